@@ -32,6 +32,7 @@ extern VkDevice g_hDevice;
 extern VmaAllocator g_hAllocator;
 extern uint32_t g_FrameIndex;
 extern bool g_SparseBindingEnabled;
+extern bool g_SparseResidencyBufferEnabled;
 extern VkQueue g_hSparseBindingQueue;
 extern VkFence g_ImmediateFence;
 extern VkCommandBuffer g_hTemporaryCommandBuffer;
@@ -93,9 +94,14 @@ public:
     virtual ~SparseBindingImage();
 
 private:
-    std::vector<VmaAllocation> m_Allocations;
+    std::vector<VkSparseMemoryBind> m_Binds;
 };
 
+// Pages of all SparseBindingImage objects. Created with the first of them.
+static VmaSparsePagePool g_SparsePagePool = VK_NULL_HANDLE;
+static VkDeviceSize g_SparsePageSize = 0;
+static uint32_t g_SparsePageMemoryTypeIndex = UINT32_MAX;
+
 ////////////////////////////////////////////////////////////////////////////////
 // class BaseImage
 
@@ -483,32 +489,40 @@ void SparseBindingImage::Init(RandomNumberGenerator& rand)
     const VkDeviceSize pageSize = imageMemReq.alignment;
     const uint32_t pageCount = (uint32_t)ceil_div<VkDeviceSize>(imageMemReq.size, pageSize);
 
-    VmaAllocationCreateInfo allocCreateInfo = {};
-    allocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
-
-    VkMemoryRequirements pageMemReq = imageMemReq;
-    pageMemReq.size = pageSize;
+    if(g_SparsePagePool == VK_NULL_HANDLE)
+    {
+        // The pool is shared by all images, so its memory type is chosen here and checked for each of them below.
+        VmaAllocationCreateInfo allocCreateInfo = {};
+        allocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+        ERR_GUARD_VULKAN( vmaFindMemoryTypeIndex(g_hAllocator, imageMemReq.memoryTypeBits, &allocCreateInfo, &g_SparsePageMemoryTypeIndex) );
+
+        VmaSparsePagePoolCreateInfo pagePoolCreateInfo = {};
+        pagePoolCreateInfo.pageSize = pageSize;
+        pagePoolCreateInfo.memoryTypeBits = 1u << g_SparsePageMemoryTypeIndex;
+        ERR_GUARD_VULKAN( vmaCreateSparsePagePool(g_hAllocator, &pagePoolCreateInfo, &g_SparsePagePool) );
+        g_SparsePageSize = pageSize;
+    }
+    TEST(pageSize == g_SparsePageSize);
+    TEST((imageMemReq.memoryTypeBits & (1u << g_SparsePageMemoryTypeIndex)) != 0);
 
     // Allocate and bind memory pages.
-    m_Allocations.resize(pageCount);
-    std::fill(m_Allocations.begin(), m_Allocations.end(), nullptr);
-    std::vector<VkSparseMemoryBind> binds{pageCount};
-    std::vector<VmaAllocationInfo> allocInfo{pageCount};
-    ERR_GUARD_VULKAN( vmaAllocateMemoryPages(g_hAllocator, &pageMemReq, &allocCreateInfo, pageCount, m_Allocations.data(), allocInfo.data()) );
-
+    m_Binds.resize(pageCount);
+    for(uint32_t i = 0; i < pageCount; ++i)
+    {
+        m_Binds[i] = {};
+        m_Binds[i].resourceOffset = pageSize * i;
+        m_Binds[i].size = pageSize;
+    }
+    ERR_GUARD_VULKAN( vmaAllocateSparseOpaquePages(g_hAllocator, g_SparsePagePool, pageCount, m_Binds.data()) );
     for(uint32_t i = 0; i < pageCount; ++i)
     {
-        binds[i] = {};
-        binds[i].resourceOffset = pageSize * i;
-        binds[i].size = pageSize;
-        binds[i].memory = allocInfo[i].deviceMemory;
-        binds[i].memoryOffset = allocInfo[i].offset;
+        TEST(m_Binds[i].memory != VK_NULL_HANDLE && m_Binds[i].size <= g_SparsePageSize);
     }
 
     VkSparseImageOpaqueMemoryBindInfo imageBindInfo;
     imageBindInfo.image = m_Image;
     imageBindInfo.bindCount = pageCount;
-    imageBindInfo.pBinds = binds.data();
+    imageBindInfo.pBinds = m_Binds.data();
 
     VkBindSparseInfo bindSparseInfo = { VK_STRUCTURE_TYPE_BIND_SPARSE_INFO };
     bindSparseInfo.pImageOpaqueBinds = &imageBindInfo;
@@ -521,12 +535,137 @@ void SparseBindingImage::Init(RandomNumberGenerator& rand)
 
 SparseBindingImage::~SparseBindingImage()
 {
-    vmaFreeMemoryPages(g_hAllocator, m_Allocations.size(), m_Allocations.data());
+    vmaFreeSparseOpaquePages(g_hAllocator, g_SparsePagePool, (uint32_t)m_Binds.size(), m_Binds.data());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // Private functions
 
+static void TestSparseBuffer()
+{
+    printf("Test sparse buffer\n");
+
+    constexpr VkDeviceSize pageSize = 1024ull * 1024;
+    constexpr VkDeviceSize rangeSize = pageSize * 3 / 2;
+    constexpr uint32_t fillValue = 0xC0DE1234;
+
+    VmaSparseBufferCreateInfo sparseCreateInfo = {};
+    sparseCreateInfo.size = 256ull * 1024 * 1024;
+    sparseCreateInfo.pageSize = pageSize;
+    sparseCreateInfo.bufferUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    VmaSparseBuffer sparseBuffer = VK_NULL_HANDLE;
+    VmaSparseBufferInfo sparseInfo = {};
+    ERR_GUARD_VULKAN( vmaCreateSparseBuffer(g_hAllocator, &sparseCreateInfo, &sparseBuffer, &sparseInfo) );
+    TEST(sparseInfo.buffer != VK_NULL_HANDLE && sparseInfo.size >= sparseCreateInfo.size);
+    TEST(sparseInfo.pageSize >= pageSize && sparseInfo.pageSize % pageSize == 0);
+    // Nothing is allocated up front.
+    TEST(sparseInfo.committedPageCount == 0 && sparseInfo.memorySize == 0);
+
+    // Ranges are placed one after another from the beginning of the buffer.
+    VkDeviceSize offsets[4] = {};
+    for(uint32_t i = 0; i < 4; ++i)
+    {
+        ERR_GUARD_VULKAN( vmaSparseBufferAllocate(g_hAllocator, sparseBuffer, rangeSize, 256, &offsets[i]) );
+        TEST(offsets[i] == rangeSize * i);
+    }
+    vmaGetSparseBufferInfo(g_hAllocator, sparseBuffer, &sparseInfo);
+    const uint32_t usedPageCount = (uint32_t)((rangeSize * 4 + sparseInfo.pageSize - 1) / sparseInfo.pageSize);
+    TEST(sparseInfo.allocatedSize == rangeSize * 4);
+    TEST(sparseInfo.committedPageCount == usedPageCount && sparseInfo.pendingBindCount == usedPageCount);
+
+    // Too big range doesn't fit.
+    VkDeviceSize offset = 0;
+    TEST(vmaSparseBufferAllocate(g_hAllocator, sparseBuffer, sparseInfo.size, 1, &offset) == VK_ERROR_OUT_OF_POOL_MEMORY);
+
+    // Null entries are skipped and a buffer passed more than once is bound only once.
+    const VmaSparseBuffer sparseBuffersToSubmit[] = { sparseBuffer, VK_NULL_HANDLE, sparseBuffer };
+    VmaSparseBindSubmitInfo bindSubmitInfo = {};
+    bindSubmitInfo.queue = g_hSparseBindingQueue;
+    bindSubmitInfo.fence = g_ImmediateFence;
+    ERR_GUARD_VULKAN( vkResetFences(g_hDevice, 1, &g_ImmediateFence) );
+    ERR_GUARD_VULKAN( vmaSubmitSparseBinds(g_hAllocator, 3, sparseBuffersToSubmit, &bindSubmitInfo) );
+    ERR_GUARD_VULKAN( vkWaitForFences(g_hDevice, 1, &g_ImmediateFence, VK_TRUE, UINT64_MAX) );
+    vmaGetSparseBufferInfo(g_hAllocator, sparseBuffer, &sparseInfo);
+    TEST(sparseInfo.pendingBindCount == 0);
+
+    // Fill a range crossing page boundary on the GPU and read it back.
+    VkBufferCreateInfo dstBufCreateInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    dstBufCreateInfo.size = rangeSize;
+    dstBufCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    VmaAllocationCreateInfo dstAllocCreateInfo = {};
+    dstAllocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+    dstAllocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    VkBuffer dstBuf = VK_NULL_HANDLE;
+    VmaAllocation dstAlloc = VK_NULL_HANDLE;
+    VmaAllocationInfo dstAllocInfo = {};
+    ERR_GUARD_VULKAN( vmaCreateBuffer(g_hAllocator, &dstBufCreateInfo, &dstAllocCreateInfo, &dstBuf, &dstAlloc, &dstAllocInfo) );
+
+    BeginSingleTimeCommands();
+    vkCmdFillBuffer(g_hTemporaryCommandBuffer, sparseInfo.buffer, offsets[1], rangeSize, fillValue);
+    VkBufferMemoryBarrier barrier = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = sparseInfo.buffer;
+    barrier.offset = offsets[1];
+    barrier.size = rangeSize;
+    vkCmdPipelineBarrier(g_hTemporaryCommandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, // srcStageMask
+        VK_PIPELINE_STAGE_TRANSFER_BIT, // dstStageMask
+        0, // dependencyFlags
+        0, nullptr, // memoryBarriers
+        1, &barrier, // bufferMemoryBarriers
+        0, nullptr); // imageMemoryBarriers
+    VkBufferCopy region = { offsets[1], 0, rangeSize };
+    vkCmdCopyBuffer(g_hTemporaryCommandBuffer, sparseInfo.buffer, dstBuf, 1, &region);
+    EndSingleTimeCommands();
+
+    ERR_GUARD_VULKAN( vmaInvalidateAllocation(g_hAllocator, dstAlloc, 0, VK_WHOLE_SIZE) );
+    const uint32_t* dstData = (const uint32_t*)dstAllocInfo.pMappedData;
+    for(size_t i = 0; i < rangeSize / sizeof(uint32_t); ++i)
+    {
+        TEST(dstData[i] == fillValue);
+    }
+    vmaDestroyBuffer(g_hAllocator, dstBuf, dstAlloc);
+
+    // Freeing the last range releases pages it doesn't share with the previous one.
+    vmaSparseBufferFree(g_hAllocator, sparseBuffer, offsets[3]);
+    vmaGetSparseBufferInfo(g_hAllocator, sparseBuffer, &sparseInfo);
+    const uint32_t remainingPageCount = (uint32_t)((rangeSize * 3 + sparseInfo.pageSize - 1) / sparseInfo.pageSize);
+    TEST(sparseInfo.committedPageCount == remainingPageCount);
+    TEST(sparseInfo.pendingBindCount == usedPageCount - remainingPageCount);
+
+    // Freed space is reused.
+    ERR_GUARD_VULKAN( vmaSparseBufferAllocate(g_hAllocator, sparseBuffer, rangeSize, 256, &offset) );
+    TEST(offset == offsets[3]);
+    vmaGetSparseBufferInfo(g_hAllocator, sparseBuffer, &sparseInfo);
+    TEST(sparseInfo.committedPageCount == usedPageCount && sparseInfo.pendingBindCount == 0);
+
+    for(uint32_t i = 0; i < 4; ++i)
+    {
+        vmaSparseBufferFree(g_hAllocator, sparseBuffer, offsets[i]);
+    }
+    vmaGetSparseBufferInfo(g_hAllocator, sparseBuffer, &sparseInfo);
+    TEST(sparseInfo.allocatedSize == 0 && sparseInfo.committedPageCount == 0);
+    TEST(sparseInfo.memorySize == sparseInfo.pageSize * usedPageCount);
+
+    // Memory of unbound pages is freed frameInUseCount frames after unbinding.
+    ERR_GUARD_VULKAN( vkResetFences(g_hDevice, 1, &g_ImmediateFence) );
+    ERR_GUARD_VULKAN( vmaSubmitSparseBinds(g_hAllocator, 1, &sparseBuffer, &bindSubmitInfo) );
+    ERR_GUARD_VULKAN( vkWaitForFences(g_hDevice, 1, &g_ImmediateFence, VK_TRUE, UINT64_MAX) );
+    ++g_FrameIndex;
+    vmaSetCurrentFrameIndex(g_hAllocator, g_FrameIndex);
+    ERR_GUARD_VULKAN( vkResetFences(g_hDevice, 1, &g_ImmediateFence) );
+    ERR_GUARD_VULKAN( vmaSubmitSparseBinds(g_hAllocator, 1, &sparseBuffer, &bindSubmitInfo) );
+    ERR_GUARD_VULKAN( vkWaitForFences(g_hDevice, 1, &g_ImmediateFence, VK_TRUE, UINT64_MAX) );
+    vmaGetSparseBufferInfo(g_hAllocator, sparseBuffer, &sparseInfo);
+    TEST(sparseInfo.pendingBindCount == 0 && sparseInfo.memorySize == 0);
+
+    vmaDestroySparseBuffer(g_hAllocator, sparseBuffer);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Public functions
 
@@ -588,6 +727,18 @@ void TestSparseBinding()
 
     // Free remaining images.
     images.clear();
+
+    VmaPoolStats pagePoolStats = {};
+    vmaGetSparsePagePoolStats(g_hAllocator, g_SparsePagePool, &pagePoolStats);
+    TEST(pagePoolStats.allocationCount == 0 && pagePoolStats.blockCount <= 1);
+    vmaDestroySparsePagePool(g_hAllocator, g_SparsePagePool);
+    g_SparsePagePool = VK_NULL_HANDLE;
+    g_SparsePageMemoryTypeIndex = UINT32_MAX;
+
+    if(g_SparseResidencyBufferEnabled)
+    {
+        TestSparseBuffer();
+    }
 }
 
 #endif // #ifdef _WIN32
@@ -22,7 +22,9 @@
 
 #include "Common.h"
 
-bool StrRangeToPtrList(const StrRange& s, std::vector<uint64_t>& out)
+// Parses values separated by single space, each of them using parseFunc.
+template<typename T, typename ParseFunc>
+static bool StrRangeToList(const StrRange& s, std::vector<T>& out, ParseFunc parseFunc)
 {
     out.clear();
     StrRange currRange = { s.beg, nullptr };
@@ -34,18 +36,34 @@ bool StrRangeToPtrList(const StrRange& s, std::vector<uint64_t>& out)
             ++currRange.end;
         }
 
-        uint64_t ptr = 0;
-        if(!StrRangeToPtr(currRange, ptr))
+        T value = {};
+        if(!parseFunc(currRange, value))
         {
             return false;
         }
-        out.push_back(ptr);
+        out.push_back(value);
 
         currRange.beg = currRange.end + 1;
     }
     return true;
 }
 
+bool StrRangeToPtrList(const StrRange& s, std::vector<uint64_t>& out)
+{
+    return StrRangeToList(s, out, StrRangeToPtr);
+}
+
+bool StrRangeToUintList(const StrRange& s, std::vector<uint64_t>& out)
+{
+    bool (*const parseFunc)(const StrRange&, uint64_t&) = StrRangeToUint;
+    return StrRangeToList(s, out, parseFunc);
+}
+
+bool StrRangeToFloatList(const StrRange& s, std::vector<float>& out)
+{
+    return StrRangeToList(s, out, StrRangeToFloat);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // LineSplit class
 
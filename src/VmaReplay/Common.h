@@ -139,6 +139,8 @@ inline bool StrRangeToBool(const StrRange& s, bool& out)
     return true;
 }
 bool StrRangeToPtrList(const StrRange& s, std::vector<uint64_t>& out);
+bool StrRangeToUintList(const StrRange& s, std::vector<uint64_t>& out);
+bool StrRangeToFloatList(const StrRange& s, std::vector<float>& out);
 
 class LineSplit
 {
@@ -380,6 +382,156 @@ bool RangeSequence<T>::Includes(T number) const
     return false;
 }
 
+/*
+Hash map from pointers recorded in the file to objects created during replay.
+
+Uses open addressing with linear probing in a single array, so unlike
+std::unordered_map it doesn't allocate a node per element. Key 0 is reserved
+for empty slots - null pointers are never inserted. Interface is a subset of
+std::unordered_map. Iterators are invalidated by insertion and erase.
+*/
+template<typename T>
+class PtrMap
+{
+public:
+    typedef std::pair<uint64_t, T> value_type;
+
+    class iterator
+    {
+    public:
+        iterator(value_type* pSlot, value_type* pEnd) : m_pSlot(pSlot), m_pEnd(pEnd) { SkipEmpty(); }
+        value_type& operator*() const { return *m_pSlot; }
+        value_type* operator->() const { return m_pSlot; }
+        iterator& operator++() { ++m_pSlot; SkipEmpty(); return *this; }
+        bool operator==(const iterator& rhs) const { return m_pSlot == rhs.m_pSlot; }
+        bool operator!=(const iterator& rhs) const { return m_pSlot != rhs.m_pSlot; }
+
+    private:
+        value_type* m_pSlot;
+        value_type* m_pEnd;
+        void SkipEmpty() { while(m_pSlot < m_pEnd && m_pSlot->first == 0) ++m_pSlot; }
+        friend class PtrMap;
+    };
+
+    bool empty() const { return m_Count == 0; }
+    size_t size() const { return m_Count; }
+    iterator begin() { return iterator(m_Slots.data(), m_Slots.data() + m_Slots.size()); }
+    iterator end() { return iterator(m_Slots.data() + m_Slots.size(), m_Slots.data() + m_Slots.size()); }
+
+    void clear() { m_Slots.clear(); m_Count = 0; }
+    iterator find(uint64_t key);
+    // Inserts default-constructed value if key doesn't exist. key must not be 0.
+    T& operator[](uint64_t key);
+    void erase(iterator it);
+
+private:
+    static const size_t MIN_CAPACITY = 64;
+
+    std::vector<value_type> m_Slots; // Capacity is always power of 2.
+    size_t m_Count = 0;
+
+    static size_t Hash(uint64_t key)
+    {
+        // Pointers have low bits zero, so mix all bits into the low ones.
+        key ^= key >> 33;
+        key *= 0xFF51AFD7ED558CCDull;
+        key ^= key >> 33;
+        return (size_t)key;
+    }
+    size_t GetMask() const { return m_Slots.size() - 1; }
+    void Rehash(size_t newCapacity);
+};
+
+template<typename T>
+typename PtrMap<T>::iterator PtrMap<T>::find(uint64_t key)
+{
+    if(key != 0 && !m_Slots.empty())
+    {
+        const size_t mask = GetMask();
+        for(size_t i = Hash(key) & mask; m_Slots[i].first != 0; i = (i + 1) & mask)
+        {
+            if(m_Slots[i].first == key)
+            {
+                return iterator(m_Slots.data() + i, m_Slots.data() + m_Slots.size());
+            }
+        }
+    }
+    return end();
+}
+
+template<typename T>
+T& PtrMap<T>::operator[](uint64_t key)
+{
+    assert(key != 0);
+
+    // Keep load factor at most 3/4 so probe sequences stay short.
+    if((m_Count + 1) * 4 > m_Slots.size() * 3)
+    {
+        // Copy to a local, as std::max takes references and would ODR-use the undefined static member.
+        const size_t minCapacity = MIN_CAPACITY;
+        Rehash(std::max(m_Slots.size() * 2, minCapacity));
+    }
+
+    const size_t mask = GetMask();
+    size_t i = Hash(key) & mask;
+    for(; m_Slots[i].first != 0; i = (i + 1) & mask)
+    {
+        if(m_Slots[i].first == key)
+        {
+            return m_Slots[i].second;
+        }
+    }
+    m_Slots[i].first = key;
+    ++m_Count;
+    return m_Slots[i].second;
+}
+
+template<typename T>
+void PtrMap<T>::erase(iterator it)
+{
+    assert(it.m_pSlot->first != 0);
+
+    // Backward shift deletion: move following elements of the probe sequence
+    // into the hole, so no tombstones are needed.
+    const size_t mask = GetMask();
+    size_t hole = it.m_pSlot - m_Slots.data();
+    for(size_t i = (hole + 1) & mask; m_Slots[i].first != 0; i = (i + 1) & mask)
+    {
+        const size_t home = Hash(m_Slots[i].first) & mask;
+        // Element can be moved to the hole only if its home slot is not cyclically in (hole, i].
+        const bool homeBetween = hole <= i ?
+            (home > hole && home <= i) :
+            (home > hole || home <= i);
+        if(!homeBetween)
+        {
+            m_Slots[hole] = std::move(m_Slots[i]);
+            hole = i;
+        }
+    }
+    m_Slots[hole] = value_type();
+    --m_Count;
+}
+
+template<typename T>
+void PtrMap<T>::Rehash(size_t newCapacity)
+{
+    std::vector<value_type> oldSlots(newCapacity);
+    m_Slots.swap(oldSlots);
+    const size_t mask = GetMask();
+    for(value_type& oldSlot : oldSlots)
+    {
+        if(oldSlot.first != 0)
+        {
+            size_t i = Hash(oldSlot.first) & mask;
+            while(m_Slots[i].first != 0)
+            {
+                i = (i + 1) & mask;
+            }
+            m_Slots[i] = std::move(oldSlot);
+        }
+    }
+}
+
 /*
 class RandomNumberGenerator
 {
@@ -55,6 +55,7 @@ const char* VMA_FUNCTION_NAMES[] = {
     "vmaDefragmentationBegin",
     "vmaDefragmentationEnd",
     "vmaSetPoolName",
+    "vmaAllocateMemoryBatch",
 };
 static_assert(
     _countof(VMA_FUNCTION_NAMES) == (size_t)VMA_FUNCTION::Count,
@@ -89,6 +89,7 @@ enum class VMA_FUNCTION
     DefragmentationBegin,
     DefragmentationEnd,
     SetPoolName,
+    AllocateMemoryBatch,
     Count
 };
 extern const char* VMA_FUNCTION_NAMES[];
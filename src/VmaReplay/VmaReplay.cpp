@@ -26,6 +26,10 @@
 #include <unordered_map>
 #include <map>
 #include <algorithm>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 static VERBOSITY g_Verbosity = VERBOSITY::DEFAULT;
 
@@ -691,7 +695,7 @@ static size_t g_DefragmentAfterLineNextIndex = 0;
 static bool ValidateFileVersion()
 {
     if(GetVersionMajor(g_FileVersion) == 1 &&
-        GetVersionMinor(g_FileVersion) <= 8)
+        GetVersionMinor(g_FileVersion) <= 13)
     {
         return true;
     }
@@ -717,6 +721,42 @@ static bool ParseFileVersion(const StrRange& s)
     }
 }
 
+// Returns number of VmaAllocationCreateInfo members recorded after the allocation and before pUserData:
+// priority since format 1.11, lifetime and tag since 1.12.
+static size_t GetAllocationCreateInfoExtraParamCount()
+{
+    if(g_FileVersion >= MakeVersion(1, 12))
+    {
+        return 3;
+    }
+    if(g_FileVersion >= MakeVersion(1, 11))
+    {
+        return 1;
+    }
+    return 0;
+}
+
+// Parses members counted by GetAllocationCreateInfoExtraParamCount(), starting at given index.
+// Members not present in the file keep their default values.
+static bool ParseAllocationCreateInfoExtraParams(const CsvSplit& csvSplit, size_t firstIndex, VmaAllocationCreateInfo& inoutInfo)
+{
+    const size_t paramCount = GetAllocationCreateInfoExtraParamCount();
+    if(paramCount >= 1 &&
+        !StrRangeToFloat(csvSplit.GetRange(firstIndex), inoutInfo.priority))
+    {
+        return false;
+    }
+    if(paramCount >= 3 &&
+        (!StrRangeToUint(csvSplit.GetRange(firstIndex + 1), (uint32_t&)inoutInfo.lifetime) ||
+        !StrRangeToUint(csvSplit.GetRange(firstIndex + 2), inoutInfo.tag) ||
+        inoutInfo.lifetime > VMA_ALLOCATION_LIFETIME_PERMANENT ||
+        inoutInfo.tag >= VMA_ALLOCATION_TAG_COUNT))
+    {
+        return false;
+    }
+    return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class Statistics
 
@@ -750,7 +790,14 @@ public:
     void RegisterAllocateMemoryPages(size_t allocCount) { m_VmaAllocateMemoryPages.PostValue(allocCount); }
     void RegisterDefragmentation(const VmaDefragmentationInfo2& info);
 
-    void RegisterDeviceMemoryAllocation(uint32_t memoryType, VkDeviceSize size);
+    void RegisterDeviceMemoryAllocation(uint32_t memoryType, VkDeviceMemory memory, VkDeviceSize size);
+    void RegisterDeviceMemoryFree(VkDeviceMemory memory) { m_CallDeviceMemory.erase(memory); }
+    size_t GetDeviceMemoryAllocationCount() const { return m_DeviceMemStats.total.allocationCount; }
+    VkDeviceSize GetDeviceMemoryAllocationTotalSize() const { return m_DeviceMemStats.total.allocationTotalSize; }
+    // Forgets device memory allocated by the previous call, so only memory allocated from now on can be claimed.
+    void BeginCall() { m_CallDeviceMemory.clear(); }
+    // If the memory was allocated by the current call and not claimed yet, claims it and returns its size, otherwise returns 0.
+    VkDeviceSize ClaimCallDeviceMemory(VkDeviceMemory memory);
     void UpdateMemStats(const VmaStats& currStats);
 
 private:
@@ -772,6 +819,8 @@ private:
         DeviceMemStatInfo memoryType[VK_MAX_MEMORY_TYPES];
         DeviceMemStatInfo total;
     } m_DeviceMemStats;
+    // Device memory allocated by the current call and its size.
+    std::unordered_map<VkDeviceMemory, VkDeviceSize> m_CallDeviceMemory;
     
     // Structure similar to VmaStatInfo, but not the same.
     struct MemStatInfo
@@ -812,7 +861,7 @@ static void VKAPI_CALL AllocateDeviceMemoryCallback(
     VkDeviceSize      size,
     void*             pUserData)
 {
-    g_Statistics->RegisterDeviceMemoryAllocation(memoryType, size);
+    g_Statistics->RegisterDeviceMemoryAllocation(memoryType, memory, size);
 }
 
 /// Callback function called before vkFreeMemory.
@@ -823,7 +872,7 @@ static void VKAPI_CALL FreeDeviceMemoryCallback(
     VkDeviceSize      size,
     void*             pUserData)
 {
-    // Nothing.
+    g_Statistics->RegisterDeviceMemoryFree(memory);
 }
 
 uint32_t Statistics::BufferUsageToClass(uint32_t usage)
@@ -1016,13 +1065,27 @@ void Statistics::UpdateMemStats(const VmaStats& currStats)
     }
 }
 
-void Statistics::RegisterDeviceMemoryAllocation(uint32_t memoryType, VkDeviceSize size)
+void Statistics::RegisterDeviceMemoryAllocation(uint32_t memoryType, VkDeviceMemory memory, VkDeviceSize size)
 {
     ++m_DeviceMemStats.total.allocationCount;
     m_DeviceMemStats.total.allocationTotalSize += size;
 
     ++m_DeviceMemStats.memoryType[memoryType].allocationCount;
     m_DeviceMemStats.memoryType[memoryType].allocationTotalSize += size;
+
+    m_CallDeviceMemory[memory] = size;
+}
+
+VkDeviceSize Statistics::ClaimCallDeviceMemory(VkDeviceMemory memory)
+{
+    const auto it = m_CallDeviceMemory.find(memory);
+    if(it == m_CallDeviceMemory.end())
+    {
+        return 0;
+    }
+    const VkDeviceSize size = it->second;
+    m_CallDeviceMemory.erase(it);
+    return size;
 }
 
 void Statistics::UpdateMemStatInfo(MemStatInfo& inoutPeakInfo, const VmaStatInfo& currInfo)
@@ -1520,6 +1583,185 @@ static bool IsLayerSupported(const VkLayerProperties* pProps, size_t propCount,
 
 static const size_t FIRST_PARAM_INDEX = 4;
 
+////////////////////////////////////////////////////////////////////////////////
+// struct Command
+
+// Line of the file decoded by the parser thread, ready to be executed by Player.
+struct Command
+{
+    enum class TYPE
+    {
+        Function, // One of VMA_FUNCTION.
+        CreateAllocator,
+        DestroyAllocator,
+        AllocationPlacement,
+        UnknownFunction,
+        TooFewColumns,
+    };
+
+    size_t lineNumber;
+    // False if the line is outside of --Lines. Such command is passed only to trigger
+    // --DumpStatsAfterLine and --DefragmentAfterLine, other members are not filled.
+    bool execute;
+    TYPE type;
+    VMA_FUNCTION function;
+    bool threadIdValid;
+    uint32_t threadId;
+    bool frameIndexValid;
+    uint32_t frameIndex;
+    CsvSplit csvSplit;
+};
+
+static void DecodeCommand(size_t lineNumber, const StrRange& line, Command& outCommand)
+{
+    outCommand.lineNumber = lineNumber;
+    outCommand.execute = true;
+    outCommand.csvSplit.Set(line);
+
+    const CsvSplit& csvSplit = outCommand.csvSplit;
+    if(csvSplit.GetCount() < FIRST_PARAM_INDEX)
+    {
+        outCommand.type = Command::TYPE::TooFewColumns;
+        return;
+    }
+
+    outCommand.threadIdValid = StrRangeToUint(csvSplit.GetRange(0), outCommand.threadId);
+    outCommand.frameIndexValid = StrRangeToUint(csvSplit.GetRange(2), outCommand.frameIndex);
+
+    const StrRange functionName = csvSplit.GetRange(3);
+    if(StrRangeEq(functionName, "AllocationPlacement"))
+        outCommand.type = Command::TYPE::AllocationPlacement;
+    else if(StrRangeEq(functionName, "vmaCreateAllocator"))
+        outCommand.type = Command::TYPE::CreateAllocator;
+    else if(StrRangeEq(functionName, "vmaDestroyAllocator"))
+        outCommand.type = Command::TYPE::DestroyAllocator;
+    else
+    {
+        outCommand.type = Command::TYPE::UnknownFunction;
+        for(uint32_t i = 0; i < (uint32_t)VMA_FUNCTION::Count; ++i)
+        {
+            if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[i]))
+            {
+                outCommand.type = Command::TYPE::Function;
+                outCommand.function = (VMA_FUNCTION)i;
+                break;
+            }
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class CommandQueue
+
+typedef std::vector<Command> CommandBatch;
+
+/*
+Passes batches of commands from the parser thread to the thread executing them.
+Number of batches waiting is limited, so the parser doesn't decode the whole file ahead.
+*/
+class CommandQueue
+{
+public:
+    static const size_t BATCH_SIZE = 256;
+    static const size_t MAX_BATCH_COUNT = 16;
+
+    // Blocks while the queue is full.
+    void Push(CommandBatch&& batch);
+    // Signals that no more batches will be pushed.
+    void Close();
+    // Blocks until a batch is available. Returns false if the queue is closed and empty.
+    bool Pop(CommandBatch& outBatch);
+
+private:
+    std::mutex m_Mutex;
+    std::condition_variable m_CondVar;
+    std::deque<CommandBatch> m_Batches;
+    bool m_Closed = false;
+};
+
+void CommandQueue::Push(CommandBatch&& batch)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_CondVar.wait(lock, [this]() { return m_Batches.size() < MAX_BATCH_COUNT; });
+    m_Batches.push_back(std::move(batch));
+    m_CondVar.notify_all();
+}
+
+void CommandQueue::Close()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Closed = true;
+    m_CondVar.notify_all();
+}
+
+bool CommandQueue::Pop(CommandBatch& outBatch)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_CondVar.wait(lock, [this]() { return !m_Batches.empty() || m_Closed; });
+    if(m_Batches.empty())
+    {
+        return false;
+    }
+    outBatch = std::move(m_Batches.front());
+    m_Batches.pop_front();
+    m_CondVar.notify_all();
+    return true;
+}
+
+// Entry point of the parser thread.
+static void ParseCommands(LineSplit& lineSplit, CommandQueue& queue)
+{
+    const bool useLineRanges = !g_LineRanges.IsEmpty();
+
+    CommandBatch batch;
+    batch.reserve(CommandQueue::BATCH_SIZE);
+    StrRange line;
+    while(lineSplit.GetNextLine(line))
+    {
+        batch.emplace_back();
+        Command& command = batch.back();
+
+        const size_t currLineNumber = lineSplit.GetNextLineIndex();
+        if(!useLineRanges || g_LineRanges.Includes(currLineNumber))
+        {
+            DecodeCommand(currLineNumber, line, command);
+        }
+        else
+        {
+            command.lineNumber = currLineNumber;
+            command.execute = false;
+        }
+
+        if(batch.size() == CommandQueue::BATCH_SIZE)
+        {
+            queue.Push(std::move(batch));
+            batch = CommandBatch();
+            batch.reserve(CommandQueue::BATCH_SIZE);
+        }
+    }
+
+    if(!batch.empty())
+    {
+        queue.Push(std::move(batch));
+    }
+    queue.Close();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class ScopedTimer
+
+// Adds time elapsed during its lifetime to given duration.
+class ScopedTimer
+{
+public:
+    ScopedTimer(duration& inoutSum) : m_Sum(inoutSum), m_Beg(std::chrono::high_resolution_clock::now()) { }
+    ~ScopedTimer() { m_Sum += std::chrono::high_resolution_clock::now() - m_Beg; }
+
+private:
+    duration& m_Sum;
+    const time_point m_Beg;
+};
+
 static void InitVulkanFeatures(
     VkPhysicalDeviceFeatures& outFeatures,
     const VkPhysicalDeviceFeatures& supportedFeatures)
@@ -1546,12 +1788,15 @@ public:
     ~Player();
 
     void ApplyConfig(ConfigurationParser& configParser);
-    void ExecuteLine(size_t lineNumber, const StrRange& line);
+    void ExecuteCommand(const Command& command);
     void DumpStats(const char* fileNameFormat, size_t lineNumber, bool detailed);
     void Defragment();
 
     void PrintStats();
 
+    // Time spent inside VMA functions called to replay the file.
+    duration GetVmaCallDuration() const { return m_VmaCallDuration; }
+
 private:
     static const size_t MAX_WARNINGS_TO_SHOW = 64;
 
@@ -1569,6 +1814,7 @@ private:
     VkCommandPool m_CommandPool = VK_NULL_HANDLE;
     VkCommandBuffer m_CommandBuffer = VK_NULL_HANDLE;
     bool m_MemoryBudgetEnabled = false;
+    bool m_MemoryPriorityEnabled = false;
     const VkPhysicalDeviceProperties* m_DevProps = nullptr;
     const VkPhysicalDeviceMemoryProperties* m_MemProps = nullptr;
 
@@ -1590,9 +1836,9 @@ private:
         VkBuffer buffer = VK_NULL_HANDLE;
         VkImage image = VK_NULL_HANDLE;
     };
-    std::unordered_map<uint64_t, Pool> m_Pools;
-    std::unordered_map<uint64_t, Allocation> m_Allocations;
-    std::unordered_map<uint64_t, VmaDefragmentationContext> m_DefragmentationContexts;
+    PtrMap<Pool> m_Pools;
+    PtrMap<Allocation> m_Allocations;
+    PtrMap<VmaDefragmentationContext> m_DefragmentationContexts;
 
     struct Thread
     {
@@ -1603,6 +1849,41 @@ private:
     // Copy of column [1] from previously parsed line.
     std::string m_LastLineTimeStr;
     Statistics m_Stats;
+    duration m_VmaCallDuration = duration::zero();
+
+    // Comparison of placement from AllocationPlacement lines with placement made during replay.
+    struct PlacementStats
+    {
+        size_t allocationCount;
+        size_t memoryTypeMismatchCount;
+        size_t blockMismatchCount;
+        size_t offsetMismatchCount;
+        size_t newBlockMismatchCount;
+        VkDeviceSize origNewBlockBytes;
+        VkDeviceSize replayNewBlockBytes;
+    } m_PlacementStats = {};
+    // Block in the original run. Dedicated allocations use their own pointer as pool and UINT32_MAX as id.
+    struct OrigBlock
+    {
+        uint64_t pool;
+        uint32_t memoryTypeIndex;
+        uint32_t blockId;
+        bool operator==(const OrigBlock& rhs) const
+        {
+            return pool == rhs.pool && memoryTypeIndex == rhs.memoryTypeIndex && blockId == rhs.blockId;
+        }
+        bool operator<(const OrigBlock& rhs) const
+        {
+            if(pool != rhs.pool)
+                return pool < rhs.pool;
+            if(memoryTypeIndex != rhs.memoryTypeIndex)
+                return memoryTypeIndex < rhs.memoryTypeIndex;
+            return blockId < rhs.blockId;
+        }
+    };
+    // Correspondence of original blocks and replayed VkDeviceMemory, set by the last allocation placed in them.
+    std::map<OrigBlock, VkDeviceMemory> m_ReplayBlocks;
+    std::unordered_map<VkDeviceMemory, OrigBlock> m_OrigBlocks;
 
     std::vector<char> m_UserDataTmpStr;
 
@@ -1643,6 +1924,7 @@ private:
     void ExecuteCreateLostAllocation(size_t lineNumber, const CsvSplit& csvSplit);
     void ExecuteAllocateMemory(size_t lineNumber, const CsvSplit& csvSplit);
     void ExecuteAllocateMemoryPages(size_t lineNumber, const CsvSplit& csvSplit);
+    void ExecuteAllocateMemoryBatch(size_t lineNumber, const CsvSplit& csvSplit);
     void ExecuteAllocateMemoryForBufferOrImage(size_t lineNumber, const CsvSplit& csvSplit, OBJECT_TYPE objType);
     void ExecuteMapMemory(size_t lineNumber, const CsvSplit& csvSplit);
     void ExecuteUnmapMemory(size_t lineNumber, const CsvSplit& csvSplit);
@@ -1655,6 +1937,7 @@ private:
     void ExecuteDefragmentationBegin(size_t lineNumber, const CsvSplit& csvSplit);
     void ExecuteDefragmentationEnd(size_t lineNumber, const CsvSplit& csvSplit);
     void ExecuteSetPoolName(size_t lineNumber, const CsvSplit& csvSplit);
+    void ExecuteAllocationPlacement(size_t lineNumber, const CsvSplit& csvSplit);
 
     void DestroyAllocation(size_t lineNumber, const CsvSplit& csvSplit, const char* functionName);
 
@@ -1694,138 +1977,173 @@ void Player::ApplyConfig(ConfigurationParser& configParser)
         m_MemoryBudgetEnabled);
 }
 
-void Player::ExecuteLine(size_t lineNumber, const StrRange& line)
+void Player::ExecuteCommand(const Command& command)
 {
-    CsvSplit csvSplit;
-    csvSplit.Set(line);
+    const size_t lineNumber = command.lineNumber;
+    const CsvSplit& csvSplit = command.csvSplit;
 
-    if(csvSplit.GetCount() >= FIRST_PARAM_INDEX)
+    if(command.type == Command::TYPE::TooFewColumns)
     {
-        // Check thread ID.
-        uint32_t threadId;
-        if(StrRangeToUint(csvSplit.GetRange(0), threadId))
+        if(IssueWarning())
         {
-            const auto it = m_Threads.find(threadId);
-            if(it != m_Threads.end())
-            {
-                ++it->second.callCount;
-            }
-            else
-            {
-                Thread threadInfo{};
-                threadInfo.callCount = 1;
-                m_Threads[threadId] = threadInfo;
-            }
+            printf("Line %zu: Too few columns.\n", lineNumber);
+        }
+        return;
+    }
+
+    // Check thread ID.
+    if(command.threadIdValid)
+    {
+        const auto it = m_Threads.find(command.threadId);
+        if(it != m_Threads.end())
+        {
+            ++it->second.callCount;
         }
         else
         {
-            if(IssueWarning())
-            {
-                printf("Line %zu: Incorrect thread ID.\n", lineNumber);
-            }
+            Thread threadInfo{};
+            threadInfo.callCount = 1;
+            m_Threads[command.threadId] = threadInfo;
+        }
+    }
+    else
+    {
+        if(IssueWarning())
+        {
+            printf("Line %zu: Incorrect thread ID.\n", lineNumber);
         }
+    }
 
-        // Save time.
-        csvSplit.GetRange(1).to_str(m_LastLineTimeStr);
+    // Save time.
+    csvSplit.GetRange(1).to_str(m_LastLineTimeStr);
 
-        // Update VMA current frame index.
-        StrRange frameIndexStr = csvSplit.GetRange(2);
-        uint32_t frameIndex;
-        if(StrRangeToUint(frameIndexStr, frameIndex))
+    // Update VMA current frame index.
+    if(command.frameIndexValid)
+    {
+        if(command.frameIndex != m_VmaFrameIndex)
         {
-            if(frameIndex != m_VmaFrameIndex)
             {
-                vmaSetCurrentFrameIndex(m_Allocator, frameIndex);
-                m_VmaFrameIndex = frameIndex;
+                const ScopedTimer timer(m_VmaCallDuration);
+                vmaSetCurrentFrameIndex(m_Allocator, command.frameIndex);
             }
+            m_VmaFrameIndex = command.frameIndex;
         }
-        else
+    }
+    else
+    {
+        if(IssueWarning())
         {
-            if(IssueWarning())
-            {
-                printf("Line %zu: Incorrect frame index.\n", lineNumber);
-            }
+            printf("Line %zu: Incorrect frame index.\n", lineNumber);
         }
+    }
 
-        StrRange functionName = csvSplit.GetRange(3);
+    // AllocationPlacement lines follow the call they describe.
+    if(command.type != Command::TYPE::AllocationPlacement)
+    {
+        m_Stats.BeginCall();
+    }
 
-        if(StrRangeEq(functionName, "vmaCreateAllocator"))
+    switch(command.type)
+    {
+    case Command::TYPE::CreateAllocator:
+    case Command::TYPE::DestroyAllocator:
+        if(ValidateFunctionParameterCount(lineNumber, csvSplit, 0, false))
         {
-            if(ValidateFunctionParameterCount(lineNumber, csvSplit, 0, false))
-            {
-                // Nothing.
-            }
+            // Nothing.
         }
-        else if(StrRangeEq(functionName, "vmaDestroyAllocator"))
-        {
-            if(ValidateFunctionParameterCount(lineNumber, csvSplit, 0, false))
-            {
-                // Nothing.
-            }
-        }
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::CreatePool]))
-            ExecuteCreatePool(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::DestroyPool]))
-            ExecuteDestroyPool(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::SetAllocationUserData]))
-            ExecuteSetAllocationUserData(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::CreateBuffer]))
-            ExecuteCreateBuffer(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::DestroyBuffer]))
-            ExecuteDestroyBuffer(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::CreateImage]))
-            ExecuteCreateImage(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::DestroyImage]))
-            ExecuteDestroyImage(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::FreeMemory]))
-            ExecuteFreeMemory(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::FreeMemoryPages]))
-            ExecuteFreeMemoryPages(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::CreateLostAllocation]))
-            ExecuteCreateLostAllocation(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::AllocateMemory]))
-            ExecuteAllocateMemory(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::AllocateMemoryPages]))
-            ExecuteAllocateMemoryPages(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::AllocateMemoryForBuffer]))
-            ExecuteAllocateMemoryForBufferOrImage(lineNumber, csvSplit, OBJECT_TYPE::BUFFER);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::AllocateMemoryForImage]))
-            ExecuteAllocateMemoryForBufferOrImage(lineNumber, csvSplit, OBJECT_TYPE::IMAGE);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::MapMemory]))
-            ExecuteMapMemory(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::UnmapMemory]))
-            ExecuteUnmapMemory(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::FlushAllocation]))
-            ExecuteFlushAllocation(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::InvalidateAllocation]))
-            ExecuteInvalidateAllocation(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::TouchAllocation]))
-            ExecuteTouchAllocation(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::GetAllocationInfo]))
-            ExecuteGetAllocationInfo(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::MakePoolAllocationsLost]))
-            ExecuteMakePoolAllocationsLost(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::ResizeAllocation]))
-            ExecuteResizeAllocation(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::DefragmentationBegin]))
-            ExecuteDefragmentationBegin(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::DefragmentationEnd]))
-            ExecuteDefragmentationEnd(lineNumber, csvSplit);
-        else if(StrRangeEq(functionName, VMA_FUNCTION_NAMES[(uint32_t)VMA_FUNCTION::SetPoolName]))
-            ExecuteSetPoolName(lineNumber, csvSplit);
-        else
+        break;
+    case Command::TYPE::AllocationPlacement:
+        ExecuteAllocationPlacement(lineNumber, csvSplit);
+        break;
+    case Command::TYPE::Function:
+        switch(command.function)
         {
-            if(IssueWarning())
-            {
-                printf("Line %zu: Unknown function.\n", lineNumber);
-            }
+            case VMA_FUNCTION::CreatePool:
+                ExecuteCreatePool(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::DestroyPool:
+                ExecuteDestroyPool(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::SetAllocationUserData:
+                ExecuteSetAllocationUserData(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::CreateBuffer:
+                ExecuteCreateBuffer(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::DestroyBuffer:
+                ExecuteDestroyBuffer(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::CreateImage:
+                ExecuteCreateImage(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::DestroyImage:
+                ExecuteDestroyImage(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::FreeMemory:
+                ExecuteFreeMemory(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::FreeMemoryPages:
+                ExecuteFreeMemoryPages(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::CreateLostAllocation:
+                ExecuteCreateLostAllocation(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::AllocateMemory:
+                ExecuteAllocateMemory(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::AllocateMemoryPages:
+                ExecuteAllocateMemoryPages(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::AllocateMemoryBatch:
+                ExecuteAllocateMemoryBatch(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::AllocateMemoryForBuffer:
+                ExecuteAllocateMemoryForBufferOrImage(lineNumber, csvSplit, OBJECT_TYPE::BUFFER);
+                break;
+            case VMA_FUNCTION::AllocateMemoryForImage:
+                ExecuteAllocateMemoryForBufferOrImage(lineNumber, csvSplit, OBJECT_TYPE::IMAGE);
+                break;
+            case VMA_FUNCTION::MapMemory:
+                ExecuteMapMemory(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::UnmapMemory:
+                ExecuteUnmapMemory(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::FlushAllocation:
+                ExecuteFlushAllocation(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::InvalidateAllocation:
+                ExecuteInvalidateAllocation(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::TouchAllocation:
+                ExecuteTouchAllocation(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::GetAllocationInfo:
+                ExecuteGetAllocationInfo(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::MakePoolAllocationsLost:
+                ExecuteMakePoolAllocationsLost(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::ResizeAllocation:
+                ExecuteResizeAllocation(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::DefragmentationBegin:
+                ExecuteDefragmentationBegin(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::DefragmentationEnd:
+                ExecuteDefragmentationEnd(lineNumber, csvSplit);
+                break;
+            case VMA_FUNCTION::SetPoolName:
+                ExecuteSetPoolName(lineNumber, csvSplit);
+                break;
+        default:
+            assert(0);
         }
-    }
-    else
-    {
+        break;
+    default:
         if(IssueWarning())
         {
-            printf("Line %zu: Too few columns.\n", lineNumber);
+            printf("Line %zu: Unknown function.\n", lineNumber);
         }
     }
 }
@@ -1855,6 +2173,8 @@ void Player::DumpStats(const char* fileNameFormat, size_t lineNumber, bool detai
 
 void Player::Destroy(const Allocation& alloc)
 {
+    const ScopedTimer timer(m_VmaCallDuration);
+
     if(alloc.buffer)
     {
         assert(alloc.image == VK_NULL_HANDLE);
@@ -2155,6 +2475,7 @@ int Player::InitVulkan()
     std::vector<const char*> enabledDeviceExtensions;
     //enabledDeviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
     bool memoryBudgetAvailable = false;
+    bool memoryPriorityAvailable = false;
     {
         uint32_t propertyCount = 0;
         res = vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &propertyCount, nullptr);
@@ -2179,6 +2500,10 @@ int Player::InitVulkan()
                         memoryBudgetAvailable = true;
                     }
                 }
+                else if(strcmp(properties[i].extensionName, VK_EXT_MEMORY_PRIORITY_EXTENSION_NAME) == 0)
+                {
+                    memoryPriorityAvailable = true;
+                }
             }
         }
     }
@@ -2210,12 +2535,37 @@ int Player::InitVulkan()
         enabledDeviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
     }
 
+    // Priorities recorded since file format 1.11 take effect only with VK_EXT_memory_priority.
+    VkPhysicalDeviceMemoryPriorityFeaturesEXT memoryPriorityFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PRIORITY_FEATURES_EXT };
+    if(memoryPriorityAvailable)
+    {
+        VkPhysicalDeviceFeatures2 supportedFeatures2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+        supportedFeatures2.pNext = &memoryPriorityFeatures;
+        vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &supportedFeatures2);
+        m_MemoryPriorityEnabled = memoryPriorityFeatures.memoryPriority == VK_TRUE;
+    }
+
+    if(m_MemoryPriorityEnabled)
+    {
+        enabledDeviceExtensions.push_back(VK_EXT_MEMORY_PRIORITY_EXTENSION_NAME);
+    }
+
+    VkPhysicalDeviceFeatures2 enabledFeatures2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+    enabledFeatures2.features = enabledFeatures;
+    if(m_MemoryPriorityEnabled)
+    {
+        memoryPriorityFeatures.pNext = nullptr;
+        memoryPriorityFeatures.memoryPriority = VK_TRUE;
+        enabledFeatures2.pNext = &memoryPriorityFeatures;
+    }
+
     VkDeviceCreateInfo deviceCreateInfo = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+    deviceCreateInfo.pNext = &enabledFeatures2;
     deviceCreateInfo.enabledExtensionCount = (uint32_t)enabledDeviceExtensions.size();
     deviceCreateInfo.ppEnabledExtensionNames = !enabledDeviceExtensions.empty() ? enabledDeviceExtensions.data() : nullptr;
     deviceCreateInfo.queueCreateInfoCount = m_TransferQueueFamilyIndex != m_GraphicsQueueFamilyIndex ? 2 : 1;
     deviceCreateInfo.pQueueCreateInfos = deviceQueueCreateInfo;
-    deviceCreateInfo.pEnabledFeatures = &enabledFeatures;
+    deviceCreateInfo.pEnabledFeatures = nullptr;
 
     res = vkCreateDevice(m_PhysicalDevice, &deviceCreateInfo, nullptr, &m_Device);
     if(res != VK_SUCCESS)
@@ -2246,6 +2596,10 @@ int Player::InitVulkan()
     {
         allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
     }
+    if(m_MemoryPriorityEnabled)
+    {
+        allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_PRIORITY_BIT;
+    }
 
     res = vmaCreateAllocator(&allocatorInfo, &m_Allocator);
     if(res != VK_SUCCESS)
@@ -2591,6 +2945,27 @@ void Player::PrintStats()
         printf("    Total custom pools created: %zu\n", m_Stats.GetPoolCreationCount());
     }
 
+    if(m_PlacementStats.allocationCount > 0)
+    {
+        printf("    Allocation placement compared with original: %zu\n", m_PlacementStats.allocationCount);
+        printf("        Different memory type: %zu\n", m_PlacementStats.memoryTypeMismatchCount);
+        printf("        Different block: %zu\n", m_PlacementStats.blockMismatchCount);
+        printf("        Different offset in the same block: %zu\n", m_PlacementStats.offsetMismatchCount);
+        printf("        Different need for new block: %zu\n", m_PlacementStats.newBlockMismatchCount);
+        printf("        Device memory allocated for them: original %llu B, replay %llu B\n",
+            m_PlacementStats.origNewBlockBytes, m_PlacementStats.replayNewBlockBytes);
+        if(m_PlacementStats.replayNewBlockBytes < m_PlacementStats.origNewBlockBytes)
+        {
+            printf("        Memory saved: %llu B\n",
+                m_PlacementStats.origNewBlockBytes - m_PlacementStats.replayNewBlockBytes);
+        }
+        else if(m_PlacementStats.replayNewBlockBytes > m_PlacementStats.origNewBlockBytes)
+        {
+            printf("        Additional memory: %llu B\n",
+                m_PlacementStats.replayNewBlockBytes - m_PlacementStats.origNewBlockBytes);
+        }
+    }
+
     float lastTime;
     if(!m_LastLineTimeStr.empty() && StrRangeToFloat(StrRange(m_LastLineTimeStr), lastTime))
     {
@@ -2717,7 +3092,8 @@ void Player::ExecuteCreatePool(size_t lineNumber, const CsvSplit& csvSplit)
 {
     m_Stats.RegisterFunctionCall(VMA_FUNCTION::CreatePool);
 
-    if(ValidateFunctionParameterCount(lineNumber, csvSplit, 7, false))
+    const bool priorityRecorded = g_FileVersion >= MakeVersion(1, 11);
+    if(ValidateFunctionParameterCount(lineNumber, csvSplit, priorityRecorded ? 8 : 7, false))
     {
         VmaPoolCreateInfo poolCreateInfo = {};
         uint64_t origPtr = 0;
@@ -2728,12 +3104,17 @@ void Player::ExecuteCreatePool(size_t lineNumber, const CsvSplit& csvSplit)
             StrRangeToUint(csvSplit.GetRange(FIRST_PARAM_INDEX + 3), poolCreateInfo.minBlockCount) &&
             StrRangeToUint(csvSplit.GetRange(FIRST_PARAM_INDEX + 4), poolCreateInfo.maxBlockCount) &&
             StrRangeToUint(csvSplit.GetRange(FIRST_PARAM_INDEX + 5), poolCreateInfo.frameInUseCount) &&
-            StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX + 6), origPtr))
+            StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX + 6), origPtr) &&
+            (!priorityRecorded || StrRangeToFloat(csvSplit.GetRange(FIRST_PARAM_INDEX + 7), poolCreateInfo.priority)))
         {
             m_Stats.RegisterCreatePool(poolCreateInfo);
 
             Pool poolDesc = {};
-            VkResult res = vmaCreatePool(m_Allocator, &poolCreateInfo, &poolDesc.pool);
+            VkResult res;
+            {
+                const ScopedTimer timer(m_VmaCallDuration);
+                res = vmaCreatePool(m_Allocator, &poolCreateInfo, &poolDesc.pool);
+            }
 
             if(origPtr)
             {
@@ -2813,7 +3194,10 @@ void Player::ExecuteDestroyPool(size_t lineNumber, const CsvSplit& csvSplit)
                 const auto it = m_Pools.find(origPtr);
                 if(it != m_Pools.end())
                 {
-                    vmaDestroyPool(m_Allocator, it->second.pool);
+                    {
+                        const ScopedTimer timer(m_VmaCallDuration);
+                        vmaDestroyPool(m_Allocator, it->second.pool);
+                    }
                     UpdateMemStats();
                     m_Pools.erase(it);
                 }
@@ -2864,7 +3248,10 @@ void Player::ExecuteSetAllocationUserData(size_t lineNumber, const CsvSplit& csv
                         pUserData);
                 }
 
-                vmaSetAllocationUserData(m_Allocator, it->second.allocation, pUserData);
+                {
+                    const ScopedTimer timer(m_VmaCallDuration);
+                    vmaSetAllocationUserData(m_Allocator, it->second.allocation, pUserData);
+                }
             }
             else
             {
@@ -2888,7 +3275,8 @@ void Player::ExecuteCreateBuffer(size_t lineNumber, const CsvSplit& csvSplit)
 {
     m_Stats.RegisterFunctionCall(VMA_FUNCTION::CreateBuffer);
 
-    if(ValidateFunctionParameterCount(lineNumber, csvSplit, 12, true))
+    const size_t extraParamCount = GetAllocationCreateInfoExtraParamCount();
+    if(ValidateFunctionParameterCount(lineNumber, csvSplit, 12 + extraParamCount, true))
     {
         VkBufferCreateInfo bufCreateInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
         VmaAllocationCreateInfo allocCreateInfo = {};
@@ -2905,16 +3293,18 @@ void Player::ExecuteCreateBuffer(size_t lineNumber, const CsvSplit& csvSplit)
             StrRangeToUint(csvSplit.GetRange(FIRST_PARAM_INDEX + 7), allocCreateInfo.preferredFlags) &&
             StrRangeToUint(csvSplit.GetRange(FIRST_PARAM_INDEX + 8), allocCreateInfo.memoryTypeBits) &&
             StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX + 9), origPool) &&
-            StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX + 10), origPtr))
+            StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX + 10), origPtr) &&
+            ParseAllocationCreateInfoExtraParams(csvSplit, FIRST_PARAM_INDEX + 11, allocCreateInfo))
         {
             FindPool(lineNumber, origPool, allocCreateInfo.pool);
 
-            if(csvSplit.GetCount() > FIRST_PARAM_INDEX + 11)
+            const size_t userDataIndex = FIRST_PARAM_INDEX + 11 + extraParamCount;
+            if(csvSplit.GetCount() > userDataIndex)
             {
                 PrepareUserData(
                     lineNumber,
                     allocCreateInfo.flags,
-                    csvSplit.GetRange(FIRST_PARAM_INDEX + 11),
+                    csvSplit.GetRange(userDataIndex),
                     csvSplit.GetLine(),
                     allocCreateInfo.pUserData);
             }
@@ -2927,7 +3317,11 @@ void Player::ExecuteCreateBuffer(size_t lineNumber, const CsvSplit& csvSplit)
 
             Allocation allocDesc = { };
             allocDesc.allocationFlags = allocCreateInfo.flags;
-            VkResult res = vmaCreateBuffer(m_Allocator, &bufCreateInfo, &allocCreateInfo, &allocDesc.buffer, &allocDesc.allocation, nullptr);
+            VkResult res;
+            {
+                const ScopedTimer timer(m_VmaCallDuration);
+                res = vmaCreateBuffer(m_Allocator, &bufCreateInfo, &allocCreateInfo, &allocDesc.buffer, &allocDesc.allocation, nullptr);
+            }
             UpdateMemStats();
             AddAllocation(lineNumber, origPtr, res, "vmaCreateBuffer", std::move(allocDesc));
         }
@@ -3017,7 +3411,8 @@ void Player::ExecuteCreateImage(size_t lineNumber, const CsvSplit& csvSplit)
 {
     m_Stats.RegisterFunctionCall(VMA_FUNCTION::CreateImage);
 
-    if(ValidateFunctionParameterCount(lineNumber, csvSplit, 21, true))
+    const size_t extraParamCount = GetAllocationCreateInfoExtraParamCount();
+    if(ValidateFunctionParameterCount(lineNumber, csvSplit, 21 + extraParamCount, true))
     {
         VkImageCreateInfo imageCreateInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
         VmaAllocationCreateInfo allocCreateInfo = {};
@@ -3043,16 +3438,18 @@ void Player::ExecuteCreateImage(size_t lineNumber, const CsvSplit& csvSplit)
             StrRangeToUint(csvSplit.GetRange(FIRST_PARAM_INDEX + 16), allocCreateInfo.preferredFlags) &&
             StrRangeToUint(csvSplit.GetRange(FIRST_PARAM_INDEX + 17), allocCreateInfo.memoryTypeBits) &&
             StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX + 18), origPool) &&
-            StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX + 19), origPtr))
+            StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX + 19), origPtr) &&
+            ParseAllocationCreateInfoExtraParams(csvSplit, FIRST_PARAM_INDEX + 20, allocCreateInfo))
         {
             FindPool(lineNumber, origPool, allocCreateInfo.pool);
 
-            if(csvSplit.GetCount() > FIRST_PARAM_INDEX + 20)
+            const size_t userDataIndex = FIRST_PARAM_INDEX + 20 + extraParamCount;
+            if(csvSplit.GetCount() > userDataIndex)
             {
                 PrepareUserData(
                     lineNumber,
                     allocCreateInfo.flags,
-                    csvSplit.GetRange(FIRST_PARAM_INDEX + 20),
+                    csvSplit.GetRange(userDataIndex),
                     csvSplit.GetLine(),
                     allocCreateInfo.pUserData);
             }
@@ -3065,7 +3462,11 @@ void Player::ExecuteCreateImage(size_t lineNumber, const CsvSplit& csvSplit)
 
             Allocation allocDesc = {};
             allocDesc.allocationFlags = allocCreateInfo.flags;
-            VkResult res = vmaCreateImage(m_Allocator, &imageCreateInfo, &allocCreateInfo, &allocDesc.image, &allocDesc.allocation, nullptr);
+            VkResult res;
+            {
+                const ScopedTimer timer(m_VmaCallDuration);
+                res = vmaCreateImage(m_Allocator, &imageCreateInfo, &allocCreateInfo, &allocDesc.image, &allocDesc.allocation, nullptr);
+            }
             UpdateMemStats();
             AddAllocation(lineNumber, origPtr, res, "vmaCreateImage", std::move(allocDesc));
         }
@@ -3137,7 +3538,10 @@ void Player::ExecuteCreateLostAllocation(size_t lineNumber, const CsvSplit& csvS
         if(StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX), origPtr))
         {
             Allocation allocDesc = {};
-            vmaCreateLostAllocation(m_Allocator, &allocDesc.allocation);
+            {
+                const ScopedTimer timer(m_VmaCallDuration);
+                vmaCreateLostAllocation(m_Allocator, &allocDesc.allocation);
+            }
             UpdateMemStats();
             m_Stats.RegisterCreateLostAllocation();
 
@@ -3157,7 +3561,8 @@ void Player::ExecuteAllocateMemory(size_t lineNumber, const CsvSplit& csvSplit)
 {
     m_Stats.RegisterFunctionCall(VMA_FUNCTION::AllocateMemory);
 
-    if(ValidateFunctionParameterCount(lineNumber, csvSplit, 11, true))
+    const size_t extraParamCount = GetAllocationCreateInfoExtraParamCount();
+    if(ValidateFunctionParameterCount(lineNumber, csvSplit, 11 + extraParamCount, true))
     {
         VkMemoryRequirements memReq = {};
         VmaAllocationCreateInfo allocCreateInfo = {};
@@ -3173,16 +3578,18 @@ void Player::ExecuteAllocateMemory(size_t lineNumber, const CsvSplit& csvSplit)
             StrRangeToUint(csvSplit.GetRange(FIRST_PARAM_INDEX + 6), allocCreateInfo.preferredFlags) &&
             StrRangeToUint(csvSplit.GetRange(FIRST_PARAM_INDEX + 7), allocCreateInfo.memoryTypeBits) &&
             StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX + 8), origPool) &&
-            StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX + 9), origPtr))
+            StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX + 9), origPtr) &&
+            ParseAllocationCreateInfoExtraParams(csvSplit, FIRST_PARAM_INDEX + 10, allocCreateInfo))
         {
             FindPool(lineNumber, origPool, allocCreateInfo.pool);
 
-            if(csvSplit.GetCount() > FIRST_PARAM_INDEX + 10)
+            const size_t userDataIndex = FIRST_PARAM_INDEX + 10 + extraParamCount;
+            if(csvSplit.GetCount() > userDataIndex)
             {
                 PrepareUserData(
                     lineNumber,
                     allocCreateInfo.flags,
-                    csvSplit.GetRange(FIRST_PARAM_INDEX + 10),
+                    csvSplit.GetRange(userDataIndex),
                     csvSplit.GetLine(),
                     allocCreateInfo.pUserData);
             }
@@ -3192,7 +3599,11 @@ void Player::ExecuteAllocateMemory(size_t lineNumber, const CsvSplit& csvSplit)
 
             Allocation allocDesc = {};
             allocDesc.allocationFlags = allocCreateInfo.flags;
-            VkResult res = vmaAllocateMemory(m_Allocator, &memReq, &allocCreateInfo, &allocDesc.allocation, nullptr);
+            VkResult res;
+            {
+                const ScopedTimer timer(m_VmaCallDuration);
+                res = vmaAllocateMemory(m_Allocator, &memReq, &allocCreateInfo, &allocDesc.allocation, nullptr);
+            }
             AddAllocation(lineNumber, origPtr, res, "vmaAllocateMemory", std::move(allocDesc));
         }
         else
@@ -3209,7 +3620,8 @@ void Player::ExecuteAllocateMemoryPages(size_t lineNumber, const CsvSplit& csvSp
 {
     m_Stats.RegisterFunctionCall(VMA_FUNCTION::AllocateMemoryPages);
 
-    if(ValidateFunctionParameterCount(lineNumber, csvSplit, 11, true))
+    const size_t extraParamCount = GetAllocationCreateInfoExtraParamCount();
+    if(ValidateFunctionParameterCount(lineNumber, csvSplit, 11 + extraParamCount, true))
     {
         VkMemoryRequirements memReq = {};
         VmaAllocationCreateInfo allocCreateInfo = {};
@@ -3225,19 +3637,21 @@ void Player::ExecuteAllocateMemoryPages(size_t lineNumber, const CsvSplit& csvSp
             StrRangeToUint(csvSplit.GetRange(FIRST_PARAM_INDEX + 6), allocCreateInfo.preferredFlags) &&
             StrRangeToUint(csvSplit.GetRange(FIRST_PARAM_INDEX + 7), allocCreateInfo.memoryTypeBits) &&
             StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX + 8), origPool) &&
-            StrRangeToPtrList(csvSplit.GetRange(FIRST_PARAM_INDEX + 9), origPtrs))
+            StrRangeToPtrList(csvSplit.GetRange(FIRST_PARAM_INDEX + 9), origPtrs) &&
+            ParseAllocationCreateInfoExtraParams(csvSplit, FIRST_PARAM_INDEX + 10, allocCreateInfo))
         {
             const size_t allocCount = origPtrs.size();
             if(allocCount > 0)
             {
                 FindPool(lineNumber, origPool, allocCreateInfo.pool);
 
-                if(csvSplit.GetCount() > FIRST_PARAM_INDEX + 10)
+                const size_t userDataIndex = FIRST_PARAM_INDEX + 10 + extraParamCount;
+                if(csvSplit.GetCount() > userDataIndex)
                 {
                     PrepareUserData(
                         lineNumber,
                         allocCreateInfo.flags,
-                        csvSplit.GetRange(FIRST_PARAM_INDEX + 10),
+                        csvSplit.GetRange(userDataIndex),
                         csvSplit.GetLine(),
                         allocCreateInfo.pUserData);
                 }
@@ -3248,7 +3662,11 @@ void Player::ExecuteAllocateMemoryPages(size_t lineNumber, const CsvSplit& csvSp
 
                 std::vector<VmaAllocation> allocations(allocCount);
 
-                VkResult res = vmaAllocateMemoryPages(m_Allocator, &memReq, &allocCreateInfo, allocCount, allocations.data(), nullptr);
+                VkResult res;
+                {
+                    const ScopedTimer timer(m_VmaCallDuration);
+                    res = vmaAllocateMemoryPages(m_Allocator, &memReq, &allocCreateInfo, allocCount, allocations.data(), nullptr);
+                }
                 for(size_t i = 0; i < allocCount; ++i)
                 {
                     Allocation allocDesc = {};
@@ -3268,6 +3686,104 @@ void Player::ExecuteAllocateMemoryPages(size_t lineNumber, const CsvSplit& csvSp
     }
 }
 
+void Player::ExecuteAllocateMemoryBatch(size_t lineNumber, const CsvSplit& csvSplit)
+{
+    m_Stats.RegisterFunctionCall(VMA_FUNCTION::AllocateMemoryBatch);
+
+    // Every parameter is a list with one value for each allocation. User data comes in separate lines.
+    if(ValidateFunctionParameterCount(lineNumber, csvSplit, 13, false))
+    {
+        std::vector<uint64_t> sizes, alignments, memoryTypeBits, flags, usages, requiredFlags, preferredFlags,
+            createInfoMemoryTypeBits, origPools, origPtrs, lifetimes, tags;
+        std::vector<float> priorities;
+
+        bool ok = StrRangeToUintList(csvSplit.GetRange(FIRST_PARAM_INDEX), sizes) &&
+            StrRangeToUintList(csvSplit.GetRange(FIRST_PARAM_INDEX + 1), alignments) &&
+            StrRangeToUintList(csvSplit.GetRange(FIRST_PARAM_INDEX + 2), memoryTypeBits) &&
+            StrRangeToUintList(csvSplit.GetRange(FIRST_PARAM_INDEX + 3), flags) &&
+            StrRangeToUintList(csvSplit.GetRange(FIRST_PARAM_INDEX + 4), usages) &&
+            StrRangeToUintList(csvSplit.GetRange(FIRST_PARAM_INDEX + 5), requiredFlags) &&
+            StrRangeToUintList(csvSplit.GetRange(FIRST_PARAM_INDEX + 6), preferredFlags) &&
+            StrRangeToUintList(csvSplit.GetRange(FIRST_PARAM_INDEX + 7), createInfoMemoryTypeBits) &&
+            StrRangeToPtrList(csvSplit.GetRange(FIRST_PARAM_INDEX + 8), origPools) &&
+            StrRangeToPtrList(csvSplit.GetRange(FIRST_PARAM_INDEX + 9), origPtrs) &&
+            StrRangeToFloatList(csvSplit.GetRange(FIRST_PARAM_INDEX + 10), priorities) &&
+            StrRangeToUintList(csvSplit.GetRange(FIRST_PARAM_INDEX + 11), lifetimes) &&
+            StrRangeToUintList(csvSplit.GetRange(FIRST_PARAM_INDEX + 12), tags);
+
+        const size_t allocCount = origPtrs.size();
+        ok = ok && allocCount > 0 &&
+            sizes.size() == allocCount &&
+            alignments.size() == allocCount &&
+            memoryTypeBits.size() == allocCount &&
+            flags.size() == allocCount &&
+            usages.size() == allocCount &&
+            requiredFlags.size() == allocCount &&
+            preferredFlags.size() == allocCount &&
+            createInfoMemoryTypeBits.size() == allocCount &&
+            origPools.size() == allocCount &&
+            priorities.size() == allocCount &&
+            lifetimes.size() == allocCount &&
+            tags.size() == allocCount;
+
+        std::vector<VkMemoryRequirements> memReqs(allocCount);
+        std::vector<VmaAllocationCreateInfo> allocCreateInfos(allocCount);
+        for(size_t i = 0; ok && i < allocCount; ++i)
+        {
+            memReqs[i].size = sizes[i];
+            memReqs[i].alignment = alignments[i];
+            memReqs[i].memoryTypeBits = (uint32_t)memoryTypeBits[i];
+
+            VmaAllocationCreateInfo& allocCreateInfo = allocCreateInfos[i];
+            allocCreateInfo.flags = (VmaAllocationCreateFlags)flags[i];
+            allocCreateInfo.usage = (VmaMemoryUsage)usages[i];
+            allocCreateInfo.requiredFlags = (VkMemoryPropertyFlags)requiredFlags[i];
+            allocCreateInfo.preferredFlags = (VkMemoryPropertyFlags)preferredFlags[i];
+            allocCreateInfo.memoryTypeBits = (uint32_t)createInfoMemoryTypeBits[i];
+            allocCreateInfo.priority = priorities[i];
+            allocCreateInfo.lifetime = (VmaAllocationLifetime)lifetimes[i];
+            allocCreateInfo.tag = (uint32_t)tags[i];
+            ok = lifetimes[i] <= VMA_ALLOCATION_LIFETIME_PERMANENT && tags[i] < VMA_ALLOCATION_TAG_COUNT;
+        }
+
+        if(ok)
+        {
+            for(size_t i = 0; i < allocCount; ++i)
+            {
+                FindPool(lineNumber, origPools[i], allocCreateInfos[i].pool);
+            }
+
+            UpdateMemStats();
+            for(size_t i = 0; i < allocCount; ++i)
+            {
+                m_Stats.RegisterCreateAllocation(allocCreateInfos[i]);
+            }
+
+            std::vector<VmaAllocation> allocations(allocCount);
+
+            VkResult res;
+            {
+                const ScopedTimer timer(m_VmaCallDuration);
+                res = vmaAllocateMemoryBatch(m_Allocator, memReqs.data(), allocCreateInfos.data(), allocCount, allocations.data(), nullptr);
+            }
+            for(size_t i = 0; i < allocCount; ++i)
+            {
+                Allocation allocDesc = {};
+                allocDesc.allocationFlags = allocCreateInfos[i].flags;
+                allocDesc.allocation = allocations[i];
+                AddAllocation(lineNumber, origPtrs[i], res, "vmaAllocateMemoryBatch", std::move(allocDesc));
+            }
+        }
+        else
+        {
+            if(IssueWarning())
+            {
+                printf("Line %zu: Invalid parameters for vmaAllocateMemoryBatch.\n", lineNumber);
+            }
+        }
+    }
+}
+
 void Player::ExecuteAllocateMemoryForBufferOrImage(size_t lineNumber, const CsvSplit& csvSplit, OBJECT_TYPE objType)
 {
     switch(objType)
@@ -3281,7 +3797,8 @@ void Player::ExecuteAllocateMemoryForBufferOrImage(size_t lineNumber, const CsvS
     default: assert(0);
     }
 
-    if(ValidateFunctionParameterCount(lineNumber, csvSplit, 13, true))
+    const size_t extraParamCount = GetAllocationCreateInfoExtraParamCount();
+    if(ValidateFunctionParameterCount(lineNumber, csvSplit, 13 + extraParamCount, true))
     {
         VkMemoryRequirements memReq = {};
         VmaAllocationCreateInfo allocCreateInfo = {};
@@ -3301,16 +3818,18 @@ void Player::ExecuteAllocateMemoryForBufferOrImage(size_t lineNumber, const CsvS
             StrRangeToUint(csvSplit.GetRange(FIRST_PARAM_INDEX + 8), allocCreateInfo.preferredFlags) &&
             StrRangeToUint(csvSplit.GetRange(FIRST_PARAM_INDEX + 9), allocCreateInfo.memoryTypeBits) &&
             StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX + 10), origPool) &&
-            StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX + 11), origPtr))
+            StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX + 11), origPtr) &&
+            ParseAllocationCreateInfoExtraParams(csvSplit, FIRST_PARAM_INDEX + 12, allocCreateInfo))
         {
             FindPool(lineNumber, origPool, allocCreateInfo.pool);
 
-            if(csvSplit.GetCount() > FIRST_PARAM_INDEX + 12)
+            const size_t userDataIndex = FIRST_PARAM_INDEX + 12 + extraParamCount;
+            if(csvSplit.GetCount() > userDataIndex)
             {
                 PrepareUserData(
                     lineNumber,
                     allocCreateInfo.flags,
-                    csvSplit.GetRange(FIRST_PARAM_INDEX + 12),
+                    csvSplit.GetRange(userDataIndex),
                     csvSplit.GetLine(),
                     allocCreateInfo.pUserData);
             }
@@ -3334,7 +3853,11 @@ void Player::ExecuteAllocateMemoryForBufferOrImage(size_t lineNumber, const CsvS
 
             Allocation allocDesc = {};
             allocDesc.allocationFlags = allocCreateInfo.flags;
-            VkResult res = vmaAllocateMemory(m_Allocator, &memReq, &allocCreateInfo, &allocDesc.allocation, nullptr);
+            VkResult res;
+            {
+                const ScopedTimer timer(m_VmaCallDuration);
+                res = vmaAllocateMemory(m_Allocator, &memReq, &allocCreateInfo, &allocDesc.allocation, nullptr);
+            }
             AddAllocation(lineNumber, origPtr, res, "vmaAllocateMemory (called as vmaAllocateMemoryForBuffer or vmaAllocateMemoryForImage)", std::move(allocDesc));
         }
         else
@@ -3365,7 +3888,11 @@ void Player::ExecuteMapMemory(size_t lineNumber, const CsvSplit& csvSplit)
                     if(it->second.allocation)
                     {
                         void* pData;
-                        VkResult res = vmaMapMemory(m_Allocator, it->second.allocation, &pData);
+                        VkResult res;
+                        {
+                            const ScopedTimer timer(m_VmaCallDuration);
+                            res = vmaMapMemory(m_Allocator, it->second.allocation, &pData);
+                        }
                         if(res != VK_SUCCESS)
                         {
                             printf("Line %zu: vmaMapMemory failed (%d)\n", lineNumber, res);
@@ -3415,6 +3942,7 @@ void Player::ExecuteUnmapMemory(size_t lineNumber, const CsvSplit& csvSplit)
                 {
                     if(it->second.allocation)
                     {
+                        const ScopedTimer timer(m_VmaCallDuration);
                         vmaUnmapMemory(m_Allocator, it->second.allocation);
                     }
                     else
@@ -3465,6 +3993,7 @@ void Player::ExecuteFlushAllocation(size_t lineNumber, const CsvSplit& csvSplit)
                 {
                     if(it->second.allocation)
                     {
+                        const ScopedTimer timer(m_VmaCallDuration);
                         vmaFlushAllocation(m_Allocator, it->second.allocation, offset, size);
                     }
                     else
@@ -3515,6 +4044,7 @@ void Player::ExecuteInvalidateAllocation(size_t lineNumber, const CsvSplit& csvS
                 {
                     if(it->second.allocation)
                     {
+                        const ScopedTimer timer(m_VmaCallDuration);
                         vmaInvalidateAllocation(m_Allocator, it->second.allocation, offset, size);
                     }
                     else
@@ -3558,6 +4088,7 @@ void Player::ExecuteTouchAllocation(size_t lineNumber, const CsvSplit& csvSplit)
             {
                 if(it->second.allocation)
                 {
+                    const ScopedTimer timer(m_VmaCallDuration);
                     vmaTouchAllocation(m_Allocator, it->second.allocation);
                 }
                 else
@@ -3601,7 +4132,10 @@ void Player::ExecuteGetAllocationInfo(size_t lineNumber, const CsvSplit& csvSpli
                 if(it->second.allocation)
                 {
                     VmaAllocationInfo allocInfo;
-                    vmaGetAllocationInfo(m_Allocator, it->second.allocation, &allocInfo);
+                    {
+                        const ScopedTimer timer(m_VmaCallDuration);
+                        vmaGetAllocationInfo(m_Allocator, it->second.allocation, &allocInfo);
+                    }
                 }
                 else
                 {
@@ -3644,7 +4178,10 @@ void Player::ExecuteMakePoolAllocationsLost(size_t lineNumber, const CsvSplit& c
                 const auto it = m_Pools.find(origPtr);
                 if(it != m_Pools.end())
                 {
-                    vmaMakePoolAllocationsLost(m_Allocator, it->second.pool, nullptr);
+                    {
+                        const ScopedTimer timer(m_VmaCallDuration);
+                        vmaMakePoolAllocationsLost(m_Allocator, it->second.pool, nullptr);
+                    }
                     UpdateMemStats();
                 }
                 else
@@ -3683,7 +4220,10 @@ void Player::ExecuteResizeAllocation(size_t lineNumber, const CsvSplit& csvSplit
                 const auto it = m_Allocations.find(origPtr);
                 if(it != m_Allocations.end())
                 {
-                    vmaResizeAllocation(m_Allocator, it->second.allocation, newSize);
+                    {
+                        const ScopedTimer timer(m_VmaCallDuration);
+                        vmaResizeAllocation(m_Allocator, it->second.allocation, newSize);
+                    }
                     UpdateMemStats();
                 }
                 else
@@ -3791,7 +4331,11 @@ void Player::ExecuteDefragmentationBegin(size_t lineNumber, const CsvSplit& csvS
             m_Stats.RegisterDefragmentation(defragInfo);
 
             VmaDefragmentationContext defragCtx = nullptr;
-            VkResult res = vmaDefragmentationBegin(m_Allocator, &defragInfo, nullptr, &defragCtx);
+            VkResult res;
+            {
+                const ScopedTimer timer(m_VmaCallDuration);
+                res = vmaDefragmentationBegin(m_Allocator, &defragInfo, nullptr, &defragCtx);
+            }
 
             if(defragInfo.commandBuffer)
             {
@@ -3816,7 +4360,10 @@ void Player::ExecuteDefragmentationBegin(size_t lineNumber, const CsvSplit& csvS
                     else
                     {
                         // We have defragmentation context, originally it was null: End immediately.
-                        vmaDefragmentationEnd(m_Allocator, defragCtx);
+                        {
+                            const ScopedTimer timer(m_VmaCallDuration);
+                            vmaDefragmentationEnd(m_Allocator, defragCtx);
+                        }
                     }
                 }
                 else
@@ -3877,7 +4424,10 @@ void Player::ExecuteDefragmentationEnd(size_t lineNumber, const CsvSplit& csvSpl
                 const auto it = m_DefragmentationContexts.find(origPtr);
                 if(it != m_DefragmentationContexts.end())
                 {
-                    vmaDefragmentationEnd(m_Allocator, it->second);
+                    {
+                        const ScopedTimer timer(m_VmaCallDuration);
+                        vmaDefragmentationEnd(m_Allocator, it->second);
+                    }
                     m_DefragmentationContexts.erase(it);
                 }
                 else
@@ -3920,7 +4470,10 @@ void Player::ExecuteSetPoolName(size_t lineNumber, const CsvSplit& csvSplit)
                 {
                     std::string poolName;
                     csvSplit.GetRange(FIRST_PARAM_INDEX + 1).to_str(poolName);
-                    vmaSetPoolName(m_Allocator, it->second.pool, !poolName.empty() ? poolName.c_str() : nullptr);
+                    {
+                        const ScopedTimer timer(m_VmaCallDuration);
+                        vmaSetPoolName(m_Allocator, it->second.pool, !poolName.empty() ? poolName.c_str() : nullptr);
+                    }
                 }
                 else
                 {
@@ -3941,6 +4494,113 @@ void Player::ExecuteSetPoolName(size_t lineNumber, const CsvSplit& csvSplit)
     }
 }
 
+void Player::ExecuteAllocationPlacement(size_t lineNumber, const CsvSplit& csvSplit)
+{
+    if(ValidateFunctionParameterCount(lineNumber, csvSplit, 8, false))
+    {
+        uint64_t origPtr = 0;
+        uint32_t memoryTypeIndex = 0;
+        uint64_t origPool = 0;
+        uint32_t blockId = 0;
+        uint64_t offset = 0;
+        bool dedicated = false, newBlock = false;
+        uint64_t blockSize = 0;
+        if(StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX), origPtr) &&
+            StrRangeToUint(csvSplit.GetRange(FIRST_PARAM_INDEX + 1), memoryTypeIndex) &&
+            StrRangeToBool(csvSplit.GetRange(FIRST_PARAM_INDEX + 2), dedicated) &&
+            StrRangeToPtr(csvSplit.GetRange(FIRST_PARAM_INDEX + 3), origPool) &&
+            StrRangeToUint(csvSplit.GetRange(FIRST_PARAM_INDEX + 4), blockId) &&
+            StrRangeToUint(csvSplit.GetRange(FIRST_PARAM_INDEX + 5), offset) &&
+            StrRangeToBool(csvSplit.GetRange(FIRST_PARAM_INDEX + 6), newBlock) &&
+            StrRangeToUint(csvSplit.GetRange(FIRST_PARAM_INDEX + 7), blockSize))
+        {
+            const auto it = m_Allocations.find(origPtr);
+            if(it != m_Allocations.end())
+            {
+                // Allocation may have failed during replay.
+                if(it->second.allocation != VK_NULL_HANDLE)
+                {
+                    VmaAllocationInfo allocInfo;
+                    vmaGetAllocationInfo(m_Allocator, it->second.allocation, &allocInfo);
+
+                    // Each page of a multi-page call claims only the device memory it was placed in.
+                    const VkDeviceSize replayNewBlockSize = m_Stats.ClaimCallDeviceMemory(allocInfo.deviceMemory);
+                    const bool replayNewBlock = replayNewBlockSize > 0;
+                    m_PlacementStats.replayNewBlockBytes += replayNewBlockSize;
+
+                    ++m_PlacementStats.allocationCount;
+                    if(newBlock)
+                    {
+                        m_PlacementStats.origNewBlockBytes += blockSize;
+                    }
+                    const bool memoryTypeDiffers = allocInfo.memoryType != memoryTypeIndex;
+
+                    // Blocks correspond if allocations that shared a block in the original share it also in replay.
+                    // Newly created blocks start a new correspondence, as handles of freed blocks can be reused.
+                    bool blockDiffers = false;
+                    if(!memoryTypeDiffers)
+                    {
+                        OrigBlock origBlock = { origPool, memoryTypeIndex, blockId };
+                        if(dedicated)
+                        {
+                            origBlock.pool = origPtr;
+                            origBlock.blockId = UINT32_MAX;
+                        }
+                        const auto replayBlockIt = m_ReplayBlocks.find(origBlock);
+                        if(!newBlock && replayBlockIt != m_ReplayBlocks.end() && replayBlockIt->second != allocInfo.deviceMemory)
+                        {
+                            blockDiffers = true;
+                        }
+                        const auto origBlockIt = m_OrigBlocks.find(allocInfo.deviceMemory);
+                        if(!replayNewBlock && origBlockIt != m_OrigBlocks.end() && !(origBlockIt->second == origBlock))
+                        {
+                            blockDiffers = true;
+                        }
+                        m_ReplayBlocks[origBlock] = allocInfo.deviceMemory;
+                        m_OrigBlocks[allocInfo.deviceMemory] = origBlock;
+                    }
+
+                    const bool offsetDiffers = !memoryTypeDiffers && !blockDiffers && allocInfo.offset != offset;
+                    const bool newBlockDiffers = replayNewBlock != newBlock;
+                    if(memoryTypeDiffers)
+                        ++m_PlacementStats.memoryTypeMismatchCount;
+                    if(blockDiffers)
+                        ++m_PlacementStats.blockMismatchCount;
+                    if(offsetDiffers)
+                        ++m_PlacementStats.offsetMismatchCount;
+                    if(newBlockDiffers)
+                        ++m_PlacementStats.newBlockMismatchCount;
+
+                    if(g_Verbosity == VERBOSITY::MAXIMUM &&
+                        (memoryTypeDiffers || blockDiffers || offsetDiffers || newBlockDiffers))
+                    {
+                        printf("Line %zu: Placement of allocation %llX differs: memory type %u/%u, block %s, offset %llu/%llu, new block %u/%u (original/replay).\n",
+                            lineNumber, origPtr,
+                            memoryTypeIndex, allocInfo.memoryType,
+                            blockDiffers ? "different" : "same",
+                            offset, allocInfo.offset,
+                            newBlock ? 1 : 0, replayNewBlock ? 1 : 0);
+                    }
+                }
+            }
+            else
+            {
+                if(IssueWarning())
+                {
+                    printf("Line %zu: Allocation %llX not found.\n", lineNumber, origPtr);
+                }
+            }
+        }
+        else
+        {
+            if(IssueWarning())
+            {
+                printf("Line %zu: Invalid parameters for AllocationPlacement.\n", lineNumber);
+            }
+        }
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Main functions
 
@@ -4044,73 +4704,81 @@ static int ProcessFile(size_t iterationIndex, const char* data, size_t numBytes,
 
         const time_point timeBeg = std::chrono::high_resolution_clock::now();
 
-        while(lineSplit.GetNextLine(line))
-        {
-            const size_t currLineNumber = lineSplit.GetNextLineIndex();
+        // Lines are decoded on a separate thread, so parsing overlaps with execution.
+        CommandQueue commandQueue;
+        std::thread parserThread(ParseCommands, std::ref(lineSplit), std::ref(commandQueue));
 
-            bool execute = true;
-            if(useLineRanges)
-            {
-                execute = g_LineRanges.Includes(currLineNumber);
-            }
-
-            if(execute)
+        CommandBatch batch;
+        while(commandQueue.Pop(batch))
+        {
+            for(const Command& command : batch)
             {
-                player.ExecuteLine(currLineNumber, line);
-                ++executedLineCount;
-            }
+                const size_t currLineNumber = command.lineNumber;
 
-            while(useDumpStatsAfterLine &&
-                g_DumpStatsAfterLineNextIndex < g_DumpStatsAfterLine.size() &&
-                currLineNumber >= g_DumpStatsAfterLine[g_DumpStatsAfterLineNextIndex].line)
-            {
-                const size_t requestedLine = g_DumpStatsAfterLine[g_DumpStatsAfterLineNextIndex].line;
-                const bool detailed = g_DumpStatsAfterLine[g_DumpStatsAfterLineNextIndex].detailed;
-                
-                if(g_Verbosity == VERBOSITY::MAXIMUM)
+                if(command.execute)
                 {
-                    printf("Dumping %sstats after line %zu actual line %zu...\n",
-                        detailed ? "detailed " : "",
-                        requestedLine,
-                        currLineNumber);
+                    player.ExecuteCommand(command);
+                    ++executedLineCount;
                 }
 
-                player.DumpStats("VmaReplay_Line%04zu.json", requestedLine, detailed);
+                while(useDumpStatsAfterLine &&
+                    g_DumpStatsAfterLineNextIndex < g_DumpStatsAfterLine.size() &&
+                    currLineNumber >= g_DumpStatsAfterLine[g_DumpStatsAfterLineNextIndex].line)
+                {
+                    const size_t requestedLine = g_DumpStatsAfterLine[g_DumpStatsAfterLineNextIndex].line;
+                    const bool detailed = g_DumpStatsAfterLine[g_DumpStatsAfterLineNextIndex].detailed;
                 
-                ++g_DumpStatsAfterLineNextIndex;
-            }
+                    if(g_Verbosity == VERBOSITY::MAXIMUM)
+                    {
+                        printf("Dumping %sstats after line %zu actual line %zu...\n",
+                            detailed ? "detailed " : "",
+                            requestedLine,
+                            currLineNumber);
+                    }
 
-            while(useDefragmentAfterLine &&
-                g_DefragmentAfterLineNextIndex < g_DefragmentAfterLine.size() &&
-                currLineNumber >= g_DefragmentAfterLine[g_DefragmentAfterLineNextIndex])
-            {
-                const size_t requestedLine = g_DefragmentAfterLine[g_DefragmentAfterLineNextIndex];
-                if(g_Verbosity >= VERBOSITY::DEFAULT)
-                {
-                    printf("Defragmenting after line %zu actual line %zu...\n",
-                        requestedLine,
-                        currLineNumber);
+                    player.DumpStats("VmaReplay_Line%04zu.json", requestedLine, detailed);
+                
+                    ++g_DumpStatsAfterLineNextIndex;
                 }
 
-                player.DumpStats("VmaReplay_Line%04zu_Defragment_1Before.json", requestedLine, true);
-                player.Defragment();
-                player.DumpStats("VmaReplay_Line%04zu_Defragment_2After.json", requestedLine, true);
+                while(useDefragmentAfterLine &&
+                    g_DefragmentAfterLineNextIndex < g_DefragmentAfterLine.size() &&
+                    currLineNumber >= g_DefragmentAfterLine[g_DefragmentAfterLineNextIndex])
+                {
+                    const size_t requestedLine = g_DefragmentAfterLine[g_DefragmentAfterLineNextIndex];
+                    if(g_Verbosity >= VERBOSITY::DEFAULT)
+                    {
+                        printf("Defragmenting after line %zu actual line %zu...\n",
+                            requestedLine,
+                            currLineNumber);
+                    }
+
+                    player.DumpStats("VmaReplay_Line%04zu_Defragment_1Before.json", requestedLine, true);
+                    player.Defragment();
+                    player.DumpStats("VmaReplay_Line%04zu_Defragment_2After.json", requestedLine, true);
                 
-                ++g_DefragmentAfterLineNextIndex;
+                    ++g_DefragmentAfterLineNextIndex;
+                }
             }
         }
 
+        parserThread.join();
+
         const duration playDuration = std::chrono::high_resolution_clock::now() - timeBeg;
         outDuration = playDuration;
 
         // End stats.
         if(g_Verbosity > VERBOSITY::MINIMUM)
         {
-            std::string playDurationStr;
+            std::string playDurationStr, vmaCallDurationStr, overheadDurationStr;
             SecondsToFriendlyStr(ToFloatSeconds(playDuration), playDurationStr);
+            SecondsToFriendlyStr(ToFloatSeconds(player.GetVmaCallDuration()), vmaCallDurationStr);
+            SecondsToFriendlyStr(ToFloatSeconds(playDuration - player.GetVmaCallDuration()), overheadDurationStr);
 
             printf("Done.\n");
             printf("Playback took: %s\n", playDurationStr.c_str());
+            printf("Time in VMA calls: %s\n", vmaCallDurationStr.c_str());
+            printf("Overhead of the player: %s\n", overheadDurationStr.c_str());
         }
         if(g_Verbosity == VERBOSITY::MAXIMUM)
         {
@@ -56,6 +56,7 @@ bool VK_EXT_buffer_device_address_enabled = false;
 bool VK_KHR_buffer_device_address_enabled = false;
 bool VK_EXT_debug_utils_enabled = false;
 bool g_SparseBindingEnabled = false;
+bool g_SparseResidencyBufferEnabled = false;
 bool g_BufferDeviceAddressEnabled = false;
 
 // # Pointers to functions from extensions
@@ -1113,6 +1114,7 @@ static void PrintEnabledFeatures()
 {
     wprintf(L"Validation layer: %d\n", g_EnableValidationLayer ? 1 : 0);
     wprintf(L"Sparse binding: %d\n", g_SparseBindingEnabled ? 1 : 0);
+    wprintf(L"Sparse residency buffer: %d\n", g_SparseResidencyBufferEnabled ? 1 : 0);
     wprintf(L"Buffer device address: %d\n", g_BufferDeviceAddressEnabled ? 1 : 0);
     if(GetVulkanApiVersion() == VK_API_VERSION_1_0)
     {
@@ -1382,6 +1384,7 @@ static void InitializeApplication()
     vkGetPhysicalDeviceFeatures2(g_hPhysicalDevice, &physicalDeviceFeatures);
 
     g_SparseBindingEnabled = physicalDeviceFeatures.features.sparseBinding != 0;
+    g_SparseResidencyBufferEnabled = g_SparseBindingEnabled && physicalDeviceFeatures.features.sparseResidencyBuffer != 0;
 
     // The extension is supported as fake with no real support for this feature? Don't use it.
     if(VK_AMD_device_coherent_memory_enabled && !physicalDeviceCoherentMemoryFeatures.deviceCoherentMemory)
@@ -1430,6 +1433,7 @@ static void InitializeApplication()
     assert(g_GraphicsQueueFamilyIndex != UINT_MAX);
 
     g_SparseBindingEnabled = g_SparseBindingEnabled && g_SparseBindingQueueFamilyIndex != UINT32_MAX;
+    g_SparseResidencyBufferEnabled = g_SparseResidencyBufferEnabled && g_SparseBindingEnabled;
 
     // Create logical device
 
@@ -1484,6 +1488,7 @@ static void InitializeApplication()
     VkPhysicalDeviceFeatures2 deviceFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
     deviceFeatures.features.samplerAnisotropy = VK_TRUE;
     deviceFeatures.features.sparseBinding = g_SparseBindingEnabled ? VK_TRUE : VK_FALSE;
+    deviceFeatures.features.sparseResidencyBuffer = g_SparseResidencyBufferEnabled ? VK_TRUE : VK_FALSE;
 
     if(VK_AMD_device_coherent_memory_enabled)
     {
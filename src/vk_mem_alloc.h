@@ -62,12 +62,20 @@ Documentation of all members: vk_mem_alloc.h
       - [Double stack](@ref linear_algorithm_double_stack)
       - [Ring buffer](@ref linear_algorithm_ring_buffer)
     - [Buddy allocation algorithm](@ref buddy_algorithm)
+    - [Importing host memory](@ref custom_memory_pools_host_pointer)
+    - [Sharing memory with other processes](@ref custom_memory_pools_export)
   - \subpage defragmentation
       - [Defragmenting CPU memory](@ref defragmentation_cpu)
       - [Defragmenting GPU memory](@ref defragmentation_gpu)
       - [Additional notes](@ref defragmentation_additional_notes)
       - [Writing custom allocation algorithm](@ref defragmentation_custom_algorithm)
   - \subpage lost_allocations
+  - \subpage allocation_scopes
+  - \subpage quotas
+  - \subpage deferred_destruction
+  - \subpage sparse_buffers
+    - [Growable sparse buffers](@ref sparse_buffers_growable)
+    - [Page pools for sparse images](@ref sparse_buffers_page_pool)
   - \subpage statistics
     - [Numeric statistics](@ref statistics_numeric_statistics)
     - [JSON dump](@ref statistics_json_dump)
@@ -90,6 +98,7 @@ Documentation of all members: vk_mem_alloc.h
   - [Device heap memory limit](@ref heap_memory_limit)
   - \subpage vk_khr_dedicated_allocation
   - \subpage enabling_buffer_device_address
+  - \subpage enabling_memory_priority
   - \subpage vk_amd_device_coherent_memory
 - \subpage general_considerations
   - [Thread safety](@ref general_considerations_thread_safety)
@@ -223,7 +232,8 @@ You can also combine multiple methods.
    specific image or buffer, you can use function vmaAllocateMemory(). Usage of
    this function is not recommended and usually not needed.
    vmaAllocateMemoryPages() function is also provided for creating multiple allocations at once,
-   which may be useful for sparse binding.
+   which may be useful for sparse binding. vmaAllocateMemoryBatch() does the same for allocations
+   with different requirements.
 -# If you already have a buffer or an image created, you want to allocate memory
    for it and then you will bind it yourself, you can use function
    vmaAllocateMemoryForBuffer(), vmaAllocateMemoryForImage().
@@ -902,6 +912,33 @@ succeeds.
 Ring buffer is available only in pools with one memory block -
 VmaPoolCreateInfo::maxBlockCount must be 1. Otherwise behavior is undefined.
 
+\subsection linear_algorithm_markers Markers and reset
+
+Allocations that are released together, like temporary data of a single
+rendering pass, don't need to be freed one by one. Function vmaResetPool()
+frees all allocations in a pool that uses linear algorithm at once.
+
+In pools with one memory block, you can also call vmaGetPoolMarker() to remember
+current top of the stack and later pass the marker to vmaRewindPool() to free
+all the allocations made after it, leaving older ones untouched:
+
+\code
+VkDeviceSize marker;
+vmaGetPoolMarker(allocator, pool, &marker);
+
+// Create temporary buffers in pool...
+
+vmaRewindPool(allocator, pool, marker);
+\endcode
+
+Allocations made before the marker should not be freed until rewinding.
+Otherwise new allocations can be placed below the marker and they won't be freed
+by vmaRewindPool(). Buffers and images bound to released allocations are not
+destroyed - you still need to destroy them yourself, using `vkDestroyBuffer()`
+and `vkDestroyImage()`.
+
+Markers are not available when the pool is used as a ring buffer.
+
 \section buddy_algorithm Buddy allocation algorithm
 
 There is another allocation algorithm that can be used with custom pools, called
@@ -939,6 +976,87 @@ Several limitations apply to pools that use buddy algorithm:
 - [Defragmentation](@ref defragmentation) doesn't work with allocations made from
   such pool.
 
+\section custom_memory_pools_host_pointer Importing host memory
+
+With VK_EXT_external_memory_host device extension, a custom pool can be created
+on top of memory you already have in your process, e.g. a memory-mapped file with
+geometry or textures. Buffers allocated from such pool read the data directly,
+without a staging copy.
+
+To use it, enable the extension while creating Vulkan device and create the allocator with
+#VMA_ALLOCATOR_CREATE_EXT_EXTERNAL_MEMORY_HOST_BIT. Then set VmaPoolCreateInfo::pHostPointer
+and VmaPoolCreateInfo::blockSize to the address and size of your memory.
+Both must be multiples of `VkPhysicalDeviceExternalMemoryHostPropertiesEXT::minImportedHostPointerAlignment`.
+
+Buffers bound to imported memory must be created with `VkExternalMemoryBufferCreateInfoKHR` chained to
+`VkBufferCreateInfo::pNext`, with `VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT` in its `handleTypes`
+(VUID-vkBindBufferMemory-memory-02985). The same applies to images and `VkExternalMemoryImageCreateInfoKHR`.
+The library doesn't add it for you.
+
+\code
+VmaPoolCreateInfo poolCreateInfo = {};
+poolCreateInfo.memoryTypeIndex = memTypeIndex;
+poolCreateInfo.pHostPointer = packFileMapping;
+poolCreateInfo.blockSize = packFileSize;
+
+VmaPool pool;
+VkResult res = vmaCreatePool(allocator, &poolCreateInfo, &pool);
+
+VkExternalMemoryBufferCreateInfoKHR externalMemoryBufferInfo = { VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO_KHR };
+externalMemoryBufferInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+
+VkBufferCreateInfo bufCreateInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+bufCreateInfo.pNext = &externalMemoryBufferInfo;
+bufCreateInfo.size = meshDataSize;
+bufCreateInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+
+VmaAllocationCreateInfo allocCreateInfo = {};
+allocCreateInfo.pool = pool;
+
+VkBuffer buf;
+VmaAllocation alloc;
+res = vmaCreateBuffer(allocator, &bufCreateInfo, &allocCreateInfo, &buf, &alloc, nullptr);
+\endcode
+
+The pool has exactly one memory block that imports whole given memory.
+Allocations are made from it like from any other custom pool, with the algorithm selected in VmaPoolCreateInfo::flags.
+vmaCreatePool() returns `VK_ERROR_FEATURE_NOT_PRESENT` if the memory cannot be imported to memory type
+VmaPoolCreateInfo::memoryTypeIndex, as reported by `vkGetMemoryHostPointerPropertiesEXT()`.
+The memory must stay valid until the pool is destroyed.
+
+\section custom_memory_pools_export Sharing memory with other processes
+
+With VK_KHR_external_memory and a platform-specific extension like VK_KHR_external_memory_fd
+or VK_EXT_external_memory_dma_buf enabled on the device, memory blocks of a custom pool can be
+allocated as exportable. Set VmaPoolCreateInfo::exportHandleTypes to the handle types you need.
+The library then chains `VkExportMemoryAllocateInfoKHR` to every `vkAllocateMemory()` call made for this pool.
+
+\code
+VmaPoolCreateInfo poolCreateInfo = {};
+poolCreateInfo.memoryTypeIndex = memTypeIndex;
+poolCreateInfo.exportHandleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT_KHR;
+
+VmaPool pool;
+VkResult res = vmaCreatePool(allocator, &poolCreateInfo, &pool);
+\endcode
+
+Allocations made from such pool are regular suballocations of bigger blocks.
+To pass one to another process, call vmaGetAllocationExportInfo(). It returns the `VkDeviceMemory` block
+containing the allocation, size of the whole block, and offset and size of the allocation inside it.
+Export handle of the block yourself, e.g. with `vkGetMemoryFdKHR()`, and send it together with
+the offset and size. The other process imports the whole block and binds its resource at the same offset,
+so no data is copied. The library doesn't call any of the functions that export or import handles.
+
+Please note:
+
+- Memory type of the pool must support the requested handle types. Check it with
+  `vkGetPhysicalDeviceExternalBufferProperties()` or `vkGetPhysicalDeviceImageFormatProperties2()`.
+  The resources must also be created with `VkExternalMemoryBufferCreateInfo` or `VkExternalMemoryImageCreateInfo`.
+- Don't pass exported allocations to defragmentation. Moving them would silently break the other process.
+  Allocations that can become lost cannot be exported for the same reason.
+- Allocations made outside of such pool, including dedicated allocations, are not exportable.
+  vmaGetAllocationExportInfo() returns `VK_ERROR_FEATURE_NOT_PRESENT` for them.
+
 \page defragmentation Defragmentation
 
 Interleaved allocations and deallocations of many objects of varying size can
@@ -1274,6 +1392,229 @@ You can use this feature for debugging purposes to explicitly mark allocations t
 in current frame and then analyze JSON dump to see for how long each allocation stays unused.
 
 
+\page allocation_scopes Allocation scopes
+
+Allocations that share a lifetime, like resources of a single level or streaming
+region, can be tagged with the same #VmaAllocationScope and then freed together.
+Unlike vmaResetPool(), this works with allocations made from default pools,
+custom pools of any algorithm and dedicated allocations, mixed together.
+
+\code
+VmaAllocationScope levelScope;
+vmaCreateAllocationScope(allocator, &levelScope);
+
+VmaAllocationCreateInfo allocCreateInfo = {};
+allocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+allocCreateInfo.scope = levelScope;
+
+VkBuffer buf;
+VmaAllocation alloc;
+vmaCreateBuffer(allocator, &bufCreateInfo, &allocCreateInfo, &buf, &alloc, nullptr);
+
+// Create more resources of the level...
+
+// Destroy all Vulkan buffers and images of the level, then:
+vmaDestroyAllocationScope(allocator, levelScope);
+\endcode
+
+Function vmaDestroyAllocationScope() frees all allocations of the scope in a single pass.
+They are sorted by memory block and offset, each block vector is locked only once
+and free space of each memory block is rebuilt once, which is faster than
+freeing the same allocations one by one.
+
+Allocations can still be freed individually using vmaFreeMemory(),
+vmaDestroyBuffer() etc., which also removes them from their scope.
+Buffers and images bound to allocations freed with the scope are not destroyed -
+you need to destroy them yourself, before or after destroying the scope.
+Scopes must be destroyed before the allocator.
+
+
+\page quotas Quotas
+
+Heap size limits (VmaAllocatorCreateInfo::pHeapSizeLimit) and #VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT
+work per memory heap. To give separate memory budgets to subsystems of your application,
+create a #VmaQuota for each of them. Quotas can be nested, so that a limit of a parent
+applies to the sum of usage of all its children:
+
+\code
+VmaQuotaCreateInfo quotaCreateInfo = {};
+quotaCreateInfo.limit = 512ull * 1024 * 1024;
+quotaCreateInfo.pName = "Textures";
+VmaQuota texturesQuota;
+vmaCreateQuota(allocator, &quotaCreateInfo, &texturesQuota);
+
+quotaCreateInfo.parent = texturesQuota;
+quotaCreateInfo.limit = 128ull * 1024 * 1024;
+quotaCreateInfo.pName = "Streaming";
+VmaQuota streamingQuota;
+vmaCreateQuota(allocator, &quotaCreateInfo, &streamingQuota);
+
+VmaAllocationCreateInfo allocCreateInfo = {};
+allocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+allocCreateInfo.quota = streamingQuota;
+// Fails with VK_ERROR_OUT_OF_DEVICE_MEMORY if "Streaming" or "Textures" would go over its limit.
+vmaCreateImage(allocator, &imgCreateInfo, &allocCreateInfo, &img, &alloc, nullptr);
+\endcode
+
+Size of an allocation made with VmaAllocationCreateInfo::quota is charged to the quota and all
+its ancestors before any memory block is searched, and returned when the allocation is freed.
+A custom pool created with VmaPoolCreateInfo::quota charges whole memory blocks it allocates instead,
+as it owns them regardless of how much of them is used.
+
+Usage of quotas is tracked with atomic counters, so checking and updating it doesn't take any lock.
+If a quota would go over its limit, nothing is charged, the allocation fails and VmaQuotaStats::overLimitCount
+of that quota is incremented. Current and peak usage can be queried with vmaGetQuotaStats().
+
+Quotas must be destroyed after all their child quotas, pools and allocations.
+
+
+\page deferred_destruction Deferred destruction
+
+Resources can't be destroyed while the GPU may still use them. Instead of keeping
+own lists of buffers to destroy a few frames later, you can pass them to
+vmaDestroyBufferDeferred(), vmaDestroyImageDeferred() or vmaFreeMemoryDeferred()
+together with a completion value - any monotonically increasing number that tells
+when the GPU is done with the resource, like value of a timeline semaphore signaled
+by the last submission using it, or index of the current frame.
+
+Then, whenever you learn that the GPU has progressed, call vmaProcessDeferredDestructions()
+with the latest reached value. All queued entries with completion value not greater
+than that are destroyed at once. Allocations among them are freed in a single pass
+grouped by memory block, which is cheaper than freeing them one by one.
+
+\code
+// When recording frame:
+vmaDestroyBufferDeferred(allocator, oldBuf, oldAlloc, submitSemaphoreValue);
+
+// At the beginning of next frame:
+uint64_t completedValue;
+vkGetSemaphoreCounterValue(device, timelineSemaphore, &completedValue);
+vmaProcessDeferredDestructions(allocator, completedValue, nullptr);
+\endcode
+
+When using frame indices as completion values, pass `frameIndex - framesInFlight`
+as `completedValue`, once the current frame index is at least `framesInFlight`.
+
+Entries whose allocations come from a custom pool are destroyed by vmaDestroyPool().
+Everything still queued is destroyed by vmaDestroyAllocator().
+In both cases the GPU must no longer use these resources.
+
+
+\page sparse_buffers Sparse resources
+
+\section sparse_buffers_growable Growable sparse buffers
+
+A buffer that grows by allocating new `VkDeviceMemory` blocks gets a new `VkBuffer`
+for each of them, so its contents can't be addressed as one range - for example
+with a single device address obtained from `vkGetBufferDeviceAddress()`.
+Making it bigger means creating a new buffer and copying the data.
+
+#VmaSparseBuffer avoids that. It is a single `VkBuffer` created with
+`VK_BUFFER_CREATE_SPARSE_BINDING_BIT | VK_BUFFER_CREATE_SPARSE_RESIDENCY_BIT`, covering
+the whole address range you may ever need, while memory is allocated only for pages that
+are actually used. Call vmaSparseBufferAllocate() to reserve a range of it.
+Ranges are placed at the lowest free offset, so used space stays dense at the beginning
+of the buffer. The offset is found by a linear first-fit scan over allocated ranges, so keep
+their number moderate. When a range touches a page that has no memory yet, a new `VkDeviceMemory`
+of size VmaSparseBufferCreateInfo::pageSize is allocated for it.
+When vmaSparseBufferFree() leaves a page with no ranges, its memory is released.
+
+Pages are not suballocated from bigger blocks - every page that has memory is a separate `VkDeviceMemory`.
+All of them count towards `VkPhysicalDeviceLimits::maxMemoryAllocationCount`, together with all other
+memory allocated by your program, and this limit can be as low as 4096. With the default page size of 2 MiB,
+this caps memory of all sparse buffers at about 8 GiB, and smaller pages lower the cap proportionally.
+Choose VmaSparseBufferCreateInfo::pageSize so that the number of pages with memory stays well below the limit.
+vmaSubmitSparseBinds() also walks all pages of each buffer, not only the changed ones, so its cost grows with
+VmaSparseBufferCreateInfo::size divided by the page size. If you need many small pages, create the sparse buffer
+yourself and take its pages from #VmaSparsePagePool using vmaAllocateSparseOpaquePages(), which places many pages
+in one `VkDeviceMemory` block - see \ref sparse_buffers_page_pool.
+
+Changes of page bindings are not submitted immediately. Call vmaSubmitSparseBinds()
+once per frame, passing all your sparse buffers, to bind and unbind their pages with
+a single call to `vkQueueBindSparse()`. Use semaphores passed in VmaSparseBindSubmitInfo
+to order it with your other queue submissions - newly allocated ranges can be
+accessed by the GPU only after their pages are bound.
+
+\code
+VmaSparseBufferCreateInfo sparseCreateInfo = {};
+sparseCreateInfo.size = 1024ull * 1024 * 1024;
+sparseCreateInfo.bufferUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+sparseCreateInfo.frameInUseCount = FRAMES_IN_FLIGHT - 1;
+
+VmaSparseBuffer sparseBuffer;
+VmaSparseBufferInfo sparseInfo;
+vmaCreateSparseBuffer(allocator, &sparseCreateInfo, &sparseBuffer, &sparseInfo);
+
+// When recording frame:
+VkDeviceSize offset;
+vmaSparseBufferAllocate(allocator, sparseBuffer, 65536, 256, &offset);
+// Use range [offset, offset + 65536) of sparseInfo.buffer...
+
+VmaSparseBindSubmitInfo bindSubmitInfo = {};
+bindSubmitInfo.queue = sparseQueue;
+bindSubmitInfo.signalSemaphoreCount = 1;
+bindSubmitInfo.pSignalSemaphores = &bindFinishedSemaphore;
+vmaSubmitSparseBinds(allocator, 1, &sparseBuffer, &bindSubmitInfo);
+// Wait for bindFinishedSemaphore in the submission of the frame.
+\endcode
+
+To use this feature, `sparseBinding` and `sparseResidencyBuffer` features must be enabled
+on the device and the queue passed to vmaSubmitSparseBinds() must support `VK_QUEUE_SPARSE_BINDING_BIT`.
+You also need to provide `vkQueueBindSparse` in VmaVulkanFunctions::vkQueueBindSparse,
+unless you use `VMA_STATIC_VULKAN_FUNCTIONS` or `VMA_DYNAMIC_VULKAN_FUNCTIONS`.
+
+Remarks:
+
+- Freeing a range follows the same rules as vmaFreeMemory() - the GPU must no longer use it.
+- Memory of unbound pages is kept for VmaSparseBufferCreateInfo::frameInUseCount frames
+  and reused when another page needs memory, before it is freed in vmaSubmitSparseBinds().
+  Use vmaSetCurrentFrameIndex() to inform the library about the current frame.
+- Memory of sparse buffers is included in #VmaBudget::blockBytes, but not in statistics
+  returned by vmaCalculateStats().
+
+\section sparse_buffers_page_pool Page pools for sparse images
+
+Sparse images, e.g. used for virtual texturing, are bound page by page, where page is the
+sparse block size of the image - typically 64 KiB. Allocating each page with vmaAllocateMemoryPages()
+creates a separate #VmaAllocation object for it, which becomes a bottleneck when there are
+hundreds of thousands of pages.
+
+#VmaSparsePagePool is specialized for this case. All its pages have the same size, so it
+just tracks which pages of its `VkDeviceMemory` blocks are free, using a bitmap.
+Pages are not represented by any objects. vmaAllocateSparseImagePages() fills members
+`memory` and `memoryOffset` of an array of `VkSparseImageMemoryBind` structures,
+which you can pass to `vkQueueBindSparse()` directly. To free the pages, pass the same
+structures to vmaFreeSparseImagePages(). Functions vmaAllocateSparseOpaquePages() and
+vmaFreeSparseOpaquePages() do the same for `VkSparseMemoryBind` structures used for buffers and opaque image binds.
+
+\code
+VkMemoryRequirements memReq;
+vkGetImageMemoryRequirements(device, sparseImage, &memReq);
+
+VmaSparsePagePoolCreateInfo pagePoolCreateInfo = {};
+// According to Vulkan specification, for sparse resources memReq.alignment is also page size.
+pagePoolCreateInfo.pageSize = memReq.alignment;
+pagePoolCreateInfo.memoryTypeBits = memReq.memoryTypeBits;
+
+VmaSparsePagePool pagePool;
+vmaCreateSparsePagePool(allocator, &pagePoolCreateInfo, &pagePool);
+
+// Fill subresource, offset and extent of pages that became resident this frame.
+std::vector<VkSparseImageMemoryBind> binds = ...;
+vmaAllocateSparseImagePages(allocator, pagePool, (uint32_t)binds.size(), binds.data());
+
+VkSparseImageMemoryBindInfo imageBindInfo = { sparseImage, (uint32_t)binds.size(), binds.data() };
+VkBindSparseInfo bindSparseInfo = { VK_STRUCTURE_TYPE_BIND_SPARSE_INFO };
+bindSparseInfo.imageBindCount = 1;
+bindSparseInfo.pImageBinds = &imageBindInfo;
+vkQueueBindSparse(sparseQueue, 1, &bindSparseInfo, VK_NULL_HANDLE);
+\endcode
+
+Allocation of many pages at once is all-or-nothing. Pages are taken from the block with the
+lowest index that has free ones, so other blocks can become empty and be freed.
+The pool keeps at most one empty block allocated.
+
+
 \page statistics Statistics
 
 This library contains functions that return information about its internal state,
@@ -1297,6 +1638,56 @@ Information are returned using structure #VmaPoolStats.
 You can query for information about specific allocation using function vmaGetAllocationInfo().
 It fill structure #VmaAllocationInfo.
 
+To see how much memory is used by each category of resources in your program, e.g. textures,
+meshes or render targets, assign a number of the category to VmaAllocationCreateInfo::tag
+when creating allocations. The library maintains counters of allocations, bytes and peak bytes
+per tag and memory type, updated with atomic operations as allocations are created and freed.
+Unlike other statistics, they are cheap to read with vmaGetAllocationTagStats(), e.g. every frame
+to show in a HUD. They are also included in the JSON dump.
+
+\section statistics_published_stats Publishing statistics to another process
+
+If a monitoring tool should observe the allocator live, without calling into the process
+and without taking any locks of the allocator, provide memory for published statistics in
+VmaAllocatorCreateInfo::pPublishedStatsMemory. It is typically a POSIX shared memory
+segment or a memory-mapped file created and mapped by your application, at least
+`sizeof(VmaPublishedStats)` bytes large. Creating and destroying it is up to you -
+the library only writes structure #VmaPublishedStats into it.
+
+\code
+int fd = shm_open("/my_app_vma_stats", O_CREAT | O_RDWR, 0644);
+ftruncate(fd, sizeof(VmaPublishedStats));
+void* publishedStatsMemory = mmap(nullptr, sizeof(VmaPublishedStats),
+    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+VmaAllocatorCreateInfo allocatorInfo = {};
+// Fill other members...
+allocatorInfo.pPublishedStatsMemory = publishedStatsMemory;
+\endcode
+
+Per heap, per memory type and per custom pool counters of blocks and allocations,
+current budget and counters of operations are updated incrementally on every
+allocation and free, so they are always current. Statistics of only first
+#VMA_PUBLISHED_STATS_MAX_POOLS custom pools existing at the same time are published.
+
+Counters are updated with atomic operations, without any lock, so threads allocating
+memory never wait for each other because of publishing. Each update is bracketed by incrementing
+VmaPublishedStats::beginSequence and VmaPublishedStats::endSequence, which are equal
+when no update is in progress. The reader copies the structure and retries if an update
+was in progress or `beginSequence` changed meanwhile. vmaReadPublishedStats() does exactly that,
+so the monitoring tool can call it on its own mapping of the memory:
+
+\code
+VmaPublishedStats stats;
+if(vmaReadPublishedStats(mappedPublishedStatsMemory, &stats) == VK_SUCCESS)
+{
+    // Use stats.heaps[heapIndex].allocationBytes etc.
+}
+\endcode
+
+vmaDestroyAllocator() clears VmaPublishedStats::magic, so after that vmaReadPublishedStats()
+returns `VK_ERROR_INITIALIZATION_FAILED`.
+
 \section statistics_json_dump JSON dump
 
 You can dump internal state of the allocator to a string in JSON format using function vmaBuildStatsString().
@@ -1524,6 +1915,48 @@ To enable it, define following macro before every include of this library:
 VmaAllocatorCreateInfo::pRecordSettings member while creating #VmaAllocator
 object. File is opened and written during whole lifetime of the allocator.
 
+<b>To keep only recent history in memory:</b> Additionally set
+VmaRecordSettings::ringBufferSize. Calls are then recorded to a buffer of this size
+in RAM, overwriting the oldest ones, and nothing is written to disk until you call
+vmaDumpRecording(), e.g. after an out-of-memory error or from a crash handler that runs
+as a regular thread - see the function for details.
+With #VMA_RECORD_DUMP_ON_ALLOCATION_FAILURE_BIT, the file is also written automatically
+when an allocation fails for the first time. The dump is a regular recording file.
+It starts with calls that create pools and allocations still alive but created before
+the oldest call kept in the buffer, so it can be replayed even though it starts in
+the middle of the program.
+
+\code
+VmaRecordSettings recordSettings = {};
+recordSettings.flags = VMA_RECORD_DUMP_ON_ALLOCATION_FAILURE_BIT;
+recordSettings.pFilePath = "LastCalls.csv";
+recordSettings.ringBufferSize = 16ull * 1024 * 1024;
+allocatorInfo.pRecordSettings = &recordSettings;
+\endcode
+
+<b>To record only part of the calls:</b> Fill VmaRecordSettings::memoryTypeBits,
+VmaRecordSettings::minAllocationSize, VmaRecordSettings::maxAllocationSize, or
+VmaRecordSettings::allocationSamplingRate, or use #VMA_RECORD_SELECTED_POOLS_ONLY_BIT and
+select custom pools with vmaSetPoolRecordingEnabled(). The decision is made once, when the allocation
+is created, and all later calls referring to it, like vmaMapMemory() or vmaFreeMemory(),
+are recorded or skipped together with it, so the file still replays correctly. Calls that are skipped
+cost little more than a check of a flag, so this can make recording usable in allocation-heavy code.
+Failed allocations are always recorded.
+
+\code
+recordSettings.flags = VMA_RECORD_SELECTED_POOLS_ONLY_BIT;
+allocatorInfo.pRecordSettings = &recordSettings;
+// ...
+vmaSetPoolRecordingEnabled(allocator, streamingPool, VK_TRUE);
+\endcode
+
+<b>To compare placement of allocations:</b> Additionally set
+#VMA_RECORD_ALLOCATION_PLACEMENT_BIT. After every call that creates allocations, the
+recording then contains their memory type, id of the memory block, offset in that block,
+and whether a new block had to be allocated for them. VmaReplay compares it with placement
+made during replay, reports how many allocations ended up elsewhere, and how much less or more
+`VkDeviceMemory` had to be allocated, e.g. after changing allocation algorithm or block size.
+
 <b>To replay file:</b> Use VmaReplay - standalone command-line program.
 Precompiled binary can be found in "bin" directory.
 Its source can be found in "src/VmaReplay" directory.
@@ -1642,6 +2075,38 @@ e.g. results of some computations.
 Create them using #VMA_MEMORY_USAGE_GPU_TO_CPU.
 You can write to them directly on GPU, as well as map and read them on CPU.
 
+For small pieces of data read back every frame, like query results, statistics
+gathered on GPU or screenshots, you can use #VmaReadbackHeap instead of creating
+a separate buffer for each of them. It is a persistently mapped buffer divided into
+one slice per frame in flight, allocated like #VMA_MEMORY_USAGE_GPU_TO_CPU, so it
+ends up in `HOST_CACHED` memory when available.
+Regions are allocated from the slice of the current frame and never freed individually -
+the whole slice is reused `frameInUseCount + 1` frames later.
+
+\code
+VmaReadbackHeapCreateInfo heapCreateInfo = {};
+heapCreateInfo.frameSize = 64 * 1024;
+heapCreateInfo.frameInUseCount = FRAMES_IN_FLIGHT - 1;
+
+VmaReadbackHeap readbackHeap;
+vmaCreateReadbackHeap(allocator, &heapCreateInfo, &readbackHeap, nullptr);
+
+// When recording frame:
+vmaSetCurrentFrameIndex(allocator, frameIndex);
+VmaReadbackRegion region;
+vmaAllocateReadbackRegion(allocator, readbackHeap, queryCount * sizeof(uint64_t), 8, &region);
+vkCmdCopyQueryPoolResults(cmdBuf, queryPool, 0, queryCount, region.buffer, region.offset,
+    sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+// After waiting for the fence of frame oldFrameIndex:
+vmaInvalidateReadbackHeaps(allocator, 1, &readbackHeap, oldFrameIndex);
+// Read results from regions allocated in oldFrameIndex.
+\endcode
+
+vmaInvalidateReadbackHeaps() invalidates everything allocated in the given frame from
+all passed heaps with a single call to `vkInvalidateMappedMemoryRanges()`,
+instead of one call for every readback.
+
 \section usage_patterns_advanced Advanced patterns
 
 \subsection usage_patterns_integrated_graphics Detecting integrated graphics
@@ -1703,6 +2168,38 @@ an simple optimization for cases when your resource ends up in mappable memory t
 directly in this case instead of creating CPU-side staging copy.
 For details see [Finding out if memory is mappable](@ref memory_mapping_finding_if_memory_mappable).
 
+\subsection usage_patterns_bar_balancing Sharing DEVICE_LOCAL + HOST_VISIBLE memory
+
+Memory type that is both `DEVICE_LOCAL` and `HOST_VISIBLE` is often limited to a 256 MiB heap
+(a PCIe BAR) unless Resizable BAR is enabled. Memory type is chosen once, when allocation is made,
+so this memory goes to whichever resources happen to be created first, not to those that benefit from it the most.
+
+If your dynamic buffers support both approaches described above - writing through a mapped pointer
+when the buffer is `HOST_VISIBLE` and through a staging buffer and transfer otherwise - you can call
+vmaBalanceBarMemory() from time to time, e.g. once per frame, passing all of them.
+It ranks them by number of CPU writes since previous call and returns list of moves
+that bring the most frequently written ones into this memory, moving rarely written ones out of it when space is needed.
+
+\code
+VmaBarBalanceInfo balanceInfo = {};
+balanceInfo.allocationCount = (uint32_t)dynamicAllocs.size();
+balanceInfo.pAllocations = dynamicAllocs.data();
+balanceInfo.memoryTypeBits = memReq.memoryTypeBits;
+balanceInfo.maxBarBytes = 128ull * 1024 * 1024;
+
+VmaBarMove moves[16];
+uint32_t moveCount = 16;
+vmaBalanceBarMemory(allocator, &balanceInfo, &moveCount, moves);
+for(uint32_t i = 0; i < moveCount; ++i)
+{
+    // Create new buffer, bind it to moves[i].dstAllocation and record vkCmdCopyBuffer from the old one.
+    // Destroy the old buffer and free moves[i].srcAllocation when the copy has completed.
+}
+\endcode
+
+CPU writes are counted as calls to vmaMapMemory(), vmaFlushAllocation() and vmaFlushAllocations().
+If your resources stay persistently mapped, count writes yourself and pass them as VmaBarBalanceInfo::pHostAccessCounts.
+
 
 \page configuration Configuration
 
@@ -1933,6 +2430,62 @@ To learn more about this extension, see [VK_KHR_buffer_device_address in Vulkan
 Example use of this extension can be found in the code of the sample and test suite
 accompanying this library.
 
+\page enabling_memory_priority Enabling memory priority
+
+Device extension VK_EXT_memory_priority lets you tell the driver which memory blocks
+are more important to stay resident in video memory when it is oversubscribed.
+Extension VK_EXT_pageable_device_local_memory additionally allows changing the priority
+of memory that is already allocated.
+
+\section enabling_memory_priority_initialization Initialization
+
+1) Call `vkEnumerateDeviceExtensionProperties` for the physical device.
+Check if the extensions are supported - if returned array of `VkExtensionProperties` contains
+"VK_EXT_memory_priority" and optionally "VK_EXT_pageable_device_local_memory".
+
+2) Check if the device features are really supported - `VkPhysicalDeviceMemoryPriorityFeaturesEXT::memoryPriority`
+and `VkPhysicalDevicePageableDeviceLocalMemoryFeaturesEXT::pageableDeviceLocalMemory`.
+
+3) While creating device with `vkCreateDevice`, enable these extensions and features.
+
+4) While creating #VmaAllocator with vmaCreateAllocator() inform VMA that you
+have enabled them - add #VMA_ALLOCATOR_CREATE_EXT_MEMORY_PRIORITY_BIT and
+#VMA_ALLOCATOR_CREATE_EXT_PAGEABLE_DEVICE_LOCAL_MEMORY_BIT to VmaAllocatorCreateInfo::flags.
+
+\section enabling_memory_priority_usage Usage
+
+Priority is a number between 0 and 1, where 0.5 is the default. Set it in VmaPoolCreateInfo::priority
+for all blocks of a custom pool, or in VmaAllocationCreateInfo::priority for a single allocation:
+
+\code
+VmaAllocationCreateInfo allocCreateInfo = {};
+allocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+allocCreateInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+allocCreateInfo.priority = 1.0f;
+
+VkImage renderTarget;
+VmaAllocation renderTargetAlloc;
+vmaCreateImage(allocator, &imgCreateInfo, &allocCreateInfo, &renderTarget, &renderTargetAlloc, nullptr);
+\endcode
+
+With only VK_EXT_memory_priority enabled, the priority is passed to `vkAllocateMemory()`, so it affects
+custom pools and dedicated allocations. Allocations made from default pools share blocks with other allocations,
+so their own priority is ignored.
+
+With VK_EXT_pageable_device_local_memory enabled too, the library also maintains the priority of existing memory:
+
+- A block takes the highest priority of the allocations made in it since it was last empty,
+  including blocks of default pools.
+- Memory not used for more than `VMA_COLD_MEMORY_FRAME_COUNT` frames (16 by default) is considered cold and its priority is halved,
+  so it is paged out before memory used recently. Memory gets its priority back when it is used again.
+  Memory is used in the frame when an allocation is made in it, or when vmaTouchAllocation() or vmaGetAllocationInfo()
+  is called for an allocation in it.
+- The priorities are recomputed in vmaSetCurrentFrameIndex(). `vkSetDeviceMemoryPriorityEXT()` is called only
+  for memory whose priority changed.
+
+To benefit from this, call vmaSetCurrentFrameIndex() every frame and vmaTouchAllocation() for
+allocations used in the frame, just like for [lost allocations](@ref lost_allocations).
+
 \page general_considerations General considerations
 
 \section general_considerations_thread_safety Thread safety
@@ -1994,11 +2547,14 @@ Features deliberately excluded from the scope of this library:
   Defining some "texture" object that would automatically stream its data from a
   staging copy in CPU memory to GPU memory would rather be a feature of another,
   higher-level library implemented on top of VMA.
-- Allocations for imported/exported external memory. They tend to require
-  explicit memory type index and dedicated allocation anyway, so they don't
-  interact with main features of this library. Such special purpose allocations
+- Allocations for imported/exported external memory, other than custom pools described in
+  [Importing host memory](@ref custom_memory_pools_host_pointer) and
+  [Sharing memory with other processes](@ref custom_memory_pools_export).
+  Other cases tend to require explicit memory type index and dedicated allocation anyway,
+  so they don't interact with main features of this library. Such special purpose allocations
   should be made manually, using `vkCreateBuffer()` and `vkAllocateMemory()`.
-- Sub-allocation of parts of one large buffer. Although recommended as a good practice,
+- Sub-allocation of parts of one large buffer, other than [sparse buffers](@ref sparse_buffers)
+  and [readback heaps](@ref usage_patterns_readback). Although recommended as a good practice,
   it is the user's responsibility to implement such logic on top of VMA.
 - Recreation of buffers and images. Although the library has functions for
   buffer and image creation (vmaCreateBuffer(), vmaCreateImage()), you need to
@@ -2031,6 +2587,14 @@ available through VmaAllocatorCreateInfo::pRecordSettings.
     #define VMA_RECORDING_ENABLED 0
 #endif
 
+/*
+Define this macro to the number of distinct values of VmaAllocationCreateInfo::tag
+the library keeps statistics for. Must be between 1 and 256.
+*/
+#ifndef VMA_ALLOCATION_TAG_COUNT
+    #define VMA_ALLOCATION_TAG_COUNT 32
+#endif
+
 #if !defined(NOMINMAX) && defined(VMA_IMPLEMENTATION)
     #define NOMINMAX // For windows.h
 #endif
@@ -2055,6 +2619,7 @@ available through VmaAllocatorCreateInfo::pRecordSettings.
     extern PFN_vkCreateImage vkCreateImage;
     extern PFN_vkDestroyImage vkDestroyImage;
     extern PFN_vkCmdCopyBuffer vkCmdCopyBuffer;
+    extern PFN_vkQueueBindSparse vkQueueBindSparse;
     #if VMA_VULKAN_VERSION >= 1001000
         extern PFN_vkGetBufferMemoryRequirements2 vkGetBufferMemoryRequirements2;
         extern PFN_vkGetImageMemoryRequirements2 vkGetImageMemoryRequirements2;
@@ -2105,6 +2670,38 @@ available through VmaAllocatorCreateInfo::pRecordSettings.
     #endif
 #endif
 
+#if !defined(VMA_MEMORY_PRIORITY)
+    #if VK_EXT_memory_priority
+        #define VMA_MEMORY_PRIORITY 1
+    #else
+        #define VMA_MEMORY_PRIORITY 0
+    #endif
+#endif
+
+#if !defined(VMA_PAGEABLE_DEVICE_LOCAL_MEMORY)
+    #if VK_EXT_pageable_device_local_memory
+        #define VMA_PAGEABLE_DEVICE_LOCAL_MEMORY 1
+    #else
+        #define VMA_PAGEABLE_DEVICE_LOCAL_MEMORY 0
+    #endif
+#endif
+
+#if !defined(VMA_EXTERNAL_MEMORY)
+    #if VK_KHR_external_memory
+        #define VMA_EXTERNAL_MEMORY 1
+    #else
+        #define VMA_EXTERNAL_MEMORY 0
+    #endif
+#endif
+
+#if !defined(VMA_EXTERNAL_MEMORY_HOST)
+    #if VK_EXT_external_memory_host
+        #define VMA_EXTERNAL_MEMORY_HOST 1
+    #else
+        #define VMA_EXTERNAL_MEMORY_HOST 0
+    #endif
+#endif
+
 // Defined to 1 when VK_KHR_buffer_device_address device extension or equivalent core Vulkan 1.2 feature is defined in its headers.
 #if !defined(VMA_BUFFER_DEVICE_ADDRESS)
     #if VK_KHR_buffer_device_address || VMA_VULKAN_VERSION >= 1002000
@@ -2316,6 +2913,43 @@ typedef enum VmaAllocatorCreateFlagBits {
     For more information, see documentation chapter \ref enabling_buffer_device_address.
     */
     VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT = 0x00000020,
+    /**
+    Enables usage of VK_EXT_external_memory_host extension.
+
+    You may set this flag only if you found out that this device extension is supported,
+    you enabled it while creating Vulkan device passed as VmaAllocatorCreateInfo::device,
+    and you want it to be used internally by this library.
+
+    The extension allows creating custom pools in memory allocated by your application,
+    using VmaPoolCreateInfo::pHostPointer. It requires also `vkGetPhysicalDeviceProperties2` (Vulkan 1.1)
+    or `vkGetPhysicalDeviceProperties2KHR` (VK_KHR_get_physical_device_properties2) to be available.
+    For more information, see [Importing host memory](@ref custom_memory_pools_host_pointer).
+    */
+    VMA_ALLOCATOR_CREATE_EXT_EXTERNAL_MEMORY_HOST_BIT = 0x00000040,
+    /**
+    Enables usage of VK_EXT_memory_priority extension.
+
+    You may set this flag only if you found out that this device extension is supported
+    and its feature `VkPhysicalDeviceMemoryPriorityFeaturesEXT::memoryPriority` is enabled
+    while creating Vulkan device passed as VmaAllocatorCreateInfo::device.
+
+    When this flag is set, VmaPoolCreateInfo::priority and VmaAllocationCreateInfo::priority
+    are passed to `vkAllocateMemory()`.
+    For more information, see documentation chapter \ref enabling_memory_priority.
+    */
+    VMA_ALLOCATOR_CREATE_EXT_MEMORY_PRIORITY_BIT = 0x00000080,
+    /**
+    Enables usage of VK_EXT_pageable_device_local_memory extension.
+
+    You may set this flag only together with #VMA_ALLOCATOR_CREATE_EXT_MEMORY_PRIORITY_BIT,
+    if you found out that this device extension is supported and enabled it with its feature
+    `VkPhysicalDevicePageableDeviceLocalMemoryFeaturesEXT::pageableDeviceLocalMemory`.
+
+    When this flag is set, vmaSetCurrentFrameIndex() updates priority of existing memory
+    depending on how recently it was used.
+    For more information, see documentation chapter \ref enabling_memory_priority.
+    */
+    VMA_ALLOCATOR_CREATE_EXT_PAGEABLE_DEVICE_LOCAL_MEMORY_BIT = 0x00000100,
 
     VMA_ALLOCATOR_CREATE_FLAG_BITS_MAX_ENUM = 0x7FFFFFFF
 } VmaAllocatorCreateFlagBits;
@@ -2354,6 +2988,15 @@ typedef struct VmaVulkanFunctions {
 #if VMA_MEMORY_BUDGET || VMA_VULKAN_VERSION >= 1001000
     PFN_vkGetPhysicalDeviceMemoryProperties2KHR VMA_NULLABLE vkGetPhysicalDeviceMemoryProperties2KHR;
 #endif
+#if VMA_EXTERNAL_MEMORY_HOST
+    PFN_vkGetMemoryHostPointerPropertiesEXT VMA_NULLABLE vkGetMemoryHostPointerPropertiesEXT;
+    PFN_vkGetPhysicalDeviceProperties2KHR VMA_NULLABLE vkGetPhysicalDeviceProperties2KHR;
+#endif
+#if VMA_PAGEABLE_DEVICE_LOCAL_MEMORY
+    PFN_vkSetDeviceMemoryPriorityEXT VMA_NULLABLE vkSetDeviceMemoryPriorityEXT;
+#endif
+    /// Optional. Required only by vmaSubmitSparseBinds().
+    PFN_vkQueueBindSparse VMA_NULLABLE vkQueueBindSparse;
 } VmaVulkanFunctions;
 
 /// Flags to be used in VmaRecordSettings::flags.
@@ -2364,6 +3007,21 @@ typedef enum VmaRecordFlagBits {
     It may degrade performance though.
     */
     VMA_RECORD_FLUSH_AFTER_CALL_BIT = 0x00000001,
+    /** \brief Writes the recording to VmaRecordSettings::pFilePath when an allocation fails for the first time.
+
+    Meaningful only when VmaRecordSettings::ringBufferSize is not 0.
+    */
+    VMA_RECORD_DUMP_ON_ALLOCATION_FAILURE_BIT = 0x00000002,
+    /** \brief Records placement of every new allocation: memory type, block, offset, and whether it created a new block.
+
+    VmaReplay uses it to compare placement made during replay with the original one.
+    */
+    VMA_RECORD_ALLOCATION_PLACEMENT_BIT = 0x00000004,
+    /** \brief Records allocations only from custom pools selected using vmaSetPoolRecordingEnabled().
+
+    Allocations made outside of custom pools, including dedicated allocations, are not recorded.
+    */
+    VMA_RECORD_SELECTED_POOLS_ONLY_BIT = 0x00000008,
 
     VMA_RECORD_FLAG_BITS_MAX_ENUM = 0x7FFFFFFF
 } VmaRecordFlagBits;
@@ -2380,8 +3038,35 @@ typedef struct VmaRecordSettings
     If the file already exists, it will be overwritten.
     It will be opened for the whole time #VmaAllocator object is alive.
     If opening this file fails, creation of the whole allocator object fails.
+
+    If `ringBufferSize` is not 0, the file is not opened until the recording is dumped.
     */
     const char* VMA_NOT_NULL pFilePath;
+    /** \brief Optional. Size of in-memory buffer for the most recent calls, in bytes.
+
+    If not 0, calls are recorded to a ring buffer of this size instead of the file,
+    and written to a file only by vmaDumpRecording() or due to #VMA_RECORD_DUMP_ON_ALLOCATION_FAILURE_BIT.
+    A call takes about 100 bytes. Additionally, about 70 bytes are kept outside of the buffer
+    for every recorded pool and allocation that is alive.
+    */
+    size_t ringBufferSize;
+    /** \brief Optional. Bit mask of memory types whose allocations are recorded.
+
+    0 means all memory types.
+    */
+    uint32_t memoryTypeBits;
+    /// Optional. Allocations smaller than this are not recorded.
+    VkDeviceSize minAllocationSize;
+    /** \brief Optional. Allocations larger than this are not recorded.
+
+    0 means no limit.
+    */
+    VkDeviceSize maxAllocationSize;
+    /** \brief Optional. If greater than 1, only about one in `allocationSamplingRate` allocations is recorded.
+
+    Allocations are selected by hash of their handle.
+    */
+    uint32_t allocationSamplingRate;
 } VmaRecordSettings;
 
 /// Description of a Allocator to be created.
@@ -2470,6 +3155,14 @@ typedef struct VmaAllocatorCreateInfo
     Leaving it initialized to zero is equivalent to `VK_API_VERSION_1_0`.
     */
     uint32_t vulkanApiVersion;
+    /** \brief Optional. Memory where the allocator publishes its live statistics, e.g. mapped shared memory segment.
+
+    If not null, it must point to at least `sizeof(VmaPublishedStats)` bytes aligned to 8 bytes,
+    which stay valid throughout whole lifetime of created allocator.
+    The library writes structure #VmaPublishedStats there and keeps it up to date.
+    For details see [Publishing statistics to another process](@ref statistics_published_stats).
+    */
+    void* VMA_NULLABLE pPublishedStatsMemory;
 } VmaAllocatorCreateInfo;
 
 /// Creates Allocator object.
@@ -2502,6 +3195,31 @@ typedef struct VmaAllocatorInfo
     VkDevice VMA_NOT_NULL device;
 } VmaAllocatorInfo;
 
+/** \brief Writes calls recorded in the ring buffer to a file.
+
+\param pFilePath Path to the file to be created or overwritten. Null means VmaRecordSettings::pFilePath.
+
+Available only if the allocator was created with VmaRecordSettings::ringBufferSize not 0,
+returns `VK_ERROR_FEATURE_NOT_PRESENT` otherwise.
+Recording continues after the dump. The file contains the configuration and the most recent
+calls that fit in the buffer, in the same format as a regular recording. Before them, it contains
+a snapshot of recorded pools and allocations that are alive but whose creating calls no longer fit
+in the buffer, written as calls to vmaCreatePool(), vmaAllocateMemory() or vmaCreateLostAllocation()
+with thread 0, time 0, frame index 0 and no user data. Allocations in the snapshot request the memory type
+they were given and dedicated memory if they got it.
+
+It never waits for a lock. It doesn't take the global mutex enabled with `VMA_DEBUG_GLOBAL_MUTEX`,
+and if the mutex of the recorder is held because another call is being recorded right now,
+possibly by a thread that crashed in the middle of it, it returns `VK_NOT_READY` without writing anything.
+
+The file is written with `fopen()` and `fwrite()`, which are not async-signal-safe. Call it from
+a crash handler that runs as a regular thread, like an unhandled exception filter or a
+`std::set_terminate()` handler, not from a POSIX signal handler.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaDumpRecording(
+    VmaAllocator VMA_NOT_NULL allocator,
+    const char* VMA_NULLABLE pFilePath);
+
 /** \brief Returns information about existing #VmaAllocator object - handle to Vulkan device etc.
 
 It might be useful if you want to keep just the #VmaAllocator handle and fetch other required handles to
@@ -2543,6 +3261,9 @@ This function must be used if you make allocations with
 #VMA_ALLOCATION_CREATE_CAN_MAKE_OTHER_LOST_BIT flags to inform the allocator
 when a new frame begins. Allocations queried using vmaGetAllocationInfo() cannot
 become lost in the current frame.
+
+If #VMA_ALLOCATOR_CREATE_EXT_PAGEABLE_DEVICE_LOCAL_MEMORY_BIT was used, it also updates
+priorities of memory blocks, as described in \ref enabling_memory_priority.
 */
 VMA_CALL_PRE void VMA_CALL_POST vmaSetCurrentFrameIndex(
     VmaAllocator VMA_NOT_NULL allocator,
@@ -2642,6 +3363,115 @@ VMA_CALL_PRE void VMA_CALL_POST vmaGetBudget(
     VmaAllocator VMA_NOT_NULL allocator,
     VmaBudget* VMA_NOT_NULL pBudget);
 
+/// Statistics of allocations having the same VmaAllocationCreateInfo::tag, per memory type.
+typedef struct VmaAllocationTagStats
+{
+    /// Number of existing allocations with the tag.
+    uint32_t allocationCount[VK_MAX_MEMORY_TYPES];
+    /// Sum size of existing allocations with the tag, in bytes.
+    VkDeviceSize allocationBytes[VK_MAX_MEMORY_TYPES];
+    /// Maximum value `allocationBytes` had since the allocator was created.
+    VkDeviceSize peakAllocationBytes[VK_MAX_MEMORY_TYPES];
+} VmaAllocationTagStats;
+
+/** \brief Retrieves statistics of allocations created with specific VmaAllocationCreateInfo::tag.
+
+\param tag Must be less than #VMA_ALLOCATION_TAG_COUNT.
+\param[out] pTagStats Statistics of the tag, per memory type.
+
+This function is very fast and doesn't take any lock, so it can be called every frame.
+*/
+VMA_CALL_PRE void VMA_CALL_POST vmaGetAllocationTagStats(
+    VmaAllocator VMA_NOT_NULL allocator,
+    uint32_t tag,
+    VmaAllocationTagStats* VMA_NOT_NULL pTagStats);
+
+/// Value of VmaPublishedStats::magic.
+#define VMA_PUBLISHED_STATS_MAGIC 0x53414D56u
+/// Value of VmaPublishedStats::version. Incremented on every change of the layout of #VmaPublishedStats.
+#define VMA_PUBLISHED_STATS_VERSION 2u
+/// Number of elements in VmaPublishedStats::pools.
+#define VMA_PUBLISHED_STATS_MAX_POOLS 32u
+
+/// Counters of memory blocks and allocations, part of #VmaPublishedStats.
+typedef struct VmaPublishedStatCounters
+{
+    /// Number of `VkDeviceMemory` blocks, including dedicated allocations.
+    uint64_t blockCount;
+    /// Sum size of `VkDeviceMemory` blocks, in bytes.
+    uint64_t blockBytes;
+    /// Number of #VmaAllocation objects, including lost ones.
+    uint64_t allocationCount;
+    /// Sum size of #VmaAllocation objects, in bytes.
+    uint64_t allocationBytes;
+} VmaPublishedStatCounters;
+
+/// Published statistics of a memory heap.
+typedef struct VmaPublishedHeapStats
+{
+    VmaPublishedStatCounters counters;
+    /// Same as VmaBudget::usage.
+    uint64_t usage;
+    /// Same as VmaBudget::budget.
+    uint64_t budget;
+} VmaPublishedHeapStats;
+
+/// Published statistics of a custom pool.
+typedef struct VmaPublishedPoolStats
+{
+    /// True if this element describes an existing custom pool. Other members are meaningless otherwise.
+    VkBool32 active;
+    /// Identifier of the pool, as used in the JSON dump.
+    uint32_t poolId;
+    uint32_t memoryTypeIndex;
+    uint32_t reserved;
+    VmaPublishedStatCounters counters;
+} VmaPublishedPoolStats;
+
+/** \brief Layout of memory pointed by VmaAllocatorCreateInfo::pPublishedStatsMemory.
+
+It contains only plain integers, so it can be read by a process built with a different compiler.
+Read it with vmaReadPublishedStats().
+*/
+typedef struct VmaPublishedStats
+{
+    /// Equal to #VMA_PUBLISHED_STATS_MAGIC once the allocator initialized the memory, 0 after it was destroyed.
+    uint32_t magic;
+    /// Equal to #VMA_PUBLISHED_STATS_VERSION.
+    uint32_t version;
+    /// Incremented at the beginning of every update.
+    uint64_t beginSequence;
+    /// Incremented at the end of every update. Equal to `beginSequence` when no update is in progress.
+    uint64_t endSequence;
+    uint32_t memoryHeapCount;
+    uint32_t memoryTypeCount;
+    /// Number of allocations created so far.
+    uint64_t allocationOperationCount;
+    /// Number of allocations freed so far.
+    uint64_t freeOperationCount;
+    /// Number of successful calls to `vkAllocateMemory` made so far.
+    uint64_t deviceMemoryAllocationCount;
+    /// Number of calls to `vkFreeMemory` made so far.
+    uint64_t deviceMemoryFreeCount;
+    VmaPublishedHeapStats heaps[VK_MAX_MEMORY_HEAPS];
+    VmaPublishedStatCounters memoryTypes[VK_MAX_MEMORY_TYPES];
+    VmaPublishedPoolStats pools[VMA_PUBLISHED_STATS_MAX_POOLS];
+} VmaPublishedStats;
+
+/** \brief Reads consistent copy of statistics published by an allocator, possibly running in another process.
+
+\param pPublishedMemory Memory passed as VmaAllocatorCreateInfo::pPublishedStatsMemory, or another mapping of it.
+\param[out] pStats Copy of the statistics.
+
+Doesn't need any allocator object and doesn't take any lock.
+Returns `VK_ERROR_INITIALIZATION_FAILED` if the memory doesn't contain statistics
+of a compatible version or the allocator was destroyed, or `VK_NOT_READY` if it was being updated all the time
+during a number of attempts to read it.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaReadPublishedStats(
+    const void* VMA_NOT_NULL pPublishedMemory,
+    VmaPublishedStats* VMA_NOT_NULL pStats);
+
 #ifndef VMA_STATS_STRING_ENABLED
 #define VMA_STATS_STRING_ENABLED 1
 #endif
@@ -2813,6 +3643,40 @@ typedef enum VmaAllocationCreateFlagBits {
     memory budget. Otherwise return `VK_ERROR_OUT_OF_DEVICE_MEMORY`.
     */
     VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT = 0x00000100,
+    /** Allocation will be returned with its memory filled with zeros.
+
+    Free ranges already cleared by vmaZeroFreeMemory() are used first, so no additional
+    work is needed. Otherwise, in `HOST_VISIBLE` memory types the allocation is cleared on the CPU
+    using `memset` before it is returned. In memory types that are not `HOST_VISIBLE`,
+    the allocation succeeds only if there is a large enough range cleared by vmaZeroFreeMemory(),
+    otherwise `VK_ERROR_OUT_OF_DEVICE_MEMORY` is returned. Such allocation never creates
+    new memory block or dedicated allocation.
+    Together with #VMA_ALLOCATION_CREATE_PAGES_SAME_BLOCK_BIT or #VMA_ALLOCATION_CREATE_PAGES_CONTIGUOUS_BIT,
+    it is supported only in `HOST_VISIBLE` memory types - in other types vmaAllocateMemoryPages()
+    returns `VK_ERROR_FEATURE_NOT_PRESENT`.
+
+    Ranges cleared in advance are tracked only in default pools and custom pools
+    that use default algorithm.
+    */
+    VMA_ALLOCATION_CREATE_ZEROED_BIT = 0x00000200,
+    /** All allocations made by single call to vmaAllocateMemoryPages() will be placed in the same `VkDeviceMemory` block.
+
+    If there is no existing block that can fit all of them, a new block is created, large enough for all the pages
+    unless custom pool has explicit block size. Dedicated allocations are never used.
+    If the pages cannot be placed together, the function fails and no allocation is made.
+
+    The flag is ignored when only one allocation is made.
+    It cannot be used together with #VMA_ALLOCATION_CREATE_CAN_MAKE_OTHER_LOST_BIT or #VMA_ALLOCATION_CREATE_UPPER_ADDRESS_BIT.
+    */
+    VMA_ALLOCATION_CREATE_PAGES_SAME_BLOCK_BIT = 0x00000400,
+    /** Like #VMA_ALLOCATION_CREATE_PAGES_SAME_BLOCK_BIT, but the allocations are also placed one after another, in
+    order of the `pAllocations` array, each one at the offset of the previous one plus its size aligned up to required alignment.
+
+    Place for all the pages is found using single search for free range of their total size, so this is
+    also the fastest way to make many allocations at once.
+    Not supported in custom pools that use #VMA_POOL_CREATE_BUDDY_ALGORITHM_BIT.
+    */
+    VMA_ALLOCATION_CREATE_PAGES_CONTIGUOUS_BIT = 0x00000800,
 
     /** Allocation strategy that chooses smallest possible free range for the
     allocation.
@@ -2851,6 +3715,68 @@ typedef enum VmaAllocationCreateFlagBits {
 } VmaAllocationCreateFlagBits;
 typedef VkFlags VmaAllocationCreateFlags;
 
+/** \brief Hint describing for how long an allocation is expected to live.
+
+Passed as VmaAllocationCreateInfo::lifetime. Allocations with the same hint are
+grouped together in the same memory blocks, so that blocks holding transient
+data can become empty as a whole and be released, instead of being pinned by a
+single long-lived allocation placed among them.
+
+Inside blocks of the default algorithm, #VMA_ALLOCATION_LIFETIME_SHORT and
+#VMA_ALLOCATION_LIFETIME_FRAME allocations are placed at the highest suitable
+address, while other allocations grow from the beginning of the block,
+similarly to a double stack.
+
+If no block with matching lifetime has enough space and a new block cannot be
+created, the allocation is still placed in any block that can fit it.
+
+The hint is ignored for dedicated allocations and in custom pools that use
+#VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT. In such pools, use
+#VMA_ALLOCATION_CREATE_UPPER_ADDRESS_BIT to separate allocations explicitly.
+*/
+typedef enum VmaAllocationLifetime
+{
+    /** No lifetime hint. Allocation can be placed in any block - this is the default behavior.
+    */
+    VMA_ALLOCATION_LIFETIME_UNKNOWN = 0,
+    /** Allocation lives for a very short time, e.g. a staging buffer freed right after the copy.
+    */
+    VMA_ALLOCATION_LIFETIME_SHORT = 1,
+    /** Allocation lives for about one frame or a few frames in flight.
+    */
+    VMA_ALLOCATION_LIFETIME_FRAME = 2,
+    /** Allocation lives until some larger unit of content is unloaded, e.g. a level or a streaming region.
+    */
+    VMA_ALLOCATION_LIFETIME_LEVEL = 3,
+    /** Allocation lives for the whole time of the application.
+    */
+    VMA_ALLOCATION_LIFETIME_PERMANENT = 4,
+
+    VMA_ALLOCATION_LIFETIME_MAX_ENUM = 0x7FFFFFFF
+} VmaAllocationLifetime;
+
+/** \struct VmaAllocationScope
+\brief Represents a group of allocations that can be freed all at once.
+
+Call function vmaCreateAllocationScope() to create it and pass it as
+VmaAllocationCreateInfo::scope to tag new allocations with it.
+Call function vmaDestroyAllocationScope() to free all allocations still
+belonging to the scope and destroy it.
+
+For more information see [Allocation scopes](@ref allocation_scopes).
+*/
+VK_DEFINE_HANDLE(VmaAllocationScope)
+
+/** \struct VmaQuota
+\brief Represents a limit of memory that can be used by a group of allocations and pools.
+
+Call function vmaCreateQuota() to create it and pass it as VmaAllocationCreateInfo::quota
+or VmaPoolCreateInfo::quota.
+
+For more information see [Quotas](@ref quotas).
+*/
+VK_DEFINE_HANDLE(VmaQuota)
+
 typedef struct VmaAllocationCreateInfo
 {
     /// Use #VmaAllocationCreateFlagBits enum.
@@ -2892,6 +3818,37 @@ typedef struct VmaAllocationCreateInfo
     internal buffer, so it doesn't need to be valid after allocation call.
     */
     void* VMA_NULLABLE pUserData;
+    /** \brief Expected lifetime of the allocation. Optional.
+
+    Leave #VMA_ALLOCATION_LIFETIME_UNKNOWN to place the allocation without regard to lifetime.
+    See #VmaAllocationLifetime for details.
+    */
+    VmaAllocationLifetime lifetime;
+    /** \brief Scope that new allocation will belong to. Optional.
+
+    Leave `VK_NULL_HANDLE` to not assign the allocation to any scope.
+    Allocations can still be freed individually before the scope is destroyed.
+    */
+    VmaAllocationScope VMA_NULLABLE scope;
+    /** \brief Priority of memory of the allocation, between 0 and 1. Optional.
+
+    Leave 0 to use default priority, 0.5.
+    Used only with #VMA_ALLOCATOR_CREATE_EXT_MEMORY_PRIORITY_BIT, for dedicated allocations,
+    or with #VMA_ALLOCATOR_CREATE_EXT_PAGEABLE_DEVICE_LOCAL_MEMORY_BIT, also to raise priority of the block
+    the allocation is made in. For more information, see \ref enabling_memory_priority.
+    */
+    float priority;
+    /** \brief Quota that size of new allocation will be charged to. Optional.
+
+    Leave `VK_NULL_HANDLE` to not charge the allocation to any quota.
+    */
+    VmaQuota VMA_NULLABLE quota;
+    /** \brief Category of the allocation, used in per-tag statistics. Optional.
+
+    Must be less than #VMA_ALLOCATION_TAG_COUNT. Meaning of the values is up to you.
+    Leave 0 to count the allocation as untagged. See vmaGetAllocationTagStats().
+    */
+    uint32_t tag;
 } VmaAllocationCreateInfo;
 
 /**
@@ -3056,6 +4013,40 @@ typedef struct VmaPoolCreateInfo {
     become lost, set this value to 0.
     */
     uint32_t frameInUseCount;
+    /** \brief Memory allocated by the application, to be imported as the only memory block of this pool. Optional.
+
+    Leave null to let the library allocate memory blocks of this pool.
+
+    If not null, the pool consists of exactly one block of size VmaPoolCreateInfo::blockSize,
+    imported from this pointer using VK_EXT_external_memory_host. `minBlockCount` and `maxBlockCount` are ignored.
+    The pointer and `blockSize` must be multiples of `VkPhysicalDeviceExternalMemoryHostPropertiesEXT::minImportedHostPointerAlignment`.
+    Requires #VMA_ALLOCATOR_CREATE_EXT_EXTERNAL_MEMORY_HOST_BIT.
+    For more information, see [Importing host memory](@ref custom_memory_pools_host_pointer).
+    */
+    void* VMA_NULLABLE pHostPointer;
+    /** \brief Priority of memory blocks of this pool, between 0 and 1. Optional.
+
+    Leave 0 to use default priority, 0.5.
+    Used only with #VMA_ALLOCATOR_CREATE_EXT_MEMORY_PRIORITY_BIT. For more information, see \ref enabling_memory_priority.
+    */
+    float priority;
+#if VMA_EXTERNAL_MEMORY
+    /** \brief Handle types that memory blocks of this pool can be exported to. Optional.
+
+    Leave 0 to allocate regular, non-exportable memory.
+
+    If not 0, `VkExportMemoryAllocateInfoKHR` with these handle types is chained to every `vkAllocateMemory()`
+    called for this pool. Cannot be combined with VmaPoolCreateInfo::pHostPointer.
+    For more information, see [Sharing memory with other processes](@ref custom_memory_pools_export).
+    */
+    VkExternalMemoryHandleTypeFlagsKHR exportHandleTypes;
+#endif
+    /** \brief Quota that memory blocks of this pool will be charged to. Optional.
+
+    Leave `VK_NULL_HANDLE` to not charge this pool to any quota.
+    If not null, creation of a new block fails when it would exceed the limit of the quota or any of its ancestors.
+    */
+    VmaQuota VMA_NULLABLE quota;
 } VmaPoolCreateInfo;
 
 /** \brief Describes parameter of existing #VmaPool.
@@ -3140,6 +4131,56 @@ Possible return values:
 */
 VMA_CALL_PRE VkResult VMA_CALL_POST vmaCheckPoolCorruption(VmaAllocator VMA_NOT_NULL allocator, VmaPool VMA_NOT_NULL pool);
 
+/** \brief Returns marker of current top of the stack in a pool that uses linear algorithm.
+
+@param allocator Allocator object.
+@param pool Pool created with #VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT and VmaPoolCreateInfo::maxBlockCount = 1.
+@param[out] pMarker Marker to be passed to vmaRewindPool().
+
+This is a fast operation that doesn't depend on the number of allocations in the pool.
+
+Returns `VK_ERROR_FEATURE_NOT_PRESENT` if the pool doesn't use linear algorithm,
+can have more than one memory block, or is currently used as a ring buffer.
+For more information, see [Markers and reset](@ref linear_algorithm_markers).
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaGetPoolMarker(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaPool VMA_NOT_NULL pool,
+    VkDeviceSize* VMA_NOT_NULL pMarker);
+
+/** \brief Frees all allocations made in a pool after given marker was obtained, in one operation.
+
+@param allocator Allocator object.
+@param pool Pool created with #VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT and VmaPoolCreateInfo::maxBlockCount = 1.
+@param marker Marker returned by vmaGetPoolMarker() for the same pool.
+
+Frees all allocations from the lower stack that start at or after the place pointed by the marker,
+as if vmaFreeMemory() was called for each of them. Their #VmaAllocation handles become invalid.
+Allocations from the upper stack of a double stack are not affected.
+
+Returns `VK_ERROR_FEATURE_NOT_PRESENT` if the pool doesn't use linear algorithm,
+can have more than one memory block, or is currently used as a ring buffer.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaRewindPool(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaPool VMA_NOT_NULL pool,
+    VkDeviceSize marker);
+
+/** \brief Frees all allocations made in a pool that uses linear algorithm, in one operation.
+
+@param allocator Allocator object.
+@param pool Pool created with #VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT.
+
+All allocations in the pool are freed, as if vmaFreeMemory() was called for each of them.
+Their #VmaAllocation handles become invalid. Memory blocks of the pool are not released,
+so they can be reused by new allocations.
+
+Returns `VK_ERROR_FEATURE_NOT_PRESENT` if the pool doesn't use linear algorithm.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaResetPool(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaPool VMA_NOT_NULL pool);
+
 /** \brief Retrieves name of a custom pool.
 
 After the call `ppName` is either null or points to an internally-owned null-terminated string
@@ -3161,6 +4202,16 @@ VMA_CALL_PRE void VMA_CALL_POST vmaSetPoolName(
     VmaPool VMA_NOT_NULL pool,
     const char* VMA_NULLABLE pName);
 
+/** \brief Selects a custom pool for recording when #VMA_RECORD_SELECTED_POOLS_ONLY_BIT is used.
+
+Affects allocations created from the pool after this call.
+Does nothing if recording is not enabled.
+*/
+VMA_CALL_PRE void VMA_CALL_POST vmaSetPoolRecordingEnabled(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaPool VMA_NOT_NULL pool,
+    VkBool32 enabled);
+
 /** \struct VmaAllocation
 \brief Represents single memory allocation.
 
@@ -3276,6 +4327,10 @@ It may be internally optimized to be more efficient than calling vmaAllocateMemo
 All allocations are made using same parameters. All of them are created out of the same memory pool and type.
 If any allocation fails, all allocations already made within this function call are also freed, so that when
 returned result is not `VK_SUCCESS`, `pAllocation` array is always entirely filled with `VK_NULL_HANDLE`.
+
+By default, each allocation is placed wherever it fits best, so they may be spread across different
+memory blocks or become dedicated allocations. Use #VMA_ALLOCATION_CREATE_PAGES_SAME_BLOCK_BIT or
+#VMA_ALLOCATION_CREATE_PAGES_CONTIGUOUS_BIT to keep them together, e.g. to bind them with fewer `VkSparseMemoryBind` structures.
 */
 VMA_CALL_PRE VkResult VMA_CALL_POST vmaAllocateMemoryPages(
     VmaAllocator VMA_NOT_NULL allocator,
@@ -3285,6 +4340,92 @@ VMA_CALL_PRE VkResult VMA_CALL_POST vmaAllocateMemoryPages(
     VmaAllocation VMA_NULLABLE * VMA_NOT_NULL VMA_LEN_IF_NOT_NULL(allocationCount) pAllocations,
     VmaAllocationInfo* VMA_NULLABLE VMA_LEN_IF_NOT_NULL(allocationCount) pAllocationInfo);
 
+/** \brief Allocates memory for multiple allocations with different requirements at once.
+
+@param allocator Allocator object.
+@param pVkMemoryRequirements Array of memory requirements, one for each allocation.
+@param pCreateInfos Array of creation parameters, one for each allocation.
+@param allocationCount Number of allocations to make.
+@param[out] pAllocations Pointer to array that will be filled with handles to created allocations.
+@param[out] pAllocationInfo Optional. Pointer to array that will be filled with parameters of created allocations.
+
+Each allocation is made as if by vmaAllocateMemory() with its own `pVkMemoryRequirements[i]` and `pCreateInfos[i]`,
+e.g. for all the buffers of a mesh loaded together. Allocations that go to the same memory pool or memory type
+are placed together, from the one with largest alignment and size to the smallest, which packs them better
+than the order they come in. Each pool and memory type is locked only once for all of them.
+
+If any allocation fails, all allocations already made within this function call are also freed, so that when
+returned result is not `VK_SUCCESS`, `pAllocations` array is always entirely filled with `VK_NULL_HANDLE`.
+
+You should free the memory using vmaFreeMemory() or vmaFreeMemoryPages().
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaAllocateMemoryBatch(
+    VmaAllocator VMA_NOT_NULL allocator,
+    const VkMemoryRequirements* VMA_NOT_NULL VMA_LEN_IF_NOT_NULL(allocationCount) pVkMemoryRequirements,
+    const VmaAllocationCreateInfo* VMA_NOT_NULL VMA_LEN_IF_NOT_NULL(allocationCount) pCreateInfos,
+    size_t allocationCount,
+    VmaAllocation VMA_NULLABLE * VMA_NOT_NULL VMA_LEN_IF_NOT_NULL(allocationCount) pAllocations,
+    VmaAllocationInfo* VMA_NULLABLE VMA_LEN_IF_NOT_NULL(allocationCount) pAllocationInfo);
+
+/// Where a single allocation would be made, as returned by vmaCheckAllocationsFit().
+typedef struct VmaAllocationFitPlacement {
+    /** \brief Memory type the allocation would be made in, or `UINT32_MAX` if it wouldn't succeed.
+    */
+    uint32_t memoryTypeIndex;
+    /** \brief `VK_TRUE` if the allocation would need new `VkDeviceMemory` - a new memory block or a dedicated allocation.
+    */
+    VkBool32 newDeviceMemory;
+} VmaAllocationFitPlacement;
+
+/// Summary returned by vmaCheckAllocationsFit().
+typedef struct VmaAllocationFitInfo {
+    /** \brief Number of allocations that would be placed in free space of existing memory blocks.
+    */
+    uint32_t existingBlockAllocationCount;
+    /** \brief Number of new `VkDeviceMemory` objects - memory blocks and dedicated allocations - that would be allocated.
+    */
+    uint32_t newDeviceMemoryCount;
+    /** \brief Total size of new `VkDeviceMemory` objects, in bytes.
+    */
+    VkDeviceSize newDeviceMemoryBytes;
+    /** \brief Budget that would be left in each memory heap.
+
+    It is #VmaBudget::budget minus #VmaBudget::usage and the size of new `VkDeviceMemory` objects in this heap,
+    or 0 if the budget would be exceeded.
+    */
+    VkDeviceSize budgetLeft[VK_MAX_MEMORY_HEAPS];
+} VmaAllocationFitInfo;
+
+/** \brief Checks whether allocations with given parameters could be made right now, without making them.
+
+@param allocator Allocator object.
+@param pVkMemoryRequirements Array of memory requirements, one for each allocation.
+@param pCreateInfos Array of creation parameters, one for each allocation.
+@param allocationCount Number of allocations to check.
+@param[out] pPlacements Optional. Array that will be filled with placement of each allocation.
+@param[out] pFitInfo Optional. Summary of all the allocations.
+@return `VK_SUCCESS` if all the allocations would succeed, `VK_ERROR_OUT_OF_DEVICE_MEMORY` if some of them wouldn't,
+    `VK_ERROR_FEATURE_NOT_PRESENT` if no memory type meets requirements of some of them.
+
+Allocations are checked together, in order, as if they were made one after another with vmaAllocateMemory(),
+so later ones don't get free space already taken by earlier ones. Nothing is changed in the allocator
+and memory pools are only locked for reading, so the function is much cheaper than allocating and freeing.
+
+The result is an estimate. It may be pessimistic, as free space is not searched as thoroughly as
+by actual allocations, and new memory blocks are assumed to have the preferred block size.
+Limits of VmaAllocationCreateInfo::quota and VmaPoolCreateInfo::quota are respected, counting
+sizes that earlier allocations of the same call would charge to them.
+It may also become outdated when other threads allocate or free memory.
+Making other allocations lost is not taken into account.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaCheckAllocationsFit(
+    VmaAllocator VMA_NOT_NULL allocator,
+    const VkMemoryRequirements* VMA_NOT_NULL VMA_LEN_IF_NOT_NULL(allocationCount) pVkMemoryRequirements,
+    const VmaAllocationCreateInfo* VMA_NOT_NULL VMA_LEN_IF_NOT_NULL(allocationCount) pCreateInfos,
+    size_t allocationCount,
+    VmaAllocationFitPlacement* VMA_NULLABLE VMA_LEN_IF_NOT_NULL(allocationCount) pPlacements,
+    VmaAllocationFitInfo* VMA_NULLABLE pFitInfo);
+
 /**
 @param[out] pAllocation Handle to allocated memory.
 @param[out] pAllocationInfo Optional. Information about allocated memory. It can be later fetched using function vmaGetAllocationInfo().
@@ -3329,18 +4470,248 @@ VMA_CALL_PRE void VMA_CALL_POST vmaFreeMemoryPages(
     size_t allocationCount,
     const VmaAllocation VMA_NULLABLE * VMA_NOT_NULL VMA_LEN_IF_NOT_NULL(allocationCount) pAllocations);
 
-/** \brief Deprecated.
+/** \brief Creates new allocation scope.
+
+\param allocator
+\param[out] pScope Handle to created scope.
+
+Pass it as VmaAllocationCreateInfo::scope to make new allocations belong to it.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaCreateAllocationScope(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaAllocationScope VMA_NULLABLE * VMA_NOT_NULL pScope);
+
+/** \brief Frees all allocations still belonging to the scope and destroys the scope.
+
+The allocations are freed in a single pass: they are grouped by memory pool and memory block,
+each pool is locked once and free space of each block is updated once.
+Allocations made with this scope must not be used after this call, just like after vmaFreeMemory().
+Allocations already freed individually are not affected.
+
+Passing `VK_NULL_HANDLE` as `scope` is valid. Such function call is just skipped.
+*/
+VMA_CALL_PRE void VMA_CALL_POST vmaDestroyAllocationScope(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaAllocationScope VMA_NULLABLE scope);
+
+/// Describes parameter of created #VmaQuota.
+typedef struct VmaQuotaCreateInfo
+{
+    /** \brief Quota that this one is part of. Optional.
+
+    Everything charged to the new quota is also charged to the parent and its ancestors.
+    */
+    VmaQuota VMA_NULLABLE parent;
+    /** \brief Maximum number of bytes that can be charged to this quota.
+
+    Set to `VK_WHOLE_SIZE` to only track usage without any limit.
+    */
+    VkDeviceSize limit;
+    /// Name of the quota, for debugging purposes. Optional. The string is copied.
+    const char* VMA_NULLABLE pName;
+} VmaQuotaCreateInfo;
+
+/// Describes current state of a #VmaQuota.
+typedef struct VmaQuotaStats
+{
+    /// Limit of the quota, as specified in VmaQuotaCreateInfo::limit.
+    VkDeviceSize limit;
+    /// Number of bytes currently charged to the quota, including its child quotas.
+    VkDeviceSize usage;
+    /// Maximum value of `usage` since the quota was created.
+    VkDeviceSize peakUsage;
+    /// Number of allocations and blocks refused because this quota would go over its limit.
+    uint32_t overLimitCount;
+} VmaQuotaStats;
+
+/** \brief Creates new quota.
+
+\param allocator
+\param pCreateInfo Parameters of the quota.
+\param[out] pQuota Handle to created quota.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaCreateQuota(
+    VmaAllocator VMA_NOT_NULL allocator,
+    const VmaQuotaCreateInfo* VMA_NOT_NULL pCreateInfo,
+    VmaQuota VMA_NULLABLE * VMA_NOT_NULL pQuota);
+
+/** \brief Destroys quota.
+
+All child quotas, pools and allocations charged to the quota must be destroyed before.
+Passing `VK_NULL_HANDLE` as `quota` is valid. Such function call is just skipped.
+*/
+VMA_CALL_PRE void VMA_CALL_POST vmaDestroyQuota(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaQuota VMA_NULLABLE quota);
+
+/** \brief Retrieves current usage, peak usage and number of refused requests of a quota.
+
+This function doesn't take any lock, so it can be called frequently.
+*/
+VMA_CALL_PRE void VMA_CALL_POST vmaGetQuotaStats(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaQuota VMA_NOT_NULL quota,
+    VmaQuotaStats* VMA_NOT_NULL pQuotaStats);
+
+/** \brief Tries to change allocation's size without moving or reallocating it.
+
+You can both shrink and grow allocation size.
+When growing, it succeeds only when the allocation is followed by enough free space
+inside its memory block - its offset never changes.
+Shrinking always succeeds for allocations made from memory blocks.
+
+Returns `VK_SUCCESS` if allocation's size has been successfully changed.
+Returns `VK_ERROR_OUT_OF_POOL_MEMORY` if allocation's size could not be changed,
+e.g. when it is a dedicated allocation or there is not enough free space after it.
+
+After successful call to this function, VmaAllocationInfo::size of this allocation changes.
+All other parameters stay the same: memory pool and type, alignment, offset, mapped pointer.
 
-\deprecated
-In version 2.2.0 it used to try to change allocation's size without moving or reallocating it.
-In current version it returns `VK_SUCCESS` only if `newSize` equals current allocation's size.
-Otherwise returns `VK_ERROR_OUT_OF_POOL_MEMORY`, indicating that allocation's size could not be changed.
+- Calling this function on allocation that is in lost state fails with result `VK_ERROR_VALIDATION_FAILED_EXT`.
+- Calling this function with `newSize` same as current allocation size does nothing and returns `VK_SUCCESS`.
+- Resizing dedicated allocations is not supported - it always returns `VK_ERROR_OUT_OF_POOL_MEMORY`,
+  as they occupy whole `VkDeviceMemory` blocks. Use vmaReallocateMemory() for them.
+- Resizing allocations created in pools that use linear or buddy algorithm is supported only in limited cases:
+  an allocation from a linear pool can grow only if it is the last one in its stack,
+  an allocation from a buddy pool only within its power-of-two node.
+
+Note that a buffer or image bound to this allocation is not resized - its size is fixed at creation.
+To use the new size, create a new resource and bind it to the same allocation.
 */
 VMA_CALL_PRE VkResult VMA_CALL_POST vmaResizeAllocation(
     VmaAllocator VMA_NOT_NULL allocator,
     VmaAllocation VMA_NOT_NULL allocation,
     VkDeviceSize newSize);
 
+/// Result of vmaReallocateMemory().
+typedef struct VmaReallocationInfo
+{
+    /** \brief Allocation to be used from now on.
+
+    Equal to the original allocation if it was resized in place.
+    */
+    VmaAllocation VMA_NOT_NULL allocation;
+    /** \brief `VK_TRUE` if `allocation` is a new allocation, different from the original one.
+    */
+    VkBool32 moved;
+    /** \brief `VK_TRUE` if contents of the original allocation have not been copied to the new one.
+
+    It happens when the allocation has been moved and any of the two allocations is not `HOST_VISIBLE`
+    or can become lost. In that case the original allocation is left alive: you need to copy
+    `copySize` bytes to the new allocation yourself, e.g. using `vkCmdCopyBuffer()`,
+    and then free the original allocation using vmaFreeMemory() once the copy has completed.
+    */
+    VkBool32 copyPending;
+    /** \brief Number of bytes of data that have been or need to be copied from the original allocation.
+
+    Equal to the minimum of the original size and `newSize`. Zero when the allocation has not been moved.
+    */
+    VkDeviceSize copySize;
+} VmaReallocationInfo;
+
+/** \brief Changes allocation's size, moving it to a new place in memory if it cannot be resized in place.
+
+First tries the same as vmaResizeAllocation(). If that fails, makes a new allocation of size `newSize`
+and, if both allocations are `HOST_VISIBLE`, copies contents of the old one using mapping and frees the old one.
+Otherwise the copy is left to you - see VmaReallocationInfo::copyPending.
+
+\param allocator
+\param allocation Allocation to resize. After it was moved and `copyPending` is not set, it is freed and must not be used anymore.
+\param newSize New size in bytes.
+\param pCreateInfo Optional. Parameters of the new allocation, if it needs to be made. If null, the new allocation
+    is made in the same custom pool or memory type as the original one, with the same
+    `VMA_ALLOCATION_CREATE_MAPPED_BIT` and `VMA_ALLOCATION_CREATE_CAN_BECOME_LOST_BIT` flags, user data,
+    tag and lifetime hint.
+\param[out] pReallocationInfo Information about the result.
+
+Alignment and suballocation type of the original allocation are preserved.
+As with moving allocations during defragmentation, buffers and images bound to the original allocation
+must be recreated and bound to the new one.
+
+If the function fails, the original allocation is left unchanged.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaReallocateMemory(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaAllocation VMA_NOT_NULL allocation,
+    VkDeviceSize newSize,
+    const VmaAllocationCreateInfo* VMA_NULLABLE pCreateInfo,
+    VmaReallocationInfo* VMA_NOT_NULL pReallocationInfo);
+
+/** \brief Parameters of vmaBalanceBarMemory().
+*/
+typedef struct VmaBarBalanceInfo
+{
+    /// Number of elements in `pAllocations` and `pHostAccessCounts` arrays.
+    uint32_t allocationCount;
+    /** \brief Allocations of dynamic resources that compete for memory that is both `DEVICE_LOCAL` and `HOST_VISIBLE`.
+
+    Allocations made from custom pools and lost allocations are ignored.
+    */
+    const VmaAllocation VMA_NOT_NULL * VMA_NULLABLE VMA_LEN_IF_NOT_NULL(allocationCount) pAllocations;
+    /** \brief Optional. Number of CPU writes to each allocation since previous call, as measured by you.
+
+    Leave null to use number of calls to vmaMapMemory(), vmaFlushAllocation() and vmaFlushAllocations()
+    made for each allocation since previous call to vmaBalanceBarMemory() that used them, counted by the library.
+    Counting starts from zero again only for the allocations whose counts have been used this way.
+    */
+    const uint32_t* VMA_NULLABLE VMA_LEN_IF_NOT_NULL(allocationCount) pHostAccessCounts;
+    /** \brief Bit mask of memory types that can be used for these resources, e.g. `VkMemoryRequirements::memoryTypeBits` of the buffers.
+    */
+    uint32_t memoryTypeBits;
+    /** \brief Maximum number of bytes of `DEVICE_LOCAL` + `HOST_VISIBLE` memory that these allocations can occupy together.
+
+    0 means no limit other than budget of the memory heap.
+    */
+    VkDeviceSize maxBarBytes;
+} VmaBarBalanceInfo;
+
+/// Single move returned by vmaBalanceBarMemory().
+typedef struct VmaBarMove
+{
+    /// Original allocation. Copy its contents to `dstAllocation` and then free it.
+    VmaAllocation VMA_NOT_NULL srcAllocation;
+    /// New allocation of the same size, made in the other kind of memory.
+    VmaAllocation VMA_NOT_NULL dstAllocation;
+    /** \brief `VK_TRUE` if `dstAllocation` is in `DEVICE_LOCAL` + `HOST_VISIBLE` memory, `VK_FALSE` if it has been moved out of it.
+
+    Promoted allocations are persistently mapped.
+    */
+    VkBool32 promoted;
+} VmaBarMove;
+
+/** \brief Moves most frequently written allocations to memory that is both `DEVICE_LOCAL` and `HOST_VISIBLE`, and rarely written ones out of it.
+
+@param allocator
+@param pInfo Allocations to consider and limits.
+@param[inout] pMoveCount Input: Number of elements in `pMoves` array. Output: Number of moves written to it.
+@param[out] pMoves Array of moves to perform.
+
+Such memory, also known as BAR, is often limited to 256 MiB. Allocations are ranked by number of CPU writes
+since previous call. The most frequently written ones that fit within the budget of the heap and
+VmaBarBalanceInfo::maxBarBytes are made to live in this memory. Allocations not written at all are never promoted.
+Allocations that already live there are moved out only when their place is needed by hotter ones.
+
+For each move, a new allocation is made, but no data is copied and nothing is freed. You need to copy
+the contents of each `srcAllocation` to `dstAllocation` on the GPU, e.g. using `vkCmdCopyBuffer()`,
+bind your resource to the new allocation and free the old one after the copy has completed.
+Memory released by moved-out allocations can be used for promotions only in a next call, after you freed them.
+
+It returns:
+
+- `VK_SUCCESS` - all allocations are where they should be, after performing returned moves.
+- `VK_INCOMPLETE` - more moves would be needed, but `*pMoveCount` limit was reached or some new
+  allocations could not be made yet. Call it again later.
+- `VK_ERROR_FEATURE_NOT_PRESENT` - `memoryTypeBits` doesn't include both a `DEVICE_LOCAL` + `HOST_VISIBLE`
+  memory type and a `DEVICE_LOCAL` memory type that is not `HOST_VISIBLE`, e.g. on integrated graphics.
+
+For more information see [Sharing DEVICE_LOCAL + HOST_VISIBLE memory](@ref usage_patterns_bar_balancing).
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaBalanceBarMemory(
+    VmaAllocator VMA_NOT_NULL allocator,
+    const VmaBarBalanceInfo* VMA_NOT_NULL pInfo,
+    uint32_t* VMA_NOT_NULL pMoveCount,
+    VmaBarMove* VMA_NULLABLE VMA_LEN_IF_NOT_NULL(*pMoveCount) pMoves);
+
 /** \brief Returns current information about specified allocation and atomically marks it as used in current frame.
 
 Current paramteres of given allocation are returned in `pAllocationInfo`.
@@ -3380,6 +4751,75 @@ VMA_CALL_PRE VkBool32 VMA_CALL_POST vmaTouchAllocation(
     VmaAllocator VMA_NOT_NULL allocator,
     VmaAllocation VMA_NOT_NULL allocation);
 
+/** \brief Finds allocation that occupies given byte of given `VkDeviceMemory`.
+
+\param allocator
+\param memory Memory block, e.g. reported by a validation error or device fault information.
+\param offset Offset in bytes from the beginning of `memory`.
+\param[out] pAllocation Found allocation, or null.
+
+Returns `VK_SUCCESS` if the allocation was found. Returns `VK_ERROR_FEATURE_NOT_PRESENT` if `memory`
+was not allocated by this allocator or `offset` falls into free space, alignment padding or debug margin.
+
+The cost is O(blocks + suballocations). There is no index from `VkDeviceMemory` to blocks:
+memory blocks of all default and custom pools, then dedicated allocations, are compared one by one.
+The suballocations of the found block are then walked in order of offset. Pools are locked for reading
+while searched, so the function is meant for diagnostics, e.g. to name the resource after a GPU crash,
+not to be called every frame.
+
+Memory owned by #VmaSparseBuffer and #VmaSparsePagePool objects is not searched, as it is not
+made of #VmaAllocation objects - the function returns `VK_ERROR_FEATURE_NOT_PRESENT` for it.
+There is also no lookup by `VkDeviceAddress`. To find the allocation of a faulting device address,
+translate it to the buffer containing it and use vmaGetAllocationInfo() of that buffer's allocation.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaFindAllocationByMemory(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VkDeviceMemory VMA_NOT_NULL_NON_DISPATCHABLE memory,
+    VkDeviceSize offset,
+    VmaAllocation VMA_NULLABLE * VMA_NOT_NULL pAllocation);
+
+#if VMA_EXTERNAL_MEMORY
+
+/** \brief Parameters of an allocation needed to import it in another process.
+
+Returned by vmaGetAllocationExportInfo().
+*/
+typedef struct VmaAllocationExportInfo {
+    /** \brief Memory block containing the allocation. Export its handle to share the allocation.
+    */
+    VkDeviceMemory VMA_NOT_NULL_NON_DISPATCHABLE deviceMemory;
+    /** \brief Size of whole `deviceMemory` block, in bytes. Use it as `allocationSize` when importing.
+    */
+    VkDeviceSize blockSize;
+    /** \brief Offset of the allocation in `deviceMemory`, in bytes.
+    */
+    VkDeviceSize offset;
+    /** \brief Size of the allocation, in bytes.
+    */
+    VkDeviceSize size;
+    /** \brief Memory type index of `deviceMemory`.
+    */
+    uint32_t memoryTypeIndex;
+    /** \brief Handle types `deviceMemory` was allocated with, equal to VmaPoolCreateInfo::exportHandleTypes of its pool.
+    */
+    VkExternalMemoryHandleTypeFlagsKHR handleTypes;
+} VmaAllocationExportInfo;
+
+/** \brief Returns parameters needed to share given allocation with another process.
+
+The allocation must come from a custom pool created with non-zero VmaPoolCreateInfo::exportHandleTypes.
+Otherwise, or if it was created with #VMA_ALLOCATION_CREATE_CAN_BECOME_LOST_BIT, returns `VK_ERROR_FEATURE_NOT_PRESENT`.
+The returned values don't change as long as the allocation is not defragmented.
+
+For more information, see [Sharing memory with other processes](@ref custom_memory_pools_export).
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaGetAllocationExportInfo(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaAllocation VMA_NOT_NULL allocation,
+    VmaAllocationExportInfo* VMA_NOT_NULL pExportInfo);
+
+#endif // #if VMA_EXTERNAL_MEMORY
+
 /** \brief Sets pUserData in given allocation to new value.
 
 If the allocation was created with VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT,
@@ -3581,6 +5021,53 @@ Possible return values:
 */
 VMA_CALL_PRE VkResult VMA_CALL_POST vmaCheckCorruption(VmaAllocator VMA_NOT_NULL allocator, uint32_t memoryTypeBits);
 
+/** \brief Range of device memory that should be filled with zeros, returned by vmaZeroFreeMemory().
+*/
+typedef struct VmaZeroFillRange
+{
+    /// Memory block that contains the range.
+    VkDeviceMemory VMA_NOT_NULL_NON_DISPATCHABLE memory;
+    /// Offset of the range in the memory block, in bytes. Always multiply of 4.
+    VkDeviceSize offset;
+    /// Size of the range, in bytes. Always multiply of 4.
+    VkDeviceSize size;
+} VmaZeroFillRange;
+
+/** \brief Clears free memory in advance, so it can be quickly returned by allocations with #VMA_ALLOCATION_CREATE_ZEROED_BIT.
+
+@param allocator
+@param pool Custom pool to process. Pass null to process default pools.
+@param maxBytes Maximum number of bytes to clear in this call. Pass `VK_WHOLE_SIZE` for no limit.
+@param[inout] pRangeCount Input: Number of elements in `pRanges` array. Output: Number of ranges written to it.
+@param[out] pRanges Optional. Array of ranges of memory that is not `HOST_VISIBLE`, which you need to fill with zeros.
+
+Free ranges in `HOST_VISIBLE` memory types are cleared immediately using `memset` and flushed
+when needed. Free ranges in other memory types cannot be accessed by the CPU, so they are
+returned in `pRanges` instead. You should fill them with zeros yourself, e.g. with `vkCmdFillBuffer`
+on a buffer bound to `VmaZeroFillRange::memory` that covers whole memory block.
+
+All returned ranges are marked as zeroed immediately. Command buffer that clears them must
+be submitted and executed before any work that uses allocations made after this call.
+
+Free ranges that are already known to contain zeros are not cleared again. Only default
+pools and custom pools that use default algorithm are processed.
+
+This function can be called many times with limited `maxBytes`, e.g. once per frame, to spread
+the work over time. It returns:
+
+- `VK_SUCCESS` - all free ranges are now zeroed.
+- `VK_INCOMPLETE` - some free ranges are not zeroed yet because of `maxBytes` or `*pRangeCount` limit.
+  Call it again to continue. When `pRanges` is null, this is also returned as long as memory
+  that is not `HOST_VISIBLE` has free ranges to clear, while all `HOST_VISIBLE` memory types are still processed.
+- Other value: Error returned by Vulkan, e.g. memory mapping failure.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaZeroFreeMemory(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaPool VMA_NULLABLE pool,
+    VkDeviceSize maxBytes,
+    uint32_t* VMA_NOT_NULL pRangeCount,
+    VmaZeroFillRange* VMA_NULLABLE VMA_LEN_IF_NOT_NULL(*pRangeCount) pRanges);
+
 /** \struct VmaDefragmentationContext
 \brief Represents Opaque object that represents started defragmentation process.
 
@@ -3965,51 +5452,512 @@ VMA_CALL_PRE void VMA_CALL_POST vmaDestroyImage(
     VkImage VMA_NULLABLE_NON_DISPATCHABLE image,
     VmaAllocation VMA_NULLABLE allocation);
 
-#ifdef __cplusplus
-}
-#endif
+/** \brief Frees memory when the GPU reaches given completion value.
 
-#endif // AMD_VULKAN_MEMORY_ALLOCATOR_H
+The allocation is queued and freed by the first call to vmaProcessDeferredDestructions()
+with `completedValue >= completionValue`. Until then it remains valid and must not be freed in any other way.
+If the allocation belongs to a #VmaAllocationScope, it is removed from the scope immediately.
 
-// For Visual Studio IntelliSense.
-#if defined(__cplusplus) && defined(__INTELLISENSE__)
-#define VMA_IMPLEMENTATION
-#endif
+Passing `VK_NULL_HANDLE` as `allocation` is valid. Such function call is just skipped.
 
-#ifdef VMA_IMPLEMENTATION
-#undef VMA_IMPLEMENTATION
+For more information see [Deferred destruction](@ref deferred_destruction).
+*/
+VMA_CALL_PRE void VMA_CALL_POST vmaFreeMemoryDeferred(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaAllocation VMA_NULLABLE allocation,
+    uint64_t completionValue);
 
-#include <cstdint>
-#include <cstdlib>
-#include <cstring>
-#include <utility>
+/** \brief Destroys Vulkan buffer and frees allocated memory when the GPU reaches given completion value.
 
-#if VMA_RECORDING_ENABLED
-    #include <chrono>
-    #if defined(_WIN32)
-        #include <windows.h>
-    #else
-        #include <sstream>
-        #include <thread>
-    #endif
-#endif
+Deferred equivalent of vmaDestroyBuffer(). See vmaFreeMemoryDeferred().
+It it safe to pass null as buffer and/or allocation.
+*/
+VMA_CALL_PRE void VMA_CALL_POST vmaDestroyBufferDeferred(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VkBuffer VMA_NULLABLE_NON_DISPATCHABLE buffer,
+    VmaAllocation VMA_NULLABLE allocation,
+    uint64_t completionValue);
 
-/*******************************************************************************
-CONFIGURATION SECTION
+/** \brief Destroys Vulkan image and frees allocated memory when the GPU reaches given completion value.
 
-Define some of these macros before each #include of this header or change them
-here if you need other then default behavior depending on your environment.
+Deferred equivalent of vmaDestroyImage(). See vmaFreeMemoryDeferred().
+It it safe to pass null as image and/or allocation.
 */
+VMA_CALL_PRE void VMA_CALL_POST vmaDestroyImageDeferred(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VkImage VMA_NULLABLE_NON_DISPATCHABLE image,
+    VmaAllocation VMA_NULLABLE allocation,
+    uint64_t completionValue);
 
-/*
-Define this macro to 1 to make the library fetch pointers to Vulkan functions
-internally, like:
+/** \brief Destroys all queued buffers, images and allocations whose completion value is not greater than `completedValue`.
 
-    vulkanFunctions.vkAllocateMemory = &vkAllocateMemory;
-*/
-#if !defined(VMA_STATIC_VULKAN_FUNCTIONS) && !defined(VK_NO_PROTOTYPES)
-    #define VMA_STATIC_VULKAN_FUNCTIONS 1
-#endif
+\param allocator
+\param completedValue Latest value reached by the GPU, e.g. current value of a timeline semaphore.
+\param[out] pDestroyedCount Optional. Number of processed entries of the queue.
+
+Allocations are freed in a single pass, grouped by memory pool and memory block.
+*/
+VMA_CALL_PRE void VMA_CALL_POST vmaProcessDeferredDestructions(
+    VmaAllocator VMA_NOT_NULL allocator,
+    uint64_t completedValue,
+    size_t* VMA_NULLABLE pDestroyedCount);
+
+/** \struct VmaReadbackHeap
+\brief Represents persistently mapped buffer for data written by the GPU and read back on the CPU.
+
+The buffer is divided into slices, one for each frame in flight. Call function vmaCreateReadbackHeap() to create it
+and vmaAllocateReadbackRegion() to get a region of it for the current frame.
+
+For more information see [Readback](@ref usage_patterns_readback).
+*/
+VK_DEFINE_HANDLE(VmaReadbackHeap)
+
+/// Describes parameters of created #VmaReadbackHeap.
+typedef struct VmaReadbackHeapCreateInfo {
+    /** \brief Number of bytes that can be read back in a single frame.
+
+    Rounded up to `VkPhysicalDeviceLimits::nonCoherentAtomSize`.
+    */
+    VkDeviceSize frameSize;
+    /** \brief Maximum number of previous frames whose data can still be written by the GPU or read by the CPU.
+
+    Typically the number of frames in flight. Total size of the heap is `frameSize * (frameInUseCount + 1)`.
+    Regions allocated in frame `N` stay valid until frame `N + frameInUseCount + 1` reuses their slice.
+    */
+    uint32_t frameInUseCount;
+    /** \brief Additional usage flags of the buffer. Optional.
+
+    `VK_BUFFER_USAGE_TRANSFER_DST_BIT` is always added. Add e.g. `VK_BUFFER_USAGE_STORAGE_BUFFER_BIT`
+    if shaders write to the heap directly.
+    */
+    VkBufferUsageFlags bufferUsage;
+    /** \brief Bitmask containing one bit set for every memory type acceptable for the heap. Optional.
+
+    Value 0 is equivalent to `UINT32_MAX`. Among acceptable types, `HOST_CACHED` ones are preferred.
+    */
+    uint32_t memoryTypeBits;
+} VmaReadbackHeapCreateInfo;
+
+/// Region of #VmaReadbackHeap returned by vmaAllocateReadbackRegion().
+typedef struct VmaReadbackRegion {
+    /// Buffer of the heap. Use it as destination of copy commands, e.g. `vkCmdCopyQueryPoolResults()`.
+    VkBuffer VMA_NOT_NULL_NON_DISPATCHABLE buffer;
+    /// Offset of the region in `buffer`, in bytes.
+    VkDeviceSize offset;
+    /// Size of the region, in bytes.
+    VkDeviceSize size;
+    /** \brief Pointer to the beginning of the region in mapped memory.
+
+    Read from it only after the GPU has finished writing and vmaInvalidateReadbackHeaps() was called for the frame of the region.
+    */
+    void* VMA_NOT_NULL pMappedData;
+} VmaReadbackRegion;
+
+/** \brief Creates buffer in `HOST_VISIBLE` memory, persistently mapped and divided into per-frame slices.
+
+\param allocator
+\param pCreateInfo Parameters of the heap.
+\param[out] pHeap Handle to created heap.
+\param[out] pAllocationInfo Optional. Information about the allocation of the heap buffer.
+
+Memory type is chosen like for #VMA_MEMORY_USAGE_GPU_TO_CPU, so `HOST_CACHED` memory is used if available.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaCreateReadbackHeap(
+    VmaAllocator VMA_NOT_NULL allocator,
+    const VmaReadbackHeapCreateInfo* VMA_NOT_NULL pCreateInfo,
+    VmaReadbackHeap VMA_NULLABLE * VMA_NOT_NULL pHeap,
+    VmaAllocationInfo* VMA_NULLABLE pAllocationInfo);
+
+/** \brief Destroys the heap together with its buffer and memory.
+
+The GPU must no longer write to any region of the heap.
+Passing `VK_NULL_HANDLE` as `heap` is valid. Such function call is just skipped.
+*/
+VMA_CALL_PRE void VMA_CALL_POST vmaDestroyReadbackHeap(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaReadbackHeap VMA_NULLABLE heap);
+
+/** \brief Allocates region of the heap for the current frame.
+
+\param allocator
+\param heap
+\param size Size of the region in bytes. Must be greater than 0.
+\param alignment Required alignment of VmaReadbackRegion::offset. Must be a power of two.
+\param[out] pRegion Allocated region.
+
+Regions are allocated linearly from the slice that belongs to the frame index set by vmaSetCurrentFrameIndex().
+They don't need to be freed. Whole slice is reused when the same slice is needed again, `frameInUseCount + 1` frames later.
+
+\return `VK_ERROR_OUT_OF_DEVICE_MEMORY` if there is not enough space left in the slice of the current frame.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaAllocateReadbackRegion(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaReadbackHeap VMA_NOT_NULL heap,
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    VmaReadbackRegion* VMA_NOT_NULL pRegion);
+
+/** \brief Invalidates all regions allocated in given frame from given heaps, using a single call to `vkInvalidateMappedMemoryRanges()`.
+
+\param allocator
+\param heapCount Number of elements in `pHeaps` array.
+\param pHeaps Heaps to invalidate.
+\param frameIndex Frame in which the regions were allocated.
+
+Call it once per frame, after waiting for the GPU to finish frame `frameIndex` and before reading its regions.
+All regions of a heap allocated in one frame are merged into a single memory range.
+Heaps that have no regions for this frame, or whose slice has already been reused, are skipped,
+as are heaps in `HOST_COHERENT` memory.
+
+Passing `VK_NULL_HANDLE` as elements of `pHeaps` array is valid. Such entries are just skipped.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaInvalidateReadbackHeaps(
+    VmaAllocator VMA_NOT_NULL allocator,
+    uint32_t heapCount,
+    const VmaReadbackHeap VMA_NULLABLE * VMA_NOT_NULL VMA_LEN_IF_NOT_NULL(heapCount) pHeaps,
+    uint32_t frameIndex);
+
+/** \struct VmaSparseBuffer
+\brief Represents large sparse buffer whose memory pages are allocated on demand.
+
+Call function vmaCreateSparseBuffer() to create it and vmaSparseBufferAllocate() to reserve a range of it.
+
+For more information see [Sparse buffers](@ref sparse_buffers).
+*/
+VK_DEFINE_HANDLE(VmaSparseBuffer)
+
+/// Describes parameters of created #VmaSparseBuffer.
+typedef struct VmaSparseBufferCreateInfo {
+    /** \brief Size of the buffer, in bytes.
+
+    This is the whole address range reserved up front. It is rounded up to a multiple of `pageSize`.
+    No memory is allocated for it until ranges are allocated with vmaSparseBufferAllocate().
+    */
+    VkDeviceSize size;
+    /** \brief Size of a single page of memory allocated on demand, in bytes. Optional.
+
+    Every page that has memory is a separate `VkDeviceMemory` block, counted towards
+    `VkPhysicalDeviceLimits::maxMemoryAllocationCount` together with all other allocations,
+    so the number of such pages, `committedPageCount` in #VmaSparseBufferInfo, must stay well below that limit.
+    Too small pages exceed it quickly, and they also make vmaSubmitSparseBinds() slower, as it walks all pages of the buffer.
+    Leave 0 to use default size of 2 MiB. Rounded up to sparse block size of the buffer.
+    */
+    VkDeviceSize pageSize;
+    /// Usage flags of the buffer.
+    VkBufferUsageFlags bufferUsage;
+    /** \brief Bitmask containing one bit set for every memory type acceptable for the pages. Optional.
+
+    Value 0 is equivalent to `UINT32_MAX`. Among acceptable types, `DEVICE_LOCAL` ones are preferred.
+    */
+    uint32_t memoryTypeBits;
+    /** \brief Number of frames the GPU may still use memory of a page after it has been unbound.
+
+    Such memory is reused for other pages or freed by vmaSubmitSparseBinds()
+    `frameInUseCount` frames after it was unbound.
+    */
+    uint32_t frameInUseCount;
+} VmaSparseBufferCreateInfo;
+
+/// Parameters of #VmaSparseBuffer returned by vmaGetSparseBufferInfo().
+typedef struct VmaSparseBufferInfo {
+    /// The sparse buffer.
+    VkBuffer VMA_NOT_NULL_NON_DISPATCHABLE buffer;
+    /// Size of the buffer, in bytes.
+    VkDeviceSize size;
+    /// Size of a single page, in bytes.
+    VkDeviceSize pageSize;
+    /// Memory type index of all pages.
+    uint32_t memoryTypeIndex;
+    /// Number of pages that have memory assigned, including those not bound yet.
+    uint32_t committedPageCount;
+    /// Number of pages that will be bound or unbound by the next call to vmaSubmitSparseBinds().
+    uint32_t pendingBindCount;
+    /// Total size of ranges allocated with vmaSparseBufferAllocate(), in bytes.
+    VkDeviceSize allocatedSize;
+    /// Total size of `VkDeviceMemory` blocks owned by the buffer, including those kept for reuse, in bytes.
+    VkDeviceSize memorySize;
+} VmaSparseBufferInfo;
+
+/// Parameters of the queue submission made by vmaSubmitSparseBinds().
+typedef struct VmaSparseBindSubmitInfo {
+    /// Queue that supports `VK_QUEUE_SPARSE_BINDING_BIT`.
+    VkQueue VMA_NOT_NULL queue;
+    /// Number of elements in `pWaitSemaphores` array.
+    uint32_t waitSemaphoreCount;
+    /// Semaphores to wait for before binding.
+    const VkSemaphore VMA_NOT_NULL_NON_DISPATCHABLE * VMA_NULLABLE VMA_LEN_IF_NOT_NULL(waitSemaphoreCount) pWaitSemaphores;
+    /// Number of elements in `pSignalSemaphores` array.
+    uint32_t signalSemaphoreCount;
+    /// Semaphores to signal when binding is complete.
+    const VkSemaphore VMA_NOT_NULL_NON_DISPATCHABLE * VMA_NULLABLE VMA_LEN_IF_NOT_NULL(signalSemaphoreCount) pSignalSemaphores;
+    /// Optional. Fence to signal when binding is complete.
+    VkFence VMA_NULLABLE_NON_DISPATCHABLE fence;
+} VmaSparseBindSubmitInfo;
+
+/** \brief Creates sparse buffer whose memory pages are allocated on demand.
+
+\param allocator
+\param pCreateInfo Parameters of the buffer.
+\param[out] pSparseBuffer Handle to created sparse buffer.
+\param[out] pSparseBufferInfo Optional. Parameters of created buffer, e.g. its `VkBuffer`.
+
+No memory is allocated by this function.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaCreateSparseBuffer(
+    VmaAllocator VMA_NOT_NULL allocator,
+    const VmaSparseBufferCreateInfo* VMA_NOT_NULL pCreateInfo,
+    VmaSparseBuffer VMA_NULLABLE * VMA_NOT_NULL pSparseBuffer,
+    VmaSparseBufferInfo* VMA_NULLABLE pSparseBufferInfo);
+
+/** \brief Destroys the sparse buffer and frees all its memory.
+
+The GPU must no longer use the buffer. Unlike other memory of the buffer, memory of pages
+unbound by vmaSubmitSparseBinds() is freed immediately, so make sure the last binding operation has completed.
+Passing `VK_NULL_HANDLE` as `sparseBuffer` is valid. Such function call is just skipped.
+*/
+VMA_CALL_PRE void VMA_CALL_POST vmaDestroySparseBuffer(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaSparseBuffer VMA_NULLABLE sparseBuffer);
+
+/** \brief Returns current parameters of the sparse buffer.
+*/
+VMA_CALL_PRE void VMA_CALL_POST vmaGetSparseBufferInfo(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaSparseBuffer VMA_NOT_NULL sparseBuffer,
+    VmaSparseBufferInfo* VMA_NOT_NULL pSparseBufferInfo);
+
+/** \brief Allocates range of the sparse buffer, allocating memory for its pages when needed.
+
+\param allocator
+\param sparseBuffer
+\param size Size of the range in bytes. Must be greater than 0.
+\param alignment Required alignment of the offset. Must be a power of two.
+\param[out] pOffset Offset of the range in the buffer.
+
+The range is placed at the lowest suitable offset. Pages it touches that had no memory
+are bound by the next call to vmaSubmitSparseBinds(), so don't let the GPU access the range before that.
+
+Finding the offset is a first-fit scan over ranges already allocated in the buffer, so its cost
+grows linearly with their number. The buffer is meant for a moderate number of large ranges
+(e.g. per-frame or per-object data) - for many small allocations, suballocate them yourself
+from bigger ranges.
+
+\return `VK_ERROR_OUT_OF_POOL_MEMORY` if there is no free range of this size in the buffer,
+`VK_ERROR_OUT_OF_DEVICE_MEMORY` if memory for its pages couldn't be allocated.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaSparseBufferAllocate(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaSparseBuffer VMA_NOT_NULL sparseBuffer,
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    VkDeviceSize* VMA_NOT_NULL pOffset);
+
+/** \brief Frees range of the sparse buffer allocated with vmaSparseBufferAllocate().
+
+\param allocator
+\param sparseBuffer
+\param offset Offset returned by vmaSparseBufferAllocate().
+
+The GPU must no longer use the range. Pages left with no allocated ranges are unbound by
+the next call to vmaSubmitSparseBinds().
+*/
+VMA_CALL_PRE void VMA_CALL_POST vmaSparseBufferFree(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaSparseBuffer VMA_NOT_NULL sparseBuffer,
+    VkDeviceSize offset);
+
+/** \brief Binds and unbinds pages of given sparse buffers changed since previous call, using a single call to `vkQueueBindSparse()`.
+
+\param allocator
+\param sparseBufferCount Number of elements in `pSparseBuffers` array.
+\param pSparseBuffers Sparse buffers to update.
+\param pSubmitInfo Queue and synchronization primitives of the submission.
+
+Call it once per frame. Bindings of adjacent pages are merged where possible.
+Changed pages are found by walking all pages of every given buffer, so the cost of this function
+is proportional to their total number of pages, even if only a few of them changed.
+If no page needs to be bound or unbound, `vkQueueBindSparse()` is still called when
+any semaphores or a fence are specified, so they get waited on and signaled as expected.
+Afterwards, memory unbound at least `frameInUseCount` frames ago is freed.
+
+Don't call this function for the same sparse buffer from multiple threads simultaneously.
+Passing `VK_NULL_HANDLE` as elements of `pSparseBuffers` array is valid. Such entries are just skipped.
+The same sparse buffer may appear in the array more than once - it is updated only once.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaSubmitSparseBinds(
+    VmaAllocator VMA_NOT_NULL allocator,
+    uint32_t sparseBufferCount,
+    const VmaSparseBuffer VMA_NULLABLE * VMA_NULLABLE VMA_LEN_IF_NOT_NULL(sparseBufferCount) pSparseBuffers,
+    const VmaSparseBindSubmitInfo* VMA_NOT_NULL pSubmitInfo);
+
+/** \struct VmaSparsePagePool
+\brief Represents pool of fixed-size memory pages for sparse resources.
+
+Call function vmaCreateSparsePagePool() to create it and vmaAllocateSparseImagePages() to allocate pages from it.
+
+For more information see [Page pools for sparse images](@ref sparse_buffers_page_pool).
+*/
+VK_DEFINE_HANDLE(VmaSparsePagePool)
+
+/// Describes parameters of created #VmaSparsePagePool.
+typedef struct VmaSparsePagePoolCreateInfo {
+    /** \brief Size of a single page, in bytes. Optional.
+
+    Should be `VkMemoryRequirements::alignment` of the sparse resources, which is their sparse block size.
+    Leave 0 to use 64 KiB, the standard sparse block size.
+    */
+    VkDeviceSize pageSize;
+    /** \brief Bitmask containing one bit set for every memory type acceptable for the pages. Optional.
+
+    Use `VkMemoryRequirements::memoryTypeBits` of the sparse resources.
+    Value 0 is equivalent to `UINT32_MAX`. Among acceptable types, `DEVICE_LOCAL` ones are preferred.
+    */
+    uint32_t memoryTypeBits;
+    /** \brief Number of pages in a single `VkDeviceMemory` block. Optional.
+
+    Leave 0 to use default, which makes blocks as large as for default pools.
+    */
+    uint32_t pagesPerBlock;
+    /** \brief Maximum number of blocks that can be allocated in this pool. Optional.
+
+    Set to 0 to use default, which is `SIZE_MAX`, which means no limit.
+    */
+    size_t maxBlockCount;
+} VmaSparsePagePoolCreateInfo;
+
+/** \brief Creates pool of fixed-size memory pages for sparse resources.
+
+\param allocator
+\param pCreateInfo Parameters of the pool.
+\param[out] pPool Handle to created pool.
+
+No memory is allocated by this function.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaCreateSparsePagePool(
+    VmaAllocator VMA_NOT_NULL allocator,
+    const VmaSparsePagePoolCreateInfo* VMA_NOT_NULL pCreateInfo,
+    VmaSparsePagePool VMA_NULLABLE * VMA_NOT_NULL pPool);
+
+/** \brief Destroys the pool and frees all its memory, including pages that were not freed.
+
+Passing `VK_NULL_HANDLE` as `pool` is valid. Such function call is just skipped.
+*/
+VMA_CALL_PRE void VMA_CALL_POST vmaDestroySparsePagePool(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaSparsePagePool VMA_NULLABLE pool);
+
+/** \brief Retrieves statistics of the pool.
+
+VmaPoolStats::allocationCount is the number of allocated pages.
+Every free page is counted as a separate range in VmaPoolStats::unusedRangeCount.
+*/
+VMA_CALL_PRE void VMA_CALL_POST vmaGetSparsePagePoolStats(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaSparsePagePool VMA_NOT_NULL pool,
+    VmaPoolStats* VMA_NOT_NULL pPoolStats);
+
+/** \brief Allocates one page for each of given image binds.
+
+\param allocator
+\param pool
+\param bindCount Number of elements in `pBinds` array.
+\param[in,out] pBinds Binds to allocate pages for. Members `memory` and `memoryOffset` are filled by this function, other members are left unchanged.
+
+Either all pages are allocated, or none of them. In the latter case `memory` of all elements is set to `VK_NULL_HANDLE`.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaAllocateSparseImagePages(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaSparsePagePool VMA_NOT_NULL pool,
+    uint32_t bindCount,
+    VkSparseImageMemoryBind* VMA_NOT_NULL VMA_LEN_IF_NOT_NULL(bindCount) pBinds);
+
+/** \brief Frees pages allocated with vmaAllocateSparseImagePages().
+
+\param allocator
+\param pool
+\param bindCount Number of elements in `pBinds` array.
+\param pBinds Binds whose `memory` and `memoryOffset` identify the pages to free.
+
+The GPU must no longer use these pages. Elements with `memory` equal to `VK_NULL_HANDLE` are skipped.
+*/
+VMA_CALL_PRE void VMA_CALL_POST vmaFreeSparseImagePages(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaSparsePagePool VMA_NOT_NULL pool,
+    uint32_t bindCount,
+    const VkSparseImageMemoryBind* VMA_NULLABLE VMA_LEN_IF_NOT_NULL(bindCount) pBinds);
+
+/** \brief Allocates one page for each of given buffer or opaque image binds.
+
+Same as vmaAllocateSparseImagePages(), but for `VkSparseMemoryBind` structures.
+`size` of every bind must not be greater than page size of the pool.
+*/
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaAllocateSparseOpaquePages(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaSparsePagePool VMA_NOT_NULL pool,
+    uint32_t bindCount,
+    VkSparseMemoryBind* VMA_NOT_NULL VMA_LEN_IF_NOT_NULL(bindCount) pBinds);
+
+/** \brief Frees pages allocated with vmaAllocateSparseOpaquePages().
+
+Same as vmaFreeSparseImagePages(), but for `VkSparseMemoryBind` structures.
+*/
+VMA_CALL_PRE void VMA_CALL_POST vmaFreeSparseOpaquePages(
+    VmaAllocator VMA_NOT_NULL allocator,
+    VmaSparsePagePool VMA_NOT_NULL pool,
+    uint32_t bindCount,
+    const VkSparseMemoryBind* VMA_NULLABLE VMA_LEN_IF_NOT_NULL(bindCount) pBinds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AMD_VULKAN_MEMORY_ALLOCATOR_H
+
+// For Visual Studio IntelliSense.
+#if defined(__cplusplus) && defined(__INTELLISENSE__)
+#define VMA_IMPLEMENTATION
+#endif
+
+#ifdef VMA_IMPLEMENTATION
+#undef VMA_IMPLEMENTATION
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#ifdef _MSC_VER
+    #include <intrin.h> // for _BitScanForward64
+#endif
+
+#if VMA_RECORDING_ENABLED
+    #include <chrono>
+    #include <cstdarg>
+    #include <type_traits>
+    #if defined(_WIN32)
+        #include <windows.h>
+    #else
+        #include <sstream>
+        #include <thread>
+    #endif
+#endif
+
+/*******************************************************************************
+CONFIGURATION SECTION
+
+Define some of these macros before each #include of this header or change them
+here if you need other then default behavior depending on your environment.
+*/
+
+/*
+Define this macro to 1 to make the library fetch pointers to Vulkan functions
+internally, like:
+
+    vulkanFunctions.vkAllocateMemory = &vkAllocateMemory;
+*/
+#if !defined(VMA_STATIC_VULKAN_FUNCTIONS) && !defined(VK_NO_PROTOTYPES)
+    #define VMA_STATIC_VULKAN_FUNCTIONS 1
+#endif
 
 /*
 Define this macro to 1 to make the library fetch pointers to Vulkan functions
@@ -4380,6 +6328,21 @@ If providing your own implementation, you need to implement a subset of std::ato
    #define VMA_DEFAULT_LARGE_HEAP_BLOCK_SIZE (256ull * 1024 * 1024)
 #endif
 
+#ifndef VMA_DEFAULT_MEMORY_PRIORITY
+   /// Priority of memory when VmaPoolCreateInfo::priority or VmaAllocationCreateInfo::priority is 0.
+   #define VMA_DEFAULT_MEMORY_PRIORITY (0.5f)
+#endif
+
+#ifndef VMA_COLD_MEMORY_FRAME_COUNT
+   /// Number of frames without use after which memory is considered cold and its priority is lowered.
+   #define VMA_COLD_MEMORY_FRAME_COUNT (16)
+#endif
+
+#ifndef VMA_DEFAULT_SPARSE_PAGE_SIZE
+   /// Size of a page of #VmaSparseBuffer when VmaSparseBufferCreateInfo::pageSize is 0.
+   #define VMA_DEFAULT_SPARSE_PAGE_SIZE (2ull * 1024 * 1024)
+#endif
+
 #ifndef VMA_CLASS_NO_COPY
     #define VMA_CLASS_NO_COPY(className) \
         private: \
@@ -4406,6 +6369,8 @@ static const uint32_t VK_MEMORY_PROPERTY_DEVICE_UNCACHED_BIT_AMD_COPY = 0x000000
 static const uint32_t VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_COPY = 0x00020000;
 
 static const uint32_t VMA_ALLOCATION_INTERNAL_STRATEGY_MIN_OFFSET = 0x10000000u;
+static const uint32_t VMA_ALLOCATION_INTERNAL_STRATEGY_MAX_OFFSET = 0x20000000u;
+static const uint32_t VMA_ALLOCATION_INTERNAL_STRATEGY_ZEROED = 0x40000000u;
 
 static VkAllocationCallbacks VmaEmptyAllocationCallbacks = {
     VMA_NULL, VMA_NULL, VMA_NULL, VMA_NULL, VMA_NULL, VMA_NULL };
@@ -4421,6 +6386,27 @@ static inline uint32_t VmaCountBitsSet(uint32_t v)
     return c;
 }
 
+// Returns index of the lowest bit set to 1 in (mask). Mask must not be 0.
+static inline uint32_t VmaBitScanLSB(uint64_t mask)
+{
+    VMA_ASSERT(mask != 0);
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long pos;
+    _BitScanForward64(&pos, mask);
+    return static_cast<uint32_t>(pos);
+#elif defined(__GNUC__) || defined(__clang__)
+    return static_cast<uint32_t>(__builtin_ctzll(mask));
+#else
+    uint32_t pos = 0;
+    while((mask & 1) == 0)
+    {
+        mask >>= 1;
+        ++pos;
+    }
+    return pos;
+#endif
+}
+
 /*
 Returns true if given number is a power of two.
 T must be unsigned integer number or signed integer but always nonnegative.
@@ -4808,6 +6794,19 @@ static inline void VmaPnextChainPushFront(MainT* mainStruct, NewT* newStruct)
     mainStruct->pNext = newStruct;
 }
 
+static inline float VmaGetMemoryPriority(float priority)
+{
+    return priority != 0.f ? priority : VMA_DEFAULT_MEMORY_PRIORITY;
+}
+
+#if VMA_PAGEABLE_DEVICE_LOCAL_MEMORY
+// Returns priority to set for memory with given priority that was last used in frame lastUseFrameIndex.
+static inline float VmaCalcColdMemoryPriority(float priority, uint32_t lastUseFrameIndex, uint32_t currentFrameIndex)
+{
+    return currentFrameIndex - lastUseFrameIndex > VMA_COLD_MEMORY_FRAME_COUNT ? priority * 0.5f : priority;
+}
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 // Memory allocation
 
@@ -6089,6 +8088,8 @@ private:
     enum FLAGS
     {
         FLAG_USER_DATA_STRING = 0x01,
+        FLAG_CREATED_BLOCK = 0x02,
+        FLAG_NOT_RECORDED = 0x04,
     };
 
 public:
@@ -6107,16 +8108,27 @@ public:
         m_Alignment{1},
         m_Size{0},
         m_pUserData{VMA_NULL},
+        m_Scope{VMA_NULL},
+        m_Quota{VMA_NULL},
+        m_QuotaCharge{0},
         m_LastUseFrameIndex{currentFrameIndex},
         m_MemoryTypeIndex{0},
+        m_IndexInScope{0},
+        m_HostAccessCount{0},
         m_Type{(uint8_t)ALLOCATION_TYPE_NONE},
         m_SuballocationType{(uint8_t)VMA_SUBALLOCATION_TYPE_UNKNOWN},
         m_MapCount{0},
-        m_Flags{userDataString ? (uint8_t)FLAG_USER_DATA_STRING : (uint8_t)0}
+        m_Flags{userDataString ? (uint8_t)FLAG_USER_DATA_STRING : (uint8_t)0},
+        m_Tag{0},
+        m_Lifetime{(uint8_t)VMA_ALLOCATION_LIFETIME_UNKNOWN},
+        m_PublishedPoolSlot{(uint8_t)VMA_PUBLISHED_STATS_MAX_POOLS}
     {
 #if VMA_STATS_STRING_ENABLED
         m_CreationFrameIndex = currentFrameIndex;
         m_BufferImageUsage = 0;
+#endif
+#if VMA_RECORDING_ENABLED
+        m_IndexInRecorder = UINT32_MAX;
 #endif
     }
 
@@ -6168,6 +8180,7 @@ public:
         VkDeviceSize offset);
 
     void ChangeOffset(VkDeviceSize newOffset);
+    void ChangeSize(VkDeviceSize newSize);
 
     // pMappedData not null means allocation is created with MAPPED flag.
     void InitDedicatedAllocation(
@@ -6175,7 +8188,8 @@ public:
         VkDeviceMemory hMemory,
         VmaSuballocationType suballocationType,
         void* pMappedData,
-        VkDeviceSize size)
+        VkDeviceSize size,
+        float priority)
     {
         VMA_ASSERT(m_Type == ALLOCATION_TYPE_NONE);
         VMA_ASSERT(hMemory != VK_NULL_HANDLE);
@@ -6187,21 +8201,76 @@ public:
         m_MapCount = (pMappedData != VMA_NULL) ? MAP_COUNT_FLAG_PERSISTENT_MAP : 0;
         m_DedicatedAllocation.m_hMemory = hMemory;
         m_DedicatedAllocation.m_pMappedData = pMappedData;
+        m_DedicatedAllocation.m_Priority = priority;
+        m_DedicatedAllocation.m_AppliedPriority = priority;
     }
 
     ALLOCATION_TYPE GetType() const { return (ALLOCATION_TYPE)m_Type; }
     VkDeviceSize GetAlignment() const { return m_Alignment; }
     VkDeviceSize GetSize() const { return m_Size; }
     bool IsUserDataString() const { return (m_Flags & FLAG_USER_DATA_STRING) != 0; }
+    // True if a new memory block had to be created for this allocation.
+    bool HasCreatedBlock() const { return (m_Flags & FLAG_CREATED_BLOCK) != 0; }
+    void SetCreatedBlock() { m_Flags |= FLAG_CREATED_BLOCK; }
+    // False if excluded by filters in VmaRecordSettings, set once when allocation is created.
+    bool IsRecorded() const { return (m_Flags & FLAG_NOT_RECORDED) == 0; }
+    void SetNotRecorded() { m_Flags |= FLAG_NOT_RECORDED; }
+#if VMA_RECORDING_ENABLED
+    // Index in live allocations of VmaRecorder, UINT32_MAX if not there. Changed only under the mutex of the recorder.
+    uint32_t GetIndexInRecorder() const { return m_IndexInRecorder; }
+    void SetIndexInRecorder(uint32_t index) { m_IndexInRecorder = index; }
+#endif
     void* GetUserData() const { return m_pUserData; }
     void SetUserData(VmaAllocator hAllocator, void* pUserData);
     VmaSuballocationType GetSuballocationType() const { return (VmaSuballocationType)m_SuballocationType; }
 
+    // Changed only under the mutex of the scope.
+    VmaAllocationScope GetScope() const { return m_Scope; }
+    uint32_t GetIndexInScope() const { return m_IndexInScope; }
+    void SetScope(VmaAllocationScope scope, uint32_t indexInScope) { m_Scope = scope; m_IndexInScope = indexInScope; }
+
+    // Quota that size of this allocation is charged to, and the charged size.
+    // It is the requested size, which may differ from GetSize() e.g. with corruption detection.
+    VmaQuota GetQuota() const { return m_Quota; }
+    VkDeviceSize GetQuotaCharge() const { return m_QuotaCharge; }
+    void SetQuota(VmaQuota quota, VkDeviceSize charge) { m_Quota = quota; m_QuotaCharge = charge; }
+
+    uint32_t GetTag() const { return m_Tag; }
+    void SetTag(uint32_t tag) { VMA_ASSERT(tag < VMA_ALLOCATION_TAG_COUNT); m_Tag = (uint8_t)tag; }
+
+    // Remembered to place the allocation among the same lifetime again when it is moved or reallocated.
+    VmaAllocationLifetime GetLifetime() const { return (VmaAllocationLifetime)m_Lifetime; }
+    void SetLifetime(VmaAllocationLifetime lifetime) { m_Lifetime = (uint8_t)lifetime; }
+
+    // Remembered because parent pool can't be reached through the block once the allocation becomes lost.
+    uint32_t GetPublishedPoolSlot() const { return m_PublishedPoolSlot; }
+    void SetPublishedPoolSlot(uint32_t slot) { VMA_ASSERT(slot <= VMA_PUBLISHED_STATS_MAX_POOLS); m_PublishedPoolSlot = (uint8_t)slot; }
+
+    void IncrementHostAccessCount() { m_HostAccessCount.fetch_add(1); }
+    // Returns number of host accesses counted so far and starts counting from zero.
+    uint32_t ResetHostAccessCount() { return m_HostAccessCount.exchange(0); }
+
     VmaDeviceMemoryBlock* GetBlock() const
     {
         VMA_ASSERT(m_Type == ALLOCATION_TYPE_BLOCK);
         return m_BlockAllocation.m_Block;
     }
+    float GetDedicatedPriority() const
+    {
+        VMA_ASSERT(m_Type == ALLOCATION_TYPE_DEDICATED);
+        return m_DedicatedAllocation.m_Priority;
+    }
+    // Last priority passed to vkSetDeviceMemoryPriorityEXT. Changed only in vmaSetCurrentFrameIndex().
+    float GetDedicatedAppliedPriority() const
+    {
+        VMA_ASSERT(m_Type == ALLOCATION_TYPE_DEDICATED);
+        return m_DedicatedAllocation.m_AppliedPriority;
+    }
+    void SetDedicatedAppliedPriority(float priority)
+    {
+        VMA_ASSERT(m_Type == ALLOCATION_TYPE_DEDICATED);
+        m_DedicatedAllocation.m_AppliedPriority = priority;
+    }
     VkDeviceSize GetOffset() const;
     VkDeviceMemory GetMemory() const;
     uint32_t GetMemoryTypeIndex() const { return m_MemoryTypeIndex; }
@@ -6262,14 +8331,22 @@ private:
     VkDeviceSize m_Alignment;
     VkDeviceSize m_Size;
     void* m_pUserData;
+    VmaAllocationScope m_Scope; // Null if not in any scope.
+    VmaQuota m_Quota; // Null if not charged to any quota.
+    VkDeviceSize m_QuotaCharge;
     VMA_ATOMIC_UINT32 m_LastUseFrameIndex;
     uint32_t m_MemoryTypeIndex;
+    uint32_t m_IndexInScope; // Index in VmaAllocationScope_T::m_Allocations.
+    VMA_ATOMIC_UINT32 m_HostAccessCount; // Since last vmaBalanceBarMemory().
     uint8_t m_Type; // ALLOCATION_TYPE
     uint8_t m_SuballocationType; // VmaSuballocationType
     // Bit 0x80 is set when allocation was created with VMA_ALLOCATION_CREATE_MAPPED_BIT.
     // Bits with mask 0x7F are reference counter for vmaMapMemory()/vmaUnmapMemory().
     uint8_t m_MapCount;
     uint8_t m_Flags; // enum FLAGS
+    uint8_t m_Tag; // VmaAllocationCreateInfo::tag
+    uint8_t m_Lifetime; // VmaAllocationLifetime
+    uint8_t m_PublishedPoolSlot; // Index to VmaPublishedStats::pools, VMA_PUBLISHED_STATS_MAX_POOLS if none.
 
     // Allocation out of VmaDeviceMemoryBlock.
     struct BlockAllocation
@@ -6284,6 +8361,8 @@ private:
     {
         VkDeviceMemory m_hMemory;
         void* m_pMappedData; // Not null means memory is mapped.
+        float m_Priority;
+        float m_AppliedPriority;
     };
 
     union
@@ -6298,6 +8377,9 @@ private:
     uint32_t m_CreationFrameIndex;
     uint32_t m_BufferImageUsage; // 0 if unknown.
 #endif
+#if VMA_RECORDING_ENABLED
+    uint32_t m_IndexInRecorder; // Index in VmaRecorder::m_LiveAllocations.
+#endif
 
     void FreeUserDataString(VmaAllocator hAllocator);
 };
@@ -6312,8 +8394,26 @@ struct VmaSuballocation
     VkDeviceSize size;
     VmaAllocation hAllocation;
     VmaSuballocationType type;
+    // Used only for free suballocations in VmaBlockMetadata_Generic:
+    // range [zeroedBegin, zeroedEnd) known to contain zeros. Empty when both are equal.
+    VkDeviceSize zeroedBegin;
+    VkDeviceSize zeroedEnd;
 };
 
+// Returns true if range [offset, offset + size) of given free suballocation is known to contain zeros.
+static inline bool VmaIsSuballocationRangeZeroed(const VmaSuballocation& suballoc, VkDeviceSize offset, VkDeviceSize size)
+{
+    return offset >= suballoc.zeroedBegin && offset + size <= suballoc.zeroedEnd;
+}
+
+// Limits zeroed range of given free suballocation to its current offset and size.
+static inline void VmaClipSuballocationZeroedRange(VmaSuballocation& suballoc)
+{
+    const VkDeviceSize end = suballoc.offset + suballoc.size;
+    suballoc.zeroedBegin = VMA_MIN(VMA_MAX(suballoc.zeroedBegin, suballoc.offset), end);
+    suballoc.zeroedEnd = VMA_MAX(VMA_MIN(suballoc.zeroedEnd, end), suballoc.zeroedBegin);
+}
+
 // Comparator for offsets.
 struct VmaSuballocationOffsetLess
 {
@@ -6397,6 +8497,9 @@ public:
     // Shouldn't modify blockCount.
     virtual void AddPoolStats(VmaPoolStats& inoutStats) const = 0;
 
+    // Returns allocation that contains given offset, or null if the offset is not inside any allocation.
+    virtual VmaAllocation FindAllocationAt(VkDeviceSize offset) const = 0;
+
 #if VMA_STATS_STRING_ENABLED
     virtual void PrintDetailedMap(class VmaJsonWriter& json) const = 0;
 #endif
@@ -6433,11 +8536,50 @@ public:
         VkDeviceSize allocSize,
         VmaAllocation hAllocation) = 0;
 
-    // Frees suballocation assigned to given memory region.
-    virtual void Free(const VmaAllocation allocation) = 0;
-    virtual void FreeAtOffset(VkDeviceSize offset) = 0;
+    // Returns end of the free range where the request was found, so other allocations can be
+    // considered after it. Default returns request.offset, meaning the rest of the range is unknown.
+    virtual VkDeviceSize GetRequestFreeRangeEnd(const VmaAllocationRequest& request) const { return request.offset; }
 
-protected:
+    // Makes multiple allocations placed every stride bytes, starting at request.offset.
+    // Request must already be checked and valid for size stride * (allocationCount - 1) + allocSize.
+    // Not supported by buddy algorithm.
+    virtual void AllocPages(
+        const VmaAllocationRequest& request,
+        VmaSuballocationType type,
+        VkDeviceSize allocSize,
+        VkDeviceSize stride,
+        size_t allocationCount,
+        const VmaAllocation* pAllocations)
+    {
+        VmaAllocationRequest pageRequest = request;
+        for(size_t allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
+        {
+            pageRequest.offset = request.offset + stride * allocIndex;
+            Alloc(pageRequest, type, allocSize, pAllocations[allocIndex]);
+        }
+    }
+
+    // Frees suballocation assigned to given memory region.
+    virtual void Free(const VmaAllocation allocation) = 0;
+    virtual void FreeAtOffset(VkDeviceSize offset) = 0;
+    // Frees multiple suballocations. pAllocations must be sorted by offset, ascending.
+    virtual void FreeBatch(const VmaAllocation* pAllocations, size_t allocationCount)
+    {
+        for(size_t allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
+        {
+            Free(pAllocations[allocIndex]);
+        }
+    }
+
+    // Tries to change size of given allocation in place, without changing its offset.
+    // Returns false if it's not possible, leaving the metadata unchanged.
+    // Allocation object itself is not updated - caller must call alloc->ChangeSize().
+    virtual bool ResizeAllocation(
+        const VmaAllocation alloc,
+        VkDeviceSize newSize,
+        VkDeviceSize bufferImageGranularity) = 0;
+
+protected:
     const VkAllocationCallbacks* GetAllocationCallbacks() const { return m_pAllocationCallbacks; }
 
 #if VMA_STATS_STRING_ENABLED
@@ -6480,6 +8622,7 @@ public:
 
     virtual void CalcAllocationStatInfo(VmaStatInfo& outInfo) const;
     virtual void AddPoolStats(VmaPoolStats& inoutStats) const;
+    virtual VmaAllocation FindAllocationAt(VkDeviceSize offset) const;
 
 #if VMA_STATS_STRING_ENABLED
     virtual void PrintDetailedMap(class VmaJsonWriter& json) const;
@@ -6511,9 +8654,26 @@ public:
         VmaSuballocationType type,
         VkDeviceSize allocSize,
         VmaAllocation hAllocation);
+    virtual void AllocPages(
+        const VmaAllocationRequest& request,
+        VmaSuballocationType type,
+        VkDeviceSize allocSize,
+        VkDeviceSize stride,
+        size_t allocationCount,
+        const VmaAllocation* pAllocations);
+    virtual VkDeviceSize GetRequestFreeRangeEnd(const VmaAllocationRequest& request) const
+    {
+        return request.item->offset + request.item->size;
+    }
 
     virtual void Free(const VmaAllocation allocation);
     virtual void FreeAtOffset(VkDeviceSize offset);
+    virtual void FreeBatch(const VmaAllocation* pAllocations, size_t allocationCount);
+
+    virtual bool ResizeAllocation(
+        const VmaAllocation alloc,
+        VkDeviceSize newSize,
+        VkDeviceSize bufferImageGranularity);
 
     ////////////////////////////////////////////////////////////////////////////////
     // For defragmentation
@@ -6522,6 +8682,21 @@ public:
         VkDeviceSize bufferImageGranularity,
         VmaSuballocationType& inOutPrevSuballocType) const;
 
+    ////////////////////////////////////////////////////////////////////////////////
+    // For zeroing of free memory
+
+    /*
+    Finds parts of free suballocations not known to contain zeros, appends them to
+    outRanges and marks them as zeroed, assuming the caller fills them with zeros.
+    Ranges are aligned to given alignment and don't cover debug margins.
+    Returns false if stopped early because of inoutMaxBytes or maxRangeCount.
+    */
+    bool ClaimDirtyFreeRanges(
+        VkDeviceSize alignment,
+        VkDeviceSize& inoutMaxBytes,
+        size_t maxRangeCount,
+        VmaVector< VmaZeroFillRange, VmaStlAllocator<VmaZeroFillRange> >& outRanges);
+
 private:
     friend class VmaDefragmentationAlgorithm_Generic;
     friend class VmaDefragmentationAlgorithm_Fast;
@@ -6550,6 +8725,15 @@ private:
         size_t* itemsToMakeLostCount,
         VkDeviceSize* pSumFreeSize,
         VkDeviceSize* pSumItemSize) const;
+    // Given free suballocation and offset already accepted by CheckAllocation,
+    // returns the highest offset inside it where the allocation can be placed instead.
+    VkDeviceSize CalcUpperOffset(
+        VkDeviceSize bufferImageGranularity,
+        VkDeviceSize allocSize,
+        VkDeviceSize allocAlignment,
+        VmaSuballocationType allocType,
+        VmaSuballocationList::const_iterator freeSuballocItem,
+        VkDeviceSize lowerOffset) const;
     // Given free suballocation, it merges it with following one, which must also be free.
     void MergeFreeWithNext(VmaSuballocationList::iterator item);
     // Releases given suballocation, making it free.
@@ -6658,6 +8842,7 @@ public:
 
     virtual void CalcAllocationStatInfo(VmaStatInfo& outInfo) const;
     virtual void AddPoolStats(VmaPoolStats& inoutStats) const;
+    virtual VmaAllocation FindAllocationAt(VkDeviceSize offset) const;
 
 #if VMA_STATS_STRING_ENABLED
     virtual void PrintDetailedMap(class VmaJsonWriter& json) const;
@@ -6689,10 +8874,31 @@ public:
         VmaSuballocationType type,
         VkDeviceSize allocSize,
         VmaAllocation hAllocation);
+    virtual VkDeviceSize GetRequestFreeRangeEnd(const VmaAllocationRequest& request) const;
 
     virtual void Free(const VmaAllocation allocation);
     virtual void FreeAtOffset(VkDeviceSize offset);
 
+    virtual bool ResizeAllocation(
+        const VmaAllocation alloc,
+        VkDeviceSize newSize,
+        VkDeviceSize bufferImageGranularity);
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // For markers and reset of linear pools
+
+    // Returns offset just after the last allocation of 1st vector. Returns false in ring buffer mode.
+    bool GetLowerStackTop(VkDeviceSize& outOffset) const;
+    /*
+    Removes allocations from the end of 1st vector that start at or after given offset
+    and appends them to outAllocations. Returns false in ring buffer mode.
+    */
+    bool FreeLowerStackAbove(
+        VkDeviceSize offset,
+        VmaVector< VmaAllocation, VmaStlAllocator<VmaAllocation> >& outAllocations);
+    // Removes all allocations and appends them to outAllocations.
+    void FreeAll(VmaVector< VmaAllocation, VmaStlAllocator<VmaAllocation> >& outAllocations);
+
 private:
     /*
     There are two suballocation vectors, used in ping-pong way.
@@ -6788,6 +8994,7 @@ public:
 
     virtual void CalcAllocationStatInfo(VmaStatInfo& outInfo) const;
     virtual void AddPoolStats(VmaPoolStats& inoutStats) const;
+    virtual VmaAllocation FindAllocationAt(VkDeviceSize offset) const;
 
 #if VMA_STATS_STRING_ENABLED
     virtual void PrintDetailedMap(class VmaJsonWriter& json) const;
@@ -6823,6 +9030,11 @@ public:
     virtual void Free(const VmaAllocation allocation) { FreeAtOffset(allocation, allocation->GetOffset()); }
     virtual void FreeAtOffset(VkDeviceSize offset) { FreeAtOffset(VMA_NULL, offset); }
 
+    virtual bool ResizeAllocation(
+        const VmaAllocation alloc,
+        VkDeviceSize newSize,
+        VkDeviceSize bufferImageGranularity);
+
 private:
     static const VkDeviceSize MIN_NODE_SIZE = 32;
     static const size_t MAX_LEVELS = 30;
@@ -6936,7 +9148,8 @@ public:
         VkDeviceMemory newMemory,
         VkDeviceSize newSize,
         uint32_t id,
-        uint32_t algorithm);
+        uint32_t algorithm,
+        float priority);
     // Always call before destruction.
     void Destroy(VmaAllocator allocator);
 
@@ -6945,6 +9158,18 @@ public:
     uint32_t GetMemoryTypeIndex() const { return m_MemoryTypeIndex; }
     uint32_t GetId() const { return m_Id; }
     void* GetMappedData() const { return m_pMappedData; }
+    // Lifetime hint of allocations that this block was started with. Meaningful only while block is not empty.
+    VmaAllocationLifetime GetLifetime() const { return m_Lifetime; }
+    void SetLifetime(VmaAllocationLifetime lifetime) { m_Lifetime = lifetime; }
+    // Highest priority of allocations that this block was started with or that were made in it since.
+    float GetPriority() const { return m_Priority; }
+    void SetPriority(float priority) { m_Priority = priority; }
+    // Can be called without the lock of parent VmaBlockVector.
+    void MarkUsed(uint32_t frameIndex) { m_LastUseFrameIndex.store(frameIndex); }
+#if VMA_PAGEABLE_DEVICE_LOCAL_MEMORY
+    // Calls vkSetDeviceMemoryPriorityEXT if priority of this block changed since the last call.
+    void UpdateMemoryPriority(VmaAllocator hAllocator, uint32_t currentFrameIndex);
+#endif
 
     // Validates all data structures inside this object. If not valid, returns false.
     bool Validate() const;
@@ -6976,6 +9201,10 @@ private:
     uint32_t m_MemoryTypeIndex;
     uint32_t m_Id;
     VkDeviceMemory m_hMemory;
+    VmaAllocationLifetime m_Lifetime;
+    float m_Priority;
+    float m_AppliedPriority; // Changed only in vmaSetCurrentFrameIndex().
+    VMA_ATOMIC_UINT32 m_LastUseFrameIndex;
 
     /*
     Protects access to m_hMemory so it's not used by multiple threads simultaneously, e.g. vkMapMemory, vkBindBufferMemory.
@@ -7008,6 +9237,27 @@ struct VmaDefragmentationMove
 };
 
 class VmaDefragmentationAlgorithm;
+struct VmaBlockVector;
+
+// Single allocation of VmaAllocator_T::AllocateMemoryBatch().
+struct VmaBatchAllocation
+{
+    // Null if the allocation is to be made separately, with VmaAllocator_T::AllocateMemory().
+    VmaBlockVector* pBlockVector;
+    // Index in the array of allocations passed by the user.
+    size_t index;
+    VkDeviceSize size;
+    VkDeviceSize alignment;
+    VmaAllocationCreateInfo createInfo;
+};
+
+// Free range of existing block taken by an allocation in vmaCheckAllocationsFit().
+struct VmaFitReservation
+{
+    const VmaDeviceMemoryBlock* pBlock;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+};
 
 /*
 Sequence of VmaDeviceMemoryBlock. Represents memory blocks allocated for a specific
@@ -7029,7 +9279,10 @@ public:
         VkDeviceSize bufferImageGranularity,
         uint32_t frameInUseCount,
         bool explicitBlockSize,
-        uint32_t algorithm);
+        uint32_t algorithm,
+        void* pHostPointer,
+        VkFlags exportHandleTypes,
+        float priority);
     ~VmaBlockVector();
 
     VkResult CreateMinBlocks();
@@ -7037,6 +9290,7 @@ public:
     VmaAllocator GetAllocator() const { return m_hAllocator; }
     VmaPool GetParentPool() const { return m_hParentPool; }
     bool IsCustomPool() const { return m_hParentPool != VMA_NULL; }
+    VkFlags GetExportHandleTypes() const { return m_ExportHandleTypes; }
     uint32_t GetMemoryTypeIndex() const { return m_MemoryTypeIndex; }
     VkDeviceSize GetPreferredBlockSize() const { return m_PreferredBlockSize; }
     VkDeviceSize GetBufferImageGranularity() const { return m_BufferImageGranularity; }
@@ -7057,7 +9311,51 @@ public:
         size_t allocationCount,
         VmaAllocation* pAllocations);
 
+    /*
+    Checks if allocation could be made in existing blocks, without making it. Ranges taken by
+    earlier allocations of the same check, listed in inoutReservations, are treated as used.
+    If the allocation fits, appends its range to inoutReservations and returns true.
+    */
+    bool CheckFitInExistingBlocks(
+        uint32_t currentFrameIndex,
+        VkDeviceSize size,
+        VkDeviceSize alignment,
+        const VmaAllocationCreateInfo& createInfo,
+        VmaVector< VmaFitReservation, VmaStlAllocator<VmaFitReservation> >& inoutReservations);
+    // Returns true if given number of new blocks could be created, not exceeding maxBlockCount.
+    bool CanCreateBlocks(size_t blockCount);
+    // Returns size of the largest existing block, or preferred block size if it is exceeded.
+    VkDeviceSize GetMaxBlockSize();
+
+    /*
+    Returns size of a new block to create for allocation of given size. Used by allocation and
+    by vmaCheckAllocationsFit(), so both choose the same size. Unless block size is explicit,
+    first blocks are 1/8, 1/4, 1/2 of the preferred size, as long as they are larger than
+    maxExistingBlockSize and at least twice the allocation size. outShift receives number of halvings.
+    */
+    VkDeviceSize CalcNewBlockSize(VkDeviceSize allocSize, VkDeviceSize maxExistingBlockSize, uint32_t& outShift) const;
+    // Halves size of a new block that couldn't be created, e.g. because of budget. Returns false if it can't be smaller.
+    bool ShrinkNewBlockSize(VkDeviceSize allocSize, VkDeviceSize& inoutBlockSize, uint32_t& inoutShift) const;
+
+    // If memory is one of blocks of this vector, returns true and allocation at given offset in it, possibly null.
+    bool FindAllocation(VkDeviceMemory memory, VkDeviceSize offset, VmaAllocation& outAllocation);
+
+    // Makes allocations of a batch under a single lock, in order of pItems.
+    // Result for item is stored in pAllocations[item.index]. Those that failed are left null.
+    void AllocateBatch(
+        uint32_t currentFrameIndex,
+        const VmaBatchAllocation* pItems,
+        size_t itemCount,
+        VmaAllocation* pAllocations);
+
     void Free(const VmaAllocation hAllocation);
+    // Frees multiple allocations under a single lock.
+    // pAllocations must be sorted by block and then by offset, ascending.
+    void FreeBatch(const VmaAllocation* pAllocations, size_t allocationCount);
+
+    // Tries to change size of given allocation in place, without moving it.
+    // Returns VK_ERROR_OUT_OF_POOL_MEMORY if there is no room to grow.
+    VkResult ResizeAllocation(const VmaAllocation hAllocation, VkDeviceSize newSize);
 
     // Adds statistics of this BlockVector to pStats.
     void AddStats(VmaStats* pStats);
@@ -7071,6 +9369,31 @@ public:
         size_t* pLostAllocationCount);
     VkResult CheckCorruption();
 
+#if VMA_PAGEABLE_DEVICE_LOCAL_MEMORY
+    void UpdateMemoryPriorities(uint32_t currentFrameIndex);
+#endif
+
+    /*
+    Marks free ranges of this block vector as zeroed. Ranges in HOST_VISIBLE memory are
+    cleared immediately, others are appended to outRanges to be cleared by the user.
+    Returns VK_INCOMPLETE if some free ranges are still not zeroed because of the limits.
+    */
+    VkResult ZeroFreeMemory(
+        VkDeviceSize& inoutMaxBytes,
+        size_t maxRangeCount,
+        VmaVector< VmaZeroFillRange, VmaStlAllocator<VmaZeroFillRange> >& outRanges);
+
+    // Markers are supported only by linear algorithm with single memory block.
+    VkResult GetMarker(VkDeviceSize* pMarker);
+    // Removes allocations made after marker and appends them to outAllocations.
+    // The caller must release the allocation objects.
+    VkResult Rewind(
+        VkDeviceSize marker,
+        VmaVector< VmaAllocation, VmaStlAllocator<VmaAllocation> >& outAllocations);
+    // Removes all allocations of linear algorithm and appends them to outAllocations.
+    // The caller must release the allocation objects. Memory blocks are kept.
+    VkResult Reset(VmaVector< VmaAllocation, VmaStlAllocator<VmaAllocation> >& outAllocations);
+
     // Saves results in pCtx->res.
     void Defragment(
         class VmaBlockVectorDefragmentationContext* pCtx,
@@ -7112,6 +9435,12 @@ private:
     const uint32_t m_FrameInUseCount;
     const bool m_ExplicitBlockSize;
     const uint32_t m_Algorithm;
+    // Host memory imported as the only block. Null for regular block vectors.
+    void* const m_pHostPointer;
+    // VkExternalMemoryHandleTypeFlagsKHR chained to allocation of every block. 0 for regular block vectors.
+    const VkFlags m_ExportHandleTypes;
+    // Priority that new and emptied blocks start with.
+    const float m_Priority;
     VMA_RW_MUTEX m_Mutex;
 
     /* There can be at most one allocation that is completely empty (except when minBlockCount > 0) -
@@ -7121,6 +9450,9 @@ private:
     VmaVector< VmaDeviceMemoryBlock*, VmaStlAllocator<VmaDeviceMemoryBlock*> > m_Blocks;
     uint32_t m_NextBlockId;
 
+    // Number of times size of a new block can be halved relative to preferred block size.
+    static const uint32_t NEW_BLOCK_SIZE_SHIFT_MAX = 3;
+
     VkDeviceSize CalcMaxBlockSize() const;
 
     // Finds and removes given block from vector.
@@ -7129,6 +9461,8 @@ private:
     // Performs single step in sorting m_Blocks. They may not be fully sorted
     // after this call.
     void IncrementallySortBlocks();
+    // Fully sorts m_Blocks, after many of them could have changed at once.
+    void SortBlocks();
 
     VkResult AllocatePage(
         uint32_t currentFrameIndex,
@@ -7138,6 +9472,10 @@ private:
         VmaSuballocationType suballocType,
         VmaAllocation* pAllocation);
 
+    // Returns true if allocation with given lifetime hint should be placed in given block
+    // without mixing it with allocations of different expected lifetime.
+    bool IsLifetimeCompatible(const VmaDeviceMemoryBlock* pBlock, VmaAllocationLifetime lifetime) const;
+
     // To be used only without CAN_MAKE_OTHER_LOST flag.
     VkResult AllocateFromBlock(
         VmaDeviceMemoryBlock* pBlock,
@@ -7146,10 +9484,45 @@ private:
         VkDeviceSize alignment,
         VmaAllocationCreateFlags allocFlags,
         void* pUserData,
+        VmaAllocationLifetime lifetime,
         VmaSuballocationType suballocType,
         uint32_t strategy,
         VmaAllocation* pAllocation);
 
+    // Used for VMA_ALLOCATION_CREATE_PAGES_SAME_BLOCK_BIT, VMA_ALLOCATION_CREATE_PAGES_CONTIGUOUS_BIT.
+    // On failure, pAllocations is left filled with null.
+    VkResult AllocatePagesInOneBlock(
+        uint32_t currentFrameIndex,
+        VkDeviceSize size,
+        VkDeviceSize alignment,
+        const VmaAllocationCreateInfo& createInfo,
+        VmaSuballocationType suballocType,
+        size_t allocationCount,
+        VmaAllocation* pAllocations);
+    // Allocates all pages as one run, every stride bytes, using single allocation request.
+    VkResult AllocateRunFromBlock(
+        VmaDeviceMemoryBlock* pBlock,
+        uint32_t currentFrameIndex,
+        VkDeviceSize size,
+        VkDeviceSize alignment,
+        VkDeviceSize stride,
+        const VmaAllocationCreateInfo& createInfo,
+        VmaSuballocationType suballocType,
+        uint32_t strategy,
+        size_t allocationCount,
+        VmaAllocation* pAllocations);
+    // Allocates pages one by one from given block. Makes none of them if not all fit.
+    VkResult AllocatePagesFromBlock(
+        VmaDeviceMemoryBlock* pBlock,
+        uint32_t currentFrameIndex,
+        VkDeviceSize size,
+        VkDeviceSize alignment,
+        const VmaAllocationCreateInfo& createInfo,
+        VmaSuballocationType suballocType,
+        uint32_t strategy,
+        size_t allocationCount,
+        VmaAllocation* pAllocations);
+
     VkResult CreateBlock(VkDeviceSize blockSize, size_t* pNewBlockIndex);
 
     // Saves result to pCtx->res.
@@ -7169,6 +9542,12 @@ private:
     void FreeEmptyBlocks(VmaDefragmentationStats* pDefragmentationStats);
 
     void UpdateHasEmptyBlock();
+
+    // Releases block resources of allocations just removed from metadata of pBlock by Rewind, Reset or FreeBatch.
+    void ReleaseRemovedAllocations(
+        VmaDeviceMemoryBlock* pBlock,
+        const VmaAllocation* pAllocations,
+        size_t allocationCount);
 };
 
 struct VmaPool_T
@@ -7189,6 +9568,17 @@ public:
     const char* GetName() const { return m_Name; }
     void SetName(const char* pName);
 
+    // Quota that memory blocks of this pool are charged to.
+    VmaQuota GetQuota() const { return m_Quota; }
+
+    // Index to VmaPublishedStats::pools, VMA_PUBLISHED_STATS_MAX_POOLS if none.
+    uint32_t GetPublishedStatsSlot() const { return m_PublishedStatsSlot; }
+    void SetPublishedStatsSlot(uint32_t slot) { m_PublishedStatsSlot = slot; }
+
+    // Used with VMA_RECORD_SELECTED_POOLS_ONLY_BIT.
+    bool IsRecordingEnabled() const { return m_RecordingEnabled.load() != 0; }
+    void SetRecordingEnabled(bool enabled) { m_RecordingEnabled.store(enabled ? 1 : 0); }
+
 #if VMA_STATS_STRING_ENABLED
     //void PrintDetailedMap(class VmaStringBuilder& sb);
 #endif
@@ -7196,6 +9586,264 @@ public:
 private:
     uint32_t m_Id;
     char* m_Name;
+    const VmaQuota m_Quota;
+    uint32_t m_PublishedStatsSlot;
+    VMA_ATOMIC_UINT32 m_RecordingEnabled;
+};
+
+/*
+Node of a tree of quotas. Usage is charged to the node and all its ancestors
+with atomic operations only, so quotas can be shared between threads without a lock.
+*/
+struct VmaQuota_T
+{
+    VMA_CLASS_NO_COPY(VmaQuota_T)
+public:
+    VmaQuota_T(VmaAllocator hAllocator, const VmaQuotaCreateInfo& createInfo);
+    ~VmaQuota_T();
+
+    VmaQuota GetParent() const { return m_Parent; }
+    const char* GetName() const { return m_Name; }
+    // Size that can still be charged to this quota alone, not considering its ancestors.
+    VkDeviceSize GetFreeSize() const
+    {
+        const VkDeviceSize usage = m_Usage.load();
+        return usage < m_Limit ? m_Limit - usage : 0;
+    }
+
+    // Charges size to this quota and its ancestors. If any of them would go over its limit,
+    // returns false and leaves all of them unchanged.
+    bool TryCharge(VkDeviceSize size);
+    void Release(VkDeviceSize size);
+
+    void GetStats(VmaQuotaStats& outStats) const;
+
+private:
+    const VmaAllocator m_hAllocator;
+    const VmaQuota m_Parent;
+    const VkDeviceSize m_Limit;
+    char* m_Name;
+    VMA_ATOMIC_UINT64 m_Usage;
+    VMA_ATOMIC_UINT64 m_PeakUsage;
+    VMA_ATOMIC_UINT32 m_OverLimitCount;
+    VMA_ATOMIC_UINT32 m_ChildCount;
+
+    bool TryChargeThis(VkDeviceSize size);
+};
+
+/*
+Set of allocations tagged with the same VmaAllocationScope.
+Each allocation stores its index in m_Allocations, so it can be removed in constant time.
+*/
+struct VmaAllocationScope_T
+{
+    VMA_CLASS_NO_COPY(VmaAllocationScope_T)
+public:
+    VmaAllocationScope_T(VmaAllocator hAllocator);
+    ~VmaAllocationScope_T();
+
+    void Add(const VmaAllocation* pAllocations, size_t allocationCount);
+    void Remove(VmaAllocation hAllocation);
+    // Detaches all allocations from this scope and appends them to outAllocations.
+    void DetachAll(VmaVector< VmaAllocation, VmaStlAllocator<VmaAllocation> >& outAllocations);
+
+private:
+    const bool m_UseMutex;
+    VMA_MUTEX m_Mutex;
+    VmaVector< VmaAllocation, VmaStlAllocator<VmaAllocation> > m_Allocations;
+};
+
+/*
+Persistently mapped buffer divided into frameInUseCount + 1 slices of equal size.
+Regions are allocated linearly from the slice of the current frame, so all regions
+of one frame form a single range that can be invalidated at once.
+*/
+struct VmaReadbackHeap_T
+{
+    VMA_CLASS_NO_COPY(VmaReadbackHeap_T)
+public:
+    VkBuffer m_Buffer;
+    VmaAllocation m_Allocation;
+
+    VmaReadbackHeap_T(VmaAllocator hAllocator, const VmaReadbackHeapCreateInfo& createInfo);
+    ~VmaReadbackHeap_T();
+
+    VkDeviceSize GetFrameSize() const { return m_FrameSize; }
+    uint32_t GetSliceCount() const { return (uint32_t)m_Slices.size(); }
+
+    VkResult Allocate(
+        uint32_t frameIndex,
+        VkDeviceSize size,
+        VkDeviceSize alignment,
+        VmaReadbackRegion& outRegion);
+    // Returns false if nothing was allocated in given frame or its slice has already been reused.
+    bool GetFrameRange(uint32_t frameIndex, VkDeviceSize& outOffset, VkDeviceSize& outSize);
+
+private:
+    struct Slice
+    {
+        uint32_t frameIndex; // VMA_FRAME_INDEX_LOST if never used.
+        VkDeviceSize usedSize;
+    };
+
+    const bool m_UseMutex;
+    const VkDeviceSize m_FrameSize;
+    VMA_MUTEX m_Mutex;
+    VmaVector< Slice, VmaStlAllocator<Slice> > m_Slices;
+};
+
+/*
+Sparse buffer divided into pages of equal size. Allocated ranges are kept sorted by
+offset and placed at the lowest free offset. Every page touched by at least one range
+has its own VkDeviceMemory, so the number of committed pages is limited by maxMemoryAllocationCount. Binding of pages whose memory changed is deferred until
+GatherBinds() is called, which is done for multiple buffers at once by
+VmaAllocator_T::SubmitSparseBinds(). Memory of unbound pages is retired and reused
+for other pages, or freed after frameInUseCount frames.
+*/
+struct VmaSparseBuffer_T
+{
+    VMA_CLASS_NO_COPY(VmaSparseBuffer_T)
+public:
+    VkBuffer m_Buffer;
+
+    VmaSparseBuffer_T(
+        VmaAllocator hAllocator,
+        const VmaSparseBufferCreateInfo& createInfo,
+        VkDeviceSize pageSize,
+        uint32_t pageCount,
+        uint32_t memoryTypeIndex);
+    // Frees all memory. Buffer must already be destroyed.
+    ~VmaSparseBuffer_T();
+
+    void GetInfo(VmaSparseBufferInfo& outInfo);
+
+    VkResult Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset);
+    void Free(VkDeviceSize offset);
+
+    void Lock() { if(m_UseMutex) m_Mutex.Lock(); }
+    void Unlock() { if(m_UseMutex) m_Mutex.Unlock(); }
+    // Must be called under Lock(). Appends binds for all pages whose memory changed since last ApplyBinds().
+    void GatherBinds(VmaVector< VkSparseMemoryBind, VmaStlAllocator<VkSparseMemoryBind> >& binds) const;
+    // Must be called under Lock(), after binds returned by GatherBinds() have been submitted.
+    void ApplyBinds(uint32_t currentFrameIndex);
+    // Must be called under Lock(). Frees memory retired at least frameInUseCount frames before currentFrameIndex.
+    void FreeRetiredMemory(uint32_t currentFrameIndex);
+
+private:
+    struct Range
+    {
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+    struct RangeOffsetLess
+    {
+        bool operator()(const Range& lhs, VkDeviceSize rhsOffset) const { return lhs.offset < rhsOffset; }
+    };
+    struct Page
+    {
+        // Memory that should be bound to the page. Null if the page has no ranges.
+        VkDeviceMemory memory;
+        // Memory that was bound to the page by the last submitted bind.
+        VkDeviceMemory boundMemory;
+        // Number of ranges overlapping the page.
+        uint32_t rangeCount;
+    };
+    struct RetiredMemory
+    {
+        VkDeviceMemory memory;
+        uint32_t frameIndex;
+    };
+
+    const VmaAllocator m_hAllocator;
+    const bool m_UseMutex;
+    const VkDeviceSize m_PageSize;
+    const uint32_t m_MemoryTypeIndex;
+    const uint32_t m_FrameInUseCount;
+    VMA_MUTEX m_Mutex;
+    VmaVector< Range, VmaStlAllocator<Range> > m_Ranges;
+    VmaVector< Page, VmaStlAllocator<Page> > m_Pages;
+    // Memory no longer bound to any page, oldest first.
+    VmaVector< RetiredMemory, VmaStlAllocator<RetiredMemory> > m_RetiredMemory;
+    VkDeviceSize m_AllocatedSize;
+    uint32_t m_CommittedPageCount;
+    uint32_t m_MemoryCount;
+
+    VkResult CommitPages(uint32_t firstPage, uint32_t lastPage);
+    void DecommitPages(uint32_t firstPage, uint32_t lastPage);
+    void RetireMemory(VkDeviceMemory memory, uint32_t frameIndex);
+};
+
+/*
+Pool of pages of equal size, suballocated from VkDeviceMemory blocks of pagesPerBlock pages.
+Free pages of each block are marked by bits set to 1 in a bitmap, stored for all
+blocks in a single array, wordsPerBlock words per block. Pages are not represented
+by any objects - they are identified by their memory and offset, so blocks are also
+indexed by their VkDeviceMemory handle. Slots of destroyed blocks have null memory and
+are reused by new blocks.
+*/
+struct VmaSparsePagePool_T
+{
+    VMA_CLASS_NO_COPY(VmaSparsePagePool_T)
+public:
+    VmaSparsePagePool_T(
+        VmaAllocator hAllocator,
+        const VmaSparsePagePoolCreateInfo& createInfo,
+        VkDeviceSize pageSize,
+        uint32_t pagesPerBlock,
+        uint32_t memoryTypeIndex);
+    ~VmaSparsePagePool_T();
+
+    void GetStats(VmaPoolStats& outStats);
+
+    // BindT is VkSparseImageMemoryBind or VkSparseMemoryBind.
+    template<typename BindT>
+    VkResult AllocatePages(uint32_t bindCount, BindT* pBinds);
+    template<typename BindT>
+    void FreePages(uint32_t bindCount, const BindT* pBinds);
+
+private:
+    struct Block
+    {
+        // Null if this slot is unused.
+        VkDeviceMemory memory;
+        uint32_t freePageCount;
+    };
+    struct BlockIndexItem
+    {
+        VkDeviceMemory memory;
+        size_t blockIndex;
+    };
+    struct BlockIndexItemMemoryLess
+    {
+        bool operator()(const BlockIndexItem& lhs, VkDeviceMemory rhsMemory) const { return lhs.memory < rhsMemory; }
+    };
+
+    const VmaAllocator m_hAllocator;
+    const bool m_UseMutex;
+    const VkDeviceSize m_PageSize;
+    const uint32_t m_PagesPerBlock;
+    const uint32_t m_WordsPerBlock;
+    const uint32_t m_MemoryTypeIndex;
+    const size_t m_MaxBlockCount;
+    VMA_MUTEX m_Mutex;
+    VmaVector< Block, VmaStlAllocator<Block> > m_Blocks;
+    VmaVector< uint64_t, VmaStlAllocator<uint64_t> > m_FreeBitmap;
+    // Existing blocks sorted by memory.
+    VmaVector< BlockIndexItem, VmaStlAllocator<BlockIndexItem> > m_BlockIndex;
+    // All blocks before this one have no free pages.
+    size_t m_FirstFreeBlockIndex;
+    size_t m_EmptyBlockCount;
+    size_t m_AllocatedPageCount;
+
+    VkDeviceSize GetBlockSize() const { return m_PageSize * m_PagesPerBlock; }
+    uint64_t* GetBlockBitmap(size_t blockIndex) { return m_FreeBitmap.data() + blockIndex * m_WordsPerBlock; }
+    bool BindFitsPage(const VkSparseMemoryBind& bind) const { return bind.size <= m_PageSize; }
+    // Extent of an image bind is in texels, so it can't be compared with page size without knowing the format.
+    bool BindFitsPage(const VkSparseImageMemoryBind&) const { return true; }
+    VkResult AllocatePage(VkDeviceMemory& outMemory, VkDeviceSize& outOffset);
+    void FreePage(VkDeviceMemory memory, VkDeviceSize offset);
+    VkResult CreateBlock(size_t& outBlockIndex);
+    void DestroyBlock(size_t blockIndex);
 };
 
 /*
@@ -7647,7 +10295,7 @@ private:
 class VmaRecorder
 {
 public:
-    VmaRecorder();
+    VmaRecorder(const VkAllocationCallbacks* pAllocationCallbacks);
     VkResult Init(const VmaRecordSettings& settings, bool useMutex);
     void WriteConfiguration(
         const VkPhysicalDeviceProperties& devProps,
@@ -7674,6 +10322,11 @@ public:
         const VmaAllocationCreateInfo& createInfo,
         uint64_t allocationCount,
         const VmaAllocation* pAllocations);
+    void RecordAllocateMemoryBatch(uint32_t frameIndex,
+        const VkMemoryRequirements* pVkMemoryRequirements,
+        const VmaAllocationCreateInfo* pCreateInfos,
+        uint64_t allocationCount,
+        const VmaAllocation* pAllocations);
     void RecordAllocateMemoryForBuffer(uint32_t frameIndex,
         const VkMemoryRequirements& vkMemReq,
         bool requiresDedicatedAllocation,
@@ -7691,6 +10344,9 @@ public:
     void RecordFreeMemoryPages(uint32_t frameIndex,
         uint64_t allocationCount,
         const VmaAllocation* pAllocations);
+    void RecordResizeAllocation(uint32_t frameIndex,
+        VmaAllocation allocation,
+        VkDeviceSize newSize);
     void RecordSetAllocationUserData(uint32_t frameIndex,
         VmaAllocation allocation,
         const void* pUserData);
@@ -7731,6 +10387,9 @@ public:
         VmaPool pool,
         const char* name);
 
+    // Writes header, configuration, objects created before the oldest call still in the ring buffer, and content of the ring buffer to a file.
+    VkResult Dump(const char* pFilePath);
+
 private:
     struct CallParams
     {
@@ -7749,30 +10408,102 @@ private:
         const char* m_Str;
     };
 
+    // Objects alive at the moment, tracked only when recording to the ring buffer.
+    // callIndex is the index of the call that created the object, counted like m_PushedCallCount.
+    struct LivePool
+    {
+        VmaPool pool;
+        uint64_t callIndex;
+        VmaPoolCreateInfo createInfo;
+    };
+    struct LiveAllocation
+    {
+        VmaAllocation allocation;
+        uint64_t callIndex;
+        VkDeviceSize size;
+        VkDeviceSize alignment;
+        VmaPool pool;
+        VmaAllocationCreateFlags flags;
+        float priority;
+        uint32_t memoryTypeIndex;
+        uint32_t lifetime;
+        uint32_t tag;
+        bool lost; // Created by vmaCreateLostAllocation(), other members are not used.
+    };
+
+    typedef VmaVector< char, VmaStlAllocator<char> > CharVectorType;
+    typedef VmaVector< size_t, VmaStlAllocator<size_t> > SizeVectorType;
+
+    const VkAllocationCallbacks* m_pAllocationCallbacks;
     bool m_UseMutex;
     VmaRecordFlags m_Flags;
+    // Filters from VmaRecordSettings.
+    uint32_t m_MemoryTypeBits;
+    VkDeviceSize m_MinAllocationSize;
+    VkDeviceSize m_MaxAllocationSize;
+    uint32_t m_AllocationSamplingRate;
     FILE* m_File;
     VMA_MUTEX m_FileMutex;
     std::chrono::time_point<std::chrono::high_resolution_clock> m_RecordingStartTime;
 
+    // Members used only when recording to the ring buffer, protected by m_FileMutex.
+    char* m_pFilePath;
+    char* m_pRingBuffer; // Null if recording to the file.
+    size_t m_RingBufferSize;
+    size_t m_RingBegin; // Offset of the oldest call.
+    size_t m_RingUsed; // Always a sum of whole calls.
+    // Sizes of calls in the ring buffer, oldest first, as a circular queue.
+    // A call may take more than one line, e.g. with VMA_RECORD_ALLOCATION_PLACEMENT_BIT.
+    SizeVectorType m_RingCallSizes;
+    size_t m_RingCallBegin;
+    size_t m_RingCallCount;
+    // All calls ever pushed, including evicted and skipped ones. The oldest call in the ring buffer has index m_PushedCallCount - m_RingCallCount.
+    uint64_t m_PushedCallCount;
+    VmaVector< LivePool, VmaStlAllocator<LivePool> > m_LivePools;
+    VmaVector< LiveAllocation, VmaStlAllocator<LiveAllocation> > m_LiveAllocations;
+    CharVectorType m_Header; // Header and configuration, written at the beginning of every dump.
+    CharVectorType m_CurrentCall; // Text of the call being recorded, moved to the ring buffer in Flush().
+    bool m_DumpedOnFailure;
+
+    static FILE* OpenFile(const char* pFilePath);
+    // Applies filters to a newly created allocation. If it shouldn't be recorded, marks it and returns false.
+    bool SelectAllocation(VmaAllocation allocation);
+    static bool IsRecorded(VmaAllocation allocation) { return allocation == VK_NULL_HANDLE || allocation->IsRecorded(); }
     void GetBasicParams(CallParams& outParams);
+    // Writes to m_File or m_CurrentCall.
+    void Printf(const char* format, ...);
 
-    // T must be a pointer type, e.g. VmaAllocation, VmaPool.
+    // T must be a pointer type, e.g. VmaPool. Use PrintAllocationList() for allocations.
     template<typename T>
     void PrintPointerList(uint64_t count, const T* pItems)
     {
+        static_assert(!std::is_same<T, VmaAllocation>::value, "Allocations must be filtered by PrintAllocationList().");
         if(count)
         {
-            fprintf(m_File, "%p", pItems[0]);
+            Printf("%p", pItems[0]);
             for(uint64_t i = 1; i < count; ++i)
             {
-                fprintf(m_File, " %p", pItems[i]);
+                Printf(" %p", pItems[i]);
             }
         }
     }
 
-    void PrintPointerList(uint64_t count, const VmaAllocation* pItems);
-    void Flush();
+    // Like PrintPointerList(), but omits allocations excluded by filters.
+    void PrintAllocationList(uint64_t count, const VmaAllocation* pItems);
+    // Writes AllocationPlacement line if enabled by VMA_RECORD_ALLOCATION_PLACEMENT_BIT.
+    void PrintPlacement(const CallParams& callParams, uint32_t frameIndex, VmaAllocation allocation);
+    // Called at the end of every recorded call. allocationFailed should be true if it was an allocation that failed.
+    void Flush(bool allocationFailed = false);
+    void PushCurrentCallToRingBuffer();
+    VkResult DumpRingBuffer(const char* pFilePath);
+    // Keep track of live objects for WriteSnapshot(). Do nothing when recording to the file.
+    void AddLivePool(const VmaPoolCreateInfo& createInfo, VmaPool pool);
+    void RemoveLivePool(VmaPool pool);
+    // Null pCreateInfo means the allocation was created by vmaCreateLostAllocation().
+    void AddLiveAllocation(VmaAllocation allocation, const VmaAllocationCreateInfo* pCreateInfo);
+    void RemoveLiveAllocation(VmaAllocation allocation);
+    // Writes live objects whose creating calls were evicted from the ring buffer as calls that create them.
+    void WriteSnapshot(FILE* file);
 };
 
 #endif // #if VMA_RECORDING_ENABLED
@@ -7843,44 +10574,173 @@ struct VmaCurrentBudgetData
     }
 };
 
-// Main allocator object.
-struct VmaAllocator_T
+/*
+Keeps VmaPublishedStats in memory provided by the user up to date, so it can be read by another process.
+Members of VmaPublishedStats are updated in place with atomic operations, so threads don't need a lock.
+Every update is bracketed by incrementing VmaPublishedStats::beginSequence and endSequence,
+which lets the reader detect updates in progress, also concurrent ones (seqlock with many writers).
+All methods do nothing if the memory was not provided.
+*/
+class VmaStatsPublisher
 {
-    VMA_CLASS_NO_COPY(VmaAllocator_T)
+    VMA_CLASS_NO_COPY(VmaStatsPublisher)
 public:
-    bool m_UseMutex;
-    uint32_t m_VulkanApiVersion;
-    bool m_UseKhrDedicatedAllocation; // Can be set only if m_VulkanApiVersion < VK_MAKE_VERSION(1, 1, 0).
-    bool m_UseKhrBindMemory2; // Can be set only if m_VulkanApiVersion < VK_MAKE_VERSION(1, 1, 0).
-    bool m_UseExtMemoryBudget;
-    bool m_UseAmdDeviceCoherentMemory;
-    bool m_UseKhrBufferDeviceAddress;
-    VkDevice m_hDevice;
-    VkInstance m_hInstance;
-    bool m_AllocationCallbacksSpecified;
-    VkAllocationCallbacks m_AllocationCallbacks;
-    VmaDeviceMemoryCallbacks m_DeviceMemoryCallbacks;
-    VmaAllocationObjectAllocator m_AllocationObjectAllocator;
-
-    // Each bit (1 << i) is set if HeapSizeLimit is enabled for that heap, so cannot allocate more than the heap size.
-    uint32_t m_HeapSizeLimitMask;
+    VmaStatsPublisher() : m_pStats(VMA_NULL) { }
+    void Init(void* pMemory, const VkPhysicalDeviceMemoryProperties& memProps);
+    // Clears the magic, so readers stop accepting the memory, and stops publishing.
+    void Invalidate();
 
-    VkPhysicalDeviceProperties m_PhysicalDeviceProperties;
-    VkPhysicalDeviceMemoryProperties m_MemProps;
+    bool IsEnabled() const { return m_pStats != VMA_NULL; }
 
-    // Default pools.
-    VmaBlockVector* m_pBlockVectors[VK_MAX_MEMORY_TYPES];
+    // Returns VMA_PUBLISHED_STATS_MAX_POOLS if all slots are taken or publishing is disabled.
+    uint32_t AcquirePoolSlot(uint32_t memTypeIndex);
+    void SetPoolId(uint32_t slot, uint32_t poolId);
+    void ReleasePoolSlot(uint32_t slot);
 
-    // Each vector is sorted by memory (handle value).
-    typedef VmaVector< VmaAllocation, VmaStlAllocator<VmaAllocation> > AllocationVectorType;
-    AllocationVectorType* m_pDedicatedAllocations[VK_MAX_MEMORY_TYPES];
-    VMA_RW_MUTEX m_DedicatedAllocationsMutex[VK_MAX_MEMORY_TYPES];
+    // In all Update* functions, size 0 means that the object doesn't exist before or after the change.
+    void UpdateDeviceMemory(uint32_t memTypeIndex, uint32_t heapIndex, VkDeviceSize oldSize, VkDeviceSize newSize);
+    void UpdatePoolBlock(uint32_t poolSlot, VkDeviceSize oldSize, VkDeviceSize newSize);
+    void UpdateAllocation(uint32_t memTypeIndex, uint32_t heapIndex, uint32_t poolSlot, VkDeviceSize oldSize, VkDeviceSize newSize);
+    void UpdateBudget(uint32_t heapIndex, VkDeviceSize usage, VkDeviceSize budget);
 
-    VmaCurrentBudgetData m_Budget;
+private:
+    VmaPublishedStats* m_pStats;
+
+    void BeginWrite();
+    void EndWrite();
+    static void UpdateCounters(uint64_t& count, uint64_t& bytes, VkDeviceSize oldSize, VkDeviceSize newSize);
+    // VmaPublishedStats contains only plain integers, to be readable by any process.
+    static VMA_ATOMIC_UINT32& AsAtomic(uint32_t& value);
+    static VMA_ATOMIC_UINT64& AsAtomic(uint64_t& value);
+};
 
-    VmaAllocator_T(const VmaAllocatorCreateInfo* pCreateInfo);
-    VkResult Init(const VmaAllocatorCreateInfo* pCreateInfo);
-    ~VmaAllocator_T();
+// Counters of allocations per VmaAllocationCreateInfo::tag and memory type, updated only with atomic operations.
+struct VmaTagStatistics
+{
+    VMA_ATOMIC_UINT32 m_AllocationCount[VMA_ALLOCATION_TAG_COUNT][VK_MAX_MEMORY_TYPES];
+    VMA_ATOMIC_UINT64 m_AllocationBytes[VMA_ALLOCATION_TAG_COUNT][VK_MAX_MEMORY_TYPES];
+    VMA_ATOMIC_UINT64 m_PeakAllocationBytes[VMA_ALLOCATION_TAG_COUNT][VK_MAX_MEMORY_TYPES];
+
+    VmaTagStatistics()
+    {
+        for(uint32_t tag = 0; tag < VMA_ALLOCATION_TAG_COUNT; ++tag)
+        {
+            for(uint32_t memTypeIndex = 0; memTypeIndex < VK_MAX_MEMORY_TYPES; ++memTypeIndex)
+            {
+                m_AllocationCount[tag][memTypeIndex] = 0;
+                m_AllocationBytes[tag][memTypeIndex] = 0;
+                m_PeakAllocationBytes[tag][memTypeIndex] = 0;
+            }
+        }
+    }
+
+    void AddAllocation(uint32_t tag, uint32_t memTypeIndex, VkDeviceSize allocationSize)
+    {
+        m_AllocationCount[tag][memTypeIndex].fetch_add(1);
+        UpdatePeak(tag, memTypeIndex, m_AllocationBytes[tag][memTypeIndex].fetch_add(allocationSize) + allocationSize);
+    }
+
+    void RemoveAllocation(uint32_t tag, uint32_t memTypeIndex, VkDeviceSize allocationSize)
+    {
+        // Allocations created by vmaCreateLostAllocation() have size 0 and were never counted.
+        if(allocationSize == 0)
+        {
+            return;
+        }
+        VMA_ASSERT(m_AllocationCount[tag][memTypeIndex].load() > 0 && m_AllocationBytes[tag][memTypeIndex].load() >= allocationSize);
+        m_AllocationCount[tag][memTypeIndex].fetch_sub(1);
+        m_AllocationBytes[tag][memTypeIndex].fetch_sub(allocationSize);
+    }
+
+    void ResizeAllocation(uint32_t tag, uint32_t memTypeIndex, VkDeviceSize oldSize, VkDeviceSize newSize)
+    {
+        if(newSize > oldSize)
+        {
+            UpdatePeak(tag, memTypeIndex, m_AllocationBytes[tag][memTypeIndex].fetch_add(newSize - oldSize) + newSize - oldSize);
+        }
+        else
+        {
+            m_AllocationBytes[tag][memTypeIndex].fetch_sub(oldSize - newSize);
+        }
+    }
+
+    void GetStats(uint32_t tag, uint32_t memTypeCount, VmaAllocationTagStats& outStats) const
+    {
+        memset(&outStats, 0, sizeof(outStats));
+        for(uint32_t memTypeIndex = 0; memTypeIndex < memTypeCount; ++memTypeIndex)
+        {
+            outStats.allocationCount[memTypeIndex] = m_AllocationCount[tag][memTypeIndex].load();
+            outStats.allocationBytes[memTypeIndex] = m_AllocationBytes[tag][memTypeIndex].load();
+            outStats.peakAllocationBytes[memTypeIndex] = m_PeakAllocationBytes[tag][memTypeIndex].load();
+        }
+    }
+
+private:
+    void UpdatePeak(uint32_t tag, uint32_t memTypeIndex, uint64_t allocationBytes)
+    {
+        uint64_t peak = m_PeakAllocationBytes[tag][memTypeIndex].load();
+        while(peak < allocationBytes && !m_PeakAllocationBytes[tag][memTypeIndex].compare_exchange_weak(peak, allocationBytes))
+        {
+        }
+    }
+};
+
+// Buffer, image and/or allocation waiting for destruction until GPU reaches completionValue.
+struct VmaDeferredDestruction
+{
+    uint64_t completionValue;
+    VkBuffer buffer;
+    VkImage image;
+    VmaAllocation allocation;
+};
+
+// Main allocator object.
+struct VmaAllocator_T
+{
+    VMA_CLASS_NO_COPY(VmaAllocator_T)
+public:
+    bool m_UseMutex;
+    uint32_t m_VulkanApiVersion;
+    bool m_UseKhrDedicatedAllocation; // Can be set only if m_VulkanApiVersion < VK_MAKE_VERSION(1, 1, 0).
+    bool m_UseKhrBindMemory2; // Can be set only if m_VulkanApiVersion < VK_MAKE_VERSION(1, 1, 0).
+    bool m_UseExtMemoryBudget;
+    bool m_UseAmdDeviceCoherentMemory;
+    bool m_UseKhrBufferDeviceAddress;
+    bool m_UseExtExternalMemoryHost;
+    bool m_UseExtMemoryPriority;
+    bool m_UseExtPageableDeviceLocalMemory;
+    VkDevice m_hDevice;
+    VkInstance m_hInstance;
+    bool m_AllocationCallbacksSpecified;
+    VkAllocationCallbacks m_AllocationCallbacks;
+    VmaDeviceMemoryCallbacks m_DeviceMemoryCallbacks;
+    VmaAllocationObjectAllocator m_AllocationObjectAllocator;
+
+    // Each bit (1 << i) is set if HeapSizeLimit is enabled for that heap, so cannot allocate more than the heap size.
+    uint32_t m_HeapSizeLimitMask;
+
+    VkPhysicalDeviceProperties m_PhysicalDeviceProperties;
+    VkPhysicalDeviceMemoryProperties m_MemProps;
+#if VMA_EXTERNAL_MEMORY_HOST
+    // VkPhysicalDeviceExternalMemoryHostPropertiesEXT::minImportedHostPointerAlignment, 1 if the extension is not used.
+    VkDeviceSize m_MinImportedHostPointerAlignment;
+#endif
+
+    // Default pools.
+    VmaBlockVector* m_pBlockVectors[VK_MAX_MEMORY_TYPES];
+
+    // Each vector is sorted by memory (handle value).
+    typedef VmaVector< VmaAllocation, VmaStlAllocator<VmaAllocation> > AllocationVectorType;
+    AllocationVectorType* m_pDedicatedAllocations[VK_MAX_MEMORY_TYPES];
+    VMA_RW_MUTEX m_DedicatedAllocationsMutex[VK_MAX_MEMORY_TYPES];
+
+    VmaCurrentBudgetData m_Budget;
+    VmaTagStatistics m_TagStats;
+    VmaStatsPublisher m_StatsPublisher;
+
+    VmaAllocator_T(const VmaAllocatorCreateInfo* pCreateInfo);
+    VkResult Init(const VmaAllocatorCreateInfo* pCreateInfo);
+    ~VmaAllocator_T();
 
     const VkAllocationCallbacks* GetAllocationCallbacks() const
     {
@@ -7956,16 +10816,55 @@ public:
         VmaSuballocationType suballocType,
         size_t allocationCount,
         VmaAllocation* pAllocations);
+    // Allocations with different parameters, all or none.
+    VkResult AllocateMemoryBatch(
+        const VkMemoryRequirements* pVkMemoryRequirements,
+        const VmaAllocationCreateInfo* pCreateInfos,
+        size_t allocationCount,
+        VmaAllocation* pAllocations);
+    // Simulates AllocateMemory() for multiple allocations without changing anything.
+    VkResult CheckAllocationsFit(
+        const VkMemoryRequirements* pVkMemoryRequirements,
+        const VmaAllocationCreateInfo* pCreateInfos,
+        size_t allocationCount,
+        VmaAllocationFitPlacement* pPlacements,
+        VmaAllocationFitInfo* pFitInfo);
+
+    VkResult FindAllocationByMemory(VkDeviceMemory memory, VkDeviceSize offset, VmaAllocation* pAllocation);
 
     // Main deallocation function.
     void FreeMemory(
         size_t allocationCount,
         const VmaAllocation* pAllocations);
+    // Frees allocations grouped by block vector and block, locking each block vector once.
+    void FreeMemoryBatch(
+        size_t allocationCount,
+        const VmaAllocation* pAllocations);
 
     VkResult ResizeAllocation(
         const VmaAllocation alloc,
         VkDeviceSize newSize);
 
+    VkResult BalanceBarMemory(
+        const VmaBarBalanceInfo& info,
+        uint32_t* pMoveCount,
+        VmaBarMove* pMoves);
+
+    // Fills parameters for new allocation made by vmaReallocateMemory() when resizing in place failed.
+    void GetReallocationParams(
+        const VmaAllocation alloc,
+        VkDeviceSize newSize,
+        const VmaAllocationCreateInfo* pCreateInfo,
+        VkMemoryRequirements& outMemReq,
+        VmaAllocationCreateInfo& outCreateInfo) const;
+    // True if contents of the allocation can be read and written on the CPU using Map().
+    bool IsAllocationHostAccessible(const VmaAllocation alloc) const;
+    // Copies first `size` bytes between two host-accessible allocations using Map(), Invalidate, Flush.
+    VkResult CopyAllocationData(
+        VmaAllocation srcAlloc,
+        VmaAllocation dstAlloc,
+        VkDeviceSize size);
+
     void CalculateStats(VmaStats* pStats);
 
     void GetBudget(
@@ -7989,12 +10888,60 @@ public:
         VmaDefragmentationContext context);
 
     void GetAllocationInfo(VmaAllocation hAllocation, VmaAllocationInfo* pAllocationInfo);
+#if VMA_EXTERNAL_MEMORY
+    VkResult GetAllocationExportInfo(VmaAllocation hAllocation, VmaAllocationExportInfo* pExportInfo);
+#endif
     bool TouchAllocation(VmaAllocation hAllocation);
+    // Remembers that memory of the allocation is used in current frame, for UpdateMemoryPriorities().
+    void MarkMemoryUsed(VmaAllocation hAllocation);
 
     VkResult CreatePool(const VmaPoolCreateInfo* pCreateInfo, VmaPool* pPool);
     void DestroyPool(VmaPool pool);
     void GetPoolStats(VmaPool pool, VmaPoolStats* pPoolStats);
 
+    VkResult CreateAllocationScope(VmaAllocationScope* pScope);
+    void DestroyAllocationScope(VmaAllocationScope scope);
+
+    VkResult CreateQuota(const VmaQuotaCreateInfo* pCreateInfo, VmaQuota* pQuota);
+    void DestroyQuota(VmaQuota quota);
+
+    // Assigns tag and lifetime from createInfo to new allocations and adds them to m_TagStats.
+    void AddTaggedAllocations(const VmaAllocationCreateInfo& createInfo, size_t allocationCount, const VmaAllocation* pAllocations);
+    // Reflects new, resized or freed allocation in m_StatsPublisher. Size 0 means that it doesn't exist before or after.
+    void PublishAllocationSize(VmaAllocation allocation, VkDeviceSize oldSize, VkDeviceSize newSize);
+
+    void DeferDestruction(
+        uint64_t completionValue,
+        VkBuffer buffer,
+        VkImage image,
+        VmaAllocation allocation);
+    // Returns number of processed entries.
+    size_t ProcessDeferredDestructions(uint64_t completedValue);
+
+    VkResult CreateReadbackHeap(
+        const VmaReadbackHeapCreateInfo& createInfo,
+        VmaReadbackHeap* pHeap,
+        VmaAllocationInfo* pAllocationInfo);
+    void DestroyReadbackHeap(VmaReadbackHeap heap);
+    VkResult InvalidateReadbackHeaps(
+        uint32_t heapCount,
+        const VmaReadbackHeap* pHeaps,
+        uint32_t frameIndex);
+
+    VkResult CreateSparseBuffer(
+        const VmaSparseBufferCreateInfo& createInfo,
+        VmaSparseBuffer* pSparseBuffer);
+    void DestroySparseBuffer(VmaSparseBuffer sparseBuffer);
+    VkResult SubmitSparseBinds(
+        uint32_t sparseBufferCount,
+        const VmaSparseBuffer* pSparseBuffers,
+        const VmaSparseBindSubmitInfo& submitInfo);
+
+    VkResult CreateSparsePagePool(
+        const VmaSparsePagePoolCreateInfo& createInfo,
+        VmaSparsePagePool* pPool);
+    void DestroySparsePagePool(VmaSparsePagePool pool);
+
     void SetCurrentFrameIndex(uint32_t frameIndex);
     uint32_t GetCurrentFrameIndex() const { return m_CurrentFrameIndex.load(); }
 
@@ -8002,8 +10949,17 @@ public:
         VmaPool hPool,
         size_t* pLostAllocationCount);
     VkResult CheckPoolCorruption(VmaPool hPool);
+    VkResult GetPoolMarker(VmaPool hPool, VkDeviceSize* pMarker);
+    VkResult RewindPool(VmaPool hPool, VkDeviceSize marker);
+    VkResult ResetPool(VmaPool hPool);
     VkResult CheckCorruption(uint32_t memoryTypeBits);
 
+    VkResult ZeroFreeMemory(
+        VmaPool pool,
+        VkDeviceSize maxBytes,
+        uint32_t* pRangeCount,
+        VmaZeroFillRange* pRanges);
+
     void CreateLostAllocation(VmaAllocation* pAllocation);
 
     // Call to Vulkan function vkAllocateMemory with accompanying bookkeeping.
@@ -8067,6 +11023,10 @@ private:
     VmaVector<VmaPool, VmaStlAllocator<VmaPool> > m_Pools;
     uint32_t m_NextPoolId;
 
+    VMA_MUTEX m_DeferredDestructionsMutex;
+    // Protected by m_DeferredDestructionsMutex. In order of submission.
+    VmaVector<VmaDeferredDestruction, VmaStlAllocator<VmaDeferredDestruction> > m_DeferredDestructions;
+
     VmaVulkanFunctions m_VulkanFunctions;
 
     // Global bit mask AND-ed with any memoryTypeBits to disallow certain memory types.
@@ -8112,8 +11072,10 @@ private:
         uint32_t memTypeIndex,
         const VkMemoryAllocateInfo& allocInfo,
         bool map,
+        bool zeroed,
         bool isUserDataString,
         void* pUserData,
+        float priority,
         VmaAllocation* pAllocation);
 
     // Allocates and registers new VkDeviceMemory specifically for dedicated allocations.
@@ -8123,8 +11085,10 @@ private:
         uint32_t memTypeIndex,
         bool withinBudget,
         bool map,
+        bool zeroed,
         bool isUserDataString,
         void* pUserData,
+        float priority,
         VkBuffer dedicatedBuffer,
         VkBufferUsageFlags dedicatedBufferUsage,
         VkImage dedicatedImage,
@@ -8133,6 +11097,37 @@ private:
 
     void FreeDedicatedMemory(const VmaAllocation allocation);
 
+    /*
+    Common last step of all ways of freeing an allocation, after its memory has been released from the block
+    or as dedicated memory, or the allocation is lost: removes it from its scope, budget, statistics and quota,
+    frees its user data and destroys the allocation object.
+    */
+    void DestroyAllocationObject(VmaAllocation allocation);
+
+    // Destroys allocation objects already removed from their memory blocks by rewinding or resetting a pool.
+    void FreeRemovedAllocations(const AllocationVectorType& allocations);
+
+    typedef VmaVector< VmaDeferredDestruction, VmaStlAllocator<VmaDeferredDestruction> > DeferredDestructionVectorType;
+    /*
+    If hPool is null, moves entries with completionValue <= completedValue to outEntries.
+    Otherwise moves all entries with allocations made from hPool, regardless of their completion value.
+    */
+    void ExtractDeferredDestructions(
+        uint64_t completedValue,
+        VmaPool hPool,
+        DeferredDestructionVectorType& outEntries);
+    void DestroyDeferred(const DeferredDestructionVectorType& entries);
+
+    // Makes new allocation for srcAllocation in one of given memory types, for vmaBalanceBarMemory().
+    VkResult AllocateBarMove(
+        VmaAllocation srcAllocation,
+        uint32_t memoryTypeBits,
+        bool promote,
+        VmaAllocation* pDstAllocation);
+
+    // Checks whether VmaPoolCreateInfo::pHostPointer can be imported into memory type of the pool.
+    VkResult CheckHostPointerImport(const VmaPoolCreateInfo& createInfo) const;
+
     /*
     Calculates and returns bit mask of memory types that can support defragmentation
     on GPU as they support creation of required buffer for copy operations.
@@ -8149,6 +11144,10 @@ private:
 #if VMA_MEMORY_BUDGET
     void UpdateVulkanBudget();
 #endif // #if VMA_MEMORY_BUDGET
+
+#if VMA_PAGEABLE_DEVICE_LOCAL_MEMORY
+    void UpdateMemoryPriorities(uint32_t currentFrameIndex);
+#endif
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -8605,6 +11604,12 @@ void VmaAllocation_T::ChangeOffset(VkDeviceSize newOffset)
     m_BlockAllocation.m_Offset = newOffset;
 }
 
+void VmaAllocation_T::ChangeSize(VkDeviceSize newSize)
+{
+    VMA_ASSERT(m_Type == ALLOCATION_TYPE_BLOCK && newSize > 0);
+    m_Size = newSize;
+}
+
 VkDeviceSize VmaAllocation_T::GetOffset() const
 {
     switch(m_Type)
@@ -8724,6 +11729,12 @@ void VmaAllocation_T::PrintParameters(class VmaJsonWriter& json) const
     json.WriteString("Size");
     json.WriteNumber(m_Size);
 
+    if(m_Tag != 0)
+    {
+        json.WriteString("Tag");
+        json.WriteNumber((uint32_t)m_Tag);
+    }
+
     if(m_pUserData != VMA_NULL)
     {
         json.WriteString("UserData");
@@ -9068,6 +12079,10 @@ bool VmaBlockMetadata_Generic::Validate() const
 
             // Margin required between allocations - every free space must be at least that large.
             VMA_VALIDATE(subAlloc.size >= VMA_DEBUG_MARGIN);
+
+            VMA_VALIDATE(subAlloc.zeroedBegin <= subAlloc.zeroedEnd);
+            VMA_VALIDATE(subAlloc.zeroedBegin == subAlloc.zeroedEnd ||
+                (subAlloc.zeroedBegin >= subAlloc.offset && subAlloc.zeroedEnd <= subAlloc.offset + subAlloc.size));
         }
         else
         {
@@ -9170,6 +12185,21 @@ void VmaBlockMetadata_Generic::AddPoolStats(VmaPoolStats& inoutStats) const
     inoutStats.unusedRangeSizeMax = VMA_MAX(inoutStats.unusedRangeSizeMax, GetUnusedRangeSizeMax());
 }
 
+VmaAllocation VmaBlockMetadata_Generic::FindAllocationAt(VkDeviceSize offset) const
+{
+    for(VmaSuballocationList::const_iterator suballocItem = m_Suballocations.cbegin();
+        suballocItem != m_Suballocations.cend() && suballocItem->offset <= offset;
+        ++suballocItem)
+    {
+        if(offset < suballocItem->offset + suballocItem->size)
+        {
+            // Null for free suballocation.
+            return suballocItem->hAllocation;
+        }
+    }
+    return VK_NULL_HANDLE;
+}
+
 #if VMA_STATS_STRING_ENABLED
 
 void VmaBlockMetadata_Generic::PrintDetailedMap(class VmaJsonWriter& json) const
@@ -9260,6 +12290,52 @@ bool VmaBlockMetadata_Generic::CreateAllocationRequest(
                 }
             }
         }
+        else if(strategy == VMA_ALLOCATION_INTERNAL_STRATEGY_ZEROED)
+        {
+            // Same as best fit, but accept only places that are already known to contain zeros.
+            VmaSuballocationList::iterator* const it = VmaBinaryFindFirstNotLess(
+                m_FreeSuballocationsBySize.data(),
+                m_FreeSuballocationsBySize.data() + freeSuballocCount,
+                allocSize + 2 * VMA_DEBUG_MARGIN,
+                VmaSuballocationItemSizeLess());
+            size_t index = it - m_FreeSuballocationsBySize.data();
+            for(; index < freeSuballocCount; ++index)
+            {
+                const VmaSuballocationList::iterator freeSuballocItem = m_FreeSuballocationsBySize[index];
+                if(freeSuballocItem->zeroedEnd - freeSuballocItem->zeroedBegin >= allocSize &&
+                    CheckAllocation(
+                        currentFrameIndex,
+                        frameInUseCount,
+                        bufferImageGranularity,
+                        allocSize,
+                        allocAlignment,
+                        allocType,
+                        freeSuballocItem,
+                        false, // canMakeOtherLost
+                        &pAllocationRequest->offset,
+                        &pAllocationRequest->itemsToMakeLostCount,
+                        &pAllocationRequest->sumFreeSize,
+                        &pAllocationRequest->sumItemSize))
+                {
+                    // Zeroed range may be at the end of this free suballocation.
+                    if(!VmaIsSuballocationRangeZeroed(*freeSuballocItem, pAllocationRequest->offset, allocSize))
+                    {
+                        pAllocationRequest->offset = CalcUpperOffset(
+                            bufferImageGranularity,
+                            allocSize,
+                            allocAlignment,
+                            allocType,
+                            freeSuballocItem,
+                            pAllocationRequest->offset);
+                    }
+                    if(VmaIsSuballocationRangeZeroed(*freeSuballocItem, pAllocationRequest->offset, allocSize))
+                    {
+                        pAllocationRequest->item = freeSuballocItem;
+                        return true;
+                    }
+                }
+            }
+        }
         else if(strategy == VMA_ALLOCATION_INTERNAL_STRATEGY_MIN_OFFSET)
         {
             for(VmaSuballocationList::iterator it = m_Suballocations.begin();
@@ -9285,6 +12361,40 @@ bool VmaBlockMetadata_Generic::CreateAllocationRequest(
                 }
             }
         }
+        else if(strategy == VMA_ALLOCATION_INTERNAL_STRATEGY_MAX_OFFSET)
+        {
+            // Search starting from the end of the block and place the allocation
+            // at the end of the free suballocation found.
+            VmaSuballocationList::iterator it = m_Suballocations.end();
+            while(it != m_Suballocations.begin())
+            {
+                --it;
+                if(it->type == VMA_SUBALLOCATION_TYPE_FREE && CheckAllocation(
+                    currentFrameIndex,
+                    frameInUseCount,
+                    bufferImageGranularity,
+                    allocSize,
+                    allocAlignment,
+                    allocType,
+                    it,
+                    false, // canMakeOtherLost
+                    &pAllocationRequest->offset,
+                    &pAllocationRequest->itemsToMakeLostCount,
+                    &pAllocationRequest->sumFreeSize,
+                    &pAllocationRequest->sumItemSize))
+                {
+                    pAllocationRequest->item = it;
+                    pAllocationRequest->offset = CalcUpperOffset(
+                        bufferImageGranularity,
+                        allocSize,
+                        allocAlignment,
+                        allocType,
+                        it,
+                        pAllocationRequest->offset);
+                    return true;
+                }
+            }
+        }
         else // WORST_FIT, FIRST_FIT
         {
             // Search staring from biggest suballocations.
@@ -9453,6 +12563,8 @@ void VmaBlockMetadata_Generic::Alloc(
     const VkDeviceSize paddingBegin = request.offset - suballoc.offset;
     VMA_ASSERT(suballoc.size >= paddingBegin + allocSize);
     const VkDeviceSize paddingEnd = suballoc.size - paddingBegin - allocSize;
+    const VkDeviceSize zeroedBegin = suballoc.zeroedBegin;
+    const VkDeviceSize zeroedEnd = suballoc.zeroedEnd;
 
     // Unregister this free suballocation from m_FreeSuballocationsBySize and update
     // it to become used.
@@ -9462,6 +12574,7 @@ void VmaBlockMetadata_Generic::Alloc(
     suballoc.size = allocSize;
     suballoc.type = type;
     suballoc.hAllocation = hAllocation;
+    suballoc.zeroedBegin = suballoc.zeroedEnd = 0;
 
     // If there are any free bytes remaining at the end, insert new free suballocation after current one.
     if(paddingEnd)
@@ -9470,6 +12583,9 @@ void VmaBlockMetadata_Generic::Alloc(
         paddingSuballoc.offset = request.offset + allocSize;
         paddingSuballoc.size = paddingEnd;
         paddingSuballoc.type = VMA_SUBALLOCATION_TYPE_FREE;
+        paddingSuballoc.zeroedBegin = zeroedBegin;
+        paddingSuballoc.zeroedEnd = zeroedEnd;
+        VmaClipSuballocationZeroedRange(paddingSuballoc);
         VmaSuballocationList::iterator next = request.item;
         ++next;
         const VmaSuballocationList::iterator paddingEndItem =
@@ -9484,6 +12600,9 @@ void VmaBlockMetadata_Generic::Alloc(
         paddingSuballoc.offset = request.offset - paddingBegin;
         paddingSuballoc.size = paddingBegin;
         paddingSuballoc.type = VMA_SUBALLOCATION_TYPE_FREE;
+        paddingSuballoc.zeroedBegin = zeroedBegin;
+        paddingSuballoc.zeroedEnd = zeroedEnd;
+        VmaClipSuballocationZeroedRange(paddingSuballoc);
         const VmaSuballocationList::iterator paddingBeginItem =
             m_Suballocations.insert(request.item, paddingSuballoc);
         RegisterFreeSuballocation(paddingBeginItem);
@@ -9502,6 +12621,66 @@ void VmaBlockMetadata_Generic::Alloc(
     m_SumFreeSize -= allocSize;
 }
 
+void VmaBlockMetadata_Generic::AllocPages(
+    const VmaAllocationRequest& request,
+    VmaSuballocationType type,
+    VkDeviceSize allocSize,
+    VkDeviceSize stride,
+    size_t allocationCount,
+    const VmaAllocation* pAllocations)
+{
+    VMA_ASSERT(request.type == VmaAllocationRequestType::Normal);
+    VMA_ASSERT(request.item != m_Suballocations.end());
+    VMA_ASSERT(allocationCount > 0 && stride >= allocSize);
+    // Given suballocation is a free block.
+    VMA_ASSERT(request.item->type == VMA_SUBALLOCATION_TYPE_FREE);
+    const VmaSuballocation freeSuballoc = *request.item;
+    const VkDeviceSize freeEnd = freeSuballoc.offset + freeSuballoc.size;
+    // Given range is inside this suballocation.
+    VMA_ASSERT(request.offset >= freeSuballoc.offset);
+    VMA_ASSERT(request.offset + stride * (allocationCount - 1) + allocSize <= freeEnd);
+
+    // Replace the free suballocation with all the new ones at once, instead of splitting
+    // what remains of it again for every page.
+    UnregisterFreeSuballocation(request.item);
+    VmaSuballocationList::iterator nextItem = request.item;
+    ++nextItem;
+    m_Suballocations.erase(request.item);
+    --m_FreeCount;
+
+    VkDeviceSize currOffset = freeSuballoc.offset;
+    for(size_t allocIndex = 0; allocIndex <= allocationCount; ++allocIndex)
+    {
+        // Past the last page, fill the rest of the original free range.
+        const VkDeviceSize pageOffset = allocIndex < allocationCount ?
+            request.offset + stride * allocIndex : freeEnd;
+        if(pageOffset > currOffset)
+        {
+            VmaSuballocation paddingSuballoc = {};
+            paddingSuballoc.offset = currOffset;
+            paddingSuballoc.size = pageOffset - currOffset;
+            paddingSuballoc.type = VMA_SUBALLOCATION_TYPE_FREE;
+            paddingSuballoc.zeroedBegin = freeSuballoc.zeroedBegin;
+            paddingSuballoc.zeroedEnd = freeSuballoc.zeroedEnd;
+            VmaClipSuballocationZeroedRange(paddingSuballoc);
+            RegisterFreeSuballocation(m_Suballocations.insert(nextItem, paddingSuballoc));
+            ++m_FreeCount;
+        }
+        if(allocIndex < allocationCount)
+        {
+            VmaSuballocation pageSuballoc = {};
+            pageSuballoc.offset = pageOffset;
+            pageSuballoc.size = allocSize;
+            pageSuballoc.type = type;
+            pageSuballoc.hAllocation = pAllocations[allocIndex];
+            m_Suballocations.insert(nextItem, pageSuballoc);
+            currOffset = pageOffset + allocSize;
+        }
+    }
+
+    m_SumFreeSize -= allocSize * allocationCount;
+}
+
 void VmaBlockMetadata_Generic::Free(const VmaAllocation allocation)
 {
     for(VmaSuballocationList::iterator suballocItem = m_Suballocations.begin();
@@ -9519,6 +12698,60 @@ void VmaBlockMetadata_Generic::Free(const VmaAllocation allocation)
     VMA_ASSERT(0 && "Not found!");
 }
 
+void VmaBlockMetadata_Generic::FreeBatch(const VmaAllocation* pAllocations, size_t allocationCount)
+{
+    if(allocationCount == 0)
+    {
+        return;
+    }
+
+    // Mark all suballocations as free in a single pass over the list.
+    size_t allocIndex = 0;
+    for(VmaSuballocationList::iterator suballocItem = m_Suballocations.begin();
+        suballocItem != m_Suballocations.end() && allocIndex < allocationCount;
+        ++suballocItem)
+    {
+        VmaSuballocation& suballoc = *suballocItem;
+        if(suballoc.hAllocation == pAllocations[allocIndex])
+        {
+            suballoc.type = VMA_SUBALLOCATION_TYPE_FREE;
+            suballoc.hAllocation = VK_NULL_HANDLE;
+            suballoc.zeroedBegin = suballoc.zeroedEnd = suballoc.offset;
+            ++m_FreeCount;
+            m_SumFreeSize += suballoc.size;
+            ++allocIndex;
+        }
+    }
+    VMA_ASSERT(allocIndex == allocationCount && "Not found or not sorted by offset!");
+
+    // Merge neighboring free suballocations and build m_FreeSuballocationsBySize once,
+    // instead of updating it after every single free.
+    m_FreeSuballocationsBySize.clear();
+    for(VmaSuballocationList::iterator suballocItem = m_Suballocations.begin();
+        suballocItem != m_Suballocations.end();
+        ++suballocItem)
+    {
+        if(suballocItem->type == VMA_SUBALLOCATION_TYPE_FREE)
+        {
+            VmaSuballocationList::iterator nextItem = suballocItem;
+            ++nextItem;
+            while(nextItem != m_Suballocations.end() && nextItem->type == VMA_SUBALLOCATION_TYPE_FREE)
+            {
+                MergeFreeWithNext(suballocItem);
+                nextItem = suballocItem;
+                ++nextItem;
+            }
+            if(suballocItem->size >= VMA_MIN_FREE_SUBALLOCATION_SIZE_TO_REGISTER)
+            {
+                m_FreeSuballocationsBySize.push_back(suballocItem);
+            }
+        }
+    }
+    VMA_SORT(m_FreeSuballocationsBySize.begin(), m_FreeSuballocationsBySize.end(), VmaSuballocationItemSizeLess());
+
+    VMA_HEAVY_ASSERT(Validate());
+}
+
 void VmaBlockMetadata_Generic::FreeAtOffset(VkDeviceSize offset)
 {
     for(VmaSuballocationList::iterator suballocItem = m_Suballocations.begin();
@@ -9535,38 +12768,143 @@ void VmaBlockMetadata_Generic::FreeAtOffset(VkDeviceSize offset)
     VMA_ASSERT(0 && "Not found!");
 }
 
-bool VmaBlockMetadata_Generic::ValidateFreeSuballocationList() const
+bool VmaBlockMetadata_Generic::ResizeAllocation(
+    const VmaAllocation alloc,
+    VkDeviceSize newSize,
+    VkDeviceSize bufferImageGranularity)
 {
-    VkDeviceSize lastSize = 0;
-    for(size_t i = 0, count = m_FreeSuballocationsBySize.size(); i < count; ++i)
+    typedef VmaSuballocationList::iterator iter_type;
+    for(iter_type suballocItem = m_Suballocations.begin();
+        suballocItem != m_Suballocations.end();
+        ++suballocItem)
     {
-        const VmaSuballocationList::iterator it = m_FreeSuballocationsBySize[i];
+        VmaSuballocation& suballoc = *suballocItem;
+        if(suballoc.hAllocation == alloc)
+        {
+            iter_type nextItem = suballocItem;
+            ++nextItem;
 
-        VMA_VALIDATE(it->type == VMA_SUBALLOCATION_TYPE_FREE);
-        VMA_VALIDATE(it->size >= VMA_MIN_FREE_SUBALLOCATION_SIZE_TO_REGISTER);
-        VMA_VALIDATE(it->size >= lastSize);
-        lastSize = it->size;
-    }
-    return true;
-}
+            // Should have been ensured on higher level.
+            VMA_ASSERT(newSize != suballoc.size && newSize > 0);
 
-bool VmaBlockMetadata_Generic::CheckAllocation(
-    uint32_t currentFrameIndex,
-    uint32_t frameInUseCount,
-    VkDeviceSize bufferImageGranularity,
-    VkDeviceSize allocSize,
-    VkDeviceSize allocAlignment,
-    VmaSuballocationType allocType,
-    VmaSuballocationList::const_iterator suballocItem,
-    bool canMakeOtherLost,
-    VkDeviceSize* pOffset,
-    size_t* itemsToMakeLostCount,
-    VkDeviceSize* pSumFreeSize,
-    VkDeviceSize* pSumItemSize) const
-{
-    VMA_ASSERT(allocSize > 0);
-    VMA_ASSERT(allocType != VMA_SUBALLOCATION_TYPE_FREE);
-    VMA_ASSERT(suballocItem != m_Suballocations.cend());
+            // Shrinking.
+            if(newSize < suballoc.size)
+            {
+                const VkDeviceSize sizeDiff = suballoc.size - newSize;
+
+                // Next item is free: grow it backward.
+                if(nextItem != m_Suballocations.end() && nextItem->type == VMA_SUBALLOCATION_TYPE_FREE)
+                {
+                    UnregisterFreeSuballocation(nextItem);
+                    nextItem->offset -= sizeDiff;
+                    nextItem->size += sizeDiff;
+                    RegisterFreeSuballocation(nextItem);
+                }
+                // This is the last item or next item is not free: create new free item after current one.
+                else
+                {
+                    VmaSuballocation newFreeSuballoc = {};
+                    newFreeSuballoc.offset = suballoc.offset + newSize;
+                    newFreeSuballoc.size = sizeDiff;
+                    newFreeSuballoc.type = VMA_SUBALLOCATION_TYPE_FREE;
+                    const iter_type newFreeSuballocIt = m_Suballocations.insert(nextItem, newFreeSuballoc);
+                    RegisterFreeSuballocation(newFreeSuballocIt);
+                    ++m_FreeCount;
+                }
+
+                suballoc.size = newSize;
+                m_SumFreeSize += sizeDiff;
+            }
+            // Growing.
+            else
+            {
+                const VkDeviceSize sizeDiff = newSize - suballoc.size;
+
+                // This is the last item or next item is not free - there is no space to grow.
+                if(nextItem == m_Suballocations.end() || nextItem->type != VMA_SUBALLOCATION_TYPE_FREE)
+                {
+                    return false;
+                }
+                // There is not enough free space, including margin.
+                if(nextItem->size < sizeDiff + VMA_DEBUG_MARGIN)
+                {
+                    return false;
+                }
+
+                // Allocation must not extend to a page occupied by a resource of conflicting type.
+                if(bufferImageGranularity > 1)
+                {
+                    iter_type nextNextItem = nextItem;
+                    ++nextNextItem;
+                    if(nextNextItem != m_Suballocations.end() &&
+                        VmaBlocksOnSamePage(suballoc.offset, newSize, nextNextItem->offset, bufferImageGranularity) &&
+                        VmaIsBufferImageGranularityConflict(suballoc.type, nextNextItem->type))
+                    {
+                        return false;
+                    }
+                }
+
+                // There is more free space than required: move and shrink next item.
+                if(nextItem->size > sizeDiff)
+                {
+                    UnregisterFreeSuballocation(nextItem);
+                    nextItem->offset += sizeDiff;
+                    nextItem->size -= sizeDiff;
+                    VmaClipSuballocationZeroedRange(*nextItem);
+                    RegisterFreeSuballocation(nextItem);
+                }
+                // There is exactly the amount of free space required: remove next item.
+                else
+                {
+                    UnregisterFreeSuballocation(nextItem);
+                    m_Suballocations.erase(nextItem);
+                    --m_FreeCount;
+                }
+
+                suballoc.size = newSize;
+                m_SumFreeSize -= sizeDiff;
+            }
+
+            // We cannot call Validate() here because alloc object is updated to new size outside of this call.
+            return true;
+        }
+    }
+    VMA_ASSERT(0 && "Not found!");
+    return false;
+}
+
+bool VmaBlockMetadata_Generic::ValidateFreeSuballocationList() const
+{
+    VkDeviceSize lastSize = 0;
+    for(size_t i = 0, count = m_FreeSuballocationsBySize.size(); i < count; ++i)
+    {
+        const VmaSuballocationList::iterator it = m_FreeSuballocationsBySize[i];
+
+        VMA_VALIDATE(it->type == VMA_SUBALLOCATION_TYPE_FREE);
+        VMA_VALIDATE(it->size >= VMA_MIN_FREE_SUBALLOCATION_SIZE_TO_REGISTER);
+        VMA_VALIDATE(it->size >= lastSize);
+        lastSize = it->size;
+    }
+    return true;
+}
+
+bool VmaBlockMetadata_Generic::CheckAllocation(
+    uint32_t currentFrameIndex,
+    uint32_t frameInUseCount,
+    VkDeviceSize bufferImageGranularity,
+    VkDeviceSize allocSize,
+    VkDeviceSize allocAlignment,
+    VmaSuballocationType allocType,
+    VmaSuballocationList::const_iterator suballocItem,
+    bool canMakeOtherLost,
+    VkDeviceSize* pOffset,
+    size_t* itemsToMakeLostCount,
+    VkDeviceSize* pSumFreeSize,
+    VkDeviceSize* pSumItemSize) const
+{
+    VMA_ASSERT(allocSize > 0);
+    VMA_ASSERT(allocType != VMA_SUBALLOCATION_TYPE_FREE);
+    VMA_ASSERT(suballocItem != m_Suballocations.cend());
     VMA_ASSERT(pOffset != VMA_NULL);
 
     *itemsToMakeLostCount = 0;
@@ -9824,6 +13162,54 @@ bool VmaBlockMetadata_Generic::CheckAllocation(
     return true;
 }
 
+VkDeviceSize VmaBlockMetadata_Generic::CalcUpperOffset(
+    VkDeviceSize bufferImageGranularity,
+    VkDeviceSize allocSize,
+    VkDeviceSize allocAlignment,
+    VmaSuballocationType allocType,
+    VmaSuballocationList::const_iterator freeSuballocItem,
+    VkDeviceSize lowerOffset) const
+{
+    VMA_ASSERT(freeSuballocItem->type == VMA_SUBALLOCATION_TYPE_FREE);
+    VMA_ASSERT(freeSuballocItem->offset + freeSuballocItem->size >= lowerOffset + allocSize + VMA_DEBUG_MARGIN);
+
+    // Start from end of this suballocation, leaving VMA_DEBUG_MARGIN at the end.
+    const VkDeviceSize upperOffset = VmaAlignDown(
+        freeSuballocItem->offset + freeSuballocItem->size - VMA_DEBUG_MARGIN - allocSize,
+        allocAlignment);
+    if(upperOffset <= lowerOffset)
+    {
+        return lowerOffset;
+    }
+
+    // Moving up can only bring the allocation closer to the next suballocations.
+    // Stay at the lower offset if that would cause BufferImageGranularity conflict.
+    if(bufferImageGranularity > 1)
+    {
+        VmaSuballocationList::const_iterator nextSuballocItem = freeSuballocItem;
+        ++nextSuballocItem;
+        while(nextSuballocItem != m_Suballocations.cend())
+        {
+            const VmaSuballocation& nextSuballoc = *nextSuballocItem;
+            if(VmaBlocksOnSamePage(upperOffset, allocSize, nextSuballoc.offset, bufferImageGranularity))
+            {
+                if(VmaIsBufferImageGranularityConflict(allocType, nextSuballoc.type))
+                {
+                    return lowerOffset;
+                }
+            }
+            else
+            {
+                // Already on next page.
+                break;
+            }
+            ++nextSuballocItem;
+        }
+    }
+
+    return upperOffset;
+}
+
 void VmaBlockMetadata_Generic::MergeFreeWithNext(VmaSuballocationList::iterator item)
 {
     VMA_ASSERT(item != m_Suballocations.end());
@@ -9834,6 +13220,19 @@ void VmaBlockMetadata_Generic::MergeFreeWithNext(VmaSuballocationList::iterator
     VMA_ASSERT(nextItem != m_Suballocations.end());
     VMA_ASSERT(nextItem->type == VMA_SUBALLOCATION_TYPE_FREE);
 
+    // Only single zeroed range is tracked: join them if adjacent, otherwise keep the larger one.
+    const VkDeviceSize zeroedSize = item->zeroedEnd - item->zeroedBegin;
+    const VkDeviceSize nextZeroedSize = nextItem->zeroedEnd - nextItem->zeroedBegin;
+    if(zeroedSize > 0 && nextZeroedSize > 0 && item->zeroedEnd == nextItem->zeroedBegin)
+    {
+        item->zeroedEnd = nextItem->zeroedEnd;
+    }
+    else if(nextZeroedSize > zeroedSize)
+    {
+        item->zeroedBegin = nextItem->zeroedBegin;
+        item->zeroedEnd = nextItem->zeroedEnd;
+    }
+
     item->size += nextItem->size;
     --m_FreeCount;
     m_Suballocations.erase(nextItem);
@@ -9841,10 +13240,11 @@ void VmaBlockMetadata_Generic::MergeFreeWithNext(VmaSuballocationList::iterator
 
 VmaSuballocationList::iterator VmaBlockMetadata_Generic::FreeSuballocation(VmaSuballocationList::iterator suballocItem)
 {
-    // Change this suballocation to be marked as free.
+    // Change this suballocation to be marked as free. Its contents are unknown.
     VmaSuballocation& suballoc = *suballocItem;
     suballoc.type = VMA_SUBALLOCATION_TYPE_FREE;
     suballoc.hAllocation = VK_NULL_HANDLE;
+    suballoc.zeroedBegin = suballoc.zeroedEnd = suballoc.offset;
 
     // Update totals.
     ++m_FreeCount;
@@ -9979,6 +13379,93 @@ bool VmaBlockMetadata_Generic::IsBufferImageGranularityConflictPossible(
     return typeConflictFound || minAlignment >= bufferImageGranularity;
 }
 
+bool VmaBlockMetadata_Generic::ClaimDirtyFreeRanges(
+    VkDeviceSize alignment,
+    VkDeviceSize& inoutMaxBytes,
+    size_t maxRangeCount,
+    VmaVector< VmaZeroFillRange, VmaStlAllocator<VmaZeroFillRange> >& outRanges)
+{
+    for(VmaSuballocationList::iterator it = m_Suballocations.begin();
+        it != m_Suballocations.end();
+        ++it)
+    {
+        if(it->type != VMA_SUBALLOCATION_TYPE_FREE)
+        {
+            continue;
+        }
+
+        // Leave margins untouched so magic values written there stay valid.
+        const VkDeviceSize begin = VmaAlignUp(it->offset + VMA_DEBUG_MARGIN, alignment);
+        const VkDeviceSize end = VmaAlignDown(it->offset + it->size - VMA_DEBUG_MARGIN, alignment);
+        if(begin >= end)
+        {
+            continue;
+        }
+
+        // Dirty parts are [begin, dirtyEnd1) before and [dirtyBegin2, end) after the zeroed range.
+        const VkDeviceSize zeroedBegin = VMA_MAX(it->zeroedBegin, begin);
+        const VkDeviceSize zeroedEnd = VMA_MIN(it->zeroedEnd, end);
+        VkDeviceSize dirtyEnd1 = begin;
+        VkDeviceSize dirtyBegin2 = begin;
+        if(zeroedBegin < zeroedEnd &&
+            VmaAlignUp(zeroedBegin, alignment) <= VmaAlignDown(zeroedEnd, alignment))
+        {
+            dirtyEnd1 = VmaAlignUp(zeroedBegin, alignment);
+            dirtyBegin2 = VmaAlignDown(zeroedEnd, alignment);
+        }
+        else
+        {
+            // Nothing usable is zeroed - start a new zeroed range at the beginning.
+            it->zeroedBegin = it->zeroedEnd = begin;
+        }
+
+        // Part before the zeroed range is claimed from its end, so the zeroed range stays contiguous.
+        if(dirtyEnd1 > begin)
+        {
+            if(outRanges.size() >= maxRangeCount)
+            {
+                return false;
+            }
+            const VkDeviceSize size = VMA_MIN(dirtyEnd1 - begin, VmaAlignDown(inoutMaxBytes, alignment));
+            if(size == 0)
+            {
+                return false;
+            }
+            const VmaZeroFillRange range = { VK_NULL_HANDLE, dirtyEnd1 - size, size };
+            outRanges.push_back(range);
+            inoutMaxBytes -= size;
+            it->zeroedBegin = dirtyEnd1 - size;
+            if(size < dirtyEnd1 - begin)
+            {
+                return false;
+            }
+        }
+
+        // Part after the zeroed range is claimed from its beginning.
+        if(end > dirtyBegin2)
+        {
+            if(outRanges.size() >= maxRangeCount)
+            {
+                return false;
+            }
+            const VkDeviceSize size = VMA_MIN(end - dirtyBegin2, VmaAlignDown(inoutMaxBytes, alignment));
+            if(size == 0)
+            {
+                return false;
+            }
+            const VmaZeroFillRange range = { VK_NULL_HANDLE, dirtyBegin2, size };
+            outRanges.push_back(range);
+            inoutMaxBytes -= size;
+            it->zeroedEnd = VMA_MAX(it->zeroedEnd, dirtyBegin2 + size);
+            if(size < end - dirtyBegin2)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class VmaBlockMetadata_Linear
 
@@ -10567,6 +14054,72 @@ void VmaBlockMetadata_Linear::AddPoolStats(VmaPoolStats& inoutStats) const
     }
 }
 
+/*
+Returns allocation that contains offset among suballocations sorted by offset,
+in increasing order or decreasing order (upper stack).
+*/
+static VmaAllocation VmaFindSortedSuballocationAt(
+    const VmaSuballocation* pBeg,
+    const VmaSuballocation* pEnd,
+    VkDeviceSize offset,
+    bool decreasing)
+{
+    VmaSuballocation refSuballoc = {};
+    refSuballoc.offset = offset;
+    const VmaSuballocation* pSuballoc = VMA_NULL;
+    if(decreasing)
+    {
+        // First item beginning at or before offset.
+        pSuballoc = VmaBinaryFindFirstNotLess(pBeg, pEnd, refSuballoc, VmaSuballocationOffsetGreater());
+    }
+    else
+    {
+        // Last item beginning at or before offset.
+        pSuballoc = VmaBinaryFindFirstNotLess(pBeg, pEnd, refSuballoc, VmaSuballocationOffsetLess());
+        if(pSuballoc == pEnd || pSuballoc->offset > offset)
+        {
+            if(pSuballoc == pBeg)
+            {
+                return VK_NULL_HANDLE;
+            }
+            --pSuballoc;
+        }
+    }
+    if(pSuballoc != pEnd && offset < pSuballoc->offset + pSuballoc->size)
+    {
+        return pSuballoc->hAllocation;
+    }
+    return VK_NULL_HANDLE;
+}
+
+VmaAllocation VmaBlockMetadata_Linear::FindAllocationAt(VkDeviceSize offset) const
+{
+    const SuballocationVectorType& suballocations1st = AccessSuballocations1st();
+    const SuballocationVectorType& suballocations2nd = AccessSuballocations2nd();
+
+    if(suballocations1st.size() > m_1stNullItemsBeginCount)
+    {
+        const VmaAllocation alloc = VmaFindSortedSuballocationAt(
+            suballocations1st.data() + m_1stNullItemsBeginCount,
+            suballocations1st.data() + suballocations1st.size(),
+            offset,
+            false); // decreasing
+        if(alloc != VK_NULL_HANDLE)
+        {
+            return alloc;
+        }
+    }
+    if(!suballocations2nd.empty())
+    {
+        return VmaFindSortedSuballocationAt(
+            suballocations2nd.data(),
+            suballocations2nd.data() + suballocations2nd.size(),
+            offset,
+            m_2ndVectorMode == SECOND_VECTOR_DOUBLE_STACK); // decreasing
+    }
+    return VK_NULL_HANDLE;
+}
+
 #if VMA_STATS_STRING_ENABLED
 void VmaBlockMetadata_Linear::PrintDetailedMap(class VmaJsonWriter& json) const
 {
@@ -11518,6 +15071,23 @@ void VmaBlockMetadata_Linear::Alloc(
     m_SumFreeSize -= newSuballoc.size;
 }
 
+VkDeviceSize VmaBlockMetadata_Linear::GetRequestFreeRangeEnd(const VmaAllocationRequest& request) const
+{
+    const SuballocationVectorType& suballocations1st = AccessSuballocations1st();
+    const SuballocationVectorType& suballocations2nd = AccessSuballocations2nd();
+    switch(request.type)
+    {
+    case VmaAllocationRequestType::EndOf1st:
+        return (m_2ndVectorMode == SECOND_VECTOR_DOUBLE_STACK && !suballocations2nd.empty()) ?
+            suballocations2nd.back().offset : GetSize();
+    case VmaAllocationRequestType::EndOf2nd:
+        return suballocations1st[m_1stNullItemsBeginCount].offset;
+    default:
+        // Upper stack grows down, so nothing is known above the request.
+        return request.offset;
+    }
+}
+
 void VmaBlockMetadata_Linear::Free(const VmaAllocation allocation)
 {
     FreeAtOffset(allocation->GetOffset());
@@ -11613,63 +15183,215 @@ void VmaBlockMetadata_Linear::FreeAtOffset(VkDeviceSize offset)
     VMA_ASSERT(0 && "Allocation to free not found in linear allocator!");
 }
 
-bool VmaBlockMetadata_Linear::ShouldCompact1st() const
-{
-    const size_t nullItemCount = m_1stNullItemsBeginCount + m_1stNullItemsMiddleCount;
-    const size_t suballocCount = AccessSuballocations1st().size();
-    return suballocCount > 32 && nullItemCount * 2 >= (suballocCount - nullItemCount) * 3;
-}
-
-void VmaBlockMetadata_Linear::CleanupAfterFree()
+bool VmaBlockMetadata_Linear::ResizeAllocation(
+    const VmaAllocation alloc,
+    VkDeviceSize newSize,
+    VkDeviceSize bufferImageGranularity)
 {
     SuballocationVectorType& suballocations1st = AccessSuballocations1st();
     SuballocationVectorType& suballocations2nd = AccessSuballocations2nd();
 
-    if(IsEmpty())
+    VmaSuballocation refSuballoc;
+    refSuballoc.offset = alloc->GetOffset();
+    // Rest of members stays uninitialized intentionally for better performance.
+
+    VmaSuballocation* pSuballoc = VMA_NULL;
+    // Only the allocation at the top of the stack can grow - up to the beginning of
+    // the following allocation or the end of the block.
+    bool canGrow = false;
+    const VmaSuballocation* pNextSuballoc = VMA_NULL;
+
+    SuballocationVectorType::iterator it = VmaBinaryFindSorted(
+        suballocations1st.begin() + m_1stNullItemsBeginCount,
+        suballocations1st.end(),
+        refSuballoc,
+        VmaSuballocationOffsetLess());
+    if(it != suballocations1st.end())
     {
-        suballocations1st.clear();
-        suballocations2nd.clear();
-        m_1stNullItemsBeginCount = 0;
-        m_1stNullItemsMiddleCount = 0;
-        m_2ndNullItemsCount = 0;
-        m_2ndVectorMode = SECOND_VECTOR_EMPTY;
+        pSuballoc = &*it;
+        if(pSuballoc == &suballocations1st.back())
+        {
+            canGrow = true;
+            if(m_2ndVectorMode == SECOND_VECTOR_DOUBLE_STACK)
+            {
+                pNextSuballoc = &suballocations2nd.back();
+            }
+        }
     }
-    else
+    else if(m_2ndVectorMode != SECOND_VECTOR_EMPTY)
     {
-        const size_t suballoc1stCount = suballocations1st.size();
-        const size_t nullItem1stCount = m_1stNullItemsBeginCount + m_1stNullItemsMiddleCount;
-        VMA_ASSERT(nullItem1stCount <= suballoc1stCount);
-
-        // Find more null items at the beginning of 1st vector.
-        while(m_1stNullItemsBeginCount < suballoc1stCount &&
-            suballocations1st[m_1stNullItemsBeginCount].hAllocation == VK_NULL_HANDLE)
+        it = m_2ndVectorMode == SECOND_VECTOR_RING_BUFFER ?
+            VmaBinaryFindSorted(suballocations2nd.begin(), suballocations2nd.end(), refSuballoc, VmaSuballocationOffsetLess()) :
+            VmaBinaryFindSorted(suballocations2nd.begin(), suballocations2nd.end(), refSuballoc, VmaSuballocationOffsetGreater());
+        if(it != suballocations2nd.end())
         {
-            ++m_1stNullItemsBeginCount;
-            --m_1stNullItemsMiddleCount;
+            pSuballoc = &*it;
+            if(m_2ndVectorMode == SECOND_VECTOR_RING_BUFFER && pSuballoc == &suballocations2nd.back())
+            {
+                canGrow = true;
+                pNextSuballoc = &suballocations1st[m_1stNullItemsBeginCount];
+            }
         }
+    }
 
-        // Find more null items at the end of 1st vector.
-        while(m_1stNullItemsMiddleCount > 0 &&
-            suballocations1st.back().hAllocation == VK_NULL_HANDLE)
+    if(pSuballoc == VMA_NULL || pSuballoc->hAllocation != alloc)
+    {
+        VMA_ASSERT(0 && "Allocation to resize not found in linear allocator!");
+        return false;
+    }
+    // Should have been ensured on higher level.
+    VMA_ASSERT(newSize != pSuballoc->size && newSize > 0);
+
+    if(newSize > pSuballoc->size)
+    {
+        if(!canGrow)
         {
-            --m_1stNullItemsMiddleCount;
-            suballocations1st.pop_back();
+            return false;
         }
-
-        // Find more null items at the end of 2nd vector.
-        while(m_2ndNullItemsCount > 0 &&
-            suballocations2nd.back().hAllocation == VK_NULL_HANDLE)
+        const VkDeviceSize endLimit = pNextSuballoc != VMA_NULL ? pNextSuballoc->offset : GetSize();
+        if(pSuballoc->offset + newSize + VMA_DEBUG_MARGIN > endLimit)
         {
-            --m_2ndNullItemsCount;
-            suballocations2nd.pop_back();
+            return false;
         }
-
-        // Find more null items at the beginning of 2nd vector.
-        while(m_2ndNullItemsCount > 0 &&
-            suballocations2nd[0].hAllocation == VK_NULL_HANDLE)
+        if(pNextSuballoc != VMA_NULL && bufferImageGranularity > 1 &&
+            VmaBlocksOnSamePage(pSuballoc->offset, newSize, pNextSuballoc->offset, bufferImageGranularity) &&
+            VmaIsBufferImageGranularityConflict(pSuballoc->type, pNextSuballoc->type))
         {
-            --m_2ndNullItemsCount;
-            VmaVectorRemove(suballocations2nd, 0);
+            return false;
+        }
+    }
+
+    m_SumFreeSize = m_SumFreeSize + pSuballoc->size - newSize;
+    pSuballoc->size = newSize;
+    return true;
+}
+
+bool VmaBlockMetadata_Linear::GetLowerStackTop(VkDeviceSize& outOffset) const
+{
+    if(m_2ndVectorMode == SECOND_VECTOR_RING_BUFFER)
+    {
+        return false;
+    }
+    const SuballocationVectorType& suballocations1st = AccessSuballocations1st();
+    // Null items are never left at the end of 1st vector.
+    outOffset = suballocations1st.empty() ? 0 : suballocations1st.back().offset + suballocations1st.back().size;
+    return true;
+}
+
+bool VmaBlockMetadata_Linear::FreeLowerStackAbove(
+    VkDeviceSize offset,
+    VmaVector< VmaAllocation, VmaStlAllocator<VmaAllocation> >& outAllocations)
+{
+    if(m_2ndVectorMode == SECOND_VECTOR_RING_BUFFER)
+    {
+        return false;
+    }
+
+    SuballocationVectorType& suballocations1st = AccessSuballocations1st();
+    while(suballocations1st.size() > m_1stNullItemsBeginCount &&
+        suballocations1st.back().offset >= offset)
+    {
+        const VmaSuballocation& suballoc = suballocations1st.back();
+        if(suballoc.hAllocation != VK_NULL_HANDLE)
+        {
+            outAllocations.push_back(suballoc.hAllocation);
+            m_SumFreeSize += suballoc.size;
+        }
+        else
+        {
+            --m_1stNullItemsMiddleCount;
+        }
+        suballocations1st.pop_back();
+    }
+    CleanupAfterFree();
+    return true;
+}
+
+void VmaBlockMetadata_Linear::FreeAll(VmaVector< VmaAllocation, VmaStlAllocator<VmaAllocation> >& outAllocations)
+{
+    SuballocationVectorType& suballocations1st = AccessSuballocations1st();
+    SuballocationVectorType& suballocations2nd = AccessSuballocations2nd();
+    for(size_t i = m_1stNullItemsBeginCount; i < suballocations1st.size(); ++i)
+    {
+        if(suballocations1st[i].hAllocation != VK_NULL_HANDLE)
+        {
+            outAllocations.push_back(suballocations1st[i].hAllocation);
+        }
+    }
+    for(size_t i = 0; i < suballocations2nd.size(); ++i)
+    {
+        if(suballocations2nd[i].hAllocation != VK_NULL_HANDLE)
+        {
+            outAllocations.push_back(suballocations2nd[i].hAllocation);
+        }
+    }
+
+    suballocations1st.clear();
+    suballocations2nd.clear();
+    m_1stNullItemsBeginCount = 0;
+    m_1stNullItemsMiddleCount = 0;
+    m_2ndNullItemsCount = 0;
+    m_2ndVectorMode = SECOND_VECTOR_EMPTY;
+    m_SumFreeSize = GetSize();
+}
+
+bool VmaBlockMetadata_Linear::ShouldCompact1st() const
+{
+    const size_t nullItemCount = m_1stNullItemsBeginCount + m_1stNullItemsMiddleCount;
+    const size_t suballocCount = AccessSuballocations1st().size();
+    return suballocCount > 32 && nullItemCount * 2 >= (suballocCount - nullItemCount) * 3;
+}
+
+void VmaBlockMetadata_Linear::CleanupAfterFree()
+{
+    SuballocationVectorType& suballocations1st = AccessSuballocations1st();
+    SuballocationVectorType& suballocations2nd = AccessSuballocations2nd();
+
+    if(IsEmpty())
+    {
+        suballocations1st.clear();
+        suballocations2nd.clear();
+        m_1stNullItemsBeginCount = 0;
+        m_1stNullItemsMiddleCount = 0;
+        m_2ndNullItemsCount = 0;
+        m_2ndVectorMode = SECOND_VECTOR_EMPTY;
+    }
+    else
+    {
+        const size_t suballoc1stCount = suballocations1st.size();
+        const size_t nullItem1stCount = m_1stNullItemsBeginCount + m_1stNullItemsMiddleCount;
+        VMA_ASSERT(nullItem1stCount <= suballoc1stCount);
+
+        // Find more null items at the beginning of 1st vector.
+        while(m_1stNullItemsBeginCount < suballoc1stCount &&
+            suballocations1st[m_1stNullItemsBeginCount].hAllocation == VK_NULL_HANDLE)
+        {
+            ++m_1stNullItemsBeginCount;
+            --m_1stNullItemsMiddleCount;
+        }
+
+        // Find more null items at the end of 1st vector.
+        while(m_1stNullItemsMiddleCount > 0 &&
+            suballocations1st.back().hAllocation == VK_NULL_HANDLE)
+        {
+            --m_1stNullItemsMiddleCount;
+            suballocations1st.pop_back();
+        }
+
+        // Find more null items at the end of 2nd vector.
+        while(m_2ndNullItemsCount > 0 &&
+            suballocations2nd.back().hAllocation == VK_NULL_HANDLE)
+        {
+            --m_2ndNullItemsCount;
+            suballocations2nd.pop_back();
+        }
+
+        // Find more null items at the beginning of 2nd vector.
+        while(m_2ndNullItemsCount > 0 &&
+            suballocations2nd[0].hAllocation == VK_NULL_HANDLE)
+        {
+            --m_2ndNullItemsCount;
+            VmaVectorRemove(suballocations2nd, 0);
         }
 
         if(ShouldCompact1st())
@@ -11865,6 +15587,39 @@ void VmaBlockMetadata_Buddy::AddPoolStats(VmaPoolStats& inoutStats) const
     }
 }
 
+VmaAllocation VmaBlockMetadata_Buddy::FindAllocationAt(VkDeviceSize offset) const
+{
+    if(offset >= m_UsableSize)
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    // Same descent as in FreeAtOffset().
+    const Node* node = m_Root;
+    VkDeviceSize nodeOffset = 0;
+    VkDeviceSize levelNodeSize = LevelToNodeSize(0);
+    while(node->type == Node::TYPE_SPLIT)
+    {
+        const VkDeviceSize nextLevelSize = levelNodeSize >> 1;
+        if(offset < nodeOffset + nextLevelSize)
+        {
+            node = node->split.leftChild;
+        }
+        else
+        {
+            node = node->split.leftChild->buddy;
+            nodeOffset += nextLevelSize;
+        }
+        levelNodeSize = nextLevelSize;
+    }
+
+    if(node->type == Node::TYPE_ALLOCATION && offset < nodeOffset + node->allocation.alloc->GetSize())
+    {
+        return node->allocation.alloc;
+    }
+    return VK_NULL_HANDLE;
+}
+
 #if VMA_STATS_STRING_ENABLED
 
 void VmaBlockMetadata_Buddy::PrintDetailedMap(class VmaJsonWriter& json) const
@@ -12113,6 +15868,45 @@ uint32_t VmaBlockMetadata_Buddy::AllocSizeToLevel(VkDeviceSize allocSize) const
     return level;
 }
 
+bool VmaBlockMetadata_Buddy::ResizeAllocation(
+    const VmaAllocation alloc,
+    VkDeviceSize newSize,
+    VkDeviceSize bufferImageGranularity)
+{
+    // Find node and level, same as in FreeAtOffset.
+    const VkDeviceSize offset = alloc->GetOffset();
+    Node* node = m_Root;
+    VkDeviceSize nodeOffset = 0;
+    VkDeviceSize levelNodeSize = LevelToNodeSize(0);
+    while(node->type == Node::TYPE_SPLIT)
+    {
+        const VkDeviceSize nextLevelSize = levelNodeSize >> 1;
+        if(offset < nodeOffset + nextLevelSize)
+        {
+            node = node->split.leftChild;
+        }
+        else
+        {
+            node = node->split.leftChild->buddy;
+            nodeOffset += nextLevelSize;
+        }
+        levelNodeSize = nextLevelSize;
+    }
+
+    VMA_ASSERT(node != VMA_NULL && node->type == Node::TYPE_ALLOCATION);
+    VMA_ASSERT(node->allocation.alloc == alloc);
+
+    // Allocation can only be resized within the node it already occupies.
+    // Neighboring nodes are never touched, so bufferImageGranularity doesn't matter here.
+    if(newSize > levelNodeSize)
+    {
+        return false;
+    }
+
+    m_SumFreeSize = m_SumFreeSize + alloc->GetSize() - newSize;
+    return true;
+}
+
 void VmaBlockMetadata_Buddy::FreeAtOffset(VmaAllocation alloc, VkDeviceSize offset)
 {
     // Find node and level.
@@ -12293,6 +16087,204 @@ void VmaBlockMetadata_Buddy::PrintDetailedMapNode(class VmaJsonWriter& json, con
 #endif // #if VMA_STATS_STRING_ENABLED
 
 
+////////////////////////////////////////////////////////////////////////////////
+// class VmaStatsPublisher
+
+void VmaStatsPublisher::Init(void* pMemory, const VkPhysicalDeviceMemoryProperties& memProps)
+{
+    VMA_ASSERT(m_pStats == VMA_NULL);
+    VMA_ASSERT(((uintptr_t)pMemory & 7) == 0 && "pPublishedStatsMemory must be aligned to 8 bytes.");
+    m_pStats = (VmaPublishedStats*)pMemory;
+    // Another process can only see the counters if atomic operations on them don't use a hidden lock.
+    VMA_ASSERT(AsAtomic(m_pStats->endSequence).is_lock_free() && AsAtomic(m_pStats->magic).is_lock_free());
+
+    // The reader may already be polling the memory, so it must never see the magic with uninitialized contents.
+    memset(m_pStats, 0, sizeof(VmaPublishedStats));
+    m_pStats->version = VMA_PUBLISHED_STATS_VERSION;
+    m_pStats->memoryHeapCount = memProps.memoryHeapCount;
+    m_pStats->memoryTypeCount = memProps.memoryTypeCount;
+    for(uint32_t heapIndex = 0; heapIndex < memProps.memoryHeapCount; ++heapIndex)
+    {
+        m_pStats->heaps[heapIndex].budget = memProps.memoryHeaps[heapIndex].size * 8 / 10; // 80% heuristics.
+    }
+    AsAtomic(m_pStats->magic).store(VMA_PUBLISHED_STATS_MAGIC);
+}
+
+void VmaStatsPublisher::Invalidate()
+{
+    if(m_pStats == VMA_NULL)
+    {
+        return;
+    }
+    // Bracketed like any update, so a reader copying the memory right now retries and sees the cleared magic.
+    BeginWrite();
+    AsAtomic(m_pStats->magic).store(0);
+    EndWrite();
+    m_pStats = VMA_NULL;
+}
+
+uint32_t VmaStatsPublisher::AcquirePoolSlot(uint32_t memTypeIndex)
+{
+    if(m_pStats == VMA_NULL)
+    {
+        return VMA_PUBLISHED_STATS_MAX_POOLS;
+    }
+    BeginWrite();
+    uint32_t slot = 0;
+    for(; slot < VMA_PUBLISHED_STATS_MAX_POOLS; ++slot)
+    {
+        VmaPublishedPoolStats& poolStats = m_pStats->pools[slot];
+        // Counters of inactive slots are zeroed by ReleasePoolSlot().
+        uint32_t inactive = VK_FALSE;
+        if(AsAtomic(poolStats.active).compare_exchange_strong(inactive, VK_TRUE))
+        {
+            AsAtomic(poolStats.memoryTypeIndex).store(memTypeIndex);
+            break;
+        }
+    }
+    EndWrite();
+    return slot;
+}
+
+void VmaStatsPublisher::SetPoolId(uint32_t slot, uint32_t poolId)
+{
+    if(slot < VMA_PUBLISHED_STATS_MAX_POOLS)
+    {
+        BeginWrite();
+        AsAtomic(m_pStats->pools[slot].poolId).store(poolId);
+        EndWrite();
+    }
+}
+
+void VmaStatsPublisher::ReleasePoolSlot(uint32_t slot)
+{
+    if(slot < VMA_PUBLISHED_STATS_MAX_POOLS)
+    {
+        VmaPublishedPoolStats& poolStats = m_pStats->pools[slot];
+        BeginWrite();
+        AsAtomic(poolStats.poolId).store(0);
+        AsAtomic(poolStats.memoryTypeIndex).store(0);
+        AsAtomic(poolStats.counters.blockCount).store(0);
+        AsAtomic(poolStats.counters.blockBytes).store(0);
+        AsAtomic(poolStats.counters.allocationCount).store(0);
+        AsAtomic(poolStats.counters.allocationBytes).store(0);
+        // Last, so the slot can be acquired by another thread only when it is clean.
+        AsAtomic(poolStats.active).store(VK_FALSE);
+        EndWrite();
+    }
+}
+
+void VmaStatsPublisher::UpdateDeviceMemory(uint32_t memTypeIndex, uint32_t heapIndex, VkDeviceSize oldSize, VkDeviceSize newSize)
+{
+    if(m_pStats == VMA_NULL)
+    {
+        return;
+    }
+    BeginWrite();
+    VmaPublishedStatCounters& typeCounters = m_pStats->memoryTypes[memTypeIndex];
+    UpdateCounters(typeCounters.blockCount, typeCounters.blockBytes, oldSize, newSize);
+    VmaPublishedHeapStats& heapStats = m_pStats->heaps[heapIndex];
+    UpdateCounters(heapStats.counters.blockCount, heapStats.counters.blockBytes, oldSize, newSize);
+    AsAtomic(heapStats.usage).fetch_add(newSize - oldSize);
+    if(oldSize == 0)
+    {
+        AsAtomic(m_pStats->deviceMemoryAllocationCount).fetch_add(1);
+    }
+    if(newSize == 0)
+    {
+        AsAtomic(m_pStats->deviceMemoryFreeCount).fetch_add(1);
+    }
+    EndWrite();
+}
+
+void VmaStatsPublisher::UpdatePoolBlock(uint32_t poolSlot, VkDeviceSize oldSize, VkDeviceSize newSize)
+{
+    if(poolSlot < VMA_PUBLISHED_STATS_MAX_POOLS)
+    {
+        BeginWrite();
+        VmaPublishedStatCounters& poolCounters = m_pStats->pools[poolSlot].counters;
+        UpdateCounters(poolCounters.blockCount, poolCounters.blockBytes, oldSize, newSize);
+        EndWrite();
+    }
+}
+
+void VmaStatsPublisher::UpdateAllocation(uint32_t memTypeIndex, uint32_t heapIndex, uint32_t poolSlot, VkDeviceSize oldSize, VkDeviceSize newSize)
+{
+    if(m_pStats == VMA_NULL)
+    {
+        return;
+    }
+    BeginWrite();
+    VmaPublishedStatCounters& typeCounters = m_pStats->memoryTypes[memTypeIndex];
+    UpdateCounters(typeCounters.allocationCount, typeCounters.allocationBytes, oldSize, newSize);
+    VmaPublishedStatCounters& heapCounters = m_pStats->heaps[heapIndex].counters;
+    UpdateCounters(heapCounters.allocationCount, heapCounters.allocationBytes, oldSize, newSize);
+    if(poolSlot < VMA_PUBLISHED_STATS_MAX_POOLS)
+    {
+        VmaPublishedStatCounters& poolCounters = m_pStats->pools[poolSlot].counters;
+        UpdateCounters(poolCounters.allocationCount, poolCounters.allocationBytes, oldSize, newSize);
+    }
+    if(oldSize == 0)
+    {
+        AsAtomic(m_pStats->allocationOperationCount).fetch_add(1);
+    }
+    if(newSize == 0)
+    {
+        AsAtomic(m_pStats->freeOperationCount).fetch_add(1);
+    }
+    EndWrite();
+}
+
+void VmaStatsPublisher::UpdateBudget(uint32_t heapIndex, VkDeviceSize usage, VkDeviceSize budget)
+{
+    if(m_pStats == VMA_NULL)
+    {
+        return;
+    }
+    BeginWrite();
+    AsAtomic(m_pStats->heaps[heapIndex].usage).store(usage);
+    AsAtomic(m_pStats->heaps[heapIndex].budget).store(budget);
+    EndWrite();
+}
+
+void VmaStatsPublisher::BeginWrite()
+{
+    // Sequentially consistent, so it becomes visible before any of the following writes.
+    AsAtomic(m_pStats->beginSequence).fetch_add(1);
+}
+
+void VmaStatsPublisher::EndWrite()
+{
+    AsAtomic(m_pStats->endSequence).fetch_add(1);
+}
+
+void VmaStatsPublisher::UpdateCounters(uint64_t& count, uint64_t& bytes, VkDeviceSize oldSize, VkDeviceSize newSize)
+{
+    if(oldSize == 0)
+    {
+        AsAtomic(count).fetch_add(1);
+    }
+    if(newSize == 0)
+    {
+        VMA_ASSERT(AsAtomic(count).load() > 0);
+        AsAtomic(count).fetch_sub(1);
+    }
+    // Unsigned arithmetic wraps around correctly when shrinking.
+    AsAtomic(bytes).fetch_add(newSize - oldSize);
+}
+
+VMA_ATOMIC_UINT32& VmaStatsPublisher::AsAtomic(uint32_t& value)
+{
+    static_assert(sizeof(VMA_ATOMIC_UINT32) == sizeof(uint32_t), "Atomic must have the same layout as plain integer.");
+    return *reinterpret_cast<VMA_ATOMIC_UINT32*>(&value);
+}
+
+VMA_ATOMIC_UINT64& VmaStatsPublisher::AsAtomic(uint64_t& value)
+{
+    static_assert(sizeof(VMA_ATOMIC_UINT64) == sizeof(uint64_t), "Atomic must have the same layout as plain integer.");
+    return *reinterpret_cast<VMA_ATOMIC_UINT64*>(&value);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class VmaDeviceMemoryBlock
 
@@ -12301,6 +16293,10 @@ VmaDeviceMemoryBlock::VmaDeviceMemoryBlock(VmaAllocator hAllocator) :
     m_MemoryTypeIndex(UINT32_MAX),
     m_Id(0),
     m_hMemory(VK_NULL_HANDLE),
+    m_Lifetime(VMA_ALLOCATION_LIFETIME_UNKNOWN),
+    m_Priority(VMA_DEFAULT_MEMORY_PRIORITY),
+    m_AppliedPriority(VMA_DEFAULT_MEMORY_PRIORITY),
+    m_LastUseFrameIndex(0),
     m_MapCount(0),
     m_pMappedData(VMA_NULL)
 {
@@ -12313,7 +16309,8 @@ void VmaDeviceMemoryBlock::Init(
     VkDeviceMemory newMemory,
     VkDeviceSize newSize,
     uint32_t id,
-    uint32_t algorithm)
+    uint32_t algorithm,
+    float priority)
 {
     VMA_ASSERT(m_hMemory == VK_NULL_HANDLE);
 
@@ -12321,6 +16318,9 @@ void VmaDeviceMemoryBlock::Init(
     m_MemoryTypeIndex = newMemoryTypeIndex;
     m_Id = id;
     m_hMemory = newMemory;
+    m_Priority = priority;
+    m_AppliedPriority = priority;
+    m_LastUseFrameIndex.store(hAllocator->GetCurrentFrameIndex());
 
     switch(algorithm)
     {
@@ -12337,6 +16337,11 @@ void VmaDeviceMemoryBlock::Init(
         m_pMetadata = vma_new(hAllocator, VmaBlockMetadata_Generic)(hAllocator);
     }
     m_pMetadata->Init(newSize);
+
+    if(hParentPool != VK_NULL_HANDLE)
+    {
+        hAllocator->m_StatsPublisher.UpdatePoolBlock(hParentPool->GetPublishedStatsSlot(), 0, newSize);
+    }
 }
 
 void VmaDeviceMemoryBlock::Destroy(VmaAllocator allocator)
@@ -12348,6 +16353,14 @@ void VmaDeviceMemoryBlock::Destroy(VmaAllocator allocator)
     VMA_ASSERT(m_hMemory != VK_NULL_HANDLE);
     allocator->FreeVulkanMemory(m_MemoryTypeIndex, m_pMetadata->GetSize(), m_hMemory);
     m_hMemory = VK_NULL_HANDLE;
+    if(m_hParentPool != VK_NULL_HANDLE)
+    {
+        allocator->m_StatsPublisher.UpdatePoolBlock(m_hParentPool->GetPublishedStatsSlot(), m_pMetadata->GetSize(), 0);
+        if(m_hParentPool->GetQuota() != VK_NULL_HANDLE)
+        {
+            m_hParentPool->GetQuota()->Release(m_pMetadata->GetSize());
+        }
+    }
 
     vma_delete(allocator, m_pMetadata);
     m_pMetadata = VMA_NULL;
@@ -12562,9 +16575,19 @@ VmaPool_T::VmaPool_T(
         (createInfo.flags & VMA_POOL_CREATE_IGNORE_BUFFER_IMAGE_GRANULARITY_BIT) != 0 ? 1 : hAllocator->GetBufferImageGranularity(),
         createInfo.frameInUseCount,
         createInfo.blockSize != 0, // explicitBlockSize
-        createInfo.flags & VMA_POOL_CREATE_ALGORITHM_MASK), // algorithm
-    m_Id(0),
-    m_Name(VMA_NULL)
+        createInfo.flags & VMA_POOL_CREATE_ALGORITHM_MASK, // algorithm
+        createInfo.pHostPointer,
+#if VMA_EXTERNAL_MEMORY
+        createInfo.exportHandleTypes,
+#else
+        0, // exportHandleTypes
+#endif
+        VmaGetMemoryPriority(createInfo.priority)),
+    m_Id(0),
+    m_Name(VMA_NULL),
+    m_Quota(createInfo.quota),
+    m_PublishedStatsSlot(VMA_PUBLISHED_STATS_MAX_POOLS),
+    m_RecordingEnabled(0)
 {
 }
 
@@ -12572,4452 +16595,8692 @@ VmaPool_T::~VmaPool_T()
 {
 }
 
-void VmaPool_T::SetName(const char* pName)
-{
-    const VkAllocationCallbacks* allocs = m_BlockVector.GetAllocator()->GetAllocationCallbacks();
-    VmaFreeString(allocs, m_Name);
+////////////////////////////////////////////////////////////////////////////////
+// class VmaQuota_T
 
-    if(pName != VMA_NULL)
+VmaQuota_T::VmaQuota_T(VmaAllocator hAllocator, const VmaQuotaCreateInfo& createInfo) :
+    m_hAllocator(hAllocator),
+    m_Parent(createInfo.parent),
+    m_Limit(createInfo.limit),
+    m_Name(VmaCreateStringCopy(hAllocator->GetAllocationCallbacks(), createInfo.pName)),
+    m_Usage(0),
+    m_PeakUsage(0),
+    m_OverLimitCount(0),
+    m_ChildCount(0)
+{
+    if(m_Parent != VMA_NULL)
     {
-        m_Name = VmaCreateStringCopy(allocs, pName);
+        m_Parent->m_ChildCount.fetch_add(1);
     }
-    else
+}
+
+VmaQuota_T::~VmaQuota_T()
+{
+    VMA_ASSERT(m_ChildCount.load() == 0 && "Quota destroyed before its child quotas.");
+    VMA_ASSERT(m_Usage.load() == 0 && "Quota destroyed while some allocations or pools are still charged to it.");
+    if(m_Parent != VMA_NULL)
     {
-        m_Name = VMA_NULL;
+        m_Parent->m_ChildCount.fetch_sub(1);
     }
+    VmaFreeString(m_hAllocator->GetAllocationCallbacks(), m_Name);
 }
 
-#if VMA_STATS_STRING_ENABLED
-
-#endif // #if VMA_STATS_STRING_ENABLED
-
-VmaBlockVector::VmaBlockVector(
-    VmaAllocator hAllocator,
-    VmaPool hParentPool,
-    uint32_t memoryTypeIndex,
-    VkDeviceSize preferredBlockSize,
-    size_t minBlockCount,
-    size_t maxBlockCount,
-    VkDeviceSize bufferImageGranularity,
-    uint32_t frameInUseCount,
-    bool explicitBlockSize,
-    uint32_t algorithm) :
-    m_hAllocator(hAllocator),
-    m_hParentPool(hParentPool),
-    m_MemoryTypeIndex(memoryTypeIndex),
-    m_PreferredBlockSize(preferredBlockSize),
-    m_MinBlockCount(minBlockCount),
-    m_MaxBlockCount(maxBlockCount),
-    m_BufferImageGranularity(bufferImageGranularity),
-    m_FrameInUseCount(frameInUseCount),
-    m_ExplicitBlockSize(explicitBlockSize),
-    m_Algorithm(algorithm),
-    m_HasEmptyBlock(false),
-    m_Blocks(VmaStlAllocator<VmaDeviceMemoryBlock*>(hAllocator->GetAllocationCallbacks())),
-    m_NextBlockId(0)
+bool VmaQuota_T::TryCharge(VkDeviceSize size)
 {
+    for(VmaQuota quota = this; quota != VMA_NULL; quota = quota->m_Parent)
+    {
+        if(!quota->TryChargeThis(size))
+        {
+            // Roll back levels charged so far.
+            for(VmaQuota chargedQuota = this; chargedQuota != quota; chargedQuota = chargedQuota->m_Parent)
+            {
+                chargedQuota->m_Usage.fetch_sub(size);
+            }
+            return false;
+        }
+    }
+    return true;
 }
 
-VmaBlockVector::~VmaBlockVector()
+void VmaQuota_T::Release(VkDeviceSize size)
 {
-    for(size_t i = m_Blocks.size(); i--; )
+    for(VmaQuota quota = this; quota != VMA_NULL; quota = quota->m_Parent)
     {
-        m_Blocks[i]->Destroy(m_hAllocator);
-        vma_delete(m_hAllocator, m_Blocks[i]);
+        VMA_ASSERT(quota->m_Usage.load() >= size);
+        quota->m_Usage.fetch_sub(size);
     }
 }
 
-VkResult VmaBlockVector::CreateMinBlocks()
+void VmaQuota_T::GetStats(VmaQuotaStats& outStats) const
 {
-    for(size_t i = 0; i < m_MinBlockCount; ++i)
+    outStats.limit = m_Limit;
+    outStats.usage = m_Usage.load();
+    outStats.peakUsage = m_PeakUsage.load();
+    outStats.overLimitCount = m_OverLimitCount.load();
+}
+
+bool VmaQuota_T::TryChargeThis(VkDeviceSize size)
+{
+    uint64_t usage = m_Usage.load();
+    uint64_t newUsage;
+    do
     {
-        VkResult res = CreateBlock(m_PreferredBlockSize, VMA_NULL);
-        if(res != VK_SUCCESS)
+        newUsage = usage + size;
+        if(newUsage > m_Limit || newUsage < usage)
         {
-            return res;
+            m_OverLimitCount.fetch_add(1);
+            return false;
         }
+    } while(!m_Usage.compare_exchange_weak(usage, newUsage));
+
+    uint64_t peakUsage = m_PeakUsage.load();
+    while(peakUsage < newUsage && !m_PeakUsage.compare_exchange_weak(peakUsage, newUsage))
+    {
     }
-    return VK_SUCCESS;
+    return true;
 }
 
-void VmaBlockVector::GetPoolStats(VmaPoolStats* pStats)
-{
-    VmaMutexLockRead lock(m_Mutex, m_hAllocator->m_UseMutex);
+////////////////////////////////////////////////////////////////////////////////
+// class VmaAllocationScope_T
 
-    const size_t blockCount = m_Blocks.size();
+VmaAllocationScope_T::VmaAllocationScope_T(VmaAllocator hAllocator) :
+    m_UseMutex(hAllocator->m_UseMutex),
+    m_Allocations(VmaStlAllocator<VmaAllocation>(hAllocator->GetAllocationCallbacks()))
+{
+}
 
-    pStats->size = 0;
-    pStats->unusedSize = 0;
-    pStats->allocationCount = 0;
-    pStats->unusedRangeCount = 0;
-    pStats->unusedRangeSizeMax = 0;
-    pStats->blockCount = blockCount;
+VmaAllocationScope_T::~VmaAllocationScope_T()
+{
+    VMA_ASSERT(m_Allocations.empty());
+}
 
-    for(uint32_t blockIndex = 0; blockIndex < blockCount; ++blockIndex)
+void VmaAllocationScope_T::Add(const VmaAllocation* pAllocations, size_t allocationCount)
+{
+    VmaMutexLock lock(m_Mutex, m_UseMutex);
+    for(size_t allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
     {
-        const VmaDeviceMemoryBlock* const pBlock = m_Blocks[blockIndex];
-        VMA_ASSERT(pBlock);
-        VMA_HEAVY_ASSERT(pBlock->Validate());
-        pBlock->m_pMetadata->AddPoolStats(*pStats);
+        const VmaAllocation hAllocation = pAllocations[allocIndex];
+        VMA_ASSERT(hAllocation->GetScope() == VK_NULL_HANDLE);
+        hAllocation->SetScope(this, (uint32_t)m_Allocations.size());
+        m_Allocations.push_back(hAllocation);
     }
 }
 
-bool VmaBlockVector::IsEmpty()
+void VmaAllocationScope_T::Remove(VmaAllocation hAllocation)
 {
-    VmaMutexLockRead lock(m_Mutex, m_hAllocator->m_UseMutex);
-    return m_Blocks.empty();
+    VmaMutexLock lock(m_Mutex, m_UseMutex);
+    VMA_ASSERT(hAllocation->GetScope() == this);
+    const uint32_t index = hAllocation->GetIndexInScope();
+    VMA_ASSERT(index < m_Allocations.size() && m_Allocations[index] == hAllocation);
+    // Move the last allocation into the freed slot.
+    const VmaAllocation hLastAllocation = m_Allocations.back();
+    m_Allocations[index] = hLastAllocation;
+    hLastAllocation->SetScope(this, index);
+    m_Allocations.pop_back();
+    hAllocation->SetScope(VK_NULL_HANDLE, 0);
 }
 
-bool VmaBlockVector::IsCorruptionDetectionEnabled() const
+void VmaAllocationScope_T::DetachAll(VmaVector< VmaAllocation, VmaStlAllocator<VmaAllocation> >& outAllocations)
 {
-    const uint32_t requiredMemFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    return (VMA_DEBUG_DETECT_CORRUPTION != 0) &&
-        (VMA_DEBUG_MARGIN > 0) &&
-        (m_Algorithm == 0 || m_Algorithm == VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT) &&
-        (m_hAllocator->m_MemProps.memoryTypes[m_MemoryTypeIndex].propertyFlags & requiredMemFlags) == requiredMemFlags;
+    VmaMutexLock lock(m_Mutex, m_UseMutex);
+    for(size_t allocIndex = 0; allocIndex < m_Allocations.size(); ++allocIndex)
+    {
+        const VmaAllocation hAllocation = m_Allocations[allocIndex];
+        hAllocation->SetScope(VK_NULL_HANDLE, 0);
+        outAllocations.push_back(hAllocation);
+    }
+    m_Allocations.clear();
 }
 
-static const uint32_t VMA_ALLOCATION_TRY_COUNT = 32;
+////////////////////////////////////////////////////////////////////////////////
+// class VmaReadbackHeap_T
 
-VkResult VmaBlockVector::Allocate(
-    uint32_t currentFrameIndex,
+VmaReadbackHeap_T::VmaReadbackHeap_T(VmaAllocator hAllocator, const VmaReadbackHeapCreateInfo& createInfo) :
+    m_Buffer(VK_NULL_HANDLE),
+    m_Allocation(VK_NULL_HANDLE),
+    m_UseMutex(hAllocator->m_UseMutex),
+    m_FrameSize(VmaAlignUp(createInfo.frameSize, hAllocator->m_PhysicalDeviceProperties.limits.nonCoherentAtomSize)),
+    m_Slices(createInfo.frameInUseCount + 1, VmaStlAllocator<Slice>(hAllocator->GetAllocationCallbacks()))
+{
+    for(size_t sliceIndex = 0; sliceIndex < m_Slices.size(); ++sliceIndex)
+    {
+        m_Slices[sliceIndex].frameIndex = VMA_FRAME_INDEX_LOST;
+        m_Slices[sliceIndex].usedSize = 0;
+    }
+}
+
+VmaReadbackHeap_T::~VmaReadbackHeap_T()
+{
+    VMA_ASSERT(m_Buffer == VK_NULL_HANDLE && m_Allocation == VK_NULL_HANDLE);
+}
+
+VkResult VmaReadbackHeap_T::Allocate(
+    uint32_t frameIndex,
     VkDeviceSize size,
     VkDeviceSize alignment,
-    const VmaAllocationCreateInfo& createInfo,
-    VmaSuballocationType suballocType,
-    size_t allocationCount,
-    VmaAllocation* pAllocations)
+    VmaReadbackRegion& outRegion)
 {
-    size_t allocIndex;
-    VkResult res = VK_SUCCESS;
+    VmaMutexLock lock(m_Mutex, m_UseMutex);
 
-    if(IsCorruptionDetectionEnabled())
+    const size_t sliceIndex = frameIndex % m_Slices.size();
+    Slice& slice = m_Slices[sliceIndex];
+    if(slice.frameIndex != frameIndex)
     {
-        size = VmaAlignUp<VkDeviceSize>(size, sizeof(VMA_CORRUPTION_DETECTION_MAGIC_VALUE));
-        alignment = VmaAlignUp<VkDeviceSize>(alignment, sizeof(VMA_CORRUPTION_DETECTION_MAGIC_VALUE));
+        // First allocation in this frame. Data of the frame that used the slice before is no longer needed.
+        slice.frameIndex = frameIndex;
+        slice.usedSize = 0;
     }
 
+    const VkDeviceSize sliceOffset = sliceIndex * m_FrameSize;
+    const VkDeviceSize offset = VmaAlignUp(sliceOffset + slice.usedSize, alignment);
+    if(offset + size > sliceOffset + m_FrameSize)
     {
-        VmaMutexLockWrite lock(m_Mutex, m_hAllocator->m_UseMutex);
-        for(allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
-        {
-            res = AllocatePage(
-                currentFrameIndex,
-                size,
-                alignment,
-                createInfo,
-                suballocType,
-                pAllocations + allocIndex);
-            if(res != VK_SUCCESS)
-            {
-                break;
-            }
-        }
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
     }
+    slice.usedSize = offset + size - sliceOffset;
 
-    if(res != VK_SUCCESS)
+    outRegion.buffer = m_Buffer;
+    outRegion.offset = offset;
+    outRegion.size = size;
+    outRegion.pMappedData = (char*)m_Allocation->GetMappedData() + offset;
+    return VK_SUCCESS;
+}
+
+bool VmaReadbackHeap_T::GetFrameRange(uint32_t frameIndex, VkDeviceSize& outOffset, VkDeviceSize& outSize)
+{
+    VmaMutexLock lock(m_Mutex, m_UseMutex);
+
+    const size_t sliceIndex = frameIndex % m_Slices.size();
+    const Slice& slice = m_Slices[sliceIndex];
+    if(slice.frameIndex != frameIndex || slice.usedSize == 0)
     {
-        // Free all already created allocations.
-        while(allocIndex--)
+        return false;
+    }
+    outOffset = sliceIndex * m_FrameSize;
+    outSize = slice.usedSize;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class VmaSparseBuffer_T
+
+VmaSparseBuffer_T::VmaSparseBuffer_T(
+    VmaAllocator hAllocator,
+    const VmaSparseBufferCreateInfo& createInfo,
+    VkDeviceSize pageSize,
+    uint32_t pageCount,
+    uint32_t memoryTypeIndex) :
+    m_Buffer(VK_NULL_HANDLE),
+    m_hAllocator(hAllocator),
+    m_UseMutex(hAllocator->m_UseMutex),
+    m_PageSize(pageSize),
+    m_MemoryTypeIndex(memoryTypeIndex),
+    m_FrameInUseCount(createInfo.frameInUseCount),
+    m_Ranges(VmaStlAllocator<Range>(hAllocator->GetAllocationCallbacks())),
+    m_Pages(pageCount, VmaStlAllocator<Page>(hAllocator->GetAllocationCallbacks())),
+    m_RetiredMemory(VmaStlAllocator<RetiredMemory>(hAllocator->GetAllocationCallbacks())),
+    m_AllocatedSize(0),
+    m_CommittedPageCount(0),
+    m_MemoryCount(0)
+{
+    for(size_t pageIndex = 0; pageIndex < m_Pages.size(); ++pageIndex)
+    {
+        m_Pages[pageIndex].memory = VK_NULL_HANDLE;
+        m_Pages[pageIndex].boundMemory = VK_NULL_HANDLE;
+        m_Pages[pageIndex].rangeCount = 0;
+    }
+}
+
+VmaSparseBuffer_T::~VmaSparseBuffer_T()
+{
+    VMA_ASSERT(m_Buffer == VK_NULL_HANDLE);
+    for(size_t pageIndex = 0; pageIndex < m_Pages.size(); ++pageIndex)
+    {
+        Page& page = m_Pages[pageIndex];
+        if(page.boundMemory != VK_NULL_HANDLE && page.boundMemory != page.memory)
         {
-            Free(pAllocations[allocIndex]);
+            m_hAllocator->FreeVulkanMemory(m_MemoryTypeIndex, m_PageSize, page.boundMemory);
+        }
+        if(page.memory != VK_NULL_HANDLE)
+        {
+            m_hAllocator->FreeVulkanMemory(m_MemoryTypeIndex, m_PageSize, page.memory);
         }
-        memset(pAllocations, 0, sizeof(VmaAllocation) * allocationCount);
     }
-
-    return res;
+    for(size_t retiredIndex = 0; retiredIndex < m_RetiredMemory.size(); ++retiredIndex)
+    {
+        m_hAllocator->FreeVulkanMemory(m_MemoryTypeIndex, m_PageSize, m_RetiredMemory[retiredIndex].memory);
+    }
 }
 
-VkResult VmaBlockVector::AllocatePage(
-    uint32_t currentFrameIndex,
-    VkDeviceSize size,
-    VkDeviceSize alignment,
-    const VmaAllocationCreateInfo& createInfo,
-    VmaSuballocationType suballocType,
-    VmaAllocation* pAllocation)
+void VmaSparseBuffer_T::GetInfo(VmaSparseBufferInfo& outInfo)
 {
-    const bool isUpperAddress = (createInfo.flags & VMA_ALLOCATION_CREATE_UPPER_ADDRESS_BIT) != 0;
-    bool canMakeOtherLost = (createInfo.flags & VMA_ALLOCATION_CREATE_CAN_MAKE_OTHER_LOST_BIT) != 0;
-    const bool mapped = (createInfo.flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0;
-    const bool isUserDataString = (createInfo.flags & VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT) != 0;
+    VmaMutexLock lock(m_Mutex, m_UseMutex);
 
-    VkDeviceSize freeMemory;
+    outInfo.buffer = m_Buffer;
+    outInfo.size = m_PageSize * m_Pages.size();
+    outInfo.pageSize = m_PageSize;
+    outInfo.memoryTypeIndex = m_MemoryTypeIndex;
+    outInfo.committedPageCount = m_CommittedPageCount;
+    outInfo.pendingBindCount = 0;
+    for(size_t pageIndex = 0; pageIndex < m_Pages.size(); ++pageIndex)
     {
-        const uint32_t heapIndex = m_hAllocator->MemoryTypeIndexToHeapIndex(m_MemoryTypeIndex);
-        VmaBudget heapBudget = {};
-        m_hAllocator->GetBudget(&heapBudget, heapIndex, 1);
-        freeMemory = (heapBudget.usage < heapBudget.budget) ? (heapBudget.budget - heapBudget.usage) : 0;
+        if(m_Pages[pageIndex].memory != m_Pages[pageIndex].boundMemory)
+        {
+            ++outInfo.pendingBindCount;
+        }
     }
+    outInfo.allocatedSize = m_AllocatedSize;
+    outInfo.memorySize = m_MemoryCount * m_PageSize;
+}
 
-    const bool canFallbackToDedicated = !IsCustomPool();
-    const bool canCreateNewBlock =
-        ((createInfo.flags & VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT) == 0) &&
-        (m_Blocks.size() < m_MaxBlockCount) &&
-        (freeMemory >= size || !canFallbackToDedicated);
-    uint32_t strategy = createInfo.flags & VMA_ALLOCATION_CREATE_STRATEGY_MASK;
+VkResult VmaSparseBuffer_T::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset)
+{
+    VmaMutexLock lock(m_Mutex, m_UseMutex);
 
-    // If linearAlgorithm is used, canMakeOtherLost is available only when used as ring buffer.
-    // Which in turn is available only when maxBlockCount = 1.
-    if(m_Algorithm == VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT && m_MaxBlockCount > 1)
+    // First fit: find the lowest gap between ranges where the new one fits.
+    const VkDeviceSize bufferSize = m_PageSize * m_Pages.size();
+    const size_t rangeCount = m_Ranges.size();
+    VkDeviceSize prevEnd = 0;
+    size_t insertIndex = 0;
+    VkDeviceSize offset = 0;
+    for(;;)
     {
-        canMakeOtherLost = false;
+        offset = VmaAlignUp(prevEnd, alignment);
+        const VkDeviceSize gapEnd = insertIndex < rangeCount ? m_Ranges[insertIndex].offset : bufferSize;
+        if(offset <= gapEnd && gapEnd - offset >= size)
+        {
+            break;
+        }
+        if(insertIndex == rangeCount)
+        {
+            return VK_ERROR_OUT_OF_POOL_MEMORY;
+        }
+        prevEnd = m_Ranges[insertIndex].offset + m_Ranges[insertIndex].size;
+        ++insertIndex;
     }
 
-    // Upper address can only be used with linear allocator and within single memory block.
-    if(isUpperAddress &&
-        (m_Algorithm != VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT || m_MaxBlockCount > 1))
+    const VkResult res = CommitPages((uint32_t)(offset / m_PageSize), (uint32_t)((offset + size - 1) / m_PageSize));
+    if(res != VK_SUCCESS)
     {
-        return VK_ERROR_FEATURE_NOT_PRESENT;
+        return res;
     }
 
-    // Validate strategy.
-    switch(strategy)
+    const Range range = { offset, size };
+    VmaVectorInsert(m_Ranges, insertIndex, range);
+    m_AllocatedSize += size;
+    outOffset = offset;
+    return VK_SUCCESS;
+}
+
+void VmaSparseBuffer_T::Free(VkDeviceSize offset)
+{
+    VmaMutexLock lock(m_Mutex, m_UseMutex);
+
+    Range* const it = VmaBinaryFindFirstNotLess(
+        m_Ranges.data(),
+        m_Ranges.data() + m_Ranges.size(),
+        offset,
+        RangeOffsetLess());
+    if(it == m_Ranges.data() + m_Ranges.size() || it->offset != offset)
     {
-    case 0:
-        strategy = VMA_ALLOCATION_CREATE_STRATEGY_BEST_FIT_BIT;
-        break;
-    case VMA_ALLOCATION_CREATE_STRATEGY_BEST_FIT_BIT:
-    case VMA_ALLOCATION_CREATE_STRATEGY_WORST_FIT_BIT:
-    case VMA_ALLOCATION_CREATE_STRATEGY_FIRST_FIT_BIT:
-        break;
-    default:
-        return VK_ERROR_FEATURE_NOT_PRESENT;
+        VMA_ASSERT(0 && "Range to free not found in sparse buffer.");
+        return;
     }
 
-    // Early reject: requested allocation size is larger that maximum block size for this block vector.
-    if(size + 2 * VMA_DEBUG_MARGIN > m_PreferredBlockSize)
+    const Range range = *it;
+    VmaVectorRemove(m_Ranges, (size_t)(it - m_Ranges.data()));
+    m_AllocatedSize -= range.size;
+    DecommitPages((uint32_t)(range.offset / m_PageSize), (uint32_t)((range.offset + range.size - 1) / m_PageSize));
+}
+
+void VmaSparseBuffer_T::GatherBinds(VmaVector< VkSparseMemoryBind, VmaStlAllocator<VkSparseMemoryBind> >& binds) const
+{
+    for(size_t pageIndex = 0; pageIndex < m_Pages.size(); ++pageIndex)
     {
-        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        const Page& page = m_Pages[pageIndex];
+        if(page.memory == page.boundMemory)
+        {
+            continue;
+        }
+        const VkDeviceSize resourceOffset = pageIndex * m_PageSize;
+        // Unbinding of adjacent pages can be done with a single bind of null memory.
+        if(page.memory == VK_NULL_HANDLE && !binds.empty() &&
+            binds.back().memory == VK_NULL_HANDLE &&
+            binds.back().resourceOffset + binds.back().size == resourceOffset)
+        {
+            binds.back().size += m_PageSize;
+        }
+        else
+        {
+            VkSparseMemoryBind bind = {};
+            bind.resourceOffset = resourceOffset;
+            bind.size = m_PageSize;
+            bind.memory = page.memory;
+            bind.memoryOffset = 0;
+            binds.push_back(bind);
+        }
     }
+}
 
-    /*
-    Under certain condition, this whole section can be skipped for optimization, so
-    we move on directly to trying to allocate with canMakeOtherLost. That's the case
-    e.g. for custom pools with linear algorithm.
-    */
-    if(!canMakeOtherLost || canCreateNewBlock)
+void VmaSparseBuffer_T::ApplyBinds(uint32_t currentFrameIndex)
+{
+    for(size_t pageIndex = 0; pageIndex < m_Pages.size(); ++pageIndex)
     {
-        // 1. Search existing allocations. Try to allocate without making other allocations lost.
-        VmaAllocationCreateFlags allocFlagsCopy = createInfo.flags;
-        allocFlagsCopy &= ~VMA_ALLOCATION_CREATE_CAN_MAKE_OTHER_LOST_BIT;
-
-        if(m_Algorithm == VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT)
+        Page& page = m_Pages[pageIndex];
+        if(page.memory != page.boundMemory)
         {
-            // Use only last block.
-            if(!m_Blocks.empty())
+            const VkDeviceMemory prevMemory = page.boundMemory;
+            page.boundMemory = page.memory;
+            if(prevMemory != VK_NULL_HANDLE)
             {
-                VmaDeviceMemoryBlock* const pCurrBlock = m_Blocks.back();
-                VMA_ASSERT(pCurrBlock);
-                VkResult res = AllocateFromBlock(
-                    pCurrBlock,
-                    currentFrameIndex,
-                    size,
-                    alignment,
-                    allocFlagsCopy,
-                    createInfo.pUserData,
-                    suballocType,
-                    strategy,
-                    pAllocation);
-                if(res == VK_SUCCESS)
-                {
-                    VMA_DEBUG_LOG("    Returned from last block #%u", pCurrBlock->GetId());
-                    return VK_SUCCESS;
-                }
+                RetireMemory(prevMemory, currentFrameIndex);
             }
         }
-        else
+    }
+}
+
+void VmaSparseBuffer_T::FreeRetiredMemory(uint32_t currentFrameIndex)
+{
+    size_t freeCount = 0;
+    while(freeCount < m_RetiredMemory.size() &&
+        m_RetiredMemory[freeCount].frameIndex + m_FrameInUseCount < currentFrameIndex)
+    {
+        m_hAllocator->FreeVulkanMemory(m_MemoryTypeIndex, m_PageSize, m_RetiredMemory[freeCount].memory);
+        --m_MemoryCount;
+        ++freeCount;
+    }
+    if(freeCount > 0)
+    {
+        const size_t remainingCount = m_RetiredMemory.size() - freeCount;
+        for(size_t retiredIndex = 0; retiredIndex < remainingCount; ++retiredIndex)
         {
-            if(strategy == VMA_ALLOCATION_CREATE_STRATEGY_BEST_FIT_BIT)
+            m_RetiredMemory[retiredIndex] = m_RetiredMemory[retiredIndex + freeCount];
+        }
+        m_RetiredMemory.resize(remainingCount);
+    }
+}
+
+VkResult VmaSparseBuffer_T::CommitPages(uint32_t firstPage, uint32_t lastPage)
+{
+    for(uint32_t pageIndex = firstPage; pageIndex <= lastPage; ++pageIndex)
+    {
+        Page& page = m_Pages[pageIndex];
+        if(page.rangeCount == 0)
+        {
+            VMA_ASSERT(page.memory == VK_NULL_HANDLE);
+            if(page.boundMemory != VK_NULL_HANDLE)
             {
-                // Forward order in m_Blocks - prefer blocks with smallest amount of free space.
-                for(size_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex )
-                {
-                    VmaDeviceMemoryBlock* const pCurrBlock = m_Blocks[blockIndex];
-                    VMA_ASSERT(pCurrBlock);
-                    VkResult res = AllocateFromBlock(
-                        pCurrBlock,
-                        currentFrameIndex,
-                        size,
-                        alignment,
-                        allocFlagsCopy,
-                        createInfo.pUserData,
-                        suballocType,
-                        strategy,
-                        pAllocation);
-                    if(res == VK_SUCCESS)
-                    {
-                        VMA_DEBUG_LOG("    Returned from existing block #%u", pCurrBlock->GetId());
-                        return VK_SUCCESS;
-                    }
-                }
+                // Unbind of this page hasn't been submitted yet - just keep the memory.
+                page.memory = page.boundMemory;
             }
-            else // WORST_FIT, FIRST_FIT
+            else if(!m_RetiredMemory.empty())
             {
-                // Backward order in m_Blocks - prefer blocks with largest amount of free space.
-                for(size_t blockIndex = m_Blocks.size(); blockIndex--; )
+                // Most recently retired memory is the least likely to be freed soon.
+                page.memory = m_RetiredMemory.back().memory;
+                m_RetiredMemory.pop_back();
+            }
+            else
+            {
+                VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+                allocInfo.memoryTypeIndex = m_MemoryTypeIndex;
+                allocInfo.allocationSize = m_PageSize;
+                const VkResult res = m_hAllocator->AllocateVulkanMemory(&allocInfo, &page.memory);
+                if(res != VK_SUCCESS)
                 {
-                    VmaDeviceMemoryBlock* const pCurrBlock = m_Blocks[blockIndex];
-                    VMA_ASSERT(pCurrBlock);
-                    VkResult res = AllocateFromBlock(
-                        pCurrBlock,
-                        currentFrameIndex,
-                        size,
-                        alignment,
-                        allocFlagsCopy,
-                        createInfo.pUserData,
-                        suballocType,
-                        strategy,
-                        pAllocation);
-                    if(res == VK_SUCCESS)
+                    page.memory = VK_NULL_HANDLE;
+                    if(pageIndex > firstPage)
                     {
-                        VMA_DEBUG_LOG("    Returned from existing block #%u", pCurrBlock->GetId());
-                        return VK_SUCCESS;
+                        DecommitPages(firstPage, pageIndex - 1);
                     }
+                    return res;
                 }
+                ++m_MemoryCount;
             }
+            ++m_CommittedPageCount;
         }
+        ++page.rangeCount;
+    }
+    return VK_SUCCESS;
+}
 
-        // 2. Try to create new block.
-        if(canCreateNewBlock)
+void VmaSparseBuffer_T::DecommitPages(uint32_t firstPage, uint32_t lastPage)
+{
+    for(uint32_t pageIndex = firstPage; pageIndex <= lastPage; ++pageIndex)
+    {
+        Page& page = m_Pages[pageIndex];
+        VMA_ASSERT(page.rangeCount > 0 && page.memory != VK_NULL_HANDLE);
+        if(--page.rangeCount == 0)
         {
-            // Calculate optimal size for new block.
-            VkDeviceSize newBlockSize = m_PreferredBlockSize;
-            uint32_t newBlockSizeShift = 0;
-            const uint32_t NEW_BLOCK_SIZE_SHIFT_MAX = 3;
-
-            if(!m_ExplicitBlockSize)
+            // Memory still bound is retired after its unbind is submitted.
+            if(page.memory != page.boundMemory)
             {
-                // Allocate 1/8, 1/4, 1/2 as first blocks.
-                const VkDeviceSize maxExistingBlockSize = CalcMaxBlockSize();
-                for(uint32_t i = 0; i < NEW_BLOCK_SIZE_SHIFT_MAX; ++i)
-                {
-                    const VkDeviceSize smallerNewBlockSize = newBlockSize / 2;
-                    if(smallerNewBlockSize > maxExistingBlockSize && smallerNewBlockSize >= size * 2)
-                    {
-                        newBlockSize = smallerNewBlockSize;
-                        ++newBlockSizeShift;
-                    }
-                    else
-                    {
-                        break;
-                    }
-                }
+                RetireMemory(page.memory, m_hAllocator->GetCurrentFrameIndex());
             }
+            page.memory = VK_NULL_HANDLE;
+            --m_CommittedPageCount;
+        }
+    }
+}
 
-            size_t newBlockIndex = 0;
-            VkResult res = (newBlockSize <= freeMemory || !canFallbackToDedicated) ?
-                CreateBlock(newBlockSize, &newBlockIndex) : VK_ERROR_OUT_OF_DEVICE_MEMORY;
-            // Allocation of this size failed? Try 1/2, 1/4, 1/8 of m_PreferredBlockSize.
-            if(!m_ExplicitBlockSize)
-            {
-                while(res < 0 && newBlockSizeShift < NEW_BLOCK_SIZE_SHIFT_MAX)
-                {
-                    const VkDeviceSize smallerNewBlockSize = newBlockSize / 2;
-                    if(smallerNewBlockSize >= size)
-                    {
-                        newBlockSize = smallerNewBlockSize;
-                        ++newBlockSizeShift;
-                        res = (newBlockSize <= freeMemory || !canFallbackToDedicated) ?
-                            CreateBlock(newBlockSize, &newBlockIndex) : VK_ERROR_OUT_OF_DEVICE_MEMORY;
-                    }
-                    else
-                    {
-                        break;
-                    }
-                }
-            }
+void VmaSparseBuffer_T::RetireMemory(VkDeviceMemory memory, uint32_t frameIndex)
+{
+    const RetiredMemory retiredMemory = { memory, frameIndex };
+    m_RetiredMemory.push_back(retiredMemory);
+}
 
-            if(res == VK_SUCCESS)
-            {
-                VmaDeviceMemoryBlock* const pBlock = m_Blocks[newBlockIndex];
-                VMA_ASSERT(pBlock->m_pMetadata->GetSize() >= size);
+////////////////////////////////////////////////////////////////////////////////
+// class VmaSparsePagePool_T
 
-                res = AllocateFromBlock(
-                    pBlock,
-                    currentFrameIndex,
-                    size,
-                    alignment,
-                    allocFlagsCopy,
-                    createInfo.pUserData,
-                    suballocType,
-                    strategy,
-                    pAllocation);
-                if(res == VK_SUCCESS)
-                {
-                    VMA_DEBUG_LOG("    Created new block #%u Size=%llu", pBlock->GetId(), newBlockSize);
-                    return VK_SUCCESS;
-                }
-                else
-                {
-                    // Allocation from new block failed, possibly due to VMA_DEBUG_MARGIN or alignment.
-                    return VK_ERROR_OUT_OF_DEVICE_MEMORY;
-                }
-            }
+VmaSparsePagePool_T::VmaSparsePagePool_T(
+    VmaAllocator hAllocator,
+    const VmaSparsePagePoolCreateInfo& createInfo,
+    VkDeviceSize pageSize,
+    uint32_t pagesPerBlock,
+    uint32_t memoryTypeIndex) :
+    m_hAllocator(hAllocator),
+    m_UseMutex(hAllocator->m_UseMutex),
+    m_PageSize(pageSize),
+    m_PagesPerBlock(pagesPerBlock),
+    m_WordsPerBlock((pagesPerBlock + 63) / 64),
+    m_MemoryTypeIndex(memoryTypeIndex),
+    m_MaxBlockCount(createInfo.maxBlockCount != 0 ? createInfo.maxBlockCount : SIZE_MAX),
+    m_Blocks(VmaStlAllocator<Block>(hAllocator->GetAllocationCallbacks())),
+    m_FreeBitmap(VmaStlAllocator<uint64_t>(hAllocator->GetAllocationCallbacks())),
+    m_BlockIndex(VmaStlAllocator<BlockIndexItem>(hAllocator->GetAllocationCallbacks())),
+    m_FirstFreeBlockIndex(0),
+    m_EmptyBlockCount(0),
+    m_AllocatedPageCount(0)
+{
+}
+
+VmaSparsePagePool_T::~VmaSparsePagePool_T()
+{
+    for(size_t blockIndex = m_Blocks.size(); blockIndex--; )
+    {
+        if(m_Blocks[blockIndex].memory != VK_NULL_HANDLE)
+        {
+            m_hAllocator->FreeVulkanMemory(m_MemoryTypeIndex, GetBlockSize(), m_Blocks[blockIndex].memory);
         }
     }
+}
 
-    // 3. Try to allocate from existing blocks with making other allocations lost.
-    if(canMakeOtherLost)
+void VmaSparsePagePool_T::GetStats(VmaPoolStats& outStats)
+{
+    VmaMutexLock lock(m_Mutex, m_UseMutex);
+
+    outStats.blockCount = m_BlockIndex.size();
+    outStats.size = GetBlockSize() * outStats.blockCount;
+    outStats.allocationCount = m_AllocatedPageCount;
+    outStats.unusedRangeCount = outStats.blockCount * m_PagesPerBlock - m_AllocatedPageCount;
+    outStats.unusedSize = m_PageSize * outStats.unusedRangeCount;
+    outStats.unusedRangeSizeMax = outStats.unusedRangeCount > 0 ? m_PageSize : 0;
+}
+
+template<typename BindT>
+VkResult VmaSparsePagePool_T::AllocatePages(uint32_t bindCount, BindT* pBinds)
+{
+    VmaMutexLock lock(m_Mutex, m_UseMutex);
+
+    for(uint32_t bindIndex = 0; bindIndex < bindCount; ++bindIndex)
     {
-        uint32_t tryIndex = 0;
-        for(; tryIndex < VMA_ALLOCATION_TRY_COUNT; ++tryIndex)
+        VMA_ASSERT(BindFitsPage(pBinds[bindIndex]) && "Bind is larger than page size of the sparse page pool.");
+        const VkResult res = AllocatePage(pBinds[bindIndex].memory, pBinds[bindIndex].memoryOffset);
+        if(res != VK_SUCCESS)
         {
-            VmaDeviceMemoryBlock* pBestRequestBlock = VMA_NULL;
-            VmaAllocationRequest bestRequest = {};
-            VkDeviceSize bestRequestCost = VK_WHOLE_SIZE;
-
-            // 1. Search existing allocations.
-            if(strategy == VMA_ALLOCATION_CREATE_STRATEGY_BEST_FIT_BIT)
+            // Free pages allocated so far, in reverse order so that blocks created for them go away first.
+            for(uint32_t freeIndex = bindIndex; freeIndex--; )
             {
-                // Forward order in m_Blocks - prefer blocks with smallest amount of free space.
-                for(size_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex )
-                {
-                    VmaDeviceMemoryBlock* const pCurrBlock = m_Blocks[blockIndex];
-                    VMA_ASSERT(pCurrBlock);
-                    VmaAllocationRequest currRequest = {};
-                    if(pCurrBlock->m_pMetadata->CreateAllocationRequest(
-                        currentFrameIndex,
-                        m_FrameInUseCount,
-                        m_BufferImageGranularity,
-                        size,
-                        alignment,
-                        (createInfo.flags & VMA_ALLOCATION_CREATE_UPPER_ADDRESS_BIT) != 0,
-                        suballocType,
-                        canMakeOtherLost,
-                        strategy,
-                        &currRequest))
-                    {
-                        const VkDeviceSize currRequestCost = currRequest.CalcCost();
-                        if(pBestRequestBlock == VMA_NULL ||
-                            currRequestCost < bestRequestCost)
-                        {
-                            pBestRequestBlock = pCurrBlock;
-                            bestRequest = currRequest;
-                            bestRequestCost = currRequestCost;
-
-                            if(bestRequestCost == 0)
-                            {
-                                break;
-                            }
-                        }
-                    }
-                }
+                FreePage(pBinds[freeIndex].memory, pBinds[freeIndex].memoryOffset);
             }
-            else // WORST_FIT, FIRST_FIT
+            for(uint32_t resetIndex = 0; resetIndex < bindCount; ++resetIndex)
             {
-                // Backward order in m_Blocks - prefer blocks with largest amount of free space.
-                for(size_t blockIndex = m_Blocks.size(); blockIndex--; )
-                {
-                    VmaDeviceMemoryBlock* const pCurrBlock = m_Blocks[blockIndex];
-                    VMA_ASSERT(pCurrBlock);
-                    VmaAllocationRequest currRequest = {};
-                    if(pCurrBlock->m_pMetadata->CreateAllocationRequest(
-                        currentFrameIndex,
-                        m_FrameInUseCount,
-                        m_BufferImageGranularity,
-                        size,
-                        alignment,
-                        (createInfo.flags & VMA_ALLOCATION_CREATE_UPPER_ADDRESS_BIT) != 0,
-                        suballocType,
-                        canMakeOtherLost,
-                        strategy,
-                        &currRequest))
-                    {
-                        const VkDeviceSize currRequestCost = currRequest.CalcCost();
-                        if(pBestRequestBlock == VMA_NULL ||
-                            currRequestCost < bestRequestCost ||
-                            strategy == VMA_ALLOCATION_CREATE_STRATEGY_FIRST_FIT_BIT)
-                        {
-                            pBestRequestBlock = pCurrBlock;
-                            bestRequest = currRequest;
-                            bestRequestCost = currRequestCost;
-
-                            if(bestRequestCost == 0 ||
-                                strategy == VMA_ALLOCATION_CREATE_STRATEGY_FIRST_FIT_BIT)
-                            {
-                                break;
-                            }
-                        }
-                    }
-                }
+                pBinds[resetIndex].memory = VK_NULL_HANDLE;
             }
+            return res;
+        }
+    }
+    return VK_SUCCESS;
+}
 
-            if(pBestRequestBlock != VMA_NULL)
-            {
-                if(mapped)
-                {
-                    VkResult res = pBestRequestBlock->Map(m_hAllocator, 1, VMA_NULL);
-                    if(res != VK_SUCCESS)
-                    {
-                        return res;
-                    }
-                }
+template<typename BindT>
+void VmaSparsePagePool_T::FreePages(uint32_t bindCount, const BindT* pBinds)
+{
+    VmaMutexLock lock(m_Mutex, m_UseMutex);
 
-                if(pBestRequestBlock->m_pMetadata->MakeRequestedAllocationsLost(
-                    currentFrameIndex,
-                    m_FrameInUseCount,
-                    &bestRequest))
-                {
-                    // Allocate from this pBlock.
-                    *pAllocation = m_hAllocator->m_AllocationObjectAllocator.Allocate(currentFrameIndex, isUserDataString);
-                    pBestRequestBlock->m_pMetadata->Alloc(bestRequest, suballocType, size, *pAllocation);
-                    UpdateHasEmptyBlock();
-                    (*pAllocation)->InitBlockAllocation(
-                        pBestRequestBlock,
-                        bestRequest.offset,
-                        alignment,
-                        size,
-                        m_MemoryTypeIndex,
-                        suballocType,
-                        mapped,
-                        (createInfo.flags & VMA_ALLOCATION_CREATE_CAN_BECOME_LOST_BIT) != 0);
-                    VMA_HEAVY_ASSERT(pBestRequestBlock->Validate());
-                    VMA_DEBUG_LOG("    Returned from existing block");
-                    (*pAllocation)->SetUserData(m_hAllocator, createInfo.pUserData);
-                    m_hAllocator->m_Budget.AddAllocation(m_hAllocator->MemoryTypeIndexToHeapIndex(m_MemoryTypeIndex), size);
-                    if(VMA_DEBUG_INITIALIZE_ALLOCATIONS)
-                    {
-                        m_hAllocator->FillAllocation(*pAllocation, VMA_ALLOCATION_FILL_PATTERN_CREATED);
-                    }
-                    if(IsCorruptionDetectionEnabled())
-                    {
-                        VkResult res = pBestRequestBlock->WriteMagicValueAroundAllocation(m_hAllocator, bestRequest.offset, size);
-                        VMA_ASSERT(res == VK_SUCCESS && "Couldn't map block memory to write magic value.");
-                    }
-                    return VK_SUCCESS;
-                }
-                // else: Some allocations must have been touched while we are here. Next try.
-            }
-            else
-            {
-                // Could not find place in any of the blocks - break outer loop.
-                break;
-            }
-        }
-        /* Maximum number of tries exceeded - a very unlike event when many other
-        threads are simultaneously touching allocations making it impossible to make
-        lost at the same time as we try to allocate. */
-        if(tryIndex == VMA_ALLOCATION_TRY_COUNT)
+    for(uint32_t bindIndex = 0; bindIndex < bindCount; ++bindIndex)
+    {
+        if(pBinds[bindIndex].memory != VK_NULL_HANDLE)
         {
-            return VK_ERROR_TOO_MANY_OBJECTS;
+            FreePage(pBinds[bindIndex].memory, pBinds[bindIndex].memoryOffset);
         }
     }
-
-    return VK_ERROR_OUT_OF_DEVICE_MEMORY;
 }
 
-void VmaBlockVector::Free(
-    const VmaAllocation hAllocation)
+VkResult VmaSparsePagePool_T::AllocatePage(VkDeviceMemory& outMemory, VkDeviceSize& outOffset)
 {
-    VmaDeviceMemoryBlock* pBlockToDelete = VMA_NULL;
-
-    bool budgetExceeded = false;
+    size_t blockIndex = m_FirstFreeBlockIndex;
+    while(blockIndex < m_Blocks.size() &&
+        (m_Blocks[blockIndex].memory == VK_NULL_HANDLE || m_Blocks[blockIndex].freePageCount == 0))
     {
-        const uint32_t heapIndex = m_hAllocator->MemoryTypeIndexToHeapIndex(m_MemoryTypeIndex);
-        VmaBudget heapBudget = {};
-        m_hAllocator->GetBudget(&heapBudget, heapIndex, 1);
-        budgetExceeded = heapBudget.usage >= heapBudget.budget;
+        ++blockIndex;
     }
+    m_FirstFreeBlockIndex = blockIndex;
 
-    // Scope for lock.
+    if(blockIndex == m_Blocks.size())
     {
-        VmaMutexLockWrite lock(m_Mutex, m_hAllocator->m_UseMutex);
-
-        VmaDeviceMemoryBlock* pBlock = hAllocation->GetBlock();
-
-        if(IsCorruptionDetectionEnabled())
-        {
-            VkResult res = pBlock->ValidateMagicValueAroundAllocation(m_hAllocator, hAllocation->GetOffset(), hAllocation->GetSize());
-            VMA_ASSERT(res == VK_SUCCESS && "Couldn't map block memory to validate magic value.");
-        }
-
-        if(hAllocation->IsPersistentMap())
-        {
-            pBlock->Unmap(m_hAllocator, 1);
-        }
-
-        pBlock->m_pMetadata->Free(hAllocation);
-        VMA_HEAVY_ASSERT(pBlock->Validate());
-
-        VMA_DEBUG_LOG("  Freed from MemoryTypeIndex=%u", m_MemoryTypeIndex);
-
-        const bool canDeleteBlock = m_Blocks.size() > m_MinBlockCount;
-        // pBlock became empty after this deallocation.
-        if(pBlock->m_pMetadata->IsEmpty())
-        {
-            // Already has empty block. We don't want to have two, so delete this one.
-            if((m_HasEmptyBlock || budgetExceeded) && canDeleteBlock)
-            {
-                pBlockToDelete = pBlock;
-                Remove(pBlock);
-            }
-            // else: We now have an empty block - leave it.
-        }
-        // pBlock didn't become empty, but we have another empty block - find and free that one.
-        // (This is optional, heuristics.)
-        else if(m_HasEmptyBlock && canDeleteBlock)
+        const VkResult res = CreateBlock(blockIndex);
+        if(res != VK_SUCCESS)
         {
-            VmaDeviceMemoryBlock* pLastBlock = m_Blocks.back();
-            if(pLastBlock->m_pMetadata->IsEmpty())
-            {
-                pBlockToDelete = pLastBlock;
-                m_Blocks.pop_back();
-            }
+            return res;
         }
-
-        UpdateHasEmptyBlock();
-        IncrementallySortBlocks();
     }
 
-    // Destruction of a free block. Deferred until this point, outside of mutex
-    // lock, for performance reason.
-    if(pBlockToDelete != VMA_NULL)
+    Block& block = m_Blocks[blockIndex];
+    uint64_t* const bitmap = GetBlockBitmap(blockIndex);
+    uint32_t wordIndex = 0;
+    while(bitmap[wordIndex] == 0)
     {
-        VMA_DEBUG_LOG("    Deleted empty block");
-        pBlockToDelete->Destroy(m_hAllocator);
-        vma_delete(m_hAllocator, pBlockToDelete);
+        ++wordIndex;
+        VMA_ASSERT(wordIndex < m_WordsPerBlock);
     }
-}
+    const uint32_t bitIndex = VmaBitScanLSB(bitmap[wordIndex]);
+    bitmap[wordIndex] &= ~(1ull << bitIndex);
 
-VkDeviceSize VmaBlockVector::CalcMaxBlockSize() const
-{
-    VkDeviceSize result = 0;
-    for(size_t i = m_Blocks.size(); i--; )
+    if(block.freePageCount == m_PagesPerBlock)
     {
-        result = VMA_MAX(result, m_Blocks[i]->m_pMetadata->GetSize());
-        if(result >= m_PreferredBlockSize)
-        {
-            break;
-        }
+        --m_EmptyBlockCount;
     }
-    return result;
-}
+    --block.freePageCount;
+    ++m_AllocatedPageCount;
 
-void VmaBlockVector::Remove(VmaDeviceMemoryBlock* pBlock)
-{
-    for(uint32_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex)
-    {
-        if(m_Blocks[blockIndex] == pBlock)
-        {
-            VmaVectorRemove(m_Blocks, blockIndex);
-            return;
-        }
-    }
-    VMA_ASSERT(0);
+    outMemory = block.memory;
+    outOffset = (wordIndex * 64 + bitIndex) * m_PageSize;
+    return VK_SUCCESS;
 }
 
-void VmaBlockVector::IncrementallySortBlocks()
+void VmaSparsePagePool_T::FreePage(VkDeviceMemory memory, VkDeviceSize offset)
 {
-    if(m_Algorithm != VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT)
+    const BlockIndexItem* const it = VmaBinaryFindFirstNotLess(
+        m_BlockIndex.data(),
+        m_BlockIndex.data() + m_BlockIndex.size(),
+        memory,
+        BlockIndexItemMemoryLess());
+    if(it == m_BlockIndex.data() + m_BlockIndex.size() || it->memory != memory)
     {
-        // Bubble sort only until first swap.
-        for(size_t i = 1; i < m_Blocks.size(); ++i)
-        {
-            if(m_Blocks[i - 1]->m_pMetadata->GetSumFreeSize() > m_Blocks[i]->m_pMetadata->GetSumFreeSize())
-            {
-                VMA_SWAP(m_Blocks[i - 1], m_Blocks[i]);
-                return;
-            }
-        }
+        VMA_ASSERT(0 && "Page to free not found in sparse page pool.");
+        return;
     }
-}
-
-VkResult VmaBlockVector::AllocateFromBlock(
-    VmaDeviceMemoryBlock* pBlock,
-    uint32_t currentFrameIndex,
-    VkDeviceSize size,
-    VkDeviceSize alignment,
-    VmaAllocationCreateFlags allocFlags,
-    void* pUserData,
-    VmaSuballocationType suballocType,
-    uint32_t strategy,
-    VmaAllocation* pAllocation)
-{
-    VMA_ASSERT((allocFlags & VMA_ALLOCATION_CREATE_CAN_MAKE_OTHER_LOST_BIT) == 0);
-    const bool isUpperAddress = (allocFlags & VMA_ALLOCATION_CREATE_UPPER_ADDRESS_BIT) != 0;
-    const bool mapped = (allocFlags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0;
-    const bool isUserDataString = (allocFlags & VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT) != 0;
+    const size_t blockIndex = it->blockIndex;
+    Block& block = m_Blocks[blockIndex];
 
-    VmaAllocationRequest currRequest = {};
-    if(pBlock->m_pMetadata->CreateAllocationRequest(
-        currentFrameIndex,
-        m_FrameInUseCount,
-        m_BufferImageGranularity,
-        size,
-        alignment,
-        isUpperAddress,
-        suballocType,
-        false, // canMakeOtherLost
-        strategy,
-        &currRequest))
-    {
-        // Allocate from pCurrBlock.
-        VMA_ASSERT(currRequest.itemsToMakeLostCount == 0);
+    VMA_ASSERT(offset % m_PageSize == 0 && offset < GetBlockSize());
+    const uint32_t pageIndex = (uint32_t)(offset / m_PageSize);
+    uint64_t& word = GetBlockBitmap(blockIndex)[pageIndex / 64];
+    const uint64_t bit = 1ull << (pageIndex % 64);
+    VMA_ASSERT((word & bit) == 0 && "Page freed twice.");
+    word |= bit;
 
-        if(mapped)
-        {
-            VkResult res = pBlock->Map(m_hAllocator, 1, VMA_NULL);
-            if(res != VK_SUCCESS)
-            {
-                return res;
-            }
-        }
+    ++block.freePageCount;
+    --m_AllocatedPageCount;
+    m_FirstFreeBlockIndex = VMA_MIN(m_FirstFreeBlockIndex, blockIndex);
 
-        *pAllocation = m_hAllocator->m_AllocationObjectAllocator.Allocate(currentFrameIndex, isUserDataString);
-        pBlock->m_pMetadata->Alloc(currRequest, suballocType, size, *pAllocation);
-        UpdateHasEmptyBlock();
-        (*pAllocation)->InitBlockAllocation(
-            pBlock,
-            currRequest.offset,
-            alignment,
-            size,
-            m_MemoryTypeIndex,
-            suballocType,
-            mapped,
-            (allocFlags & VMA_ALLOCATION_CREATE_CAN_BECOME_LOST_BIT) != 0);
-        VMA_HEAVY_ASSERT(pBlock->Validate());
-        (*pAllocation)->SetUserData(m_hAllocator, pUserData);
-        m_hAllocator->m_Budget.AddAllocation(m_hAllocator->MemoryTypeIndexToHeapIndex(m_MemoryTypeIndex), size);
-        if(VMA_DEBUG_INITIALIZE_ALLOCATIONS)
+    // Keep at most one empty block.
+    if(block.freePageCount == m_PagesPerBlock)
+    {
+        if(m_EmptyBlockCount > 0)
         {
-            m_hAllocator->FillAllocation(*pAllocation, VMA_ALLOCATION_FILL_PATTERN_CREATED);
+            DestroyBlock(blockIndex);
         }
-        if(IsCorruptionDetectionEnabled())
+        else
         {
-            VkResult res = pBlock->WriteMagicValueAroundAllocation(m_hAllocator, currRequest.offset, size);
-            VMA_ASSERT(res == VK_SUCCESS && "Couldn't map block memory to write magic value.");
+            ++m_EmptyBlockCount;
         }
-        return VK_SUCCESS;
     }
-    return VK_ERROR_OUT_OF_DEVICE_MEMORY;
 }
 
-VkResult VmaBlockVector::CreateBlock(VkDeviceSize blockSize, size_t* pNewBlockIndex)
+VkResult VmaSparsePagePool_T::CreateBlock(size_t& outBlockIndex)
 {
-    VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    allocInfo.memoryTypeIndex = m_MemoryTypeIndex;
-    allocInfo.allocationSize = blockSize;
-
-#if VMA_BUFFER_DEVICE_ADDRESS
-    // Every standalone block can potentially contain a buffer with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT - always enable the feature.
-    VkMemoryAllocateFlagsInfoKHR allocFlagsInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO_KHR };
-    if(m_hAllocator->m_UseKhrBufferDeviceAddress)
+    if(m_BlockIndex.size() >= m_MaxBlockCount)
     {
-        allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR;
-        VmaPnextChainPushFront(&allocInfo, &allocFlagsInfo);
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
     }
-#endif // #if VMA_BUFFER_DEVICE_ADDRESS
 
-    VkDeviceMemory mem = VK_NULL_HANDLE;
-    VkResult res = m_hAllocator->AllocateVulkanMemory(&allocInfo, &mem);
-    if(res < 0)
+    VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    allocInfo.memoryTypeIndex = m_MemoryTypeIndex;
+    allocInfo.allocationSize = GetBlockSize();
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    const VkResult res = m_hAllocator->AllocateVulkanMemory(&allocInfo, &memory);
+    if(res != VK_SUCCESS)
     {
         return res;
     }
 
-    // New VkDeviceMemory successfully created.
-
-    // Create new Allocation for it.
-    VmaDeviceMemoryBlock* const pBlock = vma_new(m_hAllocator, VmaDeviceMemoryBlock)(m_hAllocator);
-    pBlock->Init(
-        m_hAllocator,
-        m_hParentPool,
-        m_MemoryTypeIndex,
-        mem,
-        allocInfo.allocationSize,
-        m_NextBlockId++,
-        m_Algorithm);
+    // Reuse slot of a destroyed block or append a new one.
+    size_t blockIndex = 0;
+    while(blockIndex < m_Blocks.size() && m_Blocks[blockIndex].memory != VK_NULL_HANDLE)
+    {
+        ++blockIndex;
+    }
+    if(blockIndex == m_Blocks.size())
+    {
+        const Block newBlock = { VK_NULL_HANDLE, 0 };
+        m_Blocks.push_back(newBlock);
+        m_FreeBitmap.resize(m_FreeBitmap.size() + m_WordsPerBlock);
+    }
+    m_Blocks[blockIndex].memory = memory;
+    m_Blocks[blockIndex].freePageCount = m_PagesPerBlock;
 
-    m_Blocks.push_back(pBlock);
-    if(pNewBlockIndex != VMA_NULL)
+    uint64_t* const bitmap = GetBlockBitmap(blockIndex);
+    for(uint32_t wordIndex = 0; wordIndex < m_WordsPerBlock; ++wordIndex)
     {
-        *pNewBlockIndex = m_Blocks.size() - 1;
+        bitmap[wordIndex] = UINT64_MAX;
+    }
+    const uint32_t lastWordPageCount = m_PagesPerBlock % 64;
+    if(lastWordPageCount != 0)
+    {
+        bitmap[m_WordsPerBlock - 1] = (1ull << lastWordPageCount) - 1;
     }
 
+    const BlockIndexItem indexItem = { memory, blockIndex };
+    const size_t indexToInsert = VmaBinaryFindFirstNotLess(
+        m_BlockIndex.data(),
+        m_BlockIndex.data() + m_BlockIndex.size(),
+        memory,
+        BlockIndexItemMemoryLess()) - m_BlockIndex.data();
+    VmaVectorInsert(m_BlockIndex, indexToInsert, indexItem);
+
+    ++m_EmptyBlockCount;
+    m_FirstFreeBlockIndex = VMA_MIN(m_FirstFreeBlockIndex, blockIndex);
+    outBlockIndex = blockIndex;
     return VK_SUCCESS;
 }
 
-void VmaBlockVector::ApplyDefragmentationMovesCpu(
-    class VmaBlockVectorDefragmentationContext* pDefragCtx,
-    const VmaVector< VmaDefragmentationMove, VmaStlAllocator<VmaDefragmentationMove> >& moves)
+void VmaSparsePagePool_T::DestroyBlock(size_t blockIndex)
 {
-    const size_t blockCount = m_Blocks.size();
-    const bool isNonCoherent = m_hAllocator->IsMemoryTypeNonCoherent(m_MemoryTypeIndex);
+    Block& block = m_Blocks[blockIndex];
+    VMA_ASSERT(block.freePageCount == m_PagesPerBlock);
 
-    enum BLOCK_FLAG
-    {
-        BLOCK_FLAG_USED = 0x00000001,
-        BLOCK_FLAG_MAPPED_FOR_DEFRAGMENTATION = 0x00000002,
-    };
-
-    struct BlockInfo
-    {
-        uint32_t flags;
-        void* pMappedData;
-    };
-    VmaVector< BlockInfo, VmaStlAllocator<BlockInfo> >
-        blockInfo(blockCount, BlockInfo(), VmaStlAllocator<BlockInfo>(m_hAllocator->GetAllocationCallbacks()));
-    memset(blockInfo.data(), 0, blockCount * sizeof(BlockInfo));
+    const BlockIndexItem* const it = VmaBinaryFindFirstNotLess(
+        m_BlockIndex.data(),
+        m_BlockIndex.data() + m_BlockIndex.size(),
+        block.memory,
+        BlockIndexItemMemoryLess());
+    VMA_ASSERT(it != m_BlockIndex.data() + m_BlockIndex.size() && it->memory == block.memory);
+    VmaVectorRemove(m_BlockIndex, (size_t)(it - m_BlockIndex.data()));
 
-    // Go over all moves. Mark blocks that are used with BLOCK_FLAG_USED.
-    const size_t moveCount = moves.size();
-    for(size_t moveIndex = 0; moveIndex < moveCount; ++moveIndex)
-    {
-        const VmaDefragmentationMove& move = moves[moveIndex];
-        blockInfo[move.srcBlockIndex].flags |= BLOCK_FLAG_USED;
-        blockInfo[move.dstBlockIndex].flags |= BLOCK_FLAG_USED;
-    }
+    m_hAllocator->FreeVulkanMemory(m_MemoryTypeIndex, GetBlockSize(), block.memory);
+    block.memory = VK_NULL_HANDLE;
+    block.freePageCount = 0;
+}
 
-    VMA_ASSERT(pDefragCtx->res == VK_SUCCESS);
+void VmaPool_T::SetName(const char* pName)
+{
+    const VkAllocationCallbacks* allocs = m_BlockVector.GetAllocator()->GetAllocationCallbacks();
+    VmaFreeString(allocs, m_Name);
 
-    // Go over all blocks. Get mapped pointer or map if necessary.
-    for(size_t blockIndex = 0; pDefragCtx->res == VK_SUCCESS && blockIndex < blockCount; ++blockIndex)
+    if(pName != VMA_NULL)
     {
-        BlockInfo& currBlockInfo = blockInfo[blockIndex];
-        VmaDeviceMemoryBlock* pBlock = m_Blocks[blockIndex];
-        if((currBlockInfo.flags & BLOCK_FLAG_USED) != 0)
-        {
-            currBlockInfo.pMappedData = pBlock->GetMappedData();
-            // It is not originally mapped - map it.
-            if(currBlockInfo.pMappedData == VMA_NULL)
-            {
-                pDefragCtx->res = pBlock->Map(m_hAllocator, 1, &currBlockInfo.pMappedData);
-                if(pDefragCtx->res == VK_SUCCESS)
-                {
-                    currBlockInfo.flags |= BLOCK_FLAG_MAPPED_FOR_DEFRAGMENTATION;
-                }
-            }
-        }
+        m_Name = VmaCreateStringCopy(allocs, pName);
     }
-
-    // Go over all moves. Do actual data transfer.
-    if(pDefragCtx->res == VK_SUCCESS)
+    else
     {
-        const VkDeviceSize nonCoherentAtomSize = m_hAllocator->m_PhysicalDeviceProperties.limits.nonCoherentAtomSize;
-        VkMappedMemoryRange memRange = { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
-
-        for(size_t moveIndex = 0; moveIndex < moveCount; ++moveIndex)
-        {
-            const VmaDefragmentationMove& move = moves[moveIndex];
-
-            const BlockInfo& srcBlockInfo = blockInfo[move.srcBlockIndex];
-            const BlockInfo& dstBlockInfo = blockInfo[move.dstBlockIndex];
-
-            VMA_ASSERT(srcBlockInfo.pMappedData && dstBlockInfo.pMappedData);
+        m_Name = VMA_NULL;
+    }
+}
 
-            // Invalidate source.
-            if(isNonCoherent)
-            {
-                VmaDeviceMemoryBlock* const pSrcBlock = m_Blocks[move.srcBlockIndex];
-                memRange.memory = pSrcBlock->GetDeviceMemory();
-                memRange.offset = VmaAlignDown(move.srcOffset, nonCoherentAtomSize);
-                memRange.size = VMA_MIN(
-                    VmaAlignUp(move.size + (move.srcOffset - memRange.offset), nonCoherentAtomSize),
-                    pSrcBlock->m_pMetadata->GetSize() - memRange.offset);
-                (*m_hAllocator->GetVulkanFunctions().vkInvalidateMappedMemoryRanges)(m_hAllocator->m_hDevice, 1, &memRange);
-            }
+#if VMA_STATS_STRING_ENABLED
 
-            // THE PLACE WHERE ACTUAL DATA COPY HAPPENS.
-            memmove(
-                reinterpret_cast<char*>(dstBlockInfo.pMappedData) + move.dstOffset,
-                reinterpret_cast<char*>(srcBlockInfo.pMappedData) + move.srcOffset,
-                static_cast<size_t>(move.size));
+#endif // #if VMA_STATS_STRING_ENABLED
 
-            if(IsCorruptionDetectionEnabled())
-            {
-                VmaWriteMagicValue(dstBlockInfo.pMappedData, move.dstOffset - VMA_DEBUG_MARGIN);
-                VmaWriteMagicValue(dstBlockInfo.pMappedData, move.dstOffset + move.size);
-            }
+VmaBlockVector::VmaBlockVector(
+    VmaAllocator hAllocator,
+    VmaPool hParentPool,
+    uint32_t memoryTypeIndex,
+    VkDeviceSize preferredBlockSize,
+    size_t minBlockCount,
+    size_t maxBlockCount,
+    VkDeviceSize bufferImageGranularity,
+    uint32_t frameInUseCount,
+    bool explicitBlockSize,
+    uint32_t algorithm,
+    void* pHostPointer,
+    VkFlags exportHandleTypes,
+    float priority) :
+    m_hAllocator(hAllocator),
+    m_hParentPool(hParentPool),
+    m_MemoryTypeIndex(memoryTypeIndex),
+    m_PreferredBlockSize(preferredBlockSize),
+    m_MinBlockCount(minBlockCount),
+    m_MaxBlockCount(maxBlockCount),
+    m_BufferImageGranularity(bufferImageGranularity),
+    m_FrameInUseCount(frameInUseCount),
+    m_ExplicitBlockSize(explicitBlockSize),
+    m_Algorithm(algorithm),
+    m_pHostPointer(pHostPointer),
+    m_ExportHandleTypes(exportHandleTypes),
+    m_Priority(priority),
+    m_HasEmptyBlock(false),
+    m_Blocks(VmaStlAllocator<VmaDeviceMemoryBlock*>(hAllocator->GetAllocationCallbacks())),
+    m_NextBlockId(0)
+{
+}
 
-            // Flush destination.
-            if(isNonCoherent)
-            {
-                VmaDeviceMemoryBlock* const pDstBlock = m_Blocks[move.dstBlockIndex];
-                memRange.memory = pDstBlock->GetDeviceMemory();
-                memRange.offset = VmaAlignDown(move.dstOffset, nonCoherentAtomSize);
-                memRange.size = VMA_MIN(
-                    VmaAlignUp(move.size + (move.dstOffset - memRange.offset), nonCoherentAtomSize),
-                    pDstBlock->m_pMetadata->GetSize() - memRange.offset);
-                (*m_hAllocator->GetVulkanFunctions().vkFlushMappedMemoryRanges)(m_hAllocator->m_hDevice, 1, &memRange);
-            }
-        }
+VmaBlockVector::~VmaBlockVector()
+{
+    for(size_t i = m_Blocks.size(); i--; )
+    {
+        m_Blocks[i]->Destroy(m_hAllocator);
+        vma_delete(m_hAllocator, m_Blocks[i]);
     }
+}
 
-    // Go over all blocks in reverse order. Unmap those that were mapped just for defragmentation.
-    // Regardless of pCtx->res == VK_SUCCESS.
-    for(size_t blockIndex = blockCount; blockIndex--; )
+VkResult VmaBlockVector::CreateMinBlocks()
+{
+    for(size_t i = 0; i < m_MinBlockCount; ++i)
     {
-        const BlockInfo& currBlockInfo = blockInfo[blockIndex];
-        if((currBlockInfo.flags & BLOCK_FLAG_MAPPED_FOR_DEFRAGMENTATION) != 0)
+        VkResult res = CreateBlock(m_PreferredBlockSize, VMA_NULL);
+        if(res != VK_SUCCESS)
         {
-            VmaDeviceMemoryBlock* pBlock = m_Blocks[blockIndex];
-            pBlock->Unmap(m_hAllocator, 1);
+            return res;
         }
     }
+    return VK_SUCCESS;
 }
 
-void VmaBlockVector::ApplyDefragmentationMovesGpu(
-    class VmaBlockVectorDefragmentationContext* pDefragCtx,
-    VmaVector< VmaDefragmentationMove, VmaStlAllocator<VmaDefragmentationMove> >& moves,
-    VkCommandBuffer commandBuffer)
+void VmaBlockVector::GetPoolStats(VmaPoolStats* pStats)
 {
+    VmaMutexLockRead lock(m_Mutex, m_hAllocator->m_UseMutex);
+
     const size_t blockCount = m_Blocks.size();
 
-    pDefragCtx->blockContexts.resize(blockCount);
-    memset(pDefragCtx->blockContexts.data(), 0, blockCount * sizeof(VmaBlockDefragmentationContext));
+    pStats->size = 0;
+    pStats->unusedSize = 0;
+    pStats->allocationCount = 0;
+    pStats->unusedRangeCount = 0;
+    pStats->unusedRangeSizeMax = 0;
+    pStats->blockCount = blockCount;
 
-    // Go over all moves. Mark blocks that are used with BLOCK_FLAG_USED.
-    const size_t moveCount = moves.size();
-    for(size_t moveIndex = 0; moveIndex < moveCount; ++moveIndex)
+    for(uint32_t blockIndex = 0; blockIndex < blockCount; ++blockIndex)
     {
-        const VmaDefragmentationMove& move = moves[moveIndex];
-
-        //if(move.type == VMA_ALLOCATION_TYPE_UNKNOWN)
-        {
-            // Old school move still require us to map the whole block
-            pDefragCtx->blockContexts[move.srcBlockIndex].flags |= VmaBlockDefragmentationContext::BLOCK_FLAG_USED;
-            pDefragCtx->blockContexts[move.dstBlockIndex].flags |= VmaBlockDefragmentationContext::BLOCK_FLAG_USED;
-        }
+        const VmaDeviceMemoryBlock* const pBlock = m_Blocks[blockIndex];
+        VMA_ASSERT(pBlock);
+        VMA_HEAVY_ASSERT(pBlock->Validate());
+        pBlock->m_pMetadata->AddPoolStats(*pStats);
     }
+}
 
-    VMA_ASSERT(pDefragCtx->res == VK_SUCCESS);
+bool VmaBlockVector::IsEmpty()
+{
+    VmaMutexLockRead lock(m_Mutex, m_hAllocator->m_UseMutex);
+    return m_Blocks.empty();
+}
 
-    // Go over all blocks. Create and bind buffer for whole block if necessary.
+bool VmaBlockVector::IsCorruptionDetectionEnabled() const
+{
+    const uint32_t requiredMemFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    return (VMA_DEBUG_DETECT_CORRUPTION != 0) &&
+        (VMA_DEBUG_MARGIN > 0) &&
+        (m_Algorithm == 0 || m_Algorithm == VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT) &&
+        (m_hAllocator->m_MemProps.memoryTypes[m_MemoryTypeIndex].propertyFlags & requiredMemFlags) == requiredMemFlags;
+}
+
+static const uint32_t VMA_ALLOCATION_TRY_COUNT = 32;
+
+VkResult VmaBlockVector::Allocate(
+    uint32_t currentFrameIndex,
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    const VmaAllocationCreateInfo& createInfo,
+    VmaSuballocationType suballocType,
+    size_t allocationCount,
+    VmaAllocation* pAllocations)
+{
+    size_t allocIndex;
+    VkResult res = VK_SUCCESS;
+
+    if(IsCorruptionDetectionEnabled())
     {
-        VkBufferCreateInfo bufCreateInfo;
-        VmaFillGpuDefragmentationBufferCreateInfo(bufCreateInfo);
+        size = VmaAlignUp<VkDeviceSize>(size, sizeof(VMA_CORRUPTION_DETECTION_MAGIC_VALUE));
+        alignment = VmaAlignUp<VkDeviceSize>(alignment, sizeof(VMA_CORRUPTION_DETECTION_MAGIC_VALUE));
+    }
 
-        for(size_t blockIndex = 0; pDefragCtx->res == VK_SUCCESS && blockIndex < blockCount; ++blockIndex)
+    const bool pagesInOneBlock = allocationCount > 1 &&
+        (createInfo.flags & (VMA_ALLOCATION_CREATE_PAGES_SAME_BLOCK_BIT | VMA_ALLOCATION_CREATE_PAGES_CONTIGUOUS_BIT)) != 0;
+
+    {
+        VmaMutexLockWrite lock(m_Mutex, m_hAllocator->m_UseMutex);
+        if(pagesInOneBlock)
         {
-            VmaBlockDefragmentationContext& currBlockCtx = pDefragCtx->blockContexts[blockIndex];
-            VmaDeviceMemoryBlock* pBlock = m_Blocks[blockIndex];
-            if((currBlockCtx.flags & VmaBlockDefragmentationContext::BLOCK_FLAG_USED) != 0)
+            // Rolls back by itself on failure.
+            res = AllocatePagesInOneBlock(
+                currentFrameIndex,
+                size,
+                alignment,
+                createInfo,
+                suballocType,
+                allocationCount,
+                pAllocations);
+            allocIndex = 0;
+            if(res == VK_SUCCESS)
             {
-                bufCreateInfo.size = pBlock->m_pMetadata->GetSize();
-                pDefragCtx->res = (*m_hAllocator->GetVulkanFunctions().vkCreateBuffer)(
-                    m_hAllocator->m_hDevice, &bufCreateInfo, m_hAllocator->GetAllocationCallbacks(), &currBlockCtx.hBuffer);
-                if(pDefragCtx->res == VK_SUCCESS)
+                VmaDeviceMemoryBlock* const pBlock = pAllocations[0]->GetBlock();
+                pBlock->SetPriority(VMA_MAX(pBlock->GetPriority(), createInfo.priority));
+                pBlock->MarkUsed(currentFrameIndex);
+            }
+        }
+        else
+        {
+            for(allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
+            {
+                res = AllocatePage(
+                    currentFrameIndex,
+                    size,
+                    alignment,
+                    createInfo,
+                    suballocType,
+                    pAllocations + allocIndex);
+                if(res != VK_SUCCESS)
                 {
-                    pDefragCtx->res = (*m_hAllocator->GetVulkanFunctions().vkBindBufferMemory)(
-                        m_hAllocator->m_hDevice, currBlockCtx.hBuffer, pBlock->GetDeviceMemory(), 0);
+                    break;
                 }
+                VmaDeviceMemoryBlock* const pBlock = pAllocations[allocIndex]->GetBlock();
+                pBlock->SetPriority(VMA_MAX(pBlock->GetPriority(), createInfo.priority));
+                pBlock->MarkUsed(currentFrameIndex);
             }
         }
     }
 
-    // Go over all moves. Post data transfer commands to command buffer.
-    if(pDefragCtx->res == VK_SUCCESS)
+    if(res != VK_SUCCESS)
     {
-        for(size_t moveIndex = 0; moveIndex < moveCount; ++moveIndex)
+        // Free all already created allocations.
+        while(allocIndex--)
         {
-            const VmaDefragmentationMove& move = moves[moveIndex];
-
-            const VmaBlockDefragmentationContext& srcBlockCtx = pDefragCtx->blockContexts[move.srcBlockIndex];
-            const VmaBlockDefragmentationContext& dstBlockCtx = pDefragCtx->blockContexts[move.dstBlockIndex];
+            Free(pAllocations[allocIndex]);
+        }
+        memset(pAllocations, 0, sizeof(VmaAllocation) * allocationCount);
+    }
 
-            VMA_ASSERT(srcBlockCtx.hBuffer && dstBlockCtx.hBuffer);
+    return res;
+}
 
-            VkBufferCopy region = {
-                move.srcOffset,
-                move.dstOffset,
-                move.size };
-            (*m_hAllocator->GetVulkanFunctions().vkCmdCopyBuffer)(
-                commandBuffer, srcBlockCtx.hBuffer, dstBlockCtx.hBuffer, 1, &region);
-        }
+bool VmaBlockVector::CheckFitInExistingBlocks(
+    uint32_t currentFrameIndex,
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    const VmaAllocationCreateInfo& createInfo,
+    VmaVector< VmaFitReservation, VmaStlAllocator<VmaFitReservation> >& inoutReservations)
+{
+    if(IsCorruptionDetectionEnabled())
+    {
+        size = VmaAlignUp<VkDeviceSize>(size, sizeof(VMA_CORRUPTION_DETECTION_MAGIC_VALUE));
+        alignment = VmaAlignUp<VkDeviceSize>(alignment, sizeof(VMA_CORRUPTION_DETECTION_MAGIC_VALUE));
+    }
+    if(size + 2 * VMA_DEBUG_MARGIN > m_PreferredBlockSize)
+    {
+        return false;
     }
 
-    // Save buffers to defrag context for later destruction.
-    if(pDefragCtx->res == VK_SUCCESS && moveCount > 0)
+    const bool isUpperAddress = (createInfo.flags & VMA_ALLOCATION_CREATE_UPPER_ADDRESS_BIT) != 0;
+    uint32_t strategy = createInfo.flags & VMA_ALLOCATION_CREATE_STRATEGY_MASK;
+    switch(strategy)
     {
-        pDefragCtx->res = VK_NOT_READY;
+    case 0:
+        strategy = VMA_ALLOCATION_CREATE_STRATEGY_BEST_FIT_BIT;
+        break;
+    case VMA_ALLOCATION_CREATE_STRATEGY_BEST_FIT_BIT:
+    case VMA_ALLOCATION_CREATE_STRATEGY_WORST_FIT_BIT:
+    case VMA_ALLOCATION_CREATE_STRATEGY_FIRST_FIT_BIT:
+        break;
+    default:
+        return false;
     }
-}
+    if((createInfo.flags & VMA_ALLOCATION_CREATE_ZEROED_BIT) != 0 &&
+        (m_hAllocator->m_MemProps.memoryTypes[m_MemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == 0)
+    {
+        // Only ranges cleared by vmaZeroFreeMemory() can be used.
+        if(m_Algorithm != 0)
+        {
+            return false;
+        }
+        strategy = VMA_ALLOCATION_INTERNAL_STRATEGY_ZEROED;
+    }
+    // Allocations placed after already reserved ones must not share a page with them.
+    const VkDeviceSize reservedAlignment = VMA_MAX(alignment, m_BufferImageGranularity);
 
-void VmaBlockVector::FreeEmptyBlocks(VmaDefragmentationStats* pDefragmentationStats)
-{
-    for(size_t blockIndex = m_Blocks.size(); blockIndex--; )
+    VmaMutexLockRead lock(m_Mutex, m_hAllocator->m_UseMutex);
+    const size_t blockCount = m_Blocks.size();
+    for(size_t blockIndex = 0; blockIndex < blockCount; ++blockIndex)
     {
-        VmaDeviceMemoryBlock* pBlock = m_Blocks[blockIndex];
-        if(pBlock->m_pMetadata->IsEmpty())
+        if(m_Algorithm == VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT && blockIndex != blockCount - 1)
         {
-            if(m_Blocks.size() > m_MinBlockCount)
-            {
-                if(pDefragmentationStats != VMA_NULL)
-                {
-                    ++pDefragmentationStats->deviceMemoryBlocksFreed;
-                    pDefragmentationStats->bytesFreed += pBlock->m_pMetadata->GetSize();
-                }
+            // Use only last block.
+            continue;
+        }
+        VmaDeviceMemoryBlock* const pBlock = m_Blocks[blockIndex];
+        VMA_ASSERT(pBlock);
+        if(pBlock->m_pMetadata->GetSumFreeSize() < size)
+        {
+            continue;
+        }
+        VmaAllocationRequest request = {};
+        if(!pBlock->m_pMetadata->CreateAllocationRequest(
+            currentFrameIndex,
+            m_FrameInUseCount,
+            m_BufferImageGranularity,
+            size,
+            alignment,
+            isUpperAddress,
+            VMA_SUBALLOCATION_TYPE_UNKNOWN,
+            false, // canMakeOtherLost
+            strategy,
+            &request))
+        {
+            continue;
+        }
 
-                VmaVectorRemove(m_Blocks, blockIndex);
-                pBlock->Destroy(m_hAllocator);
-                vma_delete(m_hAllocator, pBlock);
-            }
-            else
+        // Free range found may be already taken by earlier allocations of this check - try after them.
+        const VkDeviceSize rangeEnd = VMA_MAX(pBlock->m_pMetadata->GetRequestFreeRangeEnd(request), request.offset + size);
+        VkDeviceSize offset = request.offset;
+        for(size_t reservationIndex = 0; reservationIndex < inoutReservations.size(); ++reservationIndex)
+        {
+            const VmaFitReservation& reservation = inoutReservations[reservationIndex];
+            if(reservation.pBlock == pBlock &&
+                reservation.offset < rangeEnd &&
+                reservation.offset + reservation.size > request.offset)
             {
-                break;
+                offset = VMA_MAX(offset,
+                    VmaAlignUp(reservation.offset + reservation.size + VMA_DEBUG_MARGIN, reservedAlignment));
             }
         }
+        if(offset == request.offset ||
+            offset + size + VMA_DEBUG_MARGIN <= rangeEnd)
+        {
+            const VmaFitReservation reservation = { pBlock, offset, size };
+            inoutReservations.push_back(reservation);
+            return true;
+        }
     }
-    UpdateHasEmptyBlock();
+    return false;
 }
 
-void VmaBlockVector::UpdateHasEmptyBlock()
+bool VmaBlockVector::CanCreateBlocks(size_t blockCount)
 {
-    m_HasEmptyBlock = false;
-    for(size_t index = 0, count = m_Blocks.size(); index < count; ++index)
+    VmaMutexLockRead lock(m_Mutex, m_hAllocator->m_UseMutex);
+    return m_Blocks.size() + blockCount <= m_MaxBlockCount;
+}
+
+bool VmaBlockVector::FindAllocation(VkDeviceMemory memory, VkDeviceSize offset, VmaAllocation& outAllocation)
+{
+    VmaMutexLockRead lock(m_Mutex, m_hAllocator->m_UseMutex);
+    for(size_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex)
     {
-        VmaDeviceMemoryBlock* const pBlock = m_Blocks[index];
-        if(pBlock->m_pMetadata->IsEmpty())
+        const VmaDeviceMemoryBlock* const pBlock = m_Blocks[blockIndex];
+        if(pBlock->GetDeviceMemory() == memory)
         {
-            m_HasEmptyBlock = true;
-            break;
+            outAllocation = offset < pBlock->m_pMetadata->GetSize() ?
+                pBlock->m_pMetadata->FindAllocationAt(offset) : VK_NULL_HANDLE;
+            return true;
         }
     }
+    return false;
 }
 
-#if VMA_STATS_STRING_ENABLED
-
-void VmaBlockVector::PrintDetailedMap(class VmaJsonWriter& json)
+void VmaBlockVector::AllocateBatch(
+    uint32_t currentFrameIndex,
+    const VmaBatchAllocation* pItems,
+    size_t itemCount,
+    VmaAllocation* pAllocations)
 {
-    VmaMutexLockRead lock(m_Mutex, m_hAllocator->m_UseMutex);
-
-    json.BeginObject();
-
-    if(IsCustomPool())
+    VmaMutexLockWrite lock(m_Mutex, m_hAllocator->m_UseMutex);
+    for(size_t itemIndex = 0; itemIndex < itemCount; ++itemIndex)
     {
-        const char* poolName = m_hParentPool->GetName();
-        if(poolName != VMA_NULL && poolName[0] != '\0')
+        const VmaBatchAllocation& item = pItems[itemIndex];
+        VMA_ASSERT(item.pBlockVector == this);
+        VkDeviceSize size = item.size;
+        VkDeviceSize alignment = item.alignment;
+        if(IsCorruptionDetectionEnabled())
         {
-            json.WriteString("Name");
-            json.WriteString(poolName);
+            size = VmaAlignUp<VkDeviceSize>(size, sizeof(VMA_CORRUPTION_DETECTION_MAGIC_VALUE));
+            alignment = VmaAlignUp<VkDeviceSize>(alignment, sizeof(VMA_CORRUPTION_DETECTION_MAGIC_VALUE));
         }
 
-        json.WriteString("MemoryTypeIndex");
-        json.WriteNumber(m_MemoryTypeIndex);
-
-        json.WriteString("BlockSize");
-        json.WriteNumber(m_PreferredBlockSize);
-
-        json.WriteString("BlockCount");
-        json.BeginObject(true);
-        if(m_MinBlockCount > 0)
+        VmaAllocation* const pAllocation = pAllocations + item.index;
+        if(AllocatePage(
+            currentFrameIndex,
+            size,
+            alignment,
+            item.createInfo,
+            VMA_SUBALLOCATION_TYPE_UNKNOWN,
+            pAllocation) == VK_SUCCESS)
         {
-            json.WriteString("Min");
-            json.WriteNumber((uint64_t)m_MinBlockCount);
+            VmaDeviceMemoryBlock* const pBlock = (*pAllocation)->GetBlock();
+            pBlock->SetPriority(VMA_MAX(pBlock->GetPriority(), item.createInfo.priority));
+            pBlock->MarkUsed(currentFrameIndex);
         }
-        if(m_MaxBlockCount < SIZE_MAX)
+        else
         {
-            json.WriteString("Max");
-            json.WriteNumber((uint64_t)m_MaxBlockCount);
+            *pAllocation = VK_NULL_HANDLE;
         }
-        json.WriteString("Cur");
-        json.WriteNumber((uint64_t)m_Blocks.size());
-        json.EndObject();
+    }
+}
 
-        if(m_FrameInUseCount > 0)
-        {
-            json.WriteString("FrameInUseCount");
-            json.WriteNumber(m_FrameInUseCount);
-        }
+VkResult VmaBlockVector::AllocatePage(
+    uint32_t currentFrameIndex,
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    const VmaAllocationCreateInfo& createInfo,
+    VmaSuballocationType suballocType,
+    VmaAllocation* pAllocation)
+{
+    const bool isUpperAddress = (createInfo.flags & VMA_ALLOCATION_CREATE_UPPER_ADDRESS_BIT) != 0;
+    bool canMakeOtherLost = (createInfo.flags & VMA_ALLOCATION_CREATE_CAN_MAKE_OTHER_LOST_BIT) != 0;
+    const bool mapped = (createInfo.flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0;
+    const bool isUserDataString = (createInfo.flags & VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT) != 0;
+    const bool isZeroed = (createInfo.flags & VMA_ALLOCATION_CREATE_ZEROED_BIT) != 0;
+    const bool isHostVisible =
+        (m_hAllocator->m_MemProps.memoryTypes[m_MemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
 
-        if(m_Algorithm != 0)
-        {
-            json.WriteString("Algorithm");
-            json.WriteString(VmaAlgorithmToStr(m_Algorithm));
-        }
-    }
-    else
+    VkDeviceSize freeMemory;
     {
-        json.WriteString("PreferredBlockSize");
-        json.WriteNumber(m_PreferredBlockSize);
+        const uint32_t heapIndex = m_hAllocator->MemoryTypeIndexToHeapIndex(m_MemoryTypeIndex);
+        VmaBudget heapBudget = {};
+        m_hAllocator->GetBudget(&heapBudget, heapIndex, 1);
+        freeMemory = (heapBudget.usage < heapBudget.budget) ? (heapBudget.budget - heapBudget.usage) : 0;
     }
 
-    json.WriteString("Blocks");
-    json.BeginObject();
-    for(size_t i = 0; i < m_Blocks.size(); ++i)
-    {
-        json.BeginString();
-        json.ContinueString(m_Blocks[i]->GetId());
-        json.EndString();
+    const bool canFallbackToDedicated = !IsCustomPool();
+    const bool canCreateNewBlock =
+        ((createInfo.flags & VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT) == 0) &&
+        (m_Blocks.size() < m_MaxBlockCount) &&
+        (freeMemory >= size || !canFallbackToDedicated);
+    uint32_t strategy = createInfo.flags & VMA_ALLOCATION_CREATE_STRATEGY_MASK;
 
-        m_Blocks[i]->m_pMetadata->PrintDetailedMap(json);
+    // If linearAlgorithm is used, canMakeOtherLost is available only when used as ring buffer.
+    // Which in turn is available only when maxBlockCount = 1.
+    if(m_Algorithm == VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT && m_MaxBlockCount > 1)
+    {
+        canMakeOtherLost = false;
     }
-    json.EndObject();
-
-    json.EndObject();
-}
-
-#endif // #if VMA_STATS_STRING_ENABLED
-
-void VmaBlockVector::Defragment(
-    class VmaBlockVectorDefragmentationContext* pCtx,
-    VmaDefragmentationStats* pStats, VmaDefragmentationFlags flags,
-    VkDeviceSize& maxCpuBytesToMove, uint32_t& maxCpuAllocationsToMove,
-    VkDeviceSize& maxGpuBytesToMove, uint32_t& maxGpuAllocationsToMove,
-    VkCommandBuffer commandBuffer)
-{
-    pCtx->res = VK_SUCCESS;
-
-    const VkMemoryPropertyFlags memPropFlags =
-        m_hAllocator->m_MemProps.memoryTypes[m_MemoryTypeIndex].propertyFlags;
-    const bool isHostVisible = (memPropFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
 
-    const bool canDefragmentOnCpu = maxCpuBytesToMove > 0 && maxCpuAllocationsToMove > 0 &&
-        isHostVisible;
-    const bool canDefragmentOnGpu = maxGpuBytesToMove > 0 && maxGpuAllocationsToMove > 0 &&
-        !IsCorruptionDetectionEnabled() &&
-        ((1u << m_MemoryTypeIndex) & m_hAllocator->GetGpuDefragmentationMemoryTypeBits()) != 0;
+    // Upper address can only be used with linear allocator and within single memory block.
+    if(isUpperAddress &&
+        (m_Algorithm != VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT || m_MaxBlockCount > 1))
+    {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
 
-    // There are options to defragment this memory type.
-    if(canDefragmentOnCpu || canDefragmentOnGpu)
+    // Validate strategy.
+    switch(strategy)
     {
-        bool defragmentOnGpu;
-        // There is only one option to defragment this memory type.
-        if(canDefragmentOnGpu != canDefragmentOnCpu)
-        {
-            defragmentOnGpu = canDefragmentOnGpu;
-        }
-        // Both options are available: Heuristics to choose the best one.
-        else
-        {
-            defragmentOnGpu = (memPropFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0 ||
-                m_hAllocator->IsIntegratedGpu();
-        }
+    case 0:
+        strategy = VMA_ALLOCATION_CREATE_STRATEGY_BEST_FIT_BIT;
+        break;
+    case VMA_ALLOCATION_CREATE_STRATEGY_BEST_FIT_BIT:
+    case VMA_ALLOCATION_CREATE_STRATEGY_WORST_FIT_BIT:
+    case VMA_ALLOCATION_CREATE_STRATEGY_FIRST_FIT_BIT:
+        break;
+    default:
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
 
-        bool overlappingMoveSupported = !defragmentOnGpu;
+    // Early reject: requested allocation size is larger that maximum block size for this block vector.
+    if(size + 2 * VMA_DEBUG_MARGIN > m_PreferredBlockSize)
+    {
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
 
-        if(m_hAllocator->m_UseMutex)
+    // 0. Zeroed allocation: prefer free ranges already cleared by vmaZeroFreeMemory().
+    if(isZeroed)
+    {
+        if(m_Algorithm == 0)
         {
-            if(flags & VMA_DEFRAGMENTATION_FLAG_INCREMENTAL)
+            VmaAllocationCreateFlags allocFlagsCopy = createInfo.flags;
+            allocFlagsCopy &= ~VMA_ALLOCATION_CREATE_CAN_MAKE_OTHER_LOST_BIT;
+            for(size_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex )
             {
-                if(!m_Mutex.TryLockWrite())
-                {
-                    pCtx->res = VK_ERROR_INITIALIZATION_FAILED;
-                    return;
+                VmaDeviceMemoryBlock* const pCurrBlock = m_Blocks[blockIndex];
+                VMA_ASSERT(pCurrBlock);
+                VkResult res = AllocateFromBlock(
+                    pCurrBlock,
+                    currentFrameIndex,
+                    size,
+                    alignment,
+                    allocFlagsCopy,
+                    createInfo.pUserData,
+                    createInfo.lifetime,
+                    suballocType,
+                    VMA_ALLOCATION_INTERNAL_STRATEGY_ZEROED,
+                    pAllocation);
+                if(res == VK_SUCCESS)
+                {
+                    VMA_DEBUG_LOG("    Returned zeroed range from existing block #%u", pCurrBlock->GetId());
+                    return VK_SUCCESS;
                 }
             }
-            else
-            {
-                m_Mutex.LockWrite();
-                pCtx->mutexLocked = true;
-            }
         }
+        // Other places can be cleared only on the CPU.
+        if(!isHostVisible)
+        {
+            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+    }
 
-        pCtx->Begin(overlappingMoveSupported, flags);
-
-        // Defragment.
-
-        const VkDeviceSize maxBytesToMove = defragmentOnGpu ? maxGpuBytesToMove : maxCpuBytesToMove;
-        const uint32_t maxAllocationsToMove = defragmentOnGpu ? maxGpuAllocationsToMove : maxCpuAllocationsToMove;
-        pCtx->res = pCtx->GetAlgorithm()->Defragment(pCtx->defragmentationMoves, maxBytesToMove, maxAllocationsToMove, flags);
+    /*
+    Under certain condition, this whole section can be skipped for optimization, so
+    we move on directly to trying to allocate with canMakeOtherLost. That's the case
+    e.g. for custom pools with linear algorithm.
+    */
+    if(!canMakeOtherLost || canCreateNewBlock)
+    {
+        // 1. Search existing allocations. Try to allocate without making other allocations lost.
+        VmaAllocationCreateFlags allocFlagsCopy = createInfo.flags;
+        allocFlagsCopy &= ~VMA_ALLOCATION_CREATE_CAN_MAKE_OTHER_LOST_BIT;
 
-        // Accumulate statistics.
-        if(pStats != VMA_NULL)
+        if(m_Algorithm == VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT)
         {
-            const VkDeviceSize bytesMoved = pCtx->GetAlgorithm()->GetBytesMoved();
-            const uint32_t allocationsMoved = pCtx->GetAlgorithm()->GetAllocationsMoved();
-            pStats->bytesMoved += bytesMoved;
-            pStats->allocationsMoved += allocationsMoved;
-            VMA_ASSERT(bytesMoved <= maxBytesToMove);
-            VMA_ASSERT(allocationsMoved <= maxAllocationsToMove);
-            if(defragmentOnGpu)
-            {
-                maxGpuBytesToMove -= bytesMoved;
-                maxGpuAllocationsToMove -= allocationsMoved;
-            }
-            else
+            // Use only last block.
+            if(!m_Blocks.empty())
             {
-                maxCpuBytesToMove -= bytesMoved;
-                maxCpuAllocationsToMove -= allocationsMoved;
+                VmaDeviceMemoryBlock* const pCurrBlock = m_Blocks.back();
+                VMA_ASSERT(pCurrBlock);
+                VkResult res = AllocateFromBlock(
+                    pCurrBlock,
+                    currentFrameIndex,
+                    size,
+                    alignment,
+                    allocFlagsCopy,
+                    createInfo.pUserData,
+                    createInfo.lifetime,
+                    suballocType,
+                    strategy,
+                    pAllocation);
+                if(res == VK_SUCCESS)
+                {
+                    VMA_DEBUG_LOG("    Returned from last block #%u", pCurrBlock->GetId());
+                    return VK_SUCCESS;
+                }
             }
         }
-
-        if(flags & VMA_DEFRAGMENTATION_FLAG_INCREMENTAL)
-        {
-            if(m_hAllocator->m_UseMutex)
-                m_Mutex.UnlockWrite();
-
-            if(pCtx->res >= VK_SUCCESS && !pCtx->defragmentationMoves.empty())
-                pCtx->res = VK_NOT_READY;
-
-            return;
-        }
-
-        if(pCtx->res >= VK_SUCCESS)
+        else
         {
-            if(defragmentOnGpu)
+            if(strategy == VMA_ALLOCATION_CREATE_STRATEGY_BEST_FIT_BIT)
             {
-                ApplyDefragmentationMovesGpu(pCtx, pCtx->defragmentationMoves, commandBuffer);
+                // Forward order in m_Blocks - prefer blocks with smallest amount of free space.
+                for(size_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex )
+                {
+                    VmaDeviceMemoryBlock* const pCurrBlock = m_Blocks[blockIndex];
+                    VMA_ASSERT(pCurrBlock);
+                    if(!IsLifetimeCompatible(pCurrBlock, createInfo.lifetime))
+                    {
+                        continue;
+                    }
+                    VkResult res = AllocateFromBlock(
+                        pCurrBlock,
+                        currentFrameIndex,
+                        size,
+                        alignment,
+                        allocFlagsCopy,
+                        createInfo.pUserData,
+                        createInfo.lifetime,
+                        suballocType,
+                        strategy,
+                        pAllocation);
+                    if(res == VK_SUCCESS)
+                    {
+                        VMA_DEBUG_LOG("    Returned from existing block #%u", pCurrBlock->GetId());
+                        return VK_SUCCESS;
+                    }
+                }
             }
-            else
+            else // WORST_FIT, FIRST_FIT
             {
-                ApplyDefragmentationMovesCpu(pCtx, pCtx->defragmentationMoves);
+                // Backward order in m_Blocks - prefer blocks with largest amount of free space.
+                for(size_t blockIndex = m_Blocks.size(); blockIndex--; )
+                {
+                    VmaDeviceMemoryBlock* const pCurrBlock = m_Blocks[blockIndex];
+                    VMA_ASSERT(pCurrBlock);
+                    if(!IsLifetimeCompatible(pCurrBlock, createInfo.lifetime))
+                    {
+                        continue;
+                    }
+                    VkResult res = AllocateFromBlock(
+                        pCurrBlock,
+                        currentFrameIndex,
+                        size,
+                        alignment,
+                        allocFlagsCopy,
+                        createInfo.pUserData,
+                        createInfo.lifetime,
+                        suballocType,
+                        strategy,
+                        pAllocation);
+                    if(res == VK_SUCCESS)
+                    {
+                        VMA_DEBUG_LOG("    Returned from existing block #%u", pCurrBlock->GetId());
+                        return VK_SUCCESS;
+                    }
+                }
             }
         }
-    }
-}
 
-void VmaBlockVector::DefragmentationEnd(
-    class VmaBlockVectorDefragmentationContext* pCtx,
-    uint32_t flags,
-    VmaDefragmentationStats* pStats)
-{
-    if(flags & VMA_DEFRAGMENTATION_FLAG_INCREMENTAL && m_hAllocator->m_UseMutex)
-    {
-        VMA_ASSERT(pCtx->mutexLocked == false);
+        // 2. Try to create new block.
+        if(canCreateNewBlock)
+        {
+            // Calculate optimal size for new block.
+            uint32_t newBlockSizeShift = 0;
+            VkDeviceSize newBlockSize = CalcNewBlockSize(size, CalcMaxBlockSize(), newBlockSizeShift);
 
-        // Incremental defragmentation doesn't hold the lock, so when we enter here we don't actually have any
-        // lock protecting us. Since we mutate state here, we have to take the lock out now
-        m_Mutex.LockWrite();
-        pCtx->mutexLocked = true;
-    }
+            size_t newBlockIndex = 0;
+            VkResult res = (newBlockSize <= freeMemory || !canFallbackToDedicated) ?
+                CreateBlock(newBlockSize, &newBlockIndex) : VK_ERROR_OUT_OF_DEVICE_MEMORY;
+            // Allocation of this size failed? Try 1/2, 1/4, 1/8 of m_PreferredBlockSize.
+            while(res < 0 && ShrinkNewBlockSize(size, newBlockSize, newBlockSizeShift))
+            {
+                res = (newBlockSize <= freeMemory || !canFallbackToDedicated) ?
+                    CreateBlock(newBlockSize, &newBlockIndex) : VK_ERROR_OUT_OF_DEVICE_MEMORY;
+            }
 
-    // If the mutex isn't locked we didn't do any work and there is nothing to delete.
-    if(pCtx->mutexLocked || !m_hAllocator->m_UseMutex)
-    {
-        // Destroy buffers.
-        for(size_t blockIndex = pCtx->blockContexts.size(); blockIndex--;)
-        {
-            VmaBlockDefragmentationContext &blockCtx = pCtx->blockContexts[blockIndex];
-            if(blockCtx.hBuffer)
+            if(res == VK_SUCCESS)
             {
-                (*m_hAllocator->GetVulkanFunctions().vkDestroyBuffer)(m_hAllocator->m_hDevice, blockCtx.hBuffer, m_hAllocator->GetAllocationCallbacks());
+                VmaDeviceMemoryBlock* const pBlock = m_Blocks[newBlockIndex];
+                VMA_ASSERT(pBlock->m_pMetadata->GetSize() >= size);
+
+                res = AllocateFromBlock(
+                    pBlock,
+                    currentFrameIndex,
+                    size,
+                    alignment,
+                    allocFlagsCopy,
+                    createInfo.pUserData,
+                    createInfo.lifetime,
+                    suballocType,
+                    strategy,
+                    pAllocation);
+                if(res == VK_SUCCESS)
+                {
+                    VMA_DEBUG_LOG("    Created new block #%u Size=%llu", pBlock->GetId(), newBlockSize);
+                    (*pAllocation)->SetCreatedBlock();
+                    return VK_SUCCESS;
+                }
+                else
+                {
+                    // Allocation from new block failed, possibly due to VMA_DEBUG_MARGIN or alignment.
+                    return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+                }
             }
         }
 
-        if(pCtx->res >= VK_SUCCESS)
+        // 3. Blocks with allocations of different lifetime were skipped so far.
+        // Mixing lifetimes is still better than failing.
+        if(createInfo.lifetime != VMA_ALLOCATION_LIFETIME_UNKNOWN &&
+            m_Algorithm != VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT)
         {
-            FreeEmptyBlocks(pStats);
+            for(size_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex )
+            {
+                VmaDeviceMemoryBlock* const pCurrBlock = m_Blocks[blockIndex];
+                VMA_ASSERT(pCurrBlock);
+                if(IsLifetimeCompatible(pCurrBlock, createInfo.lifetime))
+                {
+                    continue;
+                }
+                VkResult res = AllocateFromBlock(
+                    pCurrBlock,
+                    currentFrameIndex,
+                    size,
+                    alignment,
+                    allocFlagsCopy,
+                    createInfo.pUserData,
+                    createInfo.lifetime,
+                    suballocType,
+                    strategy,
+                    pAllocation);
+                if(res == VK_SUCCESS)
+                {
+                    VMA_DEBUG_LOG("    Returned from existing block #%u with different lifetime", pCurrBlock->GetId());
+                    return VK_SUCCESS;
+                }
+            }
         }
     }
 
-    if(pCtx->mutexLocked)
-    {
-        VMA_ASSERT(m_hAllocator->m_UseMutex);
-        m_Mutex.UnlockWrite();
-    }
-}
-
-uint32_t VmaBlockVector::ProcessDefragmentations(
-    class VmaBlockVectorDefragmentationContext *pCtx,
-    VmaDefragmentationPassMoveInfo* pMove, uint32_t maxMoves)
-{
-    VmaMutexLockWrite lock(m_Mutex, m_hAllocator->m_UseMutex);
-
-    const uint32_t moveCount = VMA_MIN(uint32_t(pCtx->defragmentationMoves.size()) - pCtx->defragmentationMovesProcessed, maxMoves);
-
-    for(uint32_t i = 0; i < moveCount; ++ i)
+    // 4. Try to allocate from existing blocks with making other allocations lost.
+    if(canMakeOtherLost)
     {
-        VmaDefragmentationMove& move = pCtx->defragmentationMoves[pCtx->defragmentationMovesProcessed + i];
-
-        pMove->allocation = move.hAllocation;
-        pMove->memory = move.pDstBlock->GetDeviceMemory();
-        pMove->offset = move.dstOffset;
-
-        ++ pMove;
-    }
+        uint32_t tryIndex = 0;
+        for(; tryIndex < VMA_ALLOCATION_TRY_COUNT; ++tryIndex)
+        {
+            VmaDeviceMemoryBlock* pBestRequestBlock = VMA_NULL;
+            VmaAllocationRequest bestRequest = {};
+            VkDeviceSize bestRequestCost = VK_WHOLE_SIZE;
 
-    pCtx->defragmentationMovesProcessed += moveCount;
+            // 1. Search existing allocations.
+            if(strategy == VMA_ALLOCATION_CREATE_STRATEGY_BEST_FIT_BIT)
+            {
+                // Forward order in m_Blocks - prefer blocks with smallest amount of free space.
+                for(size_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex )
+                {
+                    VmaDeviceMemoryBlock* const pCurrBlock = m_Blocks[blockIndex];
+                    VMA_ASSERT(pCurrBlock);
+                    VmaAllocationRequest currRequest = {};
+                    if(pCurrBlock->m_pMetadata->CreateAllocationRequest(
+                        currentFrameIndex,
+                        m_FrameInUseCount,
+                        m_BufferImageGranularity,
+                        size,
+                        alignment,
+                        (createInfo.flags & VMA_ALLOCATION_CREATE_UPPER_ADDRESS_BIT) != 0,
+                        suballocType,
+                        canMakeOtherLost,
+                        strategy,
+                        &currRequest))
+                    {
+                        const VkDeviceSize currRequestCost = currRequest.CalcCost();
+                        if(pBestRequestBlock == VMA_NULL ||
+                            currRequestCost < bestRequestCost)
+                        {
+                            pBestRequestBlock = pCurrBlock;
+                            bestRequest = currRequest;
+                            bestRequestCost = currRequestCost;
 
-    return moveCount;
-}
+                            if(bestRequestCost == 0)
+                            {
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+            else // WORST_FIT, FIRST_FIT
+            {
+                // Backward order in m_Blocks - prefer blocks with largest amount of free space.
+                for(size_t blockIndex = m_Blocks.size(); blockIndex--; )
+                {
+                    VmaDeviceMemoryBlock* const pCurrBlock = m_Blocks[blockIndex];
+                    VMA_ASSERT(pCurrBlock);
+                    VmaAllocationRequest currRequest = {};
+                    if(pCurrBlock->m_pMetadata->CreateAllocationRequest(
+                        currentFrameIndex,
+                        m_FrameInUseCount,
+                        m_BufferImageGranularity,
+                        size,
+                        alignment,
+                        (createInfo.flags & VMA_ALLOCATION_CREATE_UPPER_ADDRESS_BIT) != 0,
+                        suballocType,
+                        canMakeOtherLost,
+                        strategy,
+                        &currRequest))
+                    {
+                        const VkDeviceSize currRequestCost = currRequest.CalcCost();
+                        if(pBestRequestBlock == VMA_NULL ||
+                            currRequestCost < bestRequestCost ||
+                            strategy == VMA_ALLOCATION_CREATE_STRATEGY_FIRST_FIT_BIT)
+                        {
+                            pBestRequestBlock = pCurrBlock;
+                            bestRequest = currRequest;
+                            bestRequestCost = currRequestCost;
 
-void VmaBlockVector::CommitDefragmentations(
-    class VmaBlockVectorDefragmentationContext *pCtx,
-    VmaDefragmentationStats* pStats)
-{
-    VmaMutexLockWrite lock(m_Mutex, m_hAllocator->m_UseMutex);
+                            if(bestRequestCost == 0 ||
+                                strategy == VMA_ALLOCATION_CREATE_STRATEGY_FIRST_FIT_BIT)
+                            {
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
 
-    for(uint32_t i = pCtx->defragmentationMovesCommitted; i < pCtx->defragmentationMovesProcessed; ++ i)
-    {
-        const VmaDefragmentationMove &move = pCtx->defragmentationMoves[i];
+            if(pBestRequestBlock != VMA_NULL)
+            {
+                if(mapped)
+                {
+                    VkResult res = pBestRequestBlock->Map(m_hAllocator, 1, VMA_NULL);
+                    if(res != VK_SUCCESS)
+                    {
+                        return res;
+                    }
+                }
+                void* pBlockData = VMA_NULL;
+                if(isZeroed)
+                {
+                    VkResult res = pBestRequestBlock->Map(m_hAllocator, 1, &pBlockData);
+                    if(res != VK_SUCCESS)
+                    {
+                        return res;
+                    }
+                }
 
-        move.pSrcBlock->m_pMetadata->FreeAtOffset(move.srcOffset);
-        move.hAllocation->ChangeBlockAllocation(m_hAllocator, move.pDstBlock, move.dstOffset);
+                if(pBestRequestBlock->m_pMetadata->MakeRequestedAllocationsLost(
+                    currentFrameIndex,
+                    m_FrameInUseCount,
+                    &bestRequest))
+                {
+                    // Allocate from this pBlock.
+                    if(pBestRequestBlock->m_pMetadata->IsEmpty())
+                    {
+                        pBestRequestBlock->SetLifetime(createInfo.lifetime);
+                        pBestRequestBlock->SetPriority(m_Priority);
+                    }
+                    *pAllocation = m_hAllocator->m_AllocationObjectAllocator.Allocate(currentFrameIndex, isUserDataString);
+                    pBestRequestBlock->m_pMetadata->Alloc(bestRequest, suballocType, size, *pAllocation);
+                    UpdateHasEmptyBlock();
+                    (*pAllocation)->InitBlockAllocation(
+                        pBestRequestBlock,
+                        bestRequest.offset,
+                        alignment,
+                        size,
+                        m_MemoryTypeIndex,
+                        suballocType,
+                        mapped,
+                        (createInfo.flags & VMA_ALLOCATION_CREATE_CAN_BECOME_LOST_BIT) != 0);
+                    VMA_HEAVY_ASSERT(pBestRequestBlock->Validate());
+                    VMA_DEBUG_LOG("    Returned from existing block");
+                    (*pAllocation)->SetUserData(m_hAllocator, createInfo.pUserData);
+                    m_hAllocator->m_Budget.AddAllocation(m_hAllocator->MemoryTypeIndexToHeapIndex(m_MemoryTypeIndex), size);
+                    if(isZeroed)
+                    {
+                        memset((char*)pBlockData + bestRequest.offset, 0, (size_t)size);
+                        m_hAllocator->FlushOrInvalidateAllocation(*pAllocation, 0, VK_WHOLE_SIZE, VMA_CACHE_FLUSH);
+                        pBestRequestBlock->Unmap(m_hAllocator, 1);
+                    }
+                    else if(VMA_DEBUG_INITIALIZE_ALLOCATIONS)
+                    {
+                        m_hAllocator->FillAllocation(*pAllocation, VMA_ALLOCATION_FILL_PATTERN_CREATED);
+                    }
+                    if(IsCorruptionDetectionEnabled())
+                    {
+                        VkResult res = pBestRequestBlock->WriteMagicValueAroundAllocation(m_hAllocator, bestRequest.offset, size);
+                        VMA_ASSERT(res == VK_SUCCESS && "Couldn't map block memory to write magic value.");
+                    }
+                    return VK_SUCCESS;
+                }
+                // else: Some allocations must have been touched while we are here. Next try.
+                if(isZeroed)
+                {
+                    pBestRequestBlock->Unmap(m_hAllocator, 1);
+                }
+            }
+            else
+            {
+                // Could not find place in any of the blocks - break outer loop.
+                break;
+            }
+        }
+        /* Maximum number of tries exceeded - a very unlike event when many other
+        threads are simultaneously touching allocations making it impossible to make
+        lost at the same time as we try to allocate. */
+        if(tryIndex == VMA_ALLOCATION_TRY_COUNT)
+        {
+            return VK_ERROR_TOO_MANY_OBJECTS;
+        }
     }
 
-    pCtx->defragmentationMovesCommitted = pCtx->defragmentationMovesProcessed;
-    FreeEmptyBlocks(pStats);
+    return VK_ERROR_OUT_OF_DEVICE_MEMORY;
 }
 
-size_t VmaBlockVector::CalcAllocationCount() const
+void VmaBlockVector::Free(
+    const VmaAllocation hAllocation)
 {
-    size_t result = 0;
-    for(size_t i = 0; i < m_Blocks.size(); ++i)
-    {
-        result += m_Blocks[i]->m_pMetadata->GetAllocationCount();
-    }
-    return result;
-}
+    VmaDeviceMemoryBlock* pBlockToDelete = VMA_NULL;
 
-bool VmaBlockVector::IsBufferImageGranularityConflictPossible() const
-{
-    if(m_BufferImageGranularity == 1)
-    {
-        return false;
-    }
-    VmaSuballocationType lastSuballocType = VMA_SUBALLOCATION_TYPE_FREE;
-    for(size_t i = 0, count = m_Blocks.size(); i < count; ++i)
+    bool budgetExceeded = false;
     {
-        VmaDeviceMemoryBlock* const pBlock = m_Blocks[i];
-        VMA_ASSERT(m_Algorithm == 0);
-        VmaBlockMetadata_Generic* const pMetadata = (VmaBlockMetadata_Generic*)pBlock->m_pMetadata;
-        if(pMetadata->IsBufferImageGranularityConflictPossible(m_BufferImageGranularity, lastSuballocType))
-        {
-            return true;
-        }
+        const uint32_t heapIndex = m_hAllocator->MemoryTypeIndexToHeapIndex(m_MemoryTypeIndex);
+        VmaBudget heapBudget = {};
+        m_hAllocator->GetBudget(&heapBudget, heapIndex, 1);
+        budgetExceeded = heapBudget.usage >= heapBudget.budget;
     }
-    return false;
-}
 
-void VmaBlockVector::MakePoolAllocationsLost(
-    uint32_t currentFrameIndex,
-    size_t* pLostAllocationCount)
-{
-    VmaMutexLockWrite lock(m_Mutex, m_hAllocator->m_UseMutex);
-    size_t lostAllocationCount = 0;
-    for(uint32_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex)
-    {
-        VmaDeviceMemoryBlock* const pBlock = m_Blocks[blockIndex];
-        VMA_ASSERT(pBlock);
-        lostAllocationCount += pBlock->m_pMetadata->MakeAllocationsLost(currentFrameIndex, m_FrameInUseCount);
-    }
-    if(pLostAllocationCount != VMA_NULL)
+    // Scope for lock.
     {
-        *pLostAllocationCount = lostAllocationCount;
-    }
-}
+        VmaMutexLockWrite lock(m_Mutex, m_hAllocator->m_UseMutex);
 
-VkResult VmaBlockVector::CheckCorruption()
-{
-    if(!IsCorruptionDetectionEnabled())
-    {
-        return VK_ERROR_FEATURE_NOT_PRESENT;
-    }
+        VmaDeviceMemoryBlock* pBlock = hAllocation->GetBlock();
 
-    VmaMutexLockRead lock(m_Mutex, m_hAllocator->m_UseMutex);
-    for(uint32_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex)
-    {
-        VmaDeviceMemoryBlock* const pBlock = m_Blocks[blockIndex];
-        VMA_ASSERT(pBlock);
-        VkResult res = pBlock->CheckCorruption(m_hAllocator);
-        if(res != VK_SUCCESS)
+        if(IsCorruptionDetectionEnabled())
         {
-            return res;
+            VkResult res = pBlock->ValidateMagicValueAroundAllocation(m_hAllocator, hAllocation->GetOffset(), hAllocation->GetSize());
+            VMA_ASSERT(res == VK_SUCCESS && "Couldn't map block memory to validate magic value.");
         }
-    }
-    return VK_SUCCESS;
-}
-
-void VmaBlockVector::AddStats(VmaStats* pStats)
-{
-    const uint32_t memTypeIndex = m_MemoryTypeIndex;
-    const uint32_t memHeapIndex = m_hAllocator->MemoryTypeIndexToHeapIndex(memTypeIndex);
 
-    VmaMutexLockRead lock(m_Mutex, m_hAllocator->m_UseMutex);
+        if(hAllocation->IsPersistentMap())
+        {
+            pBlock->Unmap(m_hAllocator, 1);
+        }
 
-    for(uint32_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex)
-    {
-        const VmaDeviceMemoryBlock* const pBlock = m_Blocks[blockIndex];
-        VMA_ASSERT(pBlock);
+        pBlock->m_pMetadata->Free(hAllocation);
         VMA_HEAVY_ASSERT(pBlock->Validate());
-        VmaStatInfo allocationStatInfo;
-        pBlock->m_pMetadata->CalcAllocationStatInfo(allocationStatInfo);
-        VmaAddStatInfo(pStats->total, allocationStatInfo);
-        VmaAddStatInfo(pStats->memoryType[memTypeIndex], allocationStatInfo);
-        VmaAddStatInfo(pStats->memoryHeap[memHeapIndex], allocationStatInfo);
-    }
-}
 
-////////////////////////////////////////////////////////////////////////////////
-// VmaDefragmentationAlgorithm_Generic members definition
+        VMA_DEBUG_LOG("  Freed from MemoryTypeIndex=%u", m_MemoryTypeIndex);
 
-VmaDefragmentationAlgorithm_Generic::VmaDefragmentationAlgorithm_Generic(
-    VmaAllocator hAllocator,
-    VmaBlockVector* pBlockVector,
-    uint32_t currentFrameIndex,
-    bool overlappingMoveSupported) :
-    VmaDefragmentationAlgorithm(hAllocator, pBlockVector, currentFrameIndex),
-    m_AllocationCount(0),
-    m_AllAllocations(false),
-    m_BytesMoved(0),
-    m_AllocationsMoved(0),
-    m_Blocks(VmaStlAllocator<BlockInfo*>(hAllocator->GetAllocationCallbacks()))
-{
-    // Create block info for each block.
-    const size_t blockCount = m_pBlockVector->m_Blocks.size();
-    for(size_t blockIndex = 0; blockIndex < blockCount; ++blockIndex)
-    {
-        BlockInfo* pBlockInfo = vma_new(m_hAllocator, BlockInfo)(m_hAllocator->GetAllocationCallbacks());
-        pBlockInfo->m_OriginalBlockIndex = blockIndex;
-        pBlockInfo->m_pBlock = m_pBlockVector->m_Blocks[blockIndex];
-        m_Blocks.push_back(pBlockInfo);
-    }
-
-    // Sort them by m_pBlock pointer value.
-    VMA_SORT(m_Blocks.begin(), m_Blocks.end(), BlockPointerLess());
-}
-
-VmaDefragmentationAlgorithm_Generic::~VmaDefragmentationAlgorithm_Generic()
-{
-    for(size_t i = m_Blocks.size(); i--; )
-    {
-        vma_delete(m_hAllocator, m_Blocks[i]);
-    }
-}
-
-void VmaDefragmentationAlgorithm_Generic::AddAllocation(VmaAllocation hAlloc, VkBool32* pChanged)
-{
-    // Now as we are inside VmaBlockVector::m_Mutex, we can make final check if this allocation was not lost.
-    if(hAlloc->GetLastUseFrameIndex() != VMA_FRAME_INDEX_LOST)
-    {
-        VmaDeviceMemoryBlock* pBlock = hAlloc->GetBlock();
-        BlockInfoVector::iterator it = VmaBinaryFindFirstNotLess(m_Blocks.begin(), m_Blocks.end(), pBlock, BlockPointerLess());
-        if(it != m_Blocks.end() && (*it)->m_pBlock == pBlock)
+        const bool canDeleteBlock = m_Blocks.size() > m_MinBlockCount;
+        // pBlock became empty after this deallocation.
+        if(pBlock->m_pMetadata->IsEmpty())
         {
-            AllocationInfo allocInfo = AllocationInfo(hAlloc, pChanged);
-            (*it)->m_Allocations.push_back(allocInfo);
+            // Already has empty block. We don't want to have two, so delete this one.
+            if((m_HasEmptyBlock || budgetExceeded) && canDeleteBlock)
+            {
+                pBlockToDelete = pBlock;
+                Remove(pBlock);
+            }
+            // else: We now have an empty block - leave it.
         }
-        else
+        // pBlock didn't become empty, but we have another empty block - find and free that one.
+        // (This is optional, heuristics.)
+        else if(m_HasEmptyBlock && canDeleteBlock)
         {
-            VMA_ASSERT(0);
+            VmaDeviceMemoryBlock* pLastBlock = m_Blocks.back();
+            if(pLastBlock->m_pMetadata->IsEmpty())
+            {
+                pBlockToDelete = pLastBlock;
+                m_Blocks.pop_back();
+            }
         }
 
-        ++m_AllocationCount;
+        UpdateHasEmptyBlock();
+        IncrementallySortBlocks();
     }
-}
 
-VkResult VmaDefragmentationAlgorithm_Generic::DefragmentRound(
-    VmaVector< VmaDefragmentationMove, VmaStlAllocator<VmaDefragmentationMove> >& moves,
-    VkDeviceSize maxBytesToMove,
-    uint32_t maxAllocationsToMove,
-    bool freeOldAllocations)
-{
-    if(m_Blocks.empty())
+    // Destruction of a free block. Deferred until this point, outside of mutex
+    // lock, for performance reason.
+    if(pBlockToDelete != VMA_NULL)
     {
-        return VK_SUCCESS;
+        VMA_DEBUG_LOG("    Deleted empty block");
+        pBlockToDelete->Destroy(m_hAllocator);
+        vma_delete(m_hAllocator, pBlockToDelete);
     }
+}
 
-    // This is a choice based on research.
-    // Option 1:
-    uint32_t strategy = VMA_ALLOCATION_CREATE_STRATEGY_MIN_TIME_BIT;
-    // Option 2:
-    //uint32_t strategy = VMA_ALLOCATION_CREATE_STRATEGY_MIN_MEMORY_BIT;
-    // Option 3:
-    //uint32_t strategy = VMA_ALLOCATION_CREATE_STRATEGY_MIN_FRAGMENTATION_BIT;
+void VmaBlockVector::FreeBatch(const VmaAllocation* pAllocations, size_t allocationCount)
+{
+    const VmaStlAllocator<VmaDeviceMemoryBlock*> blockAllocator(m_hAllocator->GetAllocationCallbacks());
+    VmaVector< VmaDeviceMemoryBlock*, VmaStlAllocator<VmaDeviceMemoryBlock*> > blocksToDelete(blockAllocator);
 
-    size_t srcBlockMinIndex = 0;
-    // When FAST_ALGORITHM, move allocations from only last out of blocks that contain non-movable allocations.
-    /*
-    if(m_AlgorithmFlags & VMA_DEFRAGMENTATION_FAST_ALGORITHM_BIT)
+    VmaBudget heapBudget = {};
+    m_hAllocator->GetBudget(&heapBudget, m_hAllocator->MemoryTypeIndexToHeapIndex(m_MemoryTypeIndex), 1);
+
+    // Scope for lock.
     {
-        const size_t blocksWithNonMovableCount = CalcBlocksWithNonMovableCount();
-        if(blocksWithNonMovableCount > 0)
+        VmaMutexLockWrite lock(m_Mutex, m_hAllocator->m_UseMutex);
+
+        for(size_t allocIndex = 0; allocIndex < allocationCount; )
         {
-            srcBlockMinIndex = blocksWithNonMovableCount - 1;
+            VmaDeviceMemoryBlock* const pBlock = pAllocations[allocIndex]->GetBlock();
+            size_t blockAllocEnd = allocIndex + 1;
+            while(blockAllocEnd < allocationCount && pAllocations[blockAllocEnd]->GetBlock() == pBlock)
+            {
+                ++blockAllocEnd;
+            }
+            pBlock->m_pMetadata->FreeBatch(pAllocations + allocIndex, blockAllocEnd - allocIndex);
+            ReleaseRemovedAllocations(pBlock, pAllocations + allocIndex, blockAllocEnd - allocIndex);
+            allocIndex = blockAllocEnd;
         }
-    }
-    */
 
-    size_t srcBlockIndex = m_Blocks.size() - 1;
-    size_t srcAllocIndex = SIZE_MAX;
-    for(;;)
-    {
-        // 1. Find next allocation to move.
-        // 1.1. Start from last to first m_Blocks - they are sorted from most "destination" to most "source".
-        // 1.2. Then start from last to first m_Allocations.
-        while(srcAllocIndex >= m_Blocks[srcBlockIndex]->m_Allocations.size())
+        VMA_DEBUG_LOG("  Freed %u allocations from MemoryTypeIndex=%u", (uint32_t)allocationCount, m_MemoryTypeIndex);
+
+        /*
+        Same rule as in Free(), applied as if the allocations were freed one by one: an empty block is deleted
+        if another one is already left or the budget is exceeded, and only above m_MinBlockCount.
+        Free() queries the budget again on every call, so usage is lowered here by each deleted block.
+        */
+        bool hasEmptyBlock = false;
+        for(size_t blockIndex = m_Blocks.size(); blockIndex--; )
         {
-            if(m_Blocks[srcBlockIndex]->m_Allocations.empty())
+            VmaDeviceMemoryBlock* const pBlock = m_Blocks[blockIndex];
+            if(pBlock->m_pMetadata->IsEmpty())
             {
-                // Finished: no more allocations to process.
-                if(srcBlockIndex == srcBlockMinIndex)
+                const bool budgetExceeded = heapBudget.usage >= heapBudget.budget;
+                if((hasEmptyBlock || budgetExceeded) && m_Blocks.size() > m_MinBlockCount)
                 {
-                    return VK_SUCCESS;
+                    heapBudget.usage -= VMA_MIN(heapBudget.usage, pBlock->m_pMetadata->GetSize());
+                    blocksToDelete.push_back(pBlock);
+                    VmaVectorRemove(m_Blocks, blockIndex);
                 }
                 else
                 {
-                    --srcBlockIndex;
-                    srcAllocIndex = SIZE_MAX;
+                    hasEmptyBlock = true;
                 }
             }
-            else
-            {
-                srcAllocIndex = m_Blocks[srcBlockIndex]->m_Allocations.size() - 1;
-            }
         }
 
-        BlockInfo* pSrcBlockInfo = m_Blocks[srcBlockIndex];
-        AllocationInfo& allocInfo = pSrcBlockInfo->m_Allocations[srcAllocIndex];
-
-        const VkDeviceSize size = allocInfo.m_hAllocation->GetSize();
-        const VkDeviceSize srcOffset = allocInfo.m_hAllocation->GetOffset();
-        const VkDeviceSize alignment = allocInfo.m_hAllocation->GetAlignment();
-        const VmaSuballocationType suballocType = allocInfo.m_hAllocation->GetSuballocationType();
-
-        // 2. Try to find new place for this allocation in preceding or current block.
-        for(size_t dstBlockIndex = 0; dstBlockIndex <= srcBlockIndex; ++dstBlockIndex)
-        {
-            BlockInfo* pDstBlockInfo = m_Blocks[dstBlockIndex];
-            VmaAllocationRequest dstAllocRequest;
-            if(pDstBlockInfo->m_pBlock->m_pMetadata->CreateAllocationRequest(
-                m_CurrentFrameIndex,
-                m_pBlockVector->GetFrameInUseCount(),
-                m_pBlockVector->GetBufferImageGranularity(),
-                size,
-                alignment,
-                false, // upperAddress
-                suballocType,
-                false, // canMakeOtherLost
-                strategy,
-                &dstAllocRequest) &&
-            MoveMakesSense(
-                dstBlockIndex, dstAllocRequest.offset, srcBlockIndex, srcOffset))
-            {
-                VMA_ASSERT(dstAllocRequest.itemsToMakeLostCount == 0);
-
-                // Reached limit on number of allocations or bytes to move.
-                if((m_AllocationsMoved + 1 > maxAllocationsToMove) ||
-                    (m_BytesMoved + size > maxBytesToMove))
-                {
-                    return VK_SUCCESS;
-                }
-
-                VmaDefragmentationMove move = {};
-                move.srcBlockIndex = pSrcBlockInfo->m_OriginalBlockIndex;
-                move.dstBlockIndex = pDstBlockInfo->m_OriginalBlockIndex;
-                move.srcOffset = srcOffset;
-                move.dstOffset = dstAllocRequest.offset;
-                move.size = size;
-                move.hAllocation = allocInfo.m_hAllocation;
-                move.pSrcBlock = pSrcBlockInfo->m_pBlock;
-                move.pDstBlock = pDstBlockInfo->m_pBlock;
+        UpdateHasEmptyBlock();
+        SortBlocks();
+    }
 
-                moves.push_back(move);
+    // Destruction of free blocks. Deferred until this point, outside of mutex
+    // lock, for performance reason.
+    for(size_t blockIndex = 0; blockIndex < blocksToDelete.size(); ++blockIndex)
+    {
+        VMA_DEBUG_LOG("    Deleted empty block");
+        blocksToDelete[blockIndex]->Destroy(m_hAllocator);
+        vma_delete(m_hAllocator, blocksToDelete[blockIndex]);
+    }
+}
 
-                pDstBlockInfo->m_pBlock->m_pMetadata->Alloc(
-                    dstAllocRequest,
-                    suballocType,
-                    size,
-                    allocInfo.m_hAllocation);
+VkResult VmaBlockVector::ResizeAllocation(
+    const VmaAllocation hAllocation,
+    VkDeviceSize newSize)
+{
+    VmaMutexLockWrite lock(m_Mutex, m_hAllocator->m_UseMutex);
 
-                if(freeOldAllocations)
-                {
-                    pSrcBlockInfo->m_pBlock->m_pMetadata->FreeAtOffset(srcOffset);
-                    allocInfo.m_hAllocation->ChangeBlockAllocation(m_hAllocator, pDstBlockInfo->m_pBlock, dstAllocRequest.offset);
-                }
+    if(IsCorruptionDetectionEnabled())
+    {
+        newSize = VmaAlignUp<VkDeviceSize>(newSize, sizeof(VMA_CORRUPTION_DETECTION_MAGIC_VALUE));
+    }
 
-                if(allocInfo.m_pChanged != VMA_NULL)
-                {
-                    *allocInfo.m_pChanged = VK_TRUE;
-                }
+    const VkDeviceSize oldSize = hAllocation->GetSize();
+    if(newSize == oldSize)
+    {
+        return VK_SUCCESS;
+    }
 
-                ++m_AllocationsMoved;
-                m_BytesMoved += size;
+    VmaDeviceMemoryBlock* pBlock = hAllocation->GetBlock();
+    if(!pBlock->m_pMetadata->ResizeAllocation(hAllocation, newSize, m_BufferImageGranularity))
+    {
+        return VK_ERROR_OUT_OF_POOL_MEMORY;
+    }
+    hAllocation->ChangeSize(newSize);
+    VMA_HEAVY_ASSERT(pBlock->Validate());
+    VMA_DEBUG_LOG("  Resized allocation in MemoryTypeIndex=%u from %llu to %llu", m_MemoryTypeIndex, oldSize, newSize);
 
-                VmaVectorRemove(pSrcBlockInfo->m_Allocations, srcAllocIndex);
+    const uint32_t heapIndex = m_hAllocator->MemoryTypeIndexToHeapIndex(m_MemoryTypeIndex);
+    if(newSize > oldSize)
+    {
+        m_hAllocator->m_Budget.AddAllocation(heapIndex, newSize - oldSize);
+    }
+    else
+    {
+        m_hAllocator->m_Budget.RemoveAllocation(heapIndex, oldSize - newSize);
+    }
 
-                break;
-            }
-        }
+    if(IsCorruptionDetectionEnabled())
+    {
+        VkResult res = pBlock->WriteMagicValueAroundAllocation(m_hAllocator, hAllocation->GetOffset(), newSize);
+        VMA_ASSERT(res == VK_SUCCESS && "Couldn't map block memory to write magic value.");
+    }
 
-        // If not processed, this allocInfo remains in pBlockInfo->m_Allocations for next round.
+    IncrementallySortBlocks();
+    return VK_SUCCESS;
+}
 
-        if(srcAllocIndex > 0)
-        {
-            --srcAllocIndex;
-        }
-        else
+VkDeviceSize VmaBlockVector::CalcNewBlockSize(VkDeviceSize allocSize, VkDeviceSize maxExistingBlockSize, uint32_t& outShift) const
+{
+    VkDeviceSize newBlockSize = m_PreferredBlockSize;
+    outShift = 0;
+    if(!m_ExplicitBlockSize)
+    {
+        // Allocate 1/8, 1/4, 1/2 as first blocks.
+        while(outShift < NEW_BLOCK_SIZE_SHIFT_MAX)
         {
-            if(srcBlockIndex > 0)
+            const VkDeviceSize smallerNewBlockSize = newBlockSize / 2;
+            if(smallerNewBlockSize > maxExistingBlockSize && smallerNewBlockSize >= allocSize * 2)
             {
-                --srcBlockIndex;
-                srcAllocIndex = SIZE_MAX;
+                newBlockSize = smallerNewBlockSize;
+                ++outShift;
             }
             else
             {
-                return VK_SUCCESS;
+                break;
             }
         }
     }
+    return newBlockSize;
 }
 
-size_t VmaDefragmentationAlgorithm_Generic::CalcBlocksWithNonMovableCount() const
+bool VmaBlockVector::ShrinkNewBlockSize(VkDeviceSize allocSize, VkDeviceSize& inoutBlockSize, uint32_t& inoutShift) const
 {
-    size_t result = 0;
-    for(size_t i = 0; i < m_Blocks.size(); ++i)
+    if(m_ExplicitBlockSize || inoutShift >= NEW_BLOCK_SIZE_SHIFT_MAX || inoutBlockSize / 2 < allocSize)
     {
-        if(m_Blocks[i]->m_HasNonMovableAllocations)
+        return false;
+    }
+    inoutBlockSize /= 2;
+    ++inoutShift;
+    return true;
+}
+
+VkDeviceSize VmaBlockVector::GetMaxBlockSize()
+{
+    VmaMutexLockRead lock(m_Mutex, m_hAllocator->m_UseMutex);
+    return CalcMaxBlockSize();
+}
+
+VkDeviceSize VmaBlockVector::CalcMaxBlockSize() const
+{
+    VkDeviceSize result = 0;
+    for(size_t i = m_Blocks.size(); i--; )
+    {
+        result = VMA_MAX(result, m_Blocks[i]->m_pMetadata->GetSize());
+        if(result >= m_PreferredBlockSize)
         {
-            ++result;
+            break;
         }
     }
     return result;
 }
 
-VkResult VmaDefragmentationAlgorithm_Generic::Defragment(
-    VmaVector< VmaDefragmentationMove, VmaStlAllocator<VmaDefragmentationMove> >& moves,
-    VkDeviceSize maxBytesToMove,
-    uint32_t maxAllocationsToMove,
-    VmaDefragmentationFlags flags)
+void VmaBlockVector::Remove(VmaDeviceMemoryBlock* pBlock)
 {
-    if(!m_AllAllocations && m_AllocationCount == 0)
+    for(uint32_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex)
     {
-        return VK_SUCCESS;
+        if(m_Blocks[blockIndex] == pBlock)
+        {
+            VmaVectorRemove(m_Blocks, blockIndex);
+            return;
+        }
     }
+    VMA_ASSERT(0);
+}
 
-    const size_t blockCount = m_Blocks.size();
-    for(size_t blockIndex = 0; blockIndex < blockCount; ++blockIndex)
+void VmaBlockVector::IncrementallySortBlocks()
+{
+    if(m_Algorithm != VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT)
     {
-        BlockInfo* pBlockInfo = m_Blocks[blockIndex];
-
-        if(m_AllAllocations)
+        // Bubble sort only until first swap.
+        for(size_t i = 1; i < m_Blocks.size(); ++i)
         {
-            VmaBlockMetadata_Generic* pMetadata = (VmaBlockMetadata_Generic*)pBlockInfo->m_pBlock->m_pMetadata;
-            for(VmaSuballocationList::const_iterator it = pMetadata->m_Suballocations.begin();
-                it != pMetadata->m_Suballocations.end();
-                ++it)
+            if(m_Blocks[i - 1]->m_pMetadata->GetSumFreeSize() > m_Blocks[i]->m_pMetadata->GetSumFreeSize())
             {
-                if(it->type != VMA_SUBALLOCATION_TYPE_FREE)
-                {
-                    AllocationInfo allocInfo = AllocationInfo(it->hAllocation, VMA_NULL);
-                    pBlockInfo->m_Allocations.push_back(allocInfo);
-                }
+                VMA_SWAP(m_Blocks[i - 1], m_Blocks[i]);
+                return;
             }
         }
-
-        pBlockInfo->CalcHasNonMovableAllocations();
-
-        // This is a choice based on research.
-        // Option 1:
-        pBlockInfo->SortAllocationsByOffsetDescending();
-        // Option 2:
-        //pBlockInfo->SortAllocationsBySizeDescending();
-    }
-
-    // Sort m_Blocks this time by the main criterium, from most "destination" to most "source" blocks.
-    VMA_SORT(m_Blocks.begin(), m_Blocks.end(), BlockInfoCompareMoveDestination());
-
-    // This is a choice based on research.
-    const uint32_t roundCount = 2;
-
-    // Execute defragmentation rounds (the main part).
-    VkResult result = VK_SUCCESS;
-    for(uint32_t round = 0; (round < roundCount) && (result == VK_SUCCESS); ++round)
-    {
-        result = DefragmentRound(moves, maxBytesToMove, maxAllocationsToMove, !(flags & VMA_DEFRAGMENTATION_FLAG_INCREMENTAL));
     }
-
-    return result;
 }
 
-bool VmaDefragmentationAlgorithm_Generic::MoveMakesSense(
-        size_t dstBlockIndex, VkDeviceSize dstOffset,
-        size_t srcBlockIndex, VkDeviceSize srcOffset)
+void VmaBlockVector::SortBlocks()
 {
-    if(dstBlockIndex < srcBlockIndex)
-    {
-        return true;
-    }
-    if(dstBlockIndex > srcBlockIndex)
-    {
-        return false;
-    }
-    if(dstOffset < srcOffset)
+    if(m_Algorithm != VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT)
     {
-        return true;
+        VMA_SORT(m_Blocks.begin(), m_Blocks.end(), [](const VmaDeviceMemoryBlock* lhs, const VmaDeviceMemoryBlock* rhs) -> bool {
+            return lhs->m_pMetadata->GetSumFreeSize() < rhs->m_pMetadata->GetSumFreeSize();
+        });
     }
-    return false;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-// VmaDefragmentationAlgorithm_Fast
+bool VmaBlockVector::IsLifetimeCompatible(const VmaDeviceMemoryBlock* pBlock, VmaAllocationLifetime lifetime) const
+{
+    // Linear algorithm allocates only from the last block anyway.
+    return lifetime == VMA_ALLOCATION_LIFETIME_UNKNOWN ||
+        m_Algorithm == VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT ||
+        pBlock->m_pMetadata->IsEmpty() ||
+        pBlock->GetLifetime() == lifetime;
+}
 
-VmaDefragmentationAlgorithm_Fast::VmaDefragmentationAlgorithm_Fast(
-    VmaAllocator hAllocator,
-    VmaBlockVector* pBlockVector,
+VkResult VmaBlockVector::AllocateFromBlock(
+    VmaDeviceMemoryBlock* pBlock,
     uint32_t currentFrameIndex,
-    bool overlappingMoveSupported) :
-    VmaDefragmentationAlgorithm(hAllocator, pBlockVector, currentFrameIndex),
-    m_OverlappingMoveSupported(overlappingMoveSupported),
-    m_AllocationCount(0),
-    m_AllAllocations(false),
-    m_BytesMoved(0),
-    m_AllocationsMoved(0),
-    m_BlockInfos(VmaStlAllocator<BlockInfo>(hAllocator->GetAllocationCallbacks()))
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    VmaAllocationCreateFlags allocFlags,
+    void* pUserData,
+    VmaAllocationLifetime lifetime,
+    VmaSuballocationType suballocType,
+    uint32_t strategy,
+    VmaAllocation* pAllocation)
 {
-    VMA_ASSERT(VMA_DEBUG_MARGIN == 0);
+    VMA_ASSERT((allocFlags & VMA_ALLOCATION_CREATE_CAN_MAKE_OTHER_LOST_BIT) == 0);
+    const bool isUpperAddress = (allocFlags & VMA_ALLOCATION_CREATE_UPPER_ADDRESS_BIT) != 0;
+    const bool mapped = (allocFlags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0;
+    const bool isUserDataString = (allocFlags & VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT) != 0;
+    // Place already known to contain zeros doesn't need to be cleared.
+    const bool clear = (allocFlags & VMA_ALLOCATION_CREATE_ZEROED_BIT) != 0 &&
+        strategy != VMA_ALLOCATION_INTERNAL_STRATEGY_ZEROED;
 
-}
+    // Short-lived allocations grow from the end of the block, so they don't
+    // pin free space between long-lived ones.
+    if(m_Algorithm == 0 &&
+        strategy != VMA_ALLOCATION_INTERNAL_STRATEGY_ZEROED &&
+        (lifetime == VMA_ALLOCATION_LIFETIME_SHORT || lifetime == VMA_ALLOCATION_LIFETIME_FRAME))
+    {
+        strategy = VMA_ALLOCATION_INTERNAL_STRATEGY_MAX_OFFSET;
+    }
 
-VmaDefragmentationAlgorithm_Fast::~VmaDefragmentationAlgorithm_Fast()
-{
+    VmaAllocationRequest currRequest = {};
+    if(pBlock->m_pMetadata->CreateAllocationRequest(
+        currentFrameIndex,
+        m_FrameInUseCount,
+        m_BufferImageGranularity,
+        size,
+        alignment,
+        isUpperAddress,
+        suballocType,
+        false, // canMakeOtherLost
+        strategy,
+        &currRequest))
+    {
+        // Allocate from pCurrBlock.
+        VMA_ASSERT(currRequest.itemsToMakeLostCount == 0);
+
+        if(mapped)
+        {
+            VkResult res = pBlock->Map(m_hAllocator, 1, VMA_NULL);
+            if(res != VK_SUCCESS)
+            {
+                return res;
+            }
+        }
+        void* pBlockData = VMA_NULL;
+        if(clear)
+        {
+            VkResult res = pBlock->Map(m_hAllocator, 1, &pBlockData);
+            if(res != VK_SUCCESS)
+            {
+                if(mapped)
+                {
+                    pBlock->Unmap(m_hAllocator, 1);
+                }
+                return res;
+            }
+        }
+
+        if(pBlock->m_pMetadata->IsEmpty())
+        {
+            pBlock->SetLifetime(lifetime);
+            pBlock->SetPriority(m_Priority);
+        }
+        *pAllocation = m_hAllocator->m_AllocationObjectAllocator.Allocate(currentFrameIndex, isUserDataString);
+        pBlock->m_pMetadata->Alloc(currRequest, suballocType, size, *pAllocation);
+        UpdateHasEmptyBlock();
+        (*pAllocation)->InitBlockAllocation(
+            pBlock,
+            currRequest.offset,
+            alignment,
+            size,
+            m_MemoryTypeIndex,
+            suballocType,
+            mapped,
+            (allocFlags & VMA_ALLOCATION_CREATE_CAN_BECOME_LOST_BIT) != 0);
+        VMA_HEAVY_ASSERT(pBlock->Validate());
+        (*pAllocation)->SetUserData(m_hAllocator, pUserData);
+        m_hAllocator->m_Budget.AddAllocation(m_hAllocator->MemoryTypeIndexToHeapIndex(m_MemoryTypeIndex), size);
+        if(clear)
+        {
+            memset((char*)pBlockData + currRequest.offset, 0, (size_t)size);
+            m_hAllocator->FlushOrInvalidateAllocation(*pAllocation, 0, VK_WHOLE_SIZE, VMA_CACHE_FLUSH);
+            pBlock->Unmap(m_hAllocator, 1);
+        }
+        else if(VMA_DEBUG_INITIALIZE_ALLOCATIONS && (allocFlags & VMA_ALLOCATION_CREATE_ZEROED_BIT) == 0)
+        {
+            m_hAllocator->FillAllocation(*pAllocation, VMA_ALLOCATION_FILL_PATTERN_CREATED);
+        }
+        if(IsCorruptionDetectionEnabled())
+        {
+            VkResult res = pBlock->WriteMagicValueAroundAllocation(m_hAllocator, currRequest.offset, size);
+            VMA_ASSERT(res == VK_SUCCESS && "Couldn't map block memory to write magic value.");
+        }
+        return VK_SUCCESS;
+    }
+    return VK_ERROR_OUT_OF_DEVICE_MEMORY;
 }
 
-VkResult VmaDefragmentationAlgorithm_Fast::Defragment(
-    VmaVector< VmaDefragmentationMove, VmaStlAllocator<VmaDefragmentationMove> >& moves,
-    VkDeviceSize maxBytesToMove,
-    uint32_t maxAllocationsToMove,
-    VmaDefragmentationFlags flags)
+VkResult VmaBlockVector::AllocatePagesInOneBlock(
+    uint32_t currentFrameIndex,
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    const VmaAllocationCreateInfo& createInfo,
+    VmaSuballocationType suballocType,
+    size_t allocationCount,
+    VmaAllocation* pAllocations)
 {
-    VMA_ASSERT(m_AllAllocations || m_pBlockVector->CalcAllocationCount() == m_AllocationCount);
+    VMA_ASSERT(allocationCount > 1);
+    const bool contiguous = (createInfo.flags & VMA_ALLOCATION_CREATE_PAGES_CONTIGUOUS_BIT) != 0;
+    const bool isZeroed = (createInfo.flags & VMA_ALLOCATION_CREATE_ZEROED_BIT) != 0;
+    const bool isHostVisible =
+        (m_hAllocator->m_MemProps.memoryTypes[m_MemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
 
-    const size_t blockCount = m_pBlockVector->GetBlockCount();
-    if(blockCount == 0 || maxBytesToMove == 0 || maxAllocationsToMove == 0)
+    if((createInfo.flags & (VMA_ALLOCATION_CREATE_CAN_MAKE_OTHER_LOST_BIT | VMA_ALLOCATION_CREATE_UPPER_ADDRESS_BIT)) != 0 ||
+        (contiguous && m_Algorithm == VMA_POOL_CREATE_BUDDY_ALGORITHM_BIT) ||
+        // Pages can be returned zeroed only by clearing them on the CPU.
+        (isZeroed && !isHostVisible))
     {
-        return VK_SUCCESS;
+        return VK_ERROR_FEATURE_NOT_PRESENT;
     }
 
-    PreprocessMetadata();
+    uint32_t strategy = createInfo.flags & VMA_ALLOCATION_CREATE_STRATEGY_MASK;
+    switch(strategy)
+    {
+    case 0:
+        strategy = VMA_ALLOCATION_CREATE_STRATEGY_BEST_FIT_BIT;
+        break;
+    case VMA_ALLOCATION_CREATE_STRATEGY_BEST_FIT_BIT:
+    case VMA_ALLOCATION_CREATE_STRATEGY_WORST_FIT_BIT:
+    case VMA_ALLOCATION_CREATE_STRATEGY_FIRST_FIT_BIT:
+        break;
+    default:
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
 
-    // Sort blocks in order from most destination.
+    // Pages of a run are separated by the same debug margin as any other allocations.
+    const VkDeviceSize stride = VmaAlignUp<VkDeviceSize>(size + VMA_DEBUG_MARGIN, alignment);
+    const VkDeviceSize runSize = stride * (allocationCount - 1) + size;
+    if(m_ExplicitBlockSize && (contiguous ? runSize : size * allocationCount) > m_PreferredBlockSize)
+    {
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
 
-    m_BlockInfos.resize(blockCount);
+    // 1. Search existing blocks. Run of all pages is tried first, as it needs only one search.
+    const size_t blockCount = m_Blocks.size();
     for(size_t i = 0; i < blockCount; ++i)
     {
-        m_BlockInfos[i].origBlockIndex = i;
+        // Forward order in m_Blocks prefers blocks with smallest amount of free space, backward order - with largest.
+        const size_t blockIndex = strategy == VMA_ALLOCATION_CREATE_STRATEGY_BEST_FIT_BIT ? i : blockCount - 1 - i;
+        if(m_Algorithm == VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT && blockIndex != blockCount - 1)
+        {
+            // Use only last block.
+            continue;
+        }
+        VmaDeviceMemoryBlock* const pCurrBlock = m_Blocks[blockIndex];
+        VMA_ASSERT(pCurrBlock);
+        if(pCurrBlock->m_pMetadata->GetSumFreeSize() < size * allocationCount ||
+            !IsLifetimeCompatible(pCurrBlock, createInfo.lifetime))
+        {
+            continue;
+        }
+        VkResult res = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        if(m_Algorithm != VMA_POOL_CREATE_BUDDY_ALGORITHM_BIT)
+        {
+            res = AllocateRunFromBlock(pCurrBlock, currentFrameIndex, size, alignment, stride,
+                createInfo, suballocType, strategy, allocationCount, pAllocations);
+        }
+        if(res != VK_SUCCESS && !contiguous && m_Algorithm != VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT)
+        {
+            res = AllocatePagesFromBlock(pCurrBlock, currentFrameIndex, size, alignment,
+                createInfo, suballocType, strategy, allocationCount, pAllocations);
+        }
+        if(res == VK_SUCCESS)
+        {
+            VMA_DEBUG_LOG("    Returned %zu pages from existing block #%u", allocationCount, pCurrBlock->GetId());
+            return VK_SUCCESS;
+        }
     }
 
-    VMA_SORT(m_BlockInfos.begin(), m_BlockInfos.end(), [this](const BlockInfo& lhs, const BlockInfo& rhs) -> bool {
-        return m_pBlockVector->GetBlock(lhs.origBlockIndex)->m_pMetadata->GetSumFreeSize() <
-            m_pBlockVector->GetBlock(rhs.origBlockIndex)->m_pMetadata->GetSumFreeSize();
-    });
+    // 2. Try to create new block, large enough for all the pages.
+    if((createInfo.flags & VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT) == 0 &&
+        m_Blocks.size() < m_MaxBlockCount)
+    {
+        // Debug margin at the beginning of the block is followed by padding to the alignment.
+        const VkDeviceSize minNewBlockSize = VmaAlignUp<VkDeviceSize>(VMA_DEBUG_MARGIN, alignment) + runSize + VMA_DEBUG_MARGIN;
+        const VkDeviceSize newBlockSize = m_ExplicitBlockSize ?
+            m_PreferredBlockSize : VMA_MAX(m_PreferredBlockSize, minNewBlockSize);
+        if((createInfo.flags & VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT) != 0)
+        {
+            const uint32_t heapIndex = m_hAllocator->MemoryTypeIndexToHeapIndex(m_MemoryTypeIndex);
+            VmaBudget heapBudget = {};
+            m_hAllocator->GetBudget(&heapBudget, heapIndex, 1);
+            if(heapBudget.usage + newBlockSize > heapBudget.budget)
+            {
+                return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+            }
+        }
 
-    // THE MAIN ALGORITHM
+        size_t newBlockIndex = 0;
+        VkResult res = CreateBlock(newBlockSize, &newBlockIndex);
+        if(res == VK_SUCCESS)
+        {
+            VmaDeviceMemoryBlock* const pBlock = m_Blocks[newBlockIndex];
+            if(m_Algorithm != VMA_POOL_CREATE_BUDDY_ALGORITHM_BIT)
+            {
+                res = AllocateRunFromBlock(pBlock, currentFrameIndex, size, alignment, stride,
+                    createInfo, suballocType, strategy, allocationCount, pAllocations);
+            }
+            else
+            {
+                res = AllocatePagesFromBlock(pBlock, currentFrameIndex, size, alignment,
+                    createInfo, suballocType, strategy, allocationCount, pAllocations);
+            }
+            if(res == VK_SUCCESS)
+            {
+                VMA_DEBUG_LOG("    Created new block #%u Size=%llu for %zu pages", pBlock->GetId(), newBlockSize, allocationCount);
+                pAllocations[0]->SetCreatedBlock();
+                return VK_SUCCESS;
+            }
+        }
+    }
 
-    FreeSpaceDatabase freeSpaceDb;
+    return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+}
 
-    size_t dstBlockInfoIndex = 0;
-    size_t dstOrigBlockIndex = m_BlockInfos[dstBlockInfoIndex].origBlockIndex;
-    VmaDeviceMemoryBlock* pDstBlock = m_pBlockVector->GetBlock(dstOrigBlockIndex);
-    VmaBlockMetadata_Generic* pDstMetadata = (VmaBlockMetadata_Generic*)pDstBlock->m_pMetadata;
-    VkDeviceSize dstBlockSize = pDstMetadata->GetSize();
-    VkDeviceSize dstOffset = 0;
+VkResult VmaBlockVector::AllocateRunFromBlock(
+    VmaDeviceMemoryBlock* pBlock,
+    uint32_t currentFrameIndex,
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    VkDeviceSize stride,
+    const VmaAllocationCreateInfo& createInfo,
+    VmaSuballocationType suballocType,
+    uint32_t strategy,
+    size_t allocationCount,
+    VmaAllocation* pAllocations)
+{
+    const bool mapped = (createInfo.flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0;
+    const bool isUserDataString = (createInfo.flags & VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT) != 0;
+    const bool clear = (createInfo.flags & VMA_ALLOCATION_CREATE_ZEROED_BIT) != 0;
+    const VkDeviceSize runSize = stride * (allocationCount - 1) + size;
 
-    bool end = false;
-    for(size_t srcBlockInfoIndex = 0; !end && srcBlockInfoIndex < blockCount; ++srcBlockInfoIndex)
+    if(m_Algorithm == 0 &&
+        (createInfo.lifetime == VMA_ALLOCATION_LIFETIME_SHORT || createInfo.lifetime == VMA_ALLOCATION_LIFETIME_FRAME))
     {
-        const size_t srcOrigBlockIndex = m_BlockInfos[srcBlockInfoIndex].origBlockIndex;
-        VmaDeviceMemoryBlock* const pSrcBlock = m_pBlockVector->GetBlock(srcOrigBlockIndex);
-        VmaBlockMetadata_Generic* const pSrcMetadata = (VmaBlockMetadata_Generic*)pSrcBlock->m_pMetadata;
-        for(VmaSuballocationList::iterator srcSuballocIt = pSrcMetadata->m_Suballocations.begin();
-            !end && srcSuballocIt != pSrcMetadata->m_Suballocations.end(); )
+        strategy = VMA_ALLOCATION_INTERNAL_STRATEGY_MAX_OFFSET;
+    }
+
+    VmaAllocationRequest request = {};
+    if(!pBlock->m_pMetadata->CreateAllocationRequest(
+        currentFrameIndex,
+        m_FrameInUseCount,
+        m_BufferImageGranularity,
+        runSize,
+        alignment,
+        false, // upperAddress
+        suballocType,
+        false, // canMakeOtherLost
+        strategy,
+        &request))
+    {
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+    VMA_ASSERT(request.itemsToMakeLostCount == 0);
+
+    if(mapped)
+    {
+        VkResult res = pBlock->Map(m_hAllocator, (uint32_t)allocationCount, VMA_NULL);
+        if(res != VK_SUCCESS)
         {
-            VmaAllocation_T* const pAlloc = srcSuballocIt->hAllocation;
-            const VkDeviceSize srcAllocAlignment = pAlloc->GetAlignment();
-            const VkDeviceSize srcAllocSize = srcSuballocIt->size;
-            if(m_AllocationsMoved == maxAllocationsToMove ||
-                m_BytesMoved + srcAllocSize > maxBytesToMove)
+            return res;
+        }
+    }
+    void* pBlockData = VMA_NULL;
+    if(clear)
+    {
+        VkResult res = pBlock->Map(m_hAllocator, 1, &pBlockData);
+        if(res != VK_SUCCESS)
+        {
+            if(mapped)
             {
-                end = true;
-                break;
+                pBlock->Unmap(m_hAllocator, (uint32_t)allocationCount);
             }
-            const VkDeviceSize srcAllocOffset = srcSuballocIt->offset;
-
-            VmaDefragmentationMove move = {};
-            // Try to place it in one of free spaces from the database.
-            size_t freeSpaceInfoIndex;
-            VkDeviceSize dstAllocOffset;
-            if(freeSpaceDb.Fetch(srcAllocAlignment, srcAllocSize,
-                freeSpaceInfoIndex, dstAllocOffset))
-            {
-                size_t freeSpaceOrigBlockIndex = m_BlockInfos[freeSpaceInfoIndex].origBlockIndex;
-                VmaDeviceMemoryBlock* pFreeSpaceBlock = m_pBlockVector->GetBlock(freeSpaceOrigBlockIndex);
-                VmaBlockMetadata_Generic* pFreeSpaceMetadata = (VmaBlockMetadata_Generic*)pFreeSpaceBlock->m_pMetadata;
-
-                // Same block
-                if(freeSpaceInfoIndex == srcBlockInfoIndex)
-                {
-                    VMA_ASSERT(dstAllocOffset <= srcAllocOffset);
+            return res;
+        }
+    }
 
-                    // MOVE OPTION 1: Move the allocation inside the same block by decreasing offset.
+    if(pBlock->m_pMetadata->IsEmpty())
+    {
+        pBlock->SetLifetime(createInfo.lifetime);
+        pBlock->SetPriority(m_Priority);
+    }
+    for(size_t allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
+    {
+        pAllocations[allocIndex] = m_hAllocator->m_AllocationObjectAllocator.Allocate(currentFrameIndex, isUserDataString);
+    }
+    pBlock->m_pMetadata->AllocPages(request, suballocType, size, stride, allocationCount, pAllocations);
+    UpdateHasEmptyBlock();
+    for(size_t allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
+    {
+        const VkDeviceSize offset = request.offset + stride * allocIndex;
+        const VmaAllocation alloc = pAllocations[allocIndex];
+        alloc->InitBlockAllocation(
+            pBlock,
+            offset,
+            alignment,
+            size,
+            m_MemoryTypeIndex,
+            suballocType,
+            mapped,
+            (createInfo.flags & VMA_ALLOCATION_CREATE_CAN_BECOME_LOST_BIT) != 0);
+        alloc->SetUserData(m_hAllocator, createInfo.pUserData);
+        if(clear)
+        {
+            memset((char*)pBlockData + offset, 0, (size_t)size);
+        }
+        else if(VMA_DEBUG_INITIALIZE_ALLOCATIONS)
+        {
+            m_hAllocator->FillAllocation(alloc, VMA_ALLOCATION_FILL_PATTERN_CREATED);
+        }
+        if(IsCorruptionDetectionEnabled())
+        {
+            VkResult res = pBlock->WriteMagicValueAroundAllocation(m_hAllocator, offset, size);
+            VMA_ASSERT(res == VK_SUCCESS && "Couldn't map block memory to write magic value.");
+        }
+    }
+    VMA_HEAVY_ASSERT(pBlock->Validate());
+    m_hAllocator->m_Budget.AddAllocation(m_hAllocator->MemoryTypeIndexToHeapIndex(m_MemoryTypeIndex), size * allocationCount);
+    if(clear)
+    {
+        m_hAllocator->FlushOrInvalidateAllocations((uint32_t)allocationCount, pAllocations, VMA_NULL, VMA_NULL, VMA_CACHE_FLUSH);
+        pBlock->Unmap(m_hAllocator, 1);
+    }
+    return VK_SUCCESS;
+}
 
-                    VmaSuballocation suballoc = *srcSuballocIt;
-                    suballoc.offset = dstAllocOffset;
-                    suballoc.hAllocation->ChangeOffset(dstAllocOffset);
-                    m_BytesMoved += srcAllocSize;
-                    ++m_AllocationsMoved;
+VkResult VmaBlockVector::AllocatePagesFromBlock(
+    VmaDeviceMemoryBlock* pBlock,
+    uint32_t currentFrameIndex,
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    const VmaAllocationCreateInfo& createInfo,
+    VmaSuballocationType suballocType,
+    uint32_t strategy,
+    size_t allocationCount,
+    VmaAllocation* pAllocations)
+{
+    size_t allocIndex = 0;
+    VkResult res = VK_SUCCESS;
+    for(; allocIndex < allocationCount; ++allocIndex)
+    {
+        res = AllocateFromBlock(
+            pBlock,
+            currentFrameIndex,
+            size,
+            alignment,
+            createInfo.flags,
+            createInfo.pUserData,
+            createInfo.lifetime,
+            suballocType,
+            strategy,
+            pAllocations + allocIndex);
+        if(res != VK_SUCCESS)
+        {
+            break;
+        }
+    }
+    if(res == VK_SUCCESS)
+    {
+        return VK_SUCCESS;
+    }
 
-                    VmaSuballocationList::iterator nextSuballocIt = srcSuballocIt;
-                    ++nextSuballocIt;
-                    pSrcMetadata->m_Suballocations.erase(srcSuballocIt);
-                    srcSuballocIt = nextSuballocIt;
+    // Roll back. Mutex is already locked, so Free() can't be used. The block is never deleted here.
+    const uint32_t heapIndex = m_hAllocator->MemoryTypeIndexToHeapIndex(m_MemoryTypeIndex);
+    while(allocIndex--)
+    {
+        const VmaAllocation alloc = pAllocations[allocIndex];
+        if(alloc->IsPersistentMap())
+        {
+            pBlock->Unmap(m_hAllocator, 1);
+        }
+        pBlock->m_pMetadata->Free(alloc);
+        m_hAllocator->m_Budget.RemoveAllocation(heapIndex, alloc->GetSize());
+        alloc->SetUserData(m_hAllocator, VMA_NULL);
+        m_hAllocator->m_AllocationObjectAllocator.Free(alloc);
+        pAllocations[allocIndex] = VK_NULL_HANDLE;
+    }
+    VMA_HEAVY_ASSERT(pBlock->Validate());
+    UpdateHasEmptyBlock();
+    return res;
+}
 
-                    InsertSuballoc(pFreeSpaceMetadata, suballoc);
+VkResult VmaBlockVector::CreateBlock(VkDeviceSize blockSize, size_t* pNewBlockIndex)
+{
+    VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    allocInfo.memoryTypeIndex = m_MemoryTypeIndex;
+    allocInfo.allocationSize = blockSize;
 
-                    move.srcBlockIndex = srcOrigBlockIndex;
-                    move.dstBlockIndex = freeSpaceOrigBlockIndex;
-                    move.srcOffset = srcAllocOffset;
-                    move.dstOffset = dstAllocOffset;
-                    move.size = srcAllocSize;
+#if VMA_BUFFER_DEVICE_ADDRESS
+    // Every standalone block can potentially contain a buffer with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT - always enable the feature.
+    VkMemoryAllocateFlagsInfoKHR allocFlagsInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO_KHR };
+    if(m_hAllocator->m_UseKhrBufferDeviceAddress)
+    {
+        allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR;
+        VmaPnextChainPushFront(&allocInfo, &allocFlagsInfo);
+    }
+#endif // #if VMA_BUFFER_DEVICE_ADDRESS
 
-                    moves.push_back(move);
-                }
-                // Different block
-                else
-                {
-                    // MOVE OPTION 2: Move the allocation to a different block.
+#if VMA_EXTERNAL_MEMORY_HOST
+    VkImportMemoryHostPointerInfoEXT importInfo = { VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT };
+    if(m_pHostPointer != VMA_NULL)
+    {
+        VMA_ASSERT(m_Blocks.empty() && blockSize == m_PreferredBlockSize);
+        importInfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+        importInfo.pHostPointer = m_pHostPointer;
+        VmaPnextChainPushFront(&allocInfo, &importInfo);
+    }
+#endif // #if VMA_EXTERNAL_MEMORY_HOST
 
-                    VMA_ASSERT(freeSpaceInfoIndex < srcBlockInfoIndex);
+#if VMA_EXTERNAL_MEMORY
+    VkExportMemoryAllocateInfoKHR exportInfo = { VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO_KHR };
+    if(m_ExportHandleTypes != 0)
+    {
+        exportInfo.handleTypes = m_ExportHandleTypes;
+        VmaPnextChainPushFront(&allocInfo, &exportInfo);
+    }
+#endif // #if VMA_EXTERNAL_MEMORY
 
-                    VmaSuballocation suballoc = *srcSuballocIt;
-                    suballoc.offset = dstAllocOffset;
-                    suballoc.hAllocation->ChangeBlockAllocation(m_hAllocator, pFreeSpaceBlock, dstAllocOffset);
-                    m_BytesMoved += srcAllocSize;
-                    ++m_AllocationsMoved;
+#if VMA_MEMORY_PRIORITY
+    VkMemoryPriorityAllocateInfoEXT priorityInfo = { VK_STRUCTURE_TYPE_MEMORY_PRIORITY_ALLOCATE_INFO_EXT };
+    if(m_hAllocator->m_UseExtMemoryPriority)
+    {
+        priorityInfo.priority = m_Priority;
+        VmaPnextChainPushFront(&allocInfo, &priorityInfo);
+    }
+#endif // #if VMA_MEMORY_PRIORITY
 
-                    VmaSuballocationList::iterator nextSuballocIt = srcSuballocIt;
-                    ++nextSuballocIt;
-                    pSrcMetadata->m_Suballocations.erase(srcSuballocIt);
-                    srcSuballocIt = nextSuballocIt;
+    const VmaQuota quota = m_hParentPool != VK_NULL_HANDLE ? m_hParentPool->GetQuota() : VK_NULL_HANDLE;
+    if(quota != VK_NULL_HANDLE && !quota->TryCharge(blockSize))
+    {
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
 
-                    InsertSuballoc(pFreeSpaceMetadata, suballoc);
+    VkDeviceMemory mem = VK_NULL_HANDLE;
+    VkResult res = m_hAllocator->AllocateVulkanMemory(&allocInfo, &mem);
+    if(res < 0)
+    {
+        if(quota != VK_NULL_HANDLE)
+        {
+            quota->Release(blockSize);
+        }
+        return res;
+    }
 
-                    move.srcBlockIndex = srcOrigBlockIndex;
-                    move.dstBlockIndex = freeSpaceOrigBlockIndex;
-                    move.srcOffset = srcAllocOffset;
-                    move.dstOffset = dstAllocOffset;
-                    move.size = srcAllocSize;
+    // New VkDeviceMemory successfully created.
 
-                    moves.push_back(move);
-                }
-            }
-            else
-            {
-                dstAllocOffset = VmaAlignUp(dstOffset, srcAllocAlignment);
+    // Create new Allocation for it.
+    VmaDeviceMemoryBlock* const pBlock = vma_new(m_hAllocator, VmaDeviceMemoryBlock)(m_hAllocator);
+    pBlock->Init(
+        m_hAllocator,
+        m_hParentPool,
+        m_MemoryTypeIndex,
+        mem,
+        allocInfo.allocationSize,
+        m_NextBlockId++,
+        m_Algorithm,
+        m_Priority);
 
-                // If the allocation doesn't fit before the end of dstBlock, forward to next block.
-                while(dstBlockInfoIndex < srcBlockInfoIndex &&
-                    dstAllocOffset + srcAllocSize > dstBlockSize)
-                {
-                    // But before that, register remaining free space at the end of dst block.
-                    freeSpaceDb.Register(dstBlockInfoIndex, dstOffset, dstBlockSize - dstOffset);
+    m_Blocks.push_back(pBlock);
+    if(pNewBlockIndex != VMA_NULL)
+    {
+        *pNewBlockIndex = m_Blocks.size() - 1;
+    }
 
-                    ++dstBlockInfoIndex;
-                    dstOrigBlockIndex = m_BlockInfos[dstBlockInfoIndex].origBlockIndex;
-                    pDstBlock = m_pBlockVector->GetBlock(dstOrigBlockIndex);
-                    pDstMetadata = (VmaBlockMetadata_Generic*)pDstBlock->m_pMetadata;
-                    dstBlockSize = pDstMetadata->GetSize();
-                    dstOffset = 0;
-                    dstAllocOffset = 0;
-                }
+    return VK_SUCCESS;
+}
 
-                // Same block
-                if(dstBlockInfoIndex == srcBlockInfoIndex)
-                {
-                    VMA_ASSERT(dstAllocOffset <= srcAllocOffset);
+void VmaBlockVector::ApplyDefragmentationMovesCpu(
+    class VmaBlockVectorDefragmentationContext* pDefragCtx,
+    const VmaVector< VmaDefragmentationMove, VmaStlAllocator<VmaDefragmentationMove> >& moves)
+{
+    const size_t blockCount = m_Blocks.size();
+    const bool isNonCoherent = m_hAllocator->IsMemoryTypeNonCoherent(m_MemoryTypeIndex);
 
-                    const bool overlap = dstAllocOffset + srcAllocSize > srcAllocOffset;
+    enum BLOCK_FLAG
+    {
+        BLOCK_FLAG_USED = 0x00000001,
+        BLOCK_FLAG_MAPPED_FOR_DEFRAGMENTATION = 0x00000002,
+    };
 
-                    bool skipOver = overlap;
-                    if(overlap && m_OverlappingMoveSupported && dstAllocOffset < srcAllocOffset)
-                    {
-                        // If destination and source place overlap, skip if it would move it
-                        // by only < 1/64 of its size.
-                        skipOver = (srcAllocOffset - dstAllocOffset) * 64 < srcAllocSize;
-                    }
-
-                    if(skipOver)
-                    {
-                        freeSpaceDb.Register(dstBlockInfoIndex, dstOffset, srcAllocOffset - dstOffset);
+    struct BlockInfo
+    {
+        uint32_t flags;
+        void* pMappedData;
+    };
+    VmaVector< BlockInfo, VmaStlAllocator<BlockInfo> >
+        blockInfo(blockCount, BlockInfo(), VmaStlAllocator<BlockInfo>(m_hAllocator->GetAllocationCallbacks()));
+    memset(blockInfo.data(), 0, blockCount * sizeof(BlockInfo));
 
-                        dstOffset = srcAllocOffset + srcAllocSize;
-                        ++srcSuballocIt;
-                    }
-                    // MOVE OPTION 1: Move the allocation inside the same block by decreasing offset.
-                    else
-                    {
-                        srcSuballocIt->offset = dstAllocOffset;
-                        srcSuballocIt->hAllocation->ChangeOffset(dstAllocOffset);
-                        dstOffset = dstAllocOffset + srcAllocSize;
-                        m_BytesMoved += srcAllocSize;
-                        ++m_AllocationsMoved;
-                        ++srcSuballocIt;
+    // Go over all moves. Mark blocks that are used with BLOCK_FLAG_USED.
+    const size_t moveCount = moves.size();
+    for(size_t moveIndex = 0; moveIndex < moveCount; ++moveIndex)
+    {
+        const VmaDefragmentationMove& move = moves[moveIndex];
+        blockInfo[move.srcBlockIndex].flags |= BLOCK_FLAG_USED;
+        blockInfo[move.dstBlockIndex].flags |= BLOCK_FLAG_USED;
+    }
 
-                        move.srcBlockIndex = srcOrigBlockIndex;
-                        move.dstBlockIndex = dstOrigBlockIndex;
-                        move.srcOffset = srcAllocOffset;
-                        move.dstOffset = dstAllocOffset;
-                        move.size = srcAllocSize;
+    VMA_ASSERT(pDefragCtx->res == VK_SUCCESS);
 
-                        moves.push_back(move);
-                    }
-                }
-                // Different block
-                else
+    // Go over all blocks. Get mapped pointer or map if necessary.
+    for(size_t blockIndex = 0; pDefragCtx->res == VK_SUCCESS && blockIndex < blockCount; ++blockIndex)
+    {
+        BlockInfo& currBlockInfo = blockInfo[blockIndex];
+        VmaDeviceMemoryBlock* pBlock = m_Blocks[blockIndex];
+        if((currBlockInfo.flags & BLOCK_FLAG_USED) != 0)
+        {
+            currBlockInfo.pMappedData = pBlock->GetMappedData();
+            // It is not originally mapped - map it.
+            if(currBlockInfo.pMappedData == VMA_NULL)
+            {
+                pDefragCtx->res = pBlock->Map(m_hAllocator, 1, &currBlockInfo.pMappedData);
+                if(pDefragCtx->res == VK_SUCCESS)
                 {
-                    // MOVE OPTION 2: Move the allocation to a different block.
+                    currBlockInfo.flags |= BLOCK_FLAG_MAPPED_FOR_DEFRAGMENTATION;
+                }
+            }
+        }
+    }
 
-                    VMA_ASSERT(dstBlockInfoIndex < srcBlockInfoIndex);
-                    VMA_ASSERT(dstAllocOffset + srcAllocSize <= dstBlockSize);
+    // Go over all moves. Do actual data transfer.
+    if(pDefragCtx->res == VK_SUCCESS)
+    {
+        const VkDeviceSize nonCoherentAtomSize = m_hAllocator->m_PhysicalDeviceProperties.limits.nonCoherentAtomSize;
+        VkMappedMemoryRange memRange = { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
 
-                    VmaSuballocation suballoc = *srcSuballocIt;
-                    suballoc.offset = dstAllocOffset;
-                    suballoc.hAllocation->ChangeBlockAllocation(m_hAllocator, pDstBlock, dstAllocOffset);
-                    dstOffset = dstAllocOffset + srcAllocSize;
-                    m_BytesMoved += srcAllocSize;
-                    ++m_AllocationsMoved;
+        for(size_t moveIndex = 0; moveIndex < moveCount; ++moveIndex)
+        {
+            const VmaDefragmentationMove& move = moves[moveIndex];
 
-                    VmaSuballocationList::iterator nextSuballocIt = srcSuballocIt;
-                    ++nextSuballocIt;
-                    pSrcMetadata->m_Suballocations.erase(srcSuballocIt);
-                    srcSuballocIt = nextSuballocIt;
+            const BlockInfo& srcBlockInfo = blockInfo[move.srcBlockIndex];
+            const BlockInfo& dstBlockInfo = blockInfo[move.dstBlockIndex];
 
-                    pDstMetadata->m_Suballocations.push_back(suballoc);
+            VMA_ASSERT(srcBlockInfo.pMappedData && dstBlockInfo.pMappedData);
 
-                    move.srcBlockIndex = srcOrigBlockIndex;
-                    move.dstBlockIndex = dstOrigBlockIndex;
-                    move.srcOffset = srcAllocOffset;
-                    move.dstOffset = dstAllocOffset;
-                    move.size = srcAllocSize;
+            // Invalidate source.
+            if(isNonCoherent)
+            {
+                VmaDeviceMemoryBlock* const pSrcBlock = m_Blocks[move.srcBlockIndex];
+                memRange.memory = pSrcBlock->GetDeviceMemory();
+                memRange.offset = VmaAlignDown(move.srcOffset, nonCoherentAtomSize);
+                memRange.size = VMA_MIN(
+                    VmaAlignUp(move.size + (move.srcOffset - memRange.offset), nonCoherentAtomSize),
+                    pSrcBlock->m_pMetadata->GetSize() - memRange.offset);
+                (*m_hAllocator->GetVulkanFunctions().vkInvalidateMappedMemoryRanges)(m_hAllocator->m_hDevice, 1, &memRange);
+            }
 
-                    moves.push_back(move);
+            // THE PLACE WHERE ACTUAL DATA COPY HAPPENS.
+            memmove(
+                reinterpret_cast<char*>(dstBlockInfo.pMappedData) + move.dstOffset,
+                reinterpret_cast<char*>(srcBlockInfo.pMappedData) + move.srcOffset,
+                static_cast<size_t>(move.size));
+
+            if(IsCorruptionDetectionEnabled())
+            {
+                VmaWriteMagicValue(dstBlockInfo.pMappedData, move.dstOffset - VMA_DEBUG_MARGIN);
+                VmaWriteMagicValue(dstBlockInfo.pMappedData, move.dstOffset + move.size);
+            }
+
+            // Flush destination.
+            if(isNonCoherent)
+            {
+                VmaDeviceMemoryBlock* const pDstBlock = m_Blocks[move.dstBlockIndex];
+                memRange.memory = pDstBlock->GetDeviceMemory();
+                memRange.offset = VmaAlignDown(move.dstOffset, nonCoherentAtomSize);
+                memRange.size = VMA_MIN(
+                    VmaAlignUp(move.size + (move.dstOffset - memRange.offset), nonCoherentAtomSize),
+                    pDstBlock->m_pMetadata->GetSize() - memRange.offset);
+                (*m_hAllocator->GetVulkanFunctions().vkFlushMappedMemoryRanges)(m_hAllocator->m_hDevice, 1, &memRange);
+            }
+        }
+    }
+
+    // Go over all blocks in reverse order. Unmap those that were mapped just for defragmentation.
+    // Regardless of pCtx->res == VK_SUCCESS.
+    for(size_t blockIndex = blockCount; blockIndex--; )
+    {
+        const BlockInfo& currBlockInfo = blockInfo[blockIndex];
+        if((currBlockInfo.flags & BLOCK_FLAG_MAPPED_FOR_DEFRAGMENTATION) != 0)
+        {
+            VmaDeviceMemoryBlock* pBlock = m_Blocks[blockIndex];
+            pBlock->Unmap(m_hAllocator, 1);
+        }
+    }
+}
+
+void VmaBlockVector::ApplyDefragmentationMovesGpu(
+    class VmaBlockVectorDefragmentationContext* pDefragCtx,
+    VmaVector< VmaDefragmentationMove, VmaStlAllocator<VmaDefragmentationMove> >& moves,
+    VkCommandBuffer commandBuffer)
+{
+    const size_t blockCount = m_Blocks.size();
+
+    pDefragCtx->blockContexts.resize(blockCount);
+    memset(pDefragCtx->blockContexts.data(), 0, blockCount * sizeof(VmaBlockDefragmentationContext));
+
+    // Go over all moves. Mark blocks that are used with BLOCK_FLAG_USED.
+    const size_t moveCount = moves.size();
+    for(size_t moveIndex = 0; moveIndex < moveCount; ++moveIndex)
+    {
+        const VmaDefragmentationMove& move = moves[moveIndex];
+
+        //if(move.type == VMA_ALLOCATION_TYPE_UNKNOWN)
+        {
+            // Old school move still require us to map the whole block
+            pDefragCtx->blockContexts[move.srcBlockIndex].flags |= VmaBlockDefragmentationContext::BLOCK_FLAG_USED;
+            pDefragCtx->blockContexts[move.dstBlockIndex].flags |= VmaBlockDefragmentationContext::BLOCK_FLAG_USED;
+        }
+    }
+
+    VMA_ASSERT(pDefragCtx->res == VK_SUCCESS);
+
+    // Go over all blocks. Create and bind buffer for whole block if necessary.
+    {
+        VkBufferCreateInfo bufCreateInfo;
+        VmaFillGpuDefragmentationBufferCreateInfo(bufCreateInfo);
+
+        for(size_t blockIndex = 0; pDefragCtx->res == VK_SUCCESS && blockIndex < blockCount; ++blockIndex)
+        {
+            VmaBlockDefragmentationContext& currBlockCtx = pDefragCtx->blockContexts[blockIndex];
+            VmaDeviceMemoryBlock* pBlock = m_Blocks[blockIndex];
+            if((currBlockCtx.flags & VmaBlockDefragmentationContext::BLOCK_FLAG_USED) != 0)
+            {
+                bufCreateInfo.size = pBlock->m_pMetadata->GetSize();
+                pDefragCtx->res = (*m_hAllocator->GetVulkanFunctions().vkCreateBuffer)(
+                    m_hAllocator->m_hDevice, &bufCreateInfo, m_hAllocator->GetAllocationCallbacks(), &currBlockCtx.hBuffer);
+                if(pDefragCtx->res == VK_SUCCESS)
+                {
+                    pDefragCtx->res = (*m_hAllocator->GetVulkanFunctions().vkBindBufferMemory)(
+                        m_hAllocator->m_hDevice, currBlockCtx.hBuffer, pBlock->GetDeviceMemory(), 0);
                 }
             }
         }
     }
 
-    m_BlockInfos.clear();
+    // Go over all moves. Post data transfer commands to command buffer.
+    if(pDefragCtx->res == VK_SUCCESS)
+    {
+        for(size_t moveIndex = 0; moveIndex < moveCount; ++moveIndex)
+        {
+            const VmaDefragmentationMove& move = moves[moveIndex];
 
-    PostprocessMetadata();
+            const VmaBlockDefragmentationContext& srcBlockCtx = pDefragCtx->blockContexts[move.srcBlockIndex];
+            const VmaBlockDefragmentationContext& dstBlockCtx = pDefragCtx->blockContexts[move.dstBlockIndex];
 
-    return VK_SUCCESS;
+            VMA_ASSERT(srcBlockCtx.hBuffer && dstBlockCtx.hBuffer);
+
+            VkBufferCopy region = {
+                move.srcOffset,
+                move.dstOffset,
+                move.size };
+            (*m_hAllocator->GetVulkanFunctions().vkCmdCopyBuffer)(
+                commandBuffer, srcBlockCtx.hBuffer, dstBlockCtx.hBuffer, 1, &region);
+        }
+    }
+
+    // Save buffers to defrag context for later destruction.
+    if(pDefragCtx->res == VK_SUCCESS && moveCount > 0)
+    {
+        pDefragCtx->res = VK_NOT_READY;
+    }
 }
 
-void VmaDefragmentationAlgorithm_Fast::PreprocessMetadata()
+void VmaBlockVector::FreeEmptyBlocks(VmaDefragmentationStats* pDefragmentationStats)
 {
-    const size_t blockCount = m_pBlockVector->GetBlockCount();
-    for(size_t blockIndex = 0; blockIndex < blockCount; ++blockIndex)
+    for(size_t blockIndex = m_Blocks.size(); blockIndex--; )
     {
-        VmaBlockMetadata_Generic* const pMetadata =
-            (VmaBlockMetadata_Generic*)m_pBlockVector->GetBlock(blockIndex)->m_pMetadata;
-        pMetadata->m_FreeCount = 0;
-        pMetadata->m_SumFreeSize = pMetadata->GetSize();
-        pMetadata->m_FreeSuballocationsBySize.clear();
-        for(VmaSuballocationList::iterator it = pMetadata->m_Suballocations.begin();
-            it != pMetadata->m_Suballocations.end(); )
+        VmaDeviceMemoryBlock* pBlock = m_Blocks[blockIndex];
+        if(pBlock->m_pMetadata->IsEmpty())
         {
-            if(it->type == VMA_SUBALLOCATION_TYPE_FREE)
+            if(m_Blocks.size() > m_MinBlockCount)
             {
-                VmaSuballocationList::iterator nextIt = it;
-                ++nextIt;
-                pMetadata->m_Suballocations.erase(it);
-                it = nextIt;
+                if(pDefragmentationStats != VMA_NULL)
+                {
+                    ++pDefragmentationStats->deviceMemoryBlocksFreed;
+                    pDefragmentationStats->bytesFreed += pBlock->m_pMetadata->GetSize();
+                }
+
+                VmaVectorRemove(m_Blocks, blockIndex);
+                pBlock->Destroy(m_hAllocator);
+                vma_delete(m_hAllocator, pBlock);
             }
             else
             {
-                ++it;
+                break;
             }
         }
     }
+    UpdateHasEmptyBlock();
 }
 
-void VmaDefragmentationAlgorithm_Fast::PostprocessMetadata()
+void VmaBlockVector::UpdateHasEmptyBlock()
 {
-    const size_t blockCount = m_pBlockVector->GetBlockCount();
-    for(size_t blockIndex = 0; blockIndex < blockCount; ++blockIndex)
+    m_HasEmptyBlock = false;
+    for(size_t index = 0, count = m_Blocks.size(); index < count; ++index)
     {
-        VmaBlockMetadata_Generic* const pMetadata =
-            (VmaBlockMetadata_Generic*)m_pBlockVector->GetBlock(blockIndex)->m_pMetadata;
-        const VkDeviceSize blockSize = pMetadata->GetSize();
-
-        // No allocations in this block - entire area is free.
-        if(pMetadata->m_Suballocations.empty())
-        {
-            pMetadata->m_FreeCount = 1;
-            //pMetadata->m_SumFreeSize is already set to blockSize.
-            VmaSuballocation suballoc = {
-                0, // offset
-                blockSize, // size
-                VMA_NULL, // hAllocation
-                VMA_SUBALLOCATION_TYPE_FREE };
-            pMetadata->m_Suballocations.push_back(suballoc);
-            pMetadata->RegisterFreeSuballocation(pMetadata->m_Suballocations.begin());
-        }
-        // There are some allocations in this block.
-        else
+        VmaDeviceMemoryBlock* const pBlock = m_Blocks[index];
+        if(pBlock->m_pMetadata->IsEmpty())
         {
-            VkDeviceSize offset = 0;
-            VmaSuballocationList::iterator it;
-            for(it = pMetadata->m_Suballocations.begin();
-                it != pMetadata->m_Suballocations.end();
-                ++it)
-            {
-                VMA_ASSERT(it->type != VMA_SUBALLOCATION_TYPE_FREE);
-                VMA_ASSERT(it->offset >= offset);
-
-                // Need to insert preceding free space.
-                if(it->offset > offset)
-                {
-                    ++pMetadata->m_FreeCount;
-                    const VkDeviceSize freeSize = it->offset - offset;
-                    VmaSuballocation suballoc = {
-                        offset, // offset
-                        freeSize, // size
-                        VMA_NULL, // hAllocation
-                        VMA_SUBALLOCATION_TYPE_FREE };
-                    VmaSuballocationList::iterator precedingFreeIt = pMetadata->m_Suballocations.insert(it, suballoc);
-                    if(freeSize >= VMA_MIN_FREE_SUBALLOCATION_SIZE_TO_REGISTER)
-                    {
-                        pMetadata->m_FreeSuballocationsBySize.push_back(precedingFreeIt);
-                    }
-                }
-
-                pMetadata->m_SumFreeSize -= it->size;
-                offset = it->offset + it->size;
-            }
-
-            // Need to insert trailing free space.
-            if(offset < blockSize)
-            {
-                ++pMetadata->m_FreeCount;
-                const VkDeviceSize freeSize = blockSize - offset;
-                VmaSuballocation suballoc = {
-                    offset, // offset
-                    freeSize, // size
-                    VMA_NULL, // hAllocation
-                    VMA_SUBALLOCATION_TYPE_FREE };
-                VMA_ASSERT(it == pMetadata->m_Suballocations.end());
-                VmaSuballocationList::iterator trailingFreeIt = pMetadata->m_Suballocations.insert(it, suballoc);
-                if(freeSize > VMA_MIN_FREE_SUBALLOCATION_SIZE_TO_REGISTER)
-                {
-                    pMetadata->m_FreeSuballocationsBySize.push_back(trailingFreeIt);
-                }
-            }
-
-            VMA_SORT(
-                pMetadata->m_FreeSuballocationsBySize.begin(),
-                pMetadata->m_FreeSuballocationsBySize.end(),
-                VmaSuballocationItemSizeLess());
+            m_HasEmptyBlock = true;
+            break;
         }
-
-        VMA_HEAVY_ASSERT(pMetadata->Validate());
     }
 }
 
-void VmaDefragmentationAlgorithm_Fast::InsertSuballoc(VmaBlockMetadata_Generic* pMetadata, const VmaSuballocation& suballoc)
+#if VMA_STATS_STRING_ENABLED
+
+void VmaBlockVector::PrintDetailedMap(class VmaJsonWriter& json)
 {
-    // TODO: Optimize somehow. Remember iterator instead of searching for it linearly.
-    VmaSuballocationList::iterator it = pMetadata->m_Suballocations.begin();
-    while(it != pMetadata->m_Suballocations.end())
+    VmaMutexLockRead lock(m_Mutex, m_hAllocator->m_UseMutex);
+
+    json.BeginObject();
+
+    if(IsCustomPool())
     {
-        if(it->offset < suballoc.offset)
+        const char* poolName = m_hParentPool->GetName();
+        if(poolName != VMA_NULL && poolName[0] != '\0')
         {
-            ++it;
+            json.WriteString("Name");
+            json.WriteString(poolName);
         }
-    }
-    pMetadata->m_Suballocations.insert(it, suballoc);
-}
-
-////////////////////////////////////////////////////////////////////////////////
-// VmaBlockVectorDefragmentationContext
-
-VmaBlockVectorDefragmentationContext::VmaBlockVectorDefragmentationContext(
-    VmaAllocator hAllocator,
-    VmaPool hCustomPool,
-    VmaBlockVector* pBlockVector,
-    uint32_t currFrameIndex) :
-    res(VK_SUCCESS),
-    mutexLocked(false),
-    blockContexts(VmaStlAllocator<VmaBlockDefragmentationContext>(hAllocator->GetAllocationCallbacks())),
-    defragmentationMoves(VmaStlAllocator<VmaDefragmentationMove>(hAllocator->GetAllocationCallbacks())),
-    defragmentationMovesProcessed(0),
-    defragmentationMovesCommitted(0),
-    hasDefragmentationPlan(0),
-    m_hAllocator(hAllocator),
-    m_hCustomPool(hCustomPool),
-    m_pBlockVector(pBlockVector),
-    m_CurrFrameIndex(currFrameIndex),
-    m_pAlgorithm(VMA_NULL),
-    m_Allocations(VmaStlAllocator<AllocInfo>(hAllocator->GetAllocationCallbacks())),
-    m_AllAllocations(false)
-{
-}
 
-VmaBlockVectorDefragmentationContext::~VmaBlockVectorDefragmentationContext()
-{
-    vma_delete(m_hAllocator, m_pAlgorithm);
-}
+        json.WriteString("MemoryTypeIndex");
+        json.WriteNumber(m_MemoryTypeIndex);
 
-void VmaBlockVectorDefragmentationContext::AddAllocation(VmaAllocation hAlloc, VkBool32* pChanged)
-{
-    AllocInfo info = { hAlloc, pChanged };
-    m_Allocations.push_back(info);
-}
+        json.WriteString("BlockSize");
+        json.WriteNumber(m_PreferredBlockSize);
 
-void VmaBlockVectorDefragmentationContext::Begin(bool overlappingMoveSupported, VmaDefragmentationFlags flags)
-{
-    const bool allAllocations = m_AllAllocations ||
-        m_Allocations.size() == m_pBlockVector->CalcAllocationCount();
+        json.WriteString("BlockCount");
+        json.BeginObject(true);
+        if(m_MinBlockCount > 0)
+        {
+            json.WriteString("Min");
+            json.WriteNumber((uint64_t)m_MinBlockCount);
+        }
+        if(m_MaxBlockCount < SIZE_MAX)
+        {
+            json.WriteString("Max");
+            json.WriteNumber((uint64_t)m_MaxBlockCount);
+        }
+        json.WriteString("Cur");
+        json.WriteNumber((uint64_t)m_Blocks.size());
+        json.EndObject();
 
-    /********************************
-    HERE IS THE CHOICE OF DEFRAGMENTATION ALGORITHM.
-    ********************************/
+        if(m_FrameInUseCount > 0)
+        {
+            json.WriteString("FrameInUseCount");
+            json.WriteNumber(m_FrameInUseCount);
+        }
 
-    /*
-    Fast algorithm is supported only when certain criteria are met:
-    - VMA_DEBUG_MARGIN is 0.
-    - All allocations in this block vector are moveable.
-    - There is no possibility of image/buffer granularity conflict.
-    - The defragmentation is not incremental
-    */
-    if(VMA_DEBUG_MARGIN == 0 &&
-        allAllocations &&
-        !m_pBlockVector->IsBufferImageGranularityConflictPossible() &&
-        !(flags & VMA_DEFRAGMENTATION_FLAG_INCREMENTAL))
-    {
-        m_pAlgorithm = vma_new(m_hAllocator, VmaDefragmentationAlgorithm_Fast)(
-            m_hAllocator, m_pBlockVector, m_CurrFrameIndex, overlappingMoveSupported);
+        if(m_Algorithm != 0)
+        {
+            json.WriteString("Algorithm");
+            json.WriteString(VmaAlgorithmToStr(m_Algorithm));
+        }
     }
     else
     {
-        m_pAlgorithm = vma_new(m_hAllocator, VmaDefragmentationAlgorithm_Generic)(
-            m_hAllocator, m_pBlockVector, m_CurrFrameIndex, overlappingMoveSupported);
+        json.WriteString("PreferredBlockSize");
+        json.WriteNumber(m_PreferredBlockSize);
     }
 
-    if(allAllocations)
-    {
-        m_pAlgorithm->AddAll();
-    }
-    else
+    json.WriteString("Blocks");
+    json.BeginObject();
+    for(size_t i = 0; i < m_Blocks.size(); ++i)
     {
-        for(size_t i = 0, count = m_Allocations.size(); i < count; ++i)
-        {
-            m_pAlgorithm->AddAllocation(m_Allocations[i].hAlloc, m_Allocations[i].pChanged);
-        }
+        json.BeginString();
+        json.ContinueString(m_Blocks[i]->GetId());
+        json.EndString();
+
+        m_Blocks[i]->m_pMetadata->PrintDetailedMap(json);
     }
+    json.EndObject();
+
+    json.EndObject();
 }
 
-////////////////////////////////////////////////////////////////////////////////
-// VmaDefragmentationContext
+#endif // #if VMA_STATS_STRING_ENABLED
 
-VmaDefragmentationContext_T::VmaDefragmentationContext_T(
-    VmaAllocator hAllocator,
-    uint32_t currFrameIndex,
-    uint32_t flags,
-    VmaDefragmentationStats* pStats) :
-    m_hAllocator(hAllocator),
-    m_CurrFrameIndex(currFrameIndex),
-    m_Flags(flags),
-    m_pStats(pStats),
-    m_CustomPoolContexts(VmaStlAllocator<VmaBlockVectorDefragmentationContext*>(hAllocator->GetAllocationCallbacks()))
+void VmaBlockVector::Defragment(
+    class VmaBlockVectorDefragmentationContext* pCtx,
+    VmaDefragmentationStats* pStats, VmaDefragmentationFlags flags,
+    VkDeviceSize& maxCpuBytesToMove, uint32_t& maxCpuAllocationsToMove,
+    VkDeviceSize& maxGpuBytesToMove, uint32_t& maxGpuAllocationsToMove,
+    VkCommandBuffer commandBuffer)
 {
-    memset(m_DefaultPoolContexts, 0, sizeof(m_DefaultPoolContexts));
-}
+    pCtx->res = VK_SUCCESS;
 
-VmaDefragmentationContext_T::~VmaDefragmentationContext_T()
-{
-    for(size_t i = m_CustomPoolContexts.size(); i--; )
-    {
-        VmaBlockVectorDefragmentationContext* pBlockVectorCtx = m_CustomPoolContexts[i];
-        pBlockVectorCtx->GetBlockVector()->DefragmentationEnd(pBlockVectorCtx, m_Flags, m_pStats);
-        vma_delete(m_hAllocator, pBlockVectorCtx);
-    }
-    for(size_t i = m_hAllocator->m_MemProps.memoryTypeCount; i--; )
+    const VkMemoryPropertyFlags memPropFlags =
+        m_hAllocator->m_MemProps.memoryTypes[m_MemoryTypeIndex].propertyFlags;
+    const bool isHostVisible = (memPropFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+
+    const bool canDefragmentOnCpu = maxCpuBytesToMove > 0 && maxCpuAllocationsToMove > 0 &&
+        isHostVisible;
+    const bool canDefragmentOnGpu = maxGpuBytesToMove > 0 && maxGpuAllocationsToMove > 0 &&
+        !IsCorruptionDetectionEnabled() &&
+        ((1u << m_MemoryTypeIndex) & m_hAllocator->GetGpuDefragmentationMemoryTypeBits()) != 0;
+
+    // There are options to defragment this memory type.
+    if(canDefragmentOnCpu || canDefragmentOnGpu)
     {
-        VmaBlockVectorDefragmentationContext* pBlockVectorCtx = m_DefaultPoolContexts[i];
-        if(pBlockVectorCtx)
+        bool defragmentOnGpu;
+        // There is only one option to defragment this memory type.
+        if(canDefragmentOnGpu != canDefragmentOnCpu)
         {
-            pBlockVectorCtx->GetBlockVector()->DefragmentationEnd(pBlockVectorCtx, m_Flags, m_pStats);
-            vma_delete(m_hAllocator, pBlockVectorCtx);
+            defragmentOnGpu = canDefragmentOnGpu;
         }
-    }
-}
-
-void VmaDefragmentationContext_T::AddPools(uint32_t poolCount, const VmaPool* pPools)
-{
-    for(uint32_t poolIndex = 0; poolIndex < poolCount; ++poolIndex)
-    {
-        VmaPool pool = pPools[poolIndex];
-        VMA_ASSERT(pool);
-        // Pools with algorithm other than default are not defragmented.
-        if(pool->m_BlockVector.GetAlgorithm() == 0)
+        // Both options are available: Heuristics to choose the best one.
+        else
         {
-            VmaBlockVectorDefragmentationContext* pBlockVectorDefragCtx = VMA_NULL;
+            defragmentOnGpu = (memPropFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0 ||
+                m_hAllocator->IsIntegratedGpu();
+        }
 
-            for(size_t i = m_CustomPoolContexts.size(); i--; )
+        bool overlappingMoveSupported = !defragmentOnGpu;
+
+        if(m_hAllocator->m_UseMutex)
+        {
+            if(flags & VMA_DEFRAGMENTATION_FLAG_INCREMENTAL)
             {
-                if(m_CustomPoolContexts[i]->GetCustomPool() == pool)
+                if(!m_Mutex.TryLockWrite())
                 {
-                    pBlockVectorDefragCtx = m_CustomPoolContexts[i];
-                    break;
+                    pCtx->res = VK_ERROR_INITIALIZATION_FAILED;
+                    return;
                 }
             }
-
-            if(!pBlockVectorDefragCtx)
+            else
             {
-                pBlockVectorDefragCtx = vma_new(m_hAllocator, VmaBlockVectorDefragmentationContext)(
-                    m_hAllocator,
-                    pool,
-                    &pool->m_BlockVector,
-                    m_CurrFrameIndex);
-                m_CustomPoolContexts.push_back(pBlockVectorDefragCtx);
+                m_Mutex.LockWrite();
+                pCtx->mutexLocked = true;
             }
-
-            pBlockVectorDefragCtx->AddAll();
         }
-    }
-}
 
-void VmaDefragmentationContext_T::AddAllocations(
-    uint32_t allocationCount,
-    const VmaAllocation* pAllocations,
-    VkBool32* pAllocationsChanged)
-{
-    // Dispatch pAllocations among defragmentators. Create them when necessary.
-    for(uint32_t allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
-    {
-        const VmaAllocation hAlloc = pAllocations[allocIndex];
-        VMA_ASSERT(hAlloc);
-        // DedicatedAlloc cannot be defragmented.
-        if((hAlloc->GetType() == VmaAllocation_T::ALLOCATION_TYPE_BLOCK) &&
-            // Lost allocation cannot be defragmented.
-            (hAlloc->GetLastUseFrameIndex() != VMA_FRAME_INDEX_LOST))
-        {
-            VmaBlockVectorDefragmentationContext* pBlockVectorDefragCtx = VMA_NULL;
+        pCtx->Begin(overlappingMoveSupported, flags);
 
-            const VmaPool hAllocPool = hAlloc->GetBlock()->GetParentPool();
-            // This allocation belongs to custom pool.
-            if(hAllocPool != VK_NULL_HANDLE)
+        // Defragment.
+
+        const VkDeviceSize maxBytesToMove = defragmentOnGpu ? maxGpuBytesToMove : maxCpuBytesToMove;
+        const uint32_t maxAllocationsToMove = defragmentOnGpu ? maxGpuAllocationsToMove : maxCpuAllocationsToMove;
+        pCtx->res = pCtx->GetAlgorithm()->Defragment(pCtx->defragmentationMoves, maxBytesToMove, maxAllocationsToMove, flags);
+
+        // Accumulate statistics.
+        if(pStats != VMA_NULL)
+        {
+            const VkDeviceSize bytesMoved = pCtx->GetAlgorithm()->GetBytesMoved();
+            const uint32_t allocationsMoved = pCtx->GetAlgorithm()->GetAllocationsMoved();
+            pStats->bytesMoved += bytesMoved;
+            pStats->allocationsMoved += allocationsMoved;
+            VMA_ASSERT(bytesMoved <= maxBytesToMove);
+            VMA_ASSERT(allocationsMoved <= maxAllocationsToMove);
+            if(defragmentOnGpu)
             {
-                // Pools with algorithm other than default are not defragmented.
-                if(hAllocPool->m_BlockVector.GetAlgorithm() == 0)
-                {
-                    for(size_t i = m_CustomPoolContexts.size(); i--; )
-                    {
-                        if(m_CustomPoolContexts[i]->GetCustomPool() == hAllocPool)
-                        {
-                            pBlockVectorDefragCtx = m_CustomPoolContexts[i];
-                            break;
-                        }
-                    }
-                    if(!pBlockVectorDefragCtx)
-                    {
-                        pBlockVectorDefragCtx = vma_new(m_hAllocator, VmaBlockVectorDefragmentationContext)(
-                            m_hAllocator,
-                            hAllocPool,
-                            &hAllocPool->m_BlockVector,
-                            m_CurrFrameIndex);
-                        m_CustomPoolContexts.push_back(pBlockVectorDefragCtx);
-                    }
-                }
+                maxGpuBytesToMove -= bytesMoved;
+                maxGpuAllocationsToMove -= allocationsMoved;
             }
-            // This allocation belongs to default pool.
             else
             {
-                const uint32_t memTypeIndex = hAlloc->GetMemoryTypeIndex();
-                pBlockVectorDefragCtx = m_DefaultPoolContexts[memTypeIndex];
-                if(!pBlockVectorDefragCtx)
-                {
-                    pBlockVectorDefragCtx = vma_new(m_hAllocator, VmaBlockVectorDefragmentationContext)(
-                        m_hAllocator,
-                        VMA_NULL, // hCustomPool
-                        m_hAllocator->m_pBlockVectors[memTypeIndex],
-                        m_CurrFrameIndex);
-                    m_DefaultPoolContexts[memTypeIndex] = pBlockVectorDefragCtx;
-                }
+                maxCpuBytesToMove -= bytesMoved;
+                maxCpuAllocationsToMove -= allocationsMoved;
             }
+        }
 
-            if(pBlockVectorDefragCtx)
+        if(flags & VMA_DEFRAGMENTATION_FLAG_INCREMENTAL)
+        {
+            if(m_hAllocator->m_UseMutex)
+                m_Mutex.UnlockWrite();
+
+            if(pCtx->res >= VK_SUCCESS && !pCtx->defragmentationMoves.empty())
+                pCtx->res = VK_NOT_READY;
+
+            return;
+        }
+
+        if(pCtx->res >= VK_SUCCESS)
+        {
+            if(defragmentOnGpu)
             {
-                VkBool32* const pChanged = (pAllocationsChanged != VMA_NULL) ?
-                    &pAllocationsChanged[allocIndex] : VMA_NULL;
-                pBlockVectorDefragCtx->AddAllocation(hAlloc, pChanged);
+                ApplyDefragmentationMovesGpu(pCtx, pCtx->defragmentationMoves, commandBuffer);
+            }
+            else
+            {
+                ApplyDefragmentationMovesCpu(pCtx, pCtx->defragmentationMoves);
             }
         }
     }
 }
 
-VkResult VmaDefragmentationContext_T::Defragment(
-    VkDeviceSize maxCpuBytesToMove, uint32_t maxCpuAllocationsToMove,
-    VkDeviceSize maxGpuBytesToMove, uint32_t maxGpuAllocationsToMove,
-    VkCommandBuffer commandBuffer, VmaDefragmentationStats* pStats, VmaDefragmentationFlags flags)
+void VmaBlockVector::DefragmentationEnd(
+    class VmaBlockVectorDefragmentationContext* pCtx,
+    uint32_t flags,
+    VmaDefragmentationStats* pStats)
 {
-    if(pStats)
-    {
-        memset(pStats, 0, sizeof(VmaDefragmentationStats));
-    }
-
-    if(flags & VMA_DEFRAGMENTATION_FLAG_INCREMENTAL)
+    if(flags & VMA_DEFRAGMENTATION_FLAG_INCREMENTAL && m_hAllocator->m_UseMutex)
     {
-        // For incremental defragmetnations, we just earmark how much we can move
-        // The real meat is in the defragmentation steps
-        m_MaxCpuBytesToMove = maxCpuBytesToMove;
-        m_MaxCpuAllocationsToMove = maxCpuAllocationsToMove;
-
-        m_MaxGpuBytesToMove = maxGpuBytesToMove;
-        m_MaxGpuAllocationsToMove = maxGpuAllocationsToMove;
-
-        if(m_MaxCpuBytesToMove == 0 && m_MaxCpuAllocationsToMove == 0 &&
-            m_MaxGpuBytesToMove == 0 && m_MaxGpuAllocationsToMove == 0)
-            return VK_SUCCESS;
-
-        return VK_NOT_READY;
-    }
+        VMA_ASSERT(pCtx->mutexLocked == false);
 
-    if(commandBuffer == VK_NULL_HANDLE)
-    {
-        maxGpuBytesToMove = 0;
-        maxGpuAllocationsToMove = 0;
+        // Incremental defragmentation doesn't hold the lock, so when we enter here we don't actually have any
+        // lock protecting us. Since we mutate state here, we have to take the lock out now
+        m_Mutex.LockWrite();
+        pCtx->mutexLocked = true;
     }
 
-    VkResult res = VK_SUCCESS;
-
-    // Process default pools.
-    for(uint32_t memTypeIndex = 0;
-        memTypeIndex < m_hAllocator->GetMemoryTypeCount() && res >= VK_SUCCESS;
-        ++memTypeIndex)
+    // If the mutex isn't locked we didn't do any work and there is nothing to delete.
+    if(pCtx->mutexLocked || !m_hAllocator->m_UseMutex)
     {
-        VmaBlockVectorDefragmentationContext* pBlockVectorCtx = m_DefaultPoolContexts[memTypeIndex];
-        if(pBlockVectorCtx)
+        // Destroy buffers.
+        for(size_t blockIndex = pCtx->blockContexts.size(); blockIndex--;)
         {
-            VMA_ASSERT(pBlockVectorCtx->GetBlockVector());
-            pBlockVectorCtx->GetBlockVector()->Defragment(
-                pBlockVectorCtx,
-                pStats, flags,
-                maxCpuBytesToMove, maxCpuAllocationsToMove,
-                maxGpuBytesToMove, maxGpuAllocationsToMove,
-                commandBuffer);
-            if(pBlockVectorCtx->res != VK_SUCCESS)
+            VmaBlockDefragmentationContext &blockCtx = pCtx->blockContexts[blockIndex];
+            if(blockCtx.hBuffer)
             {
-                res = pBlockVectorCtx->res;
+                (*m_hAllocator->GetVulkanFunctions().vkDestroyBuffer)(m_hAllocator->m_hDevice, blockCtx.hBuffer, m_hAllocator->GetAllocationCallbacks());
             }
         }
-    }
 
-    // Process custom pools.
-    for(size_t customCtxIndex = 0, customCtxCount = m_CustomPoolContexts.size();
-        customCtxIndex < customCtxCount && res >= VK_SUCCESS;
-        ++customCtxIndex)
-    {
-        VmaBlockVectorDefragmentationContext* pBlockVectorCtx = m_CustomPoolContexts[customCtxIndex];
-        VMA_ASSERT(pBlockVectorCtx && pBlockVectorCtx->GetBlockVector());
-        pBlockVectorCtx->GetBlockVector()->Defragment(
-            pBlockVectorCtx,
-            pStats, flags,
-            maxCpuBytesToMove, maxCpuAllocationsToMove,
-            maxGpuBytesToMove, maxGpuAllocationsToMove,
-            commandBuffer);
-        if(pBlockVectorCtx->res != VK_SUCCESS)
+        if(pCtx->res >= VK_SUCCESS)
         {
-            res = pBlockVectorCtx->res;
+            FreeEmptyBlocks(pStats);
         }
     }
 
-    return res;
+    if(pCtx->mutexLocked)
+    {
+        VMA_ASSERT(m_hAllocator->m_UseMutex);
+        m_Mutex.UnlockWrite();
+    }
 }
 
-VkResult VmaDefragmentationContext_T::DefragmentPassBegin(VmaDefragmentationPassInfo* pInfo)
+uint32_t VmaBlockVector::ProcessDefragmentations(
+    class VmaBlockVectorDefragmentationContext *pCtx,
+    VmaDefragmentationPassMoveInfo* pMove, uint32_t maxMoves)
 {
-    VmaDefragmentationPassMoveInfo* pCurrentMove = pInfo->pMoves;
-    uint32_t movesLeft = pInfo->moveCount;
+    VmaMutexLockWrite lock(m_Mutex, m_hAllocator->m_UseMutex);
 
-    // Process default pools.
-    for(uint32_t memTypeIndex = 0;
-        memTypeIndex < m_hAllocator->GetMemoryTypeCount();
-        ++memTypeIndex)
-    {
-        VmaBlockVectorDefragmentationContext *pBlockVectorCtx = m_DefaultPoolContexts[memTypeIndex];
-        if(pBlockVectorCtx)
-        {
-            VMA_ASSERT(pBlockVectorCtx->GetBlockVector());
+    const uint32_t moveCount = VMA_MIN(uint32_t(pCtx->defragmentationMoves.size()) - pCtx->defragmentationMovesProcessed, maxMoves);
 
-            if(!pBlockVectorCtx->hasDefragmentationPlan)
-            {
-                pBlockVectorCtx->GetBlockVector()->Defragment(
-                    pBlockVectorCtx,
-                    m_pStats, m_Flags,
-                    m_MaxCpuBytesToMove, m_MaxCpuAllocationsToMove,
-                    m_MaxGpuBytesToMove, m_MaxGpuAllocationsToMove,
-                    VK_NULL_HANDLE);
+    for(uint32_t i = 0; i < moveCount; ++ i)
+    {
+        VmaDefragmentationMove& move = pCtx->defragmentationMoves[pCtx->defragmentationMovesProcessed + i];
 
-                if(pBlockVectorCtx->res < VK_SUCCESS)
-                    continue;
-
-                pBlockVectorCtx->hasDefragmentationPlan = true;
-            }
-
-            const uint32_t processed = pBlockVectorCtx->GetBlockVector()->ProcessDefragmentations(
-                pBlockVectorCtx,
-                pCurrentMove, movesLeft);
+        pMove->allocation = move.hAllocation;
+        pMove->memory = move.pDstBlock->GetDeviceMemory();
+        pMove->offset = move.dstOffset;
 
-            movesLeft -= processed;
-            pCurrentMove += processed;
-        }
+        ++ pMove;
     }
 
-    // Process custom pools.
-    for(size_t customCtxIndex = 0, customCtxCount = m_CustomPoolContexts.size();
-        customCtxIndex < customCtxCount;
-        ++customCtxIndex)
-    {
-        VmaBlockVectorDefragmentationContext *pBlockVectorCtx = m_CustomPoolContexts[customCtxIndex];
-        VMA_ASSERT(pBlockVectorCtx && pBlockVectorCtx->GetBlockVector());
-
-        if(!pBlockVectorCtx->hasDefragmentationPlan)
-        {
-            pBlockVectorCtx->GetBlockVector()->Defragment(
-                pBlockVectorCtx,
-                m_pStats, m_Flags,
-                m_MaxCpuBytesToMove, m_MaxCpuAllocationsToMove,
-                m_MaxGpuBytesToMove, m_MaxGpuAllocationsToMove,
-                VK_NULL_HANDLE);
+    pCtx->defragmentationMovesProcessed += moveCount;
 
-            if(pBlockVectorCtx->res < VK_SUCCESS)
-                continue;
+    return moveCount;
+}
 
-            pBlockVectorCtx->hasDefragmentationPlan = true;
-        }
+void VmaBlockVector::CommitDefragmentations(
+    class VmaBlockVectorDefragmentationContext *pCtx,
+    VmaDefragmentationStats* pStats)
+{
+    VmaMutexLockWrite lock(m_Mutex, m_hAllocator->m_UseMutex);
 
-        const uint32_t processed = pBlockVectorCtx->GetBlockVector()->ProcessDefragmentations(
-            pBlockVectorCtx,
-            pCurrentMove, movesLeft);
+    for(uint32_t i = pCtx->defragmentationMovesCommitted; i < pCtx->defragmentationMovesProcessed; ++ i)
+    {
+        const VmaDefragmentationMove &move = pCtx->defragmentationMoves[i];
 
-        movesLeft -= processed;
-        pCurrentMove += processed;
+        move.pSrcBlock->m_pMetadata->FreeAtOffset(move.srcOffset);
+        move.hAllocation->ChangeBlockAllocation(m_hAllocator, move.pDstBlock, move.dstOffset);
     }
 
-    pInfo->moveCount = pInfo->moveCount - movesLeft;
-
-    return VK_SUCCESS;
+    pCtx->defragmentationMovesCommitted = pCtx->defragmentationMovesProcessed;
+    FreeEmptyBlocks(pStats);
 }
-VkResult VmaDefragmentationContext_T::DefragmentPassEnd()
-{
-    VkResult res = VK_SUCCESS;
 
-    // Process default pools.
-    for(uint32_t memTypeIndex = 0;
-        memTypeIndex < m_hAllocator->GetMemoryTypeCount();
-        ++memTypeIndex)
+size_t VmaBlockVector::CalcAllocationCount() const
+{
+    size_t result = 0;
+    for(size_t i = 0; i < m_Blocks.size(); ++i)
     {
-        VmaBlockVectorDefragmentationContext *pBlockVectorCtx = m_DefaultPoolContexts[memTypeIndex];
-        if(pBlockVectorCtx)
-        {
-            VMA_ASSERT(pBlockVectorCtx->GetBlockVector());
-
-            if(!pBlockVectorCtx->hasDefragmentationPlan)
-            {
-                res = VK_NOT_READY;
-                continue;
-            }
-
-            pBlockVectorCtx->GetBlockVector()->CommitDefragmentations(
-                pBlockVectorCtx, m_pStats);
-
-            if(pBlockVectorCtx->defragmentationMoves.size() != pBlockVectorCtx->defragmentationMovesCommitted)
-                res = VK_NOT_READY;
-        }
+        result += m_Blocks[i]->m_pMetadata->GetAllocationCount();
     }
+    return result;
+}
 
-    // Process custom pools.
-    for(size_t customCtxIndex = 0, customCtxCount = m_CustomPoolContexts.size();
-        customCtxIndex < customCtxCount;
-        ++customCtxIndex)
+bool VmaBlockVector::IsBufferImageGranularityConflictPossible() const
+{
+    if(m_BufferImageGranularity == 1)
     {
-        VmaBlockVectorDefragmentationContext *pBlockVectorCtx = m_CustomPoolContexts[customCtxIndex];
-        VMA_ASSERT(pBlockVectorCtx && pBlockVectorCtx->GetBlockVector());
-
-        if(!pBlockVectorCtx->hasDefragmentationPlan)
+        return false;
+    }
+    VmaSuballocationType lastSuballocType = VMA_SUBALLOCATION_TYPE_FREE;
+    for(size_t i = 0, count = m_Blocks.size(); i < count; ++i)
+    {
+        VmaDeviceMemoryBlock* const pBlock = m_Blocks[i];
+        VMA_ASSERT(m_Algorithm == 0);
+        VmaBlockMetadata_Generic* const pMetadata = (VmaBlockMetadata_Generic*)pBlock->m_pMetadata;
+        if(pMetadata->IsBufferImageGranularityConflictPossible(m_BufferImageGranularity, lastSuballocType))
         {
-            res = VK_NOT_READY;
-            continue;
+            return true;
         }
+    }
+    return false;
+}
 
-        pBlockVectorCtx->GetBlockVector()->CommitDefragmentations(
-            pBlockVectorCtx, m_pStats);
+#if VMA_PAGEABLE_DEVICE_LOCAL_MEMORY
 
-        if(pBlockVectorCtx->defragmentationMoves.size() != pBlockVectorCtx->defragmentationMovesCommitted)
-            res = VK_NOT_READY;
+void VmaDeviceMemoryBlock::UpdateMemoryPriority(VmaAllocator hAllocator, uint32_t currentFrameIndex)
+{
+    const float priority = VmaCalcColdMemoryPriority(m_Priority, m_LastUseFrameIndex.load(), currentFrameIndex);
+    if(priority != m_AppliedPriority)
+    {
+        (*hAllocator->GetVulkanFunctions().vkSetDeviceMemoryPriorityEXT)(hAllocator->m_hDevice, m_hMemory, priority);
+        m_AppliedPriority = priority;
     }
-
-    return res;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-// VmaRecorder
+void VmaBlockVector::UpdateMemoryPriorities(uint32_t currentFrameIndex)
+{
+    VmaMutexLockRead lock(m_Mutex, m_hAllocator->m_UseMutex);
+    for(size_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex)
+    {
+        m_Blocks[blockIndex]->UpdateMemoryPriority(m_hAllocator, currentFrameIndex);
+    }
+}
 
-#if VMA_RECORDING_ENABLED
+#endif // #if VMA_PAGEABLE_DEVICE_LOCAL_MEMORY
 
-VmaRecorder::VmaRecorder() :
-    m_UseMutex(true),
-    m_Flags(0),
-    m_File(VMA_NULL),
-    m_RecordingStartTime(std::chrono::high_resolution_clock::now())
+void VmaBlockVector::MakePoolAllocationsLost(
+    uint32_t currentFrameIndex,
+    size_t* pLostAllocationCount)
 {
+    VmaMutexLockWrite lock(m_Mutex, m_hAllocator->m_UseMutex);
+    size_t lostAllocationCount = 0;
+    for(uint32_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex)
+    {
+        VmaDeviceMemoryBlock* const pBlock = m_Blocks[blockIndex];
+        VMA_ASSERT(pBlock);
+        lostAllocationCount += pBlock->m_pMetadata->MakeAllocationsLost(currentFrameIndex, m_FrameInUseCount);
+    }
+    if(pLostAllocationCount != VMA_NULL)
+    {
+        *pLostAllocationCount = lostAllocationCount;
+    }
 }
 
-VkResult VmaRecorder::Init(const VmaRecordSettings& settings, bool useMutex)
+VkResult VmaBlockVector::CheckCorruption()
 {
-    m_UseMutex = useMutex;
-    m_Flags = settings.flags;
-
-#if defined(_WIN32)
-    // Open file for writing.
-    errno_t err = fopen_s(&m_File, settings.pFilePath, "wb");
+    if(!IsCorruptionDetectionEnabled())
+    {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
 
-    if(err != 0)
+    VmaMutexLockRead lock(m_Mutex, m_hAllocator->m_UseMutex);
+    for(uint32_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex)
     {
-        return VK_ERROR_INITIALIZATION_FAILED;
+        VmaDeviceMemoryBlock* const pBlock = m_Blocks[blockIndex];
+        VMA_ASSERT(pBlock);
+        VkResult res = pBlock->CheckCorruption(m_hAllocator);
+        if(res != VK_SUCCESS)
+        {
+            return res;
+        }
     }
-#else
-    // Open file for writing.
-    m_File = fopen(settings.pFilePath, "wb");
+    return VK_SUCCESS;
+}
 
-    if(m_File == 0)
+VkResult VmaBlockVector::ZeroFreeMemory(
+    VkDeviceSize& inoutMaxBytes,
+    size_t maxRangeCount,
+    VmaVector< VmaZeroFillRange, VmaStlAllocator<VmaZeroFillRange> >& outRanges)
+{
+    // Zeroed ranges are tracked only by the default algorithm.
+    if(m_Algorithm != 0)
     {
-        return VK_ERROR_INITIALIZATION_FAILED;
+        return VK_SUCCESS;
     }
-#endif
 
-    // Write header.
-    fprintf(m_File, "%s\n", "Vulkan Memory Allocator,Calls recording");
-    fprintf(m_File, "%s\n", "1,8");
+    const bool isHostVisible =
+        (m_hAllocator->m_MemProps.memoryTypes[m_MemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+    const bool isNonCoherent = m_hAllocator->IsMemoryTypeNonCoherent(m_MemoryTypeIndex);
+    const VkDeviceSize nonCoherentAtomSize = m_hAllocator->m_PhysicalDeviceProperties.limits.nonCoherentAtomSize;
+    // vkCmdFillBuffer requires offset and size to be multiply of 4.
+    const VkDeviceSize alignment = isHostVisible ? 1 : 4;
+
+    VmaMutexLockWrite lock(m_Mutex, m_hAllocator->m_UseMutex);
+
+    VmaVector< VmaZeroFillRange, VmaStlAllocator<VmaZeroFillRange> > hostRanges(
+        VmaStlAllocator<VmaZeroFillRange>(m_hAllocator->GetAllocationCallbacks()));
+    for(size_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex)
+    {
+        VmaDeviceMemoryBlock* const pBlock = m_Blocks[blockIndex];
+        VMA_ASSERT(pBlock);
+        VmaBlockMetadata_Generic* const pMetadata = (VmaBlockMetadata_Generic*)pBlock->m_pMetadata;
 
+        bool complete;
+        if(inoutMaxBytes < alignment || (!isHostVisible && outRanges.size() >= maxRangeCount))
+        {
+            // Limits are used up: only check if there is anything left to clear, without mapping the block.
+            hostRanges.clear();
+            complete = pMetadata->ClaimDirtyFreeRanges(alignment, inoutMaxBytes, 0, hostRanges);
+        }
+        else if(isHostVisible)
+        {
+            void* pBlockData = VMA_NULL;
+            VkResult res = pBlock->Map(m_hAllocator, 1, &pBlockData);
+            if(res != VK_SUCCESS)
+            {
+                return res;
+            }
+            hostRanges.clear();
+            complete = pMetadata->ClaimDirtyFreeRanges(alignment, inoutMaxBytes, SIZE_MAX, hostRanges);
+            for(size_t rangeIndex = 0; rangeIndex < hostRanges.size(); ++rangeIndex)
+            {
+                const VmaZeroFillRange& range = hostRanges[rangeIndex];
+                memset((char*)pBlockData + range.offset, 0, (size_t)range.size);
+                if(isNonCoherent)
+                {
+                    VkMappedMemoryRange memRange = { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
+                    memRange.memory = pBlock->GetDeviceMemory();
+                    memRange.offset = VmaAlignDown(range.offset, nonCoherentAtomSize);
+                    memRange.size = VMA_MIN(
+                        VmaAlignUp(range.size + (range.offset - memRange.offset), nonCoherentAtomSize),
+                        pMetadata->GetSize() - memRange.offset);
+                    (*m_hAllocator->GetVulkanFunctions().vkFlushMappedMemoryRanges)(m_hAllocator->m_hDevice, 1, &memRange);
+                }
+            }
+            pBlock->Unmap(m_hAllocator, 1);
+        }
+        else
+        {
+            const size_t prevRangeCount = outRanges.size();
+            complete = pMetadata->ClaimDirtyFreeRanges(alignment, inoutMaxBytes, maxRangeCount, outRanges);
+            for(size_t rangeIndex = prevRangeCount; rangeIndex < outRanges.size(); ++rangeIndex)
+            {
+                outRanges[rangeIndex].memory = pBlock->GetDeviceMemory();
+            }
+        }
+        if(!complete)
+        {
+            return VK_INCOMPLETE;
+        }
+    }
     return VK_SUCCESS;
 }
 
-VmaRecorder::~VmaRecorder()
+VkResult VmaBlockVector::GetMarker(VkDeviceSize* pMarker)
 {
-    if(m_File != VMA_NULL)
+    if(m_Algorithm != VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT || m_MaxBlockCount != 1)
     {
-        fclose(m_File);
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    VmaMutexLockRead lock(m_Mutex, m_hAllocator->m_UseMutex);
+    *pMarker = 0;
+    if(!m_Blocks.empty())
+    {
+        const VmaBlockMetadata_Linear* const pMetadata = (const VmaBlockMetadata_Linear*)m_Blocks[0]->m_pMetadata;
+        if(!pMetadata->GetLowerStackTop(*pMarker))
+        {
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
     }
+    return VK_SUCCESS;
 }
 
-void VmaRecorder::RecordCreateAllocator(uint32_t frameIndex)
+VkResult VmaBlockVector::Rewind(
+    VkDeviceSize marker,
+    VmaVector< VmaAllocation, VmaStlAllocator<VmaAllocation> >& outAllocations)
 {
-    CallParams callParams;
-    GetBasicParams(callParams);
+    if(m_Algorithm != VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT || m_MaxBlockCount != 1)
+    {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
 
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaCreateAllocator\n", callParams.threadId, callParams.time, frameIndex);
-    Flush();
+    VmaMutexLockWrite lock(m_Mutex, m_hAllocator->m_UseMutex);
+    if(m_Blocks.empty())
+    {
+        return VK_SUCCESS;
+    }
+
+    VmaDeviceMemoryBlock* const pBlock = m_Blocks[0];
+    const size_t firstAllocIndex = outAllocations.size();
+    if(!((VmaBlockMetadata_Linear*)pBlock->m_pMetadata)->FreeLowerStackAbove(marker, outAllocations))
+    {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+    ReleaseRemovedAllocations(
+        pBlock,
+        outAllocations.data() + firstAllocIndex,
+        outAllocations.size() - firstAllocIndex);
+    UpdateHasEmptyBlock();
+    return VK_SUCCESS;
 }
 
-void VmaRecorder::RecordDestroyAllocator(uint32_t frameIndex)
+VkResult VmaBlockVector::Reset(VmaVector< VmaAllocation, VmaStlAllocator<VmaAllocation> >& outAllocations)
 {
-    CallParams callParams;
-    GetBasicParams(callParams);
+    if(m_Algorithm != VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT)
+    {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
 
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaDestroyAllocator\n", callParams.threadId, callParams.time, frameIndex);
-    Flush();
+    VmaMutexLockWrite lock(m_Mutex, m_hAllocator->m_UseMutex);
+    for(size_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex)
+    {
+        VmaDeviceMemoryBlock* const pBlock = m_Blocks[blockIndex];
+        const size_t firstAllocIndex = outAllocations.size();
+        ((VmaBlockMetadata_Linear*)pBlock->m_pMetadata)->FreeAll(outAllocations);
+        ReleaseRemovedAllocations(
+            pBlock,
+            outAllocations.data() + firstAllocIndex,
+            outAllocations.size() - firstAllocIndex);
+    }
+    UpdateHasEmptyBlock();
+    return VK_SUCCESS;
 }
 
-void VmaRecorder::RecordCreatePool(uint32_t frameIndex, const VmaPoolCreateInfo& createInfo, VmaPool pool)
+void VmaBlockVector::ReleaseRemovedAllocations(
+    VmaDeviceMemoryBlock* pBlock,
+    const VmaAllocation* pAllocations,
+    size_t allocationCount)
 {
-    CallParams callParams;
-    GetBasicParams(callParams);
-
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaCreatePool,%u,%u,%llu,%llu,%llu,%u,%p\n", callParams.threadId, callParams.time, frameIndex,
-        createInfo.memoryTypeIndex,
-        createInfo.flags,
-        createInfo.blockSize,
-        (uint64_t)createInfo.minBlockCount,
-        (uint64_t)createInfo.maxBlockCount,
-        createInfo.frameInUseCount,
-        pool);
-    Flush();
-}
-
-void VmaRecorder::RecordDestroyPool(uint32_t frameIndex, VmaPool pool)
-{
-    CallParams callParams;
-    GetBasicParams(callParams);
-
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaDestroyPool,%p\n", callParams.threadId, callParams.time, frameIndex,
-        pool);
-    Flush();
+    for(size_t allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
+    {
+        const VmaAllocation hAllocation = pAllocations[allocIndex];
+        VMA_ASSERT(hAllocation->GetBlock() == pBlock);
+        // Still under the lock, so no new allocation could take this place yet.
+        if(VMA_DEBUG_INITIALIZE_ALLOCATIONS)
+        {
+            m_hAllocator->FillAllocation(hAllocation, VMA_ALLOCATION_FILL_PATTERN_DESTROYED);
+        }
+        if(IsCorruptionDetectionEnabled())
+        {
+            VkResult res = pBlock->ValidateMagicValueAroundAllocation(m_hAllocator, hAllocation->GetOffset(), hAllocation->GetSize());
+            VMA_ASSERT(res == VK_SUCCESS && "Couldn't map block memory to validate magic value.");
+        }
+        if(hAllocation->IsPersistentMap())
+        {
+            pBlock->Unmap(m_hAllocator, 1);
+        }
+    }
+    VMA_HEAVY_ASSERT(pBlock->Validate());
 }
 
-void VmaRecorder::RecordAllocateMemory(uint32_t frameIndex,
-        const VkMemoryRequirements& vkMemReq,
-        const VmaAllocationCreateInfo& createInfo,
-        VmaAllocation allocation)
+void VmaBlockVector::AddStats(VmaStats* pStats)
 {
-    CallParams callParams;
-    GetBasicParams(callParams);
-
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    UserDataString userDataStr(createInfo.flags, createInfo.pUserData);
-    fprintf(m_File, "%u,%.3f,%u,vmaAllocateMemory,%llu,%llu,%u,%u,%u,%u,%u,%u,%p,%p,%s\n", callParams.threadId, callParams.time, frameIndex,
-        vkMemReq.size,
-        vkMemReq.alignment,
-        vkMemReq.memoryTypeBits,
-        createInfo.flags,
-        createInfo.usage,
-        createInfo.requiredFlags,
-        createInfo.preferredFlags,
-        createInfo.memoryTypeBits,
-        createInfo.pool,
-        allocation,
-        userDataStr.GetString());
-    Flush();
-}
+    const uint32_t memTypeIndex = m_MemoryTypeIndex;
+    const uint32_t memHeapIndex = m_hAllocator->MemoryTypeIndexToHeapIndex(memTypeIndex);
 
-void VmaRecorder::RecordAllocateMemoryPages(uint32_t frameIndex,
-    const VkMemoryRequirements& vkMemReq,
-    const VmaAllocationCreateInfo& createInfo,
-    uint64_t allocationCount,
-    const VmaAllocation* pAllocations)
-{
-    CallParams callParams;
-    GetBasicParams(callParams);
+    VmaMutexLockRead lock(m_Mutex, m_hAllocator->m_UseMutex);
 
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    UserDataString userDataStr(createInfo.flags, createInfo.pUserData);
-    fprintf(m_File, "%u,%.3f,%u,vmaAllocateMemoryPages,%llu,%llu,%u,%u,%u,%u,%u,%u,%p,", callParams.threadId, callParams.time, frameIndex,
-        vkMemReq.size,
-        vkMemReq.alignment,
-        vkMemReq.memoryTypeBits,
-        createInfo.flags,
-        createInfo.usage,
-        createInfo.requiredFlags,
-        createInfo.preferredFlags,
-        createInfo.memoryTypeBits,
-        createInfo.pool);
-    PrintPointerList(allocationCount, pAllocations);
-    fprintf(m_File, ",%s\n", userDataStr.GetString());
-    Flush();
+    for(uint32_t blockIndex = 0; blockIndex < m_Blocks.size(); ++blockIndex)
+    {
+        const VmaDeviceMemoryBlock* const pBlock = m_Blocks[blockIndex];
+        VMA_ASSERT(pBlock);
+        VMA_HEAVY_ASSERT(pBlock->Validate());
+        VmaStatInfo allocationStatInfo;
+        pBlock->m_pMetadata->CalcAllocationStatInfo(allocationStatInfo);
+        VmaAddStatInfo(pStats->total, allocationStatInfo);
+        VmaAddStatInfo(pStats->memoryType[memTypeIndex], allocationStatInfo);
+        VmaAddStatInfo(pStats->memoryHeap[memHeapIndex], allocationStatInfo);
+    }
 }
 
-void VmaRecorder::RecordAllocateMemoryForBuffer(uint32_t frameIndex,
-    const VkMemoryRequirements& vkMemReq,
-    bool requiresDedicatedAllocation,
-    bool prefersDedicatedAllocation,
-    const VmaAllocationCreateInfo& createInfo,
-    VmaAllocation allocation)
-{
-    CallParams callParams;
-    GetBasicParams(callParams);
-
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    UserDataString userDataStr(createInfo.flags, createInfo.pUserData);
-    fprintf(m_File, "%u,%.3f,%u,vmaAllocateMemoryForBuffer,%llu,%llu,%u,%u,%u,%u,%u,%u,%u,%u,%p,%p,%s\n", callParams.threadId, callParams.time, frameIndex,
-        vkMemReq.size,
-        vkMemReq.alignment,
-        vkMemReq.memoryTypeBits,
-        requiresDedicatedAllocation ? 1 : 0,
-        prefersDedicatedAllocation ? 1 : 0,
-        createInfo.flags,
-        createInfo.usage,
-        createInfo.requiredFlags,
-        createInfo.preferredFlags,
-        createInfo.memoryTypeBits,
-        createInfo.pool,
-        allocation,
-        userDataStr.GetString());
-    Flush();
-}
+////////////////////////////////////////////////////////////////////////////////
+// VmaDefragmentationAlgorithm_Generic members definition
 
-void VmaRecorder::RecordAllocateMemoryForImage(uint32_t frameIndex,
-    const VkMemoryRequirements& vkMemReq,
-    bool requiresDedicatedAllocation,
-    bool prefersDedicatedAllocation,
-    const VmaAllocationCreateInfo& createInfo,
-    VmaAllocation allocation)
+VmaDefragmentationAlgorithm_Generic::VmaDefragmentationAlgorithm_Generic(
+    VmaAllocator hAllocator,
+    VmaBlockVector* pBlockVector,
+    uint32_t currentFrameIndex,
+    bool overlappingMoveSupported) :
+    VmaDefragmentationAlgorithm(hAllocator, pBlockVector, currentFrameIndex),
+    m_AllocationCount(0),
+    m_AllAllocations(false),
+    m_BytesMoved(0),
+    m_AllocationsMoved(0),
+    m_Blocks(VmaStlAllocator<BlockInfo*>(hAllocator->GetAllocationCallbacks()))
 {
-    CallParams callParams;
-    GetBasicParams(callParams);
+    // Create block info for each block.
+    const size_t blockCount = m_pBlockVector->m_Blocks.size();
+    for(size_t blockIndex = 0; blockIndex < blockCount; ++blockIndex)
+    {
+        BlockInfo* pBlockInfo = vma_new(m_hAllocator, BlockInfo)(m_hAllocator->GetAllocationCallbacks());
+        pBlockInfo->m_OriginalBlockIndex = blockIndex;
+        pBlockInfo->m_pBlock = m_pBlockVector->m_Blocks[blockIndex];
+        m_Blocks.push_back(pBlockInfo);
+    }
 
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    UserDataString userDataStr(createInfo.flags, createInfo.pUserData);
-    fprintf(m_File, "%u,%.3f,%u,vmaAllocateMemoryForImage,%llu,%llu,%u,%u,%u,%u,%u,%u,%u,%u,%p,%p,%s\n", callParams.threadId, callParams.time, frameIndex,
-        vkMemReq.size,
-        vkMemReq.alignment,
-        vkMemReq.memoryTypeBits,
-        requiresDedicatedAllocation ? 1 : 0,
-        prefersDedicatedAllocation ? 1 : 0,
-        createInfo.flags,
-        createInfo.usage,
-        createInfo.requiredFlags,
-        createInfo.preferredFlags,
-        createInfo.memoryTypeBits,
-        createInfo.pool,
-        allocation,
-        userDataStr.GetString());
-    Flush();
+    // Sort them by m_pBlock pointer value.
+    VMA_SORT(m_Blocks.begin(), m_Blocks.end(), BlockPointerLess());
 }
 
-void VmaRecorder::RecordFreeMemory(uint32_t frameIndex,
-    VmaAllocation allocation)
+VmaDefragmentationAlgorithm_Generic::~VmaDefragmentationAlgorithm_Generic()
 {
-    CallParams callParams;
-    GetBasicParams(callParams);
-
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaFreeMemory,%p\n", callParams.threadId, callParams.time, frameIndex,
-        allocation);
-    Flush();
+    for(size_t i = m_Blocks.size(); i--; )
+    {
+        vma_delete(m_hAllocator, m_Blocks[i]);
+    }
 }
 
-void VmaRecorder::RecordFreeMemoryPages(uint32_t frameIndex,
-    uint64_t allocationCount,
-    const VmaAllocation* pAllocations)
+void VmaDefragmentationAlgorithm_Generic::AddAllocation(VmaAllocation hAlloc, VkBool32* pChanged)
 {
-    CallParams callParams;
-    GetBasicParams(callParams);
+    // Now as we are inside VmaBlockVector::m_Mutex, we can make final check if this allocation was not lost.
+    if(hAlloc->GetLastUseFrameIndex() != VMA_FRAME_INDEX_LOST)
+    {
+        VmaDeviceMemoryBlock* pBlock = hAlloc->GetBlock();
+        BlockInfoVector::iterator it = VmaBinaryFindFirstNotLess(m_Blocks.begin(), m_Blocks.end(), pBlock, BlockPointerLess());
+        if(it != m_Blocks.end() && (*it)->m_pBlock == pBlock)
+        {
+            AllocationInfo allocInfo = AllocationInfo(hAlloc, pChanged);
+            (*it)->m_Allocations.push_back(allocInfo);
+        }
+        else
+        {
+            VMA_ASSERT(0);
+        }
 
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaFreeMemoryPages,", callParams.threadId, callParams.time, frameIndex);
-    PrintPointerList(allocationCount, pAllocations);
-    fprintf(m_File, "\n");
-    Flush();
+        ++m_AllocationCount;
+    }
 }
 
-void VmaRecorder::RecordSetAllocationUserData(uint32_t frameIndex,
-    VmaAllocation allocation,
-    const void* pUserData)
+VkResult VmaDefragmentationAlgorithm_Generic::DefragmentRound(
+    VmaVector< VmaDefragmentationMove, VmaStlAllocator<VmaDefragmentationMove> >& moves,
+    VkDeviceSize maxBytesToMove,
+    uint32_t maxAllocationsToMove,
+    bool freeOldAllocations)
 {
-    CallParams callParams;
-    GetBasicParams(callParams);
-
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    UserDataString userDataStr(
-        allocation->IsUserDataString() ? VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT : 0,
-        pUserData);
-    fprintf(m_File, "%u,%.3f,%u,vmaSetAllocationUserData,%p,%s\n", callParams.threadId, callParams.time, frameIndex,
-        allocation,
-        userDataStr.GetString());
-    Flush();
-}
+    if(m_Blocks.empty())
+    {
+        return VK_SUCCESS;
+    }
 
-void VmaRecorder::RecordCreateLostAllocation(uint32_t frameIndex,
-    VmaAllocation allocation)
-{
-    CallParams callParams;
-    GetBasicParams(callParams);
+    // This is a choice based on research.
+    // Option 1:
+    uint32_t strategy = VMA_ALLOCATION_CREATE_STRATEGY_MIN_TIME_BIT;
+    // Option 2:
+    //uint32_t strategy = VMA_ALLOCATION_CREATE_STRATEGY_MIN_MEMORY_BIT;
+    // Option 3:
+    //uint32_t strategy = VMA_ALLOCATION_CREATE_STRATEGY_MIN_FRAGMENTATION_BIT;
 
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaCreateLostAllocation,%p\n", callParams.threadId, callParams.time, frameIndex,
-        allocation);
-    Flush();
-}
+    size_t srcBlockMinIndex = 0;
+    // When FAST_ALGORITHM, move allocations from only last out of blocks that contain non-movable allocations.
+    /*
+    if(m_AlgorithmFlags & VMA_DEFRAGMENTATION_FAST_ALGORITHM_BIT)
+    {
+        const size_t blocksWithNonMovableCount = CalcBlocksWithNonMovableCount();
+        if(blocksWithNonMovableCount > 0)
+        {
+            srcBlockMinIndex = blocksWithNonMovableCount - 1;
+        }
+    }
+    */
+
+    size_t srcBlockIndex = m_Blocks.size() - 1;
+    size_t srcAllocIndex = SIZE_MAX;
+    for(;;)
+    {
+        // 1. Find next allocation to move.
+        // 1.1. Start from last to first m_Blocks - they are sorted from most "destination" to most "source".
+        // 1.2. Then start from last to first m_Allocations.
+        while(srcAllocIndex >= m_Blocks[srcBlockIndex]->m_Allocations.size())
+        {
+            if(m_Blocks[srcBlockIndex]->m_Allocations.empty())
+            {
+                // Finished: no more allocations to process.
+                if(srcBlockIndex == srcBlockMinIndex)
+                {
+                    return VK_SUCCESS;
+                }
+                else
+                {
+                    --srcBlockIndex;
+                    srcAllocIndex = SIZE_MAX;
+                }
+            }
+            else
+            {
+                srcAllocIndex = m_Blocks[srcBlockIndex]->m_Allocations.size() - 1;
+            }
+        }
+
+        BlockInfo* pSrcBlockInfo = m_Blocks[srcBlockIndex];
+        AllocationInfo& allocInfo = pSrcBlockInfo->m_Allocations[srcAllocIndex];
+
+        const VkDeviceSize size = allocInfo.m_hAllocation->GetSize();
+        const VkDeviceSize srcOffset = allocInfo.m_hAllocation->GetOffset();
+        const VkDeviceSize alignment = allocInfo.m_hAllocation->GetAlignment();
+        const VmaSuballocationType suballocType = allocInfo.m_hAllocation->GetSuballocationType();
+
+        // 2. Try to find new place for this allocation in preceding or current block.
+        for(size_t dstBlockIndex = 0; dstBlockIndex <= srcBlockIndex; ++dstBlockIndex)
+        {
+            BlockInfo* pDstBlockInfo = m_Blocks[dstBlockIndex];
+            VmaAllocationRequest dstAllocRequest;
+            if(pDstBlockInfo->m_pBlock->m_pMetadata->CreateAllocationRequest(
+                m_CurrentFrameIndex,
+                m_pBlockVector->GetFrameInUseCount(),
+                m_pBlockVector->GetBufferImageGranularity(),
+                size,
+                alignment,
+                false, // upperAddress
+                suballocType,
+                false, // canMakeOtherLost
+                strategy,
+                &dstAllocRequest) &&
+            MoveMakesSense(
+                dstBlockIndex, dstAllocRequest.offset, srcBlockIndex, srcOffset))
+            {
+                VMA_ASSERT(dstAllocRequest.itemsToMakeLostCount == 0);
+
+                // Reached limit on number of allocations or bytes to move.
+                if((m_AllocationsMoved + 1 > maxAllocationsToMove) ||
+                    (m_BytesMoved + size > maxBytesToMove))
+                {
+                    return VK_SUCCESS;
+                }
+
+                VmaDefragmentationMove move = {};
+                move.srcBlockIndex = pSrcBlockInfo->m_OriginalBlockIndex;
+                move.dstBlockIndex = pDstBlockInfo->m_OriginalBlockIndex;
+                move.srcOffset = srcOffset;
+                move.dstOffset = dstAllocRequest.offset;
+                move.size = size;
+                move.hAllocation = allocInfo.m_hAllocation;
+                move.pSrcBlock = pSrcBlockInfo->m_pBlock;
+                move.pDstBlock = pDstBlockInfo->m_pBlock;
+
+                moves.push_back(move);
+
+                pDstBlockInfo->m_pBlock->m_pMetadata->Alloc(
+                    dstAllocRequest,
+                    suballocType,
+                    size,
+                    allocInfo.m_hAllocation);
+
+                if(freeOldAllocations)
+                {
+                    pSrcBlockInfo->m_pBlock->m_pMetadata->FreeAtOffset(srcOffset);
+                    allocInfo.m_hAllocation->ChangeBlockAllocation(m_hAllocator, pDstBlockInfo->m_pBlock, dstAllocRequest.offset);
+                }
+
+                if(allocInfo.m_pChanged != VMA_NULL)
+                {
+                    *allocInfo.m_pChanged = VK_TRUE;
+                }
+
+                ++m_AllocationsMoved;
+                m_BytesMoved += size;
+
+                VmaVectorRemove(pSrcBlockInfo->m_Allocations, srcAllocIndex);
+
+                break;
+            }
+        }
+
+        // If not processed, this allocInfo remains in pBlockInfo->m_Allocations for next round.
+
+        if(srcAllocIndex > 0)
+        {
+            --srcAllocIndex;
+        }
+        else
+        {
+            if(srcBlockIndex > 0)
+            {
+                --srcBlockIndex;
+                srcAllocIndex = SIZE_MAX;
+            }
+            else
+            {
+                return VK_SUCCESS;
+            }
+        }
+    }
+}
+
+size_t VmaDefragmentationAlgorithm_Generic::CalcBlocksWithNonMovableCount() const
+{
+    size_t result = 0;
+    for(size_t i = 0; i < m_Blocks.size(); ++i)
+    {
+        if(m_Blocks[i]->m_HasNonMovableAllocations)
+        {
+            ++result;
+        }
+    }
+    return result;
+}
+
+VkResult VmaDefragmentationAlgorithm_Generic::Defragment(
+    VmaVector< VmaDefragmentationMove, VmaStlAllocator<VmaDefragmentationMove> >& moves,
+    VkDeviceSize maxBytesToMove,
+    uint32_t maxAllocationsToMove,
+    VmaDefragmentationFlags flags)
+{
+    if(!m_AllAllocations && m_AllocationCount == 0)
+    {
+        return VK_SUCCESS;
+    }
+
+    const size_t blockCount = m_Blocks.size();
+    for(size_t blockIndex = 0; blockIndex < blockCount; ++blockIndex)
+    {
+        BlockInfo* pBlockInfo = m_Blocks[blockIndex];
+
+        if(m_AllAllocations)
+        {
+            VmaBlockMetadata_Generic* pMetadata = (VmaBlockMetadata_Generic*)pBlockInfo->m_pBlock->m_pMetadata;
+            for(VmaSuballocationList::const_iterator it = pMetadata->m_Suballocations.begin();
+                it != pMetadata->m_Suballocations.end();
+                ++it)
+            {
+                if(it->type != VMA_SUBALLOCATION_TYPE_FREE)
+                {
+                    AllocationInfo allocInfo = AllocationInfo(it->hAllocation, VMA_NULL);
+                    pBlockInfo->m_Allocations.push_back(allocInfo);
+                }
+            }
+        }
+
+        pBlockInfo->CalcHasNonMovableAllocations();
+
+        // This is a choice based on research.
+        // Option 1:
+        pBlockInfo->SortAllocationsByOffsetDescending();
+        // Option 2:
+        //pBlockInfo->SortAllocationsBySizeDescending();
+    }
+
+    // Sort m_Blocks this time by the main criterium, from most "destination" to most "source" blocks.
+    VMA_SORT(m_Blocks.begin(), m_Blocks.end(), BlockInfoCompareMoveDestination());
+
+    // This is a choice based on research.
+    const uint32_t roundCount = 2;
+
+    // Execute defragmentation rounds (the main part).
+    VkResult result = VK_SUCCESS;
+    for(uint32_t round = 0; (round < roundCount) && (result == VK_SUCCESS); ++round)
+    {
+        result = DefragmentRound(moves, maxBytesToMove, maxAllocationsToMove, !(flags & VMA_DEFRAGMENTATION_FLAG_INCREMENTAL));
+    }
+
+    return result;
+}
+
+bool VmaDefragmentationAlgorithm_Generic::MoveMakesSense(
+        size_t dstBlockIndex, VkDeviceSize dstOffset,
+        size_t srcBlockIndex, VkDeviceSize srcOffset)
+{
+    if(dstBlockIndex < srcBlockIndex)
+    {
+        return true;
+    }
+    if(dstBlockIndex > srcBlockIndex)
+    {
+        return false;
+    }
+    if(dstOffset < srcOffset)
+    {
+        return true;
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// VmaDefragmentationAlgorithm_Fast
+
+VmaDefragmentationAlgorithm_Fast::VmaDefragmentationAlgorithm_Fast(
+    VmaAllocator hAllocator,
+    VmaBlockVector* pBlockVector,
+    uint32_t currentFrameIndex,
+    bool overlappingMoveSupported) :
+    VmaDefragmentationAlgorithm(hAllocator, pBlockVector, currentFrameIndex),
+    m_OverlappingMoveSupported(overlappingMoveSupported),
+    m_AllocationCount(0),
+    m_AllAllocations(false),
+    m_BytesMoved(0),
+    m_AllocationsMoved(0),
+    m_BlockInfos(VmaStlAllocator<BlockInfo>(hAllocator->GetAllocationCallbacks()))
+{
+    VMA_ASSERT(VMA_DEBUG_MARGIN == 0);
+
+}
+
+VmaDefragmentationAlgorithm_Fast::~VmaDefragmentationAlgorithm_Fast()
+{
+}
+
+VkResult VmaDefragmentationAlgorithm_Fast::Defragment(
+    VmaVector< VmaDefragmentationMove, VmaStlAllocator<VmaDefragmentationMove> >& moves,
+    VkDeviceSize maxBytesToMove,
+    uint32_t maxAllocationsToMove,
+    VmaDefragmentationFlags flags)
+{
+    VMA_ASSERT(m_AllAllocations || m_pBlockVector->CalcAllocationCount() == m_AllocationCount);
+
+    const size_t blockCount = m_pBlockVector->GetBlockCount();
+    if(blockCount == 0 || maxBytesToMove == 0 || maxAllocationsToMove == 0)
+    {
+        return VK_SUCCESS;
+    }
+
+    PreprocessMetadata();
+
+    // Sort blocks in order from most destination.
+
+    m_BlockInfos.resize(blockCount);
+    for(size_t i = 0; i < blockCount; ++i)
+    {
+        m_BlockInfos[i].origBlockIndex = i;
+    }
+
+    VMA_SORT(m_BlockInfos.begin(), m_BlockInfos.end(), [this](const BlockInfo& lhs, const BlockInfo& rhs) -> bool {
+        return m_pBlockVector->GetBlock(lhs.origBlockIndex)->m_pMetadata->GetSumFreeSize() <
+            m_pBlockVector->GetBlock(rhs.origBlockIndex)->m_pMetadata->GetSumFreeSize();
+    });
+
+    // THE MAIN ALGORITHM
+
+    FreeSpaceDatabase freeSpaceDb;
+
+    size_t dstBlockInfoIndex = 0;
+    size_t dstOrigBlockIndex = m_BlockInfos[dstBlockInfoIndex].origBlockIndex;
+    VmaDeviceMemoryBlock* pDstBlock = m_pBlockVector->GetBlock(dstOrigBlockIndex);
+    VmaBlockMetadata_Generic* pDstMetadata = (VmaBlockMetadata_Generic*)pDstBlock->m_pMetadata;
+    VkDeviceSize dstBlockSize = pDstMetadata->GetSize();
+    VkDeviceSize dstOffset = 0;
+
+    bool end = false;
+    for(size_t srcBlockInfoIndex = 0; !end && srcBlockInfoIndex < blockCount; ++srcBlockInfoIndex)
+    {
+        const size_t srcOrigBlockIndex = m_BlockInfos[srcBlockInfoIndex].origBlockIndex;
+        VmaDeviceMemoryBlock* const pSrcBlock = m_pBlockVector->GetBlock(srcOrigBlockIndex);
+        VmaBlockMetadata_Generic* const pSrcMetadata = (VmaBlockMetadata_Generic*)pSrcBlock->m_pMetadata;
+        for(VmaSuballocationList::iterator srcSuballocIt = pSrcMetadata->m_Suballocations.begin();
+            !end && srcSuballocIt != pSrcMetadata->m_Suballocations.end(); )
+        {
+            VmaAllocation_T* const pAlloc = srcSuballocIt->hAllocation;
+            const VkDeviceSize srcAllocAlignment = pAlloc->GetAlignment();
+            const VkDeviceSize srcAllocSize = srcSuballocIt->size;
+            if(m_AllocationsMoved == maxAllocationsToMove ||
+                m_BytesMoved + srcAllocSize > maxBytesToMove)
+            {
+                end = true;
+                break;
+            }
+            const VkDeviceSize srcAllocOffset = srcSuballocIt->offset;
+
+            VmaDefragmentationMove move = {};
+            // Try to place it in one of free spaces from the database.
+            size_t freeSpaceInfoIndex;
+            VkDeviceSize dstAllocOffset;
+            if(freeSpaceDb.Fetch(srcAllocAlignment, srcAllocSize,
+                freeSpaceInfoIndex, dstAllocOffset))
+            {
+                size_t freeSpaceOrigBlockIndex = m_BlockInfos[freeSpaceInfoIndex].origBlockIndex;
+                VmaDeviceMemoryBlock* pFreeSpaceBlock = m_pBlockVector->GetBlock(freeSpaceOrigBlockIndex);
+                VmaBlockMetadata_Generic* pFreeSpaceMetadata = (VmaBlockMetadata_Generic*)pFreeSpaceBlock->m_pMetadata;
+
+                // Same block
+                if(freeSpaceInfoIndex == srcBlockInfoIndex)
+                {
+                    VMA_ASSERT(dstAllocOffset <= srcAllocOffset);
+
+                    // MOVE OPTION 1: Move the allocation inside the same block by decreasing offset.
+
+                    VmaSuballocation suballoc = *srcSuballocIt;
+                    suballoc.offset = dstAllocOffset;
+                    suballoc.hAllocation->ChangeOffset(dstAllocOffset);
+                    m_BytesMoved += srcAllocSize;
+                    ++m_AllocationsMoved;
+
+                    VmaSuballocationList::iterator nextSuballocIt = srcSuballocIt;
+                    ++nextSuballocIt;
+                    pSrcMetadata->m_Suballocations.erase(srcSuballocIt);
+                    srcSuballocIt = nextSuballocIt;
+
+                    InsertSuballoc(pFreeSpaceMetadata, suballoc);
+
+                    move.srcBlockIndex = srcOrigBlockIndex;
+                    move.dstBlockIndex = freeSpaceOrigBlockIndex;
+                    move.srcOffset = srcAllocOffset;
+                    move.dstOffset = dstAllocOffset;
+                    move.size = srcAllocSize;
+
+                    moves.push_back(move);
+                }
+                // Different block
+                else
+                {
+                    // MOVE OPTION 2: Move the allocation to a different block.
+
+                    VMA_ASSERT(freeSpaceInfoIndex < srcBlockInfoIndex);
+
+                    VmaSuballocation suballoc = *srcSuballocIt;
+                    suballoc.offset = dstAllocOffset;
+                    suballoc.hAllocation->ChangeBlockAllocation(m_hAllocator, pFreeSpaceBlock, dstAllocOffset);
+                    m_BytesMoved += srcAllocSize;
+                    ++m_AllocationsMoved;
+
+                    VmaSuballocationList::iterator nextSuballocIt = srcSuballocIt;
+                    ++nextSuballocIt;
+                    pSrcMetadata->m_Suballocations.erase(srcSuballocIt);
+                    srcSuballocIt = nextSuballocIt;
+
+                    InsertSuballoc(pFreeSpaceMetadata, suballoc);
+
+                    move.srcBlockIndex = srcOrigBlockIndex;
+                    move.dstBlockIndex = freeSpaceOrigBlockIndex;
+                    move.srcOffset = srcAllocOffset;
+                    move.dstOffset = dstAllocOffset;
+                    move.size = srcAllocSize;
+
+                    moves.push_back(move);
+                }
+            }
+            else
+            {
+                dstAllocOffset = VmaAlignUp(dstOffset, srcAllocAlignment);
+
+                // If the allocation doesn't fit before the end of dstBlock, forward to next block.
+                while(dstBlockInfoIndex < srcBlockInfoIndex &&
+                    dstAllocOffset + srcAllocSize > dstBlockSize)
+                {
+                    // But before that, register remaining free space at the end of dst block.
+                    freeSpaceDb.Register(dstBlockInfoIndex, dstOffset, dstBlockSize - dstOffset);
+
+                    ++dstBlockInfoIndex;
+                    dstOrigBlockIndex = m_BlockInfos[dstBlockInfoIndex].origBlockIndex;
+                    pDstBlock = m_pBlockVector->GetBlock(dstOrigBlockIndex);
+                    pDstMetadata = (VmaBlockMetadata_Generic*)pDstBlock->m_pMetadata;
+                    dstBlockSize = pDstMetadata->GetSize();
+                    dstOffset = 0;
+                    dstAllocOffset = 0;
+                }
+
+                // Same block
+                if(dstBlockInfoIndex == srcBlockInfoIndex)
+                {
+                    VMA_ASSERT(dstAllocOffset <= srcAllocOffset);
+
+                    const bool overlap = dstAllocOffset + srcAllocSize > srcAllocOffset;
+
+                    bool skipOver = overlap;
+                    if(overlap && m_OverlappingMoveSupported && dstAllocOffset < srcAllocOffset)
+                    {
+                        // If destination and source place overlap, skip if it would move it
+                        // by only < 1/64 of its size.
+                        skipOver = (srcAllocOffset - dstAllocOffset) * 64 < srcAllocSize;
+                    }
+
+                    if(skipOver)
+                    {
+                        freeSpaceDb.Register(dstBlockInfoIndex, dstOffset, srcAllocOffset - dstOffset);
+
+                        dstOffset = srcAllocOffset + srcAllocSize;
+                        ++srcSuballocIt;
+                    }
+                    // MOVE OPTION 1: Move the allocation inside the same block by decreasing offset.
+                    else
+                    {
+                        srcSuballocIt->offset = dstAllocOffset;
+                        srcSuballocIt->hAllocation->ChangeOffset(dstAllocOffset);
+                        dstOffset = dstAllocOffset + srcAllocSize;
+                        m_BytesMoved += srcAllocSize;
+                        ++m_AllocationsMoved;
+                        ++srcSuballocIt;
+
+                        move.srcBlockIndex = srcOrigBlockIndex;
+                        move.dstBlockIndex = dstOrigBlockIndex;
+                        move.srcOffset = srcAllocOffset;
+                        move.dstOffset = dstAllocOffset;
+                        move.size = srcAllocSize;
+
+                        moves.push_back(move);
+                    }
+                }
+                // Different block
+                else
+                {
+                    // MOVE OPTION 2: Move the allocation to a different block.
+
+                    VMA_ASSERT(dstBlockInfoIndex < srcBlockInfoIndex);
+                    VMA_ASSERT(dstAllocOffset + srcAllocSize <= dstBlockSize);
+
+                    VmaSuballocation suballoc = *srcSuballocIt;
+                    suballoc.offset = dstAllocOffset;
+                    suballoc.hAllocation->ChangeBlockAllocation(m_hAllocator, pDstBlock, dstAllocOffset);
+                    dstOffset = dstAllocOffset + srcAllocSize;
+                    m_BytesMoved += srcAllocSize;
+                    ++m_AllocationsMoved;
+
+                    VmaSuballocationList::iterator nextSuballocIt = srcSuballocIt;
+                    ++nextSuballocIt;
+                    pSrcMetadata->m_Suballocations.erase(srcSuballocIt);
+                    srcSuballocIt = nextSuballocIt;
+
+                    pDstMetadata->m_Suballocations.push_back(suballoc);
+
+                    move.srcBlockIndex = srcOrigBlockIndex;
+                    move.dstBlockIndex = dstOrigBlockIndex;
+                    move.srcOffset = srcAllocOffset;
+                    move.dstOffset = dstAllocOffset;
+                    move.size = srcAllocSize;
+
+                    moves.push_back(move);
+                }
+            }
+        }
+    }
+
+    m_BlockInfos.clear();
+
+    PostprocessMetadata();
+
+    return VK_SUCCESS;
+}
+
+void VmaDefragmentationAlgorithm_Fast::PreprocessMetadata()
+{
+    const size_t blockCount = m_pBlockVector->GetBlockCount();
+    for(size_t blockIndex = 0; blockIndex < blockCount; ++blockIndex)
+    {
+        VmaBlockMetadata_Generic* const pMetadata =
+            (VmaBlockMetadata_Generic*)m_pBlockVector->GetBlock(blockIndex)->m_pMetadata;
+        pMetadata->m_FreeCount = 0;
+        pMetadata->m_SumFreeSize = pMetadata->GetSize();
+        pMetadata->m_FreeSuballocationsBySize.clear();
+        for(VmaSuballocationList::iterator it = pMetadata->m_Suballocations.begin();
+            it != pMetadata->m_Suballocations.end(); )
+        {
+            if(it->type == VMA_SUBALLOCATION_TYPE_FREE)
+            {
+                VmaSuballocationList::iterator nextIt = it;
+                ++nextIt;
+                pMetadata->m_Suballocations.erase(it);
+                it = nextIt;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+}
+
+void VmaDefragmentationAlgorithm_Fast::PostprocessMetadata()
+{
+    const size_t blockCount = m_pBlockVector->GetBlockCount();
+    for(size_t blockIndex = 0; blockIndex < blockCount; ++blockIndex)
+    {
+        VmaBlockMetadata_Generic* const pMetadata =
+            (VmaBlockMetadata_Generic*)m_pBlockVector->GetBlock(blockIndex)->m_pMetadata;
+        const VkDeviceSize blockSize = pMetadata->GetSize();
+
+        // No allocations in this block - entire area is free.
+        if(pMetadata->m_Suballocations.empty())
+        {
+            pMetadata->m_FreeCount = 1;
+            //pMetadata->m_SumFreeSize is already set to blockSize.
+            VmaSuballocation suballoc = {
+                0, // offset
+                blockSize, // size
+                VMA_NULL, // hAllocation
+                VMA_SUBALLOCATION_TYPE_FREE };
+            pMetadata->m_Suballocations.push_back(suballoc);
+            pMetadata->RegisterFreeSuballocation(pMetadata->m_Suballocations.begin());
+        }
+        // There are some allocations in this block.
+        else
+        {
+            VkDeviceSize offset = 0;
+            VmaSuballocationList::iterator it;
+            for(it = pMetadata->m_Suballocations.begin();
+                it != pMetadata->m_Suballocations.end();
+                ++it)
+            {
+                VMA_ASSERT(it->type != VMA_SUBALLOCATION_TYPE_FREE);
+                VMA_ASSERT(it->offset >= offset);
+
+                // Need to insert preceding free space.
+                if(it->offset > offset)
+                {
+                    ++pMetadata->m_FreeCount;
+                    const VkDeviceSize freeSize = it->offset - offset;
+                    VmaSuballocation suballoc = {
+                        offset, // offset
+                        freeSize, // size
+                        VMA_NULL, // hAllocation
+                        VMA_SUBALLOCATION_TYPE_FREE };
+                    VmaSuballocationList::iterator precedingFreeIt = pMetadata->m_Suballocations.insert(it, suballoc);
+                    if(freeSize >= VMA_MIN_FREE_SUBALLOCATION_SIZE_TO_REGISTER)
+                    {
+                        pMetadata->m_FreeSuballocationsBySize.push_back(precedingFreeIt);
+                    }
+                }
+
+                pMetadata->m_SumFreeSize -= it->size;
+                offset = it->offset + it->size;
+            }
+
+            // Need to insert trailing free space.
+            if(offset < blockSize)
+            {
+                ++pMetadata->m_FreeCount;
+                const VkDeviceSize freeSize = blockSize - offset;
+                VmaSuballocation suballoc = {
+                    offset, // offset
+                    freeSize, // size
+                    VMA_NULL, // hAllocation
+                    VMA_SUBALLOCATION_TYPE_FREE };
+                VMA_ASSERT(it == pMetadata->m_Suballocations.end());
+                VmaSuballocationList::iterator trailingFreeIt = pMetadata->m_Suballocations.insert(it, suballoc);
+                if(freeSize > VMA_MIN_FREE_SUBALLOCATION_SIZE_TO_REGISTER)
+                {
+                    pMetadata->m_FreeSuballocationsBySize.push_back(trailingFreeIt);
+                }
+            }
+
+            VMA_SORT(
+                pMetadata->m_FreeSuballocationsBySize.begin(),
+                pMetadata->m_FreeSuballocationsBySize.end(),
+                VmaSuballocationItemSizeLess());
+        }
+
+        VMA_HEAVY_ASSERT(pMetadata->Validate());
+    }
+}
+
+void VmaDefragmentationAlgorithm_Fast::InsertSuballoc(VmaBlockMetadata_Generic* pMetadata, const VmaSuballocation& suballoc)
+{
+    // TODO: Optimize somehow. Remember iterator instead of searching for it linearly.
+    VmaSuballocationList::iterator it = pMetadata->m_Suballocations.begin();
+    while(it != pMetadata->m_Suballocations.end())
+    {
+        if(it->offset < suballoc.offset)
+        {
+            ++it;
+        }
+    }
+    pMetadata->m_Suballocations.insert(it, suballoc);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// VmaBlockVectorDefragmentationContext
+
+VmaBlockVectorDefragmentationContext::VmaBlockVectorDefragmentationContext(
+    VmaAllocator hAllocator,
+    VmaPool hCustomPool,
+    VmaBlockVector* pBlockVector,
+    uint32_t currFrameIndex) :
+    res(VK_SUCCESS),
+    mutexLocked(false),
+    blockContexts(VmaStlAllocator<VmaBlockDefragmentationContext>(hAllocator->GetAllocationCallbacks())),
+    defragmentationMoves(VmaStlAllocator<VmaDefragmentationMove>(hAllocator->GetAllocationCallbacks())),
+    defragmentationMovesProcessed(0),
+    defragmentationMovesCommitted(0),
+    hasDefragmentationPlan(0),
+    m_hAllocator(hAllocator),
+    m_hCustomPool(hCustomPool),
+    m_pBlockVector(pBlockVector),
+    m_CurrFrameIndex(currFrameIndex),
+    m_pAlgorithm(VMA_NULL),
+    m_Allocations(VmaStlAllocator<AllocInfo>(hAllocator->GetAllocationCallbacks())),
+    m_AllAllocations(false)
+{
+}
+
+VmaBlockVectorDefragmentationContext::~VmaBlockVectorDefragmentationContext()
+{
+    vma_delete(m_hAllocator, m_pAlgorithm);
+}
+
+void VmaBlockVectorDefragmentationContext::AddAllocation(VmaAllocation hAlloc, VkBool32* pChanged)
+{
+    AllocInfo info = { hAlloc, pChanged };
+    m_Allocations.push_back(info);
+}
+
+void VmaBlockVectorDefragmentationContext::Begin(bool overlappingMoveSupported, VmaDefragmentationFlags flags)
+{
+    const bool allAllocations = m_AllAllocations ||
+        m_Allocations.size() == m_pBlockVector->CalcAllocationCount();
+
+    /********************************
+    HERE IS THE CHOICE OF DEFRAGMENTATION ALGORITHM.
+    ********************************/
+
+    /*
+    Fast algorithm is supported only when certain criteria are met:
+    - VMA_DEBUG_MARGIN is 0.
+    - All allocations in this block vector are moveable.
+    - There is no possibility of image/buffer granularity conflict.
+    - The defragmentation is not incremental
+    */
+    if(VMA_DEBUG_MARGIN == 0 &&
+        allAllocations &&
+        !m_pBlockVector->IsBufferImageGranularityConflictPossible() &&
+        !(flags & VMA_DEFRAGMENTATION_FLAG_INCREMENTAL))
+    {
+        m_pAlgorithm = vma_new(m_hAllocator, VmaDefragmentationAlgorithm_Fast)(
+            m_hAllocator, m_pBlockVector, m_CurrFrameIndex, overlappingMoveSupported);
+    }
+    else
+    {
+        m_pAlgorithm = vma_new(m_hAllocator, VmaDefragmentationAlgorithm_Generic)(
+            m_hAllocator, m_pBlockVector, m_CurrFrameIndex, overlappingMoveSupported);
+    }
+
+    if(allAllocations)
+    {
+        m_pAlgorithm->AddAll();
+    }
+    else
+    {
+        for(size_t i = 0, count = m_Allocations.size(); i < count; ++i)
+        {
+            m_pAlgorithm->AddAllocation(m_Allocations[i].hAlloc, m_Allocations[i].pChanged);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// VmaDefragmentationContext
+
+VmaDefragmentationContext_T::VmaDefragmentationContext_T(
+    VmaAllocator hAllocator,
+    uint32_t currFrameIndex,
+    uint32_t flags,
+    VmaDefragmentationStats* pStats) :
+    m_hAllocator(hAllocator),
+    m_CurrFrameIndex(currFrameIndex),
+    m_Flags(flags),
+    m_pStats(pStats),
+    m_CustomPoolContexts(VmaStlAllocator<VmaBlockVectorDefragmentationContext*>(hAllocator->GetAllocationCallbacks()))
+{
+    memset(m_DefaultPoolContexts, 0, sizeof(m_DefaultPoolContexts));
+}
+
+VmaDefragmentationContext_T::~VmaDefragmentationContext_T()
+{
+    for(size_t i = m_CustomPoolContexts.size(); i--; )
+    {
+        VmaBlockVectorDefragmentationContext* pBlockVectorCtx = m_CustomPoolContexts[i];
+        pBlockVectorCtx->GetBlockVector()->DefragmentationEnd(pBlockVectorCtx, m_Flags, m_pStats);
+        vma_delete(m_hAllocator, pBlockVectorCtx);
+    }
+    for(size_t i = m_hAllocator->m_MemProps.memoryTypeCount; i--; )
+    {
+        VmaBlockVectorDefragmentationContext* pBlockVectorCtx = m_DefaultPoolContexts[i];
+        if(pBlockVectorCtx)
+        {
+            pBlockVectorCtx->GetBlockVector()->DefragmentationEnd(pBlockVectorCtx, m_Flags, m_pStats);
+            vma_delete(m_hAllocator, pBlockVectorCtx);
+        }
+    }
+}
+
+void VmaDefragmentationContext_T::AddPools(uint32_t poolCount, const VmaPool* pPools)
+{
+    for(uint32_t poolIndex = 0; poolIndex < poolCount; ++poolIndex)
+    {
+        VmaPool pool = pPools[poolIndex];
+        VMA_ASSERT(pool);
+        // Pools with algorithm other than default are not defragmented.
+        if(pool->m_BlockVector.GetAlgorithm() == 0)
+        {
+            VmaBlockVectorDefragmentationContext* pBlockVectorDefragCtx = VMA_NULL;
+
+            for(size_t i = m_CustomPoolContexts.size(); i--; )
+            {
+                if(m_CustomPoolContexts[i]->GetCustomPool() == pool)
+                {
+                    pBlockVectorDefragCtx = m_CustomPoolContexts[i];
+                    break;
+                }
+            }
+
+            if(!pBlockVectorDefragCtx)
+            {
+                pBlockVectorDefragCtx = vma_new(m_hAllocator, VmaBlockVectorDefragmentationContext)(
+                    m_hAllocator,
+                    pool,
+                    &pool->m_BlockVector,
+                    m_CurrFrameIndex);
+                m_CustomPoolContexts.push_back(pBlockVectorDefragCtx);
+            }
+
+            pBlockVectorDefragCtx->AddAll();
+        }
+    }
+}
+
+void VmaDefragmentationContext_T::AddAllocations(
+    uint32_t allocationCount,
+    const VmaAllocation* pAllocations,
+    VkBool32* pAllocationsChanged)
+{
+    // Dispatch pAllocations among defragmentators. Create them when necessary.
+    for(uint32_t allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
+    {
+        const VmaAllocation hAlloc = pAllocations[allocIndex];
+        VMA_ASSERT(hAlloc);
+        // DedicatedAlloc cannot be defragmented.
+        if((hAlloc->GetType() == VmaAllocation_T::ALLOCATION_TYPE_BLOCK) &&
+            // Lost allocation cannot be defragmented.
+            (hAlloc->GetLastUseFrameIndex() != VMA_FRAME_INDEX_LOST))
+        {
+            VmaBlockVectorDefragmentationContext* pBlockVectorDefragCtx = VMA_NULL;
+
+            const VmaPool hAllocPool = hAlloc->GetBlock()->GetParentPool();
+            // This allocation belongs to custom pool.
+            if(hAllocPool != VK_NULL_HANDLE)
+            {
+                // Pools with algorithm other than default are not defragmented.
+                if(hAllocPool->m_BlockVector.GetAlgorithm() == 0)
+                {
+                    for(size_t i = m_CustomPoolContexts.size(); i--; )
+                    {
+                        if(m_CustomPoolContexts[i]->GetCustomPool() == hAllocPool)
+                        {
+                            pBlockVectorDefragCtx = m_CustomPoolContexts[i];
+                            break;
+                        }
+                    }
+                    if(!pBlockVectorDefragCtx)
+                    {
+                        pBlockVectorDefragCtx = vma_new(m_hAllocator, VmaBlockVectorDefragmentationContext)(
+                            m_hAllocator,
+                            hAllocPool,
+                            &hAllocPool->m_BlockVector,
+                            m_CurrFrameIndex);
+                        m_CustomPoolContexts.push_back(pBlockVectorDefragCtx);
+                    }
+                }
+            }
+            // This allocation belongs to default pool.
+            else
+            {
+                const uint32_t memTypeIndex = hAlloc->GetMemoryTypeIndex();
+                pBlockVectorDefragCtx = m_DefaultPoolContexts[memTypeIndex];
+                if(!pBlockVectorDefragCtx)
+                {
+                    pBlockVectorDefragCtx = vma_new(m_hAllocator, VmaBlockVectorDefragmentationContext)(
+                        m_hAllocator,
+                        VMA_NULL, // hCustomPool
+                        m_hAllocator->m_pBlockVectors[memTypeIndex],
+                        m_CurrFrameIndex);
+                    m_DefaultPoolContexts[memTypeIndex] = pBlockVectorDefragCtx;
+                }
+            }
+
+            if(pBlockVectorDefragCtx)
+            {
+                VkBool32* const pChanged = (pAllocationsChanged != VMA_NULL) ?
+                    &pAllocationsChanged[allocIndex] : VMA_NULL;
+                pBlockVectorDefragCtx->AddAllocation(hAlloc, pChanged);
+            }
+        }
+    }
+}
+
+VkResult VmaDefragmentationContext_T::Defragment(
+    VkDeviceSize maxCpuBytesToMove, uint32_t maxCpuAllocationsToMove,
+    VkDeviceSize maxGpuBytesToMove, uint32_t maxGpuAllocationsToMove,
+    VkCommandBuffer commandBuffer, VmaDefragmentationStats* pStats, VmaDefragmentationFlags flags)
+{
+    if(pStats)
+    {
+        memset(pStats, 0, sizeof(VmaDefragmentationStats));
+    }
+
+    if(flags & VMA_DEFRAGMENTATION_FLAG_INCREMENTAL)
+    {
+        // For incremental defragmetnations, we just earmark how much we can move
+        // The real meat is in the defragmentation steps
+        m_MaxCpuBytesToMove = maxCpuBytesToMove;
+        m_MaxCpuAllocationsToMove = maxCpuAllocationsToMove;
+
+        m_MaxGpuBytesToMove = maxGpuBytesToMove;
+        m_MaxGpuAllocationsToMove = maxGpuAllocationsToMove;
+
+        if(m_MaxCpuBytesToMove == 0 && m_MaxCpuAllocationsToMove == 0 &&
+            m_MaxGpuBytesToMove == 0 && m_MaxGpuAllocationsToMove == 0)
+            return VK_SUCCESS;
+
+        return VK_NOT_READY;
+    }
+
+    if(commandBuffer == VK_NULL_HANDLE)
+    {
+        maxGpuBytesToMove = 0;
+        maxGpuAllocationsToMove = 0;
+    }
+
+    VkResult res = VK_SUCCESS;
+
+    // Process default pools.
+    for(uint32_t memTypeIndex = 0;
+        memTypeIndex < m_hAllocator->GetMemoryTypeCount() && res >= VK_SUCCESS;
+        ++memTypeIndex)
+    {
+        VmaBlockVectorDefragmentationContext* pBlockVectorCtx = m_DefaultPoolContexts[memTypeIndex];
+        if(pBlockVectorCtx)
+        {
+            VMA_ASSERT(pBlockVectorCtx->GetBlockVector());
+            pBlockVectorCtx->GetBlockVector()->Defragment(
+                pBlockVectorCtx,
+                pStats, flags,
+                maxCpuBytesToMove, maxCpuAllocationsToMove,
+                maxGpuBytesToMove, maxGpuAllocationsToMove,
+                commandBuffer);
+            if(pBlockVectorCtx->res != VK_SUCCESS)
+            {
+                res = pBlockVectorCtx->res;
+            }
+        }
+    }
+
+    // Process custom pools.
+    for(size_t customCtxIndex = 0, customCtxCount = m_CustomPoolContexts.size();
+        customCtxIndex < customCtxCount && res >= VK_SUCCESS;
+        ++customCtxIndex)
+    {
+        VmaBlockVectorDefragmentationContext* pBlockVectorCtx = m_CustomPoolContexts[customCtxIndex];
+        VMA_ASSERT(pBlockVectorCtx && pBlockVectorCtx->GetBlockVector());
+        pBlockVectorCtx->GetBlockVector()->Defragment(
+            pBlockVectorCtx,
+            pStats, flags,
+            maxCpuBytesToMove, maxCpuAllocationsToMove,
+            maxGpuBytesToMove, maxGpuAllocationsToMove,
+            commandBuffer);
+        if(pBlockVectorCtx->res != VK_SUCCESS)
+        {
+            res = pBlockVectorCtx->res;
+        }
+    }
+
+    return res;
+}
+
+VkResult VmaDefragmentationContext_T::DefragmentPassBegin(VmaDefragmentationPassInfo* pInfo)
+{
+    VmaDefragmentationPassMoveInfo* pCurrentMove = pInfo->pMoves;
+    uint32_t movesLeft = pInfo->moveCount;
+
+    // Process default pools.
+    for(uint32_t memTypeIndex = 0;
+        memTypeIndex < m_hAllocator->GetMemoryTypeCount();
+        ++memTypeIndex)
+    {
+        VmaBlockVectorDefragmentationContext *pBlockVectorCtx = m_DefaultPoolContexts[memTypeIndex];
+        if(pBlockVectorCtx)
+        {
+            VMA_ASSERT(pBlockVectorCtx->GetBlockVector());
+
+            if(!pBlockVectorCtx->hasDefragmentationPlan)
+            {
+                pBlockVectorCtx->GetBlockVector()->Defragment(
+                    pBlockVectorCtx,
+                    m_pStats, m_Flags,
+                    m_MaxCpuBytesToMove, m_MaxCpuAllocationsToMove,
+                    m_MaxGpuBytesToMove, m_MaxGpuAllocationsToMove,
+                    VK_NULL_HANDLE);
+
+                if(pBlockVectorCtx->res < VK_SUCCESS)
+                    continue;
+
+                pBlockVectorCtx->hasDefragmentationPlan = true;
+            }
+
+            const uint32_t processed = pBlockVectorCtx->GetBlockVector()->ProcessDefragmentations(
+                pBlockVectorCtx,
+                pCurrentMove, movesLeft);
+
+            movesLeft -= processed;
+            pCurrentMove += processed;
+        }
+    }
+
+    // Process custom pools.
+    for(size_t customCtxIndex = 0, customCtxCount = m_CustomPoolContexts.size();
+        customCtxIndex < customCtxCount;
+        ++customCtxIndex)
+    {
+        VmaBlockVectorDefragmentationContext *pBlockVectorCtx = m_CustomPoolContexts[customCtxIndex];
+        VMA_ASSERT(pBlockVectorCtx && pBlockVectorCtx->GetBlockVector());
+
+        if(!pBlockVectorCtx->hasDefragmentationPlan)
+        {
+            pBlockVectorCtx->GetBlockVector()->Defragment(
+                pBlockVectorCtx,
+                m_pStats, m_Flags,
+                m_MaxCpuBytesToMove, m_MaxCpuAllocationsToMove,
+                m_MaxGpuBytesToMove, m_MaxGpuAllocationsToMove,
+                VK_NULL_HANDLE);
+
+            if(pBlockVectorCtx->res < VK_SUCCESS)
+                continue;
+
+            pBlockVectorCtx->hasDefragmentationPlan = true;
+        }
+
+        const uint32_t processed = pBlockVectorCtx->GetBlockVector()->ProcessDefragmentations(
+            pBlockVectorCtx,
+            pCurrentMove, movesLeft);
+
+        movesLeft -= processed;
+        pCurrentMove += processed;
+    }
+
+    pInfo->moveCount = pInfo->moveCount - movesLeft;
+
+    return VK_SUCCESS;
+}
+VkResult VmaDefragmentationContext_T::DefragmentPassEnd()
+{
+    VkResult res = VK_SUCCESS;
+
+    // Process default pools.
+    for(uint32_t memTypeIndex = 0;
+        memTypeIndex < m_hAllocator->GetMemoryTypeCount();
+        ++memTypeIndex)
+    {
+        VmaBlockVectorDefragmentationContext *pBlockVectorCtx = m_DefaultPoolContexts[memTypeIndex];
+        if(pBlockVectorCtx)
+        {
+            VMA_ASSERT(pBlockVectorCtx->GetBlockVector());
+
+            if(!pBlockVectorCtx->hasDefragmentationPlan)
+            {
+                res = VK_NOT_READY;
+                continue;
+            }
+
+            pBlockVectorCtx->GetBlockVector()->CommitDefragmentations(
+                pBlockVectorCtx, m_pStats);
+
+            if(pBlockVectorCtx->defragmentationMoves.size() != pBlockVectorCtx->defragmentationMovesCommitted)
+                res = VK_NOT_READY;
+        }
+    }
+
+    // Process custom pools.
+    for(size_t customCtxIndex = 0, customCtxCount = m_CustomPoolContexts.size();
+        customCtxIndex < customCtxCount;
+        ++customCtxIndex)
+    {
+        VmaBlockVectorDefragmentationContext *pBlockVectorCtx = m_CustomPoolContexts[customCtxIndex];
+        VMA_ASSERT(pBlockVectorCtx && pBlockVectorCtx->GetBlockVector());
+
+        if(!pBlockVectorCtx->hasDefragmentationPlan)
+        {
+            res = VK_NOT_READY;
+            continue;
+        }
+
+        pBlockVectorCtx->GetBlockVector()->CommitDefragmentations(
+            pBlockVectorCtx, m_pStats);
+
+        if(pBlockVectorCtx->defragmentationMoves.size() != pBlockVectorCtx->defragmentationMovesCommitted)
+            res = VK_NOT_READY;
+    }
+
+    return res;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// VmaRecorder
+
+#if VMA_RECORDING_ENABLED
+
+VmaRecorder::VmaRecorder(const VkAllocationCallbacks* pAllocationCallbacks) :
+    m_pAllocationCallbacks(pAllocationCallbacks),
+    m_UseMutex(true),
+    m_Flags(0),
+    m_MemoryTypeBits(UINT32_MAX),
+    m_MinAllocationSize(0),
+    m_MaxAllocationSize(VK_WHOLE_SIZE),
+    m_AllocationSamplingRate(1),
+    m_File(VMA_NULL),
+    m_RecordingStartTime(std::chrono::high_resolution_clock::now()),
+    m_pFilePath(VMA_NULL),
+    m_pRingBuffer(VMA_NULL),
+    m_RingBufferSize(0),
+    m_RingBegin(0),
+    m_RingUsed(0),
+    m_RingCallSizes(VmaStlAllocator<size_t>(pAllocationCallbacks)),
+    m_RingCallBegin(0),
+    m_RingCallCount(0),
+    m_PushedCallCount(0),
+    m_LivePools(VmaStlAllocator<LivePool>(pAllocationCallbacks)),
+    m_LiveAllocations(VmaStlAllocator<LiveAllocation>(pAllocationCallbacks)),
+    m_Header(VmaStlAllocator<char>(pAllocationCallbacks)),
+    m_CurrentCall(VmaStlAllocator<char>(pAllocationCallbacks)),
+    m_DumpedOnFailure(false)
+{
+}
+
+VkResult VmaRecorder::Init(const VmaRecordSettings& settings, bool useMutex)
+{
+    m_UseMutex = useMutex;
+    m_Flags = settings.flags;
+    if(settings.memoryTypeBits != 0)
+    {
+        m_MemoryTypeBits = settings.memoryTypeBits;
+    }
+    m_MinAllocationSize = settings.minAllocationSize;
+    if(settings.maxAllocationSize != 0)
+    {
+        m_MaxAllocationSize = settings.maxAllocationSize;
+    }
+    m_AllocationSamplingRate = VMA_MAX(settings.allocationSamplingRate, 1u);
+
+    if(settings.ringBufferSize > 0)
+    {
+        // Nothing is written to disk until the dump, so only remember the path.
+        m_pFilePath = VmaCreateStringCopy(m_pAllocationCallbacks, settings.pFilePath);
+        m_RingBufferSize = settings.ringBufferSize;
+        m_pRingBuffer = vma_new_array(m_pAllocationCallbacks, char, m_RingBufferSize);
+    }
+    else
+    {
+        m_File = OpenFile(settings.pFilePath);
+        if(m_File == VMA_NULL)
+        {
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+    }
+
+    // Write header.
+    Printf("%s\n", "Vulkan Memory Allocator,Calls recording");
+    Printf("%s\n", "1,13");
+
+    return VK_SUCCESS;
+}
+
+VmaRecorder::~VmaRecorder()
+{
+    if(m_File != VMA_NULL)
+    {
+        fclose(m_File);
+    }
+    vma_delete_array(m_pAllocationCallbacks, m_pRingBuffer, m_RingBufferSize);
+    VmaFreeString(m_pAllocationCallbacks, m_pFilePath);
+}
+
+VkResult VmaRecorder::Dump(const char* pFilePath)
+{
+    // Never wait - the mutex may be held by a thread that crashed while recording.
+    if(m_UseMutex && !m_FileMutex.TryLock())
+    {
+        return VK_NOT_READY;
+    }
+    const VkResult res = DumpRingBuffer(pFilePath != VMA_NULL ? pFilePath : m_pFilePath);
+    if(m_UseMutex)
+    {
+        m_FileMutex.Unlock();
+    }
+    return res;
+}
+
+void VmaRecorder::RecordCreateAllocator(uint32_t frameIndex)
+{
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaCreateAllocator\n", callParams.threadId, callParams.time, frameIndex);
+    Flush();
+}
+
+void VmaRecorder::RecordDestroyAllocator(uint32_t frameIndex)
+{
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaDestroyAllocator\n", callParams.threadId, callParams.time, frameIndex);
+    Flush();
+}
+
+void VmaRecorder::RecordCreatePool(uint32_t frameIndex, const VmaPoolCreateInfo& createInfo, VmaPool pool)
+{
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaCreatePool,%u,%u,%llu,%llu,%llu,%u,%p,%g\n", callParams.threadId, callParams.time, frameIndex,
+        createInfo.memoryTypeIndex,
+        createInfo.flags,
+        createInfo.blockSize,
+        (uint64_t)createInfo.minBlockCount,
+        (uint64_t)createInfo.maxBlockCount,
+        createInfo.frameInUseCount,
+        pool,
+        createInfo.priority);
+    AddLivePool(createInfo, pool);
+    Flush();
+}
+
+void VmaRecorder::RecordDestroyPool(uint32_t frameIndex, VmaPool pool)
+{
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaDestroyPool,%p\n", callParams.threadId, callParams.time, frameIndex,
+        pool);
+    RemoveLivePool(pool);
+    Flush();
+}
+
+void VmaRecorder::RecordAllocateMemory(uint32_t frameIndex,
+        const VkMemoryRequirements& vkMemReq,
+        const VmaAllocationCreateInfo& createInfo,
+        VmaAllocation allocation)
+{
+    if(!SelectAllocation(allocation))
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    UserDataString userDataStr(createInfo.flags, createInfo.pUserData);
+    Printf("%u,%.3f,%u,vmaAllocateMemory,%llu,%llu,%u,%u,%u,%u,%u,%u,%p,%p,%g,%u,%u,%s\n", callParams.threadId, callParams.time, frameIndex,
+        vkMemReq.size,
+        vkMemReq.alignment,
+        vkMemReq.memoryTypeBits,
+        createInfo.flags,
+        createInfo.usage,
+        createInfo.requiredFlags,
+        createInfo.preferredFlags,
+        createInfo.memoryTypeBits,
+        createInfo.pool,
+        allocation,
+        createInfo.priority,
+        createInfo.lifetime,
+        createInfo.tag,
+        userDataStr.GetString());
+    AddLiveAllocation(allocation, &createInfo);
+    PrintPlacement(callParams, frameIndex, allocation);
+    Flush(allocation == VK_NULL_HANDLE);
+}
+
+void VmaRecorder::RecordAllocateMemoryPages(uint32_t frameIndex,
+    const VkMemoryRequirements& vkMemReq,
+    const VmaAllocationCreateInfo& createInfo,
+    uint64_t allocationCount,
+    const VmaAllocation* pAllocations)
+{
+    // All pages share the decision made for the first one.
+    if(allocationCount > 0 && !SelectAllocation(pAllocations[0]))
+    {
+        for(uint64_t i = 1; i < allocationCount; ++i)
+        {
+            pAllocations[i]->SetNotRecorded();
+        }
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    UserDataString userDataStr(createInfo.flags, createInfo.pUserData);
+    Printf("%u,%.3f,%u,vmaAllocateMemoryPages,%llu,%llu,%u,%u,%u,%u,%u,%u,%p,", callParams.threadId, callParams.time, frameIndex,
+        vkMemReq.size,
+        vkMemReq.alignment,
+        vkMemReq.memoryTypeBits,
+        createInfo.flags,
+        createInfo.usage,
+        createInfo.requiredFlags,
+        createInfo.preferredFlags,
+        createInfo.memoryTypeBits,
+        createInfo.pool);
+    PrintAllocationList(allocationCount, pAllocations);
+    Printf(",%g,%u,%u,%s\n", createInfo.priority, createInfo.lifetime, createInfo.tag, userDataStr.GetString());
+    for(uint64_t i = 0; i < allocationCount; ++i)
+    {
+        AddLiveAllocation(pAllocations[i], &createInfo);
+        PrintPlacement(callParams, frameIndex, pAllocations[i]);
+    }
+    Flush(allocationCount > 0 && pAllocations[0] == VK_NULL_HANDLE);
+}
+
+void VmaRecorder::RecordAllocateMemoryBatch(uint32_t frameIndex,
+    const VkMemoryRequirements* pVkMemoryRequirements,
+    const VmaAllocationCreateInfo* pCreateInfos,
+    uint64_t allocationCount,
+    const VmaAllocation* pAllocations)
+{
+    // Unlike pages, each allocation is selected separately. All of them must be checked to mark ones not selected.
+    bool anySelected = false;
+    for(uint64_t i = 0; i < allocationCount; ++i)
+    {
+        if(SelectAllocation(pAllocations[i]))
+        {
+            anySelected = true;
+        }
+    }
+    if(!anySelected)
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    // Every parameter is a list of values separated with spaces, one for each recorded allocation.
+    static const uint32_t PARAMETER_COUNT = 13;
+    Printf("%u,%.3f,%u,vmaAllocateMemoryBatch", callParams.threadId, callParams.time, frameIndex);
+    for(uint32_t paramIndex = 0; paramIndex < PARAMETER_COUNT; ++paramIndex)
+    {
+        const char* separator = ",";
+        for(uint64_t i = 0; i < allocationCount; ++i)
+        {
+            if(!IsRecorded(pAllocations[i]))
+            {
+                continue;
+            }
+            Printf("%s", separator);
+            separator = " ";
+
+            const VkMemoryRequirements& vkMemReq = pVkMemoryRequirements[i];
+            const VmaAllocationCreateInfo& createInfo = pCreateInfos[i];
+            switch(paramIndex)
+            {
+            case 0:
+                Printf("%llu", vkMemReq.size);
+                break;
+            case 1:
+                Printf("%llu", vkMemReq.alignment);
+                break;
+            case 2:
+                Printf("%u", vkMemReq.memoryTypeBits);
+                break;
+            case 3:
+                Printf("%u", createInfo.flags);
+                break;
+            case 4:
+                Printf("%u", createInfo.usage);
+                break;
+            case 5:
+                Printf("%u", createInfo.requiredFlags);
+                break;
+            case 6:
+                Printf("%u", createInfo.preferredFlags);
+                break;
+            case 7:
+                Printf("%u", createInfo.memoryTypeBits);
+                break;
+            case 8:
+                Printf("%p", createInfo.pool);
+                break;
+            case 9:
+                Printf("%p", pAllocations[i]);
+                break;
+            case 10:
+                Printf("%g", createInfo.priority);
+                break;
+            case 11:
+                Printf("%u", createInfo.lifetime);
+                break;
+            case 12:
+                Printf("%u", createInfo.tag);
+                break;
+            default:
+                VMA_ASSERT(0);
+            }
+        }
+    }
+    Printf("\n");
+    for(uint64_t i = 0; i < allocationCount; ++i)
+    {
+        if(IsRecorded(pAllocations[i]))
+        {
+            AddLiveAllocation(pAllocations[i], &pCreateInfos[i]);
+            PrintPlacement(callParams, frameIndex, pAllocations[i]);
+        }
+    }
+    // User data may contain commas, so it can't be a list. It is set by following lines, after placement.
+    for(uint64_t i = 0; i < allocationCount; ++i)
+    {
+        if(pAllocations[i] != VK_NULL_HANDLE && IsRecorded(pAllocations[i]) && pCreateInfos[i].pUserData != VMA_NULL)
+        {
+            UserDataString userDataStr(pCreateInfos[i].flags, pCreateInfos[i].pUserData);
+            Printf("%u,%.3f,%u,vmaSetAllocationUserData,%p,%s\n", callParams.threadId, callParams.time, frameIndex,
+                pAllocations[i],
+                userDataStr.GetString());
+        }
+    }
+    Flush(allocationCount > 0 && pAllocations[0] == VK_NULL_HANDLE);
+}
+
+void VmaRecorder::RecordAllocateMemoryForBuffer(uint32_t frameIndex,
+    const VkMemoryRequirements& vkMemReq,
+    bool requiresDedicatedAllocation,
+    bool prefersDedicatedAllocation,
+    const VmaAllocationCreateInfo& createInfo,
+    VmaAllocation allocation)
+{
+    if(!SelectAllocation(allocation))
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    UserDataString userDataStr(createInfo.flags, createInfo.pUserData);
+    Printf("%u,%.3f,%u,vmaAllocateMemoryForBuffer,%llu,%llu,%u,%u,%u,%u,%u,%u,%u,%u,%p,%p,%g,%u,%u,%s\n", callParams.threadId, callParams.time, frameIndex,
+        vkMemReq.size,
+        vkMemReq.alignment,
+        vkMemReq.memoryTypeBits,
+        requiresDedicatedAllocation ? 1 : 0,
+        prefersDedicatedAllocation ? 1 : 0,
+        createInfo.flags,
+        createInfo.usage,
+        createInfo.requiredFlags,
+        createInfo.preferredFlags,
+        createInfo.memoryTypeBits,
+        createInfo.pool,
+        allocation,
+        createInfo.priority,
+        createInfo.lifetime,
+        createInfo.tag,
+        userDataStr.GetString());
+    AddLiveAllocation(allocation, &createInfo);
+    PrintPlacement(callParams, frameIndex, allocation);
+    Flush(allocation == VK_NULL_HANDLE);
+}
+
+void VmaRecorder::RecordAllocateMemoryForImage(uint32_t frameIndex,
+    const VkMemoryRequirements& vkMemReq,
+    bool requiresDedicatedAllocation,
+    bool prefersDedicatedAllocation,
+    const VmaAllocationCreateInfo& createInfo,
+    VmaAllocation allocation)
+{
+    if(!SelectAllocation(allocation))
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    UserDataString userDataStr(createInfo.flags, createInfo.pUserData);
+    Printf("%u,%.3f,%u,vmaAllocateMemoryForImage,%llu,%llu,%u,%u,%u,%u,%u,%u,%u,%u,%p,%p,%g,%u,%u,%s\n", callParams.threadId, callParams.time, frameIndex,
+        vkMemReq.size,
+        vkMemReq.alignment,
+        vkMemReq.memoryTypeBits,
+        requiresDedicatedAllocation ? 1 : 0,
+        prefersDedicatedAllocation ? 1 : 0,
+        createInfo.flags,
+        createInfo.usage,
+        createInfo.requiredFlags,
+        createInfo.preferredFlags,
+        createInfo.memoryTypeBits,
+        createInfo.pool,
+        allocation,
+        createInfo.priority,
+        createInfo.lifetime,
+        createInfo.tag,
+        userDataStr.GetString());
+    AddLiveAllocation(allocation, &createInfo);
+    PrintPlacement(callParams, frameIndex, allocation);
+    Flush(allocation == VK_NULL_HANDLE);
+}
+
+void VmaRecorder::RecordFreeMemory(uint32_t frameIndex,
+    VmaAllocation allocation)
+{
+    if(!IsRecorded(allocation))
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaFreeMemory,%p\n", callParams.threadId, callParams.time, frameIndex,
+        allocation);
+    RemoveLiveAllocation(allocation);
+    Flush();
+}
+
+void VmaRecorder::RecordFreeMemoryPages(uint32_t frameIndex,
+    uint64_t allocationCount,
+    const VmaAllocation* pAllocations)
+{
+    bool anyRecorded = false;
+    for(uint64_t i = 0; i < allocationCount && !anyRecorded; ++i)
+    {
+        anyRecorded = IsRecorded(pAllocations[i]);
+    }
+    if(!anyRecorded)
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaFreeMemoryPages,", callParams.threadId, callParams.time, frameIndex);
+    PrintAllocationList(allocationCount, pAllocations);
+    Printf("\n");
+    for(uint64_t i = 0; i < allocationCount; ++i)
+    {
+        RemoveLiveAllocation(pAllocations[i]);
+    }
+    Flush();
+}
+
+void VmaRecorder::RecordResizeAllocation(uint32_t frameIndex,
+    VmaAllocation allocation,
+    VkDeviceSize newSize)
+{
+    if(!IsRecorded(allocation))
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaResizeAllocation,%p,%llu\n", callParams.threadId, callParams.time, frameIndex,
+        allocation, newSize);
+    const uint32_t liveIndex = allocation->GetIndexInRecorder();
+    if(liveIndex != UINT32_MAX)
+    {
+        m_LiveAllocations[liveIndex].size = newSize;
+    }
+    Flush();
+}
+
+void VmaRecorder::RecordSetAllocationUserData(uint32_t frameIndex,
+    VmaAllocation allocation,
+    const void* pUserData)
+{
+    if(!IsRecorded(allocation))
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    UserDataString userDataStr(
+        allocation->IsUserDataString() ? VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT : 0,
+        pUserData);
+    Printf("%u,%.3f,%u,vmaSetAllocationUserData,%p,%s\n", callParams.threadId, callParams.time, frameIndex,
+        allocation,
+        userDataStr.GetString());
+    Flush();
+}
+
+void VmaRecorder::RecordCreateLostAllocation(uint32_t frameIndex,
+    VmaAllocation allocation)
+{
+    if(!SelectAllocation(allocation))
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaCreateLostAllocation,%p\n", callParams.threadId, callParams.time, frameIndex,
+        allocation);
+    AddLiveAllocation(allocation, VMA_NULL);
+    Flush();
+}
 
 void VmaRecorder::RecordMapMemory(uint32_t frameIndex,
     VmaAllocation allocation)
 {
-    CallParams callParams;
-    GetBasicParams(callParams);
+    if(!IsRecorded(allocation))
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaMapMemory,%p\n", callParams.threadId, callParams.time, frameIndex,
+        allocation);
+    Flush();
+}
+
+void VmaRecorder::RecordUnmapMemory(uint32_t frameIndex,
+    VmaAllocation allocation)
+{
+    if(!IsRecorded(allocation))
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaUnmapMemory,%p\n", callParams.threadId, callParams.time, frameIndex,
+        allocation);
+    Flush();
+}
+
+void VmaRecorder::RecordFlushAllocation(uint32_t frameIndex,
+    VmaAllocation allocation, VkDeviceSize offset, VkDeviceSize size)
+{
+    if(!IsRecorded(allocation))
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaFlushAllocation,%p,%llu,%llu\n", callParams.threadId, callParams.time, frameIndex,
+        allocation,
+        offset,
+        size);
+    Flush();
+}
+
+void VmaRecorder::RecordInvalidateAllocation(uint32_t frameIndex,
+    VmaAllocation allocation, VkDeviceSize offset, VkDeviceSize size)
+{
+    if(!IsRecorded(allocation))
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaInvalidateAllocation,%p,%llu,%llu\n", callParams.threadId, callParams.time, frameIndex,
+        allocation,
+        offset,
+        size);
+    Flush();
+}
+
+void VmaRecorder::RecordCreateBuffer(uint32_t frameIndex,
+    const VkBufferCreateInfo& bufCreateInfo,
+    const VmaAllocationCreateInfo& allocCreateInfo,
+    VmaAllocation allocation)
+{
+    if(!SelectAllocation(allocation))
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    UserDataString userDataStr(allocCreateInfo.flags, allocCreateInfo.pUserData);
+    Printf("%u,%.3f,%u,vmaCreateBuffer,%u,%llu,%u,%u,%u,%u,%u,%u,%u,%p,%p,%g,%u,%u,%s\n", callParams.threadId, callParams.time, frameIndex,
+        bufCreateInfo.flags,
+        bufCreateInfo.size,
+        bufCreateInfo.usage,
+        bufCreateInfo.sharingMode,
+        allocCreateInfo.flags,
+        allocCreateInfo.usage,
+        allocCreateInfo.requiredFlags,
+        allocCreateInfo.preferredFlags,
+        allocCreateInfo.memoryTypeBits,
+        allocCreateInfo.pool,
+        allocation,
+        allocCreateInfo.priority,
+        allocCreateInfo.lifetime,
+        allocCreateInfo.tag,
+        userDataStr.GetString());
+    AddLiveAllocation(allocation, &allocCreateInfo);
+    PrintPlacement(callParams, frameIndex, allocation);
+    Flush(allocation == VK_NULL_HANDLE);
+}
+
+void VmaRecorder::RecordCreateImage(uint32_t frameIndex,
+    const VkImageCreateInfo& imageCreateInfo,
+    const VmaAllocationCreateInfo& allocCreateInfo,
+    VmaAllocation allocation)
+{
+    if(!SelectAllocation(allocation))
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    UserDataString userDataStr(allocCreateInfo.flags, allocCreateInfo.pUserData);
+    Printf("%u,%.3f,%u,vmaCreateImage,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%p,%p,%g,%u,%u,%s\n", callParams.threadId, callParams.time, frameIndex,
+        imageCreateInfo.flags,
+        imageCreateInfo.imageType,
+        imageCreateInfo.format,
+        imageCreateInfo.extent.width,
+        imageCreateInfo.extent.height,
+        imageCreateInfo.extent.depth,
+        imageCreateInfo.mipLevels,
+        imageCreateInfo.arrayLayers,
+        imageCreateInfo.samples,
+        imageCreateInfo.tiling,
+        imageCreateInfo.usage,
+        imageCreateInfo.sharingMode,
+        imageCreateInfo.initialLayout,
+        allocCreateInfo.flags,
+        allocCreateInfo.usage,
+        allocCreateInfo.requiredFlags,
+        allocCreateInfo.preferredFlags,
+        allocCreateInfo.memoryTypeBits,
+        allocCreateInfo.pool,
+        allocation,
+        allocCreateInfo.priority,
+        allocCreateInfo.lifetime,
+        allocCreateInfo.tag,
+        userDataStr.GetString());
+    AddLiveAllocation(allocation, &allocCreateInfo);
+    PrintPlacement(callParams, frameIndex, allocation);
+    Flush(allocation == VK_NULL_HANDLE);
+}
+
+void VmaRecorder::RecordDestroyBuffer(uint32_t frameIndex,
+    VmaAllocation allocation)
+{
+    if(!IsRecorded(allocation))
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaDestroyBuffer,%p\n", callParams.threadId, callParams.time, frameIndex,
+        allocation);
+    RemoveLiveAllocation(allocation);
+    Flush();
+}
+
+void VmaRecorder::RecordDestroyImage(uint32_t frameIndex,
+    VmaAllocation allocation)
+{
+    if(!IsRecorded(allocation))
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaDestroyImage,%p\n", callParams.threadId, callParams.time, frameIndex,
+        allocation);
+    RemoveLiveAllocation(allocation);
+    Flush();
+}
+
+void VmaRecorder::RecordTouchAllocation(uint32_t frameIndex,
+    VmaAllocation allocation)
+{
+    if(!IsRecorded(allocation))
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaTouchAllocation,%p\n", callParams.threadId, callParams.time, frameIndex,
+        allocation);
+    Flush();
+}
+
+void VmaRecorder::RecordGetAllocationInfo(uint32_t frameIndex,
+    VmaAllocation allocation)
+{
+    if(!IsRecorded(allocation))
+    {
+        return;
+    }
+
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaGetAllocationInfo,%p\n", callParams.threadId, callParams.time, frameIndex,
+        allocation);
+    Flush();
+}
+
+void VmaRecorder::RecordMakePoolAllocationsLost(uint32_t frameIndex,
+    VmaPool pool)
+{
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaMakePoolAllocationsLost,%p\n", callParams.threadId, callParams.time, frameIndex,
+        pool);
+    Flush();
+}
+
+void VmaRecorder::RecordDefragmentationBegin(uint32_t frameIndex,
+    const VmaDefragmentationInfo2& info,
+    VmaDefragmentationContext ctx)
+{
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaDefragmentationBegin,%u,", callParams.threadId, callParams.time, frameIndex,
+        info.flags);
+    PrintAllocationList(info.allocationCount, info.pAllocations);
+    Printf(",");
+    PrintPointerList(info.poolCount, info.pPools);
+    Printf(",%llu,%u,%llu,%u,%p,%p\n",
+        info.maxCpuBytesToMove,
+        info.maxCpuAllocationsToMove,
+        info.maxGpuBytesToMove,
+        info.maxGpuAllocationsToMove,
+        info.commandBuffer,
+        ctx);
+    Flush();
+}
+
+void VmaRecorder::RecordDefragmentationEnd(uint32_t frameIndex,
+    VmaDefragmentationContext ctx)
+{
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaDefragmentationEnd,%p\n", callParams.threadId, callParams.time, frameIndex,
+        ctx);
+    Flush();
+}
+
+void VmaRecorder::RecordSetPoolName(uint32_t frameIndex,
+    VmaPool pool,
+    const char* name)
+{
+    CallParams callParams;
+    GetBasicParams(callParams);
+
+    VmaMutexLock lock(m_FileMutex, m_UseMutex);
+    Printf("%u,%.3f,%u,vmaSetPoolName,%p,%s\n", callParams.threadId, callParams.time, frameIndex,
+        pool, name != VMA_NULL ? name : "");
+    Flush();
+}
+
+VmaRecorder::UserDataString::UserDataString(VmaAllocationCreateFlags allocFlags, const void* pUserData)
+{
+    if(pUserData != VMA_NULL)
+    {
+        if((allocFlags & VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT) != 0)
+        {
+            m_Str = (const char*)pUserData;
+        }
+        else
+        {
+            // If VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT is not specified, convert the string's memory address to a string and store it.
+            snprintf(m_PtrStr, 17, "%p", pUserData);
+            m_Str = m_PtrStr;
+        }
+    }
+    else
+    {
+        m_Str = "";
+    }
+}
+
+void VmaRecorder::WriteConfiguration(
+    const VkPhysicalDeviceProperties& devProps,
+    const VkPhysicalDeviceMemoryProperties& memProps,
+    uint32_t vulkanApiVersion,
+    bool dedicatedAllocationExtensionEnabled,
+    bool bindMemory2ExtensionEnabled,
+    bool memoryBudgetExtensionEnabled,
+    bool deviceCoherentMemoryExtensionEnabled)
+{
+    Printf("Config,Begin\n");
+
+    Printf("VulkanApiVersion,%u,%u\n", VK_VERSION_MAJOR(vulkanApiVersion), VK_VERSION_MINOR(vulkanApiVersion));
+
+    Printf("PhysicalDevice,apiVersion,%u\n", devProps.apiVersion);
+    Printf("PhysicalDevice,driverVersion,%u\n", devProps.driverVersion);
+    Printf("PhysicalDevice,vendorID,%u\n", devProps.vendorID);
+    Printf("PhysicalDevice,deviceID,%u\n", devProps.deviceID);
+    Printf("PhysicalDevice,deviceType,%u\n", devProps.deviceType);
+    Printf("PhysicalDevice,deviceName,%s\n", devProps.deviceName);
+
+    Printf("PhysicalDeviceLimits,maxMemoryAllocationCount,%u\n", devProps.limits.maxMemoryAllocationCount);
+    Printf("PhysicalDeviceLimits,bufferImageGranularity,%llu\n", devProps.limits.bufferImageGranularity);
+    Printf("PhysicalDeviceLimits,nonCoherentAtomSize,%llu\n", devProps.limits.nonCoherentAtomSize);
+
+    Printf("PhysicalDeviceMemory,HeapCount,%u\n", memProps.memoryHeapCount);
+    for(uint32_t i = 0; i < memProps.memoryHeapCount; ++i)
+    {
+        Printf("PhysicalDeviceMemory,Heap,%u,size,%llu\n", i, memProps.memoryHeaps[i].size);
+        Printf("PhysicalDeviceMemory,Heap,%u,flags,%u\n", i, memProps.memoryHeaps[i].flags);
+    }
+    Printf("PhysicalDeviceMemory,TypeCount,%u\n", memProps.memoryTypeCount);
+    for(uint32_t i = 0; i < memProps.memoryTypeCount; ++i)
+    {
+        Printf("PhysicalDeviceMemory,Type,%u,heapIndex,%u\n", i, memProps.memoryTypes[i].heapIndex);
+        Printf("PhysicalDeviceMemory,Type,%u,propertyFlags,%u\n", i, memProps.memoryTypes[i].propertyFlags);
+    }
+
+    Printf("Extension,VK_KHR_dedicated_allocation,%u\n", dedicatedAllocationExtensionEnabled ? 1 : 0);
+    Printf("Extension,VK_KHR_bind_memory2,%u\n", bindMemory2ExtensionEnabled ? 1 : 0);
+    Printf("Extension,VK_EXT_memory_budget,%u\n", memoryBudgetExtensionEnabled ? 1 : 0);
+    Printf("Extension,VK_AMD_device_coherent_memory,%u\n", deviceCoherentMemoryExtensionEnabled ? 1 : 0);
+
+    Printf("Macro,VMA_DEBUG_ALWAYS_DEDICATED_MEMORY,%u\n", VMA_DEBUG_ALWAYS_DEDICATED_MEMORY ? 1 : 0);
+    Printf("Macro,VMA_DEBUG_ALIGNMENT,%llu\n", (VkDeviceSize)VMA_DEBUG_ALIGNMENT);
+    Printf("Macro,VMA_DEBUG_MARGIN,%llu\n", (VkDeviceSize)VMA_DEBUG_MARGIN);
+    Printf("Macro,VMA_DEBUG_INITIALIZE_ALLOCATIONS,%u\n", VMA_DEBUG_INITIALIZE_ALLOCATIONS ? 1 : 0);
+    Printf("Macro,VMA_DEBUG_DETECT_CORRUPTION,%u\n", VMA_DEBUG_DETECT_CORRUPTION ? 1 : 0);
+    Printf("Macro,VMA_DEBUG_GLOBAL_MUTEX,%u\n", VMA_DEBUG_GLOBAL_MUTEX ? 1 : 0);
+    Printf("Macro,VMA_DEBUG_MIN_BUFFER_IMAGE_GRANULARITY,%llu\n", (VkDeviceSize)VMA_DEBUG_MIN_BUFFER_IMAGE_GRANULARITY);
+    Printf("Macro,VMA_SMALL_HEAP_MAX_SIZE,%llu\n", (VkDeviceSize)VMA_SMALL_HEAP_MAX_SIZE);
+    Printf("Macro,VMA_DEFAULT_LARGE_HEAP_BLOCK_SIZE,%llu\n", (VkDeviceSize)VMA_DEFAULT_LARGE_HEAP_BLOCK_SIZE);
+
+    Printf("Config,End\n");
+
+    if(m_pRingBuffer != VMA_NULL)
+    {
+        // Header and configuration must survive in every dump, so they are kept aside of the ring buffer.
+        m_Header.resize(m_CurrentCall.size());
+        memcpy(m_Header.data(), m_CurrentCall.data(), m_CurrentCall.size());
+        m_CurrentCall.clear();
+    }
+}
+
+FILE* VmaRecorder::OpenFile(const char* pFilePath)
+{
+    FILE* file = VMA_NULL;
+#if defined(_WIN32)
+    if(fopen_s(&file, pFilePath, "wb") != 0)
+    {
+        return VMA_NULL;
+    }
+#else
+    file = fopen(pFilePath, "wb");
+#endif
+    return file;
+}
+
+void VmaRecorder::GetBasicParams(CallParams& outParams)
+{
+    #if defined(_WIN32)
+        outParams.threadId = GetCurrentThreadId();
+    #else
+        // Use C++11 features to get thread id and convert it to uint32_t.
+        // There is room for optimization since sstream is quite slow.
+        // Is there a better way to convert std::this_thread::get_id() to uint32_t?
+        std::thread::id thread_id = std::this_thread::get_id();
+        stringstream thread_id_to_string_converter;
+        thread_id_to_string_converter << thread_id;
+        string thread_id_as_string = thread_id_to_string_converter.str();
+        outParams.threadId = static_cast<uint32_t>(std::stoi(thread_id_as_string.c_str()));
+    #endif
+
+    auto current_time = std::chrono::high_resolution_clock::now();
+
+    outParams.time = std::chrono::duration<double, std::chrono::seconds::period>(current_time - m_RecordingStartTime).count();
+}
+
+void VmaRecorder::PrintAllocationList(uint64_t count, const VmaAllocation* pItems)
+{
+    bool first = true;
+    for(uint64_t i = 0; i < count; ++i)
+    {
+        if(IsRecorded(pItems[i]))
+        {
+            Printf(first ? "%p" : " %p", pItems[i]);
+            first = false;
+        }
+    }
+}
+
+void VmaRecorder::Printf(const char* format, ...)
+{
+    va_list argList;
+    va_start(argList, format);
+    if(m_pRingBuffer == VMA_NULL)
+    {
+        vfprintf(m_File, format, argList);
+    }
+    else
+    {
+        // Most calls fit in the local buffer, so formatting twice is rarely needed.
+        char localBuf[256];
+        va_list argListCopy;
+        va_copy(argListCopy, argList);
+        const int length = vsnprintf(localBuf, sizeof(localBuf), format, argListCopy);
+        va_end(argListCopy);
+        if(length > 0)
+        {
+            const size_t oldSize = m_CurrentCall.size();
+            if((size_t)length < sizeof(localBuf))
+            {
+                m_CurrentCall.resize(oldSize + length);
+                memcpy(m_CurrentCall.data() + oldSize, localBuf, length);
+            }
+            else
+            {
+                // +1 for null terminator written by vsnprintf.
+                m_CurrentCall.resize(oldSize + length + 1);
+                vsnprintf(m_CurrentCall.data() + oldSize, length + 1, format, argList);
+                m_CurrentCall.resize(oldSize + length);
+            }
+        }
+    }
+    va_end(argList);
+}
+
+bool VmaRecorder::SelectAllocation(VmaAllocation allocation)
+{
+    // Failed allocations are always recorded.
+    if(allocation == VK_NULL_HANDLE)
+    {
+        return true;
+    }
+
+    bool selected = ((1u << allocation->GetMemoryTypeIndex()) & m_MemoryTypeBits) != 0 &&
+        allocation->GetSize() >= m_MinAllocationSize &&
+        allocation->GetSize() <= m_MaxAllocationSize;
+    if(selected && (m_Flags & VMA_RECORD_SELECTED_POOLS_ONLY_BIT) != 0)
+    {
+        // Lost allocation has no block.
+        const VmaPool pool = (allocation->GetType() == VmaAllocation_T::ALLOCATION_TYPE_BLOCK && allocation->GetBlock() != VMA_NULL) ?
+            allocation->GetBlock()->GetParentPool() : VK_NULL_HANDLE;
+        selected = pool != VK_NULL_HANDLE && pool->IsRecordingEnabled();
+    }
+    if(selected && m_AllocationSamplingRate > 1)
+    {
+        // Fibonacci hashing of the handle, so allocations from consecutive addresses are spread evenly.
+        const uint64_t hash = (uint64_t)(uintptr_t)allocation * 0x9E3779B97F4A7C15ull;
+        selected = (uint32_t)(hash >> 32) % m_AllocationSamplingRate == 0;
+    }
+
+    if(!selected)
+    {
+        allocation->SetNotRecorded();
+    }
+    return selected;
+}
+
+void VmaRecorder::PrintPlacement(const CallParams& callParams, uint32_t frameIndex, VmaAllocation allocation)
+{
+    if((m_Flags & VMA_RECORD_ALLOCATION_PLACEMENT_BIT) == 0 || allocation == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    // Dedicated allocation always gets its own new "block".
+    const bool dedicated = allocation->GetType() == VmaAllocation_T::ALLOCATION_TYPE_DEDICATED;
+    VmaPool pool = VK_NULL_HANDLE;
+    uint32_t blockId = 0;
+    VkDeviceSize blockSize = allocation->GetSize();
+    if(!dedicated)
+    {
+        VmaDeviceMemoryBlock* const pBlock = allocation->GetBlock();
+        pool = pBlock->GetParentPool();
+        blockId = pBlock->GetId();
+        blockSize = pBlock->m_pMetadata->GetSize();
+    }
+    Printf("%u,%.3f,%u,AllocationPlacement,%p,%u,%u,%p,%u,%llu,%u,%llu\n", callParams.threadId, callParams.time, frameIndex,
+        allocation,
+        allocation->GetMemoryTypeIndex(),
+        dedicated ? 1 : 0,
+        pool,
+        blockId,
+        allocation->GetOffset(),
+        (dedicated || allocation->HasCreatedBlock()) ? 1 : 0,
+        blockSize);
+}
+
+void VmaRecorder::Flush(bool allocationFailed)
+{
+    if(m_pRingBuffer != VMA_NULL)
+    {
+        PushCurrentCallToRingBuffer();
+        if(allocationFailed &&
+            (m_Flags & VMA_RECORD_DUMP_ON_ALLOCATION_FAILURE_BIT) != 0 &&
+            !m_DumpedOnFailure)
+        {
+            m_DumpedOnFailure = true;
+            DumpRingBuffer(m_pFilePath);
+        }
+    }
+    else if((m_Flags & VMA_RECORD_FLUSH_AFTER_CALL_BIT) != 0)
+    {
+        fflush(m_File);
+    }
+}
+
+void VmaRecorder::PushCurrentCallToRingBuffer()
+{
+    const size_t callSize = m_CurrentCall.size();
+    ++m_PushedCallCount;
+    if(callSize > m_RingBufferSize)
+    {
+        // Doesn't fit even into empty buffer - skip it and evict all older calls,
+        // so the dump doesn't have a gap. Objects created by them go to the snapshot.
+        m_RingBegin = 0;
+        m_RingUsed = 0;
+        m_RingCallBegin = 0;
+        m_RingCallCount = 0;
+        m_CurrentCall.clear();
+        return;
+    }
+
+    // Evict oldest calls, always whole ones, to make space.
+    while(m_RingUsed + callSize > m_RingBufferSize)
+    {
+        VMA_HEAVY_ASSERT(m_RingCallCount > 0);
+        const size_t evictedSize = m_RingCallSizes[m_RingCallBegin];
+        VMA_HEAVY_ASSERT(evictedSize <= m_RingUsed);
+        m_RingBegin = (m_RingBegin + evictedSize) % m_RingBufferSize;
+        m_RingUsed -= evictedSize;
+        m_RingCallBegin = (m_RingCallBegin + 1) % m_RingCallSizes.size();
+        --m_RingCallCount;
+    }
+
+    if(m_RingCallCount == m_RingCallSizes.size())
+    {
+        // Grow the queue. Sizes that wrapped around to the beginning are moved after the old end.
+        const size_t oldCapacity = m_RingCallSizes.size();
+        m_RingCallSizes.resize(VMA_MAX(oldCapacity * 2, (size_t)64));
+        for(size_t i = 0; i < m_RingCallBegin; ++i)
+        {
+            m_RingCallSizes[oldCapacity + i] = m_RingCallSizes[i];
+        }
+    }
+    m_RingCallSizes[(m_RingCallBegin + m_RingCallCount) % m_RingCallSizes.size()] = callSize;
+    ++m_RingCallCount;
+
+    const size_t writeOffset = (m_RingBegin + m_RingUsed) % m_RingBufferSize;
+    const size_t firstPartSize = VMA_MIN(callSize, m_RingBufferSize - writeOffset);
+    memcpy(m_pRingBuffer + writeOffset, m_CurrentCall.data(), firstPartSize);
+    if(firstPartSize < callSize)
+    {
+        memcpy(m_pRingBuffer, m_CurrentCall.data() + firstPartSize, callSize - firstPartSize);
+    }
+    m_RingUsed += callSize;
+    m_CurrentCall.clear();
+}
+
+VkResult VmaRecorder::DumpRingBuffer(const char* pFilePath)
+{
+    if(m_pRingBuffer == VMA_NULL)
+    {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    FILE* const file = OpenFile(pFilePath);
+    if(file == VMA_NULL)
+    {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    fwrite(m_Header.data(), 1, m_Header.size(), file);
+    WriteSnapshot(file);
+    const size_t firstPartSize = VMA_MIN(m_RingUsed, m_RingBufferSize - m_RingBegin);
+    fwrite(m_pRingBuffer + m_RingBegin, 1, firstPartSize, file);
+    fwrite(m_pRingBuffer, 1, m_RingUsed - firstPartSize, file);
+
+    const bool success = ferror(file) == 0;
+    fclose(file);
+    return success ? VK_SUCCESS : VK_ERROR_INITIALIZATION_FAILED;
+}
+
+void VmaRecorder::AddLivePool(const VmaPoolCreateInfo& createInfo, VmaPool pool)
+{
+    if(m_pRingBuffer == VMA_NULL || pool == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    LivePool livePool = {};
+    livePool.pool = pool;
+    livePool.callIndex = m_PushedCallCount;
+    livePool.createInfo = createInfo;
+    m_LivePools.push_back(livePool);
+}
+
+void VmaRecorder::RemoveLivePool(VmaPool pool)
+{
+    for(size_t i = 0; i < m_LivePools.size(); ++i)
+    {
+        if(m_LivePools[i].pool == pool)
+        {
+            m_LivePools[i] = m_LivePools.back();
+            m_LivePools.pop_back();
+            return;
+        }
+    }
+}
+
+void VmaRecorder::AddLiveAllocation(VmaAllocation allocation, const VmaAllocationCreateInfo* pCreateInfo)
+{
+    if(m_pRingBuffer == VMA_NULL || allocation == VK_NULL_HANDLE)
+    {
+        return;
+    }
+    VMA_ASSERT(allocation->GetIndexInRecorder() == UINT32_MAX);
+
+    // Remember what is needed to create the same allocation again, not the original request,
+    // so replay of the snapshot ends up in the same memory type and kind of memory.
+    LiveAllocation liveAlloc = {};
+    liveAlloc.allocation = allocation;
+    liveAlloc.callIndex = m_PushedCallCount;
+    liveAlloc.lost = pCreateInfo == VMA_NULL;
+    if(!liveAlloc.lost)
+    {
+        liveAlloc.size = allocation->GetSize();
+        liveAlloc.alignment = allocation->GetAlignment();
+        liveAlloc.pool = pCreateInfo->pool;
+        liveAlloc.flags = pCreateInfo->flags &
+            ~(VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT | VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT);
+        if(allocation->GetType() == VmaAllocation_T::ALLOCATION_TYPE_DEDICATED)
+        {
+            liveAlloc.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+        }
+        liveAlloc.priority = pCreateInfo->priority;
+        liveAlloc.memoryTypeIndex = allocation->GetMemoryTypeIndex();
+        liveAlloc.lifetime = pCreateInfo->lifetime;
+        liveAlloc.tag = pCreateInfo->tag;
+    }
+    allocation->SetIndexInRecorder((uint32_t)m_LiveAllocations.size());
+    m_LiveAllocations.push_back(liveAlloc);
+}
+
+void VmaRecorder::RemoveLiveAllocation(VmaAllocation allocation)
+{
+    if(allocation == VK_NULL_HANDLE || allocation->GetIndexInRecorder() == UINT32_MAX)
+    {
+        return;
+    }
+
+    const uint32_t index = allocation->GetIndexInRecorder();
+    VMA_ASSERT(index < m_LiveAllocations.size() && m_LiveAllocations[index].allocation == allocation);
+    // Move the last allocation into the freed slot.
+    m_LiveAllocations[index] = m_LiveAllocations.back();
+    m_LiveAllocations[index].allocation->SetIndexInRecorder(index);
+    m_LiveAllocations.pop_back();
+    allocation->SetIndexInRecorder(UINT32_MAX);
+}
+
+void VmaRecorder::WriteSnapshot(FILE* file)
+{
+    // Objects created by calls that are still in the ring buffer are created there.
+    // Pools go first, because allocations may refer to them. Calls have thread 0, time 0, frame 0, and no user data.
+    // Every call is formatted with Printf() to m_CurrentCall, which is empty between calls.
+    VMA_ASSERT(m_CurrentCall.empty());
+    const uint64_t firstRingCallIndex = m_PushedCallCount - m_RingCallCount;
+    for(size_t i = 0; i < m_LivePools.size(); ++i)
+    {
+        const LivePool& livePool = m_LivePools[i];
+        if(livePool.callIndex < firstRingCallIndex)
+        {
+            const VmaPoolCreateInfo& createInfo = livePool.createInfo;
+            Printf("0,0.000,0,vmaCreatePool,%u,%u,%llu,%llu,%llu,%u,%p,%g\n",
+                createInfo.memoryTypeIndex,
+                createInfo.flags,
+                createInfo.blockSize,
+                (uint64_t)createInfo.minBlockCount,
+                (uint64_t)createInfo.maxBlockCount,
+                createInfo.frameInUseCount,
+                livePool.pool,
+                createInfo.priority);
+            fwrite(m_CurrentCall.data(), 1, m_CurrentCall.size(), file);
+            m_CurrentCall.clear();
+        }
+    }
+    for(size_t i = 0; i < m_LiveAllocations.size(); ++i)
+    {
+        const LiveAllocation& liveAlloc = m_LiveAllocations[i];
+        if(liveAlloc.callIndex >= firstRingCallIndex)
+        {
+            continue;
+        }
+        if(liveAlloc.lost)
+        {
+            Printf("0,0.000,0,vmaCreateLostAllocation,%p\n", liveAlloc.allocation);
+        }
+        else
+        {
+            // Memory type chosen originally is the only one allowed.
+            Printf("0,0.000,0,vmaAllocateMemory,%llu,%llu,%u,%u,%u,%u,%u,%u,%p,%p,%g,%u,%u,\n",
+                liveAlloc.size,
+                liveAlloc.alignment,
+                1u << liveAlloc.memoryTypeIndex,
+                liveAlloc.flags,
+                (uint32_t)VMA_MEMORY_USAGE_UNKNOWN,
+                0u, // requiredFlags
+                0u, // preferredFlags
+                0u, // memoryTypeBits
+                liveAlloc.pool,
+                liveAlloc.allocation,
+                liveAlloc.priority,
+                liveAlloc.lifetime,
+                liveAlloc.tag);
+        }
+        fwrite(m_CurrentCall.data(), 1, m_CurrentCall.size(), file);
+        m_CurrentCall.clear();
+    }
+}
+
+#endif // #if VMA_RECORDING_ENABLED
+
+////////////////////////////////////////////////////////////////////////////////
+// VmaAllocationObjectAllocator
+
+VmaAllocationObjectAllocator::VmaAllocationObjectAllocator(const VkAllocationCallbacks* pAllocationCallbacks) :
+    m_Allocator(pAllocationCallbacks, 1024)
+{
+}
+
+template<typename... Types> VmaAllocation VmaAllocationObjectAllocator::Allocate(Types... args)
+{
+    VmaMutexLock mutexLock(m_Mutex);
+    return m_Allocator.Alloc<Types...>(std::forward<Types>(args)...);
+}
+
+void VmaAllocationObjectAllocator::Free(VmaAllocation hAlloc)
+{
+    VmaMutexLock mutexLock(m_Mutex);
+    m_Allocator.Free(hAlloc);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// VmaAllocator_T
+
+VmaAllocator_T::VmaAllocator_T(const VmaAllocatorCreateInfo* pCreateInfo) :
+    m_UseMutex((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_EXTERNALLY_SYNCHRONIZED_BIT) == 0),
+    m_VulkanApiVersion(pCreateInfo->vulkanApiVersion != 0 ? pCreateInfo->vulkanApiVersion : VK_API_VERSION_1_0),
+    m_UseKhrDedicatedAllocation((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_KHR_DEDICATED_ALLOCATION_BIT) != 0),
+    m_UseKhrBindMemory2((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_KHR_BIND_MEMORY2_BIT) != 0),
+    m_UseExtMemoryBudget((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT) != 0),
+    m_UseAmdDeviceCoherentMemory((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_AMD_DEVICE_COHERENT_MEMORY_BIT) != 0),
+    m_UseKhrBufferDeviceAddress((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT) != 0),
+    m_UseExtExternalMemoryHost((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_EXT_EXTERNAL_MEMORY_HOST_BIT) != 0),
+    m_UseExtMemoryPriority((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_EXT_MEMORY_PRIORITY_BIT) != 0),
+    m_UseExtPageableDeviceLocalMemory((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_EXT_PAGEABLE_DEVICE_LOCAL_MEMORY_BIT) != 0),
+    m_hDevice(pCreateInfo->device),
+    m_hInstance(pCreateInfo->instance),
+    m_AllocationCallbacksSpecified(pCreateInfo->pAllocationCallbacks != VMA_NULL),
+    m_AllocationCallbacks(pCreateInfo->pAllocationCallbacks ?
+        *pCreateInfo->pAllocationCallbacks : VmaEmptyAllocationCallbacks),
+    m_AllocationObjectAllocator(&m_AllocationCallbacks),
+    m_HeapSizeLimitMask(0),
+    m_PreferredLargeHeapBlockSize(0),
+    m_PhysicalDevice(pCreateInfo->physicalDevice),
+    m_CurrentFrameIndex(0),
+    m_GpuDefragmentationMemoryTypeBits(UINT32_MAX),
+    m_Pools(VmaStlAllocator<VmaPool>(GetAllocationCallbacks())),
+    m_NextPoolId(0),
+    m_DeferredDestructions(VmaStlAllocator<VmaDeferredDestruction>(GetAllocationCallbacks())),
+    m_GlobalMemoryTypeBits(UINT32_MAX)
+#if VMA_RECORDING_ENABLED
+    ,m_pRecorder(VMA_NULL)
+#endif
+{
+    if(m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0))
+    {
+        m_UseKhrDedicatedAllocation = false;
+        m_UseKhrBindMemory2 = false;
+    }
+
+    if(VMA_DEBUG_DETECT_CORRUPTION)
+    {
+        // Needs to be multiply of uint32_t size because we are going to write VMA_CORRUPTION_DETECTION_MAGIC_VALUE to it.
+        VMA_ASSERT(VMA_DEBUG_MARGIN % sizeof(uint32_t) == 0);
+    }
+
+    VMA_ASSERT(pCreateInfo->physicalDevice && pCreateInfo->device && pCreateInfo->instance);
+
+    if(m_VulkanApiVersion < VK_MAKE_VERSION(1, 1, 0))
+    {
+#if !(VMA_DEDICATED_ALLOCATION)
+        if((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_KHR_DEDICATED_ALLOCATION_BIT) != 0)
+        {
+            VMA_ASSERT(0 && "VMA_ALLOCATOR_CREATE_KHR_DEDICATED_ALLOCATION_BIT set but required extensions are disabled by preprocessor macros.");
+        }
+#endif
+#if !(VMA_BIND_MEMORY2)
+        if((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_KHR_BIND_MEMORY2_BIT) != 0)
+        {
+            VMA_ASSERT(0 && "VMA_ALLOCATOR_CREATE_KHR_BIND_MEMORY2_BIT set but required extension is disabled by preprocessor macros.");
+        }
+#endif
+    }
+#if !(VMA_MEMORY_BUDGET)
+    if((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT) != 0)
+    {
+        VMA_ASSERT(0 && "VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT set but required extension is disabled by preprocessor macros.");
+    }
+#endif
+#if !(VMA_EXTERNAL_MEMORY_HOST)
+    if((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_EXT_EXTERNAL_MEMORY_HOST_BIT) != 0)
+    {
+        VMA_ASSERT(0 && "VMA_ALLOCATOR_CREATE_EXT_EXTERNAL_MEMORY_HOST_BIT set but required extension is disabled by preprocessor macros.");
+    }
+#endif
+#if !(VMA_MEMORY_PRIORITY)
+    if(m_UseExtMemoryPriority)
+    {
+        VMA_ASSERT(0 && "VMA_ALLOCATOR_CREATE_EXT_MEMORY_PRIORITY_BIT set but required extension is disabled by preprocessor macros.");
+    }
+#endif
+#if !(VMA_PAGEABLE_DEVICE_LOCAL_MEMORY)
+    if(m_UseExtPageableDeviceLocalMemory)
+    {
+        VMA_ASSERT(0 && "VMA_ALLOCATOR_CREATE_EXT_PAGEABLE_DEVICE_LOCAL_MEMORY_BIT set but required extension is disabled by preprocessor macros.");
+    }
+#endif
+    // Priority of existing memory is changed relative to the one given at allocation.
+    VMA_ASSERT(!m_UseExtPageableDeviceLocalMemory || m_UseExtMemoryPriority);
+#if !(VMA_BUFFER_DEVICE_ADDRESS)
+    if(m_UseKhrBufferDeviceAddress)
+    {
+        VMA_ASSERT(0 && "VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT is set but required extension or Vulkan 1.2 is not available in your Vulkan header or its support in VMA has been disabled by a preprocessor macro.");
+    }
+#endif
+#if VMA_VULKAN_VERSION < 1002000
+    if(m_VulkanApiVersion >= VK_MAKE_VERSION(1, 2, 0))
+    {
+        VMA_ASSERT(0 && "vulkanApiVersion >= VK_API_VERSION_1_2 but required Vulkan version is disabled by preprocessor macros.");
+    }
+#endif
+#if VMA_VULKAN_VERSION < 1001000
+    if(m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0))
+    {
+        VMA_ASSERT(0 && "vulkanApiVersion >= VK_API_VERSION_1_1 but required Vulkan version is disabled by preprocessor macros.");
+    }
+#endif
+
+    memset(&m_DeviceMemoryCallbacks, 0 ,sizeof(m_DeviceMemoryCallbacks));
+    memset(&m_PhysicalDeviceProperties, 0, sizeof(m_PhysicalDeviceProperties));
+    memset(&m_MemProps, 0, sizeof(m_MemProps));
+
+    memset(&m_pBlockVectors, 0, sizeof(m_pBlockVectors));
+    memset(&m_pDedicatedAllocations, 0, sizeof(m_pDedicatedAllocations));
+    memset(&m_VulkanFunctions, 0, sizeof(m_VulkanFunctions));
+
+    if(pCreateInfo->pDeviceMemoryCallbacks != VMA_NULL)
+    {
+        m_DeviceMemoryCallbacks.pUserData = pCreateInfo->pDeviceMemoryCallbacks->pUserData;
+        m_DeviceMemoryCallbacks.pfnAllocate = pCreateInfo->pDeviceMemoryCallbacks->pfnAllocate;
+        m_DeviceMemoryCallbacks.pfnFree = pCreateInfo->pDeviceMemoryCallbacks->pfnFree;
+    }
+
+    ImportVulkanFunctions(pCreateInfo->pVulkanFunctions);
+
+    (*m_VulkanFunctions.vkGetPhysicalDeviceProperties)(m_PhysicalDevice, &m_PhysicalDeviceProperties);
+    (*m_VulkanFunctions.vkGetPhysicalDeviceMemoryProperties)(m_PhysicalDevice, &m_MemProps);
+
+#if VMA_EXTERNAL_MEMORY_HOST
+    m_MinImportedHostPointerAlignment = 1;
+    if(m_UseExtExternalMemoryHost)
+    {
+        VkPhysicalDeviceExternalMemoryHostPropertiesEXT externalMemoryHostProps = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT };
+        VkPhysicalDeviceProperties2KHR props2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR };
+        props2.pNext = &externalMemoryHostProps;
+        (*m_VulkanFunctions.vkGetPhysicalDeviceProperties2KHR)(m_PhysicalDevice, &props2);
+        m_MinImportedHostPointerAlignment = VMA_MAX(externalMemoryHostProps.minImportedHostPointerAlignment, (VkDeviceSize)1);
+    }
+#endif // #if VMA_EXTERNAL_MEMORY_HOST
+
+    VMA_ASSERT(VmaIsPow2(VMA_DEBUG_ALIGNMENT));
+    VMA_ASSERT(VmaIsPow2(VMA_DEBUG_MIN_BUFFER_IMAGE_GRANULARITY));
+    VMA_ASSERT(VmaIsPow2(m_PhysicalDeviceProperties.limits.bufferImageGranularity));
+    VMA_ASSERT(VmaIsPow2(m_PhysicalDeviceProperties.limits.nonCoherentAtomSize));
+
+    m_PreferredLargeHeapBlockSize = (pCreateInfo->preferredLargeHeapBlockSize != 0) ?
+        pCreateInfo->preferredLargeHeapBlockSize : static_cast<VkDeviceSize>(VMA_DEFAULT_LARGE_HEAP_BLOCK_SIZE);
+
+    m_GlobalMemoryTypeBits = CalculateGlobalMemoryTypeBits();
+
+    if(pCreateInfo->pHeapSizeLimit != VMA_NULL)
+    {
+        for(uint32_t heapIndex = 0; heapIndex < GetMemoryHeapCount(); ++heapIndex)
+        {
+            const VkDeviceSize limit = pCreateInfo->pHeapSizeLimit[heapIndex];
+            if(limit != VK_WHOLE_SIZE)
+            {
+                m_HeapSizeLimitMask |= 1u << heapIndex;
+                if(limit < m_MemProps.memoryHeaps[heapIndex].size)
+                {
+                    m_MemProps.memoryHeaps[heapIndex].size = limit;
+                }
+            }
+        }
+    }
+
+    for(uint32_t memTypeIndex = 0; memTypeIndex < GetMemoryTypeCount(); ++memTypeIndex)
+    {
+        const VkDeviceSize preferredBlockSize = CalcPreferredBlockSize(memTypeIndex);
+
+        m_pBlockVectors[memTypeIndex] = vma_new(this, VmaBlockVector)(
+            this,
+            VK_NULL_HANDLE, // hParentPool
+            memTypeIndex,
+            preferredBlockSize,
+            0,
+            SIZE_MAX,
+            GetBufferImageGranularity(),
+            pCreateInfo->frameInUseCount,
+            false, // explicitBlockSize
+            false, // linearAlgorithm
+            VMA_NULL, // pHostPointer
+            0, // exportHandleTypes
+            VMA_DEFAULT_MEMORY_PRIORITY);
+        // No need to call m_pBlockVectors[memTypeIndex][blockVectorTypeIndex]->CreateMinBlocks here,
+        // becase minBlockCount is 0.
+        m_pDedicatedAllocations[memTypeIndex] = vma_new(this, AllocationVectorType)(VmaStlAllocator<VmaAllocation>(GetAllocationCallbacks()));
+
+    }
+}
+
+VkResult VmaAllocator_T::Init(const VmaAllocatorCreateInfo* pCreateInfo)
+{
+    VkResult res = VK_SUCCESS;
+
+    if(pCreateInfo->pPublishedStatsMemory != VMA_NULL)
+    {
+        m_StatsPublisher.Init(pCreateInfo->pPublishedStatsMemory, m_MemProps);
+    }
+
+    if(pCreateInfo->pRecordSettings != VMA_NULL &&
+        !VmaStrIsEmpty(pCreateInfo->pRecordSettings->pFilePath))
+    {
+#if VMA_RECORDING_ENABLED
+        m_pRecorder = vma_new(this, VmaRecorder)(GetAllocationCallbacks());
+        res = m_pRecorder->Init(*pCreateInfo->pRecordSettings, m_UseMutex);
+        if(res != VK_SUCCESS)
+        {
+            return res;
+        }
+        m_pRecorder->WriteConfiguration(
+            m_PhysicalDeviceProperties,
+            m_MemProps,
+            m_VulkanApiVersion,
+            m_UseKhrDedicatedAllocation,
+            m_UseKhrBindMemory2,
+            m_UseExtMemoryBudget,
+            m_UseAmdDeviceCoherentMemory);
+        m_pRecorder->RecordCreateAllocator(GetCurrentFrameIndex());
+#else
+        VMA_ASSERT(0 && "VmaAllocatorCreateInfo::pRecordSettings used, but not supported due to VMA_RECORDING_ENABLED not defined to 1.");
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+#endif
+    }
+
+#if VMA_MEMORY_BUDGET
+    if(m_UseExtMemoryBudget)
+    {
+        UpdateVulkanBudget();
+    }
+#endif // #if VMA_MEMORY_BUDGET
+
+    return res;
+}
+
+VmaAllocator_T::~VmaAllocator_T()
+{
+    // Device must be idle at this point, so everything still queued can be destroyed.
+    ProcessDeferredDestructions(UINT64_MAX);
+
+#if VMA_RECORDING_ENABLED
+    if(m_pRecorder != VMA_NULL)
+    {
+        m_pRecorder->RecordDestroyAllocator(GetCurrentFrameIndex());
+        vma_delete(this, m_pRecorder);
+    }
+#endif
+
+    VMA_ASSERT(m_Pools.empty());
+
+    for(size_t i = GetMemoryTypeCount(); i--; )
+    {
+        if(m_pDedicatedAllocations[i] != VMA_NULL && !m_pDedicatedAllocations[i]->empty())
+        {
+            VMA_ASSERT(0 && "Unfreed dedicated allocations found.");
+        }
+
+        vma_delete(this, m_pDedicatedAllocations[i]);
+        vma_delete(this, m_pBlockVectors[i]);
+    }
+
+    m_StatsPublisher.Invalidate();
+}
+
+void VmaAllocator_T::ImportVulkanFunctions(const VmaVulkanFunctions* pVulkanFunctions)
+{
+#if VMA_STATIC_VULKAN_FUNCTIONS == 1
+    ImportVulkanFunctions_Static();
+#endif
+
+    if(pVulkanFunctions != VMA_NULL)
+    {
+        ImportVulkanFunctions_Custom(pVulkanFunctions);
+    }
+
+#if VMA_DYNAMIC_VULKAN_FUNCTIONS == 1
+    ImportVulkanFunctions_Dynamic();
+#endif
+
+    ValidateVulkanFunctions();
+}
+
+#if VMA_STATIC_VULKAN_FUNCTIONS == 1
+
+void VmaAllocator_T::ImportVulkanFunctions_Static()
+{
+    // Vulkan 1.0
+    m_VulkanFunctions.vkGetPhysicalDeviceProperties = (PFN_vkGetPhysicalDeviceProperties)vkGetPhysicalDeviceProperties;
+    m_VulkanFunctions.vkGetPhysicalDeviceMemoryProperties = (PFN_vkGetPhysicalDeviceMemoryProperties)vkGetPhysicalDeviceMemoryProperties;
+    m_VulkanFunctions.vkAllocateMemory = (PFN_vkAllocateMemory)vkAllocateMemory;
+    m_VulkanFunctions.vkFreeMemory = (PFN_vkFreeMemory)vkFreeMemory;
+    m_VulkanFunctions.vkMapMemory = (PFN_vkMapMemory)vkMapMemory;
+    m_VulkanFunctions.vkUnmapMemory = (PFN_vkUnmapMemory)vkUnmapMemory;
+    m_VulkanFunctions.vkFlushMappedMemoryRanges = (PFN_vkFlushMappedMemoryRanges)vkFlushMappedMemoryRanges;
+    m_VulkanFunctions.vkInvalidateMappedMemoryRanges = (PFN_vkInvalidateMappedMemoryRanges)vkInvalidateMappedMemoryRanges;
+    m_VulkanFunctions.vkBindBufferMemory = (PFN_vkBindBufferMemory)vkBindBufferMemory;
+    m_VulkanFunctions.vkBindImageMemory = (PFN_vkBindImageMemory)vkBindImageMemory;
+    m_VulkanFunctions.vkGetBufferMemoryRequirements = (PFN_vkGetBufferMemoryRequirements)vkGetBufferMemoryRequirements;
+    m_VulkanFunctions.vkGetImageMemoryRequirements = (PFN_vkGetImageMemoryRequirements)vkGetImageMemoryRequirements;
+    m_VulkanFunctions.vkCreateBuffer = (PFN_vkCreateBuffer)vkCreateBuffer;
+    m_VulkanFunctions.vkDestroyBuffer = (PFN_vkDestroyBuffer)vkDestroyBuffer;
+    m_VulkanFunctions.vkCreateImage = (PFN_vkCreateImage)vkCreateImage;
+    m_VulkanFunctions.vkDestroyImage = (PFN_vkDestroyImage)vkDestroyImage;
+    m_VulkanFunctions.vkCmdCopyBuffer = (PFN_vkCmdCopyBuffer)vkCmdCopyBuffer;
+    m_VulkanFunctions.vkQueueBindSparse = (PFN_vkQueueBindSparse)vkQueueBindSparse;
+
+    // Vulkan 1.1
+#if VMA_VULKAN_VERSION >= 1001000
+    if(m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0))
+    {
+        m_VulkanFunctions.vkGetBufferMemoryRequirements2KHR = (PFN_vkGetBufferMemoryRequirements2)vkGetBufferMemoryRequirements2;
+        m_VulkanFunctions.vkGetImageMemoryRequirements2KHR = (PFN_vkGetImageMemoryRequirements2)vkGetImageMemoryRequirements2;
+        m_VulkanFunctions.vkBindBufferMemory2KHR = (PFN_vkBindBufferMemory2)vkBindBufferMemory2;
+        m_VulkanFunctions.vkBindImageMemory2KHR = (PFN_vkBindImageMemory2)vkBindImageMemory2;
+        m_VulkanFunctions.vkGetPhysicalDeviceMemoryProperties2KHR = (PFN_vkGetPhysicalDeviceMemoryProperties2)vkGetPhysicalDeviceMemoryProperties2;
+#if VMA_EXTERNAL_MEMORY_HOST
+        m_VulkanFunctions.vkGetPhysicalDeviceProperties2KHR = (PFN_vkGetPhysicalDeviceProperties2)vkGetPhysicalDeviceProperties2;
+#endif
+    }
+#endif
+}
+
+#endif // #if VMA_STATIC_VULKAN_FUNCTIONS == 1
+
+void VmaAllocator_T::ImportVulkanFunctions_Custom(const VmaVulkanFunctions* pVulkanFunctions)
+{
+    VMA_ASSERT(pVulkanFunctions != VMA_NULL);
+
+#define VMA_COPY_IF_NOT_NULL(funcName) \
+    if(pVulkanFunctions->funcName != VMA_NULL) m_VulkanFunctions.funcName = pVulkanFunctions->funcName;
+
+    VMA_COPY_IF_NOT_NULL(vkGetPhysicalDeviceProperties);
+    VMA_COPY_IF_NOT_NULL(vkGetPhysicalDeviceMemoryProperties);
+    VMA_COPY_IF_NOT_NULL(vkAllocateMemory);
+    VMA_COPY_IF_NOT_NULL(vkFreeMemory);
+    VMA_COPY_IF_NOT_NULL(vkMapMemory);
+    VMA_COPY_IF_NOT_NULL(vkUnmapMemory);
+    VMA_COPY_IF_NOT_NULL(vkFlushMappedMemoryRanges);
+    VMA_COPY_IF_NOT_NULL(vkInvalidateMappedMemoryRanges);
+    VMA_COPY_IF_NOT_NULL(vkBindBufferMemory);
+    VMA_COPY_IF_NOT_NULL(vkBindImageMemory);
+    VMA_COPY_IF_NOT_NULL(vkGetBufferMemoryRequirements);
+    VMA_COPY_IF_NOT_NULL(vkGetImageMemoryRequirements);
+    VMA_COPY_IF_NOT_NULL(vkCreateBuffer);
+    VMA_COPY_IF_NOT_NULL(vkDestroyBuffer);
+    VMA_COPY_IF_NOT_NULL(vkCreateImage);
+    VMA_COPY_IF_NOT_NULL(vkDestroyImage);
+    VMA_COPY_IF_NOT_NULL(vkCmdCopyBuffer);
+
+#if VMA_DEDICATED_ALLOCATION || VMA_VULKAN_VERSION >= 1001000
+    VMA_COPY_IF_NOT_NULL(vkGetBufferMemoryRequirements2KHR);
+    VMA_COPY_IF_NOT_NULL(vkGetImageMemoryRequirements2KHR);
+#endif
+
+#if VMA_BIND_MEMORY2 || VMA_VULKAN_VERSION >= 1001000
+    VMA_COPY_IF_NOT_NULL(vkBindBufferMemory2KHR);
+    VMA_COPY_IF_NOT_NULL(vkBindImageMemory2KHR);
+#endif
+
+#if VMA_MEMORY_BUDGET
+    VMA_COPY_IF_NOT_NULL(vkGetPhysicalDeviceMemoryProperties2KHR);
+#endif
+
+#if VMA_EXTERNAL_MEMORY_HOST
+    VMA_COPY_IF_NOT_NULL(vkGetMemoryHostPointerPropertiesEXT);
+    VMA_COPY_IF_NOT_NULL(vkGetPhysicalDeviceProperties2KHR);
+#endif
+
+#if VMA_PAGEABLE_DEVICE_LOCAL_MEMORY
+    VMA_COPY_IF_NOT_NULL(vkSetDeviceMemoryPriorityEXT);
+#endif
+
+    VMA_COPY_IF_NOT_NULL(vkQueueBindSparse);
+
+#undef VMA_COPY_IF_NOT_NULL
+}
+
+#if VMA_DYNAMIC_VULKAN_FUNCTIONS == 1
+
+void VmaAllocator_T::ImportVulkanFunctions_Dynamic()
+{
+#define VMA_FETCH_INSTANCE_FUNC(memberName, functionPointerType, functionNameString) \
+    if(m_VulkanFunctions.memberName == VMA_NULL) \
+        m_VulkanFunctions.memberName = \
+            (functionPointerType)vkGetInstanceProcAddr(m_hInstance, functionNameString);
+#define VMA_FETCH_DEVICE_FUNC(memberName, functionPointerType, functionNameString) \
+    if(m_VulkanFunctions.memberName == VMA_NULL) \
+        m_VulkanFunctions.memberName = \
+            (functionPointerType)vkGetDeviceProcAddr(m_hDevice, functionNameString);
+
+    VMA_FETCH_INSTANCE_FUNC(vkGetPhysicalDeviceProperties, PFN_vkGetPhysicalDeviceProperties, "vkGetPhysicalDeviceProperties");
+    VMA_FETCH_INSTANCE_FUNC(vkGetPhysicalDeviceMemoryProperties, PFN_vkGetPhysicalDeviceMemoryProperties, "vkGetPhysicalDeviceMemoryProperties");
+    VMA_FETCH_DEVICE_FUNC(vkAllocateMemory, PFN_vkAllocateMemory, "vkAllocateMemory");
+    VMA_FETCH_DEVICE_FUNC(vkFreeMemory, PFN_vkFreeMemory, "vkFreeMemory");
+    VMA_FETCH_DEVICE_FUNC(vkMapMemory, PFN_vkMapMemory, "vkMapMemory");
+    VMA_FETCH_DEVICE_FUNC(vkUnmapMemory, PFN_vkUnmapMemory, "vkUnmapMemory");
+    VMA_FETCH_DEVICE_FUNC(vkFlushMappedMemoryRanges, PFN_vkFlushMappedMemoryRanges, "vkFlushMappedMemoryRanges");
+    VMA_FETCH_DEVICE_FUNC(vkInvalidateMappedMemoryRanges, PFN_vkInvalidateMappedMemoryRanges, "vkInvalidateMappedMemoryRanges");
+    VMA_FETCH_DEVICE_FUNC(vkBindBufferMemory, PFN_vkBindBufferMemory, "vkBindBufferMemory");
+    VMA_FETCH_DEVICE_FUNC(vkBindImageMemory, PFN_vkBindImageMemory, "vkBindImageMemory");
+    VMA_FETCH_DEVICE_FUNC(vkGetBufferMemoryRequirements, PFN_vkGetBufferMemoryRequirements, "vkGetBufferMemoryRequirements");
+    VMA_FETCH_DEVICE_FUNC(vkGetImageMemoryRequirements, PFN_vkGetImageMemoryRequirements, "vkGetImageMemoryRequirements");
+    VMA_FETCH_DEVICE_FUNC(vkCreateBuffer, PFN_vkCreateBuffer, "vkCreateBuffer");
+    VMA_FETCH_DEVICE_FUNC(vkDestroyBuffer, PFN_vkDestroyBuffer, "vkDestroyBuffer");
+    VMA_FETCH_DEVICE_FUNC(vkCreateImage, PFN_vkCreateImage, "vkCreateImage");
+    VMA_FETCH_DEVICE_FUNC(vkDestroyImage, PFN_vkDestroyImage, "vkDestroyImage");
+    VMA_FETCH_DEVICE_FUNC(vkCmdCopyBuffer, PFN_vkCmdCopyBuffer, "vkCmdCopyBuffer");
+    VMA_FETCH_DEVICE_FUNC(vkQueueBindSparse, PFN_vkQueueBindSparse, "vkQueueBindSparse");
+
+#if VMA_VULKAN_VERSION >= 1001000
+    if(m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0))
+    {
+        VMA_FETCH_DEVICE_FUNC(vkGetBufferMemoryRequirements2KHR, PFN_vkGetBufferMemoryRequirements2, "vkGetBufferMemoryRequirements2");
+        VMA_FETCH_DEVICE_FUNC(vkGetImageMemoryRequirements2KHR, PFN_vkGetImageMemoryRequirements2, "vkGetImageMemoryRequirements2");
+        VMA_FETCH_DEVICE_FUNC(vkBindBufferMemory2KHR, PFN_vkBindBufferMemory2, "vkBindBufferMemory2");
+        VMA_FETCH_DEVICE_FUNC(vkBindImageMemory2KHR, PFN_vkBindImageMemory2, "vkBindImageMemory2");
+        VMA_FETCH_INSTANCE_FUNC(vkGetPhysicalDeviceMemoryProperties2KHR, PFN_vkGetPhysicalDeviceMemoryProperties2, "vkGetPhysicalDeviceMemoryProperties2");
+    }
+#endif
+
+#if VMA_DEDICATED_ALLOCATION
+    if(m_UseKhrDedicatedAllocation)
+    {
+        VMA_FETCH_DEVICE_FUNC(vkGetBufferMemoryRequirements2KHR, PFN_vkGetBufferMemoryRequirements2KHR, "vkGetBufferMemoryRequirements2KHR");
+        VMA_FETCH_DEVICE_FUNC(vkGetImageMemoryRequirements2KHR, PFN_vkGetImageMemoryRequirements2KHR, "vkGetImageMemoryRequirements2KHR");
+    }
+#endif
+
+#if VMA_BIND_MEMORY2
+    if(m_UseKhrBindMemory2)
+    {
+        VMA_FETCH_DEVICE_FUNC(vkBindBufferMemory2KHR, PFN_vkBindBufferMemory2KHR, "vkBindBufferMemory2KHR");
+        VMA_FETCH_DEVICE_FUNC(vkBindImageMemory2KHR, PFN_vkBindImageMemory2KHR, "vkBindImageMemory2KHR");
+    }
+#endif // #if VMA_BIND_MEMORY2
+
+#if VMA_MEMORY_BUDGET
+    if(m_UseExtMemoryBudget)
+    {
+        VMA_FETCH_INSTANCE_FUNC(vkGetPhysicalDeviceMemoryProperties2KHR, PFN_vkGetPhysicalDeviceMemoryProperties2KHR, "vkGetPhysicalDeviceMemoryProperties2KHR");
+    }
+#endif // #if VMA_MEMORY_BUDGET
+
+#if VMA_EXTERNAL_MEMORY_HOST
+    if(m_UseExtExternalMemoryHost)
+    {
+        VMA_FETCH_DEVICE_FUNC(vkGetMemoryHostPointerPropertiesEXT, PFN_vkGetMemoryHostPointerPropertiesEXT, "vkGetMemoryHostPointerPropertiesEXT");
+#if VMA_VULKAN_VERSION >= 1001000
+        if(m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0))
+        {
+            VMA_FETCH_INSTANCE_FUNC(vkGetPhysicalDeviceProperties2KHR, PFN_vkGetPhysicalDeviceProperties2, "vkGetPhysicalDeviceProperties2");
+        }
+#endif
+        VMA_FETCH_INSTANCE_FUNC(vkGetPhysicalDeviceProperties2KHR, PFN_vkGetPhysicalDeviceProperties2KHR, "vkGetPhysicalDeviceProperties2KHR");
+    }
+#endif // #if VMA_EXTERNAL_MEMORY_HOST
+
+#if VMA_PAGEABLE_DEVICE_LOCAL_MEMORY
+    if(m_UseExtPageableDeviceLocalMemory)
+    {
+        VMA_FETCH_DEVICE_FUNC(vkSetDeviceMemoryPriorityEXT, PFN_vkSetDeviceMemoryPriorityEXT, "vkSetDeviceMemoryPriorityEXT");
+    }
+#endif // #if VMA_PAGEABLE_DEVICE_LOCAL_MEMORY
+
+#undef VMA_FETCH_DEVICE_FUNC
+#undef VMA_FETCH_INSTANCE_FUNC
+}
+
+#endif // #if VMA_DYNAMIC_VULKAN_FUNCTIONS == 1
+
+void VmaAllocator_T::ValidateVulkanFunctions()
+{
+    VMA_ASSERT(m_VulkanFunctions.vkGetPhysicalDeviceProperties != VMA_NULL);
+    VMA_ASSERT(m_VulkanFunctions.vkGetPhysicalDeviceMemoryProperties != VMA_NULL);
+    VMA_ASSERT(m_VulkanFunctions.vkAllocateMemory != VMA_NULL);
+    VMA_ASSERT(m_VulkanFunctions.vkFreeMemory != VMA_NULL);
+    VMA_ASSERT(m_VulkanFunctions.vkMapMemory != VMA_NULL);
+    VMA_ASSERT(m_VulkanFunctions.vkUnmapMemory != VMA_NULL);
+    VMA_ASSERT(m_VulkanFunctions.vkFlushMappedMemoryRanges != VMA_NULL);
+    VMA_ASSERT(m_VulkanFunctions.vkInvalidateMappedMemoryRanges != VMA_NULL);
+    VMA_ASSERT(m_VulkanFunctions.vkBindBufferMemory != VMA_NULL);
+    VMA_ASSERT(m_VulkanFunctions.vkBindImageMemory != VMA_NULL);
+    VMA_ASSERT(m_VulkanFunctions.vkGetBufferMemoryRequirements != VMA_NULL);
+    VMA_ASSERT(m_VulkanFunctions.vkGetImageMemoryRequirements != VMA_NULL);
+    VMA_ASSERT(m_VulkanFunctions.vkCreateBuffer != VMA_NULL);
+    VMA_ASSERT(m_VulkanFunctions.vkDestroyBuffer != VMA_NULL);
+    VMA_ASSERT(m_VulkanFunctions.vkCreateImage != VMA_NULL);
+    VMA_ASSERT(m_VulkanFunctions.vkDestroyImage != VMA_NULL);
+    VMA_ASSERT(m_VulkanFunctions.vkCmdCopyBuffer != VMA_NULL);
+
+#if VMA_DEDICATED_ALLOCATION || VMA_VULKAN_VERSION >= 1001000
+    if(m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0) || m_UseKhrDedicatedAllocation)
+    {
+        VMA_ASSERT(m_VulkanFunctions.vkGetBufferMemoryRequirements2KHR != VMA_NULL);
+        VMA_ASSERT(m_VulkanFunctions.vkGetImageMemoryRequirements2KHR != VMA_NULL);
+    }
+#endif
+
+#if VMA_BIND_MEMORY2 || VMA_VULKAN_VERSION >= 1001000
+    if(m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0) || m_UseKhrBindMemory2)
+    {
+        VMA_ASSERT(m_VulkanFunctions.vkBindBufferMemory2KHR != VMA_NULL);
+        VMA_ASSERT(m_VulkanFunctions.vkBindImageMemory2KHR != VMA_NULL);
+    }
+#endif
+
+#if VMA_MEMORY_BUDGET || VMA_VULKAN_VERSION >= 1001000
+    if(m_UseExtMemoryBudget || m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0))
+    {
+        VMA_ASSERT(m_VulkanFunctions.vkGetPhysicalDeviceMemoryProperties2KHR != VMA_NULL);
+    }
+#endif
+
+#if VMA_EXTERNAL_MEMORY_HOST
+    if(m_UseExtExternalMemoryHost)
+    {
+        VMA_ASSERT(m_VulkanFunctions.vkGetMemoryHostPointerPropertiesEXT != VMA_NULL);
+        VMA_ASSERT(m_VulkanFunctions.vkGetPhysicalDeviceProperties2KHR != VMA_NULL);
+    }
+#endif
+
+#if VMA_PAGEABLE_DEVICE_LOCAL_MEMORY
+    if(m_UseExtPageableDeviceLocalMemory)
+    {
+        VMA_ASSERT(m_VulkanFunctions.vkSetDeviceMemoryPriorityEXT != VMA_NULL);
+    }
+#endif
+}
+
+VkDeviceSize VmaAllocator_T::CalcPreferredBlockSize(uint32_t memTypeIndex)
+{
+    const uint32_t heapIndex = MemoryTypeIndexToHeapIndex(memTypeIndex);
+    const VkDeviceSize heapSize = m_MemProps.memoryHeaps[heapIndex].size;
+    const bool isSmallHeap = heapSize <= VMA_SMALL_HEAP_MAX_SIZE;
+    return VmaAlignUp(isSmallHeap ? (heapSize / 8) : m_PreferredLargeHeapBlockSize, (VkDeviceSize)32);
+}
+
+VkResult VmaAllocator_T::AllocateMemoryOfType(
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    bool dedicatedAllocation,
+    VkBuffer dedicatedBuffer,
+    VkBufferUsageFlags dedicatedBufferUsage,
+    VkImage dedicatedImage,
+    const VmaAllocationCreateInfo& createInfo,
+    uint32_t memTypeIndex,
+    VmaSuballocationType suballocType,
+    size_t allocationCount,
+    VmaAllocation* pAllocations)
+{
+    VMA_ASSERT(pAllocations != VMA_NULL);
+    VMA_DEBUG_LOG("  AllocateMemory: MemoryTypeIndex=%u, AllocationCount=%zu, Size=%llu", memTypeIndex, allocationCount, size);
+
+    VmaAllocationCreateInfo finalCreateInfo = createInfo;
+
+    // If memory type is not HOST_VISIBLE, disable MAPPED.
+    if((finalCreateInfo.flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0 &&
+        (m_MemProps.memoryTypes[memTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == 0)
+    {
+        finalCreateInfo.flags &= ~VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    }
+    // If memory is lazily allocated, it should be always dedicated.
+    if(finalCreateInfo.usage == VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED)
+    {
+        finalCreateInfo.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+    }
+    // Memory that is not HOST_VISIBLE can be returned zeroed only from ranges cleared by vmaZeroFreeMemory().
+    const bool zeroedOnlyFromBlocks =
+        (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_ZEROED_BIT) != 0 &&
+        (m_MemProps.memoryTypes[memTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == 0;
+    if(zeroedOnlyFromBlocks)
+    {
+        if((finalCreateInfo.flags & VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT) != 0)
+        {
+            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+        finalCreateInfo.flags |= VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT;
+    }
+
+    // Pages that must share one block can't become dedicated allocations.
+    const bool pagesInOneBlock = allocationCount > 1 &&
+        (finalCreateInfo.flags & (VMA_ALLOCATION_CREATE_PAGES_SAME_BLOCK_BIT | VMA_ALLOCATION_CREATE_PAGES_CONTIGUOUS_BIT)) != 0;
+    if(pagesInOneBlock && (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT) != 0)
+    {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    VmaBlockVector* const blockVector = m_pBlockVectors[memTypeIndex];
+    VMA_ASSERT(blockVector);
+
+    const VkDeviceSize preferredBlockSize = blockVector->GetPreferredBlockSize();
+    bool preferDedicatedMemory =
+        !pagesInOneBlock &&
+        (VMA_DEBUG_ALWAYS_DEDICATED_MEMORY ||
+        dedicatedAllocation ||
+        // Heuristics: Allocate dedicated memory if requested size if greater than half of preferred block size.
+        size > preferredBlockSize / 2);
+
+    if(preferDedicatedMemory &&
+        (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT) == 0 &&
+        finalCreateInfo.pool == VK_NULL_HANDLE)
+    {
+        finalCreateInfo.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+    }
+
+    if((finalCreateInfo.flags & VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT) != 0)
+    {
+        if((finalCreateInfo.flags & VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT) != 0)
+        {
+            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+        else
+        {
+            return AllocateDedicatedMemory(
+                size,
+                suballocType,
+                memTypeIndex,
+                (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT) != 0,
+                (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0,
+                (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_ZEROED_BIT) != 0,
+                (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT) != 0,
+                finalCreateInfo.pUserData,
+                finalCreateInfo.priority,
+                dedicatedBuffer,
+                dedicatedBufferUsage,
+                dedicatedImage,
+                allocationCount,
+                pAllocations);
+        }
+    }
+    else
+    {
+        VkResult res = blockVector->Allocate(
+            m_CurrentFrameIndex.load(),
+            size,
+            alignment,
+            finalCreateInfo,
+            suballocType,
+            allocationCount,
+            pAllocations);
+        if(res == VK_SUCCESS)
+        {
+            return res;
+        }
+        if(pagesInOneBlock)
+        {
+            return res;
+        }
+
+        // 5. Try dedicated memory.
+        if((finalCreateInfo.flags & VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT) != 0)
+        {
+            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+        else
+        {
+            res = AllocateDedicatedMemory(
+                size,
+                suballocType,
+                memTypeIndex,
+                (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT) != 0,
+                (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0,
+                (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_ZEROED_BIT) != 0,
+                (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT) != 0,
+                finalCreateInfo.pUserData,
+                finalCreateInfo.priority,
+                dedicatedBuffer,
+                dedicatedBufferUsage,
+                dedicatedImage,
+                allocationCount,
+                pAllocations);
+            if(res == VK_SUCCESS)
+            {
+                // Succeeded: AllocateDedicatedMemory function already filld pMemory, nothing more to do here.
+                VMA_DEBUG_LOG("    Allocated as DedicatedMemory");
+                return VK_SUCCESS;
+            }
+            else
+            {
+                // Everything failed: Return error code.
+                VMA_DEBUG_LOG("    vkAllocateMemory FAILED");
+                return res;
+            }
+        }
+    }
+}
+
+VkResult VmaAllocator_T::AllocateDedicatedMemory(
+    VkDeviceSize size,
+    VmaSuballocationType suballocType,
+    uint32_t memTypeIndex,
+    bool withinBudget,
+    bool map,
+    bool zeroed,
+    bool isUserDataString,
+    void* pUserData,
+    float priority,
+    VkBuffer dedicatedBuffer,
+    VkBufferUsageFlags dedicatedBufferUsage,
+    VkImage dedicatedImage,
+    size_t allocationCount,
+    VmaAllocation* pAllocations)
+{
+    VMA_ASSERT(allocationCount > 0 && pAllocations);
+
+    if(withinBudget)
+    {
+        const uint32_t heapIndex = MemoryTypeIndexToHeapIndex(memTypeIndex);
+        VmaBudget heapBudget = {};
+        GetBudget(&heapBudget, heapIndex, 1);
+        if(heapBudget.usage + size * allocationCount > heapBudget.budget)
+        {
+            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+    }
+
+    VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    allocInfo.memoryTypeIndex = memTypeIndex;
+    allocInfo.allocationSize = size;
+
+#if VMA_DEDICATED_ALLOCATION || VMA_VULKAN_VERSION >= 1001000
+    VkMemoryDedicatedAllocateInfoKHR dedicatedAllocInfo = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO_KHR };
+    if(m_UseKhrDedicatedAllocation || m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0))
+    {
+        if(dedicatedBuffer != VK_NULL_HANDLE)
+        {
+            VMA_ASSERT(dedicatedImage == VK_NULL_HANDLE);
+            dedicatedAllocInfo.buffer = dedicatedBuffer;
+            VmaPnextChainPushFront(&allocInfo, &dedicatedAllocInfo);
+        }
+        else if(dedicatedImage != VK_NULL_HANDLE)
+        {
+            dedicatedAllocInfo.image = dedicatedImage;
+            VmaPnextChainPushFront(&allocInfo, &dedicatedAllocInfo);
+        }
+    }
+#endif // #if VMA_DEDICATED_ALLOCATION || VMA_VULKAN_VERSION >= 1001000
+
+#if VMA_BUFFER_DEVICE_ADDRESS
+    VkMemoryAllocateFlagsInfoKHR allocFlagsInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO_KHR };
+    if(m_UseKhrBufferDeviceAddress)
+    {
+        bool canContainBufferWithDeviceAddress = true;
+        if(dedicatedBuffer != VK_NULL_HANDLE)
+        {
+            canContainBufferWithDeviceAddress = dedicatedBufferUsage == UINT32_MAX || // Usage flags unknown
+                (dedicatedBufferUsage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_EXT) != 0;
+        }
+        else if(dedicatedImage != VK_NULL_HANDLE)
+        {
+            canContainBufferWithDeviceAddress = false;
+        }
+        if(canContainBufferWithDeviceAddress)
+        {
+            allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR;
+            VmaPnextChainPushFront(&allocInfo, &allocFlagsInfo);
+        }
+    }
+#endif // #if VMA_BUFFER_DEVICE_ADDRESS
+
+    const float memoryPriority = VmaGetMemoryPriority(priority);
+#if VMA_MEMORY_PRIORITY
+    VkMemoryPriorityAllocateInfoEXT priorityInfo = { VK_STRUCTURE_TYPE_MEMORY_PRIORITY_ALLOCATE_INFO_EXT };
+    if(m_UseExtMemoryPriority)
+    {
+        priorityInfo.priority = memoryPriority;
+        VmaPnextChainPushFront(&allocInfo, &priorityInfo);
+    }
+#endif // #if VMA_MEMORY_PRIORITY
+
+    size_t allocIndex;
+    VkResult res = VK_SUCCESS;
+    for(allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
+    {
+        res = AllocateDedicatedMemoryPage(
+            size,
+            suballocType,
+            memTypeIndex,
+            allocInfo,
+            map,
+            zeroed,
+            isUserDataString,
+            pUserData,
+            memoryPriority,
+            pAllocations + allocIndex);
+        if(res != VK_SUCCESS)
+        {
+            break;
+        }
+    }
+
+    if(res == VK_SUCCESS)
+    {
+        // Register them in m_pDedicatedAllocations.
+        {
+            VmaMutexLockWrite lock(m_DedicatedAllocationsMutex[memTypeIndex], m_UseMutex);
+            AllocationVectorType* pDedicatedAllocations = m_pDedicatedAllocations[memTypeIndex];
+            VMA_ASSERT(pDedicatedAllocations);
+            for(allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
+            {
+                VmaVectorInsertSorted<VmaPointerLess>(*pDedicatedAllocations, pAllocations[allocIndex]);
+            }
+        }
+
+        VMA_DEBUG_LOG("    Allocated DedicatedMemory Count=%zu, MemoryTypeIndex=#%u", allocationCount, memTypeIndex);
+    }
+    else
+    {
+        // Free all already created allocations.
+        while(allocIndex--)
+        {
+            VmaAllocation currAlloc = pAllocations[allocIndex];
+            VkDeviceMemory hMemory = currAlloc->GetMemory();
+
+            /*
+            There is no need to call this, because Vulkan spec allows to skip vkUnmapMemory
+            before vkFreeMemory.
+
+            if(currAlloc->GetMappedData() != VMA_NULL)
+            {
+                (*m_VulkanFunctions.vkUnmapMemory)(m_hDevice, hMemory);
+            }
+            */
+
+            FreeVulkanMemory(memTypeIndex, currAlloc->GetSize(), hMemory);
+            m_Budget.RemoveAllocation(MemoryTypeIndexToHeapIndex(memTypeIndex), currAlloc->GetSize());
+            currAlloc->SetUserData(this, VMA_NULL);
+            m_AllocationObjectAllocator.Free(currAlloc);
+        }
+
+        memset(pAllocations, 0, sizeof(VmaAllocation) * allocationCount);
+    }
+
+    return res;
+}
+
+VkResult VmaAllocator_T::AllocateDedicatedMemoryPage(
+    VkDeviceSize size,
+    VmaSuballocationType suballocType,
+    uint32_t memTypeIndex,
+    const VkMemoryAllocateInfo& allocInfo,
+    bool map,
+    bool zeroed,
+    bool isUserDataString,
+    void* pUserData,
+    float priority,
+    VmaAllocation* pAllocation)
+{
+    VkDeviceMemory hMemory = VK_NULL_HANDLE;
+    VkResult res = AllocateVulkanMemory(&allocInfo, &hMemory);
+    if(res < 0)
+    {
+        VMA_DEBUG_LOG("    vkAllocateMemory FAILED");
+        return res;
+    }
+
+    void* pMappedData = VMA_NULL;
+    if(map)
+    {
+        res = (*m_VulkanFunctions.vkMapMemory)(
+            m_hDevice,
+            hMemory,
+            0,
+            VK_WHOLE_SIZE,
+            0,
+            &pMappedData);
+        if(res < 0)
+        {
+            VMA_DEBUG_LOG("    vkMapMemory FAILED");
+            FreeVulkanMemory(memTypeIndex, size, hMemory);
+            return res;
+        }
+    }
+
+    // Newly allocated memory is not guaranteed to contain zeros.
+    if(zeroed)
+    {
+        void* pData = pMappedData;
+        if(pData == VMA_NULL)
+        {
+            res = (*m_VulkanFunctions.vkMapMemory)(m_hDevice, hMemory, 0, VK_WHOLE_SIZE, 0, &pData);
+            if(res < 0)
+            {
+                VMA_DEBUG_LOG("    vkMapMemory FAILED");
+                FreeVulkanMemory(memTypeIndex, size, hMemory);
+                return res;
+            }
+        }
+        memset(pData, 0, (size_t)size);
+        if(IsMemoryTypeNonCoherent(memTypeIndex))
+        {
+            VkMappedMemoryRange memRange = { VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE };
+            memRange.memory = hMemory;
+            memRange.size = VK_WHOLE_SIZE;
+            (*m_VulkanFunctions.vkFlushMappedMemoryRanges)(m_hDevice, 1, &memRange);
+        }
+        if(pMappedData == VMA_NULL)
+        {
+            (*m_VulkanFunctions.vkUnmapMemory)(m_hDevice, hMemory);
+        }
+    }
+
+    *pAllocation = m_AllocationObjectAllocator.Allocate(m_CurrentFrameIndex.load(), isUserDataString);
+    (*pAllocation)->InitDedicatedAllocation(memTypeIndex, hMemory, suballocType, pMappedData, size, priority);
+    (*pAllocation)->SetUserData(this, pUserData);
+    m_Budget.AddAllocation(MemoryTypeIndexToHeapIndex(memTypeIndex), size);
+    if(VMA_DEBUG_INITIALIZE_ALLOCATIONS && !zeroed)
+    {
+        FillAllocation(*pAllocation, VMA_ALLOCATION_FILL_PATTERN_CREATED);
+    }
+
+    return VK_SUCCESS;
+}
+
+void VmaAllocator_T::GetBufferMemoryRequirements(
+    VkBuffer hBuffer,
+    VkMemoryRequirements& memReq,
+    bool& requiresDedicatedAllocation,
+    bool& prefersDedicatedAllocation) const
+{
+#if VMA_DEDICATED_ALLOCATION || VMA_VULKAN_VERSION >= 1001000
+    if(m_UseKhrDedicatedAllocation || m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0))
+    {
+        VkBufferMemoryRequirementsInfo2KHR memReqInfo = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2_KHR };
+        memReqInfo.buffer = hBuffer;
+
+        VkMemoryDedicatedRequirementsKHR memDedicatedReq = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS_KHR };
+
+        VkMemoryRequirements2KHR memReq2 = { VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2_KHR };
+        VmaPnextChainPushFront(&memReq2, &memDedicatedReq);
+
+        (*m_VulkanFunctions.vkGetBufferMemoryRequirements2KHR)(m_hDevice, &memReqInfo, &memReq2);
+
+        memReq = memReq2.memoryRequirements;
+        requiresDedicatedAllocation = (memDedicatedReq.requiresDedicatedAllocation != VK_FALSE);
+        prefersDedicatedAllocation  = (memDedicatedReq.prefersDedicatedAllocation  != VK_FALSE);
+    }
+    else
+#endif // #if VMA_DEDICATED_ALLOCATION || VMA_VULKAN_VERSION >= 1001000
+    {
+        (*m_VulkanFunctions.vkGetBufferMemoryRequirements)(m_hDevice, hBuffer, &memReq);
+        requiresDedicatedAllocation = false;
+        prefersDedicatedAllocation  = false;
+    }
+}
+
+void VmaAllocator_T::GetImageMemoryRequirements(
+    VkImage hImage,
+    VkMemoryRequirements& memReq,
+    bool& requiresDedicatedAllocation,
+    bool& prefersDedicatedAllocation) const
+{
+#if VMA_DEDICATED_ALLOCATION || VMA_VULKAN_VERSION >= 1001000
+    if(m_UseKhrDedicatedAllocation || m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0))
+    {
+        VkImageMemoryRequirementsInfo2KHR memReqInfo = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2_KHR };
+        memReqInfo.image = hImage;
+
+        VkMemoryDedicatedRequirementsKHR memDedicatedReq = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS_KHR };
+
+        VkMemoryRequirements2KHR memReq2 = { VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2_KHR };
+        VmaPnextChainPushFront(&memReq2, &memDedicatedReq);
+
+        (*m_VulkanFunctions.vkGetImageMemoryRequirements2KHR)(m_hDevice, &memReqInfo, &memReq2);
+
+        memReq = memReq2.memoryRequirements;
+        requiresDedicatedAllocation = (memDedicatedReq.requiresDedicatedAllocation != VK_FALSE);
+        prefersDedicatedAllocation  = (memDedicatedReq.prefersDedicatedAllocation  != VK_FALSE);
+    }
+    else
+#endif // #if VMA_DEDICATED_ALLOCATION || VMA_VULKAN_VERSION >= 1001000
+    {
+        (*m_VulkanFunctions.vkGetImageMemoryRequirements)(m_hDevice, hImage, &memReq);
+        requiresDedicatedAllocation = false;
+        prefersDedicatedAllocation  = false;
+    }
+}
+
+VkResult VmaAllocator_T::AllocateMemory(
+    const VkMemoryRequirements& vkMemReq,
+    bool requiresDedicatedAllocation,
+    bool prefersDedicatedAllocation,
+    VkBuffer dedicatedBuffer,
+    VkBufferUsageFlags dedicatedBufferUsage,
+    VkImage dedicatedImage,
+    const VmaAllocationCreateInfo& createInfo,
+    VmaSuballocationType suballocType,
+    size_t allocationCount,
+    VmaAllocation* pAllocations)
+{
+    memset(pAllocations, 0, sizeof(VmaAllocation) * allocationCount);
+
+    VMA_ASSERT(VmaIsPow2(vkMemReq.alignment));
+
+    if(createInfo.scope != VK_NULL_HANDLE)
+    {
+        VmaAllocationCreateInfo createInfoWithoutScope = createInfo;
+        createInfoWithoutScope.scope = VK_NULL_HANDLE;
+        const VkResult res = AllocateMemory(
+            vkMemReq,
+            requiresDedicatedAllocation,
+            prefersDedicatedAllocation,
+            dedicatedBuffer,
+            dedicatedBufferUsage,
+            dedicatedImage,
+            createInfoWithoutScope,
+            suballocType,
+            allocationCount,
+            pAllocations);
+        if(res == VK_SUCCESS)
+        {
+            createInfo.scope->Add(pAllocations, allocationCount);
+        }
+        return res;
+    }
+
+    // Admission is checked before any block is searched, without taking any lock.
+    if(createInfo.quota != VK_NULL_HANDLE)
+    {
+        const VkDeviceSize totalSize = vkMemReq.size * allocationCount;
+        if(!createInfo.quota->TryCharge(totalSize))
+        {
+            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+        VmaAllocationCreateInfo createInfoWithoutQuota = createInfo;
+        createInfoWithoutQuota.quota = VK_NULL_HANDLE;
+        const VkResult res = AllocateMemory(
+            vkMemReq,
+            requiresDedicatedAllocation,
+            prefersDedicatedAllocation,
+            dedicatedBuffer,
+            dedicatedBufferUsage,
+            dedicatedImage,
+            createInfoWithoutQuota,
+            suballocType,
+            allocationCount,
+            pAllocations);
+        if(res == VK_SUCCESS)
+        {
+            for(size_t allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
+            {
+                pAllocations[allocIndex]->SetQuota(createInfo.quota, vkMemReq.size);
+            }
+        }
+        else
+        {
+            createInfo.quota->Release(totalSize);
+        }
+        return res;
+    }
+
+    if(vkMemReq.size == 0 || createInfo.tag >= VMA_ALLOCATION_TAG_COUNT)
+    {
+        return VK_ERROR_VALIDATION_FAILED_EXT;
+    }
+    if((createInfo.flags & VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT) != 0 &&
+        (createInfo.flags & VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT) != 0)
+    {
+        VMA_ASSERT(0 && "Specifying VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT together with VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT makes no sense.");
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+    if((createInfo.flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0 &&
+        (createInfo.flags & VMA_ALLOCATION_CREATE_CAN_BECOME_LOST_BIT) != 0)
+    {
+        VMA_ASSERT(0 && "Specifying VMA_ALLOCATION_CREATE_MAPPED_BIT together with VMA_ALLOCATION_CREATE_CAN_BECOME_LOST_BIT is invalid.");
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+    if(requiresDedicatedAllocation)
+    {
+        if((createInfo.flags & VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT) != 0)
+        {
+            VMA_ASSERT(0 && "VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT specified while dedicated allocation is required.");
+            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+        if(createInfo.pool != VK_NULL_HANDLE)
+        {
+            VMA_ASSERT(0 && "Pool specified while dedicated allocation is required.");
+            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+    }
+    if((createInfo.pool != VK_NULL_HANDLE) &&
+        ((createInfo.flags & (VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT)) != 0))
+    {
+        VMA_ASSERT(0 && "Specifying VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT when pool != null is invalid.");
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+
+    if(createInfo.pool != VK_NULL_HANDLE)
+    {
+        const VkDeviceSize alignmentForPool = VMA_MAX(
+            vkMemReq.alignment,
+            GetMemoryTypeMinAlignment(createInfo.pool->m_BlockVector.GetMemoryTypeIndex()));
 
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaMapMemory,%p\n", callParams.threadId, callParams.time, frameIndex,
-        allocation);
-    Flush();
-}
+        VmaAllocationCreateInfo createInfoForPool = createInfo;
+        // If memory type is not HOST_VISIBLE, disable MAPPED.
+        if((createInfoForPool.flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0 &&
+            (m_MemProps.memoryTypes[createInfo.pool->m_BlockVector.GetMemoryTypeIndex()].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == 0)
+        {
+            createInfoForPool.flags &= ~VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        }
 
-void VmaRecorder::RecordUnmapMemory(uint32_t frameIndex,
-    VmaAllocation allocation)
-{
-    CallParams callParams;
-    GetBasicParams(callParams);
+        const VkResult res = createInfo.pool->m_BlockVector.Allocate(
+            m_CurrentFrameIndex.load(),
+            vkMemReq.size,
+            alignmentForPool,
+            createInfoForPool,
+            suballocType,
+            allocationCount,
+            pAllocations);
+        if(res == VK_SUCCESS)
+        {
+            AddTaggedAllocations(createInfo, allocationCount, pAllocations);
+        }
+        return res;
+    }
+    else
+    {
+        // Bit mask of memory Vulkan types acceptable for this allocation.
+        uint32_t memoryTypeBits = vkMemReq.memoryTypeBits;
+        uint32_t memTypeIndex = UINT32_MAX;
+        VkResult res = vmaFindMemoryTypeIndex(this, memoryTypeBits, &createInfo, &memTypeIndex);
+        if(res == VK_SUCCESS)
+        {
+            VkDeviceSize alignmentForMemType = VMA_MAX(
+                vkMemReq.alignment,
+                GetMemoryTypeMinAlignment(memTypeIndex));
 
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaUnmapMemory,%p\n", callParams.threadId, callParams.time, frameIndex,
-        allocation);
-    Flush();
+            res = AllocateMemoryOfType(
+                vkMemReq.size,
+                alignmentForMemType,
+                requiresDedicatedAllocation || prefersDedicatedAllocation,
+                dedicatedBuffer,
+                dedicatedBufferUsage,
+                dedicatedImage,
+                createInfo,
+                memTypeIndex,
+                suballocType,
+                allocationCount,
+                pAllocations);
+            // Succeeded on first try.
+            if(res == VK_SUCCESS)
+            {
+                AddTaggedAllocations(createInfo, allocationCount, pAllocations);
+                return res;
+            }
+            // Allocation from this memory type failed. Try other compatible memory types.
+            else
+            {
+                for(;;)
+                {
+                    // Remove old memTypeIndex from list of possibilities.
+                    memoryTypeBits &= ~(1u << memTypeIndex);
+                    // Find alternative memTypeIndex.
+                    res = vmaFindMemoryTypeIndex(this, memoryTypeBits, &createInfo, &memTypeIndex);
+                    if(res == VK_SUCCESS)
+                    {
+                        alignmentForMemType = VMA_MAX(
+                            vkMemReq.alignment,
+                            GetMemoryTypeMinAlignment(memTypeIndex));
+
+                        res = AllocateMemoryOfType(
+                            vkMemReq.size,
+                            alignmentForMemType,
+                            requiresDedicatedAllocation || prefersDedicatedAllocation,
+                            dedicatedBuffer,
+                            dedicatedBufferUsage,
+                            dedicatedImage,
+                            createInfo,
+                            memTypeIndex,
+                            suballocType,
+                            allocationCount,
+                            pAllocations);
+                        // Allocation from this alternative memory type succeeded.
+                        if(res == VK_SUCCESS)
+                        {
+                            AddTaggedAllocations(createInfo, allocationCount, pAllocations);
+                            return res;
+                        }
+                        // else: Allocation from this memory type failed. Try next one - next loop iteration.
+                    }
+                    // No other matching memory type index could be found.
+                    else
+                    {
+                        // Not returning res, which is VK_ERROR_FEATURE_NOT_PRESENT, because we already failed to allocate once.
+                        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+                    }
+                }
+            }
+        }
+        // Can't find any single memory type maching requirements. res is VK_ERROR_FEATURE_NOT_PRESENT.
+        else
+            return res;
+    }
 }
 
-void VmaRecorder::RecordFlushAllocation(uint32_t frameIndex,
-    VmaAllocation allocation, VkDeviceSize offset, VkDeviceSize size)
+VkResult VmaAllocator_T::AllocateMemoryBatch(
+    const VkMemoryRequirements* pVkMemoryRequirements,
+    const VmaAllocationCreateInfo* pCreateInfos,
+    size_t allocationCount,
+    VmaAllocation* pAllocations)
 {
-    CallParams callParams;
-    GetBasicParams(callParams);
+    memset(pAllocations, 0, sizeof(VmaAllocation) * allocationCount);
 
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaFlushAllocation,%p,%llu,%llu\n", callParams.threadId, callParams.time, frameIndex,
-        allocation,
-        offset,
-        size);
-    Flush();
-}
+    typedef VmaStlAllocator<VmaBatchAllocation> ItemAllocator;
+    VmaVector< VmaBatchAllocation, ItemAllocator > items(allocationCount, ItemAllocator(GetAllocationCallbacks()));
 
-void VmaRecorder::RecordInvalidateAllocation(uint32_t frameIndex,
-    VmaAllocation allocation, VkDeviceSize offset, VkDeviceSize size)
-{
-    CallParams callParams;
-    GetBasicParams(callParams);
+    // Find block vector for each allocation. Cases that need special treatment are left to AllocateMemory().
+    for(size_t allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
+    {
+        const VkMemoryRequirements& vkMemReq = pVkMemoryRequirements[allocIndex];
+        const VmaAllocationCreateInfo& createInfo = pCreateInfos[allocIndex];
+        VmaBatchAllocation& item = items[allocIndex];
+        item.pBlockVector = VMA_NULL;
+        item.index = allocIndex;
+        item.size = vkMemReq.size;
+        item.alignment = vkMemReq.alignment;
+        item.createInfo = createInfo;
 
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaInvalidateAllocation,%p,%llu,%llu\n", callParams.threadId, callParams.time, frameIndex,
-        allocation,
-        offset,
-        size);
-    Flush();
-}
+        VMA_ASSERT(VmaIsPow2(vkMemReq.alignment));
+        if(vkMemReq.size == 0)
+        {
+            return VK_ERROR_VALIDATION_FAILED_EXT;
+        }
+        if(createInfo.scope != VK_NULL_HANDLE ||
+            createInfo.quota != VK_NULL_HANDLE ||
+            createInfo.tag >= VMA_ALLOCATION_TAG_COUNT ||
+            createInfo.usage == VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED ||
+            (createInfo.flags & (VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT | VMA_ALLOCATION_CREATE_ZEROED_BIT)) != 0 ||
+            ((createInfo.flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0 &&
+                (createInfo.flags & VMA_ALLOCATION_CREATE_CAN_BECOME_LOST_BIT) != 0))
+        {
+            continue;
+        }
 
-void VmaRecorder::RecordCreateBuffer(uint32_t frameIndex,
-    const VkBufferCreateInfo& bufCreateInfo,
-    const VmaAllocationCreateInfo& allocCreateInfo,
-    VmaAllocation allocation)
-{
-    CallParams callParams;
-    GetBasicParams(callParams);
+        uint32_t memTypeIndex = UINT32_MAX;
+        if(createInfo.pool != VK_NULL_HANDLE)
+        {
+            item.pBlockVector = &createInfo.pool->m_BlockVector;
+            memTypeIndex = item.pBlockVector->GetMemoryTypeIndex();
+        }
+        else
+        {
+            if(vmaFindMemoryTypeIndex(this, vkMemReq.memoryTypeBits, &createInfo, &memTypeIndex) != VK_SUCCESS)
+            {
+                continue;
+            }
+            VmaBlockVector* const blockVector = m_pBlockVectors[memTypeIndex];
+            VMA_ASSERT(blockVector);
+            // Same heuristics as in AllocateMemoryOfType().
+            if(VMA_DEBUG_ALWAYS_DEDICATED_MEMORY ||
+                vkMemReq.size > blockVector->GetPreferredBlockSize() / 2)
+            {
+                continue;
+            }
+            item.pBlockVector = blockVector;
+        }
 
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    UserDataString userDataStr(allocCreateInfo.flags, allocCreateInfo.pUserData);
-    fprintf(m_File, "%u,%.3f,%u,vmaCreateBuffer,%u,%llu,%u,%u,%u,%u,%u,%u,%u,%p,%p,%s\n", callParams.threadId, callParams.time, frameIndex,
-        bufCreateInfo.flags,
-        bufCreateInfo.size,
-        bufCreateInfo.usage,
-        bufCreateInfo.sharingMode,
-        allocCreateInfo.flags,
-        allocCreateInfo.usage,
-        allocCreateInfo.requiredFlags,
-        allocCreateInfo.preferredFlags,
-        allocCreateInfo.memoryTypeBits,
-        allocCreateInfo.pool,
-        allocation,
-        userDataStr.GetString());
-    Flush();
+        item.alignment = VMA_MAX(vkMemReq.alignment, GetMemoryTypeMinAlignment(memTypeIndex));
+        // If memory type is not HOST_VISIBLE, disable MAPPED.
+        if((item.createInfo.flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0 &&
+            (m_MemProps.memoryTypes[memTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == 0)
+        {
+            item.createInfo.flags &= ~VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        }
+    }
+
+    // Group by block vector. Within a group, place allocations with largest alignment and size first.
+    struct BatchAllocationLess
+    {
+        bool operator()(const VmaBatchAllocation& lhs, const VmaBatchAllocation& rhs) const
+        {
+            if(lhs.pBlockVector != rhs.pBlockVector)
+            {
+                return VmaPointerLess()(lhs.pBlockVector, rhs.pBlockVector);
+            }
+            if(lhs.alignment != rhs.alignment)
+            {
+                return lhs.alignment > rhs.alignment;
+            }
+            return lhs.size > rhs.size;
+        }
+    };
+    VMA_SORT(items.begin(), items.end(), BatchAllocationLess());
+
+    const uint32_t currentFrameIndex = m_CurrentFrameIndex.load();
+    for(size_t groupBegin = 0; groupBegin < allocationCount; )
+    {
+        VmaBlockVector* const pBlockVector = items[groupBegin].pBlockVector;
+        size_t groupEnd = groupBegin + 1;
+        while(groupEnd < allocationCount && items[groupEnd].pBlockVector == pBlockVector)
+        {
+            ++groupEnd;
+        }
+        if(pBlockVector != VMA_NULL)
+        {
+            pBlockVector->AllocateBatch(currentFrameIndex, items.data() + groupBegin, groupEnd - groupBegin, pAllocations);
+        }
+        groupBegin = groupEnd;
+    }
+    for(size_t itemIndex = 0; itemIndex < allocationCount; ++itemIndex)
+    {
+        const VmaBatchAllocation& item = items[itemIndex];
+        if(pAllocations[item.index] != VK_NULL_HANDLE)
+        {
+            AddTaggedAllocations(item.createInfo, 1, pAllocations + item.index);
+        }
+    }
+
+    // Allocations left out or not fitting into existing blocks: dedicated memory, other memory types etc.
+    VkResult res = VK_SUCCESS;
+    for(size_t allocIndex = 0; allocIndex < allocationCount && res == VK_SUCCESS; ++allocIndex)
+    {
+        if(pAllocations[allocIndex] == VK_NULL_HANDLE)
+        {
+            res = AllocateMemory(
+                pVkMemoryRequirements[allocIndex],
+                false, // requiresDedicatedAllocation
+                false, // prefersDedicatedAllocation
+                VK_NULL_HANDLE, // dedicatedBuffer
+                UINT32_MAX, // dedicatedBufferUsage
+                VK_NULL_HANDLE, // dedicatedImage
+                pCreateInfos[allocIndex],
+                VMA_SUBALLOCATION_TYPE_UNKNOWN,
+                1, // allocationCount
+                pAllocations + allocIndex);
+        }
+    }
+
+    if(res != VK_SUCCESS)
+    {
+        FreeMemory(allocationCount, pAllocations);
+        memset(pAllocations, 0, sizeof(VmaAllocation) * allocationCount);
+    }
+    return res;
 }
 
-void VmaRecorder::RecordCreateImage(uint32_t frameIndex,
-    const VkImageCreateInfo& imageCreateInfo,
-    const VmaAllocationCreateInfo& allocCreateInfo,
-    VmaAllocation allocation)
+/*
+Simulates placement of allocations for vmaCheckAllocationsFit(). Follows the same
+decisions as AllocateMemory(), but only remembers where allocations would go:
+ranges of existing blocks, new blocks whose free space is used like in a linear allocator,
+and sizes charged to quotas.
+*/
+class VmaAllocationFitChecker
 {
-    CallParams callParams;
-    GetBasicParams(callParams);
+    VMA_CLASS_NO_COPY(VmaAllocationFitChecker)
+public:
+    VmaAllocationFitChecker(VmaAllocator hAllocator);
 
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    UserDataString userDataStr(allocCreateInfo.flags, allocCreateInfo.pUserData);
-    fprintf(m_File, "%u,%.3f,%u,vmaCreateImage,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%p,%p,%s\n", callParams.threadId, callParams.time, frameIndex,
-        imageCreateInfo.flags,
-        imageCreateInfo.imageType,
-        imageCreateInfo.format,
-        imageCreateInfo.extent.width,
-        imageCreateInfo.extent.height,
-        imageCreateInfo.extent.depth,
-        imageCreateInfo.mipLevels,
-        imageCreateInfo.arrayLayers,
-        imageCreateInfo.samples,
-        imageCreateInfo.tiling,
-        imageCreateInfo.usage,
-        imageCreateInfo.sharingMode,
-        imageCreateInfo.initialLayout,
-        allocCreateInfo.flags,
-        allocCreateInfo.usage,
-        allocCreateInfo.requiredFlags,
-        allocCreateInfo.preferredFlags,
-        allocCreateInfo.memoryTypeBits,
-        allocCreateInfo.pool,
-        allocation,
-        userDataStr.GetString());
-    Flush();
-}
+    VkResult Check(
+        const VkMemoryRequirements& vkMemReq,
+        const VmaAllocationCreateInfo& createInfo,
+        VmaAllocationFitPlacement& outPlacement);
+    void GetFitInfo(VmaAllocationFitInfo& outInfo) const;
+
+private:
+    struct NewBlock
+    {
+        VmaBlockVector* pBlockVector;
+        VkDeviceSize size;
+        VkDeviceSize usedSize;
+    };
+    struct QuotaCharge
+    {
+        VmaQuota quota;
+        VkDeviceSize size;
+    };
+
+    const VmaAllocator m_hAllocator;
+    const uint32_t m_CurrentFrameIndex;
+    VmaBudget m_Budget[VK_MAX_MEMORY_HEAPS];
+    VkDeviceSize m_NewBytes[VK_MAX_MEMORY_HEAPS];
+    uint32_t m_ExistingBlockAllocationCount;
+    uint32_t m_NewDeviceMemoryCount;
+    VmaVector< VmaFitReservation, VmaStlAllocator<VmaFitReservation> > m_Reservations;
+    VmaVector< NewBlock, VmaStlAllocator<NewBlock> > m_NewBlocks;
+    // Sizes charged by earlier allocations to each quota, including the ancestors.
+    VmaVector< QuotaCharge, VmaStlAllocator<QuotaCharge> > m_QuotaCharges;
+
+    VkResult Place(
+        const VkMemoryRequirements& vkMemReq,
+        const VmaAllocationCreateInfo& createInfo,
+        VmaAllocationFitPlacement& outPlacement);
+    bool CheckInBlockVector(
+        VmaBlockVector* pBlockVector,
+        const VkMemoryRequirements& vkMemReq,
+        const VmaAllocationCreateInfo& createInfo,
+        VmaAllocationFitPlacement& outPlacement);
+    VkDeviceSize GetFreeBudget(uint32_t heapIndex) const;
+    void AddNewDeviceMemory(uint32_t heapIndex, VkDeviceSize size);
+    // Like VmaQuota_T::TryCharge(), but charges only m_QuotaCharges.
+    bool TryChargeQuota(VmaQuota quota, VkDeviceSize size);
+    void ReleaseQuota(VmaQuota quota, VkDeviceSize size);
+    QuotaCharge* FindQuotaCharge(VmaQuota quota);
+};
 
-void VmaRecorder::RecordDestroyBuffer(uint32_t frameIndex,
-    VmaAllocation allocation)
+VmaAllocationFitChecker::VmaAllocationFitChecker(VmaAllocator hAllocator) :
+    m_hAllocator(hAllocator),
+    m_CurrentFrameIndex(hAllocator->GetCurrentFrameIndex()),
+    m_ExistingBlockAllocationCount(0),
+    m_NewDeviceMemoryCount(0),
+    m_Reservations(VmaStlAllocator<VmaFitReservation>(hAllocator->GetAllocationCallbacks())),
+    m_NewBlocks(VmaStlAllocator<NewBlock>(hAllocator->GetAllocationCallbacks())),
+    m_QuotaCharges(VmaStlAllocator<QuotaCharge>(hAllocator->GetAllocationCallbacks()))
 {
-    CallParams callParams;
-    GetBasicParams(callParams);
-
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaDestroyBuffer,%p\n", callParams.threadId, callParams.time, frameIndex,
-        allocation);
-    Flush();
+    memset(m_Budget, 0, sizeof(m_Budget));
+    memset(m_NewBytes, 0, sizeof(m_NewBytes));
+    hAllocator->GetBudget(m_Budget, 0, hAllocator->GetMemoryHeapCount());
 }
 
-void VmaRecorder::RecordDestroyImage(uint32_t frameIndex,
-    VmaAllocation allocation)
+VkResult VmaAllocationFitChecker::Check(
+    const VkMemoryRequirements& vkMemReq,
+    const VmaAllocationCreateInfo& createInfo,
+    VmaAllocationFitPlacement& outPlacement)
 {
-    CallParams callParams;
-    GetBasicParams(callParams);
+    outPlacement.memoryTypeIndex = UINT32_MAX;
+    outPlacement.newDeviceMemory = VK_FALSE;
 
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaDestroyImage,%p\n", callParams.threadId, callParams.time, frameIndex,
-        allocation);
-    Flush();
+    if(vkMemReq.size == 0)
+    {
+        return VK_ERROR_VALIDATION_FAILED_EXT;
+    }
+
+    // Like AllocateMemory(), charge the quota before looking for a place.
+    if(createInfo.quota != VK_NULL_HANDLE && !TryChargeQuota(createInfo.quota, vkMemReq.size))
+    {
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+    const VkResult res = Place(vkMemReq, createInfo, outPlacement);
+    if(res != VK_SUCCESS && createInfo.quota != VK_NULL_HANDLE)
+    {
+        ReleaseQuota(createInfo.quota, vkMemReq.size);
+    }
+    return res;
 }
 
-void VmaRecorder::RecordTouchAllocation(uint32_t frameIndex,
-    VmaAllocation allocation)
+VkResult VmaAllocationFitChecker::Place(
+    const VkMemoryRequirements& vkMemReq,
+    const VmaAllocationCreateInfo& createInfo,
+    VmaAllocationFitPlacement& outPlacement)
 {
-    CallParams callParams;
-    GetBasicParams(callParams);
+    if(createInfo.pool != VK_NULL_HANDLE)
+    {
+        return CheckInBlockVector(&createInfo.pool->m_BlockVector, vkMemReq, createInfo, outPlacement) ?
+            VK_SUCCESS : VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
 
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaTouchAllocation,%p\n", callParams.threadId, callParams.time, frameIndex,
-        allocation);
-    Flush();
+    // Like AllocateMemory(), try other compatible memory types if the best one is full.
+    uint32_t memoryTypeBits = vkMemReq.memoryTypeBits;
+    uint32_t memTypeIndex = UINT32_MAX;
+    VkResult res = vmaFindMemoryTypeIndex(m_hAllocator, memoryTypeBits, &createInfo, &memTypeIndex);
+    if(res != VK_SUCCESS)
+    {
+        return res;
+    }
+    for(;;)
+    {
+        if(CheckInBlockVector(m_hAllocator->m_pBlockVectors[memTypeIndex], vkMemReq, createInfo, outPlacement))
+        {
+            return VK_SUCCESS;
+        }
+        memoryTypeBits &= ~(1u << memTypeIndex);
+        if(vmaFindMemoryTypeIndex(m_hAllocator, memoryTypeBits, &createInfo, &memTypeIndex) != VK_SUCCESS)
+        {
+            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+    }
 }
 
-void VmaRecorder::RecordGetAllocationInfo(uint32_t frameIndex,
-    VmaAllocation allocation)
+void VmaAllocationFitChecker::GetFitInfo(VmaAllocationFitInfo& outInfo) const
 {
-    CallParams callParams;
-    GetBasicParams(callParams);
-
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaGetAllocationInfo,%p\n", callParams.threadId, callParams.time, frameIndex,
-        allocation);
-    Flush();
+    memset(&outInfo, 0, sizeof(outInfo));
+    outInfo.existingBlockAllocationCount = m_ExistingBlockAllocationCount;
+    outInfo.newDeviceMemoryCount = m_NewDeviceMemoryCount;
+    const uint32_t heapCount = m_hAllocator->GetMemoryHeapCount();
+    for(uint32_t heapIndex = 0; heapIndex < heapCount; ++heapIndex)
+    {
+        outInfo.newDeviceMemoryBytes += m_NewBytes[heapIndex];
+        outInfo.budgetLeft[heapIndex] = GetFreeBudget(heapIndex);
+    }
 }
 
-void VmaRecorder::RecordMakePoolAllocationsLost(uint32_t frameIndex,
-    VmaPool pool)
-{
-    CallParams callParams;
-    GetBasicParams(callParams);
+bool VmaAllocationFitChecker::CheckInBlockVector(
+    VmaBlockVector* pBlockVector,
+    const VkMemoryRequirements& vkMemReq,
+    const VmaAllocationCreateInfo& createInfo,
+    VmaAllocationFitPlacement& outPlacement)
+{
+    VMA_ASSERT(pBlockVector);
+    const uint32_t memTypeIndex = pBlockVector->GetMemoryTypeIndex();
+    const uint32_t heapIndex = m_hAllocator->MemoryTypeIndexToHeapIndex(memTypeIndex);
+    const bool isCustomPool = pBlockVector->IsCustomPool();
+    const VkDeviceSize size = vkMemReq.size;
+    const VkDeviceSize alignment = VMA_MAX(vkMemReq.alignment, m_hAllocator->GetMemoryTypeMinAlignment(memTypeIndex));
+    const VkDeviceSize preferredBlockSize = pBlockVector->GetPreferredBlockSize();
+    const VmaQuota poolQuota = isCustomPool ? pBlockVector->GetParentPool()->GetQuota() : VK_NULL_HANDLE;
+    const bool canAllocate =
+        (createInfo.flags & VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT) == 0 &&
+        // Memory that is not HOST_VISIBLE can be returned zeroed only from ranges cleared by vmaZeroFreeMemory().
+        ((createInfo.flags & VMA_ALLOCATION_CREATE_ZEROED_BIT) == 0 ||
+            (m_hAllocator->m_MemProps.memoryTypes[memTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0);
+    const bool dedicated = !isCustomPool &&
+        (VMA_DEBUG_ALWAYS_DEDICATED_MEMORY ||
+        (createInfo.flags & VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT) != 0 ||
+        createInfo.usage == VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED ||
+        size > preferredBlockSize / 2);
+
+    outPlacement.memoryTypeIndex = memTypeIndex;
+    if(!dedicated)
+    {
+        // 1. Free space of existing blocks.
+        if(pBlockVector->CheckFitInExistingBlocks(m_CurrentFrameIndex, size, alignment, createInfo, m_Reservations))
+        {
+            outPlacement.newDeviceMemory = VK_FALSE;
+            ++m_ExistingBlockAllocationCount;
+            return true;
+        }
 
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaMakePoolAllocationsLost,%p\n", callParams.threadId, callParams.time, frameIndex,
-        pool);
-    Flush();
-}
+        // 2. Free space of blocks to be created for earlier allocations.
+        outPlacement.newDeviceMemory = VK_TRUE;
+        size_t newBlockCount = 0;
+        VkDeviceSize maxExistingBlockSize = pBlockVector->GetMaxBlockSize();
+        for(size_t newBlockIndex = 0; newBlockIndex < m_NewBlocks.size(); ++newBlockIndex)
+        {
+            NewBlock& newBlock = m_NewBlocks[newBlockIndex];
+            if(newBlock.pBlockVector == pBlockVector)
+            {
+                ++newBlockCount;
+                maxExistingBlockSize = VMA_MAX(maxExistingBlockSize, newBlock.size);
+                const VkDeviceSize offset = VmaAlignUp(newBlock.usedSize + VMA_DEBUG_MARGIN, alignment);
+                if(offset + size + VMA_DEBUG_MARGIN <= newBlock.size)
+                {
+                    newBlock.usedSize = offset + size;
+                    return true;
+                }
+            }
+        }
 
-void VmaRecorder::RecordDefragmentationBegin(uint32_t frameIndex,
-    const VmaDefragmentationInfo2& info,
-    VmaDefragmentationContext ctx)
-{
-    CallParams callParams;
-    GetBasicParams(callParams);
+        // 3. New block, sized like VmaBlockVector::AllocatePage() does. Default pools prefer dedicated
+        // allocation to a block that would exceed the budget, so they try smaller blocks first.
+        const VkDeviceSize freeBudget = GetFreeBudget(heapIndex);
+        if(canAllocate &&
+            size + 2 * VMA_DEBUG_MARGIN <= preferredBlockSize &&
+            (isCustomPool || size <= freeBudget) &&
+            pBlockVector->CanCreateBlocks(newBlockCount + 1))
+        {
+            const VkDeviceSize usedSize = VmaAlignUp<VkDeviceSize>(VMA_DEBUG_MARGIN, alignment) + size;
+            uint32_t newBlockSizeShift = 0;
+            VkDeviceSize newBlockSize = pBlockVector->CalcNewBlockSize(size, maxExistingBlockSize, newBlockSizeShift);
+            for(;;)
+            {
+                if((isCustomPool || newBlockSize <= freeBudget) &&
+                    (poolQuota == VK_NULL_HANDLE || TryChargeQuota(poolQuota, newBlockSize)))
+                {
+                    if(usedSize + VMA_DEBUG_MARGIN > newBlockSize)
+                    {
+                        // Like in AllocatePage(), allocation that doesn't fit in the new block fails.
+                        if(poolQuota != VK_NULL_HANDLE)
+                        {
+                            ReleaseQuota(poolQuota, newBlockSize);
+                        }
+                        break;
+                    }
+                    const NewBlock newBlock = { pBlockVector, newBlockSize, usedSize };
+                    m_NewBlocks.push_back(newBlock);
+                    AddNewDeviceMemory(heapIndex, newBlockSize);
+                    return true;
+                }
+                if(!pBlockVector->ShrinkNewBlockSize(size, newBlockSize, newBlockSizeShift))
+                {
+                    break;
+                }
+            }
+        }
+        if(isCustomPool)
+        {
+            outPlacement.memoryTypeIndex = UINT32_MAX;
+            outPlacement.newDeviceMemory = VK_FALSE;
+            return false;
+        }
+    }
 
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaDefragmentationBegin,%u,", callParams.threadId, callParams.time, frameIndex,
-        info.flags);
-    PrintPointerList(info.allocationCount, info.pAllocations);
-    fprintf(m_File, ",");
-    PrintPointerList(info.poolCount, info.pPools);
-    fprintf(m_File, ",%llu,%u,%llu,%u,%p,%p\n",
-        info.maxCpuBytesToMove,
-        info.maxCpuAllocationsToMove,
-        info.maxGpuBytesToMove,
-        info.maxGpuAllocationsToMove,
-        info.commandBuffer,
-        ctx);
-    Flush();
+    // 4. Dedicated allocation.
+    if(canAllocate &&
+        ((createInfo.flags & VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT) == 0 || size <= GetFreeBudget(heapIndex)))
+    {
+        outPlacement.newDeviceMemory = VK_TRUE;
+        AddNewDeviceMemory(heapIndex, size);
+        return true;
+    }
+    outPlacement.memoryTypeIndex = UINT32_MAX;
+    outPlacement.newDeviceMemory = VK_FALSE;
+    return false;
 }
 
-void VmaRecorder::RecordDefragmentationEnd(uint32_t frameIndex,
-    VmaDefragmentationContext ctx)
+VkDeviceSize VmaAllocationFitChecker::GetFreeBudget(uint32_t heapIndex) const
 {
-    CallParams callParams;
-    GetBasicParams(callParams);
-
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaDefragmentationEnd,%p\n", callParams.threadId, callParams.time, frameIndex,
-        ctx);
-    Flush();
+    const VkDeviceSize usage = m_Budget[heapIndex].usage + m_NewBytes[heapIndex];
+    return usage < m_Budget[heapIndex].budget ? m_Budget[heapIndex].budget - usage : 0;
 }
 
-void VmaRecorder::RecordSetPoolName(uint32_t frameIndex,
-    VmaPool pool,
-    const char* name)
+void VmaAllocationFitChecker::AddNewDeviceMemory(uint32_t heapIndex, VkDeviceSize size)
 {
-    CallParams callParams;
-    GetBasicParams(callParams);
-
-    VmaMutexLock lock(m_FileMutex, m_UseMutex);
-    fprintf(m_File, "%u,%.3f,%u,vmaSetPoolName,%p,%s\n", callParams.threadId, callParams.time, frameIndex,
-        pool, name != VMA_NULL ? name : "");
-    Flush();
+    m_NewBytes[heapIndex] += size;
+    ++m_NewDeviceMemoryCount;
 }
 
-VmaRecorder::UserDataString::UserDataString(VmaAllocationCreateFlags allocFlags, const void* pUserData)
+bool VmaAllocationFitChecker::TryChargeQuota(VmaQuota quota, VkDeviceSize size)
 {
-    if(pUserData != VMA_NULL)
+    for(VmaQuota currQuota = quota; currQuota != VK_NULL_HANDLE; currQuota = currQuota->GetParent())
     {
-        if((allocFlags & VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT) != 0)
+        const QuotaCharge* const pCharge = FindQuotaCharge(currQuota);
+        const VkDeviceSize chargedSize = pCharge != VMA_NULL ? pCharge->size : 0;
+        if(chargedSize + size > currQuota->GetFreeSize())
         {
-            m_Str = (const char*)pUserData;
+            return false;
+        }
+    }
+    for(VmaQuota currQuota = quota; currQuota != VK_NULL_HANDLE; currQuota = currQuota->GetParent())
+    {
+        QuotaCharge* const pCharge = FindQuotaCharge(currQuota);
+        if(pCharge != VMA_NULL)
+        {
+            pCharge->size += size;
         }
         else
         {
-            // If VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT is not specified, convert the string's memory address to a string and store it.
-            snprintf(m_PtrStr, 17, "%p", pUserData);
-            m_Str = m_PtrStr;
+            const QuotaCharge newCharge = { currQuota, size };
+            m_QuotaCharges.push_back(newCharge);
         }
     }
-    else
+    return true;
+}
+
+void VmaAllocationFitChecker::ReleaseQuota(VmaQuota quota, VkDeviceSize size)
+{
+    for(VmaQuota currQuota = quota; currQuota != VK_NULL_HANDLE; currQuota = currQuota->GetParent())
     {
-        m_Str = "";
+        QuotaCharge* const pCharge = FindQuotaCharge(currQuota);
+        VMA_ASSERT(pCharge != VMA_NULL && pCharge->size >= size);
+        pCharge->size -= size;
     }
 }
 
-void VmaRecorder::WriteConfiguration(
-    const VkPhysicalDeviceProperties& devProps,
-    const VkPhysicalDeviceMemoryProperties& memProps,
-    uint32_t vulkanApiVersion,
-    bool dedicatedAllocationExtensionEnabled,
-    bool bindMemory2ExtensionEnabled,
-    bool memoryBudgetExtensionEnabled,
-    bool deviceCoherentMemoryExtensionEnabled)
+VmaAllocationFitChecker::QuotaCharge* VmaAllocationFitChecker::FindQuotaCharge(VmaQuota quota)
 {
-    fprintf(m_File, "Config,Begin\n");
-
-    fprintf(m_File, "VulkanApiVersion,%u,%u\n", VK_VERSION_MAJOR(vulkanApiVersion), VK_VERSION_MINOR(vulkanApiVersion));
+    for(size_t chargeIndex = 0; chargeIndex < m_QuotaCharges.size(); ++chargeIndex)
+    {
+        if(m_QuotaCharges[chargeIndex].quota == quota)
+        {
+            return &m_QuotaCharges[chargeIndex];
+        }
+    }
+    return VMA_NULL;
+}
 
-    fprintf(m_File, "PhysicalDevice,apiVersion,%u\n", devProps.apiVersion);
-    fprintf(m_File, "PhysicalDevice,driverVersion,%u\n", devProps.driverVersion);
-    fprintf(m_File, "PhysicalDevice,vendorID,%u\n", devProps.vendorID);
-    fprintf(m_File, "PhysicalDevice,deviceID,%u\n", devProps.deviceID);
-    fprintf(m_File, "PhysicalDevice,deviceType,%u\n", devProps.deviceType);
-    fprintf(m_File, "PhysicalDevice,deviceName,%s\n", devProps.deviceName);
+VkResult VmaAllocator_T::CheckAllocationsFit(
+    const VkMemoryRequirements* pVkMemoryRequirements,
+    const VmaAllocationCreateInfo* pCreateInfos,
+    size_t allocationCount,
+    VmaAllocationFitPlacement* pPlacements,
+    VmaAllocationFitInfo* pFitInfo)
+{
+    VmaAllocationFitChecker checker(this);
+    VkResult res = VK_SUCCESS;
+    for(size_t allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
+    {
+        VmaAllocationFitPlacement placement = {};
+        const VkResult allocRes = checker.Check(pVkMemoryRequirements[allocIndex], pCreateInfos[allocIndex], placement);
+        if(allocRes != VK_SUCCESS && res == VK_SUCCESS)
+        {
+            res = allocRes;
+        }
+        if(pPlacements != VMA_NULL)
+        {
+            pPlacements[allocIndex] = placement;
+        }
+    }
+    if(pFitInfo != VMA_NULL)
+    {
+        checker.GetFitInfo(*pFitInfo);
+    }
+    return res;
+}
 
-    fprintf(m_File, "PhysicalDeviceLimits,maxMemoryAllocationCount,%u\n", devProps.limits.maxMemoryAllocationCount);
-    fprintf(m_File, "PhysicalDeviceLimits,bufferImageGranularity,%llu\n", devProps.limits.bufferImageGranularity);
-    fprintf(m_File, "PhysicalDeviceLimits,nonCoherentAtomSize,%llu\n", devProps.limits.nonCoherentAtomSize);
+VkResult VmaAllocator_T::FindAllocationByMemory(VkDeviceMemory memory, VkDeviceSize offset, VmaAllocation* pAllocation)
+{
+    *pAllocation = VK_NULL_HANDLE;
+    bool memoryFound = false;
 
-    fprintf(m_File, "PhysicalDeviceMemory,HeapCount,%u\n", memProps.memoryHeapCount);
-    for(uint32_t i = 0; i < memProps.memoryHeapCount; ++i)
+    // Default pools.
+    for(uint32_t memTypeIndex = 0; !memoryFound && memTypeIndex < GetMemoryTypeCount(); ++memTypeIndex)
     {
-        fprintf(m_File, "PhysicalDeviceMemory,Heap,%u,size,%llu\n", i, memProps.memoryHeaps[i].size);
-        fprintf(m_File, "PhysicalDeviceMemory,Heap,%u,flags,%u\n", i, memProps.memoryHeaps[i].flags);
+        VmaBlockVector* const pBlockVector = m_pBlockVectors[memTypeIndex];
+        VMA_ASSERT(pBlockVector);
+        memoryFound = pBlockVector->FindAllocation(memory, offset, *pAllocation);
     }
-    fprintf(m_File, "PhysicalDeviceMemory,TypeCount,%u\n", memProps.memoryTypeCount);
-    for(uint32_t i = 0; i < memProps.memoryTypeCount; ++i)
+
+    // Custom pools.
+    if(!memoryFound)
     {
-        fprintf(m_File, "PhysicalDeviceMemory,Type,%u,heapIndex,%u\n", i, memProps.memoryTypes[i].heapIndex);
-        fprintf(m_File, "PhysicalDeviceMemory,Type,%u,propertyFlags,%u\n", i, memProps.memoryTypes[i].propertyFlags);
+        VmaMutexLockRead lock(m_PoolsMutex, m_UseMutex);
+        for(size_t poolIndex = 0, poolCount = m_Pools.size(); !memoryFound && poolIndex < poolCount; ++poolIndex)
+        {
+            memoryFound = m_Pools[poolIndex]->m_BlockVector.FindAllocation(memory, offset, *pAllocation);
+        }
     }
 
-    fprintf(m_File, "Extension,VK_KHR_dedicated_allocation,%u\n", dedicatedAllocationExtensionEnabled ? 1 : 0);
-    fprintf(m_File, "Extension,VK_KHR_bind_memory2,%u\n", bindMemory2ExtensionEnabled ? 1 : 0);
-    fprintf(m_File, "Extension,VK_EXT_memory_budget,%u\n", memoryBudgetExtensionEnabled ? 1 : 0);
-    fprintf(m_File, "Extension,VK_AMD_device_coherent_memory,%u\n", deviceCoherentMemoryExtensionEnabled ? 1 : 0);
-
-    fprintf(m_File, "Macro,VMA_DEBUG_ALWAYS_DEDICATED_MEMORY,%u\n", VMA_DEBUG_ALWAYS_DEDICATED_MEMORY ? 1 : 0);
-    fprintf(m_File, "Macro,VMA_DEBUG_ALIGNMENT,%llu\n", (VkDeviceSize)VMA_DEBUG_ALIGNMENT);
-    fprintf(m_File, "Macro,VMA_DEBUG_MARGIN,%llu\n", (VkDeviceSize)VMA_DEBUG_MARGIN);
-    fprintf(m_File, "Macro,VMA_DEBUG_INITIALIZE_ALLOCATIONS,%u\n", VMA_DEBUG_INITIALIZE_ALLOCATIONS ? 1 : 0);
-    fprintf(m_File, "Macro,VMA_DEBUG_DETECT_CORRUPTION,%u\n", VMA_DEBUG_DETECT_CORRUPTION ? 1 : 0);
-    fprintf(m_File, "Macro,VMA_DEBUG_GLOBAL_MUTEX,%u\n", VMA_DEBUG_GLOBAL_MUTEX ? 1 : 0);
-    fprintf(m_File, "Macro,VMA_DEBUG_MIN_BUFFER_IMAGE_GRANULARITY,%llu\n", (VkDeviceSize)VMA_DEBUG_MIN_BUFFER_IMAGE_GRANULARITY);
-    fprintf(m_File, "Macro,VMA_SMALL_HEAP_MAX_SIZE,%llu\n", (VkDeviceSize)VMA_SMALL_HEAP_MAX_SIZE);
-    fprintf(m_File, "Macro,VMA_DEFAULT_LARGE_HEAP_BLOCK_SIZE,%llu\n", (VkDeviceSize)VMA_DEFAULT_LARGE_HEAP_BLOCK_SIZE);
+    // Dedicated allocations.
+    for(uint32_t memTypeIndex = 0; !memoryFound && memTypeIndex < GetMemoryTypeCount(); ++memTypeIndex)
+    {
+        VmaMutexLockRead dedicatedAllocationsLock(m_DedicatedAllocationsMutex[memTypeIndex], m_UseMutex);
+        const AllocationVectorType* const pDedicatedAllocVector = m_pDedicatedAllocations[memTypeIndex];
+        VMA_ASSERT(pDedicatedAllocVector);
+        for(size_t allocIndex = 0, allocCount = pDedicatedAllocVector->size(); allocIndex < allocCount; ++allocIndex)
+        {
+            const VmaAllocation alloc = (*pDedicatedAllocVector)[allocIndex];
+            if(alloc->GetMemory() == memory)
+            {
+                memoryFound = true;
+                if(offset < alloc->GetSize())
+                {
+                    *pAllocation = alloc;
+                }
+                break;
+            }
+        }
+    }
 
-    fprintf(m_File, "Config,End\n");
+    return *pAllocation != VK_NULL_HANDLE ? VK_SUCCESS : VK_ERROR_FEATURE_NOT_PRESENT;
 }
 
-void VmaRecorder::GetBasicParams(CallParams& outParams)
+void VmaAllocator_T::FreeMemory(
+    size_t allocationCount,
+    const VmaAllocation* pAllocations)
 {
-    #if defined(_WIN32)
-        outParams.threadId = GetCurrentThreadId();
-    #else
-        // Use C++11 features to get thread id and convert it to uint32_t.
-        // There is room for optimization since sstream is quite slow.
-        // Is there a better way to convert std::this_thread::get_id() to uint32_t?
-        std::thread::id thread_id = std::this_thread::get_id();
-        stringstream thread_id_to_string_converter;
-        thread_id_to_string_converter << thread_id;
-        string thread_id_as_string = thread_id_to_string_converter.str();
-        outParams.threadId = static_cast<uint32_t>(std::stoi(thread_id_as_string.c_str()));
-    #endif
+    VMA_ASSERT(pAllocations);
 
-    auto current_time = std::chrono::high_resolution_clock::now();
+    for(size_t allocIndex = allocationCount; allocIndex--; )
+    {
+        VmaAllocation allocation = pAllocations[allocIndex];
 
-    outParams.time = std::chrono::duration<double, std::chrono::seconds::period>(current_time - m_RecordingStartTime).count();
-}
+        if(allocation != VK_NULL_HANDLE)
+        {
+            if(TouchAllocation(allocation))
+            {
+                if(VMA_DEBUG_INITIALIZE_ALLOCATIONS)
+                {
+                    FillAllocation(allocation, VMA_ALLOCATION_FILL_PATTERN_DESTROYED);
+                }
+
+                switch(allocation->GetType())
+                {
+                case VmaAllocation_T::ALLOCATION_TYPE_BLOCK:
+                    {
+                        VmaBlockVector* pBlockVector = VMA_NULL;
+                        VmaPool hPool = allocation->GetBlock()->GetParentPool();
+                        if(hPool != VK_NULL_HANDLE)
+                        {
+                            pBlockVector = &hPool->m_BlockVector;
+                        }
+                        else
+                        {
+                            const uint32_t memTypeIndex = allocation->GetMemoryTypeIndex();
+                            pBlockVector = m_pBlockVectors[memTypeIndex];
+                        }
+                        pBlockVector->Free(allocation);
+                    }
+                    break;
+                case VmaAllocation_T::ALLOCATION_TYPE_DEDICATED:
+                    FreeDedicatedMemory(allocation);
+                    break;
+                default:
+                    VMA_ASSERT(0);
+                }
+            }
 
-void VmaRecorder::PrintPointerList(uint64_t count, const VmaAllocation* pItems)
-{
-    if(count)
-    {
-        fprintf(m_File, "%p", pItems[0]);
-        for(uint64_t i = 1; i < count; ++i)
-        {
-            fprintf(m_File, " %p", pItems[i]);
+            // Do this regardless of whether the allocation is lost.
+            DestroyAllocationObject(allocation);
         }
     }
 }
 
-void VmaRecorder::Flush()
-{
-    if((m_Flags & VMA_RECORD_FLUSH_AFTER_CALL_BIT) != 0)
-    {
-        fflush(m_File);
-    }
-}
-
-#endif // #if VMA_RECORDING_ENABLED
-
-////////////////////////////////////////////////////////////////////////////////
-// VmaAllocationObjectAllocator
-
-VmaAllocationObjectAllocator::VmaAllocationObjectAllocator(const VkAllocationCallbacks* pAllocationCallbacks) :
-    m_Allocator(pAllocationCallbacks, 1024)
-{
-}
-
-template<typename... Types> VmaAllocation VmaAllocationObjectAllocator::Allocate(Types... args)
+void VmaAllocator_T::FreeMemoryBatch(
+    size_t allocationCount,
+    const VmaAllocation* pAllocations)
 {
-    VmaMutexLock mutexLock(m_Mutex);
-    return m_Allocator.Alloc<Types...>(std::forward<Types>(args)...);
-}
+    VMA_ASSERT(allocationCount == 0 || pAllocations);
 
-void VmaAllocationObjectAllocator::Free(VmaAllocation hAlloc)
-{
-    VmaMutexLock mutexLock(m_Mutex);
-    m_Allocator.Free(hAlloc);
-}
+    // Orders allocations so that ones from the same block vector, then the same block, are adjacent and sorted by offset.
+    struct BlockAllocationLess
+    {
+        bool operator()(const VmaAllocation lhs, const VmaAllocation rhs) const
+        {
+            const VmaDeviceMemoryBlock* const pLhsBlock = lhs->GetBlock();
+            const VmaDeviceMemoryBlock* const pRhsBlock = rhs->GetBlock();
+            if(pLhsBlock->GetParentPool() != pRhsBlock->GetParentPool())
+            {
+                return pLhsBlock->GetParentPool() < pRhsBlock->GetParentPool();
+            }
+            if(lhs->GetMemoryTypeIndex() != rhs->GetMemoryTypeIndex())
+            {
+                return lhs->GetMemoryTypeIndex() < rhs->GetMemoryTypeIndex();
+            }
+            if(pLhsBlock != pRhsBlock)
+            {
+                return pLhsBlock < pRhsBlock;
+            }
+            return lhs->GetOffset() < rhs->GetOffset();
+        }
+    };
 
-////////////////////////////////////////////////////////////////////////////////
-// VmaAllocator_T
+    const VmaStlAllocator<VmaAllocation> allocationAllocator(GetAllocationCallbacks());
+    AllocationVectorType blockAllocations(allocationAllocator);
 
-VmaAllocator_T::VmaAllocator_T(const VmaAllocatorCreateInfo* pCreateInfo) :
-    m_UseMutex((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_EXTERNALLY_SYNCHRONIZED_BIT) == 0),
-    m_VulkanApiVersion(pCreateInfo->vulkanApiVersion != 0 ? pCreateInfo->vulkanApiVersion : VK_API_VERSION_1_0),
-    m_UseKhrDedicatedAllocation((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_KHR_DEDICATED_ALLOCATION_BIT) != 0),
-    m_UseKhrBindMemory2((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_KHR_BIND_MEMORY2_BIT) != 0),
-    m_UseExtMemoryBudget((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT) != 0),
-    m_UseAmdDeviceCoherentMemory((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_AMD_DEVICE_COHERENT_MEMORY_BIT) != 0),
-    m_UseKhrBufferDeviceAddress((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT) != 0),
-    m_hDevice(pCreateInfo->device),
-    m_hInstance(pCreateInfo->instance),
-    m_AllocationCallbacksSpecified(pCreateInfo->pAllocationCallbacks != VMA_NULL),
-    m_AllocationCallbacks(pCreateInfo->pAllocationCallbacks ?
-        *pCreateInfo->pAllocationCallbacks : VmaEmptyAllocationCallbacks),
-    m_AllocationObjectAllocator(&m_AllocationCallbacks),
-    m_HeapSizeLimitMask(0),
-    m_PreferredLargeHeapBlockSize(0),
-    m_PhysicalDevice(pCreateInfo->physicalDevice),
-    m_CurrentFrameIndex(0),
-    m_GpuDefragmentationMemoryTypeBits(UINT32_MAX),
-    m_Pools(VmaStlAllocator<VmaPool>(GetAllocationCallbacks())),
-    m_NextPoolId(0),
-    m_GlobalMemoryTypeBits(UINT32_MAX)
-#if VMA_RECORDING_ENABLED
-    ,m_pRecorder(VMA_NULL)
-#endif
-{
-    if(m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0))
+    for(size_t allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
     {
-        m_UseKhrDedicatedAllocation = false;
-        m_UseKhrBindMemory2 = false;
-    }
+        VmaAllocation allocation = pAllocations[allocIndex];
+        if(allocation == VK_NULL_HANDLE)
+        {
+            continue;
+        }
 
-    if(VMA_DEBUG_DETECT_CORRUPTION)
-    {
-        // Needs to be multiply of uint32_t size because we are going to write VMA_CORRUPTION_DETECTION_MAGIC_VALUE to it.
-        VMA_ASSERT(VMA_DEBUG_MARGIN % sizeof(uint32_t) == 0);
+        if(TouchAllocation(allocation))
+        {
+            switch(allocation->GetType())
+            {
+            case VmaAllocation_T::ALLOCATION_TYPE_BLOCK:
+                blockAllocations.push_back(allocation);
+                break;
+            case VmaAllocation_T::ALLOCATION_TYPE_DEDICATED:
+                if(VMA_DEBUG_INITIALIZE_ALLOCATIONS)
+                {
+                    FillAllocation(allocation, VMA_ALLOCATION_FILL_PATTERN_DESTROYED);
+                }
+                FreeDedicatedMemory(allocation);
+                break;
+            default:
+                VMA_ASSERT(0);
+            }
+        }
     }
 
-    VMA_ASSERT(pCreateInfo->physicalDevice && pCreateInfo->device && pCreateInfo->instance);
+    VMA_SORT(blockAllocations.begin(), blockAllocations.end(), BlockAllocationLess());
 
-    if(m_VulkanApiVersion < VK_MAKE_VERSION(1, 1, 0))
+    for(size_t allocIndex = 0; allocIndex < blockAllocations.size(); )
     {
-#if !(VMA_DEDICATED_ALLOCATION)
-        if((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_KHR_DEDICATED_ALLOCATION_BIT) != 0)
+        const VmaAllocation firstAllocation = blockAllocations[allocIndex];
+        const VmaPool hPool = firstAllocation->GetBlock()->GetParentPool();
+        const uint32_t memTypeIndex = firstAllocation->GetMemoryTypeIndex();
+        size_t vectorAllocEnd = allocIndex + 1;
+        while(vectorAllocEnd < blockAllocations.size() &&
+            blockAllocations[vectorAllocEnd]->GetBlock()->GetParentPool() == hPool &&
+            blockAllocations[vectorAllocEnd]->GetMemoryTypeIndex() == memTypeIndex)
         {
-            VMA_ASSERT(0 && "VMA_ALLOCATOR_CREATE_KHR_DEDICATED_ALLOCATION_BIT set but required extensions are disabled by preprocessor macros.");
+            ++vectorAllocEnd;
         }
-#endif
-#if !(VMA_BIND_MEMORY2)
-        if((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_KHR_BIND_MEMORY2_BIT) != 0)
+        VmaBlockVector* const pBlockVector = hPool != VK_NULL_HANDLE ?
+            &hPool->m_BlockVector : m_pBlockVectors[memTypeIndex];
+        pBlockVector->FreeBatch(blockAllocations.data() + allocIndex, vectorAllocEnd - allocIndex);
+        allocIndex = vectorAllocEnd;
+    }
+
+    for(size_t allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
+    {
+        if(pAllocations[allocIndex] != VK_NULL_HANDLE)
         {
-            VMA_ASSERT(0 && "VMA_ALLOCATOR_CREATE_KHR_BIND_MEMORY2_BIT set but required extension is disabled by preprocessor macros.");
+            DestroyAllocationObject(pAllocations[allocIndex]);
         }
-#endif
     }
-#if !(VMA_MEMORY_BUDGET)
-    if((pCreateInfo->flags & VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT) != 0)
+}
+
+void VmaAllocator_T::DestroyAllocationObject(VmaAllocation allocation)
+{
+    if(allocation->GetScope() != VK_NULL_HANDLE)
     {
-        VMA_ASSERT(0 && "VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT set but required extension is disabled by preprocessor macros.");
+        allocation->GetScope()->Remove(allocation);
     }
-#endif
-#if !(VMA_BUFFER_DEVICE_ADDRESS)
-    if(m_UseKhrBufferDeviceAddress)
+    // Lost allocations still account to Budget.AllocationBytes.
+    m_Budget.RemoveAllocation(MemoryTypeIndexToHeapIndex(allocation->GetMemoryTypeIndex()), allocation->GetSize());
+    m_TagStats.RemoveAllocation(allocation->GetTag(), allocation->GetMemoryTypeIndex(), allocation->GetSize());
+    PublishAllocationSize(allocation, allocation->GetSize(), 0);
+    if(allocation->GetQuota() != VK_NULL_HANDLE)
     {
-        VMA_ASSERT(0 && "VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT is set but required extension or Vulkan 1.2 is not available in your Vulkan header or its support in VMA has been disabled by a preprocessor macro.");
+        allocation->GetQuota()->Release(allocation->GetQuotaCharge());
     }
-#endif
-#if VMA_VULKAN_VERSION < 1002000
-    if(m_VulkanApiVersion >= VK_MAKE_VERSION(1, 2, 0))
+    allocation->SetUserData(this, VMA_NULL);
+    m_AllocationObjectAllocator.Free(allocation);
+}
+
+VkResult VmaAllocator_T::ResizeAllocation(
+    const VmaAllocation alloc,
+    VkDeviceSize newSize)
+{
+    if(newSize == 0 || alloc->GetLastUseFrameIndex() == VMA_FRAME_INDEX_LOST)
     {
-        VMA_ASSERT(0 && "vulkanApiVersion >= VK_API_VERSION_1_2 but required Vulkan version is disabled by preprocessor macros.");
+        return VK_ERROR_VALIDATION_FAILED_EXT;
     }
-#endif
-#if VMA_VULKAN_VERSION < 1001000
-    if(m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0))
+    if(newSize == alloc->GetSize())
     {
-        VMA_ASSERT(0 && "vulkanApiVersion >= VK_API_VERSION_1_1 but required Vulkan version is disabled by preprocessor macros.");
+        return VK_SUCCESS;
     }
-#endif
-
-    memset(&m_DeviceMemoryCallbacks, 0 ,sizeof(m_DeviceMemoryCallbacks));
-    memset(&m_PhysicalDeviceProperties, 0, sizeof(m_PhysicalDeviceProperties));
-    memset(&m_MemProps, 0, sizeof(m_MemProps));
-
-    memset(&m_pBlockVectors, 0, sizeof(m_pBlockVectors));
-    memset(&m_pDedicatedAllocations, 0, sizeof(m_pDedicatedAllocations));
-    memset(&m_VulkanFunctions, 0, sizeof(m_VulkanFunctions));
 
-    if(pCreateInfo->pDeviceMemoryCallbacks != VMA_NULL)
+    switch(alloc->GetType())
     {
-        m_DeviceMemoryCallbacks.pUserData = pCreateInfo->pDeviceMemoryCallbacks->pUserData;
-        m_DeviceMemoryCallbacks.pfnAllocate = pCreateInfo->pDeviceMemoryCallbacks->pfnAllocate;
-        m_DeviceMemoryCallbacks.pfnFree = pCreateInfo->pDeviceMemoryCallbacks->pfnFree;
-    }
-
-    ImportVulkanFunctions(pCreateInfo->pVulkanFunctions);
-
-    (*m_VulkanFunctions.vkGetPhysicalDeviceProperties)(m_PhysicalDevice, &m_PhysicalDeviceProperties);
-    (*m_VulkanFunctions.vkGetPhysicalDeviceMemoryProperties)(m_PhysicalDevice, &m_MemProps);
-
-    VMA_ASSERT(VmaIsPow2(VMA_DEBUG_ALIGNMENT));
-    VMA_ASSERT(VmaIsPow2(VMA_DEBUG_MIN_BUFFER_IMAGE_GRANULARITY));
-    VMA_ASSERT(VmaIsPow2(m_PhysicalDeviceProperties.limits.bufferImageGranularity));
-    VMA_ASSERT(VmaIsPow2(m_PhysicalDeviceProperties.limits.nonCoherentAtomSize));
+    case VmaAllocation_T::ALLOCATION_TYPE_BLOCK:
+        {
+            VmaBlockVector* pBlockVector = VMA_NULL;
+            VmaPool hPool = alloc->GetBlock()->GetParentPool();
+            if(hPool != VK_NULL_HANDLE)
+            {
+                pBlockVector = &hPool->m_BlockVector;
+            }
+            else
+            {
+                pBlockVector = m_pBlockVectors[alloc->GetMemoryTypeIndex()];
+            }
 
-    m_PreferredLargeHeapBlockSize = (pCreateInfo->preferredLargeHeapBlockSize != 0) ?
-        pCreateInfo->preferredLargeHeapBlockSize : static_cast<VkDeviceSize>(VMA_DEFAULT_LARGE_HEAP_BLOCK_SIZE);
+            const VmaQuota quota = alloc->GetQuota();
+            const VkDeviceSize oldSize = alloc->GetSize();
+            const VkDeviceSize oldCharge = alloc->GetQuotaCharge();
+            if(quota != VK_NULL_HANDLE && newSize > oldCharge && !quota->TryCharge(newSize - oldCharge))
+            {
+                return VK_ERROR_OUT_OF_POOL_MEMORY;
+            }
+            const VkResult res = pBlockVector->ResizeAllocation(alloc, newSize);
+            if(res == VK_SUCCESS)
+            {
+                // Size may have been aligned up, so take the one actually stored, like AddAllocation() did.
+                m_TagStats.ResizeAllocation(alloc->GetTag(), alloc->GetMemoryTypeIndex(), oldSize, alloc->GetSize());
+                PublishAllocationSize(alloc, oldSize, alloc->GetSize());
+            }
+            if(quota != VK_NULL_HANDLE)
+            {
+                if(res != VK_SUCCESS && newSize > oldCharge)
+                {
+                    quota->Release(newSize - oldCharge);
+                }
+                else if(res == VK_SUCCESS)
+                {
+                    if(newSize < oldCharge)
+                    {
+                        quota->Release(oldCharge - newSize);
+                    }
+                    alloc->SetQuota(quota, newSize);
+                }
+            }
+            return res;
+        }
+    case VmaAllocation_T::ALLOCATION_TYPE_DEDICATED:
+        // Dedicated allocation always occupies whole VkDeviceMemory.
+        return VK_ERROR_OUT_OF_POOL_MEMORY;
+    default:
+        VMA_ASSERT(0);
+        return VK_ERROR_OUT_OF_POOL_MEMORY;
+    }
+}
 
-    m_GlobalMemoryTypeBits = CalculateGlobalMemoryTypeBits();
+VkResult VmaAllocator_T::BalanceBarMemory(
+    const VmaBarBalanceInfo& info,
+    uint32_t* pMoveCount,
+    VmaBarMove* pMoves)
+{
+    const uint32_t maxMoveCount = pMoves != VMA_NULL ? *pMoveCount : 0;
+    *pMoveCount = 0;
 
-    if(pCreateInfo->pHeapSizeLimit != VMA_NULL)
+    // Split memory types into BAR (DEVICE_LOCAL + HOST_VISIBLE) and plain DEVICE_LOCAL.
+    uint32_t barMemoryTypeBits = 0;
+    uint32_t deviceMemoryTypeBits = 0;
+    uint32_t barHeapIndex = UINT32_MAX;
+    const uint32_t memoryTypeBits = info.memoryTypeBits & m_GlobalMemoryTypeBits;
+    for(uint32_t memTypeIndex = 0; memTypeIndex < GetMemoryTypeCount(); ++memTypeIndex)
     {
-        for(uint32_t heapIndex = 0; heapIndex < GetMemoryHeapCount(); ++heapIndex)
+        if((memoryTypeBits & (1u << memTypeIndex)) == 0)
         {
-            const VkDeviceSize limit = pCreateInfo->pHeapSizeLimit[heapIndex];
-            if(limit != VK_WHOLE_SIZE)
+            continue;
+        }
+        const VkMemoryPropertyFlags flags = m_MemProps.memoryTypes[memTypeIndex].propertyFlags;
+        if((flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0)
+        {
+            if((flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0)
             {
-                m_HeapSizeLimitMask |= 1u << heapIndex;
-                if(limit < m_MemProps.memoryHeaps[heapIndex].size)
+                barMemoryTypeBits |= 1u << memTypeIndex;
+                if(barHeapIndex == UINT32_MAX)
                 {
-                    m_MemProps.memoryHeaps[heapIndex].size = limit;
+                    barHeapIndex = MemoryTypeIndexToHeapIndex(memTypeIndex);
                 }
             }
+            else
+            {
+                deviceMemoryTypeBits |= 1u << memTypeIndex;
+            }
         }
     }
-
-    for(uint32_t memTypeIndex = 0; memTypeIndex < GetMemoryTypeCount(); ++memTypeIndex)
+    if(barMemoryTypeBits == 0 || deviceMemoryTypeBits == 0)
     {
-        const VkDeviceSize preferredBlockSize = CalcPreferredBlockSize(memTypeIndex);
-
-        m_pBlockVectors[memTypeIndex] = vma_new(this, VmaBlockVector)(
-            this,
-            VK_NULL_HANDLE, // hParentPool
-            memTypeIndex,
-            preferredBlockSize,
-            0,
-            SIZE_MAX,
-            GetBufferImageGranularity(),
-            pCreateInfo->frameInUseCount,
-            false, // explicitBlockSize
-            false); // linearAlgorithm
-        // No need to call m_pBlockVectors[memTypeIndex][blockVectorTypeIndex]->CreateMinBlocks here,
-        // becase minBlockCount is 0.
-        m_pDedicatedAllocations[memTypeIndex] = vma_new(this, AllocationVectorType)(VmaStlAllocator<VmaAllocation>(GetAllocationCallbacks()));
-
+        return VK_ERROR_FEATURE_NOT_PRESENT;
     }
-}
 
-VkResult VmaAllocator_T::Init(const VmaAllocatorCreateInfo* pCreateInfo)
-{
-    VkResult res = VK_SUCCESS;
+    struct Candidate
+    {
+        VmaAllocation allocation;
+        uint32_t hostAccessCount;
+        bool inBar;
+        bool selected;
+    };
+    // Hottest first. On ties prefer allocations already in BAR, so they don't bounce back and forth.
+    struct CandidateHotterThan
+    {
+        bool operator()(const Candidate& lhs, const Candidate& rhs) const
+        {
+            if(lhs.hostAccessCount != rhs.hostAccessCount)
+            {
+                return lhs.hostAccessCount > rhs.hostAccessCount;
+            }
+            return lhs.inBar && !rhs.inBar;
+        }
+    };
+
+    const VmaStlAllocator<Candidate> candidateAllocator(GetAllocationCallbacks());
+    VmaVector< Candidate, VmaStlAllocator<Candidate> > candidates(candidateAllocator);
+    VkDeviceSize barBytes = 0;
+    for(uint32_t allocIndex = 0; allocIndex < info.allocationCount; ++allocIndex)
+    {
+        const VmaAllocation allocation = info.pAllocations[allocIndex];
+        if(allocation->GetLastUseFrameIndex() == VMA_FRAME_INDEX_LOST ||
+            (allocation->GetType() == VmaAllocation_T::ALLOCATION_TYPE_BLOCK && allocation->GetBlock()->GetParentPool() != VK_NULL_HANDLE))
+        {
+            continue;
+        }
 
-    if(pCreateInfo->pRecordSettings != VMA_NULL &&
-        !VmaStrIsEmpty(pCreateInfo->pRecordSettings->pFilePath))
-    {
-#if VMA_RECORDING_ENABLED
-        m_pRecorder = vma_new(this, VmaRecorder)();
-        res = m_pRecorder->Init(*pCreateInfo->pRecordSettings, m_UseMutex);
-        if(res != VK_SUCCESS)
+        Candidate candidate = {};
+        candidate.allocation = allocation;
+        // Counters of the library are restarted only when they are used.
+        candidate.hostAccessCount = info.pHostAccessCounts != VMA_NULL ?
+            info.pHostAccessCounts[allocIndex] : allocation->ResetHostAccessCount();
+        candidate.inBar = (barMemoryTypeBits & (1u << allocation->GetMemoryTypeIndex())) != 0;
+        if(candidate.inBar)
         {
-            return res;
+            barBytes += allocation->GetSize();
         }
-        m_pRecorder->WriteConfiguration(
-            m_PhysicalDeviceProperties,
-            m_MemProps,
-            m_VulkanApiVersion,
-            m_UseKhrDedicatedAllocation,
-            m_UseKhrBindMemory2,
-            m_UseExtMemoryBudget,
-            m_UseAmdDeviceCoherentMemory);
-        m_pRecorder->RecordCreateAllocator(GetCurrentFrameIndex());
-#else
-        VMA_ASSERT(0 && "VmaAllocatorCreateInfo::pRecordSettings used, but not supported due to VMA_RECORDING_ENABLED not defined to 1.");
-        return VK_ERROR_FEATURE_NOT_PRESENT;
-#endif
+        candidates.push_back(candidate);
     }
+    VMA_SORT(candidates.begin(), candidates.end(), CandidateHotterThan());
 
-#if VMA_MEMORY_BUDGET
-    if(m_UseExtMemoryBudget)
+    // Select the hottest allocations that fit in BAR space available to them.
+    VmaBudget barBudget = {};
+    GetBudget(&barBudget, barHeapIndex, 1);
+    VkDeviceSize allowedBarBytes = barBytes +
+        (barBudget.budget > barBudget.usage ? barBudget.budget - barBudget.usage : 0);
+    if(info.maxBarBytes != 0)
     {
-        UpdateVulkanBudget();
+        allowedBarBytes = VMA_MIN(allowedBarBytes, info.maxBarBytes);
     }
-#endif // #if VMA_MEMORY_BUDGET
-
-    return res;
-}
-
-VmaAllocator_T::~VmaAllocator_T()
-{
-#if VMA_RECORDING_ENABLED
-    if(m_pRecorder != VMA_NULL)
+    VkDeviceSize selectedBytes = 0;
+    VkDeviceSize promotedBytes = 0;
+    for(size_t candidateIndex = 0; candidateIndex < candidates.size(); ++candidateIndex)
     {
-        m_pRecorder->RecordDestroyAllocator(GetCurrentFrameIndex());
-        vma_delete(this, m_pRecorder);
+        Candidate& candidate = candidates[candidateIndex];
+        const VkDeviceSize size = candidate.allocation->GetSize();
+        if(candidate.hostAccessCount > 0 && selectedBytes + size <= allowedBarBytes)
+        {
+            candidate.selected = true;
+            selectedBytes += size;
+            if(!candidate.inBar)
+            {
+                promotedBytes += size;
+            }
+        }
     }
-#endif
 
-    VMA_ASSERT(m_Pools.empty());
+    VkResult res = VK_SUCCESS;
 
-    for(size_t i = GetMemoryTypeCount(); i--; )
+    // Move out the coldest unselected allocations, only as many as needed to make room.
+    VkDeviceSize bytesToDemote = barBytes + promotedBytes > allowedBarBytes ?
+        barBytes + promotedBytes - allowedBarBytes : 0;
+    for(size_t candidateIndex = candidates.size(); candidateIndex-- && bytesToDemote > 0; )
     {
-        if(m_pDedicatedAllocations[i] != VMA_NULL && !m_pDedicatedAllocations[i]->empty())
+        const Candidate& candidate = candidates[candidateIndex];
+        if(!candidate.inBar || candidate.selected)
         {
-            VMA_ASSERT(0 && "Unfreed dedicated allocations found.");
+            continue;
+        }
+        if(*pMoveCount == maxMoveCount)
+        {
+            return VK_INCOMPLETE;
+        }
+        VmaBarMove& move = pMoves[*pMoveCount];
+        if(AllocateBarMove(candidate.allocation, deviceMemoryTypeBits, false, &move.dstAllocation) == VK_SUCCESS)
+        {
+            move.srcAllocation = candidate.allocation;
+            move.promoted = VK_FALSE;
+            ++*pMoveCount;
+            bytesToDemote -= VMA_MIN(bytesToDemote, candidate.allocation->GetSize());
+        }
+        else
+        {
+            res = VK_INCOMPLETE;
         }
-
-        vma_delete(this, m_pDedicatedAllocations[i]);
-        vma_delete(this, m_pBlockVectors[i]);
     }
-}
 
-void VmaAllocator_T::ImportVulkanFunctions(const VmaVulkanFunctions* pVulkanFunctions)
-{
-#if VMA_STATIC_VULKAN_FUNCTIONS == 1
-    ImportVulkanFunctions_Static();
-#endif
-
-    if(pVulkanFunctions != VMA_NULL)
+    // Move in the selected allocations, hottest first.
+    for(size_t candidateIndex = 0; candidateIndex < candidates.size(); ++candidateIndex)
     {
-        ImportVulkanFunctions_Custom(pVulkanFunctions);
+        const Candidate& candidate = candidates[candidateIndex];
+        if(candidate.inBar || !candidate.selected)
+        {
+            continue;
+        }
+        if(*pMoveCount == maxMoveCount)
+        {
+            return VK_INCOMPLETE;
+        }
+        VmaBarMove& move = pMoves[*pMoveCount];
+        // Fails while space of allocations being moved out is not freed yet.
+        if(AllocateBarMove(candidate.allocation, barMemoryTypeBits, true, &move.dstAllocation) == VK_SUCCESS)
+        {
+            move.srcAllocation = candidate.allocation;
+            move.promoted = VK_TRUE;
+            ++*pMoveCount;
+        }
+        else
+        {
+            res = VK_INCOMPLETE;
+        }
     }
 
-#if VMA_DYNAMIC_VULKAN_FUNCTIONS == 1
-    ImportVulkanFunctions_Dynamic();
-#endif
-
-    ValidateVulkanFunctions();
+    return res;
 }
 
-#if VMA_STATIC_VULKAN_FUNCTIONS == 1
-
-void VmaAllocator_T::ImportVulkanFunctions_Static()
+VkResult VmaAllocator_T::AllocateBarMove(
+    VmaAllocation srcAllocation,
+    uint32_t memoryTypeBits,
+    bool promote,
+    VmaAllocation* pDstAllocation)
 {
-    // Vulkan 1.0
-    m_VulkanFunctions.vkGetPhysicalDeviceProperties = (PFN_vkGetPhysicalDeviceProperties)vkGetPhysicalDeviceProperties;
-    m_VulkanFunctions.vkGetPhysicalDeviceMemoryProperties = (PFN_vkGetPhysicalDeviceMemoryProperties)vkGetPhysicalDeviceMemoryProperties;
-    m_VulkanFunctions.vkAllocateMemory = (PFN_vkAllocateMemory)vkAllocateMemory;
-    m_VulkanFunctions.vkFreeMemory = (PFN_vkFreeMemory)vkFreeMemory;
-    m_VulkanFunctions.vkMapMemory = (PFN_vkMapMemory)vkMapMemory;
-    m_VulkanFunctions.vkUnmapMemory = (PFN_vkUnmapMemory)vkUnmapMemory;
-    m_VulkanFunctions.vkFlushMappedMemoryRanges = (PFN_vkFlushMappedMemoryRanges)vkFlushMappedMemoryRanges;
-    m_VulkanFunctions.vkInvalidateMappedMemoryRanges = (PFN_vkInvalidateMappedMemoryRanges)vkInvalidateMappedMemoryRanges;
-    m_VulkanFunctions.vkBindBufferMemory = (PFN_vkBindBufferMemory)vkBindBufferMemory;
-    m_VulkanFunctions.vkBindImageMemory = (PFN_vkBindImageMemory)vkBindImageMemory;
-    m_VulkanFunctions.vkGetBufferMemoryRequirements = (PFN_vkGetBufferMemoryRequirements)vkGetBufferMemoryRequirements;
-    m_VulkanFunctions.vkGetImageMemoryRequirements = (PFN_vkGetImageMemoryRequirements)vkGetImageMemoryRequirements;
-    m_VulkanFunctions.vkCreateBuffer = (PFN_vkCreateBuffer)vkCreateBuffer;
-    m_VulkanFunctions.vkDestroyBuffer = (PFN_vkDestroyBuffer)vkDestroyBuffer;
-    m_VulkanFunctions.vkCreateImage = (PFN_vkCreateImage)vkCreateImage;
-    m_VulkanFunctions.vkDestroyImage = (PFN_vkDestroyImage)vkDestroyImage;
-    m_VulkanFunctions.vkCmdCopyBuffer = (PFN_vkCmdCopyBuffer)vkCmdCopyBuffer;
+    VkMemoryRequirements vkMemReq = {};
+    vkMemReq.size = srcAllocation->GetSize();
+    vkMemReq.alignment = VMA_MAX(srcAllocation->GetAlignment(), (VkDeviceSize)1);
+    vkMemReq.memoryTypeBits = memoryTypeBits;
 
-    // Vulkan 1.1
-#if VMA_VULKAN_VERSION >= 1001000
-    if(m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0))
+    VmaAllocationCreateInfo createInfo = {};
+    createInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    createInfo.memoryTypeBits = memoryTypeBits;
+    if(promote)
     {
-        m_VulkanFunctions.vkGetBufferMemoryRequirements2KHR = (PFN_vkGetBufferMemoryRequirements2)vkGetBufferMemoryRequirements2;
-        m_VulkanFunctions.vkGetImageMemoryRequirements2KHR = (PFN_vkGetImageMemoryRequirements2)vkGetImageMemoryRequirements2;
-        m_VulkanFunctions.vkBindBufferMemory2KHR = (PFN_vkBindBufferMemory2)vkBindBufferMemory2;
-        m_VulkanFunctions.vkBindImageMemory2KHR = (PFN_vkBindImageMemory2)vkBindImageMemory2;
-        m_VulkanFunctions.vkGetPhysicalDeviceMemoryProperties2KHR = (PFN_vkGetPhysicalDeviceMemoryProperties2)vkGetPhysicalDeviceMemoryProperties2;
+        createInfo.flags |= VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT;
     }
-#endif
-}
-
-#endif // #if VMA_STATIC_VULKAN_FUNCTIONS == 1
-
-void VmaAllocator_T::ImportVulkanFunctions_Custom(const VmaVulkanFunctions* pVulkanFunctions)
-{
-    VMA_ASSERT(pVulkanFunctions != VMA_NULL);
-
-#define VMA_COPY_IF_NOT_NULL(funcName) \
-    if(pVulkanFunctions->funcName != VMA_NULL) m_VulkanFunctions.funcName = pVulkanFunctions->funcName;
-
-    VMA_COPY_IF_NOT_NULL(vkGetPhysicalDeviceProperties);
-    VMA_COPY_IF_NOT_NULL(vkGetPhysicalDeviceMemoryProperties);
-    VMA_COPY_IF_NOT_NULL(vkAllocateMemory);
-    VMA_COPY_IF_NOT_NULL(vkFreeMemory);
-    VMA_COPY_IF_NOT_NULL(vkMapMemory);
-    VMA_COPY_IF_NOT_NULL(vkUnmapMemory);
-    VMA_COPY_IF_NOT_NULL(vkFlushMappedMemoryRanges);
-    VMA_COPY_IF_NOT_NULL(vkInvalidateMappedMemoryRanges);
-    VMA_COPY_IF_NOT_NULL(vkBindBufferMemory);
-    VMA_COPY_IF_NOT_NULL(vkBindImageMemory);
-    VMA_COPY_IF_NOT_NULL(vkGetBufferMemoryRequirements);
-    VMA_COPY_IF_NOT_NULL(vkGetImageMemoryRequirements);
-    VMA_COPY_IF_NOT_NULL(vkCreateBuffer);
-    VMA_COPY_IF_NOT_NULL(vkDestroyBuffer);
-    VMA_COPY_IF_NOT_NULL(vkCreateImage);
-    VMA_COPY_IF_NOT_NULL(vkDestroyImage);
-    VMA_COPY_IF_NOT_NULL(vkCmdCopyBuffer);
-
-#if VMA_DEDICATED_ALLOCATION || VMA_VULKAN_VERSION >= 1001000
-    VMA_COPY_IF_NOT_NULL(vkGetBufferMemoryRequirements2KHR);
-    VMA_COPY_IF_NOT_NULL(vkGetImageMemoryRequirements2KHR);
-#endif
+    if(srcAllocation->IsUserDataString())
+    {
+        createInfo.flags |= VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT;
+    }
+    createInfo.pUserData = srcAllocation->GetUserData();
+    createInfo.scope = srcAllocation->GetScope();
+    createInfo.quota = srcAllocation->GetQuota();
+    createInfo.tag = srcAllocation->GetTag();
+    createInfo.lifetime = srcAllocation->GetLifetime();
 
-#if VMA_BIND_MEMORY2 || VMA_VULKAN_VERSION >= 1001000
-    VMA_COPY_IF_NOT_NULL(vkBindBufferMemory2KHR);
-    VMA_COPY_IF_NOT_NULL(vkBindImageMemory2KHR);
-#endif
+    const VkResult res = AllocateMemory(
+        vkMemReq,
+        false, // requiresDedicatedAllocation
+        false, // prefersDedicatedAllocation
+        VK_NULL_HANDLE, // dedicatedBuffer
+        UINT32_MAX, // dedicatedBufferUsage
+        VK_NULL_HANDLE, // dedicatedImage
+        createInfo,
+        srcAllocation->GetSuballocationType(),
+        1, // allocationCount
+        pDstAllocation);
 
-#if VMA_MEMORY_BUDGET
-    VMA_COPY_IF_NOT_NULL(vkGetPhysicalDeviceMemoryProperties2KHR);
+#if VMA_RECORDING_ENABLED
+    if(m_pRecorder != VMA_NULL)
+    {
+        m_pRecorder->RecordAllocateMemory(GetCurrentFrameIndex(), vkMemReq, createInfo, *pDstAllocation);
+    }
 #endif
 
-#undef VMA_COPY_IF_NOT_NULL
+    return res;
 }
 
-#if VMA_DYNAMIC_VULKAN_FUNCTIONS == 1
-
-void VmaAllocator_T::ImportVulkanFunctions_Dynamic()
+void VmaAllocator_T::GetReallocationParams(
+    const VmaAllocation alloc,
+    VkDeviceSize newSize,
+    const VmaAllocationCreateInfo* pCreateInfo,
+    VkMemoryRequirements& outMemReq,
+    VmaAllocationCreateInfo& outCreateInfo) const
 {
-#define VMA_FETCH_INSTANCE_FUNC(memberName, functionPointerType, functionNameString) \
-    if(m_VulkanFunctions.memberName == VMA_NULL) \
-        m_VulkanFunctions.memberName = \
-            (functionPointerType)vkGetInstanceProcAddr(m_hInstance, functionNameString);
-#define VMA_FETCH_DEVICE_FUNC(memberName, functionPointerType, functionNameString) \
-    if(m_VulkanFunctions.memberName == VMA_NULL) \
-        m_VulkanFunctions.memberName = \
-            (functionPointerType)vkGetDeviceProcAddr(m_hDevice, functionNameString);
-
-    VMA_FETCH_INSTANCE_FUNC(vkGetPhysicalDeviceProperties, PFN_vkGetPhysicalDeviceProperties, "vkGetPhysicalDeviceProperties");
-    VMA_FETCH_INSTANCE_FUNC(vkGetPhysicalDeviceMemoryProperties, PFN_vkGetPhysicalDeviceMemoryProperties, "vkGetPhysicalDeviceMemoryProperties");
-    VMA_FETCH_DEVICE_FUNC(vkAllocateMemory, PFN_vkAllocateMemory, "vkAllocateMemory");
-    VMA_FETCH_DEVICE_FUNC(vkFreeMemory, PFN_vkFreeMemory, "vkFreeMemory");
-    VMA_FETCH_DEVICE_FUNC(vkMapMemory, PFN_vkMapMemory, "vkMapMemory");
-    VMA_FETCH_DEVICE_FUNC(vkUnmapMemory, PFN_vkUnmapMemory, "vkUnmapMemory");
-    VMA_FETCH_DEVICE_FUNC(vkFlushMappedMemoryRanges, PFN_vkFlushMappedMemoryRanges, "vkFlushMappedMemoryRanges");
-    VMA_FETCH_DEVICE_FUNC(vkInvalidateMappedMemoryRanges, PFN_vkInvalidateMappedMemoryRanges, "vkInvalidateMappedMemoryRanges");
-    VMA_FETCH_DEVICE_FUNC(vkBindBufferMemory, PFN_vkBindBufferMemory, "vkBindBufferMemory");
-    VMA_FETCH_DEVICE_FUNC(vkBindImageMemory, PFN_vkBindImageMemory, "vkBindImageMemory");
-    VMA_FETCH_DEVICE_FUNC(vkGetBufferMemoryRequirements, PFN_vkGetBufferMemoryRequirements, "vkGetBufferMemoryRequirements");
-    VMA_FETCH_DEVICE_FUNC(vkGetImageMemoryRequirements, PFN_vkGetImageMemoryRequirements, "vkGetImageMemoryRequirements");
-    VMA_FETCH_DEVICE_FUNC(vkCreateBuffer, PFN_vkCreateBuffer, "vkCreateBuffer");
-    VMA_FETCH_DEVICE_FUNC(vkDestroyBuffer, PFN_vkDestroyBuffer, "vkDestroyBuffer");
-    VMA_FETCH_DEVICE_FUNC(vkCreateImage, PFN_vkCreateImage, "vkCreateImage");
-    VMA_FETCH_DEVICE_FUNC(vkDestroyImage, PFN_vkDestroyImage, "vkDestroyImage");
-    VMA_FETCH_DEVICE_FUNC(vkCmdCopyBuffer, PFN_vkCmdCopyBuffer, "vkCmdCopyBuffer");
+    const uint32_t memTypeIndex = alloc->GetMemoryTypeIndex();
 
-#if VMA_VULKAN_VERSION >= 1001000
-    if(m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0))
-    {
-        VMA_FETCH_DEVICE_FUNC(vkGetBufferMemoryRequirements2KHR, PFN_vkGetBufferMemoryRequirements2, "vkGetBufferMemoryRequirements2");
-        VMA_FETCH_DEVICE_FUNC(vkGetImageMemoryRequirements2KHR, PFN_vkGetImageMemoryRequirements2, "vkGetImageMemoryRequirements2");
-        VMA_FETCH_DEVICE_FUNC(vkBindBufferMemory2KHR, PFN_vkBindBufferMemory2, "vkBindBufferMemory2");
-        VMA_FETCH_DEVICE_FUNC(vkBindImageMemory2KHR, PFN_vkBindImageMemory2, "vkBindImageMemory2");
-        VMA_FETCH_INSTANCE_FUNC(vkGetPhysicalDeviceMemoryProperties2KHR, PFN_vkGetPhysicalDeviceMemoryProperties2, "vkGetPhysicalDeviceMemoryProperties2");
-    }
-#endif
+    outMemReq.size = newSize;
+    outMemReq.alignment = VMA_MAX(alloc->GetAlignment(), (VkDeviceSize)1);
 
-#if VMA_DEDICATED_ALLOCATION
-    if(m_UseKhrDedicatedAllocation)
+    if(pCreateInfo != VMA_NULL)
     {
-        VMA_FETCH_DEVICE_FUNC(vkGetBufferMemoryRequirements2KHR, PFN_vkGetBufferMemoryRequirements2KHR, "vkGetBufferMemoryRequirements2KHR");
-        VMA_FETCH_DEVICE_FUNC(vkGetImageMemoryRequirements2KHR, PFN_vkGetImageMemoryRequirements2KHR, "vkGetImageMemoryRequirements2KHR");
+        outMemReq.memoryTypeBits = UINT32_MAX;
+        outCreateInfo = *pCreateInfo;
+        return;
     }
-#endif
 
-#if VMA_BIND_MEMORY2
-    if(m_UseKhrBindMemory2)
+    // Keep the allocation in the same pool or memory type and with the same properties.
+    outMemReq.memoryTypeBits = 1u << memTypeIndex;
+    outCreateInfo = VmaAllocationCreateInfo();
+    outCreateInfo.memoryTypeBits = 1u << memTypeIndex;
+    if(alloc->GetType() == VmaAllocation_T::ALLOCATION_TYPE_BLOCK)
     {
-        VMA_FETCH_DEVICE_FUNC(vkBindBufferMemory2KHR, PFN_vkBindBufferMemory2KHR, "vkBindBufferMemory2KHR");
-        VMA_FETCH_DEVICE_FUNC(vkBindImageMemory2KHR, PFN_vkBindImageMemory2KHR, "vkBindImageMemory2KHR");
+        outCreateInfo.pool = alloc->GetBlock()->GetParentPool();
     }
-#endif // #if VMA_BIND_MEMORY2
-
-#if VMA_MEMORY_BUDGET
-    if(m_UseExtMemoryBudget)
+    else
     {
-        VMA_FETCH_INSTANCE_FUNC(vkGetPhysicalDeviceMemoryProperties2KHR, PFN_vkGetPhysicalDeviceMemoryProperties2KHR, "vkGetPhysicalDeviceMemoryProperties2KHR");
+        outCreateInfo.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
     }
-#endif // #if VMA_MEMORY_BUDGET
-
-#undef VMA_FETCH_DEVICE_FUNC
-#undef VMA_FETCH_INSTANCE_FUNC
-}
-
-#endif // #if VMA_DYNAMIC_VULKAN_FUNCTIONS == 1
-
-void VmaAllocator_T::ValidateVulkanFunctions()
-{
-    VMA_ASSERT(m_VulkanFunctions.vkGetPhysicalDeviceProperties != VMA_NULL);
-    VMA_ASSERT(m_VulkanFunctions.vkGetPhysicalDeviceMemoryProperties != VMA_NULL);
-    VMA_ASSERT(m_VulkanFunctions.vkAllocateMemory != VMA_NULL);
-    VMA_ASSERT(m_VulkanFunctions.vkFreeMemory != VMA_NULL);
-    VMA_ASSERT(m_VulkanFunctions.vkMapMemory != VMA_NULL);
-    VMA_ASSERT(m_VulkanFunctions.vkUnmapMemory != VMA_NULL);
-    VMA_ASSERT(m_VulkanFunctions.vkFlushMappedMemoryRanges != VMA_NULL);
-    VMA_ASSERT(m_VulkanFunctions.vkInvalidateMappedMemoryRanges != VMA_NULL);
-    VMA_ASSERT(m_VulkanFunctions.vkBindBufferMemory != VMA_NULL);
-    VMA_ASSERT(m_VulkanFunctions.vkBindImageMemory != VMA_NULL);
-    VMA_ASSERT(m_VulkanFunctions.vkGetBufferMemoryRequirements != VMA_NULL);
-    VMA_ASSERT(m_VulkanFunctions.vkGetImageMemoryRequirements != VMA_NULL);
-    VMA_ASSERT(m_VulkanFunctions.vkCreateBuffer != VMA_NULL);
-    VMA_ASSERT(m_VulkanFunctions.vkDestroyBuffer != VMA_NULL);
-    VMA_ASSERT(m_VulkanFunctions.vkCreateImage != VMA_NULL);
-    VMA_ASSERT(m_VulkanFunctions.vkDestroyImage != VMA_NULL);
-    VMA_ASSERT(m_VulkanFunctions.vkCmdCopyBuffer != VMA_NULL);
-
-#if VMA_DEDICATED_ALLOCATION || VMA_VULKAN_VERSION >= 1001000
-    if(m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0) || m_UseKhrDedicatedAllocation)
+    if(alloc->IsPersistentMap())
     {
-        VMA_ASSERT(m_VulkanFunctions.vkGetBufferMemoryRequirements2KHR != VMA_NULL);
-        VMA_ASSERT(m_VulkanFunctions.vkGetImageMemoryRequirements2KHR != VMA_NULL);
+        outCreateInfo.flags |= VMA_ALLOCATION_CREATE_MAPPED_BIT;
     }
-#endif
-
-#if VMA_BIND_MEMORY2 || VMA_VULKAN_VERSION >= 1001000
-    if(m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0) || m_UseKhrBindMemory2)
+    if(alloc->CanBecomeLost())
     {
-        VMA_ASSERT(m_VulkanFunctions.vkBindBufferMemory2KHR != VMA_NULL);
-        VMA_ASSERT(m_VulkanFunctions.vkBindImageMemory2KHR != VMA_NULL);
+        outCreateInfo.flags |= VMA_ALLOCATION_CREATE_CAN_BECOME_LOST_BIT;
     }
-#endif
-
-#if VMA_MEMORY_BUDGET || VMA_VULKAN_VERSION >= 1001000
-    if(m_UseExtMemoryBudget || m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0))
+    if(alloc->IsUserDataString())
     {
-        VMA_ASSERT(m_VulkanFunctions.vkGetPhysicalDeviceMemoryProperties2KHR != VMA_NULL);
+        outCreateInfo.flags |= VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT;
     }
-#endif
+    outCreateInfo.pUserData = alloc->GetUserData();
+    outCreateInfo.scope = alloc->GetScope();
+    outCreateInfo.quota = alloc->GetQuota();
+    outCreateInfo.tag = alloc->GetTag();
+    outCreateInfo.lifetime = alloc->GetLifetime();
 }
 
-VkDeviceSize VmaAllocator_T::CalcPreferredBlockSize(uint32_t memTypeIndex)
+bool VmaAllocator_T::IsAllocationHostAccessible(const VmaAllocation alloc) const
 {
-    const uint32_t heapIndex = MemoryTypeIndexToHeapIndex(memTypeIndex);
-    const VkDeviceSize heapSize = m_MemProps.memoryHeaps[heapIndex].size;
-    const bool isSmallHeap = heapSize <= VMA_SMALL_HEAP_MAX_SIZE;
-    return VmaAlignUp(isSmallHeap ? (heapSize / 8) : m_PreferredLargeHeapBlockSize, (VkDeviceSize)32);
+    return !alloc->CanBecomeLost() &&
+        (m_MemProps.memoryTypes[alloc->GetMemoryTypeIndex()].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
 }
 
-VkResult VmaAllocator_T::AllocateMemoryOfType(
-    VkDeviceSize size,
-    VkDeviceSize alignment,
-    bool dedicatedAllocation,
-    VkBuffer dedicatedBuffer,
-    VkBufferUsageFlags dedicatedBufferUsage,
-    VkImage dedicatedImage,
-    const VmaAllocationCreateInfo& createInfo,
-    uint32_t memTypeIndex,
-    VmaSuballocationType suballocType,
-    size_t allocationCount,
-    VmaAllocation* pAllocations)
+VkResult VmaAllocator_T::CopyAllocationData(
+    VmaAllocation srcAlloc,
+    VmaAllocation dstAlloc,
+    VkDeviceSize size)
 {
-    VMA_ASSERT(pAllocations != VMA_NULL);
-    VMA_DEBUG_LOG("  AllocateMemory: MemoryTypeIndex=%u, AllocationCount=%zu, Size=%llu", memTypeIndex, allocationCount, size);
-
-    VmaAllocationCreateInfo finalCreateInfo = createInfo;
+    VMA_ASSERT(IsAllocationHostAccessible(srcAlloc) && IsAllocationHostAccessible(dstAlloc));
+    VMA_ASSERT(size <= srcAlloc->GetSize() && size <= dstAlloc->GetSize());
 
-    // If memory type is not HOST_VISIBLE, disable MAPPED.
-    if((finalCreateInfo.flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0 &&
-        (m_MemProps.memoryTypes[memTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == 0)
+    void* pSrcData = VMA_NULL;
+    VkResult res = Map(srcAlloc, &pSrcData);
+    if(res != VK_SUCCESS)
     {
-        finalCreateInfo.flags &= ~VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        return res;
     }
-    // If memory is lazily allocated, it should be always dedicated.
-    if(finalCreateInfo.usage == VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED)
+    void* pDstData = VMA_NULL;
+    res = Map(dstAlloc, &pDstData);
+    if(res == VK_SUCCESS)
     {
-        finalCreateInfo.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+        res = FlushOrInvalidateAllocation(srcAlloc, 0, size, VMA_CACHE_INVALIDATE);
+        if(res == VK_SUCCESS)
+        {
+            memcpy(pDstData, pSrcData, (size_t)size);
+            res = FlushOrInvalidateAllocation(dstAlloc, 0, size, VMA_CACHE_FLUSH);
+        }
+        Unmap(dstAlloc);
     }
+    Unmap(srcAlloc);
+    return res;
+}
 
-    VmaBlockVector* const blockVector = m_pBlockVectors[memTypeIndex];
-    VMA_ASSERT(blockVector);
-
-    const VkDeviceSize preferredBlockSize = blockVector->GetPreferredBlockSize();
-    bool preferDedicatedMemory =
-        VMA_DEBUG_ALWAYS_DEDICATED_MEMORY ||
-        dedicatedAllocation ||
-        // Heuristics: Allocate dedicated memory if requested size if greater than half of preferred block size.
-        size > preferredBlockSize / 2;
+void VmaAllocator_T::CalculateStats(VmaStats* pStats)
+{
+    // Initialize.
+    InitStatInfo(pStats->total);
+    for(size_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i)
+        InitStatInfo(pStats->memoryType[i]);
+    for(size_t i = 0; i < VK_MAX_MEMORY_HEAPS; ++i)
+        InitStatInfo(pStats->memoryHeap[i]);
 
-    if(preferDedicatedMemory &&
-        (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT) == 0 &&
-        finalCreateInfo.pool == VK_NULL_HANDLE)
+    // Process default pools.
+    for(uint32_t memTypeIndex = 0; memTypeIndex < GetMemoryTypeCount(); ++memTypeIndex)
     {
-        finalCreateInfo.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+        VmaBlockVector* const pBlockVector = m_pBlockVectors[memTypeIndex];
+        VMA_ASSERT(pBlockVector);
+        pBlockVector->AddStats(pStats);
     }
 
-    if((finalCreateInfo.flags & VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT) != 0)
+    // Process custom pools.
     {
-        if((finalCreateInfo.flags & VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT) != 0)
-        {
-            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
-        }
-        else
+        VmaMutexLockRead lock(m_PoolsMutex, m_UseMutex);
+        for(size_t poolIndex = 0, poolCount = m_Pools.size(); poolIndex < poolCount; ++poolIndex)
         {
-            return AllocateDedicatedMemory(
-                size,
-                suballocType,
-                memTypeIndex,
-                (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT) != 0,
-                (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0,
-                (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT) != 0,
-                finalCreateInfo.pUserData,
-                dedicatedBuffer,
-                dedicatedBufferUsage,
-                dedicatedImage,
-                allocationCount,
-                pAllocations);
+            m_Pools[poolIndex]->m_BlockVector.AddStats(pStats);
         }
     }
-    else
+
+    // Process dedicated allocations.
+    for(uint32_t memTypeIndex = 0; memTypeIndex < GetMemoryTypeCount(); ++memTypeIndex)
     {
-        VkResult res = blockVector->Allocate(
-            m_CurrentFrameIndex.load(),
-            size,
-            alignment,
-            finalCreateInfo,
-            suballocType,
-            allocationCount,
-            pAllocations);
-        if(res == VK_SUCCESS)
+        const uint32_t memHeapIndex = MemoryTypeIndexToHeapIndex(memTypeIndex);
+        VmaMutexLockRead dedicatedAllocationsLock(m_DedicatedAllocationsMutex[memTypeIndex], m_UseMutex);
+        AllocationVectorType* const pDedicatedAllocVector = m_pDedicatedAllocations[memTypeIndex];
+        VMA_ASSERT(pDedicatedAllocVector);
+        for(size_t allocIndex = 0, allocCount = pDedicatedAllocVector->size(); allocIndex < allocCount; ++allocIndex)
         {
-            return res;
+            VmaStatInfo allocationStatInfo;
+            (*pDedicatedAllocVector)[allocIndex]->DedicatedAllocCalcStatsInfo(allocationStatInfo);
+            VmaAddStatInfo(pStats->total, allocationStatInfo);
+            VmaAddStatInfo(pStats->memoryType[memTypeIndex], allocationStatInfo);
+            VmaAddStatInfo(pStats->memoryHeap[memHeapIndex], allocationStatInfo);
         }
+    }
 
-        // 5. Try dedicated memory.
-        if((finalCreateInfo.flags & VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT) != 0)
+    // Postprocess.
+    VmaPostprocessCalcStatInfo(pStats->total);
+    for(size_t i = 0; i < GetMemoryTypeCount(); ++i)
+        VmaPostprocessCalcStatInfo(pStats->memoryType[i]);
+    for(size_t i = 0; i < GetMemoryHeapCount(); ++i)
+        VmaPostprocessCalcStatInfo(pStats->memoryHeap[i]);
+}
+
+void VmaAllocator_T::GetBudget(VmaBudget* outBudget, uint32_t firstHeap, uint32_t heapCount)
+{
+#if VMA_MEMORY_BUDGET
+    if(m_UseExtMemoryBudget)
+    {
+        if(m_Budget.m_OperationsSinceBudgetFetch < 30)
         {
-            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+            VmaMutexLockRead lockRead(m_Budget.m_BudgetMutex, m_UseMutex);
+            for(uint32_t i = 0; i < heapCount; ++i, ++outBudget)
+            {
+                const uint32_t heapIndex = firstHeap + i;
+
+                outBudget->blockBytes = m_Budget.m_BlockBytes[heapIndex];
+                outBudget->allocationBytes = m_Budget.m_AllocationBytes[heapIndex];
+
+                if(m_Budget.m_VulkanUsage[heapIndex] + outBudget->blockBytes > m_Budget.m_BlockBytesAtBudgetFetch[heapIndex])
+                {
+                    outBudget->usage = m_Budget.m_VulkanUsage[heapIndex] +
+                        outBudget->blockBytes - m_Budget.m_BlockBytesAtBudgetFetch[heapIndex];
+                }
+                else
+                {
+                    outBudget->usage = 0;
+                }
+
+                // Have to take MIN with heap size because explicit HeapSizeLimit is included in it.
+                outBudget->budget = VMA_MIN(
+                    m_Budget.m_VulkanBudget[heapIndex], m_MemProps.memoryHeaps[heapIndex].size);
+            }
         }
         else
         {
-            res = AllocateDedicatedMemory(
-                size,
-                suballocType,
-                memTypeIndex,
-                (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT) != 0,
-                (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0,
-                (finalCreateInfo.flags & VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT) != 0,
-                finalCreateInfo.pUserData,
-                dedicatedBuffer,
-                dedicatedBufferUsage,
-                dedicatedImage,
-                allocationCount,
-                pAllocations);
-            if(res == VK_SUCCESS)
-            {
-                // Succeeded: AllocateDedicatedMemory function already filld pMemory, nothing more to do here.
-                VMA_DEBUG_LOG("    Allocated as DedicatedMemory");
-                return VK_SUCCESS;
-            }
-            else
-            {
-                // Everything failed: Return error code.
-                VMA_DEBUG_LOG("    vkAllocateMemory FAILED");
-                return res;
-            }
+            UpdateVulkanBudget(); // Outside of mutex lock
+            GetBudget(outBudget, firstHeap, heapCount); // Recursion
+        }
+    }
+    else
+#endif
+    {
+        for(uint32_t i = 0; i < heapCount; ++i, ++outBudget)
+        {
+            const uint32_t heapIndex = firstHeap + i;
+
+            outBudget->blockBytes = m_Budget.m_BlockBytes[heapIndex];
+            outBudget->allocationBytes = m_Budget.m_AllocationBytes[heapIndex];
+
+            outBudget->usage = outBudget->blockBytes;
+            outBudget->budget = m_MemProps.memoryHeaps[heapIndex].size * 8 / 10; // 80% heuristics.
         }
     }
 }
 
-VkResult VmaAllocator_T::AllocateDedicatedMemory(
-    VkDeviceSize size,
-    VmaSuballocationType suballocType,
-    uint32_t memTypeIndex,
-    bool withinBudget,
-    bool map,
-    bool isUserDataString,
-    void* pUserData,
-    VkBuffer dedicatedBuffer,
-    VkBufferUsageFlags dedicatedBufferUsage,
-    VkImage dedicatedImage,
-    size_t allocationCount,
-    VmaAllocation* pAllocations)
+static const uint32_t VMA_VENDOR_ID_AMD = 4098;
+
+VkResult VmaAllocator_T::DefragmentationBegin(
+    const VmaDefragmentationInfo2& info,
+    VmaDefragmentationStats* pStats,
+    VmaDefragmentationContext* pContext)
 {
-    VMA_ASSERT(allocationCount > 0 && pAllocations);
+    if(info.pAllocationsChanged != VMA_NULL)
+    {
+        memset(info.pAllocationsChanged, 0, info.allocationCount * sizeof(VkBool32));
+    }
 
-    if(withinBudget)
+    *pContext = vma_new(this, VmaDefragmentationContext_T)(
+        this, m_CurrentFrameIndex.load(), info.flags, pStats);
+
+    (*pContext)->AddPools(info.poolCount, info.pPools);
+    (*pContext)->AddAllocations(
+        info.allocationCount, info.pAllocations, info.pAllocationsChanged);
+
+    VkResult res = (*pContext)->Defragment(
+        info.maxCpuBytesToMove, info.maxCpuAllocationsToMove,
+        info.maxGpuBytesToMove, info.maxGpuAllocationsToMove,
+        info.commandBuffer, pStats, info.flags);
+
+    if(res != VK_NOT_READY)
     {
-        const uint32_t heapIndex = MemoryTypeIndexToHeapIndex(memTypeIndex);
-        VmaBudget heapBudget = {};
-        GetBudget(&heapBudget, heapIndex, 1);
-        if(heapBudget.usage + size * allocationCount > heapBudget.budget)
-        {
-            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
-        }
+        vma_delete(this, *pContext);
+        *pContext = VMA_NULL;
     }
 
-    VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    allocInfo.memoryTypeIndex = memTypeIndex;
-    allocInfo.allocationSize = size;
+    return res;
+}
+
+VkResult VmaAllocator_T::DefragmentationEnd(
+    VmaDefragmentationContext context)
+{
+    vma_delete(this, context);
+    return VK_SUCCESS;
+}
+
+VkResult VmaAllocator_T::DefragmentationPassBegin(
+    VmaDefragmentationPassInfo* pInfo,
+    VmaDefragmentationContext context)
+{
+    return context->DefragmentPassBegin(pInfo);
+}
+VkResult VmaAllocator_T::DefragmentationPassEnd(
+    VmaDefragmentationContext context)
+{
+    return context->DefragmentPassEnd();
 
-#if VMA_DEDICATED_ALLOCATION || VMA_VULKAN_VERSION >= 1001000
-    VkMemoryDedicatedAllocateInfoKHR dedicatedAllocInfo = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO_KHR };
-    if(m_UseKhrDedicatedAllocation || m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0))
-    {
-        if(dedicatedBuffer != VK_NULL_HANDLE)
-        {
-            VMA_ASSERT(dedicatedImage == VK_NULL_HANDLE);
-            dedicatedAllocInfo.buffer = dedicatedBuffer;
-            VmaPnextChainPushFront(&allocInfo, &dedicatedAllocInfo);
-        }
-        else if(dedicatedImage != VK_NULL_HANDLE)
-        {
-            dedicatedAllocInfo.image = dedicatedImage;
-            VmaPnextChainPushFront(&allocInfo, &dedicatedAllocInfo);
-        }
-    }
-#endif // #if VMA_DEDICATED_ALLOCATION || VMA_VULKAN_VERSION >= 1001000
+}
 
-#if VMA_BUFFER_DEVICE_ADDRESS
-    VkMemoryAllocateFlagsInfoKHR allocFlagsInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO_KHR };
-    if(m_UseKhrBufferDeviceAddress)
+void VmaAllocator_T::GetAllocationInfo(VmaAllocation hAllocation, VmaAllocationInfo* pAllocationInfo)
+{
+    if(hAllocation->CanBecomeLost())
     {
-        bool canContainBufferWithDeviceAddress = true;
-        if(dedicatedBuffer != VK_NULL_HANDLE)
-        {
-            canContainBufferWithDeviceAddress = dedicatedBufferUsage == UINT32_MAX || // Usage flags unknown
-                (dedicatedBufferUsage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_EXT) != 0;
-        }
-        else if(dedicatedImage != VK_NULL_HANDLE)
-        {
-            canContainBufferWithDeviceAddress = false;
-        }
-        if(canContainBufferWithDeviceAddress)
+        /*
+        Warning: This is a carefully designed algorithm.
+        Do not modify unless you really know what you're doing :)
+        */
+        const uint32_t localCurrFrameIndex = m_CurrentFrameIndex.load();
+        uint32_t localLastUseFrameIndex = hAllocation->GetLastUseFrameIndex();
+        for(;;)
         {
-            allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR;
-            VmaPnextChainPushFront(&allocInfo, &allocFlagsInfo);
+            if(localLastUseFrameIndex == VMA_FRAME_INDEX_LOST)
+            {
+                pAllocationInfo->memoryType = UINT32_MAX;
+                pAllocationInfo->deviceMemory = VK_NULL_HANDLE;
+                pAllocationInfo->offset = 0;
+                pAllocationInfo->size = hAllocation->GetSize();
+                pAllocationInfo->pMappedData = VMA_NULL;
+                pAllocationInfo->pUserData = hAllocation->GetUserData();
+                return;
+            }
+            else if(localLastUseFrameIndex == localCurrFrameIndex)
+            {
+                MarkMemoryUsed(hAllocation);
+                pAllocationInfo->memoryType = hAllocation->GetMemoryTypeIndex();
+                pAllocationInfo->deviceMemory = hAllocation->GetMemory();
+                pAllocationInfo->offset = hAllocation->GetOffset();
+                pAllocationInfo->size = hAllocation->GetSize();
+                pAllocationInfo->pMappedData = VMA_NULL;
+                pAllocationInfo->pUserData = hAllocation->GetUserData();
+                return;
+            }
+            else // Last use time earlier than current time.
+            {
+                if(hAllocation->CompareExchangeLastUseFrameIndex(localLastUseFrameIndex, localCurrFrameIndex))
+                {
+                    localLastUseFrameIndex = localCurrFrameIndex;
+                }
+            }
         }
     }
-#endif // #if VMA_BUFFER_DEVICE_ADDRESS
-
-    size_t allocIndex;
-    VkResult res = VK_SUCCESS;
-    for(allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
+    else
     {
-        res = AllocateDedicatedMemoryPage(
-            size,
-            suballocType,
-            memTypeIndex,
-            allocInfo,
-            map,
-            isUserDataString,
-            pUserData,
-            pAllocations + allocIndex);
-        if(res != VK_SUCCESS)
+#if VMA_STATS_STRING_ENABLED
+        uint32_t localCurrFrameIndex = m_CurrentFrameIndex.load();
+        uint32_t localLastUseFrameIndex = hAllocation->GetLastUseFrameIndex();
+        for(;;)
         {
-            break;
+            VMA_ASSERT(localLastUseFrameIndex != VMA_FRAME_INDEX_LOST);
+            if(localLastUseFrameIndex == localCurrFrameIndex)
+            {
+                break;
+            }
+            else // Last use time earlier than current time.
+            {
+                if(hAllocation->CompareExchangeLastUseFrameIndex(localLastUseFrameIndex, localCurrFrameIndex))
+                {
+                    localLastUseFrameIndex = localCurrFrameIndex;
+                }
+            }
         }
+#endif
+
+        MarkMemoryUsed(hAllocation);
+        pAllocationInfo->memoryType = hAllocation->GetMemoryTypeIndex();
+        pAllocationInfo->deviceMemory = hAllocation->GetMemory();
+        pAllocationInfo->offset = hAllocation->GetOffset();
+        pAllocationInfo->size = hAllocation->GetSize();
+        pAllocationInfo->pMappedData = hAllocation->GetMappedData();
+        pAllocationInfo->pUserData = hAllocation->GetUserData();
     }
+}
 
-    if(res == VK_SUCCESS)
+bool VmaAllocator_T::TouchAllocation(VmaAllocation hAllocation)
+{
+    // This is a stripped-down version of VmaAllocator_T::GetAllocationInfo.
+    if(hAllocation->CanBecomeLost())
     {
-        // Register them in m_pDedicatedAllocations.
+        uint32_t localCurrFrameIndex = m_CurrentFrameIndex.load();
+        uint32_t localLastUseFrameIndex = hAllocation->GetLastUseFrameIndex();
+        for(;;)
         {
-            VmaMutexLockWrite lock(m_DedicatedAllocationsMutex[memTypeIndex], m_UseMutex);
-            AllocationVectorType* pDedicatedAllocations = m_pDedicatedAllocations[memTypeIndex];
-            VMA_ASSERT(pDedicatedAllocations);
-            for(allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
+            if(localLastUseFrameIndex == VMA_FRAME_INDEX_LOST)
             {
-                VmaVectorInsertSorted<VmaPointerLess>(*pDedicatedAllocations, pAllocations[allocIndex]);
+                return false;
+            }
+            else if(localLastUseFrameIndex == localCurrFrameIndex)
+            {
+                MarkMemoryUsed(hAllocation);
+                return true;
+            }
+            else // Last use time earlier than current time.
+            {
+                if(hAllocation->CompareExchangeLastUseFrameIndex(localLastUseFrameIndex, localCurrFrameIndex))
+                {
+                    localLastUseFrameIndex = localCurrFrameIndex;
+                }
             }
         }
-
-        VMA_DEBUG_LOG("    Allocated DedicatedMemory Count=%zu, MemoryTypeIndex=#%u", allocationCount, memTypeIndex);
     }
     else
     {
-        // Free all already created allocations.
-        while(allocIndex--)
+#if VMA_STATS_STRING_ENABLED
+        uint32_t localCurrFrameIndex = m_CurrentFrameIndex.load();
+        uint32_t localLastUseFrameIndex = hAllocation->GetLastUseFrameIndex();
+        for(;;)
         {
-            VmaAllocation currAlloc = pAllocations[allocIndex];
-            VkDeviceMemory hMemory = currAlloc->GetMemory();
-
-            /*
-            There is no need to call this, because Vulkan spec allows to skip vkUnmapMemory
-            before vkFreeMemory.
-
-            if(currAlloc->GetMappedData() != VMA_NULL)
+            VMA_ASSERT(localLastUseFrameIndex != VMA_FRAME_INDEX_LOST);
+            if(localLastUseFrameIndex == localCurrFrameIndex)
             {
-                (*m_VulkanFunctions.vkUnmapMemory)(m_hDevice, hMemory);
+                break;
+            }
+            else // Last use time earlier than current time.
+            {
+                if(hAllocation->CompareExchangeLastUseFrameIndex(localLastUseFrameIndex, localCurrFrameIndex))
+                {
+                    localLastUseFrameIndex = localCurrFrameIndex;
+                }
             }
-            */
-
-            FreeVulkanMemory(memTypeIndex, currAlloc->GetSize(), hMemory);
-            m_Budget.RemoveAllocation(MemoryTypeIndexToHeapIndex(memTypeIndex), currAlloc->GetSize());
-            currAlloc->SetUserData(this, VMA_NULL);
-            m_AllocationObjectAllocator.Free(currAlloc);
         }
+#endif
 
-        memset(pAllocations, 0, sizeof(VmaAllocation) * allocationCount);
+        MarkMemoryUsed(hAllocation);
+        return true;
     }
-
-    return res;
 }
 
-VkResult VmaAllocator_T::AllocateDedicatedMemoryPage(
-    VkDeviceSize size,
-    VmaSuballocationType suballocType,
-    uint32_t memTypeIndex,
-    const VkMemoryAllocateInfo& allocInfo,
-    bool map,
-    bool isUserDataString,
-    void* pUserData,
-    VmaAllocation* pAllocation)
+void VmaAllocator_T::MarkMemoryUsed(VmaAllocation hAllocation)
 {
-    VkDeviceMemory hMemory = VK_NULL_HANDLE;
-    VkResult res = AllocateVulkanMemory(&allocInfo, &hMemory);
-    if(res < 0)
-    {
-        VMA_DEBUG_LOG("    vkAllocateMemory FAILED");
-        return res;
-    }
-
-    void* pMappedData = VMA_NULL;
-    if(map)
+#if VMA_PAGEABLE_DEVICE_LOCAL_MEMORY
+    if(m_UseExtPageableDeviceLocalMemory)
     {
-        res = (*m_VulkanFunctions.vkMapMemory)(
-            m_hDevice,
-            hMemory,
-            0,
-            VK_WHOLE_SIZE,
-            0,
-            &pMappedData);
-        if(res < 0)
+        const uint32_t localCurrFrameIndex = m_CurrentFrameIndex.load();
+        if(hAllocation->GetType() == VmaAllocation_T::ALLOCATION_TYPE_BLOCK)
         {
-            VMA_DEBUG_LOG("    vkMapMemory FAILED");
-            FreeVulkanMemory(memTypeIndex, size, hMemory);
-            return res;
+            hAllocation->GetBlock()->MarkUsed(localCurrFrameIndex);
+        }
+        else
+        {
+            // Dedicated allocations cannot become lost, so their last use frame index is free to track usage.
+            uint32_t localLastUseFrameIndex = hAllocation->GetLastUseFrameIndex();
+            while(localLastUseFrameIndex != localCurrFrameIndex &&
+                !hAllocation->CompareExchangeLastUseFrameIndex(localLastUseFrameIndex, localCurrFrameIndex))
+            {
+            }
         }
     }
-
-    *pAllocation = m_AllocationObjectAllocator.Allocate(m_CurrentFrameIndex.load(), isUserDataString);
-    (*pAllocation)->InitDedicatedAllocation(memTypeIndex, hMemory, suballocType, pMappedData, size);
-    (*pAllocation)->SetUserData(this, pUserData);
-    m_Budget.AddAllocation(MemoryTypeIndexToHeapIndex(memTypeIndex), size);
-    if(VMA_DEBUG_INITIALIZE_ALLOCATIONS)
-    {
-        FillAllocation(*pAllocation, VMA_ALLOCATION_FILL_PATTERN_CREATED);
-    }
-
-    return VK_SUCCESS;
+#endif // #if VMA_PAGEABLE_DEVICE_LOCAL_MEMORY
 }
 
-void VmaAllocator_T::GetBufferMemoryRequirements(
-    VkBuffer hBuffer,
-    VkMemoryRequirements& memReq,
-    bool& requiresDedicatedAllocation,
-    bool& prefersDedicatedAllocation) const
-{
-#if VMA_DEDICATED_ALLOCATION || VMA_VULKAN_VERSION >= 1001000
-    if(m_UseKhrDedicatedAllocation || m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0))
-    {
-        VkBufferMemoryRequirementsInfo2KHR memReqInfo = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2_KHR };
-        memReqInfo.buffer = hBuffer;
-
-        VkMemoryDedicatedRequirementsKHR memDedicatedReq = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS_KHR };
-
-        VkMemoryRequirements2KHR memReq2 = { VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2_KHR };
-        VmaPnextChainPushFront(&memReq2, &memDedicatedReq);
-
-        (*m_VulkanFunctions.vkGetBufferMemoryRequirements2KHR)(m_hDevice, &memReqInfo, &memReq2);
-
-        memReq = memReq2.memoryRequirements;
-        requiresDedicatedAllocation = (memDedicatedReq.requiresDedicatedAllocation != VK_FALSE);
-        prefersDedicatedAllocation  = (memDedicatedReq.prefersDedicatedAllocation  != VK_FALSE);
+#if VMA_EXTERNAL_MEMORY
+VkResult VmaAllocator_T::GetAllocationExportInfo(VmaAllocation hAllocation, VmaAllocationExportInfo* pExportInfo)
+{
+    // Only blocks of custom pools are allocated as exportable.
+    // Allocations that can become lost could be reused under the importing process.
+    if(hAllocation->GetType() != VmaAllocation_T::ALLOCATION_TYPE_BLOCK ||
+        hAllocation->CanBecomeLost())
+    {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
     }
-    else
-#endif // #if VMA_DEDICATED_ALLOCATION || VMA_VULKAN_VERSION >= 1001000
+    VmaDeviceMemoryBlock* const pBlock = hAllocation->GetBlock();
+    const VmaPool hPool = pBlock->GetParentPool();
+    if(hPool == VK_NULL_HANDLE || hPool->m_BlockVector.GetExportHandleTypes() == 0)
     {
-        (*m_VulkanFunctions.vkGetBufferMemoryRequirements)(m_hDevice, hBuffer, &memReq);
-        requiresDedicatedAllocation = false;
-        prefersDedicatedAllocation  = false;
+        return VK_ERROR_FEATURE_NOT_PRESENT;
     }
+
+    pExportInfo->deviceMemory = pBlock->GetDeviceMemory();
+    pExportInfo->blockSize = pBlock->m_pMetadata->GetSize();
+    pExportInfo->offset = hAllocation->GetOffset();
+    pExportInfo->size = hAllocation->GetSize();
+    pExportInfo->memoryTypeIndex = pBlock->GetMemoryTypeIndex();
+    pExportInfo->handleTypes = hPool->m_BlockVector.GetExportHandleTypes();
+    return VK_SUCCESS;
 }
+#endif // #if VMA_EXTERNAL_MEMORY
 
-void VmaAllocator_T::GetImageMemoryRequirements(
-    VkImage hImage,
-    VkMemoryRequirements& memReq,
-    bool& requiresDedicatedAllocation,
-    bool& prefersDedicatedAllocation) const
+VkResult VmaAllocator_T::CheckHostPointerImport(const VmaPoolCreateInfo& createInfo) const
 {
-#if VMA_DEDICATED_ALLOCATION || VMA_VULKAN_VERSION >= 1001000
-    if(m_UseKhrDedicatedAllocation || m_VulkanApiVersion >= VK_MAKE_VERSION(1, 1, 0))
+    if(createInfo.blockSize == 0)
     {
-        VkImageMemoryRequirementsInfo2KHR memReqInfo = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2_KHR };
-        memReqInfo.image = hImage;
-
-        VkMemoryDedicatedRequirementsKHR memDedicatedReq = { VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS_KHR };
-
-        VkMemoryRequirements2KHR memReq2 = { VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2_KHR };
-        VmaPnextChainPushFront(&memReq2, &memDedicatedReq);
-
-        (*m_VulkanFunctions.vkGetImageMemoryRequirements2KHR)(m_hDevice, &memReqInfo, &memReq2);
-
-        memReq = memReq2.memoryRequirements;
-        requiresDedicatedAllocation = (memDedicatedReq.requiresDedicatedAllocation != VK_FALSE);
-        prefersDedicatedAllocation  = (memDedicatedReq.prefersDedicatedAllocation  != VK_FALSE);
+        return VK_ERROR_INITIALIZATION_FAILED;
     }
-    else
-#endif // #if VMA_DEDICATED_ALLOCATION || VMA_VULKAN_VERSION >= 1001000
+#if VMA_EXTERNAL_MEMORY_HOST
+    if(m_UseExtExternalMemoryHost)
     {
-        (*m_VulkanFunctions.vkGetImageMemoryRequirements)(m_hDevice, hImage, &memReq);
-        requiresDedicatedAllocation = false;
-        prefersDedicatedAllocation  = false;
+        const bool aligned = (uintptr_t)createInfo.pHostPointer % m_MinImportedHostPointerAlignment == 0 &&
+            createInfo.blockSize % m_MinImportedHostPointerAlignment == 0;
+        VMA_ASSERT(aligned && "VmaPoolCreateInfo::pHostPointer and blockSize must be multiples of minImportedHostPointerAlignment.");
+        if(!aligned)
+        {
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+
+        VkMemoryHostPointerPropertiesEXT hostPointerProps = { VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT };
+        const VkResult res = (*m_VulkanFunctions.vkGetMemoryHostPointerPropertiesEXT)(
+            m_hDevice,
+            VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT,
+            createInfo.pHostPointer,
+            &hostPointerProps);
+        if(res != VK_SUCCESS)
+        {
+            return res;
+        }
+        return (hostPointerProps.memoryTypeBits & (1u << createInfo.memoryTypeIndex)) != 0 ?
+            VK_SUCCESS : VK_ERROR_FEATURE_NOT_PRESENT;
     }
+#endif // #if VMA_EXTERNAL_MEMORY_HOST
+    return VK_ERROR_FEATURE_NOT_PRESENT;
 }
 
-VkResult VmaAllocator_T::AllocateMemory(
-    const VkMemoryRequirements& vkMemReq,
-    bool requiresDedicatedAllocation,
-    bool prefersDedicatedAllocation,
-    VkBuffer dedicatedBuffer,
-    VkBufferUsageFlags dedicatedBufferUsage,
-    VkImage dedicatedImage,
-    const VmaAllocationCreateInfo& createInfo,
-    VmaSuballocationType suballocType,
-    size_t allocationCount,
-    VmaAllocation* pAllocations)
+VkResult VmaAllocator_T::CreatePool(const VmaPoolCreateInfo* pCreateInfo, VmaPool* pPool)
 {
-    memset(pAllocations, 0, sizeof(VmaAllocation) * allocationCount);
+    VMA_DEBUG_LOG("  CreatePool: MemoryTypeIndex=%u, flags=%u", pCreateInfo->memoryTypeIndex, pCreateInfo->flags);
 
-    VMA_ASSERT(VmaIsPow2(vkMemReq.alignment));
+    VmaPoolCreateInfo newCreateInfo = *pCreateInfo;
 
-    if(vkMemReq.size == 0)
+    if(newCreateInfo.maxBlockCount == 0)
     {
-        return VK_ERROR_VALIDATION_FAILED_EXT;
+        newCreateInfo.maxBlockCount = SIZE_MAX;
     }
-    if((createInfo.flags & VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT) != 0 &&
-        (createInfo.flags & VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT) != 0)
+    if(newCreateInfo.minBlockCount > newCreateInfo.maxBlockCount)
     {
-        VMA_ASSERT(0 && "Specifying VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT together with VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT makes no sense.");
-        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        return VK_ERROR_INITIALIZATION_FAILED;
     }
-    if((createInfo.flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0 &&
-        (createInfo.flags & VMA_ALLOCATION_CREATE_CAN_BECOME_LOST_BIT) != 0)
+    // Memory type index out of range or forbidden.
+    if(pCreateInfo->memoryTypeIndex >= GetMemoryTypeCount() ||
+        ((1u << pCreateInfo->memoryTypeIndex) & m_GlobalMemoryTypeBits) == 0)
     {
-        VMA_ASSERT(0 && "Specifying VMA_ALLOCATION_CREATE_MAPPED_BIT together with VMA_ALLOCATION_CREATE_CAN_BECOME_LOST_BIT is invalid.");
-        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        return VK_ERROR_FEATURE_NOT_PRESENT;
     }
-    if(requiresDedicatedAllocation)
+#if VMA_EXTERNAL_MEMORY
+    // Imported memory cannot be exported again.
+    if(newCreateInfo.pHostPointer != VMA_NULL && newCreateInfo.exportHandleTypes != 0)
     {
-        if((createInfo.flags & VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT) != 0)
-        {
-            VMA_ASSERT(0 && "VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT specified while dedicated allocation is required.");
-            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
-        }
-        if(createInfo.pool != VK_NULL_HANDLE)
-        {
-            VMA_ASSERT(0 && "Pool specified while dedicated allocation is required.");
-            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
-        }
+        return VK_ERROR_INITIALIZATION_FAILED;
     }
-    if((createInfo.pool != VK_NULL_HANDLE) &&
-        ((createInfo.flags & (VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT)) != 0))
+#endif
+    if(newCreateInfo.pHostPointer != VMA_NULL)
     {
-        VMA_ASSERT(0 && "Specifying VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT when pool != null is invalid.");
-        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        VkResult res = CheckHostPointerImport(newCreateInfo);
+        if(res != VK_SUCCESS)
+        {
+            return res;
+        }
+        // Imported memory is the only block, created now and kept until the pool is destroyed.
+        newCreateInfo.minBlockCount = 1;
+        newCreateInfo.maxBlockCount = 1;
     }
 
-    if(createInfo.pool != VK_NULL_HANDLE)
-    {
-        const VkDeviceSize alignmentForPool = VMA_MAX(
-            vkMemReq.alignment,
-            GetMemoryTypeMinAlignment(createInfo.pool->m_BlockVector.GetMemoryTypeIndex()));
+    const VkDeviceSize preferredBlockSize = CalcPreferredBlockSize(newCreateInfo.memoryTypeIndex);
 
-        VmaAllocationCreateInfo createInfoForPool = createInfo;
-        // If memory type is not HOST_VISIBLE, disable MAPPED.
-        if((createInfoForPool.flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0 &&
-            (m_MemProps.memoryTypes[createInfo.pool->m_BlockVector.GetMemoryTypeIndex()].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == 0)
-        {
-            createInfoForPool.flags &= ~VMA_ALLOCATION_CREATE_MAPPED_BIT;
-        }
+    *pPool = vma_new(this, VmaPool_T)(this, newCreateInfo, preferredBlockSize);
+    (*pPool)->SetPublishedStatsSlot(m_StatsPublisher.AcquirePoolSlot(newCreateInfo.memoryTypeIndex));
 
-        return createInfo.pool->m_BlockVector.Allocate(
-            m_CurrentFrameIndex.load(),
-            vkMemReq.size,
-            alignmentForPool,
-            createInfoForPool,
-            suballocType,
-            allocationCount,
-            pAllocations);
-    }
-    else
+    VkResult res = (*pPool)->m_BlockVector.CreateMinBlocks();
+    if(res != VK_SUCCESS)
     {
-        // Bit mask of memory Vulkan types acceptable for this allocation.
-        uint32_t memoryTypeBits = vkMemReq.memoryTypeBits;
-        uint32_t memTypeIndex = UINT32_MAX;
-        VkResult res = vmaFindMemoryTypeIndex(this, memoryTypeBits, &createInfo, &memTypeIndex);
-        if(res == VK_SUCCESS)
-        {
-            VkDeviceSize alignmentForMemType = VMA_MAX(
-                vkMemReq.alignment,
-                GetMemoryTypeMinAlignment(memTypeIndex));
-
-            res = AllocateMemoryOfType(
-                vkMemReq.size,
-                alignmentForMemType,
-                requiresDedicatedAllocation || prefersDedicatedAllocation,
-                dedicatedBuffer,
-                dedicatedBufferUsage,
-                dedicatedImage,
-                createInfo,
-                memTypeIndex,
-                suballocType,
-                allocationCount,
-                pAllocations);
-            // Succeeded on first try.
-            if(res == VK_SUCCESS)
-            {
-                return res;
-            }
-            // Allocation from this memory type failed. Try other compatible memory types.
-            else
-            {
-                for(;;)
-                {
-                    // Remove old memTypeIndex from list of possibilities.
-                    memoryTypeBits &= ~(1u << memTypeIndex);
-                    // Find alternative memTypeIndex.
-                    res = vmaFindMemoryTypeIndex(this, memoryTypeBits, &createInfo, &memTypeIndex);
-                    if(res == VK_SUCCESS)
-                    {
-                        alignmentForMemType = VMA_MAX(
-                            vkMemReq.alignment,
-                            GetMemoryTypeMinAlignment(memTypeIndex));
+        const uint32_t publishedStatsSlot = (*pPool)->GetPublishedStatsSlot();
+        vma_delete(this, *pPool);
+        m_StatsPublisher.ReleasePoolSlot(publishedStatsSlot);
+        *pPool = VMA_NULL;
+        return res;
+    }
 
-                        res = AllocateMemoryOfType(
-                            vkMemReq.size,
-                            alignmentForMemType,
-                            requiresDedicatedAllocation || prefersDedicatedAllocation,
-                            dedicatedBuffer,
-                            dedicatedBufferUsage,
-                            dedicatedImage,
-                            createInfo,
-                            memTypeIndex,
-                            suballocType,
-                            allocationCount,
-                            pAllocations);
-                        // Allocation from this alternative memory type succeeded.
-                        if(res == VK_SUCCESS)
-                        {
-                            return res;
-                        }
-                        // else: Allocation from this memory type failed. Try next one - next loop iteration.
-                    }
-                    // No other matching memory type index could be found.
-                    else
-                    {
-                        // Not returning res, which is VK_ERROR_FEATURE_NOT_PRESENT, because we already failed to allocate once.
-                        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
-                    }
-                }
-            }
-        }
-        // Can't find any single memory type maching requirements. res is VK_ERROR_FEATURE_NOT_PRESENT.
-        else
-            return res;
+    // Add to m_Pools.
+    {
+        VmaMutexLockWrite lock(m_PoolsMutex, m_UseMutex);
+        (*pPool)->SetId(m_NextPoolId++);
+        VmaVectorInsertSorted<VmaPointerLess>(m_Pools, *pPool);
     }
+    m_StatsPublisher.SetPoolId((*pPool)->GetPublishedStatsSlot(), (*pPool)->GetId());
+
+    return VK_SUCCESS;
 }
 
-void VmaAllocator_T::FreeMemory(
-    size_t allocationCount,
-    const VmaAllocation* pAllocations)
+void VmaAllocator_T::DestroyPool(VmaPool pool)
 {
-    VMA_ASSERT(pAllocations);
-
-    for(size_t allocIndex = allocationCount; allocIndex--; )
+    // Pending destructions can't outlive memory of the pool.
     {
-        VmaAllocation allocation = pAllocations[allocIndex];
-
-        if(allocation != VK_NULL_HANDLE)
-        {
-            if(TouchAllocation(allocation))
-            {
-                if(VMA_DEBUG_INITIALIZE_ALLOCATIONS)
-                {
-                    FillAllocation(allocation, VMA_ALLOCATION_FILL_PATTERN_DESTROYED);
-                }
-
-                switch(allocation->GetType())
-                {
-                case VmaAllocation_T::ALLOCATION_TYPE_BLOCK:
-                    {
-                        VmaBlockVector* pBlockVector = VMA_NULL;
-                        VmaPool hPool = allocation->GetBlock()->GetParentPool();
-                        if(hPool != VK_NULL_HANDLE)
-                        {
-                            pBlockVector = &hPool->m_BlockVector;
-                        }
-                        else
-                        {
-                            const uint32_t memTypeIndex = allocation->GetMemoryTypeIndex();
-                            pBlockVector = m_pBlockVectors[memTypeIndex];
-                        }
-                        pBlockVector->Free(allocation);
-                    }
-                    break;
-                case VmaAllocation_T::ALLOCATION_TYPE_DEDICATED:
-                    FreeDedicatedMemory(allocation);
-                    break;
-                default:
-                    VMA_ASSERT(0);
-                }
-            }
+        const VmaStlAllocator<VmaDeferredDestruction> entryAllocator(GetAllocationCallbacks());
+        DeferredDestructionVectorType poolEntries(entryAllocator);
+        ExtractDeferredDestructions(0, pool, poolEntries);
+        DestroyDeferred(poolEntries);
+    }
 
-            // Do this regardless of whether the allocation is lost. Lost allocations still account to Budget.AllocationBytes.
-            m_Budget.RemoveAllocation(MemoryTypeIndexToHeapIndex(allocation->GetMemoryTypeIndex()), allocation->GetSize());
-            allocation->SetUserData(this, VMA_NULL);
-            m_AllocationObjectAllocator.Free(allocation);
-        }
+    // Remove from m_Pools.
+    {
+        VmaMutexLockWrite lock(m_PoolsMutex, m_UseMutex);
+        bool success = VmaVectorRemoveSorted<VmaPointerLess>(m_Pools, pool);
+        VMA_ASSERT(success && "Pool not found in Allocator.");
     }
+
+    // Blocks of the pool are removed from its published statistics while it's being deleted.
+    const uint32_t publishedStatsSlot = pool->GetPublishedStatsSlot();
+    vma_delete(this, pool);
+    m_StatsPublisher.ReleasePoolSlot(publishedStatsSlot);
 }
 
-VkResult VmaAllocator_T::ResizeAllocation(
-    const VmaAllocation alloc,
-    VkDeviceSize newSize)
+void VmaAllocator_T::GetPoolStats(VmaPool pool, VmaPoolStats* pPoolStats)
 {
-    // This function is deprecated and so it does nothing. It's left for backward compatibility.
-    if(newSize == 0 || alloc->GetLastUseFrameIndex() == VMA_FRAME_INDEX_LOST)
+    pool->m_BlockVector.GetPoolStats(pPoolStats);
+}
+
+VkResult VmaAllocator_T::CreateAllocationScope(VmaAllocationScope* pScope)
+{
+    *pScope = vma_new(this, VmaAllocationScope_T)(this);
+    return VK_SUCCESS;
+}
+
+void VmaAllocator_T::DestroyAllocationScope(VmaAllocationScope scope)
+{
+    const VmaStlAllocator<VmaAllocation> allocationAllocator(GetAllocationCallbacks());
+    AllocationVectorType allocations(allocationAllocator);
+    scope->DetachAll(allocations);
+
+#if VMA_RECORDING_ENABLED
+    // Recorded as regular frees, so replay doesn't need to know about scopes.
+    if(m_pRecorder != VMA_NULL && !allocations.empty())
     {
-        return VK_ERROR_VALIDATION_FAILED_EXT;
+        m_pRecorder->RecordFreeMemoryPages(GetCurrentFrameIndex(), allocations.size(), allocations.data());
     }
-    if(newSize == alloc->GetSize())
+#endif
+
+    FreeMemoryBatch(allocations.size(), allocations.data());
+    vma_delete(this, scope);
+}
+
+VkResult VmaAllocator_T::CreateQuota(const VmaQuotaCreateInfo* pCreateInfo, VmaQuota* pQuota)
+{
+    if(pCreateInfo->limit == 0)
     {
-        return VK_SUCCESS;
+        return VK_ERROR_INITIALIZATION_FAILED;
     }
-    return VK_ERROR_OUT_OF_POOL_MEMORY;
+    *pQuota = vma_new(this, VmaQuota_T)(this, *pCreateInfo);
+    return VK_SUCCESS;
 }
 
-void VmaAllocator_T::CalculateStats(VmaStats* pStats)
+void VmaAllocator_T::DestroyQuota(VmaQuota quota)
 {
-    // Initialize.
-    InitStatInfo(pStats->total);
-    for(size_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i)
-        InitStatInfo(pStats->memoryType[i]);
-    for(size_t i = 0; i < VK_MAX_MEMORY_HEAPS; ++i)
-        InitStatInfo(pStats->memoryHeap[i]);
+    vma_delete(this, quota);
+}
 
-    // Process default pools.
-    for(uint32_t memTypeIndex = 0; memTypeIndex < GetMemoryTypeCount(); ++memTypeIndex)
+void VmaAllocator_T::AddTaggedAllocations(const VmaAllocationCreateInfo& createInfo, size_t allocationCount, const VmaAllocation* pAllocations)
+{
+    for(size_t allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
     {
-        VmaBlockVector* const pBlockVector = m_pBlockVectors[memTypeIndex];
-        VMA_ASSERT(pBlockVector);
-        pBlockVector->AddStats(pStats);
+        const VmaAllocation allocation = pAllocations[allocIndex];
+        allocation->SetTag(createInfo.tag);
+        allocation->SetLifetime(createInfo.lifetime);
+        m_TagStats.AddAllocation(createInfo.tag, allocation->GetMemoryTypeIndex(), allocation->GetSize());
+        PublishAllocationSize(allocation, 0, allocation->GetSize());
     }
+}
 
-    // Process custom pools.
+void VmaAllocator_T::PublishAllocationSize(VmaAllocation allocation, VkDeviceSize oldSize, VkDeviceSize newSize)
+{
+    if(!m_StatsPublisher.IsEnabled() || oldSize == newSize)
     {
-        VmaMutexLockRead lock(m_PoolsMutex, m_UseMutex);
-        for(size_t poolIndex = 0, poolCount = m_Pools.size(); poolIndex < poolCount; ++poolIndex)
-        {
-            m_Pools[poolIndex]->m_BlockVector.AddStats(pStats);
-        }
+        return;
     }
-
-    // Process dedicated allocations.
-    for(uint32_t memTypeIndex = 0; memTypeIndex < GetMemoryTypeCount(); ++memTypeIndex)
+    if(oldSize == 0 && allocation->GetType() == VmaAllocation_T::ALLOCATION_TYPE_BLOCK)
     {
-        const uint32_t memHeapIndex = MemoryTypeIndexToHeapIndex(memTypeIndex);
-        VmaMutexLockRead dedicatedAllocationsLock(m_DedicatedAllocationsMutex[memTypeIndex], m_UseMutex);
-        AllocationVectorType* const pDedicatedAllocVector = m_pDedicatedAllocations[memTypeIndex];
-        VMA_ASSERT(pDedicatedAllocVector);
-        for(size_t allocIndex = 0, allocCount = pDedicatedAllocVector->size(); allocIndex < allocCount; ++allocIndex)
+        const VmaPool hPool = allocation->GetBlock()->GetParentPool();
+        if(hPool != VK_NULL_HANDLE)
         {
-            VmaStatInfo allocationStatInfo;
-            (*pDedicatedAllocVector)[allocIndex]->DedicatedAllocCalcStatsInfo(allocationStatInfo);
-            VmaAddStatInfo(pStats->total, allocationStatInfo);
-            VmaAddStatInfo(pStats->memoryType[memTypeIndex], allocationStatInfo);
-            VmaAddStatInfo(pStats->memoryHeap[memHeapIndex], allocationStatInfo);
+            allocation->SetPublishedPoolSlot(hPool->GetPublishedStatsSlot());
         }
     }
-
-    // Postprocess.
-    VmaPostprocessCalcStatInfo(pStats->total);
-    for(size_t i = 0; i < GetMemoryTypeCount(); ++i)
-        VmaPostprocessCalcStatInfo(pStats->memoryType[i]);
-    for(size_t i = 0; i < GetMemoryHeapCount(); ++i)
-        VmaPostprocessCalcStatInfo(pStats->memoryHeap[i]);
+    const uint32_t memTypeIndex = allocation->GetMemoryTypeIndex();
+    m_StatsPublisher.UpdateAllocation(
+        memTypeIndex, MemoryTypeIndexToHeapIndex(memTypeIndex), allocation->GetPublishedPoolSlot(), oldSize, newSize);
 }
 
-void VmaAllocator_T::GetBudget(VmaBudget* outBudget, uint32_t firstHeap, uint32_t heapCount)
+void VmaAllocator_T::DeferDestruction(
+    uint64_t completionValue,
+    VkBuffer buffer,
+    VkImage image,
+    VmaAllocation allocation)
 {
-#if VMA_MEMORY_BUDGET
-    if(m_UseExtMemoryBudget)
+    // From now on the allocation is owned by the queue, not the scope.
+    if(allocation != VK_NULL_HANDLE && allocation->GetScope() != VK_NULL_HANDLE)
     {
-        if(m_Budget.m_OperationsSinceBudgetFetch < 30)
-        {
-            VmaMutexLockRead lockRead(m_Budget.m_BudgetMutex, m_UseMutex);
-            for(uint32_t i = 0; i < heapCount; ++i, ++outBudget)
-            {
-                const uint32_t heapIndex = firstHeap + i;
+        allocation->GetScope()->Remove(allocation);
+    }
 
-                outBudget->blockBytes = m_Budget.m_BlockBytes[heapIndex];
-                outBudget->allocationBytes = m_Budget.m_AllocationBytes[heapIndex];
+    VmaDeferredDestruction entry = {};
+    entry.completionValue = completionValue;
+    entry.buffer = buffer;
+    entry.image = image;
+    entry.allocation = allocation;
 
-                if(m_Budget.m_VulkanUsage[heapIndex] + outBudget->blockBytes > m_Budget.m_BlockBytesAtBudgetFetch[heapIndex])
-                {
-                    outBudget->usage = m_Budget.m_VulkanUsage[heapIndex] +
-                        outBudget->blockBytes - m_Budget.m_BlockBytesAtBudgetFetch[heapIndex];
-                }
-                else
-                {
-                    outBudget->usage = 0;
-                }
+    VmaMutexLock lock(m_DeferredDestructionsMutex, m_UseMutex);
+    m_DeferredDestructions.push_back(entry);
+}
 
-                // Have to take MIN with heap size because explicit HeapSizeLimit is included in it.
-                outBudget->budget = VMA_MIN(
-                    m_Budget.m_VulkanBudget[heapIndex], m_MemProps.memoryHeaps[heapIndex].size);
-            }
+size_t VmaAllocator_T::ProcessDeferredDestructions(uint64_t completedValue)
+{
+    const VmaStlAllocator<VmaDeferredDestruction> entryAllocator(GetAllocationCallbacks());
+    DeferredDestructionVectorType readyEntries(entryAllocator);
+    ExtractDeferredDestructions(completedValue, VK_NULL_HANDLE, readyEntries);
+    DestroyDeferred(readyEntries);
+    return readyEntries.size();
+}
+
+void VmaAllocator_T::ExtractDeferredDestructions(
+    uint64_t completedValue,
+    VmaPool hPool,
+    DeferredDestructionVectorType& outEntries)
+{
+    VmaMutexLock lock(m_DeferredDestructionsMutex, m_UseMutex);
+    size_t dstIndex = 0;
+    for(size_t srcIndex = 0; srcIndex < m_DeferredDestructions.size(); ++srcIndex)
+    {
+        const VmaDeferredDestruction& entry = m_DeferredDestructions[srcIndex];
+        bool extract = false;
+        if(hPool == VK_NULL_HANDLE)
+        {
+            extract = entry.completionValue <= completedValue;
         }
         else
         {
-            UpdateVulkanBudget(); // Outside of mutex lock
-            GetBudget(outBudget, firstHeap, heapCount); // Recursion
+            extract = entry.allocation != VK_NULL_HANDLE &&
+                entry.allocation->GetType() == VmaAllocation_T::ALLOCATION_TYPE_BLOCK &&
+                entry.allocation->GetLastUseFrameIndex() != VMA_FRAME_INDEX_LOST &&
+                entry.allocation->GetBlock()->GetParentPool() == hPool;
         }
-    }
-    else
-#endif
-    {
-        for(uint32_t i = 0; i < heapCount; ++i, ++outBudget)
-        {
-            const uint32_t heapIndex = firstHeap + i;
-
-            outBudget->blockBytes = m_Budget.m_BlockBytes[heapIndex];
-            outBudget->allocationBytes = m_Budget.m_AllocationBytes[heapIndex];
 
-            outBudget->usage = outBudget->blockBytes;
-            outBudget->budget = m_MemProps.memoryHeaps[heapIndex].size * 8 / 10; // 80% heuristics.
+        if(extract)
+        {
+            outEntries.push_back(entry);
+        }
+        else
+        {
+            m_DeferredDestructions[dstIndex++] = entry;
         }
     }
+    m_DeferredDestructions.resize(dstIndex);
 }
 
-static const uint32_t VMA_VENDOR_ID_AMD = 4098;
-
-VkResult VmaAllocator_T::DefragmentationBegin(
-    const VmaDefragmentationInfo2& info,
-    VmaDefragmentationStats* pStats,
-    VmaDefragmentationContext* pContext)
+void VmaAllocator_T::DestroyDeferred(const DeferredDestructionVectorType& entries)
 {
-    if(info.pAllocationsChanged != VMA_NULL)
+    const VmaStlAllocator<VmaAllocation> allocationAllocator(GetAllocationCallbacks());
+    AllocationVectorType allocations(allocationAllocator);
+    for(size_t entryIndex = 0; entryIndex < entries.size(); ++entryIndex)
     {
-        memset(info.pAllocationsChanged, 0, info.allocationCount * sizeof(VkBool32));
+        const VmaDeferredDestruction& entry = entries[entryIndex];
+        if(entry.buffer != VK_NULL_HANDLE)
+        {
+            (*m_VulkanFunctions.vkDestroyBuffer)(m_hDevice, entry.buffer, GetAllocationCallbacks());
+        }
+        if(entry.image != VK_NULL_HANDLE)
+        {
+            (*m_VulkanFunctions.vkDestroyImage)(m_hDevice, entry.image, GetAllocationCallbacks());
+        }
+        if(entry.allocation != VK_NULL_HANDLE)
+        {
+            allocations.push_back(entry.allocation);
+        }
     }
 
-    *pContext = vma_new(this, VmaDefragmentationContext_T)(
-        this, m_CurrentFrameIndex.load(), info.flags, pStats);
-
-    (*pContext)->AddPools(info.poolCount, info.pPools);
-    (*pContext)->AddAllocations(
-        info.allocationCount, info.pAllocations, info.pAllocationsChanged);
-
-    VkResult res = (*pContext)->Defragment(
-        info.maxCpuBytesToMove, info.maxCpuAllocationsToMove,
-        info.maxGpuBytesToMove, info.maxGpuAllocationsToMove,
-        info.commandBuffer, pStats, info.flags);
+    if(allocations.empty())
+    {
+        return;
+    }
 
-    if(res != VK_NOT_READY)
+#if VMA_RECORDING_ENABLED
+    // Recorded when memory is actually freed, so replay doesn't need to know about the queue.
+    if(m_pRecorder != VMA_NULL)
     {
-        vma_delete(this, *pContext);
-        *pContext = VMA_NULL;
+        m_pRecorder->RecordFreeMemoryPages(GetCurrentFrameIndex(), allocations.size(), allocations.data());
     }
+#endif
 
-    return res;
+    FreeMemoryBatch(allocations.size(), allocations.data());
 }
 
-VkResult VmaAllocator_T::DefragmentationEnd(
-    VmaDefragmentationContext context)
+VkResult VmaAllocator_T::CreateReadbackHeap(
+    const VmaReadbackHeapCreateInfo& createInfo,
+    VmaReadbackHeap* pHeap,
+    VmaAllocationInfo* pAllocationInfo)
 {
-    vma_delete(this, context);
-    return VK_SUCCESS;
-}
+    VmaReadbackHeap_T* const heap = vma_new(this, VmaReadbackHeap_T)(this, createInfo);
 
-VkResult VmaAllocator_T::DefragmentationPassBegin(
-    VmaDefragmentationPassInfo* pInfo,
-    VmaDefragmentationContext context)
-{
-    return context->DefragmentPassBegin(pInfo);
-}
-VkResult VmaAllocator_T::DefragmentationPassEnd(
-    VmaDefragmentationContext context)
-{
-    return context->DefragmentPassEnd();
+    VkBufferCreateInfo bufCreateInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    bufCreateInfo.size = heap->GetFrameSize() * heap->GetSliceCount();
+    bufCreateInfo.usage = createInfo.bufferUsage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-}
+    VmaAllocationCreateInfo allocCreateInfo = {};
+    allocCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    // Prefers HOST_CACHED memory types. Reading uncached memory on the CPU is very slow.
+    allocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+    allocCreateInfo.memoryTypeBits = createInfo.memoryTypeBits;
 
-void VmaAllocator_T::GetAllocationInfo(VmaAllocation hAllocation, VmaAllocationInfo* pAllocationInfo)
-{
-    if(hAllocation->CanBecomeLost())
+    VkResult res = (*GetVulkanFunctions().vkCreateBuffer)(m_hDevice, &bufCreateInfo, GetAllocationCallbacks(), &heap->m_Buffer);
+    if(res >= 0)
     {
-        /*
-        Warning: This is a carefully designed algorithm.
-        Do not modify unless you really know what you're doing :)
-        */
-        const uint32_t localCurrFrameIndex = m_CurrentFrameIndex.load();
-        uint32_t localLastUseFrameIndex = hAllocation->GetLastUseFrameIndex();
-        for(;;)
+        VkMemoryRequirements vkMemReq = {};
+        bool requiresDedicatedAllocation = false;
+        bool prefersDedicatedAllocation  = false;
+        GetBufferMemoryRequirements(heap->m_Buffer, vkMemReq,
+            requiresDedicatedAllocation, prefersDedicatedAllocation);
+
+        res = AllocateMemory(
+            vkMemReq,
+            requiresDedicatedAllocation,
+            prefersDedicatedAllocation,
+            heap->m_Buffer, // dedicatedBuffer
+            bufCreateInfo.usage, // dedicatedBufferUsage
+            VK_NULL_HANDLE, // dedicatedImage
+            allocCreateInfo,
+            VMA_SUBALLOCATION_TYPE_BUFFER,
+            1, // allocationCount
+            &heap->m_Allocation);
+
+#if VMA_RECORDING_ENABLED
+        if(m_pRecorder != VMA_NULL)
         {
-            if(localLastUseFrameIndex == VMA_FRAME_INDEX_LOST)
-            {
-                pAllocationInfo->memoryType = UINT32_MAX;
-                pAllocationInfo->deviceMemory = VK_NULL_HANDLE;
-                pAllocationInfo->offset = 0;
-                pAllocationInfo->size = hAllocation->GetSize();
-                pAllocationInfo->pMappedData = VMA_NULL;
-                pAllocationInfo->pUserData = hAllocation->GetUserData();
-                return;
-            }
-            else if(localLastUseFrameIndex == localCurrFrameIndex)
-            {
-                pAllocationInfo->memoryType = hAllocation->GetMemoryTypeIndex();
-                pAllocationInfo->deviceMemory = hAllocation->GetMemory();
-                pAllocationInfo->offset = hAllocation->GetOffset();
-                pAllocationInfo->size = hAllocation->GetSize();
-                pAllocationInfo->pMappedData = VMA_NULL;
-                pAllocationInfo->pUserData = hAllocation->GetUserData();
-                return;
-            }
-            else // Last use time earlier than current time.
-            {
-                if(hAllocation->CompareExchangeLastUseFrameIndex(localLastUseFrameIndex, localCurrFrameIndex))
-                {
-                    localLastUseFrameIndex = localCurrFrameIndex;
-                }
-            }
+            m_pRecorder->RecordAllocateMemory(GetCurrentFrameIndex(), vkMemReq, allocCreateInfo, heap->m_Allocation);
         }
-    }
-    else
-    {
-#if VMA_STATS_STRING_ENABLED
-        uint32_t localCurrFrameIndex = m_CurrentFrameIndex.load();
-        uint32_t localLastUseFrameIndex = hAllocation->GetLastUseFrameIndex();
-        for(;;)
+#endif
+
+        if(res >= 0)
         {
-            VMA_ASSERT(localLastUseFrameIndex != VMA_FRAME_INDEX_LOST);
-            if(localLastUseFrameIndex == localCurrFrameIndex)
-            {
-                break;
-            }
-            else // Last use time earlier than current time.
+            res = BindBufferMemory(heap->m_Allocation, 0, heap->m_Buffer, VMA_NULL);
+            if(res >= 0)
             {
-                if(hAllocation->CompareExchangeLastUseFrameIndex(localLastUseFrameIndex, localCurrFrameIndex))
+                #if VMA_STATS_STRING_ENABLED
+                    heap->m_Allocation->InitBufferImageUsage(bufCreateInfo.usage);
+                #endif
+                if(pAllocationInfo != VMA_NULL)
                 {
-                    localLastUseFrameIndex = localCurrFrameIndex;
+                    GetAllocationInfo(heap->m_Allocation, pAllocationInfo);
                 }
+                *pHeap = heap;
+                return VK_SUCCESS;
             }
+            FreeMemory(
+                1, // allocationCount
+                &heap->m_Allocation);
+            heap->m_Allocation = VK_NULL_HANDLE;
         }
-#endif
+        (*GetVulkanFunctions().vkDestroyBuffer)(m_hDevice, heap->m_Buffer, GetAllocationCallbacks());
+        heap->m_Buffer = VK_NULL_HANDLE;
+    }
+    vma_delete(this, heap);
+    return res;
+}
 
-        pAllocationInfo->memoryType = hAllocation->GetMemoryTypeIndex();
-        pAllocationInfo->deviceMemory = hAllocation->GetMemory();
-        pAllocationInfo->offset = hAllocation->GetOffset();
-        pAllocationInfo->size = hAllocation->GetSize();
-        pAllocationInfo->pMappedData = hAllocation->GetMappedData();
-        pAllocationInfo->pUserData = hAllocation->GetUserData();
+void VmaAllocator_T::DestroyReadbackHeap(VmaReadbackHeap heap)
+{
+#if VMA_RECORDING_ENABLED
+    if(m_pRecorder != VMA_NULL)
+    {
+        m_pRecorder->RecordFreeMemory(GetCurrentFrameIndex(), heap->m_Allocation);
     }
+#endif
+
+    (*GetVulkanFunctions().vkDestroyBuffer)(m_hDevice, heap->m_Buffer, GetAllocationCallbacks());
+    heap->m_Buffer = VK_NULL_HANDLE;
+    FreeMemory(
+        1, // allocationCount
+        &heap->m_Allocation);
+    heap->m_Allocation = VK_NULL_HANDLE;
+    vma_delete(this, heap);
 }
 
-bool VmaAllocator_T::TouchAllocation(VmaAllocation hAllocation)
+VkResult VmaAllocator_T::InvalidateReadbackHeaps(
+    uint32_t heapCount,
+    const VmaReadbackHeap* pHeaps,
+    uint32_t frameIndex)
 {
-    // This is a stripped-down version of VmaAllocator_T::GetAllocationInfo.
-    if(hAllocation->CanBecomeLost())
+    typedef VmaStlAllocator<VmaAllocation> AllocationAllocator;
+    typedef VmaStlAllocator<VkDeviceSize> SizeAllocator;
+    const AllocationAllocator allocationAllocator(GetAllocationCallbacks());
+    const SizeAllocator sizeAllocator(GetAllocationCallbacks());
+    VmaSmallVector<VmaAllocation, AllocationAllocator, 16> allocations(allocationAllocator);
+    VmaSmallVector<VkDeviceSize, SizeAllocator, 16> offsets(sizeAllocator);
+    VmaSmallVector<VkDeviceSize, SizeAllocator, 16> sizes(sizeAllocator);
+
+    for(uint32_t heapIndex = 0; heapIndex < heapCount; ++heapIndex)
     {
-        uint32_t localCurrFrameIndex = m_CurrentFrameIndex.load();
-        uint32_t localLastUseFrameIndex = hAllocation->GetLastUseFrameIndex();
-        for(;;)
+        VmaReadbackHeap heap = pHeaps[heapIndex];
+        VkDeviceSize offset = 0, size = 0;
+        if(heap != VK_NULL_HANDLE && heap->GetFrameRange(frameIndex, offset, size))
         {
-            if(localLastUseFrameIndex == VMA_FRAME_INDEX_LOST)
-            {
-                return false;
-            }
-            else if(localLastUseFrameIndex == localCurrFrameIndex)
-            {
-                return true;
-            }
-            else // Last use time earlier than current time.
-            {
-                if(hAllocation->CompareExchangeLastUseFrameIndex(localLastUseFrameIndex, localCurrFrameIndex))
-                {
-                    localLastUseFrameIndex = localCurrFrameIndex;
-                }
-            }
+            allocations.push_back(heap->m_Allocation);
+            offsets.push_back(offset);
+            sizes.push_back(size);
         }
     }
-    else
+
+    return FlushOrInvalidateAllocations(
+        (uint32_t)allocations.size(), allocations.data(), offsets.data(), sizes.data(), VMA_CACHE_INVALIDATE);
+}
+
+VkResult VmaAllocator_T::CreateSparseBuffer(
+    const VmaSparseBufferCreateInfo& createInfo,
+    VmaSparseBuffer* pSparseBuffer)
+{
+    VkBufferCreateInfo bufCreateInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    bufCreateInfo.flags = VK_BUFFER_CREATE_SPARSE_BINDING_BIT | VK_BUFFER_CREATE_SPARSE_RESIDENCY_BIT;
+    bufCreateInfo.size = createInfo.size;
+    bufCreateInfo.usage = createInfo.bufferUsage;
+    bufCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    // Size of the buffer depends on page size, which depends on sparse block size returned as
+    // alignment in memory requirements, so the buffer is created twice if size is not a multiple of it.
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkResult res = (*GetVulkanFunctions().vkCreateBuffer)(m_hDevice, &bufCreateInfo, GetAllocationCallbacks(), &buffer);
+    if(res < 0)
     {
-#if VMA_STATS_STRING_ENABLED
-        uint32_t localCurrFrameIndex = m_CurrentFrameIndex.load();
-        uint32_t localLastUseFrameIndex = hAllocation->GetLastUseFrameIndex();
-        for(;;)
+        return res;
+    }
+    VkMemoryRequirements vkMemReq = {};
+    (*GetVulkanFunctions().vkGetBufferMemoryRequirements)(m_hDevice, buffer, &vkMemReq);
+
+    const VkDeviceSize pageSize = VmaAlignUp(
+        createInfo.pageSize != 0 ? createInfo.pageSize : (VkDeviceSize)VMA_DEFAULT_SPARSE_PAGE_SIZE,
+        vkMemReq.alignment);
+    const VkDeviceSize bufferSize = VmaAlignUp(createInfo.size, pageSize);
+    if(bufferSize != createInfo.size)
+    {
+        (*GetVulkanFunctions().vkDestroyBuffer)(m_hDevice, buffer, GetAllocationCallbacks());
+        buffer = VK_NULL_HANDLE;
+        bufCreateInfo.size = bufferSize;
+        res = (*GetVulkanFunctions().vkCreateBuffer)(m_hDevice, &bufCreateInfo, GetAllocationCallbacks(), &buffer);
+        if(res < 0)
         {
-            VMA_ASSERT(localLastUseFrameIndex != VMA_FRAME_INDEX_LOST);
-            if(localLastUseFrameIndex == localCurrFrameIndex)
-            {
-                break;
-            }
-            else // Last use time earlier than current time.
-            {
-                if(hAllocation->CompareExchangeLastUseFrameIndex(localLastUseFrameIndex, localCurrFrameIndex))
-                {
-                    localLastUseFrameIndex = localCurrFrameIndex;
-                }
-            }
+            return res;
         }
-#endif
+    }
 
-        return true;
+    VmaAllocationCreateInfo allocCreateInfo = {};
+    allocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    const uint32_t memoryTypeBits = vkMemReq.memoryTypeBits &
+        (createInfo.memoryTypeBits != 0 ? createInfo.memoryTypeBits : UINT32_MAX);
+    uint32_t memTypeIndex = UINT32_MAX;
+    res = vmaFindMemoryTypeIndex(this, memoryTypeBits, &allocCreateInfo, &memTypeIndex);
+    if(res != VK_SUCCESS)
+    {
+        (*GetVulkanFunctions().vkDestroyBuffer)(m_hDevice, buffer, GetAllocationCallbacks());
+        return res;
     }
+
+    VmaSparseBuffer_T* const sparseBuffer = vma_new(this, VmaSparseBuffer_T)(
+        this, createInfo, pageSize, (uint32_t)(bufferSize / pageSize), memTypeIndex);
+    sparseBuffer->m_Buffer = buffer;
+    *pSparseBuffer = sparseBuffer;
+    return VK_SUCCESS;
 }
 
-VkResult VmaAllocator_T::CreatePool(const VmaPoolCreateInfo* pCreateInfo, VmaPool* pPool)
+void VmaAllocator_T::DestroySparseBuffer(VmaSparseBuffer sparseBuffer)
 {
-    VMA_DEBUG_LOG("  CreatePool: MemoryTypeIndex=%u, flags=%u", pCreateInfo->memoryTypeIndex, pCreateInfo->flags);
+    (*GetVulkanFunctions().vkDestroyBuffer)(m_hDevice, sparseBuffer->m_Buffer, GetAllocationCallbacks());
+    sparseBuffer->m_Buffer = VK_NULL_HANDLE;
+    vma_delete(this, sparseBuffer);
+}
 
-    VmaPoolCreateInfo newCreateInfo = *pCreateInfo;
+VkResult VmaAllocator_T::SubmitSparseBinds(
+    uint32_t sparseBufferCount,
+    const VmaSparseBuffer* pSparseBuffers,
+    const VmaSparseBindSubmitInfo& submitInfo)
+{
+    typedef VmaStlAllocator<VkSparseMemoryBind> BindAllocator;
+    typedef VmaStlAllocator<VkSparseBufferMemoryBindInfo> BufferBindAllocator;
+    typedef VmaStlAllocator<size_t> IndexAllocator;
+    typedef VmaStlAllocator<VmaSparseBuffer> SparseBufferAllocator;
+    const BindAllocator bindAllocator(GetAllocationCallbacks());
+    const BufferBindAllocator bufferBindAllocator(GetAllocationCallbacks());
+    const IndexAllocator indexAllocator(GetAllocationCallbacks());
+    const SparseBufferAllocator sparseBufferAllocator(GetAllocationCallbacks());
+    VmaVector< VkSparseMemoryBind, BindAllocator > binds(bindAllocator);
+    VmaSmallVector<VkSparseBufferMemoryBindInfo, BufferBindAllocator, 16> bufferBinds(bufferBindAllocator);
+    // Index of the first element of `binds` for each element of `bufferBinds`.
+    VmaSmallVector<size_t, IndexAllocator, 16> firstBindIndices(indexAllocator);
 
-    if(newCreateInfo.maxBlockCount == 0)
+    // Each buffer must be locked and gathered only once, even if passed multiple times.
+    // Sorting also makes the buffers always locked in the same order.
+    VmaSmallVector<VmaSparseBuffer, SparseBufferAllocator, 16> sparseBuffers(sparseBufferAllocator);
+    for(uint32_t sparseBufferIndex = 0; sparseBufferIndex < sparseBufferCount; ++sparseBufferIndex)
     {
-        newCreateInfo.maxBlockCount = SIZE_MAX;
+        if(pSparseBuffers[sparseBufferIndex] != VK_NULL_HANDLE)
+        {
+            sparseBuffers.push_back(pSparseBuffers[sparseBufferIndex]);
+        }
     }
-    if(newCreateInfo.minBlockCount > newCreateInfo.maxBlockCount)
+    VMA_SORT(sparseBuffers.data(), sparseBuffers.data() + sparseBuffers.size(), VmaPointerLess());
+    size_t uniqueSparseBufferCount = 0;
+    for(size_t i = 0; i < sparseBuffers.size(); ++i)
     {
-        return VK_ERROR_INITIALIZATION_FAILED;
+        if(uniqueSparseBufferCount == 0 || sparseBuffers[uniqueSparseBufferCount - 1] != sparseBuffers[i])
+        {
+            sparseBuffers[uniqueSparseBufferCount++] = sparseBuffers[i];
+        }
     }
-    // Memory type index out of range or forbidden.
-    if(pCreateInfo->memoryTypeIndex >= GetMemoryTypeCount() ||
-        ((1u << pCreateInfo->memoryTypeIndex) & m_GlobalMemoryTypeBits) == 0)
+    sparseBuffers.resize(uniqueSparseBufferCount);
+
+    // Buffers stay locked until the submitted binds are applied to them.
+    for(size_t sparseBufferIndex = 0; sparseBufferIndex < sparseBuffers.size(); ++sparseBufferIndex)
     {
-        return VK_ERROR_FEATURE_NOT_PRESENT;
+        VmaSparseBuffer sparseBuffer = sparseBuffers[sparseBufferIndex];
+        sparseBuffer->Lock();
+        const size_t firstBindIndex = binds.size();
+        sparseBuffer->GatherBinds(binds);
+        if(binds.size() > firstBindIndex)
+        {
+            VkSparseBufferMemoryBindInfo bufferBind = {};
+            bufferBind.buffer = sparseBuffer->m_Buffer;
+            bufferBind.bindCount = (uint32_t)(binds.size() - firstBindIndex);
+            bufferBinds.push_back(bufferBind);
+            firstBindIndices.push_back(firstBindIndex);
+        }
+    }
+    // `binds` could be reallocated while gathering, so pointers are set only now.
+    for(size_t bufferBindIndex = 0; bufferBindIndex < bufferBinds.size(); ++bufferBindIndex)
+    {
+        bufferBinds[bufferBindIndex].pBinds = binds.data() + firstBindIndices[bufferBindIndex];
     }
 
-    const VkDeviceSize preferredBlockSize = CalcPreferredBlockSize(newCreateInfo.memoryTypeIndex);
+    VkResult res = VK_SUCCESS;
+    if(!bufferBinds.empty() ||
+        submitInfo.waitSemaphoreCount > 0 ||
+        submitInfo.signalSemaphoreCount > 0 ||
+        submitInfo.fence != VK_NULL_HANDLE)
+    {
+        VMA_ASSERT(m_VulkanFunctions.vkQueueBindSparse != VMA_NULL);
 
-    *pPool = vma_new(this, VmaPool_T)(this, newCreateInfo, preferredBlockSize);
+        VkBindSparseInfo bindSparseInfo = { VK_STRUCTURE_TYPE_BIND_SPARSE_INFO };
+        bindSparseInfo.waitSemaphoreCount = submitInfo.waitSemaphoreCount;
+        bindSparseInfo.pWaitSemaphores = submitInfo.pWaitSemaphores;
+        bindSparseInfo.bufferBindCount = (uint32_t)bufferBinds.size();
+        bindSparseInfo.pBufferBinds = bufferBinds.data();
+        bindSparseInfo.signalSemaphoreCount = submitInfo.signalSemaphoreCount;
+        bindSparseInfo.pSignalSemaphores = submitInfo.pSignalSemaphores;
 
-    VkResult res = (*pPool)->m_BlockVector.CreateMinBlocks();
-    if(res != VK_SUCCESS)
-    {
-        vma_delete(this, *pPool);
-        *pPool = VMA_NULL;
-        return res;
+        // VULKAN CALL vkQueueBindSparse.
+        res = (*m_VulkanFunctions.vkQueueBindSparse)(submitInfo.queue, 1, &bindSparseInfo, submitInfo.fence);
     }
 
-    // Add to m_Pools.
+    const uint32_t currentFrameIndex = GetCurrentFrameIndex();
+    for(size_t sparseBufferIndex = 0; sparseBufferIndex < sparseBuffers.size(); ++sparseBufferIndex)
     {
-        VmaMutexLockWrite lock(m_PoolsMutex, m_UseMutex);
-        (*pPool)->SetId(m_NextPoolId++);
-        VmaVectorInsertSorted<VmaPointerLess>(m_Pools, *pPool);
+        VmaSparseBuffer sparseBuffer = sparseBuffers[sparseBufferIndex];
+        if(res == VK_SUCCESS)
+        {
+            sparseBuffer->ApplyBinds(currentFrameIndex);
+        }
+        sparseBuffer->FreeRetiredMemory(currentFrameIndex);
+        sparseBuffer->Unlock();
     }
-
-    return VK_SUCCESS;
+    return res;
 }
 
-void VmaAllocator_T::DestroyPool(VmaPool pool)
+VkResult VmaAllocator_T::CreateSparsePagePool(
+    const VmaSparsePagePoolCreateInfo& createInfo,
+    VmaSparsePagePool* pPool)
 {
-    // Remove from m_Pools.
+    static const VkDeviceSize DEFAULT_PAGE_SIZE = 64ull * 1024;
+    const VkDeviceSize pageSize = createInfo.pageSize != 0 ? createInfo.pageSize : DEFAULT_PAGE_SIZE;
+
+    VmaAllocationCreateInfo allocCreateInfo = {};
+    allocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    uint32_t memTypeIndex = UINT32_MAX;
+    VkResult res = vmaFindMemoryTypeIndex(
+        this,
+        createInfo.memoryTypeBits != 0 ? createInfo.memoryTypeBits : UINT32_MAX,
+        &allocCreateInfo,
+        &memTypeIndex);
+    if(res != VK_SUCCESS)
     {
-        VmaMutexLockWrite lock(m_PoolsMutex, m_UseMutex);
-        bool success = VmaVectorRemoveSorted<VmaPointerLess>(m_Pools, pool);
-        VMA_ASSERT(success && "Pool not found in Allocator.");
+        return res;
     }
 
-    vma_delete(this, pool);
+    uint32_t pagesPerBlock = createInfo.pagesPerBlock;
+    if(pagesPerBlock == 0)
+    {
+        pagesPerBlock = (uint32_t)VMA_MAX(CalcPreferredBlockSize(memTypeIndex) / pageSize, (VkDeviceSize)1);
+    }
+
+    *pPool = vma_new(this, VmaSparsePagePool_T)(this, createInfo, pageSize, pagesPerBlock, memTypeIndex);
+    return VK_SUCCESS;
 }
 
-void VmaAllocator_T::GetPoolStats(VmaPool pool, VmaPoolStats* pPoolStats)
+void VmaAllocator_T::DestroySparsePagePool(VmaSparsePagePool pool)
 {
-    pool->m_BlockVector.GetPoolStats(pPoolStats);
+    vma_delete(this, pool);
 }
 
 void VmaAllocator_T::SetCurrentFrameIndex(uint32_t frameIndex)
@@ -17030,6 +25293,13 @@ void VmaAllocator_T::SetCurrentFrameIndex(uint32_t frameIndex)
         UpdateVulkanBudget();
     }
 #endif // #if VMA_MEMORY_BUDGET
+
+#if VMA_PAGEABLE_DEVICE_LOCAL_MEMORY
+    if(m_UseExtPageableDeviceLocalMemory)
+    {
+        UpdateMemoryPriorities(frameIndex);
+    }
+#endif // #if VMA_PAGEABLE_DEVICE_LOCAL_MEMORY
 }
 
 void VmaAllocator_T::MakePoolAllocationsLost(
@@ -17046,6 +25316,50 @@ VkResult VmaAllocator_T::CheckPoolCorruption(VmaPool hPool)
     return hPool->m_BlockVector.CheckCorruption();
 }
 
+VkResult VmaAllocator_T::GetPoolMarker(VmaPool hPool, VkDeviceSize* pMarker)
+{
+    return hPool->m_BlockVector.GetMarker(pMarker);
+}
+
+VkResult VmaAllocator_T::RewindPool(VmaPool hPool, VkDeviceSize marker)
+{
+    const VmaStlAllocator<VmaAllocation> allocationAllocator(GetAllocationCallbacks());
+    AllocationVectorType allocations(allocationAllocator);
+    VkResult res = hPool->m_BlockVector.Rewind(marker, allocations);
+    FreeRemovedAllocations(allocations);
+    return res;
+}
+
+VkResult VmaAllocator_T::ResetPool(VmaPool hPool)
+{
+    const VmaStlAllocator<VmaAllocation> allocationAllocator(GetAllocationCallbacks());
+    AllocationVectorType allocations(allocationAllocator);
+    VkResult res = hPool->m_BlockVector.Reset(allocations);
+    FreeRemovedAllocations(allocations);
+    return res;
+}
+
+void VmaAllocator_T::FreeRemovedAllocations(const AllocationVectorType& allocations)
+{
+    if(allocations.empty())
+    {
+        return;
+    }
+
+#if VMA_RECORDING_ENABLED
+    // Recorded as regular frees, so replay doesn't need to know about pool markers.
+    if(m_pRecorder != VMA_NULL)
+    {
+        m_pRecorder->RecordFreeMemoryPages(GetCurrentFrameIndex(), allocations.size(), allocations.data());
+    }
+#endif
+
+    for(size_t allocIndex = 0; allocIndex < allocations.size(); ++allocIndex)
+    {
+        DestroyAllocationObject(allocations[allocIndex]);
+    }
+}
+
 VkResult VmaAllocator_T::CheckCorruption(uint32_t memoryTypeBits)
 {
     VkResult finalRes = VK_ERROR_FEATURE_NOT_PRESENT;
@@ -17096,6 +25410,53 @@ VkResult VmaAllocator_T::CheckCorruption(uint32_t memoryTypeBits)
     return finalRes;
 }
 
+VkResult VmaAllocator_T::ZeroFreeMemory(
+    VmaPool pool,
+    VkDeviceSize maxBytes,
+    uint32_t* pRangeCount,
+    VmaZeroFillRange* pRanges)
+{
+    const size_t maxRangeCount = pRanges != VMA_NULL ? *pRangeCount : 0;
+    const VmaStlAllocator<VmaZeroFillRange> rangeAllocator(GetAllocationCallbacks());
+    VmaVector< VmaZeroFillRange, VmaStlAllocator<VmaZeroFillRange> > ranges(rangeAllocator);
+
+    VkResult res = VK_SUCCESS;
+    if(pool != VK_NULL_HANDLE)
+    {
+        res = pool->m_BlockVector.ZeroFreeMemory(maxBytes, maxRangeCount, ranges);
+    }
+    else
+    {
+        // Process default pools. A memory type that is incomplete, e.g. not HOST_VISIBLE while pRanges is null,
+        // must not stop the others from making progress.
+        for(uint32_t memTypeIndex = 0; memTypeIndex < GetMemoryTypeCount(); ++memTypeIndex)
+        {
+            VmaBlockVector* const pBlockVector = m_pBlockVectors[memTypeIndex];
+            if(pBlockVector != VMA_NULL)
+            {
+                const VkResult localRes = pBlockVector->ZeroFreeMemory(maxBytes, maxRangeCount, ranges);
+                if(localRes == VK_INCOMPLETE)
+                {
+                    res = VK_INCOMPLETE;
+                }
+                else if(localRes != VK_SUCCESS)
+                {
+                    res = localRes;
+                    break;
+                }
+            }
+        }
+    }
+
+    VMA_ASSERT(ranges.size() <= maxRangeCount);
+    for(size_t rangeIndex = 0; rangeIndex < ranges.size(); ++rangeIndex)
+    {
+        pRanges[rangeIndex] = ranges[rangeIndex];
+    }
+    *pRangeCount = (uint32_t)ranges.size();
+    return res;
+}
+
 void VmaAllocator_T::CreateLostAllocation(VmaAllocation* pAllocation)
 {
     *pAllocation = m_AllocationObjectAllocator.Allocate(VMA_FRAME_INDEX_LOST, false);
@@ -17137,6 +25498,7 @@ VkResult VmaAllocator_T::AllocateVulkanMemory(const VkMemoryAllocateInfo* pAlloc
 #if VMA_MEMORY_BUDGET
         ++m_Budget.m_OperationsSinceBudgetFetch;
 #endif
+        m_StatsPublisher.UpdateDeviceMemory(pAllocateInfo->memoryTypeIndex, heapIndex, 0, pAllocateInfo->allocationSize);
 
         // Informative callback.
         if(m_DeviceMemoryCallbacks.pfnAllocate != VMA_NULL)
@@ -17164,6 +25526,7 @@ void VmaAllocator_T::FreeVulkanMemory(uint32_t memoryType, VkDeviceSize size, Vk
     (*m_VulkanFunctions.vkFreeMemory)(m_hDevice, hMemory, GetAllocationCallbacks());
 
     m_Budget.m_BlockBytes[MemoryTypeIndexToHeapIndex(memoryType)] -= size;
+    m_StatsPublisher.UpdateDeviceMemory(memoryType, MemoryTypeIndexToHeapIndex(memoryType), size, 0);
 }
 
 VkResult VmaAllocator_T::BindVulkanBuffer(
@@ -17568,6 +25931,11 @@ void VmaAllocator_T::UpdateVulkanBudget()
             {
                 m_Budget.m_VulkanUsage[heapIndex] = m_Budget.m_BlockBytesAtBudgetFetch[heapIndex];
             }
+
+            m_StatsPublisher.UpdateBudget(
+                heapIndex,
+                m_Budget.m_VulkanUsage[heapIndex],
+                VMA_MIN(m_Budget.m_VulkanBudget[heapIndex], m_MemProps.memoryHeaps[heapIndex].size));
         }
         m_Budget.m_OperationsSinceBudgetFetch = 0;
     }
@@ -17575,6 +25943,46 @@ void VmaAllocator_T::UpdateVulkanBudget()
 
 #endif // #if VMA_MEMORY_BUDGET
 
+#if VMA_PAGEABLE_DEVICE_LOCAL_MEMORY
+
+void VmaAllocator_T::UpdateMemoryPriorities(uint32_t currentFrameIndex)
+{
+    for(uint32_t memTypeIndex = 0; memTypeIndex < GetMemoryTypeCount(); ++memTypeIndex)
+    {
+        VmaBlockVector* const pBlockVector = m_pBlockVectors[memTypeIndex];
+        VMA_ASSERT(pBlockVector);
+        pBlockVector->UpdateMemoryPriorities(currentFrameIndex);
+    }
+
+    {
+        VmaMutexLockRead lock(m_PoolsMutex, m_UseMutex);
+        for(size_t poolIndex = 0, poolCount = m_Pools.size(); poolIndex < poolCount; ++poolIndex)
+        {
+            m_Pools[poolIndex]->m_BlockVector.UpdateMemoryPriorities(currentFrameIndex);
+        }
+    }
+
+    for(uint32_t memTypeIndex = 0; memTypeIndex < GetMemoryTypeCount(); ++memTypeIndex)
+    {
+        VmaMutexLockRead dedicatedAllocationsLock(m_DedicatedAllocationsMutex[memTypeIndex], m_UseMutex);
+        AllocationVectorType* const pDedicatedAllocVector = m_pDedicatedAllocations[memTypeIndex];
+        VMA_ASSERT(pDedicatedAllocVector);
+        for(size_t allocIndex = 0, allocCount = pDedicatedAllocVector->size(); allocIndex < allocCount; ++allocIndex)
+        {
+            const VmaAllocation hAlloc = (*pDedicatedAllocVector)[allocIndex];
+            const float priority = VmaCalcColdMemoryPriority(
+                hAlloc->GetDedicatedPriority(), hAlloc->GetLastUseFrameIndex(), currentFrameIndex);
+            if(priority != hAlloc->GetDedicatedAppliedPriority())
+            {
+                (*m_VulkanFunctions.vkSetDeviceMemoryPriorityEXT)(m_hDevice, hAlloc->GetMemory(), priority);
+                hAlloc->SetDedicatedAppliedPriority(priority);
+            }
+        }
+    }
+}
+
+#endif // #if VMA_PAGEABLE_DEVICE_LOCAL_MEMORY
+
 void VmaAllocator_T::FillAllocation(const VmaAllocation hAllocation, uint8_t pattern)
 {
     if(VMA_DEBUG_INITIALIZE_ALLOCATIONS &&
@@ -17723,6 +26131,25 @@ VMA_CALL_PRE void VMA_CALL_POST vmaDestroyAllocator(
     }
 }
 
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaDumpRecording(
+    VmaAllocator allocator,
+    const char* pFilePath)
+{
+    VMA_ASSERT(allocator);
+
+    VMA_DEBUG_LOG("vmaDumpRecording");
+
+    // No VMA_DEBUG_GLOBAL_MUTEX_LOCK - it may be called from a crash handler while another call is in progress.
+
+#if VMA_RECORDING_ENABLED
+    if(allocator->GetRecorder() != VMA_NULL)
+    {
+        return allocator->GetRecorder()->Dump(pFilePath);
+    }
+#endif
+    return VK_ERROR_FEATURE_NOT_PRESENT;
+}
+
 VMA_CALL_PRE void VMA_CALL_POST vmaGetAllocatorInfo(VmaAllocator allocator, VmaAllocatorInfo* pAllocatorInfo)
 {
     VMA_ASSERT(allocator && pAllocatorInfo);
@@ -17787,6 +26214,50 @@ VMA_CALL_PRE void VMA_CALL_POST vmaGetBudget(
     allocator->GetBudget(pBudget, 0, allocator->GetMemoryHeapCount());
 }
 
+VMA_CALL_PRE void VMA_CALL_POST vmaGetAllocationTagStats(
+    VmaAllocator allocator,
+    uint32_t tag,
+    VmaAllocationTagStats* pTagStats)
+{
+    VMA_ASSERT(allocator && tag < VMA_ALLOCATION_TAG_COUNT && pTagStats);
+    allocator->m_TagStats.GetStats(tag, allocator->GetMemoryTypeCount(), *pTagStats);
+}
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaReadPublishedStats(
+    const void* pPublishedMemory,
+    VmaPublishedStats* pStats)
+{
+    VMA_ASSERT(pPublishedMemory && pStats);
+
+    const VmaPublishedStats* const pSrc = (const VmaPublishedStats*)pPublishedMemory;
+    const volatile uint64_t* const pBeginSequence = &pSrc->beginSequence;
+    const volatile uint64_t* const pEndSequence = &pSrc->endSequence;
+    for(uint32_t attempt = 0; attempt < 1000; ++attempt)
+    {
+        // If all updates begun so far have ended, none is in progress. An update that ends
+        // after beginSequence was read can only make endSequence equal to it if another one
+        // began meanwhile, which is detected by reading beginSequence again after the copy.
+        const uint64_t sequenceBefore = *pBeginSequence;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(*pEndSequence != sequenceBefore)
+        {
+            continue;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        memcpy(pStats, pSrc, sizeof(VmaPublishedStats));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(*pBeginSequence == sequenceBefore)
+        {
+            if(pStats->magic != VMA_PUBLISHED_STATS_MAGIC || pStats->version != VMA_PUBLISHED_STATS_VERSION)
+            {
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+            return VK_SUCCESS;
+        }
+    }
+    return VK_NOT_READY;
+}
+
 #if VMA_STATS_STRING_ENABLED
 
 VMA_CALL_PRE void VMA_CALL_POST vmaBuildStatsString(
@@ -17902,6 +26373,38 @@ VMA_CALL_PRE void VMA_CALL_POST vmaBuildStatsString(
                         VmaPrintStatInfo(json, stats.memoryType[typeIndex]);
                     }
 
+                    // Tags that were ever used in this memory type.
+                    bool tagsWritten = false;
+                    for(uint32_t tag = 0; tag < VMA_ALLOCATION_TAG_COUNT; ++tag)
+                    {
+                        const VmaTagStatistics& tagStats = allocator->m_TagStats;
+                        if(tagStats.m_PeakAllocationBytes[tag][typeIndex].load() == 0)
+                        {
+                            continue;
+                        }
+                        if(!tagsWritten)
+                        {
+                            json.WriteString("Tags");
+                            json.BeginObject();
+                            tagsWritten = true;
+                        }
+                        json.BeginString();
+                        json.ContinueString(tag);
+                        json.EndString();
+                        json.BeginObject(true);
+                        json.WriteString("Allocations");
+                        json.WriteNumber(tagStats.m_AllocationCount[tag][typeIndex].load());
+                        json.WriteString("Bytes");
+                        json.WriteNumber(tagStats.m_AllocationBytes[tag][typeIndex].load());
+                        json.WriteString("PeakBytes");
+                        json.WriteNumber(tagStats.m_PeakAllocationBytes[tag][typeIndex].load());
+                        json.EndObject();
+                    }
+                    if(tagsWritten)
+                    {
+                        json.EndObject();
+                    }
+
                     json.EndObject();
                 }
             }
@@ -18196,6 +26699,47 @@ VMA_CALL_PRE VkResult VMA_CALL_POST vmaCheckPoolCorruption(VmaAllocator allocato
     return allocator->CheckPoolCorruption(pool);
 }
 
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaGetPoolMarker(
+    VmaAllocator allocator,
+    VmaPool pool,
+    VkDeviceSize* pMarker)
+{
+    VMA_ASSERT(allocator && pool && pMarker);
+
+    VMA_DEBUG_LOG("vmaGetPoolMarker");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    return allocator->GetPoolMarker(pool, pMarker);
+}
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaRewindPool(
+    VmaAllocator allocator,
+    VmaPool pool,
+    VkDeviceSize marker)
+{
+    VMA_ASSERT(allocator && pool);
+
+    VMA_DEBUG_LOG("vmaRewindPool");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    return allocator->RewindPool(pool, marker);
+}
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaResetPool(
+    VmaAllocator allocator,
+    VmaPool pool)
+{
+    VMA_ASSERT(allocator && pool);
+
+    VMA_DEBUG_LOG("vmaResetPool");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    return allocator->ResetPool(pool);
+}
+
 VMA_CALL_PRE void VMA_CALL_POST vmaGetPoolName(
     VmaAllocator allocator,
     VmaPool pool,
@@ -18231,6 +26775,18 @@ VMA_CALL_PRE void VMA_CALL_POST vmaSetPoolName(
 #endif
 }
 
+VMA_CALL_PRE void VMA_CALL_POST vmaSetPoolRecordingEnabled(
+    VmaAllocator allocator,
+    VmaPool pool,
+    VkBool32 enabled)
+{
+    VMA_ASSERT(allocator && pool);
+
+    VMA_DEBUG_LOG("vmaSetPoolRecordingEnabled");
+
+    pool->SetRecordingEnabled(enabled != VK_FALSE);
+}
+
 VMA_CALL_PRE VkResult VMA_CALL_POST vmaAllocateMemory(
     VmaAllocator allocator,
     const VkMemoryRequirements* pVkMemoryRequirements,
@@ -18329,6 +26885,77 @@ VMA_CALL_PRE VkResult VMA_CALL_POST vmaAllocateMemoryPages(
     return result;
 }
 
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaAllocateMemoryBatch(
+    VmaAllocator allocator,
+    const VkMemoryRequirements* pVkMemoryRequirements,
+    const VmaAllocationCreateInfo* pCreateInfos,
+    size_t allocationCount,
+    VmaAllocation* pAllocations,
+    VmaAllocationInfo* pAllocationInfo)
+{
+    if(allocationCount == 0)
+    {
+        return VK_SUCCESS;
+    }
+
+    VMA_ASSERT(allocator && pVkMemoryRequirements && pCreateInfos && pAllocations);
+
+    VMA_DEBUG_LOG("vmaAllocateMemoryBatch");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    VkResult result = allocator->AllocateMemoryBatch(
+        pVkMemoryRequirements,
+        pCreateInfos,
+        allocationCount,
+        pAllocations);
+
+#if VMA_RECORDING_ENABLED
+    // Recorded as one call, as allocations are placed in different order than they come in.
+    if(allocator->GetRecorder() != VMA_NULL)
+    {
+        allocator->GetRecorder()->RecordAllocateMemoryBatch(
+            allocator->GetCurrentFrameIndex(),
+            pVkMemoryRequirements,
+            pCreateInfos,
+            (uint64_t)allocationCount,
+            pAllocations);
+    }
+#endif
+
+    if(pAllocationInfo != VMA_NULL && result == VK_SUCCESS)
+    {
+        for(size_t i = 0; i < allocationCount; ++i)
+        {
+            allocator->GetAllocationInfo(pAllocations[i], pAllocationInfo + i);
+        }
+    }
+
+    return result;
+}
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaCheckAllocationsFit(
+    VmaAllocator allocator,
+    const VkMemoryRequirements* pVkMemoryRequirements,
+    const VmaAllocationCreateInfo* pCreateInfos,
+    size_t allocationCount,
+    VmaAllocationFitPlacement* pPlacements,
+    VmaAllocationFitInfo* pFitInfo)
+{
+    VMA_ASSERT(allocator && (allocationCount == 0 || (pVkMemoryRequirements && pCreateInfos)));
+
+    VMA_DEBUG_LOG("vmaCheckAllocationsFit");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    return allocator->CheckAllocationsFit(
+        pVkMemoryRequirements,
+        pCreateInfos,
+        allocationCount,
+        pPlacements,
+        pFitInfo);
+}
+
 VMA_CALL_PRE VkResult VMA_CALL_POST vmaAllocateMemoryForBuffer(
     VmaAllocator allocator,
     VkBuffer buffer,
@@ -18492,6 +27119,79 @@ VMA_CALL_PRE void VMA_CALL_POST vmaFreeMemoryPages(
     allocator->FreeMemory(allocationCount, pAllocations);
 }
 
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaCreateAllocationScope(
+    VmaAllocator allocator,
+    VmaAllocationScope* pScope)
+{
+    VMA_ASSERT(allocator && pScope);
+
+    VMA_DEBUG_LOG("vmaCreateAllocationScope");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    return allocator->CreateAllocationScope(pScope);
+}
+
+VMA_CALL_PRE void VMA_CALL_POST vmaDestroyAllocationScope(
+    VmaAllocator allocator,
+    VmaAllocationScope scope)
+{
+    VMA_ASSERT(allocator);
+
+    if(scope == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    VMA_DEBUG_LOG("vmaDestroyAllocationScope");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    allocator->DestroyAllocationScope(scope);
+}
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaCreateQuota(
+    VmaAllocator allocator,
+    const VmaQuotaCreateInfo* pCreateInfo,
+    VmaQuota* pQuota)
+{
+    VMA_ASSERT(allocator && pCreateInfo && pQuota);
+
+    VMA_DEBUG_LOG("vmaCreateQuota");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    return allocator->CreateQuota(pCreateInfo, pQuota);
+}
+
+VMA_CALL_PRE void VMA_CALL_POST vmaDestroyQuota(
+    VmaAllocator allocator,
+    VmaQuota quota)
+{
+    VMA_ASSERT(allocator);
+
+    if(quota == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    VMA_DEBUG_LOG("vmaDestroyQuota");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    allocator->DestroyQuota(quota);
+}
+
+VMA_CALL_PRE void VMA_CALL_POST vmaGetQuotaStats(
+    VmaAllocator allocator,
+    VmaQuota quota,
+    VmaQuotaStats* pQuotaStats)
+{
+    VMA_ASSERT(allocator && quota && pQuotaStats);
+
+    quota->GetStats(*pQuotaStats);
+}
+
 VMA_CALL_PRE VkResult VMA_CALL_POST vmaResizeAllocation(
     VmaAllocator allocator,
     VmaAllocation allocation,
@@ -18503,7 +27203,153 @@ VMA_CALL_PRE VkResult VMA_CALL_POST vmaResizeAllocation(
 
     VMA_DEBUG_GLOBAL_MUTEX_LOCK
 
-    return allocator->ResizeAllocation(allocation, newSize);
+    const VkResult res = allocator->ResizeAllocation(allocation, newSize);
+
+#if VMA_RECORDING_ENABLED
+    // Failed resize leaves the allocation unchanged, so there is nothing to replay.
+    if(res == VK_SUCCESS && allocator->GetRecorder() != VMA_NULL)
+    {
+        allocator->GetRecorder()->RecordResizeAllocation(
+            allocator->GetCurrentFrameIndex(),
+            allocation,
+            newSize);
+    }
+#endif
+
+    return res;
+}
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaReallocateMemory(
+    VmaAllocator allocator,
+    VmaAllocation allocation,
+    VkDeviceSize newSize,
+    const VmaAllocationCreateInfo* pCreateInfo,
+    VmaReallocationInfo* pReallocationInfo)
+{
+    VMA_ASSERT(allocator && allocation && pReallocationInfo);
+
+    VMA_DEBUG_LOG("vmaReallocateMemory");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    pReallocationInfo->allocation = allocation;
+    pReallocationInfo->moved = VK_FALSE;
+    pReallocationInfo->copyPending = VK_FALSE;
+    pReallocationInfo->copySize = 0;
+
+    // 1. Try to resize in place.
+    VkResult res = allocator->ResizeAllocation(allocation, newSize);
+
+#if VMA_RECORDING_ENABLED
+    // Failed resize is followed by a new allocation, which is recorded instead.
+    if(res == VK_SUCCESS && allocator->GetRecorder() != VMA_NULL)
+    {
+        allocator->GetRecorder()->RecordResizeAllocation(
+            allocator->GetCurrentFrameIndex(),
+            allocation,
+            newSize);
+    }
+#endif
+
+    if(res != VK_ERROR_OUT_OF_POOL_MEMORY)
+    {
+        return res;
+    }
+
+    // 2. Make new allocation.
+    VkMemoryRequirements vkMemReq = {};
+    VmaAllocationCreateInfo createInfo = {};
+    allocator->GetReallocationParams(allocation, newSize, pCreateInfo, vkMemReq, createInfo);
+
+    VmaAllocation newAllocation = VK_NULL_HANDLE;
+    res = allocator->AllocateMemory(
+        vkMemReq,
+        false, // requiresDedicatedAllocation
+        false, // prefersDedicatedAllocation
+        VK_NULL_HANDLE, // dedicatedBuffer
+        UINT32_MAX, // dedicatedBufferUsage
+        VK_NULL_HANDLE, // dedicatedImage
+        createInfo,
+        allocation->GetSuballocationType(),
+        1, // allocationCount
+        &newAllocation);
+
+#if VMA_RECORDING_ENABLED
+    if(allocator->GetRecorder() != VMA_NULL)
+    {
+        allocator->GetRecorder()->RecordAllocateMemory(
+            allocator->GetCurrentFrameIndex(),
+            vkMemReq,
+            createInfo,
+            newAllocation);
+    }
+#endif
+
+    if(res != VK_SUCCESS)
+    {
+        return res;
+    }
+
+    const VkDeviceSize copySize = VMA_MIN(allocation->GetSize(), newSize);
+
+    // 3. Copy contents on the CPU and free the old allocation, if possible.
+    if(allocator->IsAllocationHostAccessible(allocation) && allocator->IsAllocationHostAccessible(newAllocation))
+    {
+        res = allocator->CopyAllocationData(allocation, newAllocation, copySize);
+        if(res != VK_SUCCESS)
+        {
+#if VMA_RECORDING_ENABLED
+            if(allocator->GetRecorder() != VMA_NULL)
+            {
+                allocator->GetRecorder()->RecordFreeMemory(
+                    allocator->GetCurrentFrameIndex(),
+                    newAllocation);
+            }
+#endif
+            allocator->FreeMemory(
+                1, // allocationCount
+                &newAllocation);
+            return res;
+        }
+
+#if VMA_RECORDING_ENABLED
+        if(allocator->GetRecorder() != VMA_NULL)
+        {
+            allocator->GetRecorder()->RecordFreeMemory(
+                allocator->GetCurrentFrameIndex(),
+                allocation);
+        }
+#endif
+
+        allocator->FreeMemory(
+            1, // allocationCount
+            &allocation);
+    }
+    else
+    {
+        pReallocationInfo->copyPending = VK_TRUE;
+    }
+
+    pReallocationInfo->allocation = newAllocation;
+    pReallocationInfo->moved = VK_TRUE;
+    pReallocationInfo->copySize = copySize;
+    return VK_SUCCESS;
+}
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaBalanceBarMemory(
+    VmaAllocator allocator,
+    const VmaBarBalanceInfo* pInfo,
+    uint32_t* pMoveCount,
+    VmaBarMove* pMoves)
+{
+    VMA_ASSERT(allocator && pInfo && pMoveCount);
+    VMA_ASSERT(pInfo->allocationCount == 0 || pInfo->pAllocations != VMA_NULL);
+
+    VMA_DEBUG_LOG("vmaBalanceBarMemory");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    return allocator->BalanceBarMemory(*pInfo, pMoveCount, pMoves);
 }
 
 VMA_CALL_PRE void VMA_CALL_POST vmaGetAllocationInfo(
@@ -18544,9 +27390,42 @@ VMA_CALL_PRE VkBool32 VMA_CALL_POST vmaTouchAllocation(
     }
 #endif
 
-    return allocator->TouchAllocation(allocation);
+    return allocator->TouchAllocation(allocation);
+}
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaFindAllocationByMemory(
+    VmaAllocator allocator,
+    VkDeviceMemory memory,
+    VkDeviceSize offset,
+    VmaAllocation* pAllocation)
+{
+    VMA_ASSERT(allocator && memory != VK_NULL_HANDLE && pAllocation);
+
+    VMA_DEBUG_LOG("vmaFindAllocationByMemory");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    return allocator->FindAllocationByMemory(memory, offset, pAllocation);
+}
+
+#if VMA_EXTERNAL_MEMORY
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaGetAllocationExportInfo(
+    VmaAllocator allocator,
+    VmaAllocation allocation,
+    VmaAllocationExportInfo* pExportInfo)
+{
+    VMA_ASSERT(allocator && allocation && pExportInfo);
+
+    VMA_DEBUG_LOG("vmaGetAllocationExportInfo");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    return allocator->GetAllocationExportInfo(allocation, pExportInfo);
 }
 
+#endif // #if VMA_EXTERNAL_MEMORY
+
 VMA_CALL_PRE void VMA_CALL_POST vmaSetAllocationUserData(
     VmaAllocator allocator,
     VmaAllocation allocation,
@@ -18598,6 +27477,8 @@ VMA_CALL_PRE VkResult VMA_CALL_POST vmaMapMemory(
 
     VMA_DEBUG_GLOBAL_MUTEX_LOCK
 
+    allocation->IncrementHostAccessCount();
+
     VkResult res = allocator->Map(allocation, ppData);
 
 #if VMA_RECORDING_ENABLED
@@ -18640,6 +27521,8 @@ VMA_CALL_PRE VkResult VMA_CALL_POST vmaFlushAllocation(VmaAllocator allocator, V
 
     VMA_DEBUG_GLOBAL_MUTEX_LOCK
 
+    allocation->IncrementHostAccessCount();
+
     const VkResult res = allocator->FlushOrInvalidateAllocation(allocation, offset, size, VMA_CACHE_FLUSH);
 
 #if VMA_RECORDING_ENABLED
@@ -18696,6 +27579,11 @@ VMA_CALL_PRE VkResult VMA_CALL_POST vmaFlushAllocations(
 
     VMA_DEBUG_GLOBAL_MUTEX_LOCK
 
+    for(uint32_t allocIndex = 0; allocIndex < allocationCount; ++allocIndex)
+    {
+        allocations[allocIndex]->IncrementHostAccessCount();
+    }
+
     const VkResult res = allocator->FlushOrInvalidateAllocations(allocationCount, allocations, offsets, sizes, VMA_CACHE_FLUSH);
 
 #if VMA_RECORDING_ENABLED
@@ -18751,6 +27639,22 @@ VMA_CALL_PRE VkResult VMA_CALL_POST vmaCheckCorruption(VmaAllocator allocator, u
     return allocator->CheckCorruption(memoryTypeBits);
 }
 
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaZeroFreeMemory(
+    VmaAllocator allocator,
+    VmaPool pool,
+    VkDeviceSize maxBytes,
+    uint32_t* pRangeCount,
+    VmaZeroFillRange* pRanges)
+{
+    VMA_ASSERT(allocator && pRangeCount);
+
+    VMA_DEBUG_LOG("vmaZeroFreeMemory");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    return allocator->ZeroFreeMemory(pool, maxBytes, pRangeCount, pRanges);
+}
+
 VMA_CALL_PRE VkResult VMA_CALL_POST vmaDefragment(
     VmaAllocator allocator,
     const VmaAllocation* pAllocations,
@@ -19226,4 +28130,364 @@ VMA_CALL_PRE void VMA_CALL_POST vmaDestroyImage(
     }
 }
 
+VMA_CALL_PRE void VMA_CALL_POST vmaFreeMemoryDeferred(
+    VmaAllocator allocator,
+    VmaAllocation allocation,
+    uint64_t completionValue)
+{
+    VMA_ASSERT(allocator);
+
+    if(allocation == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    VMA_DEBUG_LOG("vmaFreeMemoryDeferred");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    allocator->DeferDestruction(completionValue, VK_NULL_HANDLE, VK_NULL_HANDLE, allocation);
+}
+
+VMA_CALL_PRE void VMA_CALL_POST vmaDestroyBufferDeferred(
+    VmaAllocator allocator,
+    VkBuffer buffer,
+    VmaAllocation allocation,
+    uint64_t completionValue)
+{
+    VMA_ASSERT(allocator);
+
+    if(buffer == VK_NULL_HANDLE && allocation == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    VMA_DEBUG_LOG("vmaDestroyBufferDeferred");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    allocator->DeferDestruction(completionValue, buffer, VK_NULL_HANDLE, allocation);
+}
+
+VMA_CALL_PRE void VMA_CALL_POST vmaDestroyImageDeferred(
+    VmaAllocator allocator,
+    VkImage image,
+    VmaAllocation allocation,
+    uint64_t completionValue)
+{
+    VMA_ASSERT(allocator);
+
+    if(image == VK_NULL_HANDLE && allocation == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    VMA_DEBUG_LOG("vmaDestroyImageDeferred");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    allocator->DeferDestruction(completionValue, VK_NULL_HANDLE, image, allocation);
+}
+
+VMA_CALL_PRE void VMA_CALL_POST vmaProcessDeferredDestructions(
+    VmaAllocator allocator,
+    uint64_t completedValue,
+    size_t* pDestroyedCount)
+{
+    VMA_ASSERT(allocator);
+
+    VMA_DEBUG_LOG("vmaProcessDeferredDestructions");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    const size_t destroyedCount = allocator->ProcessDeferredDestructions(completedValue);
+    if(pDestroyedCount != VMA_NULL)
+    {
+        *pDestroyedCount = destroyedCount;
+    }
+}
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaCreateReadbackHeap(
+    VmaAllocator allocator,
+    const VmaReadbackHeapCreateInfo* pCreateInfo,
+    VmaReadbackHeap* pHeap,
+    VmaAllocationInfo* pAllocationInfo)
+{
+    VMA_ASSERT(allocator && pCreateInfo && pHeap);
+
+    if(pCreateInfo->frameSize == 0)
+    {
+        return VK_ERROR_VALIDATION_FAILED_EXT;
+    }
+
+    VMA_DEBUG_LOG("vmaCreateReadbackHeap");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    *pHeap = VK_NULL_HANDLE;
+    return allocator->CreateReadbackHeap(*pCreateInfo, pHeap, pAllocationInfo);
+}
+
+VMA_CALL_PRE void VMA_CALL_POST vmaDestroyReadbackHeap(
+    VmaAllocator allocator,
+    VmaReadbackHeap heap)
+{
+    VMA_ASSERT(allocator);
+
+    if(heap == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    VMA_DEBUG_LOG("vmaDestroyReadbackHeap");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    allocator->DestroyReadbackHeap(heap);
+}
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaAllocateReadbackRegion(
+    VmaAllocator allocator,
+    VmaReadbackHeap heap,
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    VmaReadbackRegion* pRegion)
+{
+    VMA_ASSERT(allocator && heap && pRegion && size > 0 && VmaIsPow2(alignment));
+
+    VMA_DEBUG_LOG("vmaAllocateReadbackRegion");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    return heap->Allocate(allocator->GetCurrentFrameIndex(), size, alignment, *pRegion);
+}
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaInvalidateReadbackHeaps(
+    VmaAllocator allocator,
+    uint32_t heapCount,
+    const VmaReadbackHeap* pHeaps,
+    uint32_t frameIndex)
+{
+    VMA_ASSERT(allocator);
+
+    if(heapCount == 0)
+    {
+        return VK_SUCCESS;
+    }
+
+    VMA_ASSERT(pHeaps);
+
+    VMA_DEBUG_LOG("vmaInvalidateReadbackHeaps");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    return allocator->InvalidateReadbackHeaps(heapCount, pHeaps, frameIndex);
+}
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaCreateSparseBuffer(
+    VmaAllocator allocator,
+    const VmaSparseBufferCreateInfo* pCreateInfo,
+    VmaSparseBuffer* pSparseBuffer,
+    VmaSparseBufferInfo* pSparseBufferInfo)
+{
+    VMA_ASSERT(allocator && pCreateInfo && pSparseBuffer);
+
+    if(pCreateInfo->size == 0)
+    {
+        return VK_ERROR_VALIDATION_FAILED_EXT;
+    }
+
+    VMA_DEBUG_LOG("vmaCreateSparseBuffer");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    *pSparseBuffer = VK_NULL_HANDLE;
+    VkResult res = allocator->CreateSparseBuffer(*pCreateInfo, pSparseBuffer);
+    if(res == VK_SUCCESS && pSparseBufferInfo != VMA_NULL)
+    {
+        (*pSparseBuffer)->GetInfo(*pSparseBufferInfo);
+    }
+    return res;
+}
+
+VMA_CALL_PRE void VMA_CALL_POST vmaDestroySparseBuffer(
+    VmaAllocator allocator,
+    VmaSparseBuffer sparseBuffer)
+{
+    VMA_ASSERT(allocator);
+
+    if(sparseBuffer == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    VMA_DEBUG_LOG("vmaDestroySparseBuffer");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    allocator->DestroySparseBuffer(sparseBuffer);
+}
+
+VMA_CALL_PRE void VMA_CALL_POST vmaGetSparseBufferInfo(
+    VmaAllocator allocator,
+    VmaSparseBuffer sparseBuffer,
+    VmaSparseBufferInfo* pSparseBufferInfo)
+{
+    VMA_ASSERT(allocator && sparseBuffer && pSparseBufferInfo);
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    sparseBuffer->GetInfo(*pSparseBufferInfo);
+}
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaSparseBufferAllocate(
+    VmaAllocator allocator,
+    VmaSparseBuffer sparseBuffer,
+    VkDeviceSize size,
+    VkDeviceSize alignment,
+    VkDeviceSize* pOffset)
+{
+    VMA_ASSERT(allocator && sparseBuffer && pOffset && size > 0 && VmaIsPow2(alignment));
+
+    VMA_DEBUG_LOG("vmaSparseBufferAllocate");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    return sparseBuffer->Allocate(size, alignment, *pOffset);
+}
+
+VMA_CALL_PRE void VMA_CALL_POST vmaSparseBufferFree(
+    VmaAllocator allocator,
+    VmaSparseBuffer sparseBuffer,
+    VkDeviceSize offset)
+{
+    VMA_ASSERT(allocator && sparseBuffer);
+
+    VMA_DEBUG_LOG("vmaSparseBufferFree");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    sparseBuffer->Free(offset);
+}
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaSubmitSparseBinds(
+    VmaAllocator allocator,
+    uint32_t sparseBufferCount,
+    const VmaSparseBuffer* pSparseBuffers,
+    const VmaSparseBindSubmitInfo* pSubmitInfo)
+{
+    VMA_ASSERT(allocator && pSubmitInfo && (sparseBufferCount == 0 || pSparseBuffers));
+
+    VMA_DEBUG_LOG("vmaSubmitSparseBinds");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    return allocator->SubmitSparseBinds(sparseBufferCount, pSparseBuffers, *pSubmitInfo);
+}
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaCreateSparsePagePool(
+    VmaAllocator allocator,
+    const VmaSparsePagePoolCreateInfo* pCreateInfo,
+    VmaSparsePagePool* pPool)
+{
+    VMA_ASSERT(allocator && pCreateInfo && pPool);
+
+    VMA_DEBUG_LOG("vmaCreateSparsePagePool");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    *pPool = VK_NULL_HANDLE;
+    return allocator->CreateSparsePagePool(*pCreateInfo, pPool);
+}
+
+VMA_CALL_PRE void VMA_CALL_POST vmaDestroySparsePagePool(
+    VmaAllocator allocator,
+    VmaSparsePagePool pool)
+{
+    VMA_ASSERT(allocator);
+
+    if(pool == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    VMA_DEBUG_LOG("vmaDestroySparsePagePool");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    allocator->DestroySparsePagePool(pool);
+}
+
+VMA_CALL_PRE void VMA_CALL_POST vmaGetSparsePagePoolStats(
+    VmaAllocator allocator,
+    VmaSparsePagePool pool,
+    VmaPoolStats* pPoolStats)
+{
+    VMA_ASSERT(allocator && pool && pPoolStats);
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    pool->GetStats(*pPoolStats);
+}
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaAllocateSparseImagePages(
+    VmaAllocator allocator,
+    VmaSparsePagePool pool,
+    uint32_t bindCount,
+    VkSparseImageMemoryBind* pBinds)
+{
+    VMA_ASSERT(allocator && pool && (bindCount == 0 || pBinds));
+
+    VMA_DEBUG_LOG("vmaAllocateSparseImagePages");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    return pool->AllocatePages(bindCount, pBinds);
+}
+
+VMA_CALL_PRE void VMA_CALL_POST vmaFreeSparseImagePages(
+    VmaAllocator allocator,
+    VmaSparsePagePool pool,
+    uint32_t bindCount,
+    const VkSparseImageMemoryBind* pBinds)
+{
+    VMA_ASSERT(allocator && pool && (bindCount == 0 || pBinds));
+
+    VMA_DEBUG_LOG("vmaFreeSparseImagePages");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    pool->FreePages(bindCount, pBinds);
+}
+
+VMA_CALL_PRE VkResult VMA_CALL_POST vmaAllocateSparseOpaquePages(
+    VmaAllocator allocator,
+    VmaSparsePagePool pool,
+    uint32_t bindCount,
+    VkSparseMemoryBind* pBinds)
+{
+    VMA_ASSERT(allocator && pool && (bindCount == 0 || pBinds));
+
+    VMA_DEBUG_LOG("vmaAllocateSparseOpaquePages");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    return pool->AllocatePages(bindCount, pBinds);
+}
+
+VMA_CALL_PRE void VMA_CALL_POST vmaFreeSparseOpaquePages(
+    VmaAllocator allocator,
+    VmaSparsePagePool pool,
+    uint32_t bindCount,
+    const VkSparseMemoryBind* pBinds)
+{
+    VMA_ASSERT(allocator && pool && (bindCount == 0 || pBinds));
+
+    VMA_DEBUG_LOG("vmaFreeSparseOpaquePages");
+
+    VMA_DEBUG_GLOBAL_MUTEX_LOCK
+
+    pool->FreePages(bindCount, pBinds);
+}
+
 #endif // #ifdef VMA_IMPLEMENTATION